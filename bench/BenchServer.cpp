@@ -0,0 +1,599 @@
+/**
+ * @file BenchServer.cpp
+ * @brief Implementation of BenchServer - shaping HTTP/1.1 range server
+ */
+
+#include "BenchServer.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace OpenIDM::Bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Pattern period; prime, so it never lines up with segment or block sizes
+constexpr qsizetype PATTERN_PERIOD = 65521;
+
+/// Largest single socket write; the table repeats this much past the period
+constexpr qsizetype CHUNK = 64 * 1024;
+
+/// A connection stops being fed while this much is still unsent
+constexpr qint64 HIGH_WATER = 1024 * 1024;
+
+/// Bandwidth buckets hold at most this many seconds of tokens
+constexpr double BURST_SECONDS = 0.02;
+
+constexpr int TICK_MS = 5;
+
+/// Requests larger than this are not HTTP from curl
+constexpr qsizetype MAX_REQUEST = 16 * 1024;
+
+const char* patternTable() {
+    static const std::vector<char> table = []() {
+        std::vector<char> bytes(PATTERN_PERIOD + CHUNK);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            quint32 x = static_cast<quint32>(i % PATTERN_PERIOD);
+            x = x * 2654435761u;
+            bytes[i] = static_cast<char>(x >> 24);
+        }
+        return bytes;
+    }();
+    return table.data();
+}
+
+double threadCpuSeconds() {
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    auto ticks = [](const FILETIME& time) {
+        return (static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return static_cast<double>(ticks(kernel) + ticks(user)) / 1e7;
+#else
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+#endif
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Server Thread
+// ═══════════════════════════════════════════════════════════════════════════════
+
+/**
+ * Everything here runs on the server thread. The counters are atomics so
+ * stats() can read them from the owner without a round trip.
+ */
+class ServerCore : public QObject {
+public:
+    bool listen(const ServerProfile& profile, quint16& port);
+    void close();
+    double cpuSeconds() const { return threadCpuSeconds() - m_cpuAtStart; }
+    std::optional<Clock::time_point> firstByteAt(const QByteArray& path) const;
+
+    std::atomic<quint64> connections{0};
+    std::atomic<quint64> requests{0};
+    std::atomic<quint64> injectedErrors{0};
+    std::atomic<quint64> truncated{0};
+    std::atomic<ByteCount> bytesSent{0};
+    std::atomic<int> peakConnections{0};
+
+private:
+    enum class State { Reading, Waiting, Sending };
+
+    struct Connection {
+        QTcpSocket* socket{nullptr};
+        QByteArray input;
+        State state{State::Reading};
+        Clock::time_point readyAt{};
+        QByteArray head;                ///< Response headers, sent once readyAt passed
+        ByteOffset position{0};         ///< Next body byte
+        ByteOffset end{0};              ///< One past the last body byte
+        ByteOffset truncateAt{-1};
+        QByteArray firstBytePath;       ///< Set until the body's first write is recorded
+        bool keepAlive{true};
+        bool overLimit{false};          ///< Beyond maxConnections
+        double tokens{0.0};
+    };
+
+    void accept();
+    void handleRequest(Connection& connection);
+    void respond(Connection& connection, int status, const QByteArray& reason,
+                 const QByteArray& headers, ByteOffset start, ByteOffset end);
+    void pump(Connection& connection);
+    void finishResponse(Connection& connection);
+    void tick();
+
+    ServerProfile m_profile;
+    std::unique_ptr<QTcpServer> m_server;
+    std::unique_ptr<QTimer> m_timer;
+    std::unordered_map<QTcpSocket*, std::unique_ptr<Connection>> m_connections;
+    int m_served{0};                    ///< Connections within maxConnections
+    double m_globalTokens{0.0};
+    Clock::time_point m_lastTick{};
+    size_t m_rotation{0};
+    double m_cpuAtStart{0.0};
+
+    mutable std::mutex m_firstByteMutex;
+    QHash<QByteArray, Clock::time_point> m_firstByte;   ///< Path -> first body byte sent
+};
+
+bool ServerCore::listen(const ServerProfile& profile, quint16& port) {
+    close();
+
+    m_profile = profile;
+    connections = 0;
+    requests = 0;
+    injectedErrors = 0;
+    truncated = 0;
+    bytesSent = 0;
+    peakConnections = 0;
+    m_globalTokens = 0.0;
+    m_lastTick = Clock::now();
+    m_cpuAtStart = threadCpuSeconds();
+    {
+        std::lock_guard lock(m_firstByteMutex);
+        m_firstByte.clear();
+    }
+
+    m_server = std::make_unique<QTcpServer>();
+    m_server->setMaxPendingConnections(1024);
+    if (!m_server->listen(QHostAddress::LocalHost, 0)) {
+        qWarning() << "BenchServer: Failed to listen:" << m_server->errorString();
+        m_server.reset();
+        return false;
+    }
+    port = m_server->serverPort();
+    QObject::connect(m_server.get(), &QTcpServer::newConnection, this, [this]() { accept(); });
+
+    // Refills the buckets and feeds throttled or delayed responses
+    m_timer = std::make_unique<QTimer>();
+    m_timer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_timer.get(), &QTimer::timeout, this, [this]() { tick(); });
+    m_timer->start(TICK_MS);
+    return true;
+}
+
+void ServerCore::close() {
+    m_timer.reset();
+    if (m_server) {
+        m_server->close();
+        m_server.reset();
+    }
+    for (auto& [socket, connection] : m_connections) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_connections.clear();
+    m_served = 0;
+}
+
+std::optional<Clock::time_point> ServerCore::firstByteAt(const QByteArray& path) const {
+    std::lock_guard lock(m_firstByteMutex);
+    auto it = m_firstByte.constFind(path);
+    if (it == m_firstByte.constEnd()) {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+void ServerCore::accept() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        auto connection = std::make_unique<Connection>();
+        connection->socket = socket;
+        connection->tokens = m_profile.perConnection * BURST_SECONDS;
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        if (m_profile.maxConnections > 0 && m_served >= m_profile.maxConnections) {
+            connection->overLimit = true;
+        } else {
+            ++m_served;
+        }
+
+        ++connections;
+        int open = static_cast<int>(m_connections.size()) + 1;
+        peakConnections = std::max(peakConnections.load(), open);
+
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it != m_connections.end()) {
+                it->second->input.append(socket->readAll());
+                if (it->second->state == State::Reading) {
+                    handleRequest(*it->second);
+                }
+            }
+        });
+        QObject::connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it != m_connections.end()) {
+                pump(*it->second);
+            }
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it != m_connections.end()) {
+                if (!it->second->overLimit) {
+                    --m_served;
+                }
+                m_connections.erase(it);
+            }
+            socket->deleteLater();
+        });
+
+        m_connections.emplace(socket, std::move(connection));
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Requests
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ServerCore::handleRequest(Connection& connection) {
+    qsizetype headerEnd = connection.input.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (connection.input.size() > MAX_REQUEST) {
+            connection.socket->abort();
+        }
+        return;
+    }
+
+    QByteArray head = connection.input.left(headerEnd);
+    connection.input.remove(0, headerEnd + 4);
+    ++requests;
+
+    const QList<QByteArray> lines = head.split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() < 3) {
+        connection.keepAlive = false;
+        respond(connection, 400, "Bad Request", {}, 0, 0);
+        return;
+    }
+    const QByteArray& method = requestLine.at(0);
+    const QByteArray& target = requestLine.at(1);
+    bool head11 = requestLine.at(2) == "HTTP/1.1";
+
+    QByteArray range;
+    QByteArray connectionHeader;
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        QByteArray line = lines.at(i).trimmed();
+        qsizetype colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        QByteArray name = line.left(colon).trimmed().toLower();
+        if (name == "range") {
+            range = line.mid(colon + 1).trimmed();
+        } else if (name == "connection") {
+            connectionHeader = line.mid(colon + 1).trimmed().toLower();
+        }
+    }
+    connection.keepAlive = head11 ? connectionHeader != "close" : connectionHeader == "keep-alive";
+
+    bool isHead = method == "HEAD";
+    if (!isHead && method != "GET") {
+        respond(connection, 405, "Method Not Allowed", "Allow: GET, HEAD\r\n", 0, 0);
+        return;
+    }
+
+    // "/<size>/<name>"
+    qsizetype slash = target.indexOf('/', 1);
+    bool ok = false;
+    ByteCount size = target.mid(1, slash - 1).toLongLong(&ok);
+    if (!target.startsWith('/') || slash < 0 || !ok || size < 0) {
+        respond(connection, 404, "Not Found", {}, 0, 0);
+        return;
+    }
+
+    if (connection.overLimit ||
+        (!isHead && QRandomGenerator::global()->generateDouble() < m_profile.errorRate)) {
+        ++injectedErrors;
+        respond(connection, 503, "Service Unavailable", {}, 0, 0);
+        return;
+    }
+
+    QByteArray headers = "Content-Type: application/octet-stream\r\n"
+                         "ETag: \"bench-" + QByteArray::number(size) + "\"\r\n"
+                         "Last-Modified: Mon, 01 Jan 2024 00:00:00 GMT\r\n";
+    if (m_profile.ranges) {
+        headers += "Accept-Ranges: bytes\r\n";
+    }
+
+    ByteOffset first = 0;
+    ByteOffset last = size - 1;
+    bool partial = false;
+    if (m_profile.ranges && range.startsWith("bytes=") && !range.contains(',')) {
+        QByteArray spec = range.mid(6);
+        qsizetype dash = spec.indexOf('-');
+        bool firstOk = false;
+        bool lastOk = false;
+        ByteOffset a = spec.left(dash).toLongLong(&firstOk);
+        ByteOffset b = spec.mid(dash + 1).toLongLong(&lastOk);
+        if (dash == 0 && lastOk) {
+            first = std::max<ByteOffset>(0, size - b);     // "bytes=-500"
+        } else if (firstOk) {
+            first = a;
+            if (lastOk) {
+                last = std::min(b, size - 1);
+            }
+        }
+        if (dash < 0 || first >= size || first > last) {
+            respond(connection, 416, "Range Not Satisfiable",
+                    "Content-Range: bytes */" + QByteArray::number(size) + "\r\n", 0, 0);
+            return;
+        }
+        partial = true;
+        headers += "Content-Range: bytes " + QByteArray::number(first) + '-' +
+                   QByteArray::number(last) + '/' + QByteArray::number(size) + "\r\n";
+    }
+
+    ByteOffset end = size > 0 ? last + 1 : 0;
+    if (isHead) {
+        headers += "Content-Length: " + QByteArray::number(end - first) + "\r\n";
+        end = first;
+    } else {
+        if (end > first && QRandomGenerator::global()->generateDouble() < m_profile.truncateRate) {
+            connection.truncateAt = first + (end - first) / 2;
+        }
+        connection.firstBytePath = target;
+    }
+    respond(connection, partial ? 206 : 200, partial ? "Partial Content" : "OK", headers, first, end);
+}
+
+void ServerCore::respond(Connection& connection, int status, const QByteArray& reason,
+                         const QByteArray& headers, ByteOffset start, ByteOffset end) {
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n" + headers;
+    if (!headers.contains("Content-Length:")) {
+        head += "Content-Length: " + QByteArray::number(end - start) + "\r\n";
+    }
+    if (!connection.keepAlive) {
+        head += "Connection: close\r\n";
+    }
+    head += "\r\n";
+
+    connection.head = std::move(head);
+    connection.position = start;
+    connection.end = end;
+    connection.state = State::Waiting;
+    connection.readyAt = Clock::now() + m_profile.latency;
+    pump(connection);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Sending
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ServerCore::pump(Connection& connection) {
+    if (connection.state == State::Waiting) {
+        if (Clock::now() < connection.readyAt) {
+            return;  // The tick picks it up
+        }
+        connection.socket->write(connection.head);
+        connection.head.clear();
+        connection.state = State::Sending;
+    }
+    if (connection.state != State::Sending) {
+        return;
+    }
+
+    const char* table = patternTable();
+    while (connection.position < connection.end) {
+        if (connection.socket->bytesToWrite() >= HIGH_WATER) {
+            return;  // bytesWritten() resumes
+        }
+
+        qint64 allowance = std::min<qint64>(connection.end - connection.position, CHUNK);
+        if (m_profile.perConnection > 0) {
+            allowance = std::min(allowance, static_cast<qint64>(connection.tokens));
+        }
+        if (m_profile.bandwidth > 0) {
+            allowance = std::min(allowance, static_cast<qint64>(m_globalTokens));
+        }
+        if (connection.truncateAt >= 0) {
+            allowance = std::min(allowance, connection.truncateAt - connection.position);
+            if (allowance <= 0) {
+                ++truncated;
+                connection.socket->abort();
+                return;
+            }
+        }
+        if (allowance <= 0) {
+            return;  // Out of tokens until the next tick
+        }
+
+        qsizetype offset = static_cast<qsizetype>(connection.position % PATTERN_PERIOD);
+        connection.socket->write(table + offset, allowance);
+        if (!connection.firstBytePath.isEmpty()) {
+            std::lock_guard lock(m_firstByteMutex);
+            m_firstByte.try_emplace(connection.firstBytePath, Clock::now());
+            connection.firstBytePath.clear();
+        }
+        connection.position += allowance;
+        connection.tokens -= static_cast<double>(allowance);
+        m_globalTokens -= static_cast<double>(allowance);
+        bytesSent += allowance;
+    }
+    finishResponse(connection);
+}
+
+void ServerCore::finishResponse(Connection& connection) {
+    connection.state = State::Reading;
+    connection.truncateAt = -1;
+    connection.firstBytePath.clear();
+    if (!connection.keepAlive) {
+        connection.socket->disconnectFromHost();
+        return;
+    }
+    if (!connection.input.isEmpty()) {
+        handleRequest(connection);
+    }
+}
+
+void ServerCore::tick() {
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastTick).count();
+    m_lastTick = now;
+
+    if (m_profile.bandwidth > 0) {
+        m_globalTokens = std::min(m_globalTokens + m_profile.bandwidth * elapsed,
+                                  m_profile.bandwidth * BURST_SECONDS);
+    }
+
+    // Snapshot: pumping may drop connections; a rotating start shares the
+    // aggregate bucket fairly
+    std::vector<QTcpSocket*> sockets;
+    sockets.reserve(m_connections.size());
+    for (const auto& [socket, connection] : m_connections) {
+        sockets.push_back(socket);
+    }
+    if (sockets.empty()) {
+        return;
+    }
+    m_rotation = (m_rotation + 1) % sockets.size();
+    std::rotate(sockets.begin(), sockets.begin() + static_cast<std::ptrdiff_t>(m_rotation), sockets.end());
+
+    for (QTcpSocket* socket : sockets) {
+        auto it = m_connections.find(socket);
+        if (it == m_connections.end()) {
+            continue;
+        }
+        Connection& connection = *it->second;
+        if (m_profile.perConnection > 0) {
+            connection.tokens = std::min(connection.tokens + m_profile.perConnection * elapsed,
+                                         m_profile.perConnection * BURST_SECONDS);
+        }
+        pump(connection);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// BenchServer
+// ═══════════════════════════════════════════════════════════════════════════════
+
+BenchServer::BenchServer(QObject* parent)
+    : QObject(parent)
+{
+    m_thread.setObjectName(QStringLiteral("BenchServer"));
+    m_thread.start();
+    m_core = new ServerCore;
+    m_core->moveToThread(&m_thread);
+}
+
+BenchServer::~BenchServer() {
+    ServerCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core]() {
+        core->close();
+        delete core;
+    }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+bool BenchServer::start(const ServerProfile& profile) {
+    bool ok = false;
+    quint16 port = 0;
+    QMetaObject::invokeMethod(m_core, [this, &profile, &ok, &port]() {
+        ok = m_core->listen(profile, port);
+    }, Qt::BlockingQueuedConnection);
+    m_port = ok ? port : 0;
+    return ok;
+}
+
+void BenchServer::stop() {
+    QMetaObject::invokeMethod(m_core, [this]() { m_core->close(); }, Qt::BlockingQueuedConnection);
+    m_port = 0;
+}
+
+QUrl BenchServer::fileUrl(const QString& name, ByteCount size) const {
+    return QUrl(QStringLiteral("http://127.0.0.1:%1/%2/%3").arg(m_port).arg(size).arg(name));
+}
+
+ServerStats BenchServer::stats() const {
+    ServerStats stats;
+    stats.connections = m_core->connections;
+    stats.requests = m_core->requests;
+    stats.injectedErrors = m_core->injectedErrors;
+    stats.truncated = m_core->truncated;
+    stats.bytesSent = m_core->bytesSent;
+    stats.peakConnections = m_core->peakConnections;
+
+    ServerCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, &stats]() {
+        stats.cpuSeconds = core->cpuSeconds();
+    }, Qt::BlockingQueuedConnection);
+    return stats;
+}
+
+std::optional<std::chrono::steady_clock::time_point> BenchServer::firstByteAt(const QUrl& url) const {
+    return m_core->firstByteAt(url.path(QUrl::FullyEncoded).toUtf8());
+}
+
+char BenchServer::patternAt(ByteOffset offset) {
+    return patternTable()[offset % PATTERN_PERIOD];
+}
+
+bool BenchServer::verifyFile(const QString& path, ByteCount size, int samples) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() != size) {
+        return false;
+    }
+
+    const char* table = patternTable();
+    auto matches = [&file, table](ByteOffset offset, qint64 length) {
+        if (!file.seek(offset)) {
+            return false;
+        }
+        QByteArray data = file.read(length);
+        for (qsizetype i = 0; i < data.size(); ++i) {
+            if (data.at(i) != table[(offset + i) % PATTERN_PERIOD]) {
+                return false;
+            }
+        }
+        return data.size() == length;
+    };
+
+    if (samples <= 0) {
+        for (ByteOffset offset = 0; offset < size; offset += 1024 * 1024) {
+            if (!matches(offset, std::min<ByteCount>(1024 * 1024, size - offset))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Evenly spread spots, plus the very end where truncation shows
+    constexpr qint64 SPOT = 4096;
+    for (int i = 0; i <= samples; ++i) {
+        ByteOffset offset = (size > SPOT) ? (size - SPOT) * i / samples : 0;
+        if (!matches(offset, std::min<ByteCount>(SPOT, size - offset))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace OpenIDM::Bench
@@ -0,0 +1,128 @@
+/**
+ * @file BenchServer.h
+ * @brief In-process HTTP/1.1 range server with traffic shaping
+ *
+ * Serves synthetic files of any size from a fixed byte pattern, so a
+ * benchmark needs no disk fixtures and can check every downloaded byte.
+ * Bandwidth (aggregate and per connection), response latency, connection
+ * limits and injected failures make one machine behave like the slow,
+ * flaky or throttling servers the engine is built for.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QUrl>
+
+namespace OpenIDM::Bench {
+
+// ───────────────────────────────────────────────────────────────────────────
+// Configuration
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief How the server misbehaves
+ */
+struct ServerProfile {
+    SpeedBps bandwidth = 0;             ///< Aggregate cap in bytes/sec (0 = unlimited)
+    SpeedBps perConnection = 0;         ///< Cap per TCP connection (0 = unlimited)
+    Duration latency{0};                ///< Delay before each response's headers
+    int maxConnections = 0;             ///< Concurrent connections served; excess get 503 (0 = any)
+    double errorRate = 0.0;             ///< Share of GETs answered 503
+    double truncateRate = 0.0;          ///< Share of bodies cut off half-way
+    bool ranges = true;                 ///< Honour Range requests
+};
+
+/**
+ * @brief Counters since start()
+ */
+struct ServerStats {
+    quint64 connections = 0;
+    quint64 requests = 0;
+    quint64 injectedErrors = 0;         ///< 503s from errorRate and maxConnections
+    quint64 truncated = 0;
+    ByteCount bytesSent = 0;
+    int peakConnections = 0;
+    double cpuSeconds = 0.0;            ///< Spent on the server thread
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// Server
+// ───────────────────────────────────────────────────────────────────────────
+
+class ServerCore;
+
+/**
+ * @class BenchServer
+ * @brief Shaping range server on a thread of its own
+ *
+ * Any path of the form `/<size>/<name>` serves `size` bytes of the
+ * pattern, so URLs and file names are unique per run (no cache hits
+ * across scenarios) without registering files first.
+ *
+ * Thread Safety:
+ * - Call the public methods from the owning thread
+ * - The sockets live on the server thread
+ */
+class BenchServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BenchServer(QObject* parent = nullptr);
+    ~BenchServer() override;
+
+    // Disable copying
+    BenchServer(const BenchServer&) = delete;
+    BenchServer& operator=(const BenchServer&) = delete;
+
+    /**
+     * @brief Listen on 127.0.0.1 with a fresh profile and zeroed counters
+     * @return False if no port could be bound
+     */
+    bool start(const ServerProfile& profile);
+
+    /// Close every connection and stop listening
+    void stop();
+
+    /// @return URL of a file called @p name with @p size bytes
+    QUrl fileUrl(const QString& name, ByteCount size) const;
+
+    /// @return Counters since start(), including the thread's CPU time
+    ServerStats stats() const;
+
+    /**
+     * @brief When the first body byte of @p url left the server
+     *
+     * Taken at the socket write, so on loopback it trails the client's
+     * first byte by microseconds, without polling the client's progress.
+     */
+    std::optional<std::chrono::steady_clock::time_point> firstByteAt(const QUrl& url) const;
+
+    /// @return Byte at @p offset of every served file
+    static char patternAt(ByteOffset offset);
+
+    /**
+     * @brief Compare a downloaded file with the pattern
+     * @param path Local file
+     * @param size Expected size
+     * @param samples Spots checked (0 = every byte)
+     * @return True if size and content match
+     */
+    static bool verifyFile(const QString& path, ByteCount size, int samples);
+
+private:
+    QThread m_thread;
+    ServerCore* m_core{nullptr};
+    quint16 m_port{0};
+};
+
+} // namespace OpenIDM::Bench
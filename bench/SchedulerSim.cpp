@@ -0,0 +1,321 @@
+/**
+ * @file SchedulerSim.cpp
+ * @brief Implementation of the virtual-clock scheduler simulator
+ */
+
+#include "SchedulerSim.h"
+
+#include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/HostGovernor.h"
+#include "openidm/engine/Segment.h"
+#include "openidm/engine/SegmentScheduler.h"
+#include "openidm/engine/SegmentWorker.h"
+
+#include <QObject>
+#include <QUrl>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <utility>
+
+namespace OpenIDM::Bench {
+
+namespace {
+
+using Clock = RetryWheel::Clock;
+
+/// Nearest-rank percentile of sorted @p values
+double rank(const std::vector<double>& values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(std::ceil(p * static_cast<double>(values.size())));
+    return values[std::clamp<size_t>(index, 1, values.size()) - 1];
+}
+
+/**
+ * One worker's connection. The stream position follows what the modelled
+ * server sends; Segment::claim() decides how much of it is new.
+ */
+struct Connection {
+    SegmentWorker* worker = nullptr;
+    Segment* segment = nullptr;
+    ByteOffset streamPos = 0;
+    double carry = 0.0;                 ///< Fraction of a byte left from the last tick
+    double pathFactor = 1.0;            ///< Below 1 on a bad path
+    SpeedBps rate = 0.0;                ///< This attempt's unshaped rate
+    Clock::time_point readyAt{};        ///< First byte of the attempt
+    Clock::time_point stalledUntil{};
+    uint64_t generation = ~uint64_t(0); ///< workGeneration() at the last failed acquire
+};
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Summary
+// ═══════════════════════════════════════════════════════════════════════════════
+
+SimulationSummary SimulationSummary::of(const std::vector<SimulationResult>& results, ByteCount fileSize) {
+    SimulationSummary summary;
+    summary.runs = results.size();
+
+    std::vector<double> elapsed;
+    double received = 0.0;
+    for (const SimulationResult& result : results) {
+        summary.steals += static_cast<double>(result.steals);
+        summary.hedges += static_cast<double>(result.hedges);
+        summary.splits += static_cast<double>(result.splits);
+        if (!result.completed) {
+            continue;
+        }
+        ++summary.completed;
+        elapsed.push_back(static_cast<double>(result.elapsed.count()));
+        received += static_cast<double>(result.received);
+    }
+    if (summary.runs > 0) {
+        auto runs = static_cast<double>(summary.runs);
+        summary.steals /= runs;
+        summary.hedges /= runs;
+        summary.splits /= runs;
+    }
+
+    std::sort(elapsed.begin(), elapsed.end());
+    summary.p50 = rank(elapsed, 0.50);
+    summary.p90 = rank(elapsed, 0.90);
+    summary.p99 = rank(elapsed, 0.99);
+    summary.max = elapsed.empty() ? 0.0 : elapsed.back();
+    if (summary.completed > 0 && fileSize > 0) {
+        summary.overhead = received / static_cast<double>(summary.completed) / static_cast<double>(fileSize) - 1.0;
+    }
+    return summary;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+SchedulerSimulator::SchedulerSimulator(ByteCount fileSize, NetworkModel network, SchedulerPolicy policy)
+    : m_fileSize(fileSize)
+    , m_network(network)
+    , m_policy(policy)
+    , m_task(std::make_unique<DownloadTask>(QUrl(QStringLiteral("http://scheduler.sim.invalid/file.bin")),
+                                            QString()))
+{
+    m_policy.segments = std::clamp(m_policy.segments, 1, static_cast<int>(Constants::MAX_SEGMENTS));
+}
+
+SchedulerSimulator::~SchedulerSimulator() = default;
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Running
+// ═══════════════════════════════════════════════════════════════════════════════
+
+SimulationResult SchedulerSimulator::run(quint64 seed, Duration limit) {
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    auto exponential = [&](double mean) { return -std::log(1.0 - uniform(random)) * mean; };
+
+    HostGovernor& governor = HostGovernor::instance();
+    governor.seedJitter(static_cast<quint32>(seed ^ (seed >> 32)));
+    governor.setLimit(std::max(governor.limit(), static_cast<size_t>(m_policy.segments)));
+
+    // Virtual time; any fixed origin keeps runs comparable
+    const Clock::time_point origin{std::chrono::hours(1)};
+    Clock::time_point now = origin;
+    const double tickSeconds = std::chrono::duration<double>(TICK).count();
+
+    SimulationResult result;
+    m_task->trace().clear();
+    SegmentScheduler scheduler(m_task.get());
+    scheduler.m_clock = [&now]() { return now; };
+    QObject::connect(&scheduler, &SegmentScheduler::rebalanced,
+                     [&result](int splits) { result.splits += static_cast<size_t>(splits); });
+
+    scheduler.initializeSegments(m_fileSize, static_cast<size_t>(m_policy.segments));
+
+    std::vector<std::unique_ptr<SegmentWorker>> workers;
+    std::vector<Connection> connections(static_cast<size_t>(m_policy.segments));
+    for (Connection& connection : connections) {
+        workers.push_back(std::make_unique<SegmentWorker>(m_task.get(), &scheduler));
+        connection.worker = workers.back().get();
+        connection.pathFactor = uniform(random) < m_network.slowShare ? m_network.slowFactor : 1.0;
+        scheduler.registerWorker(connection.worker);
+    }
+
+    // As SegmentWorker::finishSegment(); while a hedged twin is still
+    // streaming, a failure leaves the segment's state to it
+    auto release = [&](Connection& connection, bool success) {
+        Segment* segment = std::exchange(connection.segment, nullptr);
+        if (success) {
+            segment->setState(SegmentState::Completed);
+        } else if (segment->writerCount() == 1) {
+            segment->setLastError(QStringLiteral("Connection reset (simulated)"));
+            segment->setState(SegmentState::Failed);
+        }
+        scheduler.releaseSegment(connection.worker, segment);
+    };
+
+    const auto sampleEvery = Constants::PROGRESS_UPDATE_INTERVAL;
+    const auto retryEvery = Constants::RETRY_WHEEL_TICK;
+    Clock::time_point nextSample = origin + sampleEvery;
+    Clock::time_point nextRebalance = origin + m_policy.rebalanceInterval;
+    Clock::time_point nextRetry = origin + retryEvery;
+    const Clock::time_point deadline = origin + limit;
+    std::optional<Clock::time_point> resetAt;
+    if (m_policy.resetAt.count() > 0) {
+        resetAt = origin + m_policy.resetAt;
+    }
+
+    while (!scheduler.isAllComplete() && !scheduler.hasFailed() && now < deadline) {
+        // As DownloadTask::onResourceChanged(): the workers stop and the
+        // layout is dropped; the re-probe takes a round trip, during which
+        // the retry timer keeps firing, before the layout is rebuilt
+        if (resetAt && now >= *resetAt) {
+            resetAt.reset();
+            for (Connection& connection : connections) {
+                if (connection.segment) {
+                    release(connection, false);
+                }
+                scheduler.unregisterWorker(connection.worker);
+                connection.generation = ~uint64_t(0);
+                connection.carry = 0.0;
+            }
+            scheduler.reset();
+
+            const Clock::time_point probed = now + m_network.latency;
+            while (now < probed) {
+                now += TICK;
+                if (now >= nextRetry) {
+                    scheduler.onRetryTimer();
+                    nextRetry += retryEvery;
+                }
+            }
+            result.resetClean = scheduler.isAllComplete() && scheduler.segmentCount() == 0;
+
+            scheduler.initializeSegments(m_fileSize, static_cast<size_t>(m_policy.segments));
+            for (Connection& connection : connections) {
+                scheduler.registerWorker(connection.worker);
+            }
+        }
+
+        // Idle workers ask again only when work may have appeared, as
+        // SegmentWorker::run() does with waitForWork()
+        uint64_t generation = scheduler.workGeneration();
+        for (Connection& connection : connections) {
+            if (connection.segment || connection.generation == generation) {
+                continue;
+            }
+            Segment* segment = scheduler.acquireSegment(connection.worker);
+            if (!segment) {
+                connection.generation = generation;
+                continue;
+            }
+            connection.segment = segment;
+            connection.streamPos = segment->currentByte();
+            connection.rate = m_network.bandwidth * connection.pathFactor *
+                              std::exp(m_network.spread * normal(random));
+            connection.readyAt = now + std::chrono::duration_cast<Clock::duration>(
+                                           std::chrono::duration<double, std::milli>(
+                                               exponential(static_cast<double>(m_network.latency.count()))));
+            connection.generation = ~uint64_t(0);
+        }
+
+        now += TICK;
+
+        // Shape: connections past their first byte and not stalled share the server
+        double demand = 0.0;
+        for (Connection& connection : connections) {
+            if (connection.segment && now >= connection.readyAt && now >= connection.stalledUntil) {
+                demand += connection.rate;
+            }
+        }
+        double share = m_network.serverBandwidth > 0 && demand > m_network.serverBandwidth
+                           ? m_network.serverBandwidth / demand
+                           : 1.0;
+
+        for (Connection& connection : connections) {
+            if (!connection.segment || now < connection.readyAt) {
+                continue;
+            }
+
+            if (m_network.failureRate > 0 && uniform(random) < m_network.failureRate * tickSeconds) {
+                ++result.failures;
+                release(connection, false);
+                continue;
+            }
+            if (now < connection.stalledUntil) {
+                continue;
+            }
+            if (m_network.stallRate > 0 && uniform(random) < m_network.stallRate * tickSeconds) {
+                connection.stalledUntil = now + std::chrono::duration_cast<Clock::duration>(
+                                                    std::chrono::duration<double, std::milli>(exponential(
+                                                        static_cast<double>(m_network.stallLength.count()))));
+                continue;
+            }
+
+            double bytes = connection.rate * share * tickSeconds + connection.carry;
+            auto whole = static_cast<ByteCount>(bytes);
+            connection.carry = bytes - static_cast<double>(whole);
+            if (whole <= 0) {
+                continue;
+            }
+
+            // Same accounting as the write callback
+            Segment* segment = connection.segment;
+            ByteOffset writeFrom = 0;
+            ByteCount claimed = segment->claim(connection.streamPos, whole, &writeFrom);
+            connection.streamPos += whole;
+            result.received += whole;
+            connection.worker->m_totalBytesDownloaded.fetch_add(claimed, std::memory_order_relaxed);
+
+            if (segment->remainingBytes() <= 0) {
+                release(connection, true);
+            }
+        }
+
+        if (now >= nextSample) {
+            scheduler.sampleThroughput();
+            nextSample += sampleEvery;
+        }
+        if (m_policy.rebalance && now >= nextRebalance) {
+            scheduler.rebalanceSegments();
+            nextRebalance += m_policy.rebalanceInterval;
+        }
+        if (now >= nextRetry) {
+            scheduler.onRetryTimer();
+            nextRetry += retryEvery;
+        }
+    }
+
+    result.completed = scheduler.isAllComplete();
+    result.elapsed = std::chrono::duration_cast<Duration>(now - origin);
+    result.segments = scheduler.segmentCount();
+    for (const auto& stats : scheduler.workerStats()) {
+        result.steals += stats.steals;
+        result.hedges += stats.hedges;
+    }
+
+    // Hand back what is still held, then drop the workers before their scheduler
+    for (Connection& connection : connections) {
+        if (connection.segment) {
+            scheduler.releaseSegment(connection.worker, connection.segment);
+        }
+        scheduler.unregisterWorker(connection.worker);
+    }
+    workers.clear();
+    return result;
+}
+
+std::vector<SimulationResult> SchedulerSimulator::runMany(size_t runs, quint64 firstSeed) {
+    std::vector<SimulationResult> results;
+    results.reserve(runs);
+    for (size_t i = 0; i < runs; ++i) {
+        results.push_back(run(firstSeed + i));
+    }
+    return results;
+}
+
+} // namespace OpenIDM::Bench
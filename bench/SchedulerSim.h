@@ -0,0 +1,143 @@
+/**
+ * @file SchedulerSim.h
+ * @brief Deterministic simulation of SegmentScheduler on a virtual clock
+ *
+ * Work-stealing and rebalancing changes are hard to judge on a live
+ * network: every run sees different bandwidth, and a difference of a few
+ * percent drowns in the noise. The simulator runs the real scheduler
+ * against a modelled network instead. Virtual time advances in fixed
+ * ticks, every connection draws its rate, stalls and failures from a
+ * seeded generator, and the scheduler's sampling, rebalance and retry
+ * timers fire on virtual time. A run of a 1 GiB download takes
+ * milliseconds, and a seed fixes everything the network does in it.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+namespace OpenIDM {
+class DownloadTask;
+}
+
+namespace OpenIDM::Bench {
+
+// ───────────────────────────────────────────────────────────────────────────
+// Configuration
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief How the simulated network behaves
+ */
+struct NetworkModel {
+    SpeedBps bandwidth = 4 * 1024 * 1024;   ///< Median per-connection rate (bytes/sec)
+    double spread = 0.3;                    ///< Log-normal sigma of each attempt's rate
+    double slowShare = 0.0;                 ///< Share of connections on a bad path for the whole run
+    double slowFactor = 0.1;                ///< Their rate relative to the median
+    SpeedBps serverBandwidth = 0;           ///< Aggregate cap, shared fairly (0 = unlimited)
+    Duration latency{50};                   ///< Request to first byte, per attempt
+    double stallRate = 0.0;                 ///< Stalls per connection-second
+    Duration stallLength{2000};             ///< Mean stall (exponential)
+    double failureRate = 0.0;               ///< Connection resets per connection-second
+};
+
+/**
+ * @brief The scheduler settings a run uses
+ *
+ * MIN_STEAL_SIZE and the split rules are compile-time constants of
+ * Segment; compare them across builds, the JSON output records them.
+ */
+struct SchedulerPolicy {
+    int segments = static_cast<int>(Constants::DEFAULT_SEGMENTS);
+    bool rebalance = true;
+    Duration rebalanceInterval = Constants::REBALANCE_INTERVAL;
+    Duration resetAt{0};                ///< Drop and rebuild the layout then, as a resource change does (0 = never)
+};
+
+/**
+ * @brief Outcome of one simulated download
+ */
+struct SimulationResult {
+    bool completed = false;             ///< False if a segment ran out of retries or time ran out
+    Duration elapsed{0};                ///< Virtual time to the last byte
+    ByteCount received = 0;             ///< Streamed, including bytes another writer delivered first
+    size_t steals = 0;
+    size_t hedges = 0;
+    size_t splits = 0;                  ///< By rebalanceSegments()
+    size_t failures = 0;                ///< Injected connection resets
+    size_t segments = 0;                ///< Segments at the end
+    bool resetClean = true;             ///< Nothing of the old layout was left to retry after resetAt
+};
+
+/**
+ * @brief Completion times over many runs
+ */
+struct SimulationSummary {
+    size_t runs = 0;
+    size_t completed = 0;
+    double p50 = 0.0;                   ///< Milliseconds, completed runs only
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double overhead = 0.0;              ///< Mean received / file size - 1
+    double steals = 0.0;                ///< Mean per run
+    double hedges = 0.0;
+    double splits = 0.0;
+
+    static SimulationSummary of(const std::vector<SimulationResult>& results, ByteCount fileSize);
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// Simulator
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @class SchedulerSimulator
+ * @brief Runs a real SegmentScheduler against a NetworkModel
+ *
+ * Each run creates a scheduler and one SegmentWorker per segment, but no
+ * worker ever starts: the simulator acquires and releases segments on
+ * their behalf, claims bytes with Segment::claim() like the write
+ * callback does and bumps the counters sampleThroughput() reads.
+ *
+ * Thread Safety:
+ * - Single-threaded; one simulator per thread
+ */
+class SchedulerSimulator {
+public:
+    /// Virtual time per step
+    static constexpr Duration TICK{10};
+
+    SchedulerSimulator(ByteCount fileSize, NetworkModel network, SchedulerPolicy policy);
+    ~SchedulerSimulator();
+
+    // Disable copying
+    SchedulerSimulator(const SchedulerSimulator&) = delete;
+    SchedulerSimulator& operator=(const SchedulerSimulator&) = delete;
+
+    /**
+     * @brief Simulate one download
+     * @param seed Seeds the network model and HostGovernor's retry jitter
+     * @param limit Virtual time after which the run counts as not completed
+     */
+    SimulationResult run(quint64 seed, Duration limit = Duration(3600 * 1000));
+
+    /// @return Results of @p runs runs seeded @p firstSeed, @p firstSeed + 1, ...
+    std::vector<SimulationResult> runMany(size_t runs, quint64 firstSeed = 1);
+
+    ByteCount fileSize() const { return m_fileSize; }
+
+private:
+    ByteCount m_fileSize;
+    NetworkModel m_network;
+    SchedulerPolicy m_policy;
+    std::unique_ptr<DownloadTask> m_task;   ///< Owner of the trace and sources the scheduler reads
+};
+
+} // namespace OpenIDM::Bench
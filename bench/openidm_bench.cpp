@@ -0,0 +1,584 @@
+/**
+ * @file openidm_bench.cpp
+ * @brief End-to-end throughput benchmark
+ *
+ * Drives DownloadManager against the in-process BenchServer and prints
+ * one JSON document per run: throughput, client CPU time per GiB, peak
+ * RSS, time to first byte and completion-time percentiles per scenario.
+ * With --baseline a previous document is compared against, and a
+ * throughput drop beyond --tolerance fails the run.
+ *
+ *   openidm_bench --list
+ *   openidm_bench --scenario single-large --repeat 3 --output run.json
+ *   openidm_bench --baseline main.json --tolerance 0.1
+ */
+
+#include "BenchServer.h"
+
+#include "openidm/engine/DownloadManager.h"
+#include "openidm/engine/DownloadTask.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace OpenIDM;
+using namespace OpenIDM::Bench;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double GIB = 1024.0 * 1024.0 * 1024.0;
+constexpr double MIB = 1024.0 * 1024.0;
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Scenarios
+// ═══════════════════════════════════════════════════════════════════════════════
+
+struct Scenario {
+    QString name;
+    QString description;
+    int files = 1;
+    ByteCount fileSize = 0;
+    ServerProfile profile;
+    int segments = 0;                   ///< Per download (0 = engine default)
+    int concurrent = 0;                 ///< Downloads at once (0 = engine default)
+};
+
+std::vector<Scenario> builtinScenarios() {
+    std::vector<Scenario> scenarios;
+
+    Scenario single;
+    single.name = QStringLiteral("single-large");
+    single.description = QStringLiteral("One 256 MiB file from an unthrottled server");
+    single.fileSize = 256LL * 1024 * 1024;
+    scenarios.push_back(single);
+
+    Scenario capped;
+    capped.name = QStringLiteral("per-connection-capped");
+    capped.description = QStringLiteral("64 MiB at 4 MiB/s per connection, 64 MiB/s in total");
+    capped.fileSize = 64LL * 1024 * 1024;
+    capped.profile.perConnection = 4 * MIB;
+    capped.profile.bandwidth = 64 * MIB;
+    scenarios.push_back(capped);
+
+    Scenario small;
+    small.name = QStringLiteral("many-small");
+    small.description = QStringLiteral("200 files of 256 KiB with 20 ms server latency");
+    small.files = 200;
+    small.fileSize = 256 * 1024;
+    small.profile.latency = Duration(20);
+    scenarios.push_back(small);
+
+    Scenario flaky;
+    flaky.name = QStringLiteral("flaky");
+    flaky.description = QStringLiteral("32 MiB files with 5% 503s and 2% bodies cut short");
+    flaky.files = 4;
+    flaky.fileSize = 32LL * 1024 * 1024;
+    flaky.profile.errorRate = 0.05;
+    flaky.profile.truncateRate = 0.02;
+    scenarios.push_back(flaky);
+
+    Scenario distant;
+    distant.name = QStringLiteral("high-latency");
+    distant.description = QStringLiteral("16 MiB with 150 ms latency and at most 6 connections");
+    distant.fileSize = 16LL * 1024 * 1024;
+    distant.profile.latency = Duration(150);
+    distant.profile.maxConnections = 6;
+    scenarios.push_back(distant);
+
+    return scenarios;
+}
+
+QJsonObject describe(const Scenario& scenario) {
+    QJsonObject profile;
+    profile[QStringLiteral("bandwidth")] = scenario.profile.bandwidth;
+    profile[QStringLiteral("perConnection")] = scenario.profile.perConnection;
+    profile[QStringLiteral("latencyMs")] = static_cast<qint64>(scenario.profile.latency.count());
+    profile[QStringLiteral("maxConnections")] = scenario.profile.maxConnections;
+    profile[QStringLiteral("errorRate")] = scenario.profile.errorRate;
+    profile[QStringLiteral("truncateRate")] = scenario.profile.truncateRate;
+    profile[QStringLiteral("ranges")] = scenario.profile.ranges;
+
+    QJsonObject object;
+    object[QStringLiteral("description")] = scenario.description;
+    object[QStringLiteral("files")] = scenario.files;
+    object[QStringLiteral("fileSize")] = scenario.fileSize;
+    object[QStringLiteral("segments")] = scenario.segments;
+    object[QStringLiteral("concurrent")] = scenario.concurrent;
+    object[QStringLiteral("server")] = profile;
+    return object;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Process Usage
+// ═══════════════════════════════════════════════════════════════════════════════
+
+double processCpuSeconds() {
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+    auto ticks = [](const FILETIME& time) {
+        return (static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return static_cast<double>(ticks(kernel) + ticks(user)) / 1e7;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval& time) {
+        return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+    };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+#endif
+}
+
+/// Start a new peak-RSS window where the OS allows it (Linux only)
+void resetPeakRss() {
+#ifdef Q_OS_LINUX
+    QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+    }
+#endif
+}
+
+/// @return Peak resident set in bytes since resetPeakRss(), or since start
+ByteCount peakRssBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return static_cast<ByteCount>(counters.PeakWorkingSetSize);
+#else
+#ifdef Q_OS_LINUX
+    // VmHWM honours clear_refs; ru_maxrss never goes down
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : status.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+            }
+        }
+    }
+#endif
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MACOS
+    return static_cast<ByteCount>(usage.ru_maxrss);
+#else
+    return static_cast<ByteCount>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Statistics
+// ═══════════════════════════════════════════════════════════════════════════════
+
+/// Nearest-rank percentiles of @p values in milliseconds
+QJsonObject percentiles(std::vector<double> values) {
+    QJsonObject object;
+    if (values.empty()) {
+        return object;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = [&values](double p) {
+        size_t index = static_cast<size_t>(std::ceil(p * static_cast<double>(values.size())));
+        return values[std::clamp<size_t>(index, 1, values.size()) - 1];
+    };
+    object[QStringLiteral("p50")] = rank(0.50);
+    object[QStringLiteral("p90")] = rank(0.90);
+    object[QStringLiteral("p99")] = rank(0.99);
+    object[QStringLiteral("max")] = values.back();
+    return object;
+}
+
+double millisecondsBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Running
+// ═══════════════════════════════════════════════════════════════════════════════
+
+struct Transfer {
+    QUrl url;
+    Clock::time_point added{};
+    Clock::time_point finished{};
+    bool done = false;
+    bool failed = false;
+    QString error;
+};
+
+/**
+ * One pass over a scenario. Downloads go to a temporary directory that
+ * is removed afterwards; files are verified byte for byte (or at
+ * @p samples spots) once the clock has stopped.
+ */
+QJsonObject runScenario(BenchServer& server, const Scenario& scenario, int pass,
+                        Duration timeout, int samples) {
+    DownloadManager& manager = DownloadManager::instance();
+
+    QJsonObject result;
+    result[QStringLiteral("pass")] = pass;
+
+    QTemporaryDir directory;
+    if (!directory.isValid() || !server.start(scenario.profile)) {
+        result[QStringLiteral("error")] = QStringLiteral("setup failed");
+        return result;
+    }
+
+    EngineTunables tunables = manager.tunables();
+    EngineTunables defaults;
+    tunables.maxSegmentsPerDownload = scenario.segments > 0 ? scenario.segments : defaults.maxSegmentsPerDownload;
+    tunables.maxConcurrentDownloads = scenario.concurrent > 0 ? scenario.concurrent : defaults.maxConcurrentDownloads;
+    manager.setTunables(tunables);
+
+    std::vector<Transfer> transfers(static_cast<size_t>(scenario.files));
+    QHash<TaskId, size_t> index;
+    int pending = scenario.files;
+    QEventLoop loop;
+
+    auto settle = [&](const TaskId& id, bool failed, const QString& error) {
+        auto it = index.constFind(id);
+        if (it == index.constEnd() || transfers[*it].done) {
+            return;
+        }
+        Transfer& transfer = transfers[*it];
+        transfer.finished = Clock::now();
+        transfer.done = true;
+        transfer.failed = failed;
+        transfer.error = error;
+        if (--pending == 0) {
+            loop.quit();
+        }
+    };
+    QMetaObject::Connection completed = QObject::connect(&manager, &DownloadManager::downloadCompleted,
+        [&settle](const TaskId& id) { settle(id, false, {}); });
+    QMetaObject::Connection failed = QObject::connect(&manager, &DownloadManager::downloadFailed,
+        [&settle](const TaskId& id, const QString& error) { settle(id, true, error); });
+
+    resetPeakRss();
+    double cpuBefore = processCpuSeconds();
+    Clock::time_point start = Clock::now();
+
+    // Unique names keep HostCache and the media cache out of the numbers
+    QString stamp = QString::number(QDateTime::currentMSecsSinceEpoch(), 36);
+    for (int i = 0; i < scenario.files; ++i) {
+        Transfer& transfer = transfers[static_cast<size_t>(i)];
+        transfer.url = server.fileUrl(QStringLiteral("%1-%2-%3-%4.bin")
+                                          .arg(scenario.name, stamp).arg(pass).arg(i),
+                                      scenario.fileSize);
+        transfer.added = Clock::now();
+        TaskId id = manager.addDownload(transfer.url, directory.path(), true);
+        if (id.isNull()) {
+            transfer.done = true;
+            transfer.failed = true;
+            transfer.error = QStringLiteral("rejected");
+            --pending;
+            continue;
+        }
+        index.insert(id, static_cast<size_t>(i));
+    }
+
+    bool timedOut = false;
+    if (pending > 0) {
+        QTimer::singleShot(std::chrono::milliseconds(timeout), &loop, [&loop, &timedOut]() {
+            timedOut = true;
+            loop.quit();
+        });
+        loop.exec();
+    }
+
+    Clock::time_point stop = Clock::now();
+    double cpuSeconds = processCpuSeconds() - cpuBefore;
+    ByteCount peakRss = peakRssBytes();
+    ServerStats stats = server.stats();
+    QObject::disconnect(completed);
+    QObject::disconnect(failed);
+
+    // Timing ends here; check what landed on disk
+    std::vector<double> firstByte;
+    std::vector<double> completion;
+    int failures = 0;
+    int corrupt = 0;
+    QJsonArray errors;
+    for (auto it = index.constBegin(); it != index.constEnd(); ++it) {
+        const Transfer& transfer = transfers[it.value()];
+        if (auto sent = server.firstByteAt(transfer.url)) {
+            firstByte.push_back(millisecondsBetween(transfer.added, *sent));
+        }
+        if (!transfer.done || transfer.failed) {
+            continue;
+        }
+        completion.push_back(millisecondsBetween(transfer.added, transfer.finished));
+        DownloadTask* task = manager.task(it.key());
+        if (!task || !BenchServer::verifyFile(task->filePath(), scenario.fileSize, samples)) {
+            ++corrupt;
+        }
+    }
+    for (const Transfer& transfer : transfers) {
+        if (!transfer.done || transfer.failed) {
+            ++failures;
+            if (errors.size() < 5) {
+                errors.append(transfer.done ? transfer.error : QStringLiteral("timed out"));
+            }
+        }
+    }
+
+    manager.removeAllDownloads(true);
+    server.stop();
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    double bytes = static_cast<double>(completion.size()) * static_cast<double>(scenario.fileSize);
+    double clientCpu = std::max(0.0, cpuSeconds - stats.cpuSeconds);
+
+    QJsonObject serverStats;
+    serverStats[QStringLiteral("connections")] = static_cast<qint64>(stats.connections);
+    serverStats[QStringLiteral("peakConnections")] = stats.peakConnections;
+    serverStats[QStringLiteral("requests")] = static_cast<qint64>(stats.requests);
+    serverStats[QStringLiteral("injectedErrors")] = static_cast<qint64>(stats.injectedErrors);
+    serverStats[QStringLiteral("truncated")] = static_cast<qint64>(stats.truncated);
+    serverStats[QStringLiteral("bytesSent")] = stats.bytesSent;
+    serverStats[QStringLiteral("cpuSeconds")] = stats.cpuSeconds;
+
+    result[QStringLiteral("seconds")] = seconds;
+    result[QStringLiteral("bytes")] = bytes;
+    result[QStringLiteral("throughputMiBps")] = seconds > 0 ? bytes / MIB / seconds : 0.0;
+    result[QStringLiteral("cpuSeconds")] = clientCpu;
+    result[QStringLiteral("cpuSecondsPerGiB")] = bytes > 0 ? clientCpu / (bytes / GIB) : 0.0;
+    result[QStringLiteral("peakRssMiB")] = static_cast<double>(peakRss) / MIB;
+    result[QStringLiteral("ttfbMs")] = percentiles(std::move(firstByte));
+    result[QStringLiteral("completionMs")] = percentiles(std::move(completion));
+    result[QStringLiteral("failures")] = failures;
+    result[QStringLiteral("corrupt")] = corrupt;
+    result[QStringLiteral("timedOut")] = timedOut;
+    result[QStringLiteral("server")] = serverStats;
+    if (!errors.isEmpty()) {
+        result[QStringLiteral("errors")] = errors;
+    }
+    return result;
+}
+
+/// Median of the passes, so one noisy pass does not decide a regression
+double medianThroughput(const QJsonArray& passes) {
+    std::vector<double> values;
+    for (const QJsonValue& pass : passes) {
+        values.push_back(pass.toObject().value(QStringLiteral("throughputMiBps")).toDouble());
+    }
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+QJsonObject environment() {
+    QJsonObject object;
+    object[QStringLiteral("time")] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    object[QStringLiteral("qt")] = QString::fromLatin1(qVersion());
+    object[QStringLiteral("curl")] = QString::fromLatin1(curl_version());
+    object[QStringLiteral("os")] = QSysInfo::prettyProductName();
+    object[QStringLiteral("cpu")] = QSysInfo::currentCpuArchitecture();
+    object[QStringLiteral("cores")] = static_cast<int>(std::thread::hardware_concurrency());
+    return object;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Entry Point
+// ═══════════════════════════════════════════════════════════════════════════════
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName(QStringLiteral("OpenIDM"));
+    app.setApplicationName(QStringLiteral("openidm_bench"));
+    app.setApplicationVersion(QStringLiteral("1.0.0"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("End-to-end download benchmark against a local shaping server"));
+    parser.addHelpOption();
+
+    const QCommandLineOption scenarioOption(QStringLiteral("scenario"),
+        QStringLiteral("Run only this scenario (repeatable)."), QStringLiteral("name"));
+    const QCommandLineOption listOption(QStringLiteral("list"), QStringLiteral("List scenarios and exit."));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+        QStringLiteral("Write JSON here instead of stdout."), QStringLiteral("file"));
+    const QCommandLineOption repeatOption(QStringLiteral("repeat"),
+        QStringLiteral("Passes per scenario (default 1)."), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption timeoutOption(QStringLiteral("timeout"),
+        QStringLiteral("Seconds per pass before giving up (default 300)."), QStringLiteral("s"), QStringLiteral("300"));
+    const QCommandLineOption samplesOption(QStringLiteral("verify-samples"),
+        QStringLiteral("Check this many spots per file (default 0 = every byte)."), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("Override file size in bytes."), QStringLiteral("bytes"));
+    const QCommandLineOption filesOption(QStringLiteral("files"), QStringLiteral("Override file count."), QStringLiteral("n"));
+    const QCommandLineOption bandwidthOption(QStringLiteral("bandwidth"),
+        QStringLiteral("Override aggregate cap in bytes/s."), QStringLiteral("bps"));
+    const QCommandLineOption perConnectionOption(QStringLiteral("per-connection"),
+        QStringLiteral("Override per-connection cap in bytes/s."), QStringLiteral("bps"));
+    const QCommandLineOption latencyOption(QStringLiteral("latency"), QStringLiteral("Override latency in ms."), QStringLiteral("ms"));
+    const QCommandLineOption errorRateOption(QStringLiteral("error-rate"), QStringLiteral("Override share of 503s."), QStringLiteral("0..1"));
+    const QCommandLineOption truncateRateOption(QStringLiteral("truncate-rate"),
+        QStringLiteral("Override share of truncated bodies."), QStringLiteral("0..1"));
+    const QCommandLineOption maxConnectionsOption(QStringLiteral("max-connections"),
+        QStringLiteral("Override connections the server accepts."), QStringLiteral("n"));
+    const QCommandLineOption segmentsOption(QStringLiteral("segments"), QStringLiteral("Override segments per download."), QStringLiteral("n"));
+    const QCommandLineOption concurrentOption(QStringLiteral("concurrent"),
+        QStringLiteral("Override concurrent downloads."), QStringLiteral("n"));
+    const QCommandLineOption baselineOption(QStringLiteral("baseline"),
+        QStringLiteral("Compare throughput with an earlier run."), QStringLiteral("file"));
+    const QCommandLineOption toleranceOption(QStringLiteral("tolerance"),
+        QStringLiteral("Allowed throughput drop vs. baseline (default 0.1)."), QStringLiteral("ratio"), QStringLiteral("0.1"));
+    parser.addOptions({scenarioOption, listOption, outputOption, repeatOption, timeoutOption, samplesOption,
+                       sizeOption, filesOption, bandwidthOption, perConnectionOption, latencyOption,
+                       errorRateOption, truncateRateOption, maxConnectionsOption, segmentsOption,
+                       concurrentOption, baselineOption, toleranceOption});
+    parser.process(app);
+
+    std::vector<Scenario> scenarios = builtinScenarios();
+    if (parser.isSet(listOption)) {
+        for (const Scenario& scenario : scenarios) {
+            qInfo().noquote() << scenario.name.leftJustified(24) << scenario.description;
+        }
+        return 0;
+    }
+
+    const QStringList selected = parser.values(scenarioOption);
+    if (!selected.isEmpty()) {
+        std::erase_if(scenarios, [&selected](const Scenario& scenario) {
+            return !selected.contains(scenario.name);
+        });
+        if (scenarios.empty()) {
+            qCritical() << "Unknown scenario:" << selected;
+            return 1;
+        }
+    }
+
+    // Overrides apply to every selected scenario
+    for (Scenario& scenario : scenarios) {
+        if (parser.isSet(sizeOption)) scenario.fileSize = parser.value(sizeOption).toLongLong();
+        if (parser.isSet(filesOption)) scenario.files = std::max(1, parser.value(filesOption).toInt());
+        if (parser.isSet(bandwidthOption)) scenario.profile.bandwidth = parser.value(bandwidthOption).toDouble();
+        if (parser.isSet(perConnectionOption)) scenario.profile.perConnection = parser.value(perConnectionOption).toDouble();
+        if (parser.isSet(latencyOption)) scenario.profile.latency = Duration(parser.value(latencyOption).toLongLong());
+        if (parser.isSet(errorRateOption)) scenario.profile.errorRate = parser.value(errorRateOption).toDouble();
+        if (parser.isSet(truncateRateOption)) scenario.profile.truncateRate = parser.value(truncateRateOption).toDouble();
+        if (parser.isSet(maxConnectionsOption)) scenario.profile.maxConnections = parser.value(maxConnectionsOption).toInt();
+        if (parser.isSet(segmentsOption)) scenario.segments = parser.value(segmentsOption).toInt();
+        if (parser.isSet(concurrentOption)) scenario.concurrent = parser.value(concurrentOption).toInt();
+    }
+
+    QJsonObject baseline;
+    if (parser.isSet(baselineOption)) {
+        QFile file(parser.value(baselineOption));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCritical() << "Cannot read baseline" << file.fileName();
+            return 1;
+        }
+        baseline = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("scenarios")).toObject();
+    }
+
+    // A private database, so neither the user's queue nor earlier runs leak in
+    QStandardPaths::setTestModeEnabled(true);
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QFile::remove(dataDir + QStringLiteral("/openidm.db"));
+    if (!DownloadManager::initialize(&app)) {
+        qCritical() << "Failed to initialize DownloadManager";
+        return 1;
+    }
+
+    const int repeat = std::max(1, parser.value(repeatOption).toInt());
+    const Duration timeout(std::max(1LL, parser.value(timeoutOption).toLongLong()) * 1000);
+    const int samples = std::max(0, parser.value(samplesOption).toInt());
+    const double tolerance = parser.value(toleranceOption).toDouble();
+
+    int exitCode = 0;
+    QJsonObject results;
+    {
+        BenchServer server;
+        for (const Scenario& scenario : scenarios) {
+            qInfo().noquote() << "Running" << scenario.name;
+            QJsonObject entry = describe(scenario);
+            QJsonArray passes;
+            for (int pass = 0; pass < repeat; ++pass) {
+                QJsonObject result = runScenario(server, scenario, pass, timeout, samples);
+                if (result.contains(QStringLiteral("error")) ||
+                    result.value(QStringLiteral("failures")).toInt() > 0 ||
+                    result.value(QStringLiteral("corrupt")).toInt() > 0) {
+                    exitCode = std::max(exitCode, 1);
+                }
+                passes.append(result);
+            }
+            entry[QStringLiteral("passes")] = passes;
+
+            double throughput = medianThroughput(passes);
+            entry[QStringLiteral("throughputMiBps")] = throughput;
+
+            QJsonObject reference = baseline.value(scenario.name).toObject();
+            if (reference.contains(QStringLiteral("throughputMiBps"))) {
+                double before = reference.value(QStringLiteral("throughputMiBps")).toDouble();
+                double change = before > 0 ? throughput / before - 1.0 : 0.0;
+                bool regressed = change < -tolerance;
+                entry[QStringLiteral("baselineMiBps")] = before;
+                entry[QStringLiteral("change")] = change;
+                entry[QStringLiteral("regressed")] = regressed;
+                if (regressed) {
+                    qWarning().noquote() << scenario.name << "regressed by" << QString::number(-change * 100, 'f', 1) + '%';
+                    exitCode = 2;
+                }
+            }
+            results[scenario.name] = entry;
+        }
+    }
+    DownloadManager::shutdown();
+
+    QJsonObject document;
+    document[QStringLiteral("environment")] = environment();
+    document[QStringLiteral("scenarios")] = results;
+    QByteArray json = QJsonDocument(document).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            qCritical() << "Cannot write" << file.fileName();
+            return 1;
+        }
+    } else {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(json);
+    }
+    return exitCode;
+}
@@ -0,0 +1,337 @@
+/**
+ * @file openidm_microbench.cpp
+ * @brief Microbenchmarks for the engine's per-byte and per-tick paths
+ *
+ * QBENCHMARK cases, one per hot primitive, data-driven over chunk size or
+ * worker count. Run with the usual QtTest switches, e.g.
+ *
+ *   openidm_microbench -tickcounter
+ *   openidm_microbench benchCrc32c -o crc.xml,xml
+ */
+
+#include <QtTest>
+
+#include "openidm/engine/Checksum.h"
+#include "openidm/engine/DiskWriter.h"
+#include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/OutputFile.h"
+#include "openidm/engine/Segment.h"
+#include "openidm/engine/SegmentScheduler.h"
+#include "openidm/engine/SpeedCalculator.h"
+#include "openidm/engine/Types.h"
+#include "openidm/persistence/PersistenceManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <latch>
+#include <thread>
+#include <vector>
+
+using namespace OpenIDM;
+
+class EngineBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void benchCrc32c_data();
+    void benchCrc32c();
+    void benchUpdateChecksum_data();
+    void benchUpdateChecksum();
+    void benchWritePath_data();
+    void benchWritePath();
+    void benchSplit();
+    void benchAcquireSteal_data();
+    void benchAcquireSteal();
+    void benchSpeedCalculator();
+    void benchPersistence_data();
+    void benchPersistence();
+
+private:
+    QTemporaryDir m_dir;
+    QByteArray m_data;
+};
+
+namespace {
+
+/// Largest chunk any case feeds in one call
+constexpr qsizetype MAX_CHUNK = 4 * 1024 * 1024;
+
+void addChunkSizes()
+{
+    QTest::addColumn<int>("chunk");
+
+    // 16 KiB is CURL_MAX_WRITE_SIZE, what a curl write callback usually sees
+    for (int chunk : {64, 1024, 16 * 1024, 256 * 1024, 4 * 1024 * 1024}) {
+        QTest::addRow("%d", chunk) << chunk;
+    }
+}
+
+} // namespace
+
+void EngineBench::initTestCase()
+{
+    QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+    QVERIFY(m_dir.isValid());
+
+    m_data.resize(MAX_CHUNK);
+    for (qsizetype i = 0; i < m_data.size(); ++i) {
+        m_data[i] = static_cast<char>((i * 2654435761u) >> 24);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Checksums
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void EngineBench::benchCrc32c_data()
+{
+    addChunkSizes();
+}
+
+void EngineBench::benchCrc32c()
+{
+    QFETCH(int, chunk);
+
+    uint32_t crc = 0;
+    QBENCHMARK {
+        crc = crc32c(m_data.constData(), static_cast<size_t>(chunk), crc);
+    }
+    QVERIFY(crc != 0 || chunk == 0);
+}
+
+void EngineBench::benchUpdateChecksum_data()
+{
+    addChunkSizes();
+}
+
+void EngineBench::benchUpdateChecksum()
+{
+    QFETCH(int, chunk);
+
+    // In-order data, as a single writer delivers it
+    Segment segment(0, 0, std::numeric_limits<ByteOffset>::max() / 2);
+    ByteOffset offset = 0;
+    QBENCHMARK {
+        segment.updateChecksum(offset, m_data.constData(), static_cast<size_t>(chunk));
+        offset += chunk;
+    }
+    QVERIFY(segment.checksumReaches(offset));
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Write Path
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void EngineBench::benchWritePath_data()
+{
+    QTest::addColumn<int>("chunk");
+
+    for (int chunk : {1024, 16 * 1024, 256 * 1024}) {
+        QTest::addRow("%d", chunk) << chunk;
+    }
+}
+
+/**
+ * SegmentWorker::writeCallback() without the transfer around it: claim,
+ * copy into a write-behind buffer, extend the CRC, and at the end wait for
+ * the writer thread. One iteration writes FILE_SIZE bytes.
+ */
+void EngineBench::benchWritePath()
+{
+    QFETCH(int, chunk);
+    constexpr ByteCount FILE_SIZE = 64LL * 1024 * 1024;
+
+    OutputFile output(m_dir.filePath(QStringLiteral("write-path-%1.bin").arg(chunk)));
+    QVERIFY(output.open());
+    QVERIFY(output.preallocate(FILE_SIZE));
+    DiskWriter& writer = DiskWriter::instance();
+
+    QBENCHMARK {
+        Segment segment(0, 0, FILE_SIZE - 1);
+        WriteBuffer* buffer = nullptr;
+
+        for (ByteOffset streamPos = 0; streamPos < FILE_SIZE; streamPos += chunk) {
+            ByteOffset writeFrom = streamPos;
+            segment.addPendingWrite(chunk);
+            ByteCount claimed = segment.claim(streamPos, chunk, &writeFrom);
+            segment.completePendingWrite(chunk - claimed);
+            const char* data = m_data.constData() + (writeFrom % (MAX_CHUNK / 2));
+
+            ByteOffset offset = writeFrom;
+            for (ByteCount left = claimed; left > 0;) {
+                if (!buffer) {
+                    buffer = writer.acquire(&output, &segment, offset);
+                }
+                size_t part = std::min(static_cast<size_t>(left), buffer->capacity - buffer->length);
+                std::memcpy(buffer->data + buffer->length, data + (offset - writeFrom), part);
+                buffer->length += part;
+                if (buffer->isFull()) {
+                    writer.submit(std::exchange(buffer, nullptr));
+                }
+                offset += static_cast<ByteOffset>(part);
+                left -= static_cast<ByteCount>(part);
+            }
+            segment.updateChecksum(writeFrom, data, static_cast<size_t>(claimed));
+        }
+        if (buffer) {
+            writer.submit(buffer);
+        }
+        writer.drain(&output);
+    }
+    QVERIFY(!output.hasFailed());
+    output.discard();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Scheduling
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void EngineBench::benchSplit()
+{
+    QBENCHMARK {
+        // Halve one 1 GiB segment until it is too small, as repeated steals do
+        Segment segment(0, 0, 1024LL * 1024 * 1024 - 1);
+        SegmentId id = 1;
+        while (auto piece = segment.split(id++)) {
+            QVERIFY(piece->startByte() == segment.endByte() + 1);
+        }
+    }
+}
+
+void EngineBench::benchAcquireSteal_data()
+{
+    QTest::addColumn<int>("workers");
+
+    for (int workers : {32, 64, 128, 256}) {
+        QTest::addRow("%d", workers) << workers;
+    }
+}
+
+/**
+ * Workers drain a 4 GiB download of 8 initial segments in 256 KiB claims;
+ * everyone beyond the first eight has to steal, and the end game hedges.
+ * Reported per acquireSegment() call, from the moment all threads start.
+ */
+void EngineBench::benchAcquireSteal()
+{
+    QFETCH(int, workers);
+    constexpr ByteCount FILE_SIZE = 4LL * 1024 * 1024 * 1024;
+    constexpr ByteCount CLAIM = 256 * 1024;
+    constexpr int ROUNDS = 5;
+
+    // The scheduler only reads the task's sources; the workers are never
+    // dereferenced by acquire/steal/release, so placeholders stand in
+    DownloadTask task(QUrl(QStringLiteral("http://127.0.0.1/bench.bin")), m_dir.path());
+    std::vector<char> placeholders(static_cast<size_t>(workers));
+
+    std::chrono::nanoseconds elapsed{0};
+    std::atomic<qint64> acquires{0};
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        SegmentScheduler scheduler(&task);
+        scheduler.setAutoRebalance(false);
+        scheduler.initializeSegments(FILE_SIZE, 8);
+
+        std::latch start(workers + 1);
+        std::vector<std::thread> threads;
+        threads.reserve(static_cast<size_t>(workers));
+        for (int i = 0; i < workers; ++i) {
+            auto* worker = reinterpret_cast<SegmentWorker*>(&placeholders[static_cast<size_t>(i)]);
+            threads.emplace_back([&scheduler, &start, &acquires, worker]() {
+                start.arrive_and_wait();
+                while (Segment* segment = scheduler.acquireSegment(worker)) {
+                    acquires.fetch_add(1, std::memory_order_relaxed);
+                    while (segment->remainingBytes() > 0) {
+                        ByteOffset claimStart = 0;
+                        segment->claim(segment->currentByte(), CLAIM, &claimStart);
+                    }
+                    segment->setState(SegmentState::Completed);
+                    scheduler.releaseSegment(worker, segment);
+                }
+            });
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        start.arrive_and_wait();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        elapsed += std::chrono::steady_clock::now() - begin;
+        QVERIFY(scheduler.isAllComplete());
+    }
+
+    QTest::setBenchmarkResult(static_cast<qreal>(elapsed.count()) / static_cast<qreal>(std::max<qint64>(1, acquires)),
+                              QTest::WalltimeNanoseconds);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Statistics & Persistence
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void EngineBench::benchSpeedCalculator()
+{
+    // One call per curl write callback; the clock advances 1 ms per call
+    SpeedCalculator calculator;
+    Timestamp now = std::chrono::system_clock::now();
+    QBENCHMARK {
+        calculator.addBytes(16 * 1024, now);
+        now += std::chrono::milliseconds(1);
+    }
+    QVERIFY(calculator.currentSpeed() > 0);
+}
+
+void EngineBench::benchPersistence_data()
+{
+    QTest::addColumn<int>("segments");
+
+    for (int segments : {8, 32, 128}) {
+        QTest::addRow("%d", segments) << segments;
+    }
+}
+
+/**
+ * 200 progress snapshots of one task's segments, committed by the writer
+ * thread. Reported per segment row, including the final commit in close().
+ */
+void EngineBench::benchPersistence()
+{
+    QFETCH(int, segments);
+    constexpr int SNAPSHOTS = 200;
+
+    std::vector<std::unique_ptr<Segment>> owned;
+    std::vector<Segment*> rows;
+    ByteCount size = 1024LL * 1024 * segments;
+    for (int i = 0; i < segments; ++i) {
+        owned.push_back(std::make_unique<Segment>(static_cast<SegmentId>(i), size / segments * i,
+                                                  size / segments * (i + 1) - 1));
+        rows.push_back(owned.back().get());
+    }
+    // Segment rows reference their task
+    DownloadTask task(QUrl(QStringLiteral("http://127.0.0.1/bench.bin")), m_dir.path());
+    TaskId id = task.id();
+
+    PersistenceManager persistence;
+    QVERIFY(persistence.initialize(m_dir.filePath(QStringLiteral("persist-%1.db").arg(segments))));
+    persistence.saveTask(&task);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int snapshot = 0; snapshot < SNAPSHOTS; ++snapshot) {
+        for (Segment* segment : rows) {
+            segment->setCurrentByte(segment->startByte() + (segment->totalSize() * snapshot) / SNAPSHOTS);
+        }
+        persistence.saveSegments(id, rows);
+    }
+    persistence.close();
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    QTest::setBenchmarkResult(static_cast<qreal>(std::chrono::nanoseconds(elapsed).count()) /
+                                  static_cast<qreal>(SNAPSHOTS * segments),
+                              QTest::WalltimeNanoseconds);
+}
+
+QTEST_GUILESS_MAIN(EngineBench)
+#include "openidm_microbench.moc"
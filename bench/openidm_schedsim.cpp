@@ -0,0 +1,319 @@
+/**
+ * @file openidm_schedsim.cpp
+ * @brief Scheduler policy comparison on a simulated network
+ *
+ * Runs SegmentScheduler through SchedulerSimulator many times per
+ * scenario and policy, and prints one JSON document: completion-time
+ * percentiles in virtual milliseconds, redundant bytes from hedging and
+ * mean steals, hedges and rebalance splits. Runs are seeded, so two
+ * builds given the same arguments can be compared directly; with
+ * --baseline a p90 increase beyond --tolerance fails the run.
+ *
+ *   openidm_schedsim --list
+ *   openidm_schedsim --scenario straggler --runs 2000 --segments 4,8,16
+ *   openidm_schedsim --no-rebalance --output steal-only.json
+ *   openidm_schedsim --baseline main.json --tolerance 0.05
+ */
+
+#include "SchedulerSim.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <vector>
+
+using namespace OpenIDM;
+using namespace OpenIDM::Bench;
+
+namespace {
+
+constexpr double MIB = 1024.0 * 1024.0;
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Scenarios
+// ═══════════════════════════════════════════════════════════════════════════════
+
+struct Scenario {
+    QString name;
+    QString description;
+    ByteCount fileSize = 0;
+    NetworkModel network;
+};
+
+std::vector<Scenario> builtinScenarios() {
+    std::vector<Scenario> scenarios;
+
+    Scenario uniform;
+    uniform.name = QStringLiteral("uniform");
+    uniform.description = QStringLiteral("256 MiB, 4 MiB/s per connection with mild variation");
+    uniform.fileSize = 256LL * 1024 * 1024;
+    scenarios.push_back(uniform);
+
+    Scenario straggler;
+    straggler.name = QStringLiteral("straggler");
+    straggler.description = QStringLiteral("256 MiB, one connection in five on a path 10x slower");
+    straggler.fileSize = 256LL * 1024 * 1024;
+    straggler.network.slowShare = 0.2;
+    scenarios.push_back(straggler);
+
+    Scenario wide;
+    wide.name = QStringLiteral("wide-spread");
+    wide.description = QStringLiteral("128 MiB, per-attempt rates spread over an order of magnitude");
+    wide.fileSize = 128LL * 1024 * 1024;
+    wide.network.spread = 1.0;
+    scenarios.push_back(wide);
+
+    Scenario throttled;
+    throttled.name = QStringLiteral("throttled");
+    throttled.description = QStringLiteral("256 MiB, server capped at 16 MiB/s in total");
+    throttled.fileSize = 256LL * 1024 * 1024;
+    throttled.network.serverBandwidth = 16 * MIB;
+    scenarios.push_back(throttled);
+
+    Scenario stalls;
+    stalls.name = QStringLiteral("stalls");
+    stalls.description = QStringLiteral("128 MiB, a 2 s stall every 20 connection-seconds");
+    stalls.fileSize = 128LL * 1024 * 1024;
+    stalls.network.stallRate = 0.05;
+    scenarios.push_back(stalls);
+
+    Scenario flaky;
+    flaky.name = QStringLiteral("flaky");
+    flaky.description = QStringLiteral("64 MiB, a connection reset every 50 connection-seconds, 200 ms latency");
+    flaky.fileSize = 64LL * 1024 * 1024;
+    flaky.network.failureRate = 0.02;
+    flaky.network.latency = Duration(200);
+    scenarios.push_back(flaky);
+
+    return scenarios;
+}
+
+QJsonObject describe(const Scenario& scenario) {
+    const NetworkModel& network = scenario.network;
+    QJsonObject model;
+    model[QStringLiteral("bandwidth")] = network.bandwidth;
+    model[QStringLiteral("spread")] = network.spread;
+    model[QStringLiteral("slowShare")] = network.slowShare;
+    model[QStringLiteral("slowFactor")] = network.slowFactor;
+    model[QStringLiteral("serverBandwidth")] = network.serverBandwidth;
+    model[QStringLiteral("latencyMs")] = static_cast<qint64>(network.latency.count());
+    model[QStringLiteral("stallRate")] = network.stallRate;
+    model[QStringLiteral("stallLengthMs")] = static_cast<qint64>(network.stallLength.count());
+    model[QStringLiteral("failureRate")] = network.failureRate;
+
+    QJsonObject object;
+    object[QStringLiteral("description")] = scenario.description;
+    object[QStringLiteral("fileSize")] = scenario.fileSize;
+    object[QStringLiteral("network")] = model;
+    return object;
+}
+
+QJsonObject toJson(const SimulationSummary& summary) {
+    QJsonObject completion;
+    completion[QStringLiteral("p50")] = summary.p50;
+    completion[QStringLiteral("p90")] = summary.p90;
+    completion[QStringLiteral("p99")] = summary.p99;
+    completion[QStringLiteral("max")] = summary.max;
+
+    QJsonObject object;
+    object[QStringLiteral("runs")] = static_cast<qint64>(summary.runs);
+    object[QStringLiteral("completed")] = static_cast<qint64>(summary.completed);
+    object[QStringLiteral("completionMs")] = completion;
+    object[QStringLiteral("overhead")] = summary.overhead;
+    object[QStringLiteral("steals")] = summary.steals;
+    object[QStringLiteral("hedges")] = summary.hedges;
+    object[QStringLiteral("splits")] = summary.splits;
+    return object;
+}
+
+/// Compile-time scheduler constants, so documents from different builds say what differed
+QJsonObject constants() {
+    QJsonObject object;
+    object[QStringLiteral("minStealSize")] = Constants::MIN_STEAL_SIZE;
+    object[QStringLiteral("hedgeThreshold")] = Constants::HEDGE_THRESHOLD;
+    object[QStringLiteral("hedgeMinEtaMs")] = static_cast<qint64>(Constants::HEDGE_MIN_ETA.count());
+    object[QStringLiteral("throughputTimeConstantMs")] =
+        static_cast<qint64>(Constants::THROUGHPUT_TIME_CONSTANT.count());
+    object[QStringLiteral("maxRetries")] = static_cast<qint64>(Constants::MAX_RETRIES);
+    object[QStringLiteral("tickMs")] = static_cast<qint64>(SchedulerSimulator::TICK.count());
+    return object;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Entry Point
+// ═══════════════════════════════════════════════════════════════════════════════
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName(QStringLiteral("OpenIDM"));
+    app.setApplicationName(QStringLiteral("openidm_schedsim"));
+    app.setApplicationVersion(QStringLiteral("1.0.0"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Segment scheduler simulation on a virtual clock"));
+    parser.addHelpOption();
+
+    const QCommandLineOption scenarioOption(QStringLiteral("scenario"),
+        QStringLiteral("Run only this scenario (repeatable)."), QStringLiteral("name"));
+    const QCommandLineOption listOption(QStringLiteral("list"), QStringLiteral("List scenarios and exit."));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+        QStringLiteral("Write JSON here instead of stdout."), QStringLiteral("file"));
+    const QCommandLineOption runsOption(QStringLiteral("runs"),
+        QStringLiteral("Runs per scenario and policy (default 500)."), QStringLiteral("n"), QStringLiteral("500"));
+    const QCommandLineOption seedOption(QStringLiteral("seed"),
+        QStringLiteral("Seed of the first run (default 1)."), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption segmentsOption(QStringLiteral("segments"),
+        QStringLiteral("Comma-separated segment counts to compare (default 8)."), QStringLiteral("list"),
+        QString::number(Constants::DEFAULT_SEGMENTS));
+    const QCommandLineOption noRebalanceOption(QStringLiteral("no-rebalance"),
+        QStringLiteral("Rely on work stealing and hedging alone."));
+    const QCommandLineOption rebalanceIntervalOption(QStringLiteral("rebalance-interval"),
+        QStringLiteral("Rebalance period in ms (default REBALANCE_INTERVAL)."), QStringLiteral("ms"));
+    const QCommandLineOption sizeOption(QStringLiteral("size"), QStringLiteral("Override file size in bytes."), QStringLiteral("bytes"));
+    const QCommandLineOption bandwidthOption(QStringLiteral("bandwidth"),
+        QStringLiteral("Override median per-connection rate in bytes/s."), QStringLiteral("bps"));
+    const QCommandLineOption serverBandwidthOption(QStringLiteral("server-bandwidth"),
+        QStringLiteral("Override aggregate cap in bytes/s."), QStringLiteral("bps"));
+    const QCommandLineOption failureRateOption(QStringLiteral("failure-rate"),
+        QStringLiteral("Override resets per connection-second."), QStringLiteral("rate"));
+    const QCommandLineOption baselineOption(QStringLiteral("baseline"),
+        QStringLiteral("Compare p90 completion with an earlier run."), QStringLiteral("file"));
+    const QCommandLineOption toleranceOption(QStringLiteral("tolerance"),
+        QStringLiteral("Allowed p90 increase vs. baseline (default 0.05)."), QStringLiteral("ratio"), QStringLiteral("0.05"));
+    parser.addOptions({scenarioOption, listOption, outputOption, runsOption, seedOption, segmentsOption,
+                       noRebalanceOption, rebalanceIntervalOption, sizeOption, bandwidthOption,
+                       serverBandwidthOption, failureRateOption, baselineOption, toleranceOption});
+    parser.process(app);
+
+    std::vector<Scenario> scenarios = builtinScenarios();
+    if (parser.isSet(listOption)) {
+        for (const Scenario& scenario : scenarios) {
+            qInfo().noquote() << scenario.name.leftJustified(16) << scenario.description;
+        }
+        return 0;
+    }
+
+    const QStringList selected = parser.values(scenarioOption);
+    if (!selected.isEmpty()) {
+        std::erase_if(scenarios, [&selected](const Scenario& scenario) {
+            return !selected.contains(scenario.name);
+        });
+        if (scenarios.empty()) {
+            qCritical() << "Unknown scenario:" << selected;
+            return 1;
+        }
+    }
+
+    for (Scenario& scenario : scenarios) {
+        if (parser.isSet(sizeOption)) scenario.fileSize = parser.value(sizeOption).toLongLong();
+        if (parser.isSet(bandwidthOption)) scenario.network.bandwidth = parser.value(bandwidthOption).toDouble();
+        if (parser.isSet(serverBandwidthOption)) scenario.network.serverBandwidth = parser.value(serverBandwidthOption).toDouble();
+        if (parser.isSet(failureRateOption)) scenario.network.failureRate = parser.value(failureRateOption).toDouble();
+    }
+
+    std::vector<SchedulerPolicy> policies;
+    for (const QString& count : parser.value(segmentsOption).split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        SchedulerPolicy policy;
+        policy.segments = std::max(1, count.trimmed().toInt());
+        policy.rebalance = !parser.isSet(noRebalanceOption);
+        if (parser.isSet(rebalanceIntervalOption)) {
+            policy.rebalanceInterval = Duration(std::max(1LL, parser.value(rebalanceIntervalOption).toLongLong()));
+        }
+        policies.push_back(policy);
+    }
+    if (policies.empty()) {
+        qCritical() << "No segment counts given";
+        return 1;
+    }
+
+    QJsonObject baseline;
+    if (parser.isSet(baselineOption)) {
+        QFile file(parser.value(baselineOption));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCritical() << "Cannot read baseline" << file.fileName();
+            return 1;
+        }
+        baseline = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("scenarios")).toObject();
+    }
+
+    // The scheduler narrates every split; thousands of runs would drown in it
+    QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+
+    const size_t runs = static_cast<size_t>(std::max(1, parser.value(runsOption).toInt()));
+    const quint64 seed = parser.value(seedOption).toULongLong();
+    const double tolerance = parser.value(toleranceOption).toDouble();
+
+    int exitCode = 0;
+    QJsonObject results;
+    for (const Scenario& scenario : scenarios) {
+        qInfo().noquote() << "Simulating" << scenario.name;
+        QJsonObject entry = describe(scenario);
+        QJsonObject reference = baseline.value(scenario.name).toObject().value(QStringLiteral("policies")).toObject();
+
+        QJsonObject byPolicy;
+        for (const SchedulerPolicy& policy : policies) {
+            QString key = QStringLiteral("%1-segments%2")
+                              .arg(policy.segments)
+                              .arg(policy.rebalance ? QString() : QStringLiteral("-no-rebalance"));
+
+            QElapsedTimer wall;
+            wall.start();
+            SchedulerSimulator simulator(scenario.fileSize, scenario.network, policy);
+            SimulationSummary summary = SimulationSummary::of(simulator.runMany(runs, seed), scenario.fileSize);
+
+            QJsonObject result = toJson(summary);
+            result[QStringLiteral("wallMs")] = static_cast<qint64>(wall.elapsed());
+            if (summary.completed < summary.runs) {
+                exitCode = std::max(exitCode, 1);
+            }
+
+            QJsonObject before = reference.value(key).toObject().value(QStringLiteral("completionMs")).toObject();
+            if (before.contains(QStringLiteral("p90"))) {
+                double p90 = before.value(QStringLiteral("p90")).toDouble();
+                double change = p90 > 0 ? summary.p90 / p90 - 1.0 : 0.0;
+                bool regressed = change > tolerance;
+                result[QStringLiteral("baselineP90Ms")] = p90;
+                result[QStringLiteral("change")] = change;
+                result[QStringLiteral("regressed")] = regressed;
+                if (regressed) {
+                    qWarning().noquote() << scenario.name << key << "p90 up by"
+                                         << QString::number(change * 100, 'f', 1) + '%';
+                    exitCode = 2;
+                }
+            }
+            byPolicy[key] = result;
+        }
+        entry[QStringLiteral("policies")] = byPolicy;
+        results[scenario.name] = entry;
+    }
+
+    QJsonObject document;
+    document[QStringLiteral("constants")] = constants();
+    document[QStringLiteral("runs")] = static_cast<qint64>(runs);
+    document[QStringLiteral("seed")] = QString::number(seed);
+    document[QStringLiteral("scenarios")] = results;
+    QByteArray json = QJsonDocument(document).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            qCritical() << "Cannot write" << file.fileName();
+            return 1;
+        }
+    } else {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(json);
+    }
+    return exitCode;
+}
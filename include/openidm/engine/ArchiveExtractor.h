@@ -0,0 +1,121 @@
+/**
+ * @file ArchiveExtractor.h
+ * @brief Unpack a tar archive while it is still downloading
+ *
+ * Extracting a multi-gigabyte `.tar.zst` after the download finished
+ * costs minutes on top of it. The extractor instead follows the
+ * contiguous prefix of the partial file (the scheduler runs in sequential
+ * mode so that prefix grows steadily), decompresses it on a thread of its
+ * own and writes the entries into the target directory as their bytes
+ * arrive; the last entry is out seconds after the last byte.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <QObject>
+#include <QString>
+
+namespace OpenIDM {
+
+/**
+ * @class ArchiveExtractor
+ * @brief Streaming tar (+ gzip / zstd) extraction from a growing file
+ *
+ * The owner reports how far the file is readable with advance(); the
+ * extractor never reads past that point. Entry names that are absolute or
+ * climb out with ".." are skipped, and nothing is written through a
+ * symbolic link, so an archive cannot touch files outside the target.
+ *
+ * Thread Safety:
+ * - Call the public methods from the owning (GUI) thread
+ * - Signals are emitted on the owning thread
+ */
+class ArchiveExtractor : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Format : uint8_t {
+        Unknown,
+        Tar,
+        TarGzip,                        ///< .tar.gz / .tgz (needs zlib)
+        TarZstd                         ///< .tar.zst / .tzst (needs libzstd)
+    };
+
+    explicit ArchiveExtractor(QObject* parent = nullptr);
+    ~ArchiveExtractor() override;
+
+    // Disable copying
+    ArchiveExtractor(const ArchiveExtractor&) = delete;
+    ArchiveExtractor& operator=(const ArchiveExtractor&) = delete;
+
+    /// @return Archive format implied by @p fileName's extension
+    static Format formatFor(const QString& fileName);
+
+    /// @return True if this build can decompress @p format
+    static bool supports(Format format);
+
+    /**
+     * @brief Create @p targetDir and start the extraction thread
+     * @return False if already running, @p format is not supported or the
+     *         directory cannot be created
+     */
+    bool start(Format format, const QString& targetDir);
+
+    /**
+     * @brief Make more of the archive available
+     * @param sourcePath File holding the archive; empty to close it (e.g.
+     *                   before it is renamed). Returns once it is closed.
+     * @param available Bytes [0, available) are on disk
+     * @param complete No more bytes will follow
+     */
+    void advance(const QString& sourcePath, ByteOffset available, bool complete);
+
+    /// Stop and join the thread; files extracted so far stay
+    void cancel();
+
+    /// @return True between start() and finished()/failed()/cancel()
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    /// @return Archive bytes consumed so far
+    ByteOffset consumed() const { return m_consumed.load(std::memory_order_relaxed); }
+
+signals:
+    /// Emitted once the end of the archive was reached
+    void finished(const QString& targetDir, int entries);
+
+    /// Emitted when the archive is corrupt or an entry cannot be written
+    void failed(const QString& error);
+
+private:
+    void run();
+
+    // Extraction thread
+    void fail(const QString& error);
+
+    std::thread m_thread;
+    Format m_format{Format::Unknown};
+    QString m_targetDir;
+
+    // Shared with the thread (m_mutex)
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    QString m_sourcePath;
+    ByteOffset m_available{0};
+    bool m_complete{false};
+    bool m_stopping{false};
+
+    // Held while the thread has the source open
+    std::mutex m_fileMutex;
+
+    std::atomic<ByteOffset> m_consumed{0};
+    std::atomic<bool> m_running{false};
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,180 @@
+/**
+ * @file BandwidthLimiter.h
+ * @brief Hierarchical token-bucket bandwidth limiting (global → task → segment)
+ *
+ * Every received block is charged to the worker's bucket, its task's bucket
+ * and the global bucket. A bucket without a rate is transparent, so bandwidth
+ * an idle segment or task does not use is automatically available to the
+ * active ones: the global cap is hit exactly whether one or fifty transfers
+ * are running.
+ *
+ * Under a global limit the task buckets get rates of their own, recomputed
+ * every speed sample: a weighted max-min fair split of the limit by task
+ * priority, with Urgent tasks served first (see BandwidthLimiter::share()).
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <QDateTime>
+#include <QTime>
+
+namespace OpenIDM {
+
+/**
+ * @class TokenBucket
+ * @brief Lock-free token bucket with an optional parent
+ *
+ * Tokens are bytes. consume() always succeeds and may drive the bucket into
+ * debt; callers then wait delay() before receiving more. This keeps the hot
+ * path (curl write callback) to a few atomic operations with no locks.
+ *
+ * Thread Safety:
+ * - All methods are safe to call concurrently from any thread
+ */
+class TokenBucket {
+public:
+    /**
+     * @brief Construct a bucket
+     * @param parent Enclosing bucket that is charged as well (not owned)
+     */
+    explicit TokenBucket(TokenBucket* parent = nullptr);
+
+    // Disable copying (children hold raw pointers)
+    TokenBucket(const TokenBucket&) = delete;
+    TokenBucket& operator=(const TokenBucket&) = delete;
+
+    /**
+     * @brief Set the sustained rate
+     * @param bytesPerSecond Limit (0 = unlimited)
+     */
+    void setRate(SpeedBps bytesPerSecond);
+
+    /**
+     * @brief Change the rate without resetting the bucket
+     *
+     * Debt and credit carry over and only the burst shrinks with the rate,
+     * so a rate recomputed every second neither stalls nor bursts.
+     */
+    void adjustRate(SpeedBps bytesPerSecond);
+
+    /// @return Configured rate (0 = unlimited)
+    SpeedBps rate() const { return static_cast<SpeedBps>(m_rate.load(std::memory_order_relaxed)); }
+
+    /// @return True if this bucket or any ancestor has a rate
+    bool isLimited() const;
+
+    /**
+     * @brief Charge received bytes to this bucket and all ancestors
+     * @param bytes Number of bytes received
+     */
+    void consume(ByteCount bytes);
+
+    /**
+     * @brief Time to wait before the chain has tokens again
+     * @return Zero if no bucket in the chain is in debt
+     */
+    Duration delay();
+
+private:
+    void refill();
+    Duration ownDelay();
+
+    TokenBucket* m_parent;
+
+    std::atomic<int64_t> m_rate{0};           ///< Bytes per second
+    std::atomic<int64_t> m_tokens{0};         ///< May go negative (debt)
+    std::atomic<int64_t> m_lastRefillNs{0};   ///< steady_clock nanoseconds
+};
+
+/**
+ * @class BandwidthLimiter
+ * @brief Process-wide root of the bucket hierarchy with time-of-day schedules
+ *
+ * The effective global limit is the first matching schedule rule, or the
+ * base limit set with setGlobalLimit() when no rule matches.
+ */
+class BandwidthLimiter {
+public:
+    /**
+     * @brief A time-of-day speed limit
+     *
+     * Rules whose end is before their start wrap past midnight
+     * (e.g. 22:00–06:00).
+     */
+    struct ScheduleRule {
+        uint8_t dayMask = 0x7F;     ///< Bit 0 = Monday ... bit 6 = Sunday
+        QTime start;                ///< Inclusive
+        QTime end;                  ///< Exclusive
+        SpeedBps limit = 0;         ///< 0 = unlimited during this window
+
+        bool matches(const QDateTime& when) const;
+    };
+
+    /**
+     * @brief One task's claim on the global limit
+     */
+    struct ShareClaim {
+        TokenBucket* bucket = nullptr;  ///< Task bucket; its rate is set by share()
+        unsigned weight = 1;            ///< priorityWeight()
+        bool foreground = false;        ///< Served before every weighted claim
+        SpeedBps cap = 0;               ///< The task's own limit (0 = none)
+        SpeedBps speed = 0;             ///< Measured over the last sample
+    };
+
+    /// @return The process-wide limiter
+    static BandwidthLimiter& instance();
+
+    /// @return Root bucket that every task bucket hangs off
+    TokenBucket& global() { return m_global; }
+
+    /**
+     * @brief Set the limit used outside any schedule window
+     * @param limit Bytes per second (0 = unlimited)
+     */
+    void setGlobalLimit(SpeedBps limit);
+
+    /// @return Limit used outside any schedule window
+    SpeedBps globalLimit() const;
+
+    /**
+     * @brief Replace the time-of-day schedule
+     */
+    void setSchedule(std::vector<ScheduleRule> rules);
+
+    /**
+     * @brief Re-evaluate the schedule and update the global bucket
+     * @param now Current local time
+     */
+    void applySchedule(const QDateTime& now = QDateTime::currentDateTime());
+
+    /// @return Currently applied global limit
+    SpeedBps effectiveLimit() const { return m_global.rate(); }
+
+    /**
+     * @brief Split the global limit between running tasks
+     *
+     * Foreground claims are filled first, then the rest of the limit goes
+     * to the others in proportion to weight. A claim only gets what it can
+     * use: one that did not reach FAIR_SHARE_SATURATED of its last rate is
+     * held to FAIR_SHARE_HEADROOM times its speed, and its unused share is
+     * passed on. Without a global limit each bucket gets its task's cap.
+     */
+    void share(const std::vector<ShareClaim>& claims);
+
+private:
+    BandwidthLimiter() = default;
+
+    TokenBucket m_global;
+
+    mutable std::mutex m_scheduleMutex;
+    std::vector<ScheduleRule> m_schedule;
+    SpeedBps m_baseLimit{0};
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,145 @@
+/**
+ * @file Checksum.h
+ * @brief Hardware-accelerated CRC32C and SHA-256, expected-hash handling
+ *
+ * Segments keep a CRC32C of the bytes they received in order; because CRCs
+ * can be combined, the whole-file CRC is known the moment the last segment
+ * completes. Cryptographic digests cannot be combined and are computed by a
+ * read-ahead pass over the finished file.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <array>
+#include <atomic>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// CRC32C (Castagnoli)
+// ═══════════════════════════════════════════════════════════════════════════════
+
+/**
+ * @brief Update a CRC32C
+ *
+ * Uses the SSE4.2 / ARMv8 CRC32C instructions when the CPU has them and a
+ * slicing-by-8 table otherwise.
+ *
+ * @param data Input data
+ * @param size Data size
+ * @param previousCrc CRC of the preceding bytes (0 to start)
+ * @return Updated CRC32C value
+ */
+uint32_t crc32c(const char* data, size_t size, uint32_t previousCrc = 0);
+
+/**
+ * @brief CRC32C of A followed by B, from the CRCs of A and B
+ * @param crcA CRC32C of the first range
+ * @param crcB CRC32C of the second range
+ * @param lengthB Length of the second range in bytes
+ */
+uint32_t crc32cCombine(uint32_t crcA, uint32_t crcB, ByteCount lengthB);
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// SHA-256
+// ═══════════════════════════════════════════════════════════════════════════════
+
+/**
+ * @class Sha256
+ * @brief Incremental SHA-256 using the SHA-NI extensions when available
+ */
+class Sha256 {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+
+    Sha256() { reset(); }
+
+    /// @brief Start a new digest
+    void reset();
+
+    /// @brief Feed more data
+    void addData(const char* data, size_t size);
+
+    /// @return Digest of everything fed so far (the object must be reset afterwards)
+    QByteArray result();
+
+    /// @return True if this CPU runs the SHA-NI path
+    static bool isAccelerated();
+
+private:
+    void compress(const uint8_t* blocks, size_t count);
+
+    std::array<uint32_t, 8> m_state{};
+    std::array<uint8_t, 64> m_buffer{};
+    size_t m_bufferLength{0};
+    uint64_t m_totalLength{0};
+};
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Expected Hashes
+// ═══════════════════════════════════════════════════════════════════════════════
+
+/**
+ * @brief Digest algorithms accepted for verification
+ */
+enum class HashAlgorithm : uint8_t {
+    None,
+    Crc32c,
+    Md5,
+    Sha1,
+    Sha256,
+    Sha512
+};
+
+/**
+ * @brief Digest a completed file is checked against
+ */
+struct ExpectedHash {
+    HashAlgorithm algorithm = HashAlgorithm::None;
+    QByteArray digest;                  ///< Raw digest bytes (CRC32C big-endian)
+
+    bool isValid() const { return algorithm != HashAlgorithm::None && !digest.isEmpty(); }
+
+    /// @return "<algorithm>:<hex>", the form accepted by fromString()
+    QString toString() const;
+
+    /**
+     * @brief Parse "sha256:<hex>", "sha-256=<hex>" or a bare hex digest
+     *
+     * Bare digests are identified by length (8 = CRC32C, 32 = MD5,
+     * 40 = SHA-1, 64 = SHA-256, 128 = SHA-512 hex characters).
+     * @return Invalid hash if the text is not understood
+     */
+    static ExpectedHash fromString(const QString& text);
+
+    /**
+     * @brief Parse a checksum sidecar (`sha256sum` output, `.sha256` files)
+     * @param content Sidecar file content
+     * @param fileName Entry to pick when the sidecar lists several files
+     * @param algorithm Algorithm implied by the sidecar's extension
+     */
+    static ExpectedHash fromSidecar(const QByteArray& content, const QString& fileName,
+                                    HashAlgorithm algorithm = HashAlgorithm::Sha256);
+};
+
+/// @return Lower-case algorithm name ("sha256", "crc32c", ...)
+QString hashAlgorithmName(HashAlgorithm algorithm);
+
+/**
+ * @brief Digest a whole file with read-ahead (see FileIo::readSequential())
+ *
+ * CRC32C is computed over Constants::VERIFY_CHUNK pieces on the global
+ * thread pool and combined; the other digests are a single sequential pass.
+ *
+ * @param progress If set, advanced by the bytes hashed so far
+ * @return Raw digest, empty if the file could not be read
+ */
+QByteArray hashFile(const QString& path, HashAlgorithm algorithm,
+                    std::atomic<ByteCount>* progress = nullptr);
+
+} // namespace OpenIDM
@@ -0,0 +1,78 @@
+/**
+ * @file ConnectionTuner.h
+ * @brief Throughput feedback controller for a task's connection count
+ *
+ * calculateOptimalSegmentCount() decides how many pieces a file is cut
+ * into; ConnectionTuner decides how many of them are fetched at once. It
+ * starts small, adds connections while each one still buys a meaningful
+ * share of throughput, backs off when it does not, and remembers the
+ * result per host for the next download.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <QString>
+
+namespace OpenIDM {
+
+/**
+ * @class ConnectionTuner
+ * @brief Hill-climbing controller over the number of parallel connections
+ *
+ * Each sample is the task's aggregate throughput measured over one
+ * Constants::CONNECTION_TUNE_INTERVAL at the current count. After a change
+ * the next sample is discarded so new connections can leave TCP slow start.
+ *
+ * Thread Safety:
+ * - Instances are used from the owning task's thread only
+ * - The per-host optimum lives in HostCache, which is thread-safe
+ */
+class ConnectionTuner {
+public:
+    /**
+     * @brief Construct a tuner
+     * @param host Host whose learned optimum seeds and receives the result
+     * @param maxConnections Upper bound (segments, pool size, MAX_SEGMENTS)
+     */
+    ConnectionTuner(const QString& host, size_t maxConnections);
+
+    /// @return Connection count to start with
+    size_t currentCount() const { return m_count; }
+
+    /// @return True once the controller stopped exploring
+    bool isSettled() const { return m_settled; }
+
+    /**
+     * @brief Feed one throughput sample for currentCount()
+     * @param throughput Aggregate bytes/second over the last interval
+     * @return Desired connection count (may be unchanged)
+     */
+    size_t update(SpeedBps throughput);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Per-host Memory
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @return Learned optimum for a host (0 if unknown)
+    static size_t learnedOptimum(const QString& host);
+
+    /// @brief Record the optimum a tuner settled on
+    static void rememberOptimum(const QString& host, size_t count);
+
+private:
+    size_t grow();
+    size_t settle(size_t count);
+
+    QString m_host;
+    size_t m_max;
+    size_t m_count;
+
+    size_t m_baselineCount{0};          ///< Last count that paid off
+    SpeedBps m_baselineThroughput{0.0};
+    bool m_warmingUp{true};
+    bool m_settled{false};
+};
+
+} // namespace OpenIDM
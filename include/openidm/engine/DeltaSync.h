@@ -0,0 +1,96 @@
+/**
+ * @file DeltaSync.h
+ * @brief Reuse the unchanged blocks of a previous copy (zsync control files)
+ *
+ * A zsync control file lists a rolling checksum and an MD4 for every block
+ * of the new file. Sliding the rolling checksum over the previous copy
+ * finds those blocks at any offset, even after insertions shifted them;
+ * found blocks are copied into the partial file locally, and only the
+ * ranges in between are handed to SegmentScheduler as segments, so the
+ * transfer is proportional to what changed.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+#include "openidm/engine/Segment.h"
+
+#include <atomic>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+namespace OpenIDM {
+
+/**
+ * @brief Block checksums of the target file (a parsed zsync control file)
+ */
+struct BlockMap {
+    ByteCount length = -1;              ///< Target file size
+    ByteCount blockSize = 0;
+    int sequentialMatches = 1;          ///< Consecutive blocks that must match together (1 or 2)
+    int rsumBytes = 4;                  ///< Stored bytes of each rolling checksum
+    int checksumBytes = 16;             ///< Stored bytes of each MD4
+    QByteArray sha1;                    ///< Whole-file SHA-1, if listed
+    std::vector<uint32_t> rsums;        ///< Per block, masked to rsumBytes
+    QByteArray checksums;               ///< Per block, checksumBytes each
+
+    bool isValid() const { return length > 0 && blockSize > 0 && !rsums.empty(); }
+
+    /// @return Number of blocks (the last one may be short)
+    size_t blockCount() const { return rsums.size(); }
+
+    /**
+     * @brief Parse a zsync control file ("zsync:" header, then block sums)
+     * @return Invalid map if @p data is not a zsync 0.6 control file
+     */
+    static BlockMap fromZsync(const QByteArray& data);
+};
+
+/**
+ * @brief A range of the target found in the previous copy
+ */
+struct BlockRun {
+    ByteOffset targetOffset = 0;
+    ByteOffset seedOffset = 0;
+    ByteCount length = 0;
+};
+
+/**
+ * @class DeltaSync
+ * @brief Block matching, seeding and segment layout for delta downloads
+ *
+ * All functions block and are meant for a pool thread; @p cancelled is
+ * polled between reads.
+ */
+class DeltaSync {
+public:
+    /**
+     * @brief Find the target's blocks in @p seedPath
+     *
+     * Runs shorter than Constants::DELTA_MIN_RUN are dropped: downloading
+     * them with their neighbours is cheaper than a request of their own.
+     *
+     * @return Runs in target order, adjacent blocks merged
+     */
+    static std::vector<BlockRun> match(const BlockMap& map, const QString& seedPath,
+                                       const std::atomic<bool>& cancelled);
+
+    /**
+     * @brief Copy @p runs from the seed into the partial file, sized to @p length
+     * @return False on an I/O error (@p error says which) or when cancelled
+     */
+    static bool copy(const std::vector<BlockRun>& runs, const QString& seedPath,
+                     const QString& partialPath, ByteCount length,
+                     const std::atomic<bool>& cancelled, QString* error);
+
+    /**
+     * @brief Segment layout: runs Completed, the gaps between them Pending
+     *
+     * Fed to SegmentScheduler::restoreSegments() like a resumed download.
+     */
+    static std::vector<Segment::Snapshot> layout(const std::vector<BlockRun>& runs, ByteCount length);
+};
+
+} // namespace OpenIDM
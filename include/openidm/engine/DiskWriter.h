@@ -0,0 +1,157 @@
+/**
+ * @file DiskWriter.h
+ * @brief Write-behind buffering between the network callbacks and the disk
+ *
+ * Segment workers copy received data into large, aligned, recycled buffers
+ * and hand full buffers to a dedicated writer thread. A slow disk (USB
+ * stick, NAS) then stalls only that thread; sockets keep being drained until
+ * the MemoryBudget is spent, which is the backpressure point.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+#include "openidm/engine/MemoryBudget.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OpenIDM {
+
+// Forward declarations
+class OutputFile;
+class Segment;
+
+/**
+ * @brief One pooled buffer covering a contiguous file range
+ */
+struct WriteBuffer {
+    char* data{nullptr};            ///< DIRECT_IO_ALIGNMENT-aligned storage
+    size_t capacity{0};             ///< Usable bytes for the current fill
+    size_t length{0};               ///< Bytes filled
+    ByteOffset offset{0};           ///< File offset of data[0]
+    OutputFile* file{nullptr};
+    Segment* segment{nullptr};      ///< Pending-byte accounting (not owned)
+    std::chrono::steady_clock::time_point issued{};  ///< Handed to FileIo (write latency)
+    bool failed{false};             ///< The write did not reach the file
+
+    /// @return File offset just past the filled bytes
+    ByteOffset end() const { return offset + static_cast<ByteOffset>(length); }
+
+    /// @return True if no more bytes fit
+    bool isFull() const { return length >= capacity; }
+};
+
+/**
+ * @class DiskWriter
+ * @brief Process-wide buffer pool plus the thread that flushes it
+ *
+ * Buffers of Constants::FILE_WRITE_BUFFER bytes are allocated on demand and
+ * recycled; up to Constants::WRITE_BUFFER_COUNT idle ones are kept. Each
+ * buffer handed out is charged to the MemoryBudget until it is written, so
+ * the pool grows only as far as the budget allows; the first buffer is
+ * always granted, so a full budget slows writers down but never stops them
+ * all. Submitted buffers are written
+ * in FIFO order, so for a single writer the bytes still in flight are always
+ * the highest ones of a segment (see Segment::durableByte()). Each batch is
+ * handed to the platform FileIo backend (io_uring, IOCP) in one submission
+ * and the batch is retired only after every write has completed. Retired
+ * buffers are reported to the file's ResumeJournal, and requested journal
+ * checkpoints run here, off the GUI thread.
+ *
+ * Thread Safety:
+ * - All public methods are thread-safe
+ */
+class DiskWriter {
+public:
+    /// @return The process-wide writer (started on first use)
+    static DiskWriter& instance();
+
+    ~DiskWriter();
+
+    // Disable copying
+    DiskWriter(const DiskWriter&) = delete;
+    DiskWriter& operator=(const DiskWriter&) = delete;
+
+    /// How acquire() charges the buffer to the MemoryBudget
+    enum class Charge {
+        Wait,       ///< Block until the budget has room
+        Granted,    ///< Already charged by a successful admit()
+        Force       ///< Past the budget if need be; for a thread that must not wait
+    };
+
+    /**
+     * @brief Take an empty buffer for a range starting at an offset
+     *
+     * With Charge::Wait, blocks while the memory budget is spent. The first
+     * buffer of a range is shortened so that it ends on an alignment
+     * boundary; all following buffers are then aligned in offset and length
+     * (O_DIRECT-eligible).
+     */
+    WriteBuffer* acquire(OutputFile* file, Segment* segment, ByteOffset offset,
+                         Charge charge = Charge::Wait);
+
+    /**
+     * @brief Charge one buffer now, for a caller that must not block
+     *
+     * For the transfer engine thread: on true the buffer is reserved, and
+     * the caller hands the grant to its next acquire() (Charge::Granted) or
+     * gives it back with revoke(). On false nothing is reserved and
+     * @p waker is parked with the MemoryBudget; it runs once a buffer may
+     * be free.
+     */
+    bool admit(MemoryBudget::Waker waker);
+
+    /// @brief Return a grant from admit() that no acquire() used
+    void revoke();
+
+    /**
+     * @brief Queue a filled buffer for writing (empty buffers are recycled)
+     */
+    void submit(WriteBuffer* buffer);
+
+    /**
+     * @brief Block until every queued buffer of a file has been written
+     */
+    void drain(const OutputFile* file);
+
+    /// @return Whether new output files should try O_DIRECT
+    bool directIo() const { return m_directIo.load(std::memory_order_relaxed); }
+
+    /// @brief Enable O_DIRECT for files opened afterwards (Linux only)
+    void setDirectIo(bool enabled) { m_directIo.store(enabled, std::memory_order_relaxed); }
+
+private:
+    DiskWriter();
+
+    void run();
+    void recycle(WriteBuffer* buffer);
+
+    /**
+     * @brief Charge the budget for one more buffer, if it allows
+     * @note Caller must hold m_mutex
+     */
+    bool grantLocked();
+
+    std::deque<WriteBuffer> m_buffers;             ///< Stable addresses; idle ones may have no data
+    std::vector<WriteBuffer*> m_free;
+    size_t m_checkedOut{0};                        ///< Acquired, not yet recycled (charged)
+    size_t m_idle{0};                              ///< Free buffers that still hold memory
+    std::deque<WriteBuffer*> m_queue;
+    std::vector<const OutputFile*> m_inFlight;     ///< Popped, being written
+
+    std::mutex m_mutex;
+    std::condition_variable m_queueCondition;      ///< Writer: work queued
+    std::condition_variable m_freeCondition;       ///< Producers: buffer freed / drained
+
+    std::atomic<bool> m_directIo{false};
+    bool m_stopping{false};
+    std::thread m_thread;
+};
+
+} // namespace OpenIDM
@@ -11,6 +11,9 @@
 
 #include "openidm/engine/Types.h"
 #include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/TaskRegistry.h"
+#include "openidm/engine/ProbePipeline.h"
+#include "openidm/persistence/PersistenceManager.h"
 
 #include <memory>
 #include <vector>
@@ -25,8 +28,9 @@
 namespace OpenIDM {
 
 // Forward declarations
-class PersistenceManager;
 class SettingsManager;
+class MetricsServer;
+class StreamServer;
 
 /**
  * @class DownloadManager
@@ -40,9 +44,16 @@ class SettingsManager;
  * 5. Settings and configuration
  * 6. Integration with persistence layer
  * 
+ * Completed downloads loaded from the database stay plain TaskData records
+ * (the archive); only unfinished ones get a DownloadTask with its
+ * scheduler and timers, so startup cost follows the active set rather than
+ * the size of the history. Both live in a TaskRegistry indexed by URL and
+ * state, so duplicate checks and per-state queries are constant-time.
+ * 
  * Thread Safety:
  * - All public methods are thread-safe
- * - Internal mutex protects task map
+ * - The registry's reader-writer lock protects tasks and archive; counts
+ *   are atomics
  * - Signals are emitted on the main thread
  */
 class DownloadManager : public QObject {
@@ -114,6 +125,15 @@ public slots:
     
     /**
      * @brief Add multiple downloads at once
+     *
+     * New tasks are registered, announced (downloadsAdded()) and saved as
+     * one batch; a URL that is already registered yields the ID of the
+     * existing download.
+     *
+     * Tasks that do not start right away are probed in the background
+     * (ProbePipeline), so sizes and range support are known before their
+     * turn and the queue can order them.
+     *
      * @param urls List of URLs
      * @param destDir Destination directory
      * @return List of created task IDs
@@ -121,6 +141,35 @@ public slots:
     std::vector<TaskId> addDownloads(const QList<QUrl>& urls,
                                       const QString& destDir = QString());
     
+    /**
+     * @brief Add the files of a Metalink document
+     *
+     * Each file becomes one task on its most preferred URL, with the other
+     * URLs as mirrors and the strongest listed digest as expected hash.
+     *
+     * @param document Metalink 4 or 3.0 XML
+     * @param destDir Destination directory
+     * @return List of created task IDs (empty if the document is invalid)
+     */
+    std::vector<TaskId> addMetalink(const QByteArray& document,
+                                     const QString& destDir = QString());
+    
+    /**
+     * @brief Import a link list file in the background
+     *
+     * The file is read line by line on a worker thread (text, CSV or an
+     * HTML/bookmarks export, see LinkList.h), dropping links it repeats.
+     * What is left is added like addDownloads() does: links already
+     * registered are skipped and the rest become queued tasks in one
+     * registry insert, one downloadsAdded() signal and one database
+     * transaction. importFinished() reports the outcome.
+     *
+     * @param path Local path or file:// URL of the list
+     * @param destDir Destination directory
+     * @return False if the file cannot be read or an import is running
+     */
+    Q_INVOKABLE bool importLinks(const QString& path, const QString& destDir = QString());
+    
     /**
      * @brief Remove a download
      * @param id Task ID
@@ -159,10 +208,22 @@ public:
     
     /**
      * @brief Get all tasks
-     * @return Vector of all task pointers
+     * @return Vector of all task pointers (archived downloads excluded)
      */
     std::vector<DownloadTask*> allTasks() const;
     
+    /**
+     * @brief Get a completed download that has no task object
+     * @param id Task ID
+     * @return Stored record, or nullopt if the ID is not archived
+     */
+    std::optional<TaskData> archivedDownload(const TaskId& id) const;
+    
+    /**
+     * @brief Get the IDs of all archived downloads
+     */
+    std::vector<TaskId> archivedDownloads() const;
+    
     /**
      * @brief Get tasks in a specific state
      * @param state State to filter by
@@ -232,6 +293,65 @@ public slots:
      */
     Q_INVOKABLE void startAll();
     
+    /**
+     * @brief Require a download to match a digest on completion
+     * @param id Task ID
+     * @param hash "sha256:<hex>" or a bare hex digest (see ExpectedHash)
+     * @return False if the task is unknown or the hash is not understood
+     */
+    Q_INVOKABLE bool setExpectedHash(const QString& id, const QString& hash);
+    
+    /**
+     * @brief Let a download fetch segments from equivalent URLs too
+     * @param id Task ID
+     * @param urls Mirrors of the task's URL
+     * @return False if the task is unknown or has already started
+     */
+    Q_INVOKABLE bool setMirrors(const QString& id, const QStringList& urls);
+    
+    /**
+     * @brief Unpack a download's archive into a directory while it downloads
+     * @param id Task ID
+     * @param directory Target directory (created if missing)
+     * @return False if the task is unknown or has already started; a file
+     *         that turns out not to be a supported archive is reported by
+     *         DownloadTask::extractionFailed()
+     */
+    Q_INVOKABLE bool setExtractTo(const QString& id, const QString& directory);
+    
+    /**
+     * @brief Download only what changed since a previous copy of the file
+     * @param id Task ID
+     * @param previousFile Older version of the file
+     * @param controlUrl zsync control file URL or path (empty = `<url>.zsync`)
+     * @return False if the task is unknown or has already started
+     */
+    Q_INVOKABLE bool setDeltaSource(const QString& id, const QString& previousFile,
+                                    const QString& controlUrl = QString());
+    
+    /**
+     * @brief Change a download's share of connections and bandwidth
+     * 
+     * An Urgent download is foreground: it starts even when the concurrent
+     * limit is reached and takes connections and bandwidth from the others.
+     * 
+     * @param id Task ID
+     * @param priority Priority value (Low = 0 ... Urgent = 3)
+     * @return False if the task is unknown or the value out of range
+     */
+    Q_INVOKABLE bool setPriority(const QString& id, int priority);
+    
+    /**
+     * @brief Get a loopback URL a media player can open while downloading
+     * 
+     * Starts the stream server on first use and switches the task to
+     * sequential mode, so playback can begin before the download ends.
+     * 
+     * @param id Task ID (running, finished or archived)
+     * @return URL, or empty if the task is unknown or no port could be bound
+     */
+    Q_INVOKABLE QString streamUrl(const QString& id);
+    
 public:
     // ───────────────────────────────────────────────────────────────────────
     // Statistics
@@ -261,12 +381,27 @@ public:
     /// @return Session bytes downloaded
     ByteCount sessionBytesDownloaded() const;
     
+    /// @return Bytes held in memory on their way to disk (MemoryBudget)
+    ByteCount bufferedBytes() const;
+    
     // ───────────────────────────────────────────────────────────────────────
     // Settings
     // ───────────────────────────────────────────────────────────────────────
     
+    /// @return Active engine tunables
+    const EngineTunables& tunables() const { return m_tunables; }
+    
+    /**
+     * @brief Replace all tunables at once
+     *
+     * Values are clamped to their allowed ranges and pushed to every task;
+     * settingsChanged() is emitted once if anything changed. The single-value
+     * setters below are shorthands for this.
+     */
+    void setTunables(const EngineTunables& tunables);
+    
     /// @return Maximum concurrent downloads
-    int maxConcurrentDownloads() const { return m_maxConcurrent; }
+    int maxConcurrentDownloads() const { return m_tunables.maxConcurrentDownloads; }
     
     /**
      * @brief Set maximum concurrent downloads
@@ -284,7 +419,7 @@ public:
     void setDefaultDownloadDirectory(const QString& path);
     
     /// @return Maximum segments per download
-    int maxSegmentsPerDownload() const { return m_maxSegments; }
+    int maxSegmentsPerDownload() const { return m_tunables.maxSegmentsPerDownload; }
     
     /**
      * @brief Set maximum segments per download
@@ -293,7 +428,7 @@ public:
     void setMaxSegmentsPerDownload(int count);
     
     /// @return Global speed limit (0 = unlimited)
-    SpeedBps speedLimit() const { return m_speedLimit; }
+    SpeedBps speedLimit() const { return m_tunables.speedLimit; }
     
     /**
      * @brief Set global speed limit
@@ -301,6 +436,15 @@ public:
      */
     void setSpeedLimit(SpeedBps limit);
     
+    /// @return Whether completed downloads are checked against `<url>.sha256`
+    bool verifySidecars() const { return m_tunables.verifySidecars; }
+    
+    /**
+     * @brief Look for `.sha256` sidecars for downloads without a given hash
+     * @param enabled Applies to existing and new downloads
+     */
+    void setVerifySidecars(bool enabled);
+    
     // ───────────────────────────────────────────────────────────────────────
     // Persistence
     // ───────────────────────────────────────────────────────────────────────
@@ -321,6 +465,16 @@ public:
      */
     void loadState();
     
+    /**
+     * @brief Store the tunables and download directory as settings
+     */
+    void saveSettings();
+    
+    /**
+     * @brief Apply the tunables and download directory stored as settings
+     */
+    void loadSettings();
+    
 signals:
     // ───────────────────────────────────────────────────────────────────────
     // Signals
@@ -329,9 +483,18 @@ signals:
     /// Emitted when a download is added
     void downloadAdded(const TaskId& id);
     
+    /// Emitted once for a batch of downloads added by addDownloads() or importLinks()
+    void downloadsAdded(const std::vector<TaskId>& ids);
+    
+    /// Emitted when importLinks() is done; skipped counts duplicates and links already added
+    void importFinished(int added, int skipped);
+    
     /// Emitted when a download is removed
     void downloadRemoved(const TaskId& id);
     
+    /// Emitted instead of downloadRemoved when the whole archive is cleared
+    void archiveCleared();
+    
     /// Emitted when a download starts
     void downloadStarted(const TaskId& id);
     
@@ -370,6 +533,8 @@ private slots:
     void onTaskCompleted();
     void onTaskFailed(const DownloadError& error);
     void onTaskNeedsPersistence();
+    void onPrefetchProbed(const TaskId& id, const ServerCapabilities& caps);
+    void onPrefetchFailed(const TaskId& id, const DownloadError& error);
     void onSpeedUpdateTimer();
     void processQueue();
     
@@ -381,25 +546,36 @@ private:
     void connectTask(DownloadTask* task);
     void disconnectTask(DownloadTask* task);
     void updateCounts();
+    void updateSpeedTimer();
     bool canStartMore() const;
     void startNextQueued();
+    std::vector<TaskId> addBatch(const QList<QUrl>& urls, const QString& destDir, size_t* created);
     
     // Singleton instance
     static std::unique_ptr<DownloadManager> s_instance;
     static bool s_initialized;
     
-    // Task storage
-    std::map<TaskId, std::unique_ptr<DownloadTask>> m_tasks;
-    mutable std::mutex m_tasksMutex;
+    // Task storage (tasks and completed downloads loaded without a task)
+    TaskRegistry m_registry;
     
     // Persistence
     std::unique_ptr<PersistenceManager> m_persistence;
     
+    // Background probes for bulk-added tasks
+    ProbePipeline* m_probes{nullptr};
+    
+    // Set while importLinks() reads a file; stops the read when set to true
+    std::shared_ptr<std::atomic<bool>> m_importCancel;
+    
+    // Prometheus endpoint (EngineTunables::metricsPort)
+    std::unique_ptr<MetricsServer> m_metricsServer;
+    
+    // Loopback playback of partial files (started by streamUrl())
+    std::unique_ptr<StreamServer> m_streamServer;
+    
     // Settings
-    int m_maxConcurrent{Constants::DEFAULT_CONCURRENT_DOWNLOADS};
-    int m_maxSegments{Constants::DEFAULT_SEGMENTS};
+    EngineTunables m_tunables;
     QString m_defaultDir;
-    SpeedBps m_speedLimit{0};
     
     // Statistics
     std::atomic<ByteCount> m_totalBytesEver{0};
@@ -413,7 +589,6 @@ private:
     
     // Timers
     QTimer* m_speedTimer{nullptr};
-    QTimer* m_queueTimer{nullptr};
 };
 
 } // namespace OpenIDM
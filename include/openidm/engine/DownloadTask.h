@@ -7,25 +7,35 @@
  * - Segment initialization and scheduling
  * - Worker thread management
  * - Progress aggregation
- * - File merging upon completion
+ * - Finalizing the preallocated output file upon completion
  */
 
 #pragma once
 
 #include "openidm/engine/Types.h"
+#include "openidm/engine/ArchiveExtractor.h"
 #include "openidm/engine/Segment.h"
 #include "openidm/engine/SegmentScheduler.h"
 #include "openidm/engine/SegmentWorker.h"
+#include "openidm/engine/SourceSet.h"
+#include "openidm/engine/OutputFile.h"
+#include "openidm/engine/ResumeJournal.h"
+#include "openidm/engine/BandwidthLimiter.h"
+#include "openidm/engine/ConnectionTuner.h"
+#include "openidm/engine/Checksum.h"
+#include "openidm/engine/SpeedCalculator.h"
+#include "openidm/engine/TaskRegistry.h"
+#include "openidm/engine/TransferTrace.h"
 
 #include <memory>
 #include <vector>
 #include <atomic>
 #include <chrono>
+#include <optional>
 
 #include <QObject>
 #include <QString>
 #include <QUrl>
-#include <QThreadPool>
 #include <QTimer>
 
 namespace OpenIDM {
@@ -43,7 +53,7 @@ class NetworkProbe;
  * 2. Create and manage segment workers
  * 3. Coordinate segment scheduler for work distribution
  * 4. Track aggregate progress and speed
- * 5. Merge segment files upon completion
+ * 5. Own the shared output file that workers write into at their offsets
  * 6. Handle errors and retries at the task level
  * 
  * Thread Safety:
@@ -169,7 +179,7 @@ public:
     /// @return Total bytes downloaded
     ByteCount downloadedSize() const { return m_downloadedBytes.load(std::memory_order_relaxed); }
     
-    /// @return Progress as percentage (0-100)
+    /// @return Progress as percentage (0-100); of the hash pass while Verifying
     double progress() const;
     
     /// @return Current download speed in bytes/second
@@ -196,6 +206,17 @@ public:
     /// @return Completed segments count
     int completedSegments() const;
     
+    /**
+     * @brief Coarse picture of which bytes are done, in flight or pending
+     * @param cells Number of equal slices of the file
+     * @return One RangeState byte per slice (the state covering most of
+     *         it, as of the last throughput sample), or an empty array
+     *         while the size is unknown
+     *
+     * Call from the task's thread; the table it reads is cached.
+     */
+    QByteArray segmentMap(int cells = Constants::SEGMENT_MAP_CELLS) const;
+    
     /// @return Detailed progress information
     DownloadProgress progressInfo() const;
     
@@ -222,6 +243,44 @@ public:
     /// @return True if server supports range requests
     bool supportsRanges() const { return m_capabilities.supportsRanges; }
     
+    /// @return Connections × streams used for the current transfer
+    SegmentScheduler::ConnectionPlan connectionPlan() const { return m_connectionPlan; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Sources
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /**
+     * @brief Offer equivalent URLs of the same file
+     *
+     * Segments are spread across the task's URL and its mirrors by measured
+     * throughput (see SourceSet). Call before start().
+     */
+    void setMirrors(const QList<QUrl>& mirrors) { m_sources.setMirrors(mirrors); }
+    
+    /// @return Mirror URLs (without url())
+    QList<QUrl> mirrors() const { return m_sources.mirrors(); }
+    
+    /// @return Sources of this download (for the scheduler and workers)
+    SourceSet& sources() { return m_sources; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Tracing
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /// @return Timing of recent segment attempts (see TransferTrace)
+    TransferTrace& trace() { return m_trace; }
+    
+    /**
+     * @brief Write the recent segment attempts as Chrome trace JSON
+     *
+     * Open the file in ui.perfetto.dev or chrome://tracing.
+     *
+     * @param path Output file
+     * @return False if the file could not be written
+     */
+    Q_INVOKABLE bool exportTrace(const QString& path) const;
+    
     // ───────────────────────────────────────────────────────────────────────
     // Priority
     // ───────────────────────────────────────────────────────────────────────
@@ -232,6 +291,161 @@ public:
     /// @brief Set task priority
     void setPriority(Priority priority);
     
+    // ───────────────────────────────────────────────────────────────────────
+    // Bandwidth
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /// @return Per-task speed limit (0 = only the global limit applies)
+    SpeedBps speedLimit() const { return m_speedLimit; }
+    
+    /**
+     * @brief Cap this task below the global limit
+     * 
+     * Under a global limit the bucket's rate is the lower of this and the
+     * task's fair share, see BandwidthLimiter::share().
+     * 
+     * @param limit Bytes per second (0 = unlimited)
+     */
+    void setSpeedLimit(SpeedBps limit);
+    
+    /// @return Per-segment speed limit (0 = unlimited)
+    SpeedBps segmentSpeedLimit() const { return m_segmentSpeedLimit; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // View Updates
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /**
+     * @brief Groups of displayed fields, flagged when their value changes
+     *
+     * List models poll these instead of refreshing every role of every
+     * active row on each tick.
+     */
+    enum DirtyField : uint32_t {
+        DirtyProgress = 1u << 0,    ///< Downloaded size, progress, remaining time
+        DirtySpeed    = 1u << 1,    ///< Speed, remaining time
+        DirtyState    = 1u << 2,
+        DirtySegments = 1u << 3,    ///< Active and total segment count
+        DirtyError    = 1u << 4,
+        DirtyFileInfo = 1u << 5,    ///< Name, path, total size, content type
+        DirtyPriority = 1u << 6
+    };
+    
+    /// @return DirtyField bits set since the last call, clearing them
+    uint32_t takeDirtyFields() { return m_dirtyFields.exchange(0, std::memory_order_acq_rel); }
+    
+    /**
+     * @brief Cap every segment connection of this task
+     * @param limit Bytes per second (0 = unlimited)
+     */
+    void setSegmentSpeedLimit(SpeedBps limit);
+    
+    /// @return Task bucket (parent of the worker buckets)
+    TokenBucket& bandwidth() { return m_bandwidth; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Integrity
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /// @return Digest the completed file must match (invalid = none)
+    ExpectedHash expectedHash() const { return m_expectedHash; }
+    
+    /// @brief Require the completed file to match a digest
+    void setExpectedHash(const ExpectedHash& hash) { m_expectedHash = hash; }
+    
+    /// @return Whether `<url>.sha256` is consulted when no hash was given
+    bool verifySidecar() const { return m_verifySidecar; }
+    
+    /// @brief Look for a `.sha256` sidecar next to the URL on completion
+    void setVerifySidecar(bool enabled) { m_verifySidecar = enabled; }
+    
+    /// @return Engine tunables last applied to this task
+    const EngineTunables& tunables() const { return m_tunables; }
+    
+    /**
+     * @brief Apply engine tunables
+     *
+     * Segment limits take effect the next time workers are started.
+     */
+    void setTunables(const EngineTunables& tunables) {
+        m_tunables = tunables;
+        m_verifySidecar = tunables.verifySidecars;
+        m_scheduler->setInterfaces(tunables.networkInterfaces);
+    }
+    
+    /**
+     * @brief CRC32C of the whole file, combined from the segment CRCs
+     *
+     * Available once all segments completed, unless a segment was resumed
+     * or hedged (its CRC then does not cover all of its bytes).
+     */
+    std::optional<uint32_t> fileCrc32c() const { return m_fileCrc32c; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Post-processing
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /// @return Directory the archive is unpacked into (empty = not unpacked)
+    QString extractTo() const { return m_extractTo; }
+    
+    /**
+     * @brief Unpack a .tar, .tar.gz or .tar.zst into @p directory while it downloads
+     *
+     * The scheduler runs in sequential mode so the archive's prefix grows
+     * steadily; the archive itself is kept. Takes effect at the next
+     * start() and is not persisted.
+     */
+    void setExtractTo(const QString& directory) { m_extractTo = directory; }
+    
+    /// @return True while entries are being extracted
+    bool isExtracting() const { return m_extractor && m_extractor->isRunning(); }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Delta Download
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /// @return Previous copy blocks are reused from (empty = none)
+    QString deltaSeed() const { return m_deltaSeed; }
+    
+    /**
+     * @brief Reuse the unchanged blocks of a previous copy of the file
+     *
+     * A download that starts from scratch first matches the blocks listed in
+     * the zsync control file against @p previousFile, copies the matches into
+     * the partial file and downloads only the rest. Without a usable control
+     * file it downloads normally. Not persisted.
+     *
+     * @param previousFile Older version of the file (may be the destination)
+     * @param controlUrl zsync control file (http(s) or file); empty = `<url>.zsync`
+     */
+    void setDeltaSource(const QString& previousFile, const QUrl& controlUrl = QUrl()) {
+        m_deltaSeed = previousFile;
+        m_deltaControl = controlUrl;
+    }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Resume
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /**
+     * @brief Provide the segment layout last saved to SQLite
+     *
+     * Used together with the resume journal when the next start() finds a
+     * partial file; ignored if the download starts from scratch.
+     */
+    void setSavedSegments(std::vector<Segment::Snapshot> snapshots) { m_savedSegments = std::move(snapshots); }
+    
+    /**
+     * @brief Accept capabilities probed ahead of start() (ProbePipeline)
+     *
+     * Only a queued task without capabilities takes them. They are treated
+     * like a cache hit, so workers send validators and a changed resource is
+     * probed again.
+     *
+     * @return true if the capabilities were applied
+     */
+    bool applyPrefetchedCapabilities(const ServerCapabilities& caps);
+    
     // ───────────────────────────────────────────────────────────────────────
     // Scheduler Access
     // ───────────────────────────────────────────────────────────────────────
@@ -239,6 +453,9 @@ public:
     /// @return Segment scheduler (for workers)
     SegmentScheduler* scheduler() const { return m_scheduler.get(); }
     
+    /// @return Shared output file (for workers, nullptr before start)
+    OutputFile* outputFile() const { return m_outputFile.get(); }
+    
     // ───────────────────────────────────────────────────────────────────────
     // Actions
     // ───────────────────────────────────────────────────────────────────────
@@ -301,6 +518,12 @@ signals:
     /// Emitted when task needs persistence update
     void needsPersistence();
     
+    /// Emitted when the archive was unpacked (see setExtractTo())
+    void extracted(const QString& directory);
+    
+    /// Emitted when the archive could not be unpacked; the download is unaffected
+    void extractionFailed(const QString& error);
+    
 private slots:
     // ───────────────────────────────────────────────────────────────────────
     // Internal Slots
@@ -308,10 +531,35 @@ private slots:
     
     void onProbeCompleted(const ServerCapabilities& caps);
     void onProbeFailed(const DownloadError& error);
+    
+    /**
+     * @brief Fan out once the fast-start request's headers are in
+     *
+     * Applies the capabilities like onProbeCompleted(), splits the open
+     * segment when the server honoured the range, opens the output file and
+     * releases the first worker's body before ramping up the rest.
+     */
+    void onStreamProbed(const ServerCapabilities& caps);
+    
+    /**
+     * @brief A worker got 412/416: the resource changed since it was probed
+     *
+     * Drops the cache entry. A download planned from cached capabilities
+     * starts over with a fresh probe; any other one fails.
+     */
+    void onResourceChanged(int httpStatus);
     void onSegmentCompleted(SegmentId id);
     void onSegmentFailed(SegmentId id, const QString& error);
     void onAllSegmentsCompleted();
     void onProgressTimer();
+    void onTuneTimer();
+    
+    /**
+     * @brief Grow to the connections WorkerPool has granted
+     *
+     * Queued by the pool when slots freed by another task reach this one.
+     */
+    void onConnectionsGranted();
     
 private:
     // ───────────────────────────────────────────────────────────────────────
@@ -323,33 +571,142 @@ private:
      */
     void probeServer();
     
+    /**
+     * @brief Check whether the first GET may double as the probe
+     *
+     * Needs an HTTP(S) URL and nothing to resume: restoring segments from a
+     * partial file needs the size before the first request.
+     */
+    bool canFastStart() const;
+    
+    /**
+     * @brief Start one worker on an open range instead of probing first
+     */
+    void fastStart();
+    
+    /**
+     * @brief Apply probed capabilities to the file name and size
+     */
+    void applyCapabilities(const ServerCapabilities& caps);
+    
     /**
      * @brief Initialize segments based on server capabilities
      */
     void initializeSegments();
     
+    /**
+     * @brief Lay out segments and start workers, seeding from a previous copy first
+     */
+    void planSegments();
+    
+    /**
+     * @brief Match and copy reusable blocks on a pool thread, then start workers
+     */
+    void seedFromPrevious();
+    
     /**
      * @brief Start worker threads
      */
     void startWorkers();
     
+    /**
+     * @brief Plan connections and grow to the tuner's first step
+     *
+     * Workers that are already running (the fast-start probe) count
+     * towards the grant.
+     */
+    void rampUpWorkers();
+    
+    /**
+     * @brief Create a worker and hand it to the engine or the thread pool
+     */
+    void spawnWorker();
+    
+    /**
+     * @brief Ask WorkerPool for a number of connections and apply the grant
+     * @param count Desired number of parallel connections
+     */
+    void setConnectionCount(size_t count);
+    
+    /**
+     * @brief Grow or shrink the number of running workers
+     * @param count Number of parallel connections granted
+     */
+    void applyConnectionCount(size_t count);
+    
     /**
      * @brief Stop all workers
      */
     void stopWorkers();
     
     /**
-     * @brief Merge segment files into final file
+     * @brief Rebuild segments from an existing partial file and its journal
+     * @return True if segments were restored (false = start from scratch)
+     */
+    bool restoreSegments();
+    
+    /**
+     * @brief Open and preallocate the partial output file
+     */
+    bool prepareOutputFile();
+    
+    /**
+     * @brief Start a fresh resume journal for the current segment layout
+     */
+    void openJournal();
+    
+    /**
+     * @brief Flush and close the output file, keeping its .part path
+     */
+    bool sealOutputFile();
+    
+    /**
+     * @brief Rename the verified .part file to its final path
+     */
+    bool finalizeOutputFile();
+    
+    /**
+     * @brief Verify the sealed .part file, then complete or fail the task
+     *
+     * CRC32C expectations are answered from the segment CRCs; other
+     * digests (and sidecar lookups) run on a pool thread.
+     */
+    void verifyFile();
+    
+    /**
+     * @brief Compare a computed digest and settle the task
+     * @param expected Digest to match (invalid = nothing to check)
+     * @param actual Computed digest
+     * @param readError Why the digest could not be computed (if it could not)
+     */
+    void finishVerification(const ExpectedHash& expected, const QByteArray& actual,
+                            const QString& readError);
+    
+    /**
+     * @brief Combine the segment CRCs in file order
+     * @return Whole-file CRC32C, or nullopt if any segment CRC is incomplete
      */
-    bool mergeSegments();
+    std::optional<uint32_t> combineSegmentChecksums() const;
     
     /**
-     * @brief Verify final file integrity
+     * @brief Start unpacking the archive if setExtractTo() asked for it
+     *
+     * Called once the output file is open and the file name is final.
      */
-    bool verifyFile();
+    void startExtraction();
     
     /**
-     * @brief Clean up temporary files
+     * @brief Tell the extractor how much of the partial file is contiguous
+     */
+    void feedExtractor();
+    
+    /**
+     * @brief Stop the extractor (the download restarts or is dropped)
+     */
+    void stopExtraction();
+    
+    /**
+     * @brief Clean up partial files (on cancel)
      */
     void cleanupTempFiles();
     
@@ -365,16 +722,14 @@ private:
      */
     void setError(const DownloadError& error);
     
+    /// @brief Flag fields for the next model update
+    void markDirty(uint32_t fields) { m_dirtyFields.fetch_or(fields, std::memory_order_release); }
+    
     /**
      * @brief Update aggregate statistics
      */
     void updateStatistics();
     
-    /**
-     * @brief Generate temporary file path for a segment
-     */
-    QString tempFilePath(SegmentId segmentId) const;
-    
     // ───────────────────────────────────────────────────────────────────────
     // Member Variables
     // ───────────────────────────────────────────────────────────────────────
@@ -388,6 +743,9 @@ private:
     
     // Server info
     ServerCapabilities m_capabilities;
+    SegmentScheduler::ConnectionPlan m_connectionPlan;
+    SourceSet m_sources;
+    TransferTrace m_trace;
     
     // State
     std::atomic<DownloadState> m_state{DownloadState::Queued};
@@ -402,21 +760,69 @@ private:
     Timestamp m_endTime;
     Duration m_elapsedTime{0};
     
+    // Integrity
+    ExpectedHash m_expectedHash;
+    bool m_verifySidecar{false};
+    std::optional<uint32_t> m_fileCrc32c;
+    std::shared_ptr<std::atomic<ByteCount>> m_verifiedBytes;  ///< Hashed so far, while Verifying
+    
+    // Delta download
+    QString m_deltaSeed;
+    QUrl m_deltaControl;
+    std::shared_ptr<std::atomic<bool>> m_deltaCancel;   ///< Set while seeding
+    
+    // Post-processing
+    QString m_extractTo;
+    std::unique_ptr<ArchiveExtractor> m_extractor;
+    ByteOffset m_extractFed{0};                     ///< Contiguous bytes handed over
+    
+    // Settings
+    EngineTunables m_tunables;
+    
+    // Bandwidth (declared before the workers whose buckets point at it)
+    TokenBucket m_bandwidth{&BandwidthLimiter::instance().global()};
+    SpeedBps m_speedLimit{0};
+    SpeedBps m_segmentSpeedLimit{0};
+    
     // Components
     std::unique_ptr<SegmentScheduler> m_scheduler;
+    mutable SegmentTable m_segmentTable;            ///< segmentMap()'s copy of the scheduler's table
     std::unique_ptr<NetworkProbe> m_probe;
+    std::unique_ptr<OutputFile> m_outputFile;
+    std::unique_ptr<ResumeJournal> m_journal;       ///< Ranged downloads only
     std::vector<std::unique_ptr<SegmentWorker>> m_workers;
-    QThreadPool* m_threadPool;
     
     // Progress timer
     QTimer* m_progressTimer{nullptr};
     
+    // Adaptive connection count
+    std::unique_ptr<ConnectionTuner> m_connectionTuner;
+    QTimer* m_tuneTimer{nullptr};
+    ByteCount m_tuneLastBytes{0};
+    Timestamp m_tuneLastTime;
+    
     // Speed calculation
-    std::vector<std::pair<Timestamp, ByteCount>> m_speedHistory;
+    SpeedCalculator m_speedMeter;                   ///< Smoothed speed for the ETA
+    int m_speedSlot{-1};                            ///< Slot in the global meter
     
     // Persistence
     bool m_needsPersistence{false};
     ByteCount m_lastPersistedBytes{0};
+    ByteCount m_lastJournalSyncBytes{0};
+    std::vector<Segment::Snapshot> m_savedSegments;
+    
+    // Values last flagged to views
+    std::atomic<uint32_t> m_dirtyFields{0};
+    ByteCount m_reportedBytes{-1};
+    SpeedBps m_reportedSpeed{-1.0};
+    int m_reportedSegments{-1};
+    
+    // Per-state list link, owned by the TaskRegistry
+    friend class TaskRegistry;
+    TaskListHook m_registryHook;
+    
+    // Connection grants are delivered by the pool
+    friend class WorkerPool;
 };
 
 } // namespace OpenIDM
@@ -0,0 +1,155 @@
+/**
+ * @file EngineMetrics.h
+ * @brief Process-wide engine counters and their Prometheus exposition
+ *
+ * The engine bumps relaxed atomics where things happen (received bytes in
+ * the write callback, steals in the scheduler, write completions on the
+ * disk thread) instead of the UI deriving numbers from its periodic
+ * snapshots. render() formats them in the Prometheus text format, which
+ * MetricsServer serves on /metrics for headless and fleet deployments.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+#include <QByteArray>
+#include <QString>
+
+namespace OpenIDM {
+
+// ───────────────────────────────────────────────────────────────────────────
+// Samples
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Per-task values read when metrics are rendered
+ */
+struct TaskSample {
+    QString id;                         ///< TaskId without braces
+    DownloadState state = DownloadState::Queued;
+    ByteCount downloaded = 0;
+    ByteCount total = -1;               ///< -1 if unknown
+    SpeedBps speed = 0.0;
+    int connections = 0;                ///< Segments being transferred
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// Metrics
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @class EngineMetrics
+ * @brief Lock-free counters, gauges and histograms of the whole engine
+ *
+ * The received-bytes counter is bumped once per curl write callback from
+ * every transfer thread, so it is spread over cache-line-sized shards.
+ *
+ * Thread Safety:
+ * - Recording methods are lock-free and callable from any thread
+ * - render() may run on any thread (MetricsServer's); it calls the task
+ *   source, which must be safe from there too
+ */
+class EngineMetrics {
+public:
+    /// Upper bounds of the disk write latency buckets, in microseconds
+    static constexpr std::array<int64_t, 12> WRITE_BUCKETS_US = {
+        100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000
+    };
+
+    /// Visits one sample per task
+    using TaskSource = std::function<void(const std::function<void(const TaskSample&)>&)>;
+
+    /// @return The process-wide instance
+    static EngineMetrics& instance();
+
+    // Disable copying
+    EngineMetrics(const EngineMetrics&) = delete;
+    EngineMetrics& operator=(const EngineMetrics&) = delete;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Recording
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @brief Bytes stored by a transfer
+    void addBytesReceived(ByteCount bytes);
+
+    /// @brief A transfer started (+1) or ended (-1)
+    void addActiveTransfers(int delta) { m_activeTransfers.fetch_add(delta, std::memory_order_relaxed); }
+
+    /// @brief A worker split off part of another worker's segment
+    void addSteal() { m_steals.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief A worker joined the end game with a duplicate request
+    void addHedge() { m_hedges.fetch_add(1, std::memory_order_relaxed); }
+
+    /// @brief A rebalance pass split @p splits slow segments
+    void addRebalance(int splits);
+
+    /// @brief A segment failed and will be tried again
+    void addRetry(ErrorCategory category);
+
+    /// @brief A download finished
+    void addDownloadFinished(bool success);
+
+    /// @brief Writes waiting for the persistence thread
+    void setPersistenceQueueDepth(size_t depth) { m_persistenceQueue.store(depth, std::memory_order_relaxed); }
+
+    /// @brief One write-behind buffer reached the disk after @p latency
+    void observeDiskWrite(std::chrono::microseconds latency, ByteCount bytes);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Exposition
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Set where per-task samples come from
+     *
+     * DownloadManager installs one that walks its TaskRegistry; without
+     * one, only the engine-wide series are rendered.
+     */
+    void setTaskSource(TaskSource source);
+
+    /// @return Prometheus text exposition format 0.0.4
+    QByteArray render() const;
+
+    /// @return Bytes received since start
+    ByteCount bytesReceived() const;
+
+private:
+    EngineMetrics() = default;
+
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t CATEGORIES = static_cast<size_t>(ErrorCategory::Unknown) + 1;
+
+    struct alignas(64) Shard {
+        std::atomic<ByteCount> value{0};
+    };
+
+    std::array<Shard, SHARDS> m_bytesReceived;
+    std::atomic<int64_t> m_activeTransfers{0};
+    std::atomic<uint64_t> m_steals{0};
+    std::atomic<uint64_t> m_hedges{0};
+    std::atomic<uint64_t> m_rebalances{0};
+    std::atomic<uint64_t> m_rebalanceSplits{0};
+    std::array<std::atomic<uint64_t>, CATEGORIES> m_retries{};
+    std::atomic<uint64_t> m_downloadsCompleted{0};
+    std::atomic<uint64_t> m_downloadsFailed{0};
+    std::atomic<size_t> m_persistenceQueue{0};
+
+    // Disk write latency histogram (non-cumulative buckets; +Inf last)
+    std::array<std::atomic<uint64_t>, WRITE_BUCKETS_US.size() + 1> m_writeBuckets{};
+    std::atomic<int64_t> m_writeLatencySumUs{0};
+    std::atomic<ByteCount> m_bytesWritten{0};
+
+    mutable std::mutex m_sourceMutex;
+    TaskSource m_taskSource;
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,211 @@
+/**
+ * @file FragmentDownloader.h
+ * @brief Parallel download of HLS/DASH fragment lists into one file
+ *
+ * A segmented stream is a list of small resources that, concatenated in
+ * order, form the media file. FragmentDownloader fetches them in parallel
+ * over one curl multi handle (connections and HTTP/2 streams are reused
+ * across fragments), decrypts AES-128 fragments on a separate writer
+ * thread, and appends each fragment to the output as soon as every
+ * fragment before it is there, so the file grows while the rest arrive.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+#include "openidm/engine/SpeedCalculator.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+
+// Forward declare CURL types
+typedef void CURL;
+typedef void CURLM;
+struct curl_slist;
+
+namespace OpenIDM {
+
+// ───────────────────────────────────────────────────────────────────────────
+// Fragment Lists
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief One piece of a segmented stream
+ */
+struct StreamFragment {
+    QUrl url;
+    ByteOffset rangeStart = -1;         ///< Sub-range of the resource, -1 = all of it
+    ByteCount rangeLength = 0;
+    int key = -1;                       ///< Index into FragmentList::keys, -1 = clear
+    QByteArray iv;                      ///< AES-128-CBC IV (16 bytes) when encrypted
+};
+
+/**
+ * @brief Fragments in playback order, initialization section first
+ */
+struct FragmentList {
+    std::vector<StreamFragment> fragments;
+    std::vector<QUrl> keys;             ///< AES-128 key URIs
+
+    bool isValid() const { return !fragments.empty(); }
+    bool isEncrypted() const { return !keys.empty(); }
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// Downloader
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @class FragmentDownloader
+ * @brief Bounded-concurrency fragment fetch with in-order assembly
+ *
+ * At most Constants::FRAGMENT_CONCURRENCY fragments are in flight, and
+ * none more than Constants::FRAGMENT_WINDOW ahead of the last one written,
+ * which bounds the memory held for reordering. A failed fragment is
+ * retried with backoff up to Constants::MAX_RETRIES times before the whole
+ * download fails.
+ *
+ * Thread Safety:
+ * - Call the public methods from the owning (GUI) thread
+ * - Signals are emitted on the owning thread
+ */
+class FragmentDownloader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FragmentDownloader(QObject* parent = nullptr);
+    ~FragmentDownloader() override;
+
+    // Disable copying
+    FragmentDownloader(const FragmentDownloader&) = delete;
+    FragmentDownloader& operator=(const FragmentDownloader&) = delete;
+
+    /// @return True if AES-128 fragments can be decrypted in this build
+    static bool supportsEncryption();
+
+    /**
+     * @brief Extra request headers ("Name: value"), e.g. from the extractor
+     * @note Takes effect for the next start
+     */
+    void setHeaders(const QStringList& headers) { m_headerLines = headers; }
+
+    /**
+     * @brief Download an HLS playlist; a master playlist's best variant is used
+     * @return False if a download is already running
+     */
+    bool startPlaylist(const QUrl& playlist, const QString& outputPath);
+
+    /**
+     * @brief Download a ready fragment list (e.g. DASH fragments from yt-dlp)
+     * @return False if a download is running, the list is empty, or it is
+     *         encrypted and supportsEncryption() is false
+     */
+    bool start(FragmentList list, const QString& outputPath);
+
+    /// Stop and join the threads; the partial output is left in place
+    void cancel();
+
+    /// @return True between a successful start and finished()/failed()/cancel()
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+signals:
+    /// Emitted at most every Constants::PROGRESS_UPDATE_INTERVAL
+    void progress(int written, int total, ByteCount bytes, SpeedBps speed);
+
+    /// Emitted once every fragment was written
+    void finished(const QString& outputPath);
+
+    /// Emitted when a fragment, key or playlist could not be fetched or written
+    void failed(const DownloadError& error);
+
+private:
+    enum class Kind { Playlist, Key, Fragment };
+
+    struct Transfer {
+        FragmentDownloader* owner{nullptr};
+        Kind kind{Kind::Fragment};
+        size_t index{0};                ///< Fragment or key index
+        QByteArray body;                ///< Fragments: charged to the MemoryBudget
+        QByteArray urlBytes;
+        QByteArray rangeBytes;
+        QUrl url;
+        bool paused{false};             ///< Held back for memory (CURL_WRITEFUNC_PAUSE)
+        ByteCount pausedBytes{0};       ///< Size of the held-back write
+    };
+
+    struct Retry {
+        Kind kind;
+        size_t index;
+        Timestamp notBefore;
+    };
+
+    bool launch(const QString& outputPath);
+
+    // I/O thread
+    void run();
+    void startTransfers();
+    void startTransfer(Kind kind, size_t index, const QUrl& url);
+    void finishTransfer(CURL* easy, int curlCode);
+    void releaseTransfer(CURL* easy);
+    bool reserveBody(Transfer& transfer, size_t bytes);
+    void resumePaused();
+    void dropBodies();
+    bool acceptPlaylist(const QByteArray& body, const QUrl& url);
+    void scheduleRetry(Kind kind, size_t index, const DownloadError& error);
+    void reportProgress();
+
+    // Writer thread
+    void write();
+    bool decrypt(QByteArray& data, const QByteArray& key, const QByteArray& iv) const;
+
+    // Either thread
+    void fail(const DownloadError& error);
+
+    static size_t writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+
+    std::thread m_io;
+    std::thread m_writer;
+    CURLM* m_multi{nullptr};
+    curl_slist* m_headers{nullptr};
+    QStringList m_headerLines;
+    QString m_outputPath;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stopping{false};
+
+    // Shared by both threads, guarded by m_mutex
+    FragmentList m_list;
+    QUrl m_playlistUrl;                 ///< Set until the media playlist is parsed
+    int m_playlistDepth{0};             ///< Master → media hops taken
+    std::map<size_t, QByteArray> m_bodies;  ///< Fetched, waiting for their turn
+    std::vector<QByteArray> m_keys;     ///< Fetched key bytes, empty until then
+    size_t m_written{0};                ///< Fragments appended to the output
+    ByteCount m_bytesWritten{0};
+    bool m_failed{false};
+    std::mutex m_mutex;
+    std::condition_variable m_writerWake;
+
+    // I/O thread only
+    std::unordered_map<CURL*, std::unique_ptr<Transfer>> m_active;
+    std::deque<Retry> m_retries;
+    std::map<std::pair<int, size_t>, size_t> m_attempts;
+    size_t m_nextFragment{0};           ///< Next never-started fragment
+    size_t m_activeFragments{0};
+    bool m_keysStarted{false};
+    ByteCount m_bytesReceived{0};
+    SpeedCalculator m_speed;
+    Timestamp m_lastProgress{};
+};
+
+} // namespace OpenIDM
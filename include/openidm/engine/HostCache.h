@@ -0,0 +1,106 @@
+/**
+ * @file HostCache.h
+ * @brief Persisted per-host and per-resource capability cache
+ *
+ * Every download used to re-learn whether its host honours ranges, which
+ * HTTP version it negotiates, how many connections pay off and the
+ * validators of the resource itself. The cache keeps those answers in the
+ * SQLite store with a TTL, so a batch against the same artifact server
+ * goes straight to a segment plan instead of probing each file.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+#include "openidm/persistence/PersistenceManager.h"
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include <QString>
+#include <QUrl>
+
+namespace OpenIDM {
+
+/**
+ * @class HostCache
+ * @brief What probes and tuners learned, keyed by host and by resource
+ *
+ * Resource entries hold a probe result and expire after
+ * Constants::RESOURCE_CACHE_TTL; they are dropped early when a server
+ * answers 412 or 416, i.e. the resource changed under us. Host entries
+ * (protocol, range support, learned connection count) live for
+ * Constants::HOST_CACHE_TTL.
+ *
+ * Thread Safety:
+ * - All methods are safe to call from any thread
+ * - Writes reach the database through PersistenceManager's writer thread
+ */
+class HostCache {
+public:
+    /// @return Process-wide cache
+    static HostCache& instance();
+
+    // Disable copying
+    HostCache(const HostCache&) = delete;
+    HostCache& operator=(const HostCache&) = delete;
+
+    /**
+     * @brief Load the persisted entries and write changes through
+     * @param persistence Store to use (nullptr = memory only)
+     */
+    void attach(PersistenceManager* persistence);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Resources
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Probe result of a resource, if still fresh
+     * @return Capabilities marked fromCache, or nullopt
+     */
+    std::optional<ServerCapabilities> lookup(const QUrl& url) const;
+
+    /**
+     * @brief Remember a probe result and what it says about the host
+     */
+    void store(const QUrl& url, const ServerCapabilities& caps);
+
+    /**
+     * @brief Forget a resource after the server reported it changed
+     */
+    void invalidate(const QUrl& url);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Hosts
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @return Fresh entry for the URL's host, or nullopt
+    std::optional<HostRecord> host(const QUrl& url) const;
+
+    /// @return Learned connection optimum for a host key (0 if unknown)
+    size_t learnedConnections(const QString& hostKey) const;
+
+    /// @brief Record the connection count a tuner settled on
+    void rememberConnections(const QString& hostKey, size_t count);
+
+    /// @return Key for a URL's host: lower-case host, ":port" if not default
+    static QString hostKey(const QUrl& url);
+
+private:
+    HostCache() = default;
+
+    static qint64 now();
+    static bool isFresh(qint64 updatedAt, Duration ttl);
+
+    /// @note Caller must hold m_mutex
+    void saveHostLocked(const HostRecord& record);
+
+    PersistenceManager* m_persistence{nullptr};
+    std::unordered_map<QString, HostRecord> m_hosts;
+    std::unordered_map<QString, ResourceRecord> m_resources;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace OpenIDM
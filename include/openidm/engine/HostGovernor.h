@@ -0,0 +1,162 @@
+/**
+ * @file HostGovernor.h
+ * @brief Per-host connection budget shared by every download in the engine
+ *
+ * WorkerPool caps connections engine-wide, but ten downloads from one
+ * server could still open ten tasks' worth of connections to it and get
+ * the client rate-limited or banned. The governor counts open transfers
+ * per host (HostCache::hostKey()) across all tasks and admits a new one
+ * only while the host is under its limit; tasks on other hosts are not
+ * affected.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <QRandomGenerator>
+#include <QString>
+
+namespace OpenIDM {
+
+/**
+ * @class HostGovernor
+ * @brief Admits transfers per host and learns limits from throttling
+ *
+ * Every host starts at the configured ceiling
+ * (EngineTunables::maxConnectionsPerHost). A 429 or 503 halves the host's
+ * limit (from what it had open, at least one) and, with Retry-After,
+ * blocks new transfers until then. Each run of clean transfers raises the
+ * limit by one again; a host that has not throttled for a while is back
+ * at the ceiling.
+ *
+ * SegmentScheduler acquires a slot before handing a worker a segment and
+ * releases it when the segment is released. It also asks retryDelay() how
+ * long a failed segment should wait, so every task backs off from a host
+ * that is failing.
+ *
+ * Thread Safety:
+ * - All methods are safe to call from any thread
+ */
+class HostGovernor {
+public:
+    /// @return Process-wide governor
+    static HostGovernor& instance();
+
+    // Disable copying
+    HostGovernor(const HostGovernor&) = delete;
+    HostGovernor& operator=(const HostGovernor&) = delete;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Budget
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Set the connections allowed per host before anything is learned
+     *
+     * Running transfers are kept; a host over the new limit admits no more
+     * until enough of them finish.
+     */
+    void setLimit(size_t connections);
+
+    /// @return Connections allowed per host before anything is learned
+    size_t limit() const;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Slots
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Open a transfer to @p host if its budget allows
+     * @param[out] retryIn When refused: time left of a Retry-After block,
+     *             or 0 if the host is just full
+     * @return True if the caller now holds a slot and must release() it
+     */
+    bool tryAcquire(const QString& host, Duration* retryIn = nullptr);
+
+    /// @brief Give back a slot taken by tryAcquire()
+    void release(const QString& host);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Feedback
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief The host answered 429 or 503
+     * @param retryAfter Its Retry-After (negative if absent)
+     */
+    void reportThrottled(const QString& host, Duration retryAfter);
+
+    /// @brief A transfer to @p host finished without being throttled
+    void reportSuccess(const QString& host);
+
+    /// @brief A transfer to @p host failed (network or server error)
+    void reportFailure(const QString& host);
+
+    /**
+     * @brief Full-jitter backoff before retrying a segment on @p host
+     *
+     * Uniform in [0, min(MAX_RETRY_DELAY, RETRY_BACKOFF_BASE × 2^(n-1))],
+     * with n the larger of the segment's @p attempt and the host's run of
+     * failures, and never before a Retry-After block ends.
+     */
+    Duration retryDelay(const QString& host, int attempt) const;
+
+    /**
+     * @brief Draw retryDelay()'s jitter from a generator seeded with @p seed
+     *
+     * Makes the backoff reproducible for the scheduler simulator; by
+     * default the jitter comes from QRandomGenerator::global().
+     */
+    void seedJitter(quint32 seed);
+
+    struct HostStatus {
+        QString host;
+        size_t active{0};
+        size_t limit{0};
+        Duration blockedFor{0};
+    };
+
+    /// @return Hosts with open transfers, a learned limit or recent failures
+    std::vector<HostStatus> hosts() const;
+
+private:
+    HostGovernor() = default;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Host {
+        size_t active{0};
+        size_t limit{0};                ///< 0 = the configured ceiling
+        size_t cleanStreak{0};
+        size_t failures{0};             ///< Bursts of failures since the last success
+        Clock::time_point blockedUntil{};
+        Clock::time_point throttledAt{};
+        Clock::time_point failedAt{};
+    };
+
+    /**
+     * @brief Effective limit, forgetting an old throttle
+     * @note Caller must hold m_mutex
+     */
+    size_t limitLocked(Host& host, Clock::time_point now);
+
+    /**
+     * @brief Drop @p host's entry once it is idle and back to defaults
+     * @note Caller must hold m_mutex
+     */
+    void pruneLocked(const QString& host);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<QString, Host> m_hosts;
+    size_t m_ceiling{Constants::DEFAULT_HOST_CONNECTIONS};
+    mutable std::optional<QRandomGenerator> m_jitter;   ///< Set by seedJitter()
+};
+
+} // namespace OpenIDM
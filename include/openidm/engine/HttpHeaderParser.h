@@ -0,0 +1,80 @@
+/**
+ * @file HttpHeaderParser.h
+ * @brief Allocation-light parsing of curl header lines into HttpHeaderInfo
+ *
+ * Every probe, redirect and segment start passes its response headers
+ * through a CURLOPT_HEADERFUNCTION. Instead of collecting them into a
+ * QString and running a regex per field over the block, each line is
+ * parsed where curl delivers it: the name is looked up with a
+ * compile-time perfect hash, and only values of known headers are
+ * converted, straight into their HttpHeaderInfo field.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <cstdint>
+#include <string_view>
+
+#include <QString>
+
+namespace OpenIDM {
+
+/**
+ * @class HttpHeaderParser
+ * @brief Stateless header line parser
+ *
+ * A status line ("HTTP/1.1 302 Found") resets the info, so after a
+ * redirect chain it describes the final response only. A folded line
+ * (obs-fold, starting with whitespace) extends the text header before it
+ * and is never read as a header of its own. Repeated headers replace
+ * the earlier value, except Alt-Svc, whose offers accumulate.
+ *
+ * Thread Safety:
+ * - Reentrant; safe from curl callbacks on any thread
+ */
+class HttpHeaderParser {
+public:
+    /// Header names the parser understands
+    enum class Header : uint8_t {
+        Unknown,
+        ContentLength,
+        ContentType,
+        ContentRange,
+        ContentEncoding,
+        ContentDisposition,
+        AcceptRanges,
+        ETag,
+        LastModified,
+        Location,
+        AltSvc,
+        Server,
+        RetryAfter,
+    };
+
+    /**
+     * @brief Parse one line as delivered to CURLOPT_HEADERFUNCTION
+     * @param line Raw bytes, with or without the trailing CRLF
+     * @param info Updated in place
+     */
+    static void parseLine(std::string_view line, HttpHeaderInfo& info);
+
+    /**
+     * @brief Case-insensitive lookup of a header name
+     * @return Header::Unknown for names the parser ignores
+     */
+    static Header lookup(std::string_view name);
+
+    /**
+     * @brief File name of a Content-Disposition value
+     *
+     * Prefers the RFC 6266 `filename*=UTF-8''...` form, then `filename=`
+     * (quoted or token); percent-escapes are decoded.
+     *
+     * @return Empty if the value names no file
+     */
+    static QString fileNameFrom(std::string_view disposition);
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,52 @@
+/**
+ * @file LinkList.h
+ * @brief Streaming extraction of URLs from imported link lists
+ *
+ * Users import plain text (one URL per line), CSV exports with a URL
+ * column, or a browser's bookmarks/HTML export. All three are read one
+ * line at a time, so a list of a few hundred thousand links never sits in
+ * memory as a whole. DownloadManager::importLinks() runs the reader on a
+ * worker thread and adds what it finds in one batch.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <functional>
+
+#include <QIODevice>
+#include <QList>
+#include <QStringView>
+#include <QUrl>
+
+namespace OpenIDM {
+
+/**
+ * @brief Extract the download URLs of one line of a link list
+ *
+ * - `href="..."` attributes, if the line has any (HTML and bookmark
+ *   exports; `&amp;` is decoded)
+ * - otherwise the whole line if it is a URL
+ * - otherwise the first comma, semicolon or tab separated field that is
+ *   one, with surrounding quotes removed (CSV, TSV)
+ *
+ * Blank lines, `#` comments and header rows yield nothing. Only HTTP(S)
+ * and FTP(S) URLs with a host are returned.
+ *
+ * @param line One line, without its terminator
+ * @param out URLs are appended here
+ */
+void extractLinks(QStringView line, QList<QUrl>& out);
+
+/**
+ * @brief Read a link list from @p device line by line
+ * @param sink Called once per URL found, in file order, duplicates included
+ * @param cancelled Stops the read between lines when set
+ * @return Lines read
+ */
+qint64 readLinkList(QIODevice& device, const std::function<void(const QUrl&)>& sink,
+                    const std::atomic<bool>* cancelled = nullptr);
+
+} // namespace OpenIDM
@@ -0,0 +1,122 @@
+/**
+ * @file MemoryBudget.h
+ * @brief Engine-wide cap on bytes buffered between the network and the disk
+ *
+ * Every connection has a curl receive buffer, write-behind buffers hold
+ * data until the disk thread has written it, and HLS fragments sit in
+ * memory until their turn. None of that was capped as a whole, so a large
+ * batch on a small machine could push it into swap. Everything that buffers
+ * charges this budget first; when it is spent, transfers are paused
+ * (CURL_WRITEFUNC_PAUSE, resumed with CURLPAUSE_CONT) rather than
+ * failed, and the data stays with the server until memory is released.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace OpenIDM {
+
+/**
+ * @class MemoryBudget
+ * @brief Counts buffered bytes and parks transfers that would exceed the cap
+ *
+ * tryReserve() is a lock-free check against the limit; reserve() always
+ * succeeds and is used where one buffer must be granted for progress (the
+ * next fragment in order, the first write-behind buffer), so the budget can
+ * be overshot by that much but never deadlock. A transfer that cannot get
+ * memory parks a waker, which runs on the next release().
+ *
+ * Thread Safety:
+ * - All methods are safe to call from any thread
+ * - Wakers run on the releasing thread and must only post work elsewhere
+ */
+class MemoryBudget {
+public:
+    using Waker = std::function<void()>;
+
+    /// @return Process-wide budget
+    static MemoryBudget& instance();
+
+    // Disable copying
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Limit
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @brief Set the cap (EngineTunables::memoryBudgetMB); wakes parked transfers
+    void setLimit(ByteCount bytes);
+
+    /// @return Cap in bytes
+    ByteCount limit() const { return m_limit.load(std::memory_order_relaxed); }
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Reservations
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @return True if @p bytes were reserved without exceeding the cap
+    bool tryReserve(ByteCount bytes);
+
+    /// @brief Reserve @p bytes even past the cap
+    void reserve(ByteCount bytes);
+
+    /// @brief Return bytes taken by tryReserve() or reserve()
+    void release(ByteCount bytes);
+
+    /// @return True if @p bytes would fit right now
+    bool hasRoom(ByteCount bytes) const;
+
+    /**
+     * @brief Wait for memory without blocking a thread
+     * @return False if @p bytes fit now (nothing is parked); true if
+     *         @p waker will run once after the next release()
+     */
+    bool park(ByteCount bytes, Waker waker);
+
+    /**
+     * @brief Block a pooled thread until a release() or @p timeout
+     * @return True if @p bytes fit afterwards
+     */
+    bool wait(ByteCount bytes, Duration timeout);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Statistics
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @return Bytes buffered now
+    ByteCount used() const { return m_used.load(std::memory_order_relaxed); }
+
+    /// @return Most bytes buffered at once since start
+    ByteCount peak() const { return m_peak.load(std::memory_order_relaxed); }
+
+    /// @return Times a transfer was paused for memory
+    uint64_t pauses() const { return m_pauses.load(std::memory_order_relaxed); }
+
+    /// @brief Count a transfer paused for memory without parking (it polls)
+    void addPause() { m_pauses.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    MemoryBudget() = default;
+
+    void notePeak(ByteCount used);
+    void wake();
+
+    std::atomic<ByteCount> m_limit{static_cast<ByteCount>(Constants::DEFAULT_MEMORY_BUDGET_MB) * 1024 * 1024};
+    std::atomic<ByteCount> m_used{0};
+    std::atomic<ByteCount> m_peak{0};
+    std::atomic<uint64_t> m_pauses{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    std::vector<Waker> m_wakers;
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,48 @@
+/**
+ * @file Metalink.h
+ * @brief Metalink (RFC 5854 and 3.0) parsing for multi-source downloads
+ *
+ * A Metalink file lists, per file, its size, digests and the mirrors that
+ * serve it. DownloadManager::addMetalink() turns each entry into a task
+ * with those mirrors (SourceSet) and the strongest digest as its expected
+ * hash.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+#include "openidm/engine/Checksum.h"
+
+#include <vector>
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+namespace OpenIDM {
+
+/**
+ * @brief One <file> entry of a Metalink document
+ */
+struct MetalinkFile {
+    QString name;               ///< Relative path suggested by the document
+    ByteCount size = -1;        ///< -1 if not given
+    ExpectedHash hash;          ///< Strongest whole-file digest listed
+    QList<QUrl> urls;           ///< HTTP(S) mirrors, most preferred first
+
+    bool isValid() const { return !urls.isEmpty(); }
+};
+
+/**
+ * @brief Parse a Metalink 4 (RFC 5854) or Metalink 3.0 document
+ *
+ * Mirrors are ordered by `priority` (v4, lower first) or `preference`
+ * (v3, higher first); non-HTTP(S) resources are skipped, so are file names
+ * that would escape the destination directory.
+ *
+ * @return Files with at least one usable URL; empty if the XML is invalid
+ */
+std::vector<MetalinkFile> parseMetalink(const QByteArray& document);
+
+} // namespace OpenIDM
@@ -0,0 +1,57 @@
+/**
+ * @file MetricsServer.h
+ * @brief Minimal HTTP endpoint serving EngineMetrics to Prometheus
+ *
+ * Answers `GET /metrics` with EngineMetrics::render() and everything else
+ * with 404. The sockets live on a thread of their own, so a scrape never
+ * waits for the GUI event loop and a busy GUI never delays a scrape.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+
+namespace OpenIDM {
+
+class MetricsListener;
+
+/**
+ * @class MetricsServer
+ * @brief Scrape endpoint, off unless a metrics port is configured
+ *
+ * Responses close the connection; scrapers open one per scrape anyway.
+ *
+ * Thread Safety:
+ * - Call the public methods from the owning thread
+ */
+class MetricsServer : public QObject {
+public:
+    explicit MetricsServer(QObject* parent = nullptr);
+    ~MetricsServer() override;
+
+    // Disable copying
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Listen on @p port, replacing any earlier listener
+     * @param port TCP port (0 picks a free one, see port())
+     * @param anyInterface Listen on all interfaces instead of loopback only
+     * @return False if the port could not be bound
+     */
+    bool start(quint16 port, bool anyInterface = false);
+
+    /// Stop listening and drop open connections
+    void stop();
+
+    /// @return Bound port, 0 when not listening
+    quint16 port() const { return m_port; }
+
+private:
+    QThread m_thread;
+    MetricsListener* m_listener{nullptr};
+    quint16 m_port{0};
+};
+
+} // namespace OpenIDM
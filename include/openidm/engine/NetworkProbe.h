@@ -47,6 +47,18 @@ public:
      */
     bool isProbing() const { return m_probing; }
     
+    /**
+     * @brief Read capabilities from a response whose headers have arrived
+     *
+     * Shared with SegmentWorker, whose fast-start request takes them from
+     * the first ranged GET instead of a separate HEAD. A 206 response's
+     * Content-Range supplies the total size and proves range support.
+     *
+     * @param curl Handle the response was received on
+     * @param headers Final (post-redirect) response, from HttpHeaderParser
+     */
+    static ServerCapabilities readCapabilities(CURL* curl, const HttpHeaderInfo& headers);
+    
 signals:
     /**
      * @brief Emitted when probe completes successfully
@@ -62,7 +74,6 @@ signals:
     
 private:
     void performProbe(const QUrl& url);
-    void parseHeaders();
     
     static size_t headerCallback(char* buffer, size_t size, size_t nitems, void* userdata);
     
@@ -71,7 +82,7 @@ private:
     bool m_cancelled{false};
     
     ServerCapabilities m_capabilities;
-    QString m_rawHeaders;
+    HttpHeaderInfo m_headers;
 };
 
 } // namespace OpenIDM
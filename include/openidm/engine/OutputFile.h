@@ -0,0 +1,193 @@
+/**
+ * @file OutputFile.h
+ * @brief Shared, preallocated destination file with positional writes
+ *
+ * All segment workers of a task write straight into one partial file at
+ * their segment's byte offset. Because every byte lands at its final
+ * position, completion is a rename instead of a merge pass over the data.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+
+#include <QString>
+
+namespace OpenIDM {
+
+// Forward declarations
+class ResumeJournal;
+
+/**
+ * @class OutputFile
+ * @brief Native file handle supporting concurrent writes at explicit offsets
+ *
+ * The file is created as `<final path>.part` and renamed to the final path
+ * by finalize(). Writes use pwrite() on POSIX and WriteFile() with an
+ * OVERLAPPED offset on Windows, so they never touch a shared file position.
+ * The DiskWriter thread instead batches writes through FileIo on
+ * writeHandle() and reports each result via completeWrite().
+ *
+ * Thread Safety:
+ * - writeAt() may be called concurrently from any number of workers and
+ *   the DiskWriter thread as long as their byte ranges do not overlap
+ *   (guaranteed by Segment::claim())
+ * - open(), preallocate(), finalize() and close() must be called from the
+ *   owning task's thread while no worker is running
+ */
+class OutputFile {
+public:
+    /**
+     * @brief Construct for a destination path (nothing is opened yet)
+     * @param finalPath Path the completed file will have
+     */
+    explicit OutputFile(QString finalPath);
+
+    ~OutputFile();
+
+    // Disable copying
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Lifecycle
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Open (or reopen for resume) the partial file
+     *
+     * Existing content is kept so resumed segments continue in place.
+     * @return True on success
+     */
+    bool open();
+
+    /**
+     * @brief Reserve disk space for the complete file
+     *
+     * Uses posix_fallocate on Linux, F_PREALLOCATE on macOS and
+     * SetEndOfFile (+ SetFileValidData when the process holds
+     * SE_MANAGE_VOLUME_NAME) on Windows. Falls back to extending the file
+     * when the filesystem cannot preallocate.
+     *
+     * @param size Final file size in bytes
+     * @return False only if the space could not be reserved at all
+     *         (typically a full disk)
+     */
+    bool preallocate(ByteCount size);
+
+    /**
+     * @brief Also open the file with O_DIRECT for aligned writes
+     *
+     * writeAt() then bypasses the page cache whenever offset, length and
+     * buffer address are multiples of Constants::DIRECT_IO_ALIGNMENT (the
+     * full write-behind buffers); other writes use the normal handle.
+     * Linux only; fails harmlessly on filesystems without O_DIRECT.
+     *
+     * @return True if direct I/O is available
+     */
+    bool enableDirectIo();
+
+    /**
+     * @brief Write a block at an absolute file offset
+     * @param offset Absolute byte offset in the file
+     * @param data Data to write
+     * @param length Number of bytes
+     * @return True if all bytes were written
+     */
+    bool writeAt(ByteOffset offset, const char* data, size_t length);
+
+    /**
+     * @brief Account for a write issued through FileIo on writeHandle()
+     *
+     * Records the failure on an error and finishes a short write
+     * synchronously, so callers see the same contract as writeAt().
+     * @param result Completion result (bytes written or negative error code)
+     * @return True if all bytes are now written
+     */
+    bool completeWrite(ByteOffset offset, const char* data, size_t length, int64_t result);
+
+    /**
+     * @brief Flush written data to stable storage, keeping the file open
+     * @return True on success
+     */
+    bool sync();
+
+    /**
+     * @brief Flush to stable storage and close, keeping the partial file
+     *
+     * Lets the complete download be verified before finalize() publishes it.
+     * @return True on success
+     */
+    bool seal();
+
+    /**
+     * @brief Rename the partial file to the final path
+     *
+     * Seals the file first if it is still open. Any existing file at the
+     * final path is replaced atomically.
+     * @return True on success
+     */
+    bool finalize();
+
+    /**
+     * @brief Close the handle, keeping the partial file for resume
+     */
+    void close();
+
+    /**
+     * @brief Close the handle and delete the partial file
+     */
+    void discard();
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Accessors
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @return True if the native handle is open
+    bool isOpen() const;
+
+    /**
+     * @brief Native handle a positional write of this block should use
+     *
+     * The O_DIRECT twin for aligned blocks, the normal handle otherwise.
+     * On Windows the handle is opened FILE_FLAG_OVERLAPPED for IOCP.
+     */
+    qintptr writeHandle(ByteOffset offset, const char* data, size_t length) const;
+
+    /// @return True once any write failed (checked by workers, set by any thread)
+    bool hasFailed() const { return m_failed.load(std::memory_order_acquire); }
+
+    /// @return Path of the completed file
+    QString finalPath() const { return m_finalPath; }
+
+    /// @return Path of the partial file being written
+    QString partialPath() const { return m_finalPath + QStringLiteral(".part"); }
+
+    /// @return Human-readable description of the last failure
+    QString errorString() const { return m_errorString; }
+
+    /// @return Journal notified of every completed write, or nullptr
+    ResumeJournal* journal() const { return m_journal; }
+
+    /// @brief Attach the resume journal (not owned; set while no worker runs)
+    void setJournal(ResumeJournal* journal) { m_journal = journal; }
+
+private:
+    void setSystemError(const char* operation);
+
+    QString m_finalPath;
+    QString m_errorString;
+    std::atomic<bool> m_failed{false};
+    ResumeJournal* m_journal{nullptr};
+
+#ifdef Q_OS_WIN
+    void* m_handle{nullptr};    // HANDLE, kept opaque to avoid <windows.h>
+#else
+    int m_fd{-1};
+    int m_directFd{-1};         // O_DIRECT twin of m_fd, -1 if unused
+#endif
+};
+
+} // namespace OpenIDM
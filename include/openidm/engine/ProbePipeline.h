@@ -0,0 +1,132 @@
+/**
+ * @file ProbePipeline.h
+ * @brief Concurrent metadata probing for bulk imports
+ *
+ * A task normally probes its server only when it starts, so a list of
+ * thousands of URLs sits in the queue with unknown sizes. The pipeline
+ * probes queued tasks ahead of time over one curl multi handle on its own
+ * thread, bounded globally and per host, and hands the results back to the
+ * GUI thread in batches.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <QObject>
+#include <QUrl>
+
+// Forward declare CURL types
+typedef void CURL;
+typedef void CURLM;
+
+namespace OpenIDM {
+
+/**
+ * @class ProbePipeline
+ * @brief Bounded-concurrency HEAD probes for many URLs
+ *
+ * Requests are grouped by host and started round-robin, at most
+ * Constants::PROBE_CONCURRENCY at once and Constants::PROBE_PER_HOST per
+ * host. Each is a HEAD; servers that refuse HEAD (405/501) get a
+ * `Range: bytes=0-0` GET instead. Headers are read with
+ * NetworkProbe::readCapabilities(), so results match a task's own probe.
+ *
+ * Thread Safety:
+ * - enqueue(), cancel() and pendingCount() from any thread
+ * - Signals are emitted on the pipeline's (GUI) thread, once per result
+ */
+class ProbePipeline : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ProbePipeline(QObject* parent = nullptr);
+    ~ProbePipeline() override;
+
+    // Disable copying
+    ProbePipeline(const ProbePipeline&) = delete;
+    ProbePipeline& operator=(const ProbePipeline&) = delete;
+
+    struct Request {
+        TaskId id;
+        QUrl url;
+    };
+
+    /**
+     * @brief Queue URLs for probing; starts the probe thread on first use
+     */
+    void enqueue(std::vector<Request> requests);
+
+    /**
+     * @brief Drop a request that has not started yet
+     *
+     * Used when the task starts before its turn; a probe already in flight
+     * still completes and its result is ignored by the task
+     * (DownloadTask::applyPrefetchedCapabilities()).
+     */
+    void cancel(const TaskId& id);
+
+    /// @return Requests queued or in flight
+    size_t pendingCount() const { return m_pendingCount.load(std::memory_order_relaxed); }
+
+signals:
+    /// Emitted with the capabilities of a probed URL
+    void probed(const TaskId& id, const ServerCapabilities& capabilities);
+
+    /// Emitted when a URL could not be probed
+    void probeFailed(const TaskId& id, const DownloadError& error);
+
+private:
+    struct Transfer {
+        Request request;
+        QString host;
+        HttpHeaderInfo headers;     ///< Final response only
+        QByteArray urlBytes;
+        bool rangedGet{false};      ///< HEAD was refused
+    };
+
+    struct Result {
+        TaskId id;
+        bool ok{false};
+        ServerCapabilities capabilities;
+        DownloadError error;
+    };
+
+    // Probe thread
+    void run();
+    void startTransfers(std::vector<Result>& results);
+    void startTransfer(std::unique_ptr<Transfer> transfer, std::vector<Result>& results);
+    void finishTransfer(CURL* easy, int curlCode, std::vector<Result>& results);
+    void releaseTransfer(CURL* easy);
+
+    // GUI thread
+    void deliver(const std::vector<Result>& results);
+
+    static size_t headerCallback(char* buffer, size_t size, size_t nitems, void* userdata);
+    static size_t discardCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+
+    std::thread m_thread;
+    CURLM* m_multi{nullptr};
+    std::atomic<bool> m_running{false};
+    std::atomic<size_t> m_pendingCount{0};
+
+    // Shared with enqueue()/cancel(), guarded by m_mutex
+    std::map<QString, std::deque<Request>> m_pendingByHost;
+    mutable std::mutex m_mutex;
+
+    // Probe thread only
+    std::unordered_map<CURL*, std::unique_ptr<Transfer>> m_active;
+    std::map<QString, size_t> m_activePerHost;
+    QString m_lastHost;             ///< Round-robin cursor over m_pendingByHost
+};
+
+} // namespace OpenIDM
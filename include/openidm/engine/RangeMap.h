@@ -0,0 +1,115 @@
+/**
+ * @file RangeMap.h
+ * @brief Run-length map of a file's pending, in-flight and completed bytes
+ *
+ * A RangeMap tiles [0, size) with maximal runs of one state. Adjacent
+ * pending or completed runs merge as they are written, so a file that was
+ * split into hundreds of segments and finished collapses back into a
+ * single completed run. A size-ordered index per state answers "largest
+ * pending gap" or "largest in-flight range" in O(log n).
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <array>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace OpenIDM {
+
+/**
+ * @enum RangeState
+ * @brief What the map knows about a byte
+ */
+enum class RangeState : uint8_t {
+    Pending,        ///< Not downloaded and not assigned
+    InFlight,       ///< Assigned to a segment that is downloading it
+    Completed       ///< Received
+};
+
+/**
+ * @class RangeMap
+ * @brief Interval map with coalescing and largest-range lookup
+ *
+ * In-flight runs carry the owning segment and only merge with runs of
+ * the same owner, so each active segment keeps a run of its own.
+ *
+ * assign() is O((k + 1) log n) for k runs overwritten; largest() and
+ * bytes() are O(log n) and O(1).
+ *
+ * Thread Safety:
+ * - None; the owner serializes access
+ */
+class RangeMap {
+public:
+    struct Range {
+        ByteOffset start{0};
+        ByteOffset end{-1};             ///< Inclusive
+        RangeState state{RangeState::Pending};
+        SegmentId owner{0};             ///< In-flight runs only
+
+        ByteCount length() const { return end - start + 1; }
+    };
+
+    RangeMap() = default;
+
+    /// @brief Cover [0, @p size) with one pending run; an unknown size empties the map
+    void reset(ByteCount size);
+
+    /// @brief Forget everything
+    void clear() { reset(0); }
+
+    /// @return Bytes covered (the file size passed to reset())
+    ByteCount size() const { return m_size; }
+
+    /**
+     * @brief Set [@p start, @p end] to @p state
+     *
+     * The range is clipped to the map; neighbours that end up with the
+     * same state (and owner, for in-flight runs) are merged.
+     */
+    void assign(ByteOffset start, ByteOffset end, RangeState state, SegmentId owner = 0);
+
+    /// @return Longest run in @p state (the last of equally long ones), if any
+    std::optional<Range> largest(RangeState state) const;
+
+    /// @return Total bytes in @p state
+    ByteCount bytes(RangeState state) const { return m_bytes[index(state)]; }
+
+    /// @return Number of runs; 1 for a finished file
+    size_t runCount() const { return m_runs.size(); }
+
+    /// @return All runs in file order
+    std::vector<Range> ranges() const;
+
+    /// @return Runs in @p state, in file order
+    std::vector<Range> ranges(RangeState state) const;
+
+private:
+    struct Run {
+        ByteOffset end;
+        RangeState state;
+        SegmentId owner;
+    };
+    using Runs = std::map<ByteOffset, Run>;
+
+    static constexpr size_t index(RangeState state) { return static_cast<size_t>(state); }
+    static bool mergeable(const Run& a, const Run& b);
+
+    Runs::iterator insertRun(ByteOffset start, const Run& run);
+    void eraseRun(Runs::iterator it);
+    void splitAt(ByteOffset position);
+    void coalesce(Runs::iterator it);
+
+    Runs m_runs;
+    std::array<std::set<std::pair<ByteCount, ByteOffset>>, 3> m_bySize; ///< (length, start)
+    std::array<ByteCount, 3> m_bytes{};
+    ByteCount m_size{0};
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,170 @@
+/**
+ * @file ResumeJournal.h
+ * @brief Per-download, memory-mapped, append-only resume journal
+ *
+ * SQLite keeps the coarse task and segment layout; fine-grained progress
+ * lives in a small `<file>.part.journal` next to the partial file. Every
+ * buffer that reaches the file appends one fixed-size record (segment id,
+ * durable byte, CRC32C of the segment prefix) to a mapped page, which costs
+ * a memcpy instead of a database transaction.
+ *
+ * Records written right after the data file was flushed are marked synced.
+ * On recovery only the bytes between a segment's last synced record and its
+ * latest record are read back and checked against the recorded CRC; whole
+ * segments are never downloaded again because of a crash.
+ */
+
+#pragma once
+
+#include "openidm/engine/Segment.h"
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+namespace OpenIDM {
+
+// Forward declarations
+class OutputFile;
+
+/**
+ * @class ResumeJournal
+ * @brief Append-only log of durable segment progress
+ *
+ * The journal holds Constants::RESUME_JOURNAL_RECORDS slots; when they run
+ * out it is compacted to the latest synced and latest record per segment.
+ * It is deleted once the download completes.
+ *
+ * Thread Safety:
+ * - recordWrite(), requestCheckpoint() and checkpoint() are thread-safe
+ *   (called by the DiskWriter thread and by write-through workers)
+ * - open() and discard() must be called while nothing writes to the file
+ */
+class ResumeJournal {
+public:
+    /**
+     * @brief Construct for a journal path (nothing is opened yet)
+     */
+    explicit ResumeJournal(QString path);
+
+    ~ResumeJournal();
+
+    // Disable copying
+    ResumeJournal(const ResumeJournal&) = delete;
+    ResumeJournal& operator=(const ResumeJournal&) = delete;
+
+    /// @return Journal path used for a partial file
+    static QString pathFor(const QString& partialPath) { return partialPath + QStringLiteral(".journal"); }
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Lifecycle
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Start a fresh journal describing the current segment layout
+     *
+     * Any previous journal is replaced. The current progress of every
+     * segment is recorded as synced, so the caller must have flushed the
+     * data file (or verified it via recover()) beforehand.
+     *
+     * @param totalSize Size of the complete file
+     * @param segments Current segment layout
+     * @return True if the journal is mapped and usable
+     */
+    bool open(ByteCount totalSize, const std::vector<Segment*>& segments);
+
+    /**
+     * @brief Unmap and delete the journal (download finished or discarded)
+     */
+    void discard();
+
+    /// @return True while the journal is mapped
+    bool isOpen() const { return m_map != nullptr; }
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Recording
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Record that a block of a segment has been written to the file
+     *
+     * Blocks arriving in order extend the segment's durable byte and CRC.
+     * An out-of-order block (hedged write-through) stops extending the CRC
+     * and falls back to Segment::resumeByte() for the durable byte.
+     */
+    void recordWrite(const Segment& segment, ByteOffset offset, const char* data, size_t length);
+
+    /// @brief Ask the DiskWriter to run checkpoint() after its next batch for this file
+    void requestCheckpoint() { m_checkpointRequested.store(true, std::memory_order_release); }
+
+    /// @return True (once) if a checkpoint was requested
+    bool takeCheckpointRequest() { return m_checkpointRequested.exchange(false, std::memory_order_acq_rel); }
+
+    /**
+     * @brief Flush the data file and mark the progress up to now as synced
+     *
+     * Progress is sampled before the flush, so every synced record covers
+     * bytes that were on stable storage when it was written.
+     * @return True if both the data file and the journal were flushed
+     */
+    bool checkpoint(OutputFile& file);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Recovery
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Rebuild the segment layout of an interrupted download
+     *
+     * Segments found in the journal resume from their latest record whose
+     * tail re-verifies against the partial file, or else from their last
+     * synced record. Segments only SQLite knows about keep @p snapshots'
+     * progress. Overlaps left by work-stealing splits are trimmed and gaps
+     * are filled with fresh pending segments.
+     *
+     * @param journalPath Journal of the download (may not exist)
+     * @param dataPath Partial file the journal describes
+     * @param totalSize Current size of the complete file
+     * @param snapshots Coarse segment state loaded from SQLite
+     * @return Layout covering [0, totalSize), or empty if nothing is usable
+     */
+    static std::vector<Segment::Snapshot> recover(const QString& journalPath, const QString& dataPath,
+                                                  ByteCount totalSize,
+                                                  std::vector<Segment::Snapshot> snapshots);
+
+private:
+    /**
+     * @brief Progress known for one segment
+     */
+    struct Entry {
+        ByteOffset startByte{0};
+        ByteOffset endByte{0};
+        ByteOffset durableByte{0};      ///< Everything before this is in the file
+        uint32_t crc{0};                ///< CRC32C of [startByte, durableByte)
+        bool crcValid{true};
+    };
+
+    bool rewrite(ByteCount totalSize);
+    bool append(SegmentId id, const Entry& entry, bool synced);
+    void unmap();
+    bool flushMap();
+
+    QString m_path;
+    QFile m_file;
+    uchar* m_map{nullptr};
+    uint32_t m_capacity{0};             ///< Record slots in the mapping
+    uint32_t m_count{0};                ///< Slots used
+    ByteCount m_totalSize{0};
+
+    std::map<SegmentId, Entry> m_entries;           ///< Latest progress
+    std::map<SegmentId, Entry> m_synced;            ///< Progress at the last checkpoint
+    std::mutex m_mutex;
+    std::atomic<bool> m_checkpointRequested{false};
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,74 @@
+/**
+ * @file RetryWheel.h
+ * @brief Hashed timer wheel holding failed segments until their retry is due
+ *
+ * A failed segment used to go straight back to the pending queue, where
+ * the worker that just failed on it usually picked it up again at once.
+ * With backoff, the segment instead waits in the wheel with a not-before
+ * time while the worker moves on to other work; the scheduler advances the
+ * wheel on a coarse tick and requeues whatever is due.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <chrono>
+#include <vector>
+
+namespace OpenIDM {
+
+// Forward declarations
+class Segment;
+
+/**
+ * @class RetryWheel
+ * @brief Fixed-tick timer wheel of segments
+ *
+ * Deadlines are rounded up to the next tick and hashed into one of
+ * RETRY_WHEEL_SLOTS slots; entries further out than one revolution stay in
+ * their slot until their tick comes round. schedule() is O(1), advance()
+ * touches only the slots it passes.
+ *
+ * Thread Safety:
+ * - None; the owner serializes access
+ */
+class RetryWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// @param origin Tick 0; tests pass a fixed one to place deadlines exactly
+    explicit RetryWheel(Clock::time_point origin = Clock::now());
+
+    /// @brief Hold @p segment until @p notBefore (at least one tick from now)
+    void schedule(Segment* segment, Clock::time_point notBefore);
+
+    /**
+     * @brief Move the wheel to @p now
+     * @return Segments whose time has come, earliest first
+     */
+    std::vector<Segment*> advance(Clock::time_point now);
+
+    /// @brief Drop every entry
+    void clear();
+
+    /// @return Segments waiting
+    size_t size() const { return m_size; }
+
+    bool empty() const { return m_size == 0; }
+
+private:
+    struct Entry {
+        Segment* segment;
+        uint64_t tick;                  ///< Absolute tick the entry is due at
+    };
+
+    uint64_t tickOf(Clock::time_point time) const;
+
+    std::vector<std::vector<Entry>> m_slots;
+    Clock::time_point m_origin;
+    uint64_t m_current{0};              ///< Last tick advanced to
+    size_t m_size{0};
+};
+
+} // namespace OpenIDM
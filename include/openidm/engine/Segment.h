@@ -3,14 +3,17 @@
  * @brief Segment data structure for download chunk management
  * 
  * A Segment represents a contiguous byte range of a download file.
- * Multiple segments are downloaded in parallel and merged upon completion.
+ * Multiple segments are downloaded in parallel, each written in place into
+ * the shared output file at its own byte offset.
  */
 
 #pragma once
 
 #include "openidm/engine/Types.h"
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <QFile>
 
@@ -24,7 +27,10 @@ namespace OpenIDM {
  * - Has a fixed start and (adjustable) end byte position
  * - Maintains atomic progress tracking for thread-safe updates
  * - Can be split into smaller segments for work-stealing
- * - Stores a rolling checksum for corruption detection
+ * - Stores a rolling CRC32C that combines into the whole-file CRC
+ * 
+ * The temp path and last error are kept out of line and only allocated
+ * when set, so a fresh segment is a few atomics and offsets.
  * 
  * Thread Safety:
  * - currentByte and state are atomic for lock-free progress updates
@@ -111,12 +117,34 @@ public:
         return m_currentByte.fetch_add(bytes, std::memory_order_relaxed) + bytes;
     }
     
+    /**
+     * @brief Claim received bytes for writing
+     *
+     * Several workers may stream the same range (end-game hedging). Each
+     * tracks its own stream position; the segment's current byte is the
+     * shared frontier. Only the part of [streamPos, streamPos + length)
+     * beyond the frontier is claimed, so no byte is written twice.
+     *
+     * @param streamPos Absolute offset of the caller's data
+     * @param length Number of bytes received
+     * @param[out] claimStart Absolute offset the claimed bytes start at
+     * @return Number of bytes the caller must write (0 = already covered)
+     */
+    ByteCount claim(ByteOffset streamPos, ByteCount length, ByteOffset* claimStart);
+    
     /**
      * @brief Adjust the end byte (for work-stealing splits)
      * @param newEnd New end byte position (must be >= currentByte)
      */
     void setEndByte(ByteOffset newEnd);
     
+    /**
+     * @brief Give an open-ended segment its end once the file size is known
+     * @param end Last byte of the segment
+     * @return False if the segment already had an end
+     */
+    bool resolveEnd(ByteOffset end);
+    
     // ───────────────────────────────────────────────────────────────────────
     // State Management
     // ───────────────────────────────────────────────────────────────────────
@@ -159,31 +187,71 @@ public:
     // Integrity & Checksum
     // ───────────────────────────────────────────────────────────────────────
     
-    /// @return Current CRC32 checksum of downloaded data
-    uint32_t checksum() const { return m_checksum; }
+    /// @brief A rolling checksum and the offset it has reached, read together
+    struct ChecksumRange {
+        uint32_t crc{0};                ///< CRC32C of [startByte(), end)
+        ByteOffset end{0};
+        bool broken{false};             ///< Data arrived out of order; crc is incomplete for good
+        
+        /// @return True if crc covers exactly [startByte(), @p offset)
+        bool reaches(ByteOffset offset) const { return !broken && end == offset; }
+    };
+    
+    /**
+     * @brief Read the checksum and its end as one consistent pair
+     *
+     * updateChecksum() publishes both under a sequence counter, so a
+     * reader on another thread (persistence, the resume journal) never
+     * pairs a new end with an old CRC.
+     */
+    ChecksumRange checksumRange() const;
+    
+    /// @return CRC32C of the bytes from startByte() up to the checksum end
+    uint32_t checksum() const { return checksumRange().crc; }
     
     /**
-     * @brief Update rolling checksum with new data
+     * @brief Extend the rolling CRC32C with data received at an offset
+     *
+     * Only data continuing exactly where the checksum ends extends it. Any
+     * other offset (a resumed segment, a hedged twin) leaves the checksum
+     * incomplete for good; the file-level CRC then reads the file instead.
+     *
+     * @param offset Absolute file offset of data[0]
      * @param data Pointer to data buffer
      * @param size Size of data
      */
-    void updateChecksum(const char* data, size_t size);
+    void updateChecksum(ByteOffset offset, const char* data, size_t size);
+    
+    /// @return True if checksum() covers every byte of the segment
+    bool hasCompleteChecksum() const {
+        return checksumReaches(m_endByte + 1);
+    }
+    
+    /// @return True if checksum() covers exactly [startByte(), end)
+    bool checksumReaches(ByteOffset end) const {
+        return checksumRange().reaches(end);
+    }
     
     /// @brief Reset checksum to initial value
-    void resetChecksum() { m_checksum = 0; }
+    void resetChecksum() {
+        publishChecksum(0, m_startByte);
+        m_checksumBroken.store(false, std::memory_order_release);
+    }
     
     // ───────────────────────────────────────────────────────────────────────
     // Temporary File
     // ───────────────────────────────────────────────────────────────────────
     
     /// @return Path to segment's temporary file
-    QString tempFilePath() const { return m_tempFilePath; }
+    QString tempFilePath() const { return m_notes ? m_notes->tempFilePath : QString(); }
     
     /**
      * @brief Set temporary file path
      * @param path Full path to temp file
      */
-    void setTempFilePath(const QString& path) { m_tempFilePath = path; }
+    void setTempFilePath(const QString& path) {
+        if (m_notes || !path.isEmpty()) notes().tempFilePath = path;
+    }
     
     // ───────────────────────────────────────────────────────────────────────
     // Error Handling & Retry
@@ -202,13 +270,15 @@ public:
     bool canRetry() const { return m_retryCount < Constants::MAX_RETRIES; }
     
     /// @return Last error message
-    QString lastError() const { return m_lastError; }
+    QString lastError() const { return m_notes ? m_notes->lastError : QString(); }
     
     /**
      * @brief Record an error
      * @param message Error description
      */
-    void setLastError(const QString& message) { m_lastError = message; }
+    void setLastError(const QString& message) {
+        if (m_notes || !message.isEmpty()) notes().lastError = message;
+    }
     
     // ───────────────────────────────────────────────────────────────────────
     // Work Stealing
@@ -233,7 +303,81 @@ public:
      * @param newId ID for the new segment
      * @return New segment covering second half, or nullopt if not splittable
      */
-    std::unique_ptr<Segment> split(SegmentId newId);
+    std::optional<Segment> split(SegmentId newId);
+    
+    /**
+     * @brief Split this segment at @p position
+     * 
+     * The position is aligned down to CHUNK_SIZE and kept at least
+     * MIN_STEAL_SIZE away from both the current byte and the end.
+     * 
+     * @param newId ID for the new segment
+     * @param position First byte of the new segment
+     * @return New segment from the split point to the original end, or
+     *         nullopt if either side would be too small
+     */
+    std::optional<Segment> splitAt(SegmentId newId, ByteOffset position);
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Hedging
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /// @brief Register a worker streaming this segment
+    void addWriter() { m_writers.fetch_add(1, std::memory_order_acq_rel); }
+    
+    /**
+     * @brief Register a duplicate (hedged) writer
+     *
+     * Records the durable offset at this point: once two writers interleave
+     * write-through and write-behind data, only that offset is known to be
+     * on disk, and snapshots use it for the rest of the segment's life.
+     */
+    void addHedgeWriter() {
+        m_hedgeDurable.store(durableByte(), std::memory_order_relaxed);
+        m_checksumBroken.store(true, std::memory_order_release);  // Two writers interleave
+        addWriter();
+    }
+    
+    /// @return Number of workers still streaming after removing one
+    int removeWriter() { return m_writers.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+    
+    /// @return Number of workers currently streaming this segment
+    int writerCount() const { return m_writers.load(std::memory_order_acquire); }
+    
+    /// @return True while a duplicate request races the primary one
+    bool isHedged() const { return writerCount() > 1; }
+    
+    // ───────────────────────────────────────────────────────────────────────
+    // Write-behind
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /// @brief Account bytes not in the file yet; called before claim() moves the frontier
+    void addPendingWrite(ByteCount bytes) { m_pendingWrite.fetch_add(bytes, std::memory_order_relaxed); }
+    
+    /// @brief Account bytes the disk writer has written
+    void completePendingWrite(ByteCount bytes) { m_pendingWrite.fetch_sub(bytes, std::memory_order_release); }
+    
+    /// @return Claimed bytes not yet written to the file
+    ByteCount pendingWriteBytes() const { return m_pendingWrite.load(std::memory_order_acquire); }
+    
+    /**
+     * @brief Offset up to which data has reached the file
+     *
+     * Write-behind buffers of a single writer are flushed in order, so the
+     * bytes still in flight are always the highest claimed ones. Writers
+     * count bytes as pending before claiming them, so the frontier read
+     * here never includes a claim that is missing from the pending count.
+     */
+    ByteOffset durableByte() const {
+        ByteOffset frontier = m_currentByte.load(std::memory_order_acquire);
+        return frontier - pendingWriteBytes();
+    }
+    
+    /// @return Offset a persisted snapshot may safely resume from
+    ByteOffset resumeByte() const {
+        ByteOffset hedged = m_hedgeDurable.load(std::memory_order_relaxed);
+        return hedged >= 0 ? std::min(durableByte(), hedged) : durableByte();
+    }
     
     // ───────────────────────────────────────────────────────────────────────
     // HTTP Range Header
@@ -253,6 +397,9 @@ public:
     
     /**
      * @brief Create a snapshot of current state for persistence
+     *
+     * Records resumeByte(), so bytes still in write-behind buffers are
+     * downloaded again after a crash instead of leaving a hole.
      * @return Copy-safe data for database storage
      */
     struct Snapshot {
@@ -265,6 +412,7 @@ public:
         QString tempFilePath;
         int retryCount;
         QString lastError;
+        bool checksumValid{false};      ///< checksum covers [startByte, currentByte)
     };
     
     Snapshot snapshot() const;
@@ -276,6 +424,23 @@ public:
     void restore(const Snapshot& snap);
     
 private:
+    /// Rarely set, so not worth carrying in every segment
+    struct Notes {
+        QString tempFilePath;
+        QString lastError;
+    };
+    
+    /// @brief Store a checksum and its end for checksumRange() (single writer)
+    void publishChecksum(uint32_t crc, ByteOffset end);
+    
+    /// @brief Return a moved-from segment to the default state
+    void resetMovedFrom();
+    
+    Notes& notes() {
+        if (!m_notes) m_notes = std::make_unique<Notes>();
+        return *m_notes;
+    }
+    
     // Identification
     SegmentId m_id{0};
     
@@ -286,25 +451,21 @@ private:
     // Progress tracking (atomic for thread-safe updates)
     std::atomic<ByteOffset> m_currentByte{0};
     std::atomic<SegmentState> m_state{SegmentState::Pending};
+    std::atomic<int> m_writers{0};      ///< Transient, not persisted
+    std::atomic<ByteCount> m_pendingWrite{0};
+    std::atomic<ByteOffset> m_hedgeDurable{-1};     ///< -1 = never hedged
     
-    // Integrity
-    uint32_t m_checksum{0};
-    
-    // Temporary storage
-    QString m_tempFilePath;
+    // Integrity (one writer at a time; readers go through checksumRange())
+    std::atomic<uint32_t> m_checksumSeq{0};        ///< Odd while an update is in progress
+    std::atomic<uint32_t> m_checksum{0};           ///< CRC32C of [m_startByte, m_checksumEnd)
+    std::atomic<ByteOffset> m_checksumEnd{0};
+    std::atomic<bool> m_checksumBroken{false};
     
     // Error handling
     int m_retryCount{0};
-    QString m_lastError;
+    
+    // Temp path and last error, allocated on first use
+    std::unique_ptr<Notes> m_notes;
 };
 
-/**
- * @brief Calculate CRC32 checksum
- * @param data Input data
- * @param size Data size
- * @param previousCrc Previous checksum for rolling calculation
- * @return Updated CRC32 value
- */
-uint32_t calculateCRC32(const char* data, size_t size, uint32_t previousCrc = 0);
-
 } // namespace OpenIDM
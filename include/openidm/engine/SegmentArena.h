@@ -0,0 +1,101 @@
+/**
+ * @file SegmentArena.h
+ * @brief Per-task segment storage and a column copy of the hot fields
+ *
+ * A download that is stolen from and rebalanced a few hundred times used
+ * to make as many small heap allocations, scattered wherever the
+ * allocator had room. SegmentArena places segments side by side in slabs
+ * of Constants::SEGMENT_SLAB_SIZE that live as long as the scheduler, so
+ * a split costs no allocation once a slab has room and scans over all
+ * segments stay within a few cache-friendly blocks.
+ *
+ * SegmentTable holds what the UI and stats readers look at (range,
+ * frontier, state) as one array per field. The scheduler refreshes its
+ * table on every throughput sample; readers copy it into a table they
+ * keep, which is a memcpy per column and no allocation once the
+ * columns are large enough.
+ */
+
+#pragma once
+
+#include "openidm/engine/Segment.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace OpenIDM {
+
+/**
+ * @class SegmentArena
+ * @brief Slab allocator for a scheduler's segments
+ *
+ * Segments are only created, never freed one at a time: the scheduler
+ * keeps every segment until the layout is rebuilt, and clear() then
+ * destroys them all but keeps the slabs for the next layout. Addresses
+ * are stable for a segment's whole life.
+ *
+ * Thread Safety:
+ * - None; the scheduler creates and clears under its own lock
+ */
+class SegmentArena {
+public:
+    SegmentArena() = default;
+    ~SegmentArena() { clear(); }
+
+    SegmentArena(const SegmentArena&) = delete;
+    SegmentArena& operator=(const SegmentArena&) = delete;
+
+    /// @return A segment constructed in place from @p args
+    template <typename... Args>
+    Segment* create(Args&&... args) {
+        return ::new (nextSlot()) Segment(std::forward<Args>(args)...);
+    }
+
+    /// @brief Destroy every segment, keeping the slabs
+    void clear();
+
+    /// @return Segments alive
+    size_t size() const { return m_used; }
+
+    /// @return Segments that fit before another slab is needed
+    size_t capacity() const { return m_slabs.size() * Constants::SEGMENT_SLAB_SIZE; }
+
+private:
+    struct Slab {
+        alignas(Segment) std::byte storage[sizeof(Segment) * Constants::SEGMENT_SLAB_SIZE];
+    };
+
+    void* nextSlot();
+    Segment* slot(size_t index) const;
+
+    std::vector<std::unique_ptr<Slab>> m_slabs;
+    size_t m_used{0};
+};
+
+/**
+ * @brief Hot fields of a scheduler's segments, one array per field
+ *
+ * Row i of every column describes the same segment, in creation order.
+ * Assigning one table to another reuses the target's columns, so a
+ * reader that keeps its table copies without allocating.
+ */
+struct SegmentTable {
+    std::vector<SegmentId> ids;
+    std::vector<ByteOffset> starts;
+    std::vector<ByteOffset> currents;   ///< Claimed frontier as of the refresh
+    std::vector<ByteOffset> ends;       ///< Inclusive; below starts[i] while the size is unknown
+    std::vector<SegmentState> states;
+
+    size_t size() const { return ids.size(); }
+
+    /// @brief Resize every column to @p rows
+    void resize(size_t rows);
+
+    /// @return Rows in @p state
+    size_t count(SegmentState state) const;
+};
+
+} // namespace OpenIDM
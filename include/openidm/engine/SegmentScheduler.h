@@ -11,17 +11,23 @@
 
 #include "openidm/engine/Types.h"
 #include "openidm/engine/Segment.h"
+#include "openidm/engine/SegmentArena.h"
+#include "openidm/engine/RangeMap.h"
+#include "openidm/engine/RetryWheel.h"
+#include "openidm/engine/TransferTrace.h"
 
 #include <memory>
 #include <vector>
 #include <deque>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <shared_mutex>
 #include <condition_variable>
 #include <functional>
 
 #include <QObject>
+#include <QStringList>
 #include <QTimer>
 
 namespace OpenIDM {
@@ -29,6 +35,7 @@ namespace OpenIDM {
 // Forward declarations
 class SegmentWorker;
 class DownloadTask;
+namespace Bench { class SchedulerSimulator; }
 
 /**
  * @class SegmentScheduler
@@ -39,7 +46,9 @@ class DownloadTask;
  * 2. Work-stealing when workers finish early
  * 3. Dynamic re-segmentation of slow/large segments
  * 4. Throughput monitoring and rebalancing
- * 5. Thread synchronization for segment state changes
+ * 5. End-game hedging: once too little is left to split, idle workers race
+ *    a duplicate request for the slowest segment's tail
+ * 6. Thread synchronization for segment state changes
  * 
  * Thread Safety:
  * - All public methods are thread-safe
@@ -48,6 +57,8 @@ class DownloadTask;
  */
 class SegmentScheduler : public QObject {
     Q_OBJECT
+    
+    friend class Bench::SchedulerSimulator;  // Drives the timers on a virtual clock
 
 public:
     // ───────────────────────────────────────────────────────────────────────
@@ -57,13 +68,45 @@ public:
     /// Callback for segment completion
     using SegmentCompleteCallback = std::function<void(Segment*)>;
     
+    /**
+     * @brief How a task's segment streams map onto connections
+     *
+     * HTTP/1.1 needs one connection per segment. For HTTP/2 and HTTP/3 the
+     * segments are carried as streams over a few connections, which keeps
+     * parallelism without tripping per-connection (per-IP) CDN limits.
+     */
+    struct ConnectionPlan {
+        size_t connections = 1;                 ///< N connections
+        size_t streamsPerConnection = 1;        ///< M streams each
+        HttpProtocol protocol = HttpProtocol::Http1;
+        
+        size_t totalStreams() const { return connections * streamsPerConnection; }
+        bool isMultiplexed() const { return streamsPerConnection > 1; }
+    };
+    
     /// Worker throughput entry
     struct WorkerStats {
         SegmentWorker* worker;
         Segment* segment;
-        SpeedBps throughput;
-        ByteCount bytesDownloaded;
-        Timestamp lastUpdate;
+        SpeedBps throughput;                    ///< Smoothed, from sampleThroughput()
+        ByteCount bytesDownloaded;              ///< Worker counter at the last sample
+        Timestamp lastUpdate;                   ///< Time of the last sample
+        QString networkInterface;               ///< Local interface/address; empty = default route
+        int slot = 0;                           ///< Stable index, the worker's trace track
+        size_t attempts = 0;                    ///< Transfers finished
+        size_t retries = 0;                     ///< Of those, retries of a failed attempt
+        size_t steals = 0;                      ///< Segments split off another worker's
+        size_t hedges = 0;                      ///< End-game races joined
+        std::chrono::microseconds writeStall{0};///< Total time blocked on the disk
+        TransferAttempt lastAttempt;            ///< Timing breakdown of the latest transfer
+    };
+    
+    /// Per-interface share of the download (multipath aggregation)
+    struct InterfaceStats {
+        QString name;                           ///< As passed to CURLOPT_INTERFACE
+        SpeedBps throughput = 0.0;              ///< Sum over its busy workers
+        size_t workers = 0;                     ///< Workers with a segment on it
+        bool measured = false;                  ///< Carried traffic at least once
     };
     
     // ───────────────────────────────────────────────────────────────────────
@@ -101,6 +144,19 @@ public:
      */
     void restoreSegments(const std::vector<Segment::Snapshot>& snapshots);
     
+    /**
+     * @brief Split a single open-ended segment once the file size is known
+     *
+     * Used by fast start: the first worker is already streaming segment 0
+     * from a `Range: bytes=0-` request. Its end is pulled in to the first
+     * of @p segmentCount ranges and the rest are queued for other workers.
+     *
+     * @param totalSize Total file size in bytes
+     * @param segmentCount Number of segments to end up with
+     * @return False if the scheduler does not hold a single open segment
+     */
+    bool resolveOpenSegment(ByteCount totalSize, size_t segmentCount);
+    
     /**
      * @brief Calculate optimal segment count based on file size
      * @param totalSize File size in bytes
@@ -108,6 +164,14 @@ public:
      */
     static size_t calculateOptimalSegmentCount(ByteCount totalSize);
     
+    /**
+     * @brief Choose "N connections × M streams" for a host
+     * @param caps Probe result (including the negotiated protocol)
+     * @param segmentCount Desired number of parallel segments
+     * @return Connection plan; totalStreams() is the worker count to start
+     */
+    static ConnectionPlan planConnections(const ServerCapabilities& caps, size_t segmentCount);
+    
     // ───────────────────────────────────────────────────────────────────────
     // Segment Access
     // ───────────────────────────────────────────────────────────────────────
@@ -137,6 +201,35 @@ public:
      */
     std::vector<Segment*> segmentsInState(SegmentState state) const;
     
+    /// @return Number of segments in @p state, without building a list
+    size_t countInState(SegmentState state) const;
+    
+    /**
+     * @brief Copy the hot-field table into @p out
+     * 
+     * The table is refreshed on every throughput sample and whenever the
+     * layout is rebuilt; segments split since the last sample appear on
+     * the next one. @p out keeps its columns, so a caller that reuses it
+     * copies without allocating.
+     */
+    void copyTable(SegmentTable& out) const;
+    
+    /**
+     * @brief Copy of the byte-range map
+     * 
+     * Completed runs are coalesced; active segments' progress is as of the
+     * last throughput sample.
+     */
+    RangeMap ranges() const;
+    
+    /**
+     * @brief Snapshots for persistence, with adjacent completed segments merged
+     * 
+     * A download that was split many times is stored as its gaps plus a few
+     * completed runs instead of one row per segment ever created.
+     */
+    std::vector<Segment::Snapshot> compactSnapshots() const;
+    
     // ───────────────────────────────────────────────────────────────────────
     // Work Distribution
     // ───────────────────────────────────────────────────────────────────────
@@ -149,7 +242,8 @@ public:
      * This method implements the work-stealing algorithm:
      * 1. First, check pending queue for unassigned segments
      * 2. If empty, attempt to steal from the largest active segment
-     * 3. If no work available, return nullptr (worker should wait)
+     * 3. If nothing is splittable, hedge the slowest segment's tail
+     * 4. If no work available, return nullptr (worker should wait)
      */
     Segment* acquireSegment(SegmentWorker* worker);
     
@@ -196,6 +290,14 @@ public:
      */
     void unregisterWorker(SegmentWorker* worker);
     
+    /**
+     * @brief Account a finished transfer to its worker
+     *
+     * Fills in the worker's slot, adds to workerStats() and keeps the
+     * attempt in the task's TransferTrace.
+     */
+    void recordAttempt(SegmentWorker* worker, TransferAttempt attempt);
+    
     /**
      * @brief Get number of active workers
      */
@@ -213,22 +315,60 @@ public:
     void wakeAllWorkers();
     
     /**
-     * @brief Wait for work availability (called by workers)
-     * @param timeout Maximum wait time
-     * @return True if work may be available, false if timeout
+     * @brief Number that changes whenever work may have become available
+     *
+     * Read before trying to acquire a segment and pass to waitForWork(), so
+     * a signal between the failed attempt and the wait is not lost.
      */
-    bool waitForWork(Duration timeout);
+    uint64_t workGeneration() const;
+    
+    /**
+     * @brief Block until there may be work (called by workers)
+     *
+     * Wakes when segments are queued, returned, completed or become worth
+     * hedging, on pause/resume/cancel, and on wakeAllWorkers().
+     *
+     * @param generation Value of workGeneration() before the failed acquire
+     * @return True if work may be available, false if the download has
+     *         nothing left to do or was cancelled
+     */
+    bool waitForWork(uint64_t generation);
+    
+    /**
+     * @brief Source assigned to a worker with its current segment
+     * @return 0 (the task's URL) unless the task has mirrors
+     */
+    SourceId sourceOf(SegmentWorker* worker) const;
+    
+    /**
+     * @brief Spread workers over several local interfaces or addresses
+     *
+     * Each name is given to CURLOPT_INTERFACE ("eth0", "192.0.2.7",
+     * "if!wlan0", "host!name"). Workers are placed like mirrors: by measured
+     * throughput per worker, and kept where they are unless another
+     * interface promises twice as much. An empty list uses the default route.
+     */
+    void setInterfaces(const QStringList& interfaces);
+    
+    /**
+     * @brief Interface assigned to a worker with its current segment
+     * @return Empty unless setInterfaces() listed some
+     */
+    QString interfaceOf(SegmentWorker* worker) const;
     
     // ───────────────────────────────────────────────────────────────────────
     // Throughput Monitoring
     // ───────────────────────────────────────────────────────────────────────
     
     /**
-     * @brief Report throughput for a worker's segment
-     * @param worker Reporting worker
-     * @param bytesPerSecond Current throughput
+     * @brief Measure worker throughput from their byte counters
+     *
+     * Called from the task's progress timer. Workers never lock the
+     * scheduler to report speed; the timer reads their counters and
+     * smooths the byte delta over Constants::THROUGHPUT_TIME_CONSTANT.
+     * With mirrors, the per-source sums go to SourceSet::sample().
      */
-    void reportThroughput(SegmentWorker* worker, SpeedBps bytesPerSecond);
+    void sampleThroughput();
     
     /**
      * @brief Get aggregate download speed
@@ -242,6 +382,12 @@ public:
      */
     std::vector<WorkerStats> workerStats() const;
     
+    /**
+     * @brief Throughput split across the configured interfaces
+     * @return One entry per setInterfaces() name; empty without any
+     */
+    std::vector<InterfaceStats> interfaceStats() const;
+    
     // ───────────────────────────────────────────────────────────────────────
     // Rebalancing
     // ───────────────────────────────────────────────────────────────────────
@@ -283,6 +429,38 @@ public:
      */
     bool hasFailed() const;
     
+    // ───────────────────────────────────────────────────────────────────────
+    // Sequential Mode (streaming while downloading)
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /**
+     * @brief Favour the lowest unfinished bytes from the read position on
+     * 
+     * Pending work is handed out in file order, in pieces of STREAM_WINDOW,
+     * and a worker with nothing pending takes the window right after the
+     * earliest active segment's instead of stealing half of the largest.
+     * The download still fills the whole file; it just fills it front first.
+     */
+    void setSequential(bool enabled);
+    
+    /// @return True if setSequential() is on
+    bool isSequential() const;
+    
+    /**
+     * @brief Where a reader of the partial file currently is
+     * 
+     * Sequential mode starts from here, so a seek ahead gets its bytes
+     * first; the bytes before it are fetched afterwards.
+     */
+    void setReadPosition(ByteOffset position);
+    
+    /**
+     * @brief End of the contiguous bytes on disk from @p from
+     * @return First byte at or after @p from that is not yet readable from
+     *         the output file (@p from itself if that byte is missing)
+     */
+    ByteOffset contiguousEnd(ByteOffset from) const;
+    
     // ───────────────────────────────────────────────────────────────────────
     // Control
     // ───────────────────────────────────────────────────────────────────────
@@ -328,43 +506,95 @@ signals:
     
 private slots:
     void onRebalanceTimer();
+    void onHostTimer();
+    void onRetryTimer();
     
 private:
     // Internal helpers
     Segment* findLargestActiveSegment() const;
+    Segment* findHedgeCandidate() const;
     Segment* createNewSegment(ByteOffset start, ByteOffset end);
+    Segment* adoptSegment(Segment&& segment);   ///< Moves it into m_arena
     void scheduleSegment(Segment* segment);
+    void checkAllComplete();                ///< Emit allSegmentsCompleted() if nothing is left
     SegmentId nextSegmentId();
+    RetryWheel::Clock::time_point now() const;
+    
+    // Note: Caller must hold m_mutex exclusively
+    void signalWork();                      ///< Bump the generation, wake waiters
+    bool isAllCompleteLocked() const;
+    SourceId chooseSourceLocked(SegmentWorker* worker, const Segment* segment) const;
+    std::vector<size_t> workersPerSourceLocked() const;
+    void assignInterfaceLocked(SegmentWorker* worker);
+    std::vector<size_t> workersPerInterfaceLocked() const;
+    void trackLocked(const Segment* segment, RangeState state);
+    void refreshTableLocked();
+    bool admitLocked(SegmentWorker* worker, const Segment* segment, Duration* retryIn);
+    void placeLocked(SegmentWorker* worker, Segment* segment);
+    void releaseHostLocked(SegmentWorker* worker);
+    
+    /// Wake the workers again once a full or blocked host may admit them
+    void scheduleHostRetry(Duration delay);
+    
+    /// Hold a failed segment back for @p delay; caller must hold m_mutex exclusively
+    void scheduleRetryLocked(Segment* segment, Duration delay);
+    
+    // Sequential mode; caller must hold m_mutex exclusively
+    std::deque<Segment*>::iterator nextPendingLocked();
+    Segment* carveWindowLocked(Segment* segment, std::vector<SegmentId>& added);
+    Segment* findSequentialVictim() const;
     
     // Parent task
     DownloadTask* m_task;
     
     // Segment storage
-    std::vector<std::unique_ptr<Segment>> m_segments;
+    SegmentArena m_arena;                       ///< Owns every segment below
+    std::vector<Segment*> m_segments;           ///< Creation order
+    SegmentTable m_table;                       ///< Hot fields as of the last sample
     std::deque<Segment*> m_pendingQueue;
+    RetryWheel m_retryWheel;                    ///< Failed segments backing off
     std::set<Segment*> m_activeSegments;
     std::set<Segment*> m_completedSegments;
     std::set<Segment*> m_failedSegments;
+    std::unordered_map<SegmentId, Segment*> m_segmentIndex;
+    RangeMap m_ranges;                          ///< Which bytes are pending, in flight, done
     
     // Worker tracking
     std::set<SegmentWorker*> m_workers;
     std::map<SegmentWorker*, Segment*> m_workerAssignments;
     std::map<SegmentWorker*, WorkerStats> m_workerStats;
+    std::map<SegmentWorker*, SourceId> m_workerSources;     ///< Kept across segments
+    std::map<SegmentWorker*, QString> m_workerHosts;        ///< HostGovernor slot held
+    
+    // Multipath
+    std::vector<InterfaceStats> m_interfaces;
+    std::map<SegmentWorker*, size_t> m_workerInterfaces;    ///< Index into m_interfaces
     
     // Synchronization
     mutable std::shared_mutex m_mutex;
     std::condition_variable_any m_workCondition;
+    uint64_t m_workGeneration{0};               ///< Guarded by m_mutex
     
     // Rebalancing
     QTimer* m_rebalanceTimer{nullptr};
     bool m_autoRebalance{true};
     
+    // Backoff: per-host admission and segment retries
+    QTimer* m_hostTimer{nullptr};
+    QTimer* m_retryTimer{nullptr};
+    std::atomic<bool> m_hostRetryQueued{false};
+    
     // ID generation
     std::atomic<SegmentId> m_nextSegmentId{0};
     
+    // Time source for sampling, steals and retries; empty = steady_clock
+    std::function<RetryWheel::Clock::time_point()> m_clock;
+    
     // State
     bool m_paused{false};
     bool m_cancelled{false};
+    bool m_sequential{false};
+    ByteOffset m_readPosition{0};
 };
 
 } // namespace OpenIDM
@@ -4,13 +4,16 @@
  * 
  * SegmentWorker is responsible for the actual HTTP transfer of a single segment.
  * It uses libcurl for fine-grained control over the connection and supports
- * pause/resume, progress reporting, and error handling.
+ * pause/resume, progress reporting, and error handling. Received data is
+ * written directly into the task's output file at the segment's offset.
  */
 
 #pragma once
 
 #include "openidm/engine/Types.h"
 #include "openidm/engine/Segment.h"
+#include "openidm/engine/BandwidthLimiter.h"
+#include "openidm/engine/TransferTrace.h"
 
 #include <atomic>
 #include <memory>
@@ -18,25 +21,31 @@
 
 #include <QObject>
 #include <QRunnable>
-#include <QFile>
 #include <QMutex>
 #include <QWaitCondition>
 
 // Forward declare CURL types
 typedef void CURL;
+struct curl_slist;
 
 namespace OpenIDM {
 
 // Forward declarations
 class SegmentScheduler;
 class DownloadTask;
+class OutputFile;
+class WorkerPool;
+struct WriteBuffer;
+namespace Bench { class SchedulerSimulator; }
 
 /**
  * @class SegmentWorker
  * @brief Downloads a segment using HTTP byte-range requests
  * 
  * Lifecycle:
- * 1. Worker is created and added to thread pool
+ * 1. Worker is created and added to thread pool (or attached to the
+ *    TransferEngine event loop, which performs the same steps without a
+ *    dedicated thread)
  * 2. Worker acquires a segment from the scheduler
  * 3. Worker downloads the segment using libcurl
  * 4. On completion/error, worker returns segment to scheduler
@@ -50,10 +59,15 @@ class DownloadTask;
  * 
  * Memory Safety:
  * - Worker does not own the Segment (scheduler owns it)
+ * - Worker does not own the OutputFile (task owns it)
  * - CURL handle is owned by the worker
  */
 class SegmentWorker : public QObject, public QRunnable {
     Q_OBJECT
+    
+    friend class TransferEngine;
+    friend class WorkerPool;                 // Tracks when run() has returned
+    friend class Bench::SchedulerSimulator;  // Feeds the counters from a network model
 
 public:
     // ───────────────────────────────────────────────────────────────────────
@@ -126,6 +140,49 @@ public:
      */
     void resume();
     
+    /**
+     * @brief Set the HTTP version and multiplexing mode for transfers
+     * @param protocol Protocol chosen by SegmentScheduler::planConnections()
+     * @param multiplex Wait for and share a multiplexed connection
+     *        (only effective when driven by TransferEngine)
+     */
+    void setProtocol(HttpProtocol protocol, bool multiplex);
+    
+    /**
+     * @brief Cap this worker's connection
+     * @param limit Bytes per second (0 = only task/global limits apply)
+     */
+    void setSpeedLimit(SpeedBps limit) { m_bandwidth.setRate(limit); }
+    
+    /**
+     * @brief Make this worker's first request double as the capability probe
+     *
+     * Call before the worker starts. The open-ended segment is requested as
+     * `Range: bytes=0-`; once the final response's headers arrive they are
+     * reported through capabilitiesReceived() and the body is held back
+     * until releaseProbe(), when the task has opened its output file.
+     */
+    void setCapabilityProbe(bool probe) { m_capabilityProbe = probe; }
+    
+    /**
+     * @brief Guard ranged requests with the validators of cached capabilities
+     *
+     * Call before the worker starts. Sends If-Match (strong ETag) or
+     * If-Unmodified-Since when @p caps came from HostCache, so a changed
+     * resource answers 412 instead of mixing two versions in one file.
+     */
+    void setPrecondition(const ServerCapabilities& caps);
+    
+    /// @return True if this worker is the fast-start probe
+    bool isCapabilityProbe() const { return m_capabilityProbe; }
+    
+    /**
+     * @brief Let the fast-start probe write the data it is holding
+     *
+     * Safe from any thread.
+     */
+    void releaseProbe();
+    
     /**
      * @brief Check if worker should continue
      */
@@ -153,19 +210,23 @@ public:
     // Statistics
     // ───────────────────────────────────────────────────────────────────────
     
-    /// @return Current download speed (bytes/second)
+    // The transfer thread only bumps these counters; the scheduler samples
+    // them on the task's progress timer and publishes the measured speed.
+    // No signal is emitted per chunk.
+    
+    /// @return Speed measured at the last scheduler sample (bytes/second)
     SpeedBps currentSpeed() const;
     
+    /// @brief Publish the speed measured by SegmentScheduler::sampleThroughput()
+    void setMeasuredSpeed(SpeedBps speed) { m_currentSpeed.store(speed, std::memory_order_relaxed); }
+    
     /// @return Total bytes downloaded by this worker
-    ByteCount totalBytesDownloaded() const { return m_totalBytesDownloaded.load(); }
+    ByteCount totalBytesDownloaded() const { return m_totalBytesDownloaded.load(std::memory_order_relaxed); }
     
     /// @return Bytes downloaded in current segment
-    ByteCount segmentBytesDownloaded() const { return m_segmentBytesDownloaded.load(); }
+    ByteCount segmentBytesDownloaded() const { return m_segmentBytesDownloaded.load(std::memory_order_relaxed); }
     
 signals:
-    /// Emitted periodically during download
-    void progressUpdated(ByteCount downloaded, SpeedBps speed);
-    
     /// Emitted when segment download completes
     void segmentCompleted(Segment* segment);
     
@@ -178,17 +239,57 @@ signals:
     /// Emitted when worker finishes (regardless of reason)
     void finished();
     
+    /// Emitted by the fast-start probe once the response headers are in
+    void capabilitiesReceived(const ServerCapabilities& capabilities);
+    
+    /// Emitted by the fast-start probe when the server refused the request
+    void probeFailed(const DownloadError& error);
+    
+    /// Emitted when a ranged request got 412 or 416: the resource changed
+    void resourceChanged(int httpStatus);
+    
 private:
     // ───────────────────────────────────────────────────────────────────────
     // Internal Methods
     // ───────────────────────────────────────────────────────────────────────
     
+    // The acquire → transfer → release cycle is split into steps so the
+    // same worker can be driven by run() (blocking curl_easy_perform) or
+    // by TransferEngine (curl_multi event loop).
+    
+    /**
+     * @brief Acquire the next segment from the scheduler and make it current
+     * @return Segment, or nullptr if no work is available
+     */
+    Segment* acquireNext();
+    
+    /**
+     * @brief Attach the output file and configure curl for a segment
+     * @param segment Segment returned by acquireNext()
+     * @return True if the transfer can be performed
+     */
+    bool prepareTransfer(Segment* segment);
+    
     /**
-     * @brief Download a single segment
-     * @param segment Segment to download
-     * @return True on success, false on error
+     * @brief Evaluate the result of a finished transfer
+     * @param segment Transferred segment
+     * @param curlCode CURLcode of the transfer
+     * @return True if the segment is complete
      */
-    bool downloadSegment(Segment* segment);
+    bool completeTransfer(Segment* segment, int curlCode);
+    
+    /**
+     * @brief Clear the current segment and release it to the scheduler
+     * @param segment Segment returned by acquireNext()
+     * @param success Result of completeTransfer()
+     */
+    void finishSegment(Segment* segment, bool success);
+    
+    /**
+     * @brief Read curl's phase timings and hand the attempt to the scheduler
+     * @param curlCode CURLcode of the transfer
+     */
+    void recordAttempt(int curlCode);
     
     /**
      * @brief Initialize libcurl handle
@@ -209,36 +310,89 @@ private:
     void cleanupCurl();
     
     /**
-     * @brief Open temporary file for segment
-     * @param segment Target segment
-     * @return True on success
+     * @brief Handle curl error
+     * @param code Curl result code
+     * @param segment Affected segment
+     * @return Populated error structure
      */
-    bool openTempFile(Segment* segment);
+    DownloadError handleCurlError(int code, Segment* segment);
     
     /**
-     * @brief Close and flush temporary file
+     * @brief Store claimed bytes, via the write-behind buffer when possible
+     *
+     * The caller has counted the bytes as pending before claiming them;
+     * they stop being pending once they are in the file.
+     * @return False if the data could not be stored
      */
-    void closeTempFile();
+    bool storeData(Segment* segment, ByteOffset offset, const char* data, size_t length);
     
     /**
-     * @brief Handle curl error
-     * @param code Curl result code
-     * @param segment Affected segment
-     * @return Populated error structure
+     * @brief Hand the partially filled write-behind buffer to DiskWriter
+     * @param synchronous Write it on this thread instead (hedged segments)
      */
-    DownloadError handleCurlError(int code, Segment* segment);
+    void flushWriteBuffer(bool synchronous = false);
     
     /**
-     * @brief Update speed calculation
-     * @param bytes Bytes received
+     * @brief Give back a buffer grant from DiskWriter::admit() that was not used
      */
-    void updateSpeed(ByteCount bytes);
+    void returnWriteGrant();
     
     /**
      * @brief Wait while paused
      */
     void waitWhilePaused();
     
+    /**
+     * @brief Block until the pool thread has returned from run()
+     *
+     * Returns at once for a worker that was never handed to WorkerPool.
+     */
+    void waitForExit();
+    
+    /**
+     * @brief Release waitForExit(); last statement of run()
+     */
+    void markExited();
+    
+    /**
+     * @brief Hold the fast-start probe's data until releaseProbe()
+     * @return False to pause the handle (engine) or abort (stopped)
+     */
+    bool waitForProbeRelease();
+    
+    /**
+     * @brief Report the capability headers collected for the probe
+     * @return False if the response is an error and the transfer must stop
+     */
+    bool reportCapabilities();
+    
+    /**
+     * @brief Check the status of a segment response once its headers are in
+     * @return False if the resource changed and the transfer must stop
+     */
+    bool checkPreconditions();
+    
+    /**
+     * @brief Report a 429 or 503 to the HostGovernor
+     * @return False if the host is throttling us and the transfer must stop
+     */
+    bool checkThrottle();
+    
+    /// @return HostGovernor key of the current source
+    QString sourceHost() const;
+    
+    /**
+     * @brief Check a mirror's first response against the task's reference
+     * @return False if the mirror disagrees and the transfer must stop
+     */
+    bool verifySource();
+    
+    /**
+     * @brief Block until the bandwidth hierarchy has tokens (blocking backend)
+     * @param wait Initial delay reported by the bucket chain
+     */
+    void waitForBandwidth(Duration wait);
+    
     // ───────────────────────────────────────────────────────────────────────
     // Curl Callbacks (static)
     // ───────────────────────────────────────────────────────────────────────
@@ -274,9 +428,24 @@ private:
     
     // Curl handle
     CURL* m_curl{nullptr};
-    
-    // Temp file
-    std::unique_ptr<QFile> m_tempFile;
+    curl_slist* m_headers{nullptr};
+    QByteArray m_precondition;      ///< Validator header for ranged requests
+    SourceId m_source{0};           ///< Source of the current segment
+    bool m_verifySource{false};     ///< First response from a mirror, check it
+    QByteArray m_interface;         ///< Multipath: CURLOPT_INTERFACE, empty = default
+    HttpProtocol m_protocol{HttpProtocol::Unknown};
+    bool m_multiplex{false};
+    bool m_engineDriven{false};     ///< Set by TransferEngine; pause instead of sleeping
+    
+    // Segment → task → global token buckets
+    TokenBucket m_bandwidth;
+    
+    // Shared destination file (owned by task, written at segment offsets)
+    OutputFile* m_output{nullptr};
+    ByteOffset m_streamOffset{0};   ///< File offset of the next byte curl delivers
+    WriteBuffer* m_writeBuffer{nullptr};    ///< Being filled (pooled, not owned)
+    bool m_writeGranted{false};             ///< Engine thread: next buffer already charged (admit())
+    ByteCount m_receiveBuffer{0};           ///< CURLOPT_BUFFERSIZE charged to the MemoryBudget
     
     // Control flags
     std::atomic<bool> m_shouldStop{false};
@@ -287,22 +456,31 @@ private:
     QMutex m_pauseMutex;
     QWaitCondition m_pauseCondition;
     
-    // Statistics
+    // Pool lifetime latch: set by WorkerPool::start(), cleared when run() returns
+    QMutex m_runMutex;
+    QWaitCondition m_runCondition;
+    bool m_queued{false};
+    
+    // Fast start: headers of the final response (also collected for mirror
+    // verification), gate guarded by m_pauseMutex
+    bool m_capabilityProbe{false};
+    bool m_probeReported{false};            ///< Transfer thread only
+    bool m_probeParked{false};              ///< Engine handle paused at the gate
+    std::atomic<bool> m_probeReleased{false};
+    HttpHeaderInfo m_probeHeaders;          ///< Parsed as curl delivers them
+    
+    // Statistics (single writer: the transfer thread)
     std::atomic<ByteCount> m_totalBytesDownloaded{0};
     std::atomic<ByteCount> m_segmentBytesDownloaded{0};
-    
-    // Speed calculation
-    struct SpeedSample {
-        ByteCount bytes;
-        Timestamp time;
-    };
-    std::vector<SpeedSample> m_speedSamples;
-    mutable QMutex m_speedMutex;
-    std::atomic<SpeedBps> m_currentSpeed{0.0};
+    std::atomic<SpeedBps> m_currentSpeed{0.0};      ///< Written by the sampler
     
     // Timing
     Timestamp m_segmentStartTime;
-    Timestamp m_lastProgressReport;
+    
+    // Tracing (transfer thread only)
+    TransferAttempt m_attempt;              ///< Current transfer, see recordAttempt()
+    ByteCount m_attemptBaseline{0};         ///< m_totalBytesDownloaded when it started
+    bool m_inTransfer{false};               ///< Counted in EngineMetrics' active transfers
 };
 
 } // namespace OpenIDM
@@ -0,0 +1,161 @@
+/**
+ * @file SourceSet.h
+ * @brief Equivalent URLs of one download and what each of them delivers
+ *
+ * A task used to fetch every segment from its one URL, so a server's
+ * per-client cap was the ceiling. With mirrors (given directly or by a
+ * Metalink file) SegmentScheduler spreads workers across sources by
+ * measured throughput; a source that disagrees about the file, keeps
+ * failing or slows to a crawl is dropped or demoted.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <mutex>
+#include <vector>
+
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+namespace OpenIDM {
+
+/**
+ * @class SourceSet
+ * @brief Sources of a download with their state and measured throughput
+ *
+ * Source 0 is the task's own URL; its probe result is the reference every
+ * mirror must match (206 to a range, same size, same strong ETag unless an
+ * expected hash will check the finished file). The set holds no worker
+ * assignments: SegmentScheduler owns those and passes the per-source worker
+ * counts in.
+ *
+ * Thread Safety:
+ * - All methods are safe to call from any thread
+ */
+class SourceSet {
+public:
+    enum class State {
+        Active,         ///< Receives new workers
+        Demoted,        ///< Too slow; used only when nothing else is left
+        Dropped         ///< Disagrees with the reference or keeps failing
+    };
+
+    struct Source {
+        QUrl url;
+        State state{State::Active};
+        SpeedBps throughput{0.0};       ///< Sum over its workers at the last sample
+        bool measured{false};           ///< throughput was sampled with workers on it
+        bool verified{false};           ///< Response matched the reference
+        size_t failures{0};             ///< Consecutive failed segments
+        Timestamp slowSince{};
+        Timestamp demotedAt{};
+    };
+
+    explicit SourceSet(const QUrl& primary);
+
+    // Disable copying
+    SourceSet(const SourceSet&) = delete;
+    SourceSet& operator=(const SourceSet&) = delete;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Sources
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Replace the mirrors; source 0 stays the primary URL
+     *
+     * Duplicates of the primary and non-HTTP(S) URLs are ignored. Call
+     * before the task starts.
+     */
+    void setMirrors(const QList<QUrl>& mirrors);
+
+    /// @return Mirror URLs (without the primary)
+    QList<QUrl> mirrors() const;
+
+    /// @return Number of sources including the primary
+    size_t size() const;
+
+    /// @return URL of a source (the primary for an unknown id)
+    QUrl url(SourceId id) const;
+
+    /// @return Copy of all sources, for diagnostics
+    std::vector<Source> sources() const;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Verification
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Set the primary's capabilities that mirrors must agree with
+     * @param caps Probe (or cache) result of the primary URL
+     * @param haveHash An expected hash will check the finished file, so
+     *        differing ETags between mirrors are tolerated
+     */
+    void setReference(const ServerCapabilities& caps, bool haveHash);
+
+    /// @return True if the next response from @p id must be checked
+    bool needsVerification(SourceId id) const;
+
+    /**
+     * @brief Check a mirror's first response against the reference
+     * @return False if the source was dropped
+     */
+    bool verify(SourceId id, const ServerCapabilities& response);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Health
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @brief A segment from @p id completed
+    void reportSuccess(SourceId id);
+
+    /// @brief A segment from @p id failed; drops it after MIRROR_MAX_FAILURES
+    void reportFailure(SourceId id);
+
+    /**
+     * @brief Record per-source throughput and demote collapsed sources
+     *
+     * Called by SegmentScheduler::sampleThroughput(). A source with workers
+     * whose per-connection speed stays below MIRROR_DEMOTE_RATIO of the best
+     * source's for MIRROR_DEMOTE_AFTER is demoted for MIRROR_PROBATION.
+     *
+     * @param throughput Summed worker throughput per source
+     * @param workers Workers assigned per source
+     */
+    void sample(const std::vector<SpeedBps>& throughput, const std::vector<size_t>& workers);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Assignment
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Pick the source for a worker's next segment
+     *
+     * Chooses the source with the highest expected rate per connection,
+     * throughput / (workers + 1); a source without a measurement is assumed
+     * as fast as the best one so it gets tried. The worker stays on
+     * @p current unless another source promises 1 / MIRROR_SWITCH_RATIO
+     * times its rate, which keeps warm connections in use.
+     *
+     * @param current Source the worker used last
+     * @param workers Workers assigned per source, including this one on @p current
+     */
+    SourceId choose(SourceId current, const std::vector<size_t>& workers) const;
+
+private:
+    /// @note Caller must hold m_mutex
+    void dropLocked(SourceId id, const QString& reason);
+
+    /// @note Caller must hold m_mutex
+    size_t usableCountLocked() const;
+
+    std::vector<Source> m_sources;
+    ServerCapabilities m_reference;
+    bool m_haveHash{false};
+    mutable std::mutex m_mutex;
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,136 @@
+/**
+ * @file SpeedCalculator.h
+ * @brief Constant-time speed meters for segments, tasks and the global total
+ *
+ * A SpeedCalculator keeps a fixed ring of time buckets covering
+ * Constants::SPEED_SMOOTHING_WINDOW together with a running sum, so adding
+ * bytes and reading the speed never loop over history or allocate. Results
+ * are published through atomics: the owner thread writes, any thread reads.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <array>
+#include <atomic>
+
+namespace OpenIDM {
+
+/**
+ * @class SpeedCalculator
+ * @brief Windowed and exponentially smoothed throughput
+ *
+ * Thread Safety:
+ * - addBytes(), setTotal(), sample() and reset() from a single thread
+ * - currentSpeed(), smoothedSpeed() and eta() from any thread, lock-free
+ */
+class SpeedCalculator {
+public:
+    static constexpr size_t BUCKET_COUNT = Constants::SPEED_BUCKET_COUNT;
+
+    SpeedCalculator() = default;
+
+    // Disable copying
+    SpeedCalculator(const SpeedCalculator&) = delete;
+    SpeedCalculator& operator=(const SpeedCalculator&) = delete;
+
+    /// @brief Forget all samples
+    void reset();
+
+    /**
+     * @brief Record bytes received
+     * @param bytes Bytes since the previous call
+     * @param now Current time
+     */
+    void addBytes(ByteCount bytes, Timestamp now);
+
+    /**
+     * @brief Record progress from a cumulative counter
+     *
+     * The first call after reset() only sets the baseline; a counter that
+     * went backwards (segments restarted) is treated as a new baseline.
+     */
+    void setTotal(ByteCount total, Timestamp now);
+
+    /**
+     * @brief Advance the clock without new bytes, so an idle meter decays
+     */
+    void sample(Timestamp now) { addBytes(0, now); }
+
+    /// @return Average over the window (bytes/second)
+    SpeedBps currentSpeed() const { return m_speed.load(std::memory_order_relaxed); }
+
+    /// @return Exponential moving average of completed buckets (bytes/second)
+    SpeedBps smoothedSpeed() const { return m_smoothed.load(std::memory_order_relaxed); }
+
+    /// @return True once at least one bucket has been filled
+    bool hasSamples() const { return smoothedSpeed() > 0.0 || currentSpeed() > 0.0; }
+
+    /**
+     * @brief Time to download @p remainingBytes at the smoothed speed
+     * @return Milliseconds, or -1 if unknown
+     */
+    Duration eta(ByteCount remainingBytes) const;
+
+private:
+    void advanceTo(int64_t bucket);
+
+    static constexpr Duration BUCKET_WIDTH = Constants::SPEED_SMOOTHING_WINDOW / BUCKET_COUNT;
+
+    std::array<ByteCount, BUCKET_COUNT> m_buckets{};
+    ByteCount m_windowBytes{0};         ///< Sum of m_buckets
+    Timestamp m_origin{};               ///< Start of bucket 0
+    int64_t m_firstBucket{0};           ///< Oldest bucket with data since reset()
+    int64_t m_headBucket{-1};           ///< Newest bucket, -1 before the first sample
+    ByteCount m_lastTotal{-1};          ///< Baseline for setTotal()
+    double m_ema{0.0};
+
+    std::atomic<SpeedBps> m_speed{0.0};
+    std::atomic<SpeedBps> m_smoothed{0.0};
+};
+
+/**
+ * @class AggregateSpeedCalculator
+ * @brief Sum of many meters, read without touching them
+ *
+ * Each running task takes an integer slot and publishes its speed there on
+ * its progress tick; the total is kept as a running sum, so the global
+ * meter costs one atomic load.
+ */
+class AggregateSpeedCalculator {
+public:
+    static constexpr size_t SLOT_COUNT = Constants::SPEED_METER_SLOTS;
+
+    /// @return Process-wide aggregate
+    static AggregateSpeedCalculator& instance();
+
+    /**
+     * @brief Claim a slot
+     * @return Slot index, or -1 if all slots are in use
+     */
+    int acquireSlot();
+
+    /// @brief Zero and return a slot
+    void releaseSlot(int slot);
+
+    /// @brief Replace the speed published in a slot
+    void publish(int slot, SpeedBps speed);
+
+    /// @return Sum of all published speeds (bytes/second)
+    SpeedBps totalSpeed() const { return static_cast<SpeedBps>(m_total.load(std::memory_order_relaxed)); }
+
+    /// @return Slots currently claimed
+    int activeSlots() const { return m_active.load(std::memory_order_relaxed); }
+
+private:
+    AggregateSpeedCalculator() = default;
+
+    // Whole bytes per second: integer sums do not drift
+    std::array<std::atomic<int64_t>, SLOT_COUNT> m_speeds{};
+    std::array<std::atomic<bool>, SLOT_COUNT> m_used{};
+    std::atomic<int64_t> m_total{0};
+    std::atomic<int> m_active{0};
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,103 @@
+/**
+ * @file StreamServer.h
+ * @brief Loopback HTTP server that plays a download while it is running
+ *
+ * A media player pointed at `http://127.0.0.1:<port>/stream/<task id>`
+ * gets the partial file as if it were complete: Range requests are
+ * answered with the final size, bytes are sent as soon as they are
+ * contiguous on disk, and a read past them simply waits until the
+ * download catches up. Opening a stream switches the task's scheduler to
+ * sequential mode and tells it where the player is reading.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <unordered_map>
+
+#include <QObject>
+#include <QUrl>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+namespace OpenIDM {
+
+class DownloadManager;
+
+/**
+ * @class StreamServer
+ * @brief Serves tasks' partial files over HTTP/1.1 with Range support
+ *
+ * One response per connection (players reconnect to seek). Only loopback
+ * is bound: the server exposes files to any local process, so it must not
+ * be reachable from the network.
+ *
+ * Thread Safety:
+ * - Lives on the main thread, next to DownloadManager
+ */
+class StreamServer : public QObject {
+public:
+    explicit StreamServer(DownloadManager& manager, QObject* parent = nullptr);
+    ~StreamServer() override;
+
+    // Disable copying
+    StreamServer(const StreamServer&) = delete;
+    StreamServer& operator=(const StreamServer&) = delete;
+
+    /**
+     * @brief Listen on the loopback interface
+     * @param port TCP port (0 picks a free one, see port())
+     * @return False if the port could not be bound
+     */
+    bool start(quint16 port = 0);
+
+    /// Stop listening and drop open streams
+    void stop();
+
+    /// @return Bound port, 0 when not listening
+    quint16 port() const { return m_port; }
+
+    /// @return URL a player opens for @p id
+    QUrl urlFor(const TaskId& id) const;
+
+private:
+    struct Stream {
+        QByteArray input;               ///< Request head until complete
+        QByteArray range;               ///< Range header, if any
+        TaskId task;                    ///< Null until the request is parsed
+        ByteOffset position{0};         ///< Next byte to send
+        ByteOffset end{-1};             ///< Last byte to send (inclusive)
+        bool answered{false};           ///< Response head sent
+        bool head{false};               ///< HEAD request: no body
+        bool waiting{false};            ///< Blocked on the download
+    };
+
+    /// Where a stream's bytes come from right now
+    struct Source {
+        QString path;                   ///< File to read (.part while running)
+        QString fileName;
+        ByteCount size{-1};             ///< Final size, -1 while unknown
+        ByteOffset available{0};        ///< End of readable bytes from the position
+    };
+
+    /// @return False once the task is gone or has failed
+    bool locate(const Stream& stream, Source& source) const;
+
+    void accept();
+    void read(QTcpSocket* socket);
+    void respond(QTcpSocket* socket, Stream& stream);
+    void pump(QTcpSocket* socket);
+    void poll();
+    void drop(QTcpSocket* socket);
+
+    DownloadManager& m_manager;
+    QTcpServer* m_server{nullptr};
+    QTimer* m_poll{nullptr};
+    std::unordered_map<QTcpSocket*, Stream> m_streams;
+    quint16 m_port{0};
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,197 @@
+/**
+ * @file TaskRegistry.h
+ * @brief Indexed storage for download tasks and archived downloads
+ *
+ * DownloadManager used to walk every task for each lookup by URL or state,
+ * which made bulk adds quadratic. The registry keeps a hash index on the
+ * normalized URL and one intrusive list per DownloadState, so lookups,
+ * per-state queries and counts no longer depend on the size of the history.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+#include "openidm/persistence/PersistenceManager.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <QString>
+#include <QUrl>
+
+namespace OpenIDM {
+
+// Forward declarations
+class DownloadTask;
+
+/**
+ * @brief Links of a task in the registry's per-state list
+ *
+ * Embedded in DownloadTask so moving a task between states allocates nothing.
+ */
+struct TaskListHook {
+    DownloadTask* prev{nullptr};
+    DownloadTask* next{nullptr};
+    DownloadState list{DownloadState::Queued};      ///< List the task is linked into
+    bool linked{false};
+};
+
+/**
+ * @class TaskRegistry
+ * @brief Owns tasks and archive records, indexed by ID, URL and state
+ *
+ * Thread Safety:
+ * - Lookups take a shared lock, so UI and timer reads run in parallel with
+ *   each other and only wait for the short structural updates
+ * - count() reads atomics and takes no lock at all
+ * - Returned task pointers stay valid until the task is taken out again,
+ *   which only the owning thread does
+ */
+class TaskRegistry {
+public:
+    TaskRegistry() = default;
+    ~TaskRegistry();
+
+    // Disable copying
+    TaskRegistry(const TaskRegistry&) = delete;
+    TaskRegistry& operator=(const TaskRegistry&) = delete;
+
+    /**
+     * @brief Key used for duplicate detection
+     *
+     * Scheme and host are case-insensitive, the fragment never reaches the
+     * server, and an explicit default port or "." / ".." path segments name
+     * the same resource.
+     */
+    static QString normalizeUrl(const QUrl& url);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Tasks
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Take ownership of a task and index it by its current state
+     * @return The task, or nullptr if its ID is already registered
+     */
+    DownloadTask* add(std::unique_ptr<DownloadTask> task);
+
+    /**
+     * @brief Insert many tasks under a single exclusive lock
+     */
+    void add(std::vector<std::unique_ptr<DownloadTask>> tasks);
+
+    /**
+     * @brief Remove a task and hand ownership back
+     * @return nullptr if the ID is not a task
+     */
+    std::unique_ptr<DownloadTask> take(const TaskId& id);
+
+    /**
+     * @brief Remove every task (archive untouched)
+     */
+    std::vector<std::unique_ptr<DownloadTask>> takeAll();
+
+    /**
+     * @brief Move a task to the list of its current state
+     *
+     * Called from DownloadManager::onTaskStateChanged(). The state is read
+     * from the task rather than the signal, so a late queued signal cannot
+     * file the task under a state it already left.
+     */
+    void updateState(DownloadTask* task);
+
+    /// @return Task with the ID, or nullptr
+    DownloadTask* find(const TaskId& id) const;
+
+    /// @return All tasks (archived downloads excluded)
+    std::vector<DownloadTask*> all() const;
+
+    /// @return Tasks currently in @p state, in the order they entered it
+    std::vector<DownloadTask*> inState(DownloadState state) const;
+
+    /**
+     * @brief Call @p fn for every task while holding the shared lock
+     *
+     * @p fn must not add or take tasks.
+     */
+    void forEach(const std::function<void(DownloadTask*)>& fn) const;
+
+    /// @return Number of tasks in @p state (lock-free)
+    int count(DownloadState state) const {
+        return m_counts[static_cast<size_t>(state)].load(std::memory_order_relaxed);
+    }
+
+    /// @return Number of tasks (lock-free)
+    int taskCount() const { return m_taskCount.load(std::memory_order_relaxed); }
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Archive
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Store completed downloads that have no task object
+     */
+    void addArchived(std::vector<TaskData> records);
+
+    /// @return Removed record, or nullopt if the ID is not archived
+    std::optional<TaskData> takeArchived(const TaskId& id);
+
+    /// @return The whole archive, leaving it empty
+    std::map<TaskId, TaskData> takeArchive();
+
+    /// @return Copy of an archived record, or nullopt
+    std::optional<TaskData> findArchived(const TaskId& id) const;
+
+    /// @return IDs of all archived downloads
+    std::vector<TaskId> archivedIds() const;
+
+    /// @return Number of archived downloads (lock-free)
+    int archivedCount() const { return m_archivedCount.load(std::memory_order_relaxed); }
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Lookup
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Find a task or archived download for a URL
+     * @return ID of a download registered for the normalized URL
+     */
+    std::optional<TaskId> findByUrl(const QUrl& url) const;
+
+    /// @return Number of tasks plus archived downloads (lock-free)
+    int size() const { return taskCount() + archivedCount(); }
+
+private:
+    struct List {
+        DownloadTask* head{nullptr};
+        DownloadTask* tail{nullptr};
+    };
+
+    // Note: Caller must hold m_mutex exclusively for all of these
+    void insertLocked(std::unique_ptr<DownloadTask> task);
+    void link(DownloadTask* task, DownloadState state);
+    void unlink(DownloadTask* task);
+    void indexUrl(const QString& key, const TaskId& id);
+    void unindexUrl(const QString& key, const TaskId& id);
+
+    static constexpr size_t STATE_COUNT = static_cast<size_t>(DownloadState::Failed) + 1;
+
+    std::map<TaskId, std::unique_ptr<DownloadTask>> m_tasks;
+    std::map<TaskId, TaskData> m_archive;
+    std::unordered_multimap<QString, TaskId> m_byUrl;   ///< Normalized URL -> downloads
+    std::array<List, STATE_COUNT> m_lists{};
+    mutable std::shared_mutex m_mutex;
+
+    std::array<std::atomic<int>, STATE_COUNT> m_counts{};
+    std::atomic<int> m_taskCount{0};
+    std::atomic<int> m_archivedCount{0};
+};
+
+} // namespace OpenIDM
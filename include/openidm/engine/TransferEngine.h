@@ -0,0 +1,205 @@
+/**
+ * @file TransferEngine.h
+ * @brief Shared libcurl multi-handle event loop for all segment transfers
+ *
+ * Instead of one blocking curl_easy_perform() per QThreadPool thread,
+ * TransferEngine drives every segment of every DownloadTask from a single
+ * I/O thread using curl_multi_socket_action(). Socket readiness comes from
+ * the Qt event dispatcher of that thread (epoll/poll on Linux, kqueue on
+ * macOS, WSAEventSelect on Windows).
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <atomic>
+#include <map>
+#include <set>
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+
+// Forward declare CURL types
+typedef void CURL;
+typedef void CURLM;
+
+namespace OpenIDM {
+
+// Forward declarations
+class SegmentWorker;
+class Segment;
+
+/**
+ * @class TransferEngine
+ * @brief Process-wide event-driven backend for SegmentWorker transfers
+ *
+ * SegmentWorker keeps its role as the per-connection state holder (easy
+ * handle, callbacks, statistics). When the engine is running, workers are
+ * attached to it instead of being started on the thread pool, and the
+ * engine performs the acquire → transfer → release cycle that
+ * SegmentWorker::run() does in blocking mode, with
+ * SegmentScheduler::acquireSegment()/releaseSegment() still being the
+ * only work source.
+ *
+ * Thread Safety:
+ * - All curl handles attached to the engine are only touched on the
+ *   engine thread
+ * - attachWorker()/detachWorker() may be called from any thread;
+ *   detachWorker() blocks until the worker's handle is removed
+ */
+class TransferEngine : public QObject {
+    Q_OBJECT
+
+public:
+    // ───────────────────────────────────────────────────────────────────────
+    // Singleton Access
+    // ───────────────────────────────────────────────────────────────────────
+
+    /// @return The process-wide engine
+    static TransferEngine& instance();
+
+    ~TransferEngine() override;
+
+    // Disable copying
+    TransferEngine(const TransferEngine&) = delete;
+    TransferEngine& operator=(const TransferEngine&) = delete;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Lifecycle
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Start the I/O thread and create the multi handle
+     * @return True if the engine is running
+     */
+    bool start();
+
+    /**
+     * @brief Abort all transfers and stop the I/O thread
+     */
+    void stop();
+
+    /// @return True if workers should be attached instead of thread-pooled
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Workers
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Hand a worker to the event loop
+     *
+     * The worker registers with its scheduler and starts pulling segments.
+     * It emits SegmentWorker::finished() once the scheduler has no more
+     * work or the worker is stopped.
+     */
+    void attachWorker(SegmentWorker* worker);
+
+    /**
+     * @brief Remove a worker from the event loop (blocking)
+     *
+     * Must be called before a stopped worker is destroyed.
+     */
+    void detachWorker(SegmentWorker* worker);
+
+    /**
+     * @brief Unpause a handle after a bandwidth-limiter delay
+     *
+     * Engine thread only; called from the write callback of a handle that
+     * returned CURL_WRITEFUNC_PAUSE. Ignored if the handle has left the
+     * multi by then.
+     */
+    void resumeLater(CURL* easy, Duration delay);
+    
+    /**
+     * @brief Unpause a handle that is holding back data
+     *
+     * Safe from any thread; the unpause runs on the engine thread. Ignored
+     * if the handle has left the multi by then.
+     */
+    void resume(CURL* easy);
+
+    /**
+     * @brief Let idle workers look for work again
+     *
+     * Called by SegmentScheduler whenever work may have appeared. Safe from
+     * any thread; bursts of calls collapse into a single pass.
+     */
+    void wakeIdleWorkers();
+
+    /// @return Number of transfers currently running
+    int activeTransferCount() const { return m_activeCount.load(std::memory_order_relaxed); }
+
+private slots:
+    void onSocketTimeout();
+    void onWorkAvailable();
+
+private:
+    TransferEngine();
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Engine-thread internals
+    // ───────────────────────────────────────────────────────────────────────
+
+    void initializeMulti();
+    void cleanupMulti();
+    void doAttach(SegmentWorker* worker);
+    void doDetach(SegmentWorker* worker);
+
+    /**
+     * @brief Acquire the next segment for an idle worker and add its handle
+     * @return True if a transfer was started
+     */
+    bool startTransfer(SegmentWorker* worker);
+
+    /**
+     * @brief Retire a worker that has no more work or was stopped
+     */
+    void retireWorker(SegmentWorker* worker);
+
+    /**
+     * @brief Park a worker until its scheduler signals work
+     */
+    void parkWorker(SegmentWorker* worker);
+
+    /**
+     * @brief Drive libcurl for a ready socket (or timeout) and reap results
+     */
+    void socketAction(qintptr socket, int eventMask);
+
+    /**
+     * @brief Process CURLMSG_DONE messages
+     */
+    void checkMultiInfo();
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Curl Callbacks (static)
+    // ───────────────────────────────────────────────────────────────────────
+
+    static int socketCallback(CURL* easy, qintptr socket, int what, void* userp, void* socketp);
+    static int timerCallback(CURLM* multi, long timeoutMs, void* userp);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Member Variables
+    // ───────────────────────────────────────────────────────────────────────
+
+    struct Transfer {
+        SegmentWorker* worker;
+        Segment* segment;
+    };
+
+    QThread m_thread;
+    CURLM* m_multi{nullptr};
+    QTimer* m_socketTimer{nullptr};
+
+    std::map<CURL*, Transfer> m_transfers;      ///< Handles inside the multi
+    std::set<SegmentWorker*> m_idleWorkers;     ///< Attached, waiting for work
+
+    std::atomic<bool> m_running{false};
+    std::atomic<int> m_activeCount{0};
+    std::atomic<bool> m_wakePending{false};     ///< onWorkAvailable() already queued
+};
+
+} // namespace OpenIDM
@@ -0,0 +1,141 @@
+/**
+ * @file TransferTrace.h
+ * @brief Per-attempt timing of segment transfers, exportable as a trace
+ *
+ * Every segment attempt leaves one record: where curl's time went (DNS,
+ * connect, TLS, waiting for the first byte, the body), what it delivered,
+ * how long the worker was blocked on the disk, plus the steals that split
+ * segments between workers. A task keeps the most recent records in a
+ * fixed ring and writes them as Chrome trace JSON, which chrome://tracing
+ * and ui.perfetto.dev open directly.
+ *
+ * Configure with OPENIDM_ENABLE_TRACING=OFF to compile recording out.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+namespace OpenIDM {
+
+// ───────────────────────────────────────────────────────────────────────────
+// Records
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief One transfer of (part of) a segment
+ *
+ * The curl phases are cumulative from the start of the attempt, as
+ * CURLINFO_*_TIME_T reports them. A reused connection has zero DNS,
+ * connect and TLS time.
+ */
+struct TransferAttempt {
+    using Micros = std::chrono::microseconds;
+
+    SegmentId segment = 0;
+    int worker = 0;                             ///< Stable worker slot (trace track)
+    SourceId source = 0;
+    ByteOffset startByte = 0;                   ///< First byte requested
+    ByteCount bytes = 0;                        ///< Bytes this attempt stored
+    int retry = 0;                              ///< Segment's retry count when it started
+    bool hedged = false;                        ///< Raced a twin in the end game
+    int result = 0;                             ///< CURLcode
+    long httpStatus = 0;
+
+    std::chrono::steady_clock::time_point started{};
+    Micros nameLookup{0};                       ///< CURLINFO_NAMELOOKUP_TIME_T
+    Micros connect{0};                          ///< CURLINFO_CONNECT_TIME_T
+    Micros appConnect{0};                       ///< CURLINFO_APPCONNECT_TIME_T (TLS)
+    Micros startTransfer{0};                    ///< CURLINFO_STARTTRANSFER_TIME_T (first byte)
+    Micros total{0};                            ///< CURLINFO_TOTAL_TIME_T
+    Micros writeStall{0};                       ///< Waiting for a DiskWriter buffer
+};
+
+/// A steal that split a segment
+struct StealEvent {
+    std::chrono::steady_clock::time_point at{};
+    int worker = 0;                             ///< Slot of the thief
+    SegmentId from = 0;
+    SegmentId created = 0;
+    ByteOffset splitAt = 0;
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// Trace
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @class TransferTrace
+ * @brief Bounded per-task record of segment attempts
+ *
+ * Recording costs a short lock once per attempt and per steal, never per
+ * byte; the ring is allocated on the first record, so idle tasks pay
+ * nothing. The oldest records are overwritten once CAPACITY is reached.
+ *
+ * Thread Safety:
+ * - All methods are thread-safe
+ */
+class TransferTrace {
+public:
+#ifdef OPENIDM_ENABLE_TRACING
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+    static constexpr size_t CAPACITY = Constants::TRACE_CAPACITY;
+
+    TransferTrace();
+
+    // Disable copying
+    TransferTrace(const TransferTrace&) = delete;
+    TransferTrace& operator=(const TransferTrace&) = delete;
+
+    /// @brief Keep a finished attempt
+    void record(const TransferAttempt& attempt);
+
+    /// @brief Keep a steal
+    void recordSteal(const StealEvent& steal);
+
+    /// @return Kept attempts, oldest first
+    std::vector<TransferAttempt> attempts() const;
+
+    /// @return Kept steals, oldest first
+    std::vector<StealEvent> steals() const;
+
+    /// @brief Forget everything (a restarted download)
+    void clear();
+
+    /**
+     * @brief Chrome trace event JSON of the kept records
+     *
+     * One track per worker slot. Each attempt is a slice with nested
+     * dns/connect/tls/ttfb/body phases; steals are instant events.
+     *
+     * @param name Process name shown for the task
+     */
+    QByteArray toChromeTrace(const QString& name) const;
+
+private:
+    template <typename T>
+    struct Ring {
+        std::vector<T> items;
+        size_t next = 0;
+
+        void push(const T& item);
+        std::vector<T> ordered() const;
+    };
+
+    mutable std::mutex m_mutex;
+    Ring<TransferAttempt> m_attempts;
+    Ring<StealEvent> m_steals;
+    std::chrono::steady_clock::time_point m_origin;
+};
+
+} // namespace OpenIDM
@@ -12,8 +12,11 @@
 #include <string>
 #include <chrono>
 #include <atomic>
+#include <optional>
 #include <QString>
+#include <QStringList>
 #include <QUuid>
+#include <QDateTime>
 
 namespace OpenIDM {
 
@@ -23,6 +26,7 @@ namespace OpenIDM {
 
 using TaskId = QUuid;
 using SegmentId = uint32_t;
+using SourceId = uint32_t;          // Index into a task's SourceSet (0 = primary URL)
 using ByteOffset = int64_t;
 using ByteCount = int64_t;
 using Timestamp = std::chrono::system_clock::time_point;
@@ -48,7 +52,7 @@ enum class DownloadState : uint8_t {
     Probing,     ///< Checking server capabilities (HEAD request)
     Downloading, ///< Actively downloading segments
     Paused,      ///< Paused by user, resumable
-    Merging,     ///< Combining segment temp files
+    Merging,     ///< Flushing and renaming the output file
     Verifying,   ///< Checking file integrity (optional)
     Completed,   ///< Successfully finished
     Failed       ///< Unrecoverable error occurred
@@ -92,6 +96,16 @@ enum class ErrorCategory : uint8_t {
     Unknown
 };
 
+/**
+ * @brief HTTP protocol version negotiated with a server
+ */
+enum class HttpProtocol : uint8_t {
+    Unknown,
+    Http1,             ///< HTTP/1.x - one request per connection at a time
+    Http2,             ///< HTTP/2 - multiplexed streams over TCP
+    Http3              ///< HTTP/3 - multiplexed streams over QUIC
+};
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Constants
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -104,6 +118,66 @@ namespace Constants {
     constexpr ByteCount MIN_SEGMENT_SIZE = 1 * 1024 * 1024;      // 1 MB
     constexpr ByteCount MIN_STEAL_SIZE = 512 * 1024;              // 512 KB
     constexpr ByteCount CHUNK_SIZE = 64 * 1024;                   // 64 KB
+    constexpr ByteCount HEDGE_THRESHOLD = 4 * 1024 * 1024;        // End game below 4 MB left
+    constexpr Duration HEDGE_MIN_ETA{1000};                       // Not worth racing below 1s
+    constexpr size_t SEGMENT_SLAB_SIZE = 64;                      // Segments per SegmentArena slab
+    
+    // Adaptive connection count
+    constexpr size_t INITIAL_CONNECTIONS = 4;                     // Before anything is learned
+    constexpr double MIN_MARGINAL_GAIN = 0.25;                    // Of one connection's share
+    
+    // Capability cache (HostCache)
+    constexpr Duration HOST_CACHE_TTL{7LL * 24 * 60 * 60 * 1000}; // 1 week
+    constexpr Duration RESOURCE_CACHE_TTL{60LL * 60 * 1000};      // 1 hour
+    
+    // Engine-wide worker pool
+    constexpr size_t DEFAULT_TOTAL_CONNECTIONS = 64;              // Shared by all downloads
+    constexpr size_t MAX_TOTAL_CONNECTIONS = 256;
+    
+    // Per-host politeness (HostGovernor)
+    constexpr size_t DEFAULT_HOST_CONNECTIONS = 16;               // Shared by all tasks on one host
+    constexpr size_t MAX_HOST_CONNECTIONS = 128;
+    constexpr size_t HOST_RECOVERY_STREAK = 8;                    // Clean transfers per +1 after a throttle
+    constexpr Duration HOST_THROTTLE_MEMORY{10LL * 60 * 1000};    // Learned limit forgotten after 10 min
+    constexpr Duration HOST_SLOT_POLL{250};                       // Recheck a full host
+    constexpr Duration MAX_RETRY_AFTER{10LL * 60 * 1000};         // Longest Retry-After honoured
+    
+    // Bandwidth sharing under a global limit (BandwidthLimiter::share)
+    constexpr SpeedBps MIN_FAIR_SHARE = 16 * 1024;                // Floor, also for preempted tasks
+    constexpr double FAIR_SHARE_SATURATED = 0.9;                  // Using this much of its rate = wants more
+    constexpr double FAIR_SHARE_HEADROOM = 1.5;                   // Growth per sample for other tasks
+    
+    // Multiplexing (HTTP/2, HTTP/3)
+    constexpr size_t MAX_MULTIPLEXED_CONNECTIONS = 2;             // Per host
+    constexpr size_t MAX_STREAMS_PER_CONNECTION = 16;
+    
+    // Multi-source downloads (SourceSet)
+    constexpr double MIRROR_DEMOTE_RATIO = 0.2;                   // Per-connection speed vs the best source
+    constexpr Duration MIRROR_DEMOTE_AFTER{10000};                // Slow for this long → demoted
+    constexpr Duration MIRROR_PROBATION{60000};                   // Demoted source is tried again after
+    constexpr double MIRROR_SWITCH_RATIO = 0.5;                   // Stay unless another source promises 2×
+    constexpr size_t MIRROR_MAX_FAILURES = 3;                     // Consecutive, then dropped
+    
+    // Bulk probing (ProbePipeline)
+    constexpr size_t PROBE_CONCURRENCY = 32;                      // In flight across all hosts
+    constexpr size_t PROBE_PER_HOST = 4;                          // In flight per host
+    constexpr Duration PROBE_TIMEOUT{15000};                      // 15 seconds per probe
+    
+    // Segmented streams (FragmentDownloader)
+    constexpr size_t FRAGMENT_CONCURRENCY = 8;                    // Fragments in flight per stream
+    constexpr size_t FRAGMENT_WINDOW = 64;                        // Max fragments fetched ahead of the writer
+    
+    // Streaming resolver (YtDlpResolver)
+    constexpr size_t RESOLVER_CONCURRENCY = 4;                    // Extractions in flight
+    constexpr Duration MEDIA_CACHE_TTL{60LL * 60 * 1000};         // 1 hour
+    constexpr Duration MEDIA_EXPIRY_MARGIN{5LL * 60 * 1000};      // Before signed media URLs expire
+    
+    // Streaming while downloading (sequential mode, StreamServer)
+    constexpr ByteCount STREAM_WINDOW = 8 * 1024 * 1024;          // Fetched per worker, in file order
+    constexpr ByteCount STREAM_SEND_BUFFER = 1 * 1024 * 1024;     // Queued per client socket
+    
+    // Transfer tracing (TransferTrace)
+    constexpr size_t TRACE_CAPACITY = 512;                        // Attempts kept per task (ring)
     
     // Download limits
     constexpr size_t MAX_CONCURRENT_DOWNLOADS = 8;
@@ -113,29 +187,100 @@ namespace Constants {
     constexpr Duration PROGRESS_UPDATE_INTERVAL{100};             // 100ms
     constexpr Duration REBALANCE_INTERVAL{5000};                  // 5 seconds
     constexpr Duration PERSISTENCE_INTERVAL{5000};                // 5 seconds
+    constexpr Duration PERSISTENCE_BATCH_WINDOW{50};              // Gather writes per commit
     constexpr Duration SPEED_SAMPLE_INTERVAL{1000};               // 1 second
     constexpr Duration SPEED_SMOOTHING_WINDOW{10000};             // 10 seconds
+    constexpr Duration THROUGHPUT_TIME_CONSTANT{2000};            // Smoothing of sampled worker speed
+    constexpr Duration CONNECTION_TUNE_INTERVAL{2000};            // 2 seconds
     
     // Retry configuration
     constexpr size_t MAX_RETRIES = 5;
     constexpr Duration RETRY_BACKOFF_BASE{1000};                  // 1 second
     constexpr double RETRY_BACKOFF_MULTIPLIER = 2.0;
     constexpr Duration MAX_RETRY_DELAY{60000};                    // 1 minute
+    constexpr Duration RETRY_WHEEL_TICK{100};                     // Retry timing resolution
+    constexpr size_t RETRY_WHEEL_SLOTS = 1024;                    // ~100 s per revolution
     
     // Network timeouts
     constexpr Duration CONNECT_TIMEOUT{30000};                    // 30 seconds
     constexpr Duration READ_TIMEOUT{60000};                       // 60 seconds
     constexpr Duration DNS_TIMEOUT{10000};                        // 10 seconds
+    constexpr long LOW_SPEED_LIMIT = 1;                           // 1 byte/sec...
+    constexpr long LOW_SPEED_TIME = 60;                           // ...for 60 seconds
     
     // File operations
     constexpr ByteCount PERSISTENCE_CHECKPOINT_BYTES = 1 * 1024 * 1024;  // 1 MB
     constexpr size_t FILE_BUFFER_SIZE = 256 * 1024;               // 256 KB
+    constexpr size_t FILE_WRITE_BUFFER = 1 * 1024 * 1024;         // 1 MB write-behind batch
+    constexpr size_t WRITE_BUFFER_COUNT = 16;                     // Idle buffers kept for reuse
+    constexpr size_t DIRECT_IO_ALIGNMENT = 4096;                  // O_DIRECT block size
+    constexpr unsigned FILE_IO_QUEUE_DEPTH = 32;                  // io_uring / IOCP in flight
+    constexpr uint32_t RESUME_JOURNAL_RECORDS = 4096;             // Slots before compaction
+    constexpr ByteCount RESUME_JOURNAL_SYNC_BYTES = 32 * 1024 * 1024;  // 32 MB between flushes
+    constexpr ByteCount VERIFY_CHUNK = 64 * 1024 * 1024;          // Hashed per thread when the digest can be split
+    
+    // Memory budget (MemoryBudget)
+    constexpr size_t DEFAULT_MEMORY_BUDGET_MB = 64;               // Everything buffered, engine-wide
+    constexpr size_t MIN_MEMORY_BUDGET_MB = 8;
+    constexpr size_t MAX_MEMORY_BUDGET_MB = 4096;
+    constexpr ByteCount CURL_BUFFER_SIZE = 256 * 1024;            // Receive buffer while the budget allows
+    constexpr ByteCount CURL_MIN_BUFFER_SIZE = 16 * 1024;         // curl's default, always granted
+    
+    // Delta downloads (DeltaSync)
+    constexpr ByteCount DELTA_MIN_RUN = 64 * 1024;                // Shorter reused runs are downloaded instead
+    constexpr ByteCount MAX_ZSYNC_CONTROL_SIZE = 256 * 1024 * 1024; // ~100 GB of 2 KB blocks at 5 bytes each
+    
+    // Inline extraction (ArchiveExtractor)
+    constexpr ByteCount EXTRACT_READ_CHUNK = 1024 * 1024;         // Archive bytes read per pass
+    constexpr size_t EXTRACT_DECODE_BUFFER = 256 * 1024;          // Decompressed bytes per step
     
     // UI
     constexpr size_t SPEED_HISTORY_SIZE = 60;                     // 60 samples
+    constexpr size_t SPEED_BUCKET_COUNT = 40;                     // 250 ms buckets over the smoothing window
+    constexpr size_t SPEED_METER_SLOTS = 64;                      // Tasks counted by the global meter
     constexpr double ETA_SMOOTHING_FACTOR = 0.3;                  // Exponential smoothing
+    constexpr int VIEW_ROW_MARGIN = 4;                            // Rows refreshed beyond the visible range
+    constexpr int SEGMENT_MAP_CELLS = 256;                        // Resolution of the progress bar's segment map
 }
 
+// ═══════════════════════════════════════════════════════════════════════════════
+// Tunables
+// ═══════════════════════════════════════════════════════════════════════════════
+
+/**
+ * @brief Engine settings that can change at runtime
+ *
+ * Constants holds compile-time limits and defaults; everything a user or a
+ * deployment may adjust lives here instead. DownloadManager owns the active
+ * copy, persists it and hands it to every task (DownloadTask::setTunables()).
+ */
+struct EngineTunables {
+    // Queue
+    int maxConcurrentDownloads = static_cast<int>(Constants::DEFAULT_CONCURRENT_DOWNLOADS);
+    
+    // Segmentation
+    int maxSegmentsPerDownload = static_cast<int>(Constants::DEFAULT_SEGMENTS);    ///< Connection ceiling per task
+    int maxTotalConnections = static_cast<int>(Constants::DEFAULT_TOTAL_CONNECTIONS); ///< WorkerPool budget
+    int maxConnectionsPerHost = static_cast<int>(Constants::DEFAULT_HOST_CONNECTIONS); ///< HostGovernor ceiling
+    bool fastStart = true;                          ///< First ranged GET doubles as the probe
+    QStringList networkInterfaces;                  ///< Multipath: local interfaces/addresses (empty = default route)
+    
+    // Bandwidth
+    SpeedBps speedLimit = 0.0;                      ///< Global limit (0 = unlimited)
+    
+    // Memory
+    int memoryBudgetMB = static_cast<int>(Constants::DEFAULT_MEMORY_BUDGET_MB); ///< MemoryBudget cap
+    
+    // Integrity
+    bool verifySidecars = false;                    ///< Look for `<url>.sha256` when no hash is given
+    
+    // Monitoring
+    int metricsPort = 0;                            ///< Prometheus /metrics on localhost (0 = off)
+    bool metricsPublic = false;                     ///< Listen on all interfaces, not just loopback
+    
+    bool operator==(const EngineTunables&) const = default;
+};
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Server Capabilities
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -152,9 +297,45 @@ struct ServerCapabilities {
     QString etag;                       ///< For resume validation
     QString lastModified;               ///< For resume validation
     int httpStatusCode = 0;             ///< Response status
+    HttpProtocol protocol = HttpProtocol::Unknown;  ///< Negotiated by the probe
+    bool advertisesHttp3 = false;       ///< Alt-Svc offered h3
+    bool fromCache = false;             ///< Served by HostCache, not probed now
     
     bool isValid() const { return httpStatusCode >= 200 && httpStatusCode < 400; }
     bool canSegment() const { return supportsRanges && contentLength > 0; }
+    bool canMultiplex() const {
+        return protocol == HttpProtocol::Http2 || protocol == HttpProtocol::Http3;
+    }
+};
+
+/**
+ * @brief Raw HTTP response headers of interest (filled by HttpHeaderParser)
+ */
+struct HttpHeaderInfo {
+    int statusCode = 0;                 ///< From the status line
+    qint64 contentLength = -1;
+    qint64 rangeTotal = -1;             ///< Total size in a 206's Content-Range
+    bool acceptRanges = false;
+    bool contentEncoded = false;        ///< Content-Encoding present
+    bool advertisesHttp3 = false;       ///< Alt-Svc offered h3
+    bool hasLocation = false;           ///< Redirect target present
+    QString contentType;
+    QString contentDisposition;
+    QString fileName;                   ///< From contentDisposition, decoded
+    QString etag;                       ///< Strong tags unquoted, weak as W/"..."
+    QDateTime lastModified;
+    QString lastModifiedValue;          ///< Verbatim, for If-Unmodified-Since
+    QString server;
+    Duration retryAfter{-1};            ///< Retry-After of a 429/503 (-1 if absent)
+    uint8_t foldHeader = 0;             ///< Parser state: header a folded line continues
+
+    /**
+     * @brief Parse filename from Content-Disposition header
+     */
+    [[nodiscard]] std::optional<QString> parseFileName() const {
+        if (fileName.isEmpty()) return std::nullopt;
+        return fileName;
+    }
 };
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -223,6 +404,34 @@ inline QString downloadStateToString(DownloadState state) {
     }
 }
 
+/**
+ * @brief Share weight of a priority for connections and bandwidth
+ * 
+ * Urgent is also the foreground class: it is served before the others
+ * rather than only weighted higher.
+ */
+inline unsigned priorityWeight(Priority priority) {
+    switch (priority) {
+        case Priority::Low:    return 1;
+        case Priority::Normal: return 2;
+        case Priority::High:   return 4;
+        case Priority::Urgent: return 8;
+        default:               return 2;
+    }
+}
+
+/**
+ * @brief Convert HttpProtocol to string
+ */
+inline QString httpProtocolToString(HttpProtocol protocol) {
+    switch (protocol) {
+        case HttpProtocol::Http1: return QStringLiteral("HTTP/1.1");
+        case HttpProtocol::Http2: return QStringLiteral("HTTP/2");
+        case HttpProtocol::Http3: return QStringLiteral("HTTP/3");
+        default:                  return QStringLiteral("Unknown");
+    }
+}
+
 /**
  * @brief Convert SegmentState to string
  */
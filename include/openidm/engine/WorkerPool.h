@@ -0,0 +1,159 @@
+/**
+ * @file WorkerPool.h
+ * @brief Engine-wide connection budget and worker threads shared by all downloads
+ *
+ * Every DownloadTask used to size its workers on its own and start them on
+ * QThreadPool::globalInstance(), which Qt Concurrent and others share. The
+ * pool replaces that with one budget of connections for the whole engine:
+ * tasks state how many connections they want, the pool grants slots by
+ * priority weight, and slots freed by a finishing, paused or shrinking task
+ * go to the other active tasks at once instead of waiting for the queue
+ * timer.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <QThreadPool>
+
+namespace OpenIDM {
+
+// Forward declarations
+class DownloadTask;
+class SegmentWorker;
+
+/**
+ * @class WorkerPool
+ * @brief Grants connection slots to tasks and runs blocking workers
+ *
+ * Slots are handed out one at a time to the task with the highest
+ * weight / (granted + 1), so two Normal tasks split the budget evenly and an
+ * Urgent task gets four times the share of a Normal one. A task that wants
+ * any connection always gets at least one, even if the budget is exhausted,
+ * so no started download sits without a worker.
+ *
+ * Urgent tasks are foreground: when the budget is spent, they take slots
+ * from the other tasks (the one furthest over its share first, never its
+ * last slot) instead of waiting for one to free up.
+ *
+ * Workers stay bound to their task (the easy handle, output file and
+ * scheduler are per task); what moves between tasks is the slot. When a
+ * task's grant grows or shrinks it is told through
+ * DownloadTask::onConnectionsGranted().
+ *
+ * Thread Safety:
+ * - All methods are safe to call from any thread
+ * - Grant notifications are queued to the task's thread
+ */
+class WorkerPool {
+public:
+    /// @return Process-wide pool
+    static WorkerPool& instance();
+
+    // Disable copying
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Budget
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Set the number of connections shared by all tasks
+     *
+     * Shrinking does not stop running workers; the surplus is absorbed as
+     * tasks lower their demand or finish.
+     */
+    void setCapacity(size_t connections);
+
+    /// @return Connections shared by all tasks
+    size_t capacity() const;
+
+    /// @return Connections currently granted
+    size_t inUse() const;
+
+    /**
+     * @brief Declare how many connections a task wants
+     *
+     * Lowering the demand frees slots for other tasks immediately; raising
+     * it grants what the budget allows now and queues the rest.
+     *
+     * @return Connections granted to the task
+     */
+    size_t request(DownloadTask* task, size_t wanted);
+
+    /**
+     * @brief Drop a task's claim and redistribute its slots
+     */
+    void release(DownloadTask* task);
+
+    /// @return Connections granted to the task (0 if it has no claim)
+    size_t granted(DownloadTask* task) const;
+
+    /**
+     * @brief Re-run the assignment after a task's priority changed
+     */
+    void reprioritize();
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Threads
+    // ───────────────────────────────────────────────────────────────────────
+
+    /**
+     * @brief Run a blocking worker on the pool's own threads
+     *
+     * Used when the TransferEngine is not running. Threads persist between
+     * downloads so starting a segment never pays for thread creation.
+     */
+    void start(SegmentWorker* worker);
+
+    /**
+     * @brief Wait until a stopped worker is no longer used by the pool
+     *
+     * Workers are not auto-deleted, so their owner must call this before
+     * destroying one. A worker still queued is taken back without running;
+     * one that is running is waited for until run() returns. Returns at
+     * once for workers never passed to start().
+     */
+    void finish(SegmentWorker* worker);
+
+    /// @return Threads available to blocking workers
+    int threadCount() const { return m_threads.maxThreadCount(); }
+
+private:
+    WorkerPool();
+
+    struct Claim {
+        size_t wanted{0};
+        size_t granted{0};
+    };
+
+    /**
+     * @brief Hand free slots to the most deserving claims
+     * @param[out] notify Tasks whose grant changed
+     * @note Caller must hold m_mutex
+     */
+    void redistribute(std::vector<DownloadTask*>& notify);
+
+    /**
+     * @brief Move slots from background claims to unsatisfied urgent ones
+     * @note Caller must hold m_mutex
+     */
+    void preempt(std::vector<DownloadTask*>& notify);
+
+    static void notifyGranted(const std::vector<DownloadTask*>& tasks);
+
+    QThreadPool m_threads;
+
+    std::unordered_map<DownloadTask*, Claim> m_claims;
+    size_t m_capacity{Constants::DEFAULT_TOTAL_CONNECTIONS};
+    size_t m_inUse{0};
+    mutable std::mutex m_mutex;
+};
+
+} // namespace OpenIDM
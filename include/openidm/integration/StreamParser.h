@@ -0,0 +1,110 @@
+/**
+ * @file StreamParser.h
+ * @brief Parser for HLS/M3U8 and other streaming formats
+ */
+
+#pragma once
+
+#include "openidm/engine/FragmentDownloader.h"
+
+#include <QString>
+#include <QUrl>
+
+#include <vector>
+
+namespace OpenIDM {
+
+/**
+ * @brief Represents a segment in an HLS stream
+ */
+struct HlsSegment {
+    QString url;
+    double duration;
+    QString title;
+    int sequenceNumber;
+    bool isDiscontinuity;
+    qint64 byteRangeStart = -1;     ///< EXT-X-BYTERANGE offset, -1 = whole resource
+    qint64 byteRangeLength = 0;
+    QString keyUrl;                 ///< AES-128 key in effect, empty = clear
+    QByteArray keyIv;               ///< Explicit IV; empty = derived from sequenceNumber
+};
+
+/**
+ * @brief Represents an HLS variant stream
+ */
+struct HlsVariant {
+    QString url;
+    int bandwidth;
+    QString resolution;
+    QString codecs;
+    QString audio;
+    QString subtitles;
+};
+
+/**
+ * @brief Parsed HLS playlist
+ */
+struct HlsPlaylist {
+    bool isMaster;
+    int targetDuration;
+    int mediaSequence;
+    bool isEndList;
+    std::vector<HlsVariant> variants;
+    std::vector<HlsSegment> segments;
+    HlsSegment initSection{};       ///< EXT-X-MAP; url is empty without one
+    bool unsupportedKey = false;    ///< SAMPLE-AES or another method we cannot decrypt
+};
+
+/**
+ * @class StreamParser
+ * @brief Parses HLS/M3U8 playlists
+ */
+class StreamParser {
+public:
+    /**
+     * @brief Check if content is an M3U8 playlist
+     * @param content Content to check
+     * @return True if content is M3U8
+     */
+    static bool isM3U8(const QString& content);
+
+    /**
+     * @brief Parse an M3U8 playlist
+     * @param content Playlist content
+     * @param baseUrl Base URL for resolving relative URLs
+     * @return Parsed playlist structure
+     */
+    static HlsPlaylist parseM3U8(const QString& content, const QUrl& baseUrl);
+
+    /**
+     * @brief Fragment list of a media playlist, for FragmentDownloader
+     * @param playlist Parsed media playlist
+     * @return Empty for master or live playlists and unsupported encryption
+     */
+    static FragmentList fragments(const HlsPlaylist& playlist);
+
+    /**
+     * @brief Get total duration of all segments
+     * @param playlist Parsed playlist
+     * @return Total duration in seconds
+     */
+    static double totalDuration(const HlsPlaylist& playlist);
+
+    /**
+     * @brief Get best quality variant
+     * @param playlist Master playlist
+     * @return Variant with highest bandwidth
+     */
+    static const HlsVariant* bestVariant(const HlsPlaylist& playlist);
+
+private:
+    /**
+     * @brief Resolve a potentially relative URL
+     * @param url URL to resolve
+     * @param baseUrl Base URL for resolution
+     * @return Absolute URL
+     */
+    static QString resolveUrl(const QString& url, const QUrl& baseUrl);
+};
+
+} // namespace OpenIDM
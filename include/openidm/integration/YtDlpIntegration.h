@@ -5,6 +5,10 @@
 
 #pragma once
 
+#include "openidm/engine/FragmentDownloader.h"
+#include "openidm/integration/YtDlpOutputParser.h"
+
+#include <QJsonObject>
 #include <QObject>
 #include <QUrl>
 #include <QString>
@@ -14,36 +18,6 @@
 
 namespace OpenIDM {
 
-/**
- * @brief Information about a video format option
- */
-struct FormatInfo {
-    QString formatId;       ///< Format identifier
-    QString ext;            ///< File extension
-    QString resolution;     ///< Video resolution (e.g., "1920x1080")
-    qint64 filesize;        ///< File size in bytes (-1 if unknown)
-    QString vcodec;         ///< Video codec
-    QString acodec;         ///< Audio codec
-    double tbr;             ///< Total bitrate
-    QString note;           ///< Format note (e.g., "1080p")
-};
-
-/**
- * @brief Extracted video information
- */
-struct VideoInfo {
-    QString url;            ///< Original URL
-    QString title;          ///< Video title
-    QString description;    ///< Video description
-    int duration;           ///< Duration in seconds
-    QString thumbnail;      ///< Thumbnail URL
-    QString uploader;       ///< Uploader name
-    QString uploadDate;     ///< Upload date (YYYYMMDD)
-    QString bestFormat;     ///< Best format ID
-    QString directUrl;      ///< Direct download URL
-    QList<FormatInfo> formats;  ///< Available formats
-};
-
 /**
  * @class YtDlpIntegration
  * @brief Wrapper for yt-dlp external process
@@ -57,8 +31,8 @@ struct VideoInfo {
 class YtDlpIntegration : public QObject {
     Q_OBJECT
     
-    Q_PROPERTY(bool available READ isAvailable CONSTANT)
-    Q_PROPERTY(QString version READ version CONSTANT)
+    Q_PROPERTY(bool available READ isAvailable NOTIFY availabilityChanged)
+    Q_PROPERTY(QString version READ version NOTIFY availabilityChanged)
 
 public:
     explicit YtDlpIntegration(QObject* parent = nullptr);
@@ -66,6 +40,7 @@ public:
     
     /**
      * @brief Check if yt-dlp is available
+     * @note False until YtDlpResolver has finished looking for it
      */
     bool isAvailable() const;
     
@@ -85,10 +60,21 @@ public:
      * @brief Extract video information
      * @param url Video URL
      * 
-     * Emits infoExtracted() on success or error() on failure.
+     * Resolved by the shared YtDlpResolver (warm helper process, cached
+     * results). Emits infoExtracted() on success or error() on failure.
      */
     Q_INVOKABLE void extractInfo(const QUrl& url);
     
+    /**
+     * @brief Extract every entry of a playlist or channel
+     * @param url Playlist URL
+     * @param flat List entries without resolving each video (fast, no formats)
+     * 
+     * Entries are parsed off the GUI thread as yt-dlp prints them and arrive
+     * in batches through playlistEntries(), then playlistExtracted().
+     */
+    Q_INVOKABLE void extractPlaylist(const QUrl& url, bool flat = true);
+    
     /**
      * @brief Download video
      * @param url Video URL
@@ -96,6 +82,9 @@ public:
      * @param format Format ID (empty for best)
      * 
      * Emits progress() during download, finished() or error() at end.
+     * HLS and DASH formats of the last extractInfo() for @p url are fetched
+     * by FragmentDownloader (parallel fragments, AES-128, in-order append);
+     * merged formats ("137+140") and everything else go through yt-dlp.
      */
     Q_INVOKABLE void download(const QUrl& url, 
                                const QString& outputPath,
@@ -113,6 +102,18 @@ signals:
      */
     void infoExtracted(const VideoInfo& info);
     
+    /**
+     * @brief Next playlist entries, in playlist order
+     * @param entries Entries parsed since the last signal
+     */
+    void playlistEntries(const QList<VideoInfo>& entries);
+    
+    /**
+     * @brief Playlist extraction completed
+     * @param count Total number of entries
+     */
+    void playlistExtracted(int count);
+    
     /**
      * @brief Download progress update
      * @param percent Progress percentage (0-100)
@@ -132,23 +133,30 @@ signals:
      */
     void error(const QString& message);
     
+    /**
+     * @brief yt-dlp was found (or not) in the background
+     */
+    void availabilityChanged();
+    
 private slots:
     void onProcessOutput();
     void onProcessError();
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     
 private:
-    QString findYtDlp() const;
+    const FormatInfo* nativeFormat(const QUrl& url, const QString& format) const;
+    bool startNative(const FormatInfo& format, const QString& outputPath);
+    QString expandTemplate(const QString& outputPath, const FormatInfo& format) const;
     
     QProcess* m_process;
-    QString m_ytdlpPath;
+    FragmentDownloader* m_fragments;
+    YtDlpOutputParser* m_parser;    ///< Playlist JSON lines, off the GUI thread
+    bool m_playlist;        ///< m_process is extracting a playlist
+    VideoInfo m_lastInfo;   ///< From the last extractInfo()
+    quint64 m_resolveId;    ///< Pending YtDlpResolver request, 0 = none
     QUrl m_currentUrl;
-    QByteArray m_outputBuffer;
+    QByteArray m_outputBuffer;  ///< Partial progress line
     QByteArray m_errorBuffer;
 };
 
 } // namespace OpenIDM
-
-// Register metatypes for signal/slot
-Q_DECLARE_METATYPE(OpenIDM::VideoInfo)
-Q_DECLARE_METATYPE(OpenIDM::FormatInfo)
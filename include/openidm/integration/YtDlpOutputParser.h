@@ -0,0 +1,214 @@
+/**
+ * @file YtDlpOutputParser.h
+ * @brief Incremental parser for yt-dlp's JSON-lines and progress output
+ *
+ * `yt-dlp -j` on a playlist prints one JSON document per entry, tens of MB
+ * for large playlists. YtDlpOutputParser splits the byte stream into lines
+ * as it arrives, parses each line on its own thread and hands back
+ * VideoInfo entries in batches, so the list fills progressively and only
+ * the current partial line is ever buffered.
+ */
+
+#pragma once
+
+#include "openidm/engine/FragmentDownloader.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+namespace OpenIDM {
+
+// ───────────────────────────────────────────────────────────────────────────
+// Extracted Information
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Information about a video format option
+ */
+struct FormatInfo {
+    QString formatId;       ///< Format identifier
+    QString ext;            ///< File extension
+    QString resolution;     ///< Video resolution (e.g., "1920x1080")
+    qint64 filesize;        ///< File size in bytes (-1 if unknown)
+    QString vcodec;         ///< Video codec
+    QString acodec;         ///< Audio codec
+    double tbr;             ///< Total bitrate
+    QString note;           ///< Format note (e.g., "1080p")
+    QString url;            ///< Media URL; the playlist for HLS
+    QString protocol;       ///< yt-dlp protocol ("https", "m3u8_native", "http_dash_segments", ...)
+    QStringList httpHeaders;    ///< Headers the site expects ("Name: value")
+    FragmentList fragments;     ///< DASH fragments, if yt-dlp listed them
+};
+
+/**
+ * @brief Extracted video information
+ */
+struct VideoInfo {
+    QString url;            ///< Original URL
+    QString title;          ///< Video title
+    QString description;    ///< Video description
+    int duration;           ///< Duration in seconds
+    QString thumbnail;      ///< Thumbnail URL
+    QString uploader;       ///< Uploader name
+    QString uploadDate;     ///< Upload date (YYYYMMDD)
+    QString bestFormat;     ///< Best format ID
+    QString directUrl;      ///< Direct download URL
+    QList<FormatInfo> formats;  ///< Available formats
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// Parser
+// ───────────────────────────────────────────────────────────────────────────
+
+/**
+ * @class YtDlpOutputParser
+ * @brief Line-by-line JSON parsing of yt-dlp stdout on a worker thread
+ *
+ * feed() takes chunks as read from the process, finish() marks the end of
+ * output. Entries parsed during one wake-up of the worker are delivered in
+ * a single entries() signal.
+ *
+ * Thread Safety:
+ * - Call the public methods from the owning (GUI) thread
+ * - Signals are emitted on the owning thread
+ * - The static helpers are reentrant
+ */
+class YtDlpOutputParser : public QObject {
+    Q_OBJECT
+
+public:
+    explicit YtDlpOutputParser(QObject* parent = nullptr);
+    ~YtDlpOutputParser() override;
+
+    // Disable copying
+    YtDlpOutputParser(const YtDlpOutputParser&) = delete;
+    YtDlpOutputParser& operator=(const YtDlpOutputParser&) = delete;
+
+    /**
+     * @brief Begin a new output stream, dropping any previous one
+     * @param sourceUrl Stored as VideoInfo::url when an entry has no URL of its own
+     */
+    void start(const QString& sourceUrl = QString());
+
+    /// Queue a chunk of stdout; cheap, the parsing happens on the worker
+    void feed(QByteArray chunk);
+
+    /// No more output: parse the last line, then emit finished()
+    void finish();
+
+    /// Stop and join the worker; nothing more is emitted for this stream
+    void cancel();
+
+    /// @return True between start() and finished()/cancel()
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Call @p handler for each complete line of @p chunk
+     *
+     * Bytes after the last newline are kept in @p pending and prefixed to
+     * the next chunk. Lines are views into @p pending or @p chunk, valid
+     * during the call only; a trailing '\r' is stripped.
+     */
+    template <typename Handler>
+    static void forEachLine(QByteArray& pending, QByteArrayView chunk, Handler&& handler);
+
+    /**
+     * @brief Parse a yt-dlp progress line without regex or QString
+     *
+     * Accepts "[download]  42.0% of ~ 10.00MiB at  2.50MiB/s ETA 00:03".
+     *
+     * @param line One output line
+     * @param percent Set to the percentage (0-100)
+     * @param speed Set to bytes/sec, 0 if not reported yet
+     * @return False if @p line is not a download progress line
+     */
+    static bool parseProgress(QByteArrayView line, double& percent, double& speed);
+
+    /**
+     * @brief Convert one yt-dlp info dictionary
+     * @param obj Info dictionary (one `-j` line)
+     * @param sourceUrl VideoInfo::url; empty = the entry's webpage_url or url
+     */
+    static VideoInfo videoInfo(const QJsonObject& obj, const QString& sourceUrl = QString());
+
+signals:
+    /// Entries in output order, several per signal under load
+    void entries(const QList<VideoInfo>& batch);
+
+    /// Emitted after the last entries() batch
+    void finished(int count);
+
+private:
+    void run();
+
+    std::thread m_worker;
+    std::atomic<bool> m_running{false};
+    quint64 m_generation{0};            ///< Drops batches of a cancelled stream
+
+    // Guarded by m_mutex
+    std::deque<QByteArray> m_chunks;
+    bool m_endOfInput{false};
+    bool m_stopping{false};
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+
+    // Worker thread only
+    QString m_sourceUrl;
+    QByteArray m_pending;
+    int m_count{0};
+};
+
+// ───────────────────────────────────────────────────────────────────────────
+// Template Implementation
+// ───────────────────────────────────────────────────────────────────────────
+
+template <typename Handler>
+void YtDlpOutputParser::forEachLine(QByteArray& pending, QByteArrayView chunk, Handler&& handler) {
+    auto emitLine = [&handler](QByteArrayView line) {
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        if (!line.isEmpty()) {
+            handler(line);
+        }
+    };
+
+    qsizetype newline = chunk.indexOf('\n');
+    if (newline < 0) {
+        pending.append(chunk);
+        return;
+    }
+
+    // The partial line from the previous chunk completes first
+    if (!pending.isEmpty()) {
+        pending.append(chunk.first(newline));
+        emitLine(pending);
+        pending.clear();
+    } else {
+        emitLine(chunk.first(newline));
+    }
+
+    qsizetype start = newline + 1;
+    while ((newline = chunk.indexOf('\n', start)) >= 0) {
+        emitLine(chunk.sliced(start, newline - start));
+        start = newline + 1;
+    }
+    pending.append(chunk.sliced(start));
+}
+
+} // namespace OpenIDM
+
+// Register metatypes for signal/slot
+Q_DECLARE_METATYPE(OpenIDM::VideoInfo)
+Q_DECLARE_METATYPE(OpenIDM::FormatInfo)
@@ -0,0 +1,149 @@
+/**
+ * @file YtDlpResolver.h
+ * @brief Warm yt-dlp extractor process shared by all resolutions
+ *
+ * Running `yt-dlp -j` per URL pays for a Python interpreter start and the
+ * import of every extractor (about a second) before any network request.
+ * YtDlpResolver keeps one helper process with yt_dlp imported, feeds it
+ * JSON-lines requests and reads JSON-lines answers, several in flight at
+ * once. Results are cached in the SQLite store until the extracted media
+ * URLs expire.
+ */
+
+#pragma once
+
+#include "openidm/engine/Types.h"
+
+#include <deque>
+#include <map>
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QUrl>
+
+namespace OpenIDM {
+
+class PersistenceManager;
+
+/**
+ * @class YtDlpResolver
+ * @brief Queue of yt-dlp info extractions over a persistent helper
+ *
+ * The helper is `python -c <script>` with the interpreter that runs the
+ * installed yt-dlp. Where yt_dlp cannot be imported (standalone binary
+ * builds), requests fall back to one `yt-dlp -j` process each, at most
+ * Constants::RESOLVER_CONCURRENCY at a time.
+ *
+ * Thread Safety:
+ * - GUI thread only
+ */
+class YtDlpResolver : public QObject {
+    Q_OBJECT
+
+public:
+    /// @return Process-wide resolver
+    static YtDlpResolver& instance();
+
+    // Disable copying
+    YtDlpResolver(const YtDlpResolver&) = delete;
+    YtDlpResolver& operator=(const YtDlpResolver&) = delete;
+
+    /**
+     * @brief Use the SQLite store as on-disk result cache
+     * @param persistence Store to use (nullptr = no cache)
+     */
+    void attach(PersistenceManager* persistence);
+
+    /**
+     * @brief Look for yt-dlp in the background
+     *
+     * Emits availabilityChanged() when done. Called on first use; call it
+     * at startup to have isAvailable() answered before the first resolve.
+     */
+    void locate();
+
+    /// @return True once locate() found yt-dlp
+    bool isAvailable() const { return !m_ytdlpPath.isEmpty(); }
+
+    /// @return True while locate() is still looking
+    bool isLocating() const { return m_locating; }
+
+    /// @return Path of the yt-dlp executable, empty if not found (yet)
+    QString ytDlpPath() const { return m_ytdlpPath; }
+
+    /// @return yt-dlp version reported by the helper or `--version`
+    QString version() const { return m_version; }
+
+    /**
+     * @brief Use a specific yt-dlp executable instead of searching for it
+     */
+    void setYtDlpPath(const QString& path);
+
+    /**
+     * @brief Queue an info extraction
+     * @param url Page or media URL
+     * @param format yt-dlp format selector (empty = its default)
+     * @return Request id passed to resolved()/failed()
+     */
+    quint64 resolve(const QUrl& url, const QString& format = QString());
+
+    /// Drop a queued request; one already running completes unreported
+    void cancel(quint64 id);
+
+signals:
+    /// Emitted once locate() finished
+    void availabilityChanged(bool available);
+
+    /// Emitted with yt-dlp's info dictionary, from the cache or the extractor
+    void resolved(quint64 id, const QJsonObject& info);
+
+    /// Emitted when the extraction failed
+    void failed(quint64 id, const QString& message);
+
+private:
+    YtDlpResolver();
+
+    struct Request {
+        quint64 id;
+        QUrl url;
+        QString format;
+    };
+
+    enum class Mode { Unknown, Helper, Processes };
+
+    void dispatch();
+    void startHelper();
+    void onHelperOutput();
+    void onHelperFinished();
+    void handleLine(QByteArrayView line);
+    void startProcess(const Request& request);
+    void finish(const Request& request, const QJsonObject& info);
+    void fail(const Request& request, const QString& message);
+
+    static QString cacheKey(const QUrl& url, const QString& format);
+    static qint64 expiryOf(const QJsonObject& info);
+
+    PersistenceManager* m_persistence{nullptr};
+    QString m_ytdlpPath;
+    QString m_python;               ///< Interpreter that can import yt_dlp
+    QString m_version;
+    bool m_locating{false};
+    bool m_located{false};
+
+    Mode m_mode{Mode::Unknown};
+    QProcess* m_helper{nullptr};
+    bool m_helperReady{false};
+    int m_helperRestarts{0};
+    QByteArray m_helperBuffer;
+
+    quint64 m_nextId{1};
+    std::deque<Request> m_queue;
+    std::map<quint64, Request> m_running;   ///< Sent to the helper or a process
+    std::map<QProcess*, quint64> m_processes;
+};
+
+} // namespace OpenIDM
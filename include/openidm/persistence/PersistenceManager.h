@@ -8,14 +8,15 @@
 #include "openidm/engine/Types.h"
 #include <memory>
 #include <vector>
-#include <queue>
 #include <mutex>
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <future>
 
 #include <QObject>
 #include <QSqlDatabase>
+#include <QStringList>
 
 namespace OpenIDM {
 
@@ -38,6 +39,30 @@ struct TaskData {
     qint64 updatedAt;
     QString contentType;
     QString errorMessage;
+    QString expectedHash;       ///< ExpectedHash::toString(), empty if none
+    QStringList mirrors;        ///< Equivalent URLs besides url (SourceSet)
+    Priority priority = Priority::Normal;
+};
+
+/**
+ * @brief What the capability cache knows about one host
+ */
+struct HostRecord {
+    QString host;               ///< Lower-case host[:port]
+    bool supportsRanges = false;
+    HttpProtocol protocol = HttpProtocol::Unknown;
+    bool advertisesHttp3 = false;
+    int connections = 0;        ///< Learned connection optimum (0 = unknown)
+    qint64 updatedAt = 0;       ///< Milliseconds since epoch
+};
+
+/**
+ * @brief Probe result for one resource, kept by the capability cache
+ */
+struct ResourceRecord {
+    QString url;                ///< TaskRegistry::normalizeUrl() form
+    ServerCapabilities capabilities;
+    qint64 updatedAt = 0;       ///< Milliseconds since epoch
 };
 
 /**
@@ -46,7 +71,9 @@ struct TaskData {
  * 
  * Features:
  * - WAL mode for crash resilience
- * - Asynchronous writes to avoid blocking
+ * - Asynchronous writes to avoid blocking, batched by a writer thread that
+ *   coalesces repeated task/segment updates and commits each batch in one
+ *   transaction on its own connection
  * - Periodic checkpoints
  * - Full task and segment state persistence
  */
@@ -79,6 +106,14 @@ public:
      */
     void saveTask(DownloadTask* task);
     
+    /**
+     * @brief Save many tasks in one write transaction
+     *
+     * For bulk imports: the records are queued at once, so the writer
+     * commits them together instead of one batch window at a time.
+     */
+    void saveTasks(const std::vector<DownloadTask*>& tasks);
+    
     /**
      * @brief Load all tasks from database
      * @return Vector of task data
@@ -116,6 +151,13 @@ public:
      */
     void saveSegments(const TaskId& taskId, const std::vector<Segment*>& segments);
     
+    /**
+     * @brief Replace all of a task's segment rows
+     * @param taskId Parent task ID
+     * @param snapshots Complete layout; rows of segments not in it are removed
+     */
+    void replaceSegments(const TaskId& taskId, std::vector<Segment::Snapshot> snapshots);
+    
     /**
      * @brief Load segments for a task
      * @param taskId Task ID
@@ -142,6 +184,57 @@ public:
      */
     QString loadSetting(const QString& key, const QString& defaultValue = QString());
     
+    // ─────────────────────────────────────────────────────────────────────
+    // Capability Cache
+    // ─────────────────────────────────────────────────────────────────────
+    
+    /**
+     * @brief Save what is known about a host
+     * @param record Host entry (replaces the previous one)
+     */
+    void saveHostRecord(const HostRecord& record);
+    
+    /**
+     * @brief Save the probe result of a resource
+     * @param record Resource entry (replaces the previous one)
+     */
+    void saveResourceRecord(const ResourceRecord& record);
+    
+    /**
+     * @brief Forget a resource entry
+     * @param url Normalized URL
+     */
+    void deleteResourceRecord(const QString& url);
+    
+    /**
+     * @brief Load all host entries
+     */
+    std::vector<HostRecord> loadHostRecords();
+    
+    /**
+     * @brief Load all resource entries
+     */
+    std::vector<ResourceRecord> loadResourceRecords();
+    
+    // ─────────────────────────────────────────────────────────────────────
+    // Media Info Cache
+    // ─────────────────────────────────────────────────────────────────────
+    
+    /**
+     * @brief Save an extractor result (yt-dlp info JSON)
+     * @param key URL and format selector
+     * @param info Compact JSON document
+     * @param expiresAt Milliseconds since epoch
+     */
+    void saveMediaInfo(const QString& key, const QByteArray& info, qint64 expiresAt);
+    
+    /**
+     * @brief Load an extractor result that has not expired
+     * @param key URL and format selector
+     * @return JSON document, or nullopt
+     */
+    std::optional<QByteArray> loadMediaInfo(const QString& key);
+    
     // ─────────────────────────────────────────────────────────────────────
     // Maintenance
     // ─────────────────────────────────────────────────────────────────────
@@ -171,8 +264,13 @@ private:
     enum class WriteOp {
         SaveTask,
         SaveSegment,
+        ReplaceSegments,
         DeleteTask,
-        SaveSetting
+        SaveSetting,
+        SaveHost,
+        SaveResource,
+        DeleteResource,
+        SaveMedia
     };
     
     struct WriteRequest {
@@ -180,8 +278,13 @@ private:
         TaskId taskId;
         TaskData taskData;
         Segment::Snapshot segmentSnapshot;
+        std::vector<Segment::Snapshot> segmentSnapshots;
         QString key;
         QString value;
+        HostRecord hostRecord;
+        ResourceRecord resourceRecord;
+        QByteArray blob;
+        qint64 expiresAt = 0;
     };
     
     // Database setup
@@ -189,21 +292,43 @@ private:
     bool migrateSchema();
     
     // Async write handling
-    void writeThreadLoop();
+    void writeThreadLoop(std::promise<bool> ready);
+    bool openWriterConnection();
+    void closeWriterConnection();
+    void processBatch(std::vector<WriteRequest>& batch);
     void processWrite(const WriteRequest& request);
     void enqueueWrite(WriteRequest request);
+    void enqueueWrites(std::vector<WriteRequest> requests);
+    void appendSave(DownloadTask* task, std::vector<WriteRequest>& requests);
     
-    // Internal operations
+    /**
+     * @brief Reduce a batch to the latest value per key, in first-seen order
+     *
+     * A DeleteTask drops the task's earlier saves; saves after it survive.
+     */
+    static std::vector<WriteRequest> coalesce(std::vector<WriteRequest>& batch);
+    
+    // Internal operations (writer thread, inside the batch transaction)
     void doSaveTask(const TaskData& data);
     void doSaveSegment(const TaskId& taskId, const Segment::Snapshot& snap);
+    void doReplaceSegments(const TaskId& taskId, const std::vector<Segment::Snapshot>& snapshots);
     void doDeleteTask(const TaskId& id);
     void doSaveSetting(const QString& key, const QString& value);
+    void doSaveHost(const HostRecord& record);
+    void doSaveResource(const ResourceRecord& record);
+    void doDeleteResource(const QString& url);
+    void doSaveMedia(const QString& key, const QByteArray& info, qint64 expiresAt);
     
-    QSqlDatabase m_database;
+    QSqlDatabase m_database;            ///< Reads, maintenance (owner thread)
     QString m_dbPath;
     
+    // Writer thread state: its own connection and prepared statements
+    struct Statements;
+    QSqlDatabase m_writer;
+    std::unique_ptr<Statements> m_statements;
+    
     // Async write queue
-    std::queue<WriteRequest> m_writeQueue;
+    std::vector<WriteRequest> m_writeQueue;
     std::mutex m_queueMutex;
     std::condition_variable m_queueCondition;
     std::thread m_writeThread;
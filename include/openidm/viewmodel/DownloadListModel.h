@@ -8,6 +8,9 @@
 #include <QAbstractListModel>
 #include <QHash>
 #include <QTimer>
+#include <QUuid>
+
+#include <vector>
 
 namespace OpenIDM {
 
@@ -20,11 +23,20 @@ class DownloadTask;
  * 
  * Provides a Qt model interface for QML ListView binding.
  * Implements role-based data access for download properties.
+ * 
+ * Archived downloads (completed, without a DownloadTask) are rows that
+ * carry only their ID; their fields are looked up when a delegate asks.
+ * 
+ * Progress updates are incremental: each tick collects the DirtyField bits
+ * of the rows the view shows and emits one dataChanged per run of adjacent
+ * rows with the same changes, naming only the affected roles. Nothing is
+ * emitted while the view is hidden.
  */
 class DownloadListModel : public QAbstractListModel {
     Q_OBJECT
     
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(bool viewVisible READ viewVisible WRITE setViewVisible NOTIFY viewVisibleChanged)
 
 public:
     // Model roles
@@ -45,7 +57,8 @@ public:
         ActiveSegmentsRole,
         TotalSegmentsRole,
         ContentTypeRole,
-        PriorityRole
+        PriorityRole,
+        SegmentMapRole              ///< DownloadTask::segmentMap(), drawn by SegmentBar
     };
     Q_ENUM(DownloadRoles)
     
@@ -61,22 +74,63 @@ public:
     Q_INVOKABLE int indexOf(const QString& taskId) const;
     Q_INVOKABLE QString taskIdAt(int index) const;
     
+    // ───────────────────────────────────────────────────────────────────────
+    // View Tracking
+    // ───────────────────────────────────────────────────────────────────────
+    
+    /**
+     * @brief Rows currently on screen
+     * @param first First visible row
+     * @param last Last visible row (-1 = through the end)
+     *
+     * Rows outside the range (plus Constants::VIEW_ROW_MARGIN) keep their
+     * dirty bits until they scroll into view.
+     */
+    Q_INVOKABLE void setVisibleRange(int first, int last);
+    
+    /// @return False while the window is hidden or minimized
+    bool viewVisible() const { return m_viewVisible; }
+    
+    /// @brief Stop (false) or resume (true) progress updates
+    void setViewVisible(bool visible);
+    
 signals:
     void countChanged();
+    void viewVisibleChanged();
     
 private slots:
     void onDownloadAdded(const QUuid& id);
+    void onDownloadsAdded(const std::vector<QUuid>& ids);
     void onDownloadRemoved(const QUuid& id);
+    void onArchiveCleared();
     void onProgressTimer();
     
 private:
     void refreshTaskList();
+    void rebuildIndex(int from = 0);
     int findTaskIndex(const QUuid& id) const;
+    void emitRowsChanged(int first, int last, uint32_t fields);
+    
+    /**
+     * @brief One list entry; task is nullptr for archived downloads
+     */
+    struct Row {
+        QUuid id;
+        DownloadTask* task{nullptr};
+    };
+    
+    QVariant archivedData(const QUuid& id, int role) const;
     
     DownloadManager* m_manager;
-    QList<DownloadTask*> m_tasks;
+    QList<Row> m_rows;
+    QHash<QUuid, int> m_rowIndex;       ///< Task ID -> row
     QHash<int, QByteArray> m_roleNames;
     QTimer* m_updateTimer;
+    
+    // View tracking
+    int m_visibleFirst{0};
+    int m_visibleLast{-1};
+    bool m_viewVisible{true};
 };
 
 } // namespace OpenIDM
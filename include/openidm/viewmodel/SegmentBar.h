@@ -0,0 +1,74 @@
+/**
+ * @file SegmentBar.h
+ * @brief Scene-graph item drawing a download's segment map
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QColor>
+#include <QQuickItem>
+
+namespace OpenIDM {
+
+/**
+ * @class SegmentBar
+ * @brief Draws a segment map as colored runs in one geometry node
+ *
+ * The map is the byte array DownloadTask::segmentMap() returns: one
+ * RangeState per slice of the file. Adjacent slices in the same state are
+ * drawn as one quad, so a bar costs a single node and a few dozen
+ * vertices however many segments the download has, and a progress tick
+ * that leaves the map unchanged costs nothing.
+ *
+ * Pending slices are left transparent by default so the track behind the
+ * item shows through.
+ */
+class SegmentBar : public QQuickItem {
+    Q_OBJECT
+
+    Q_PROPERTY(QByteArray segmentMap READ segmentMap WRITE setSegmentMap NOTIFY segmentMapChanged)
+    Q_PROPERTY(int cells READ cells NOTIFY segmentMapChanged)
+    Q_PROPERTY(QColor completedColor READ completedColor WRITE setCompletedColor NOTIFY colorsChanged)
+    Q_PROPERTY(QColor activeColor READ activeColor WRITE setActiveColor NOTIFY colorsChanged)
+    Q_PROPERTY(QColor pendingColor READ pendingColor WRITE setPendingColor NOTIFY colorsChanged)
+
+public:
+    explicit SegmentBar(QQuickItem* parent = nullptr);
+
+    // ───────────────────────────────────────────────────────────────────────
+    // Properties
+    // ───────────────────────────────────────────────────────────────────────
+
+    QByteArray segmentMap() const { return m_segmentMap; }
+    void setSegmentMap(const QByteArray& map);
+
+    /// @return Slices in the map; 0 while the file size is unknown
+    int cells() const { return static_cast<int>(m_segmentMap.size()); }
+
+    QColor completedColor() const { return m_colors[2]; }
+    void setCompletedColor(const QColor& color) { setColor(2, color); }
+
+    /// @brief Color of bytes assigned to a segment but not yet received
+    QColor activeColor() const { return m_colors[1]; }
+    void setActiveColor(const QColor& color) { setColor(1, color); }
+
+    QColor pendingColor() const { return m_colors[0]; }
+    void setPendingColor(const QColor& color) { setColor(0, color); }
+
+signals:
+    void segmentMapChanged();
+    void colorsChanged();
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+
+private:
+    void setColor(int state, const QColor& color);
+
+    QByteArray m_segmentMap;
+    QColor m_colors[3];                 ///< Indexed by RangeState
+};
+
+} // namespace OpenIDM
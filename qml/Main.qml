@@ -2,6 +2,7 @@ import QtQuick 2.15
 import QtQuick.Window 2.15
 import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
+import QtQuick.Dialogs
 import "theme"
 import "views"
 import "components"
@@ -27,6 +28,13 @@ ApplicationWindow {
     title: qsTr("OpenIDM - Download Manager")
     color: Theme.background
     
+    // Pause list progress updates while nobody can see them
+    Binding {
+        target: downloadListModel
+        property: "viewVisible"
+        value: window.visible && window.visibility !== Window.Minimized
+    }
+    
     // Background gradient
     Rectangle {
         anchors.fill: parent
@@ -220,6 +228,14 @@ ApplicationWindow {
                         onClicked: addDownloadDialog.open()
                     }
                     
+                    // Import link list button
+                    ActionButton {
+                        iconSource: "folder"
+                        tooltip: qsTr("Import Links")
+                        iconColor: Theme.textSecondary
+                        onClicked: importDialog.open()
+                    }
+                    
                     // Settings button
                     ActionButton {
                         iconSource: "settings"
@@ -376,6 +392,21 @@ ApplicationWindow {
         }
     }
     
+    // ═══════════════════════════════════════════════════════════════════════
+    // Import Links Dialog
+    // ═══════════════════════════════════════════════════════════════════════
+    FileDialog {
+        id: importDialog
+        title: qsTr("Import Links")
+        nameFilters: [qsTr("Link lists (*.txt *.csv *.html *.htm)"), qsTr("All files (*)")]
+        
+        onAccepted: {
+            if (downloadManager) {
+                downloadManager.importLinks(selectedFile.toString(), "")
+            }
+        }
+    }
+    
     // ═══════════════════════════════════════════════════════════════════════
     // Settings Popup (placeholder)
     // ═══════════════════════════════════════════════════════════════════════
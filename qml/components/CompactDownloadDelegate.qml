@@ -0,0 +1,140 @@
+import QtQuick 2.15
+import "../theme"
+
+/**
+ * CompactDownloadDelegate - One-line download row for long lists
+ * 
+ * Takes the same properties and signals as DownloadItemDelegate but
+ * draws a flat row: no glass panel, no hover or pulse animations and no
+ * Canvas icons, so hundreds of visible rows stay cheap to build and to
+ * composite. Actions are text glyphs.
+ */
+Rectangle {
+    id: root
+    
+    // Required properties from model
+    required property int index
+    required property string downloadId
+    required property string fileName
+    required property string url
+    required property int state  // DownloadState enum
+    required property double progress  // 0-100
+    required property double speed  // bytes/sec
+    required property string totalSize
+    required property string downloadedSize
+    required property string remainingTime
+    required property string errorMessage
+    required property int activeSegments
+    required property int totalSegments
+    
+    property var segmentMap
+    
+    // Signals
+    signal pauseClicked()
+    signal resumeClicked()
+    signal cancelClicked()
+    signal retryClicked()
+    signal openFolderClicked()
+    signal deleteClicked()
+    
+    readonly property bool finished: state === 6 || state === 7  // Completed or failed
+    
+    implicitWidth: ListView.view ? ListView.view.width : 400
+    implicitHeight: Theme.downloadItemHeightCompact
+    radius: Theme.radiusSm
+    color: index % 2 ? Theme.glassBg : "transparent"
+    
+    // State indicator
+    Rectangle {
+        id: indicator
+        anchors.left: parent.left
+        anchors.verticalCenter: parent.verticalCenter
+        width: 3
+        height: parent.height - Theme.spacingSm
+        radius: 1
+        color: Theme.stateColor(root.state)
+    }
+    
+    Text {
+        id: name
+        anchors.left: indicator.right
+        anchors.leftMargin: Theme.spacingSm
+        anchors.verticalCenter: parent.verticalCenter
+        width: parent.width * 0.35
+        text: root.fileName
+        color: Theme.textPrimary
+        font.pixelSize: Theme.fontSizeSm
+        elide: Text.ElideMiddle
+    }
+    
+    ProgressBar {
+        anchors.left: name.right
+        anchors.right: status.left
+        anchors.leftMargin: Theme.spacingMd
+        anchors.rightMargin: Theme.spacingMd
+        anchors.verticalCenter: parent.verticalCenter
+        value: root.progress
+        fillColor: Theme.stateColor(root.state)
+        animated: false
+        segmentMap: root.segmentMap
+        visible: !root.finished
+    }
+    
+    Text {
+        id: status
+        anchors.right: primaryAction.left
+        anchors.rightMargin: Theme.spacingSm
+        anchors.verticalCenter: parent.verticalCenter
+        width: 150
+        horizontalAlignment: Text.AlignRight
+        text: root.state === 2 ? Theme.formatSpeed(root.speed) + "  " + root.progress.toFixed(0) + "%"
+                               : Theme.stateText(root.state)
+        color: root.state === 7 ? Theme.error : Theme.textSecondary
+        font.pixelSize: Theme.fontSizeXs
+        font.family: Theme.fontFamilyMono
+    }
+    
+    // Pause, resume, retry or open folder, depending on the state
+    Text {
+        id: primaryAction
+        anchors.right: removeAction.left
+        anchors.verticalCenter: parent.verticalCenter
+        width: 24
+        horizontalAlignment: Text.AlignHCenter
+        text: root.state === 2 ? "⏸" : root.state === 3 ? "▶" : root.state === 7 ? "↻" : root.state === 6 ? "📂" : ""
+        color: Theme.textSecondary
+        font.pixelSize: Theme.fontSizeMd
+        
+        MouseArea {
+            anchors.fill: parent
+            enabled: parent.text !== ""
+            cursorShape: Qt.PointingHandCursor
+            onClicked: {
+                switch (root.state) {
+                    case 2: root.pauseClicked(); break
+                    case 3: root.resumeClicked(); break
+                    case 6: root.openFolderClicked(); break
+                    case 7: root.retryClicked(); break
+                }
+            }
+        }
+    }
+    
+    Text {
+        id: removeAction
+        anchors.right: parent.right
+        anchors.rightMargin: Theme.spacingXs
+        anchors.verticalCenter: parent.verticalCenter
+        width: 24
+        horizontalAlignment: Text.AlignHCenter
+        text: "✕"
+        color: Theme.textTertiary
+        font.pixelSize: Theme.fontSizeMd
+        
+        MouseArea {
+            anchors.fill: parent
+            cursorShape: Qt.PointingHandCursor
+            onClicked: root.finished ? root.deleteClicked() : root.cancelClicked()
+        }
+    }
+}
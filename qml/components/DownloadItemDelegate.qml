@@ -28,6 +28,7 @@ GlassPanel {
     
     // Properties
     property bool expanded: false
+    property var segmentMap
     
     // Signals
     signal pauseClicked()
@@ -223,7 +224,7 @@ GlassPanel {
             Layout.fillWidth: true
             value: root.progress
             fillColor: Theme.stateColor(root.state)
-            showStripes: root.state === 2
+            segmentMap: root.segmentMap
             visible: root.state !== 6 && root.state !== 7  // Not completed or failed
         }
         
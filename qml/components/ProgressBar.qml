@@ -1,8 +1,13 @@
 import QtQuick 2.15
+import OpenIDM 1.0
 import "../theme"
 
 /**
  * ProgressBar - Custom progress bar with animations
+ * 
+ * Given a segment map (the model's segmentMap role) it shows which parts
+ * of the file are done and which are being fetched, drawn by SegmentBar
+ * in a single scene-graph node. Without one it falls back to a plain fill.
  */
 Item {
     id: root
@@ -14,8 +19,10 @@ Item {
     property color fillColor: Theme.progressFill
     property color backgroundColor: Theme.progressBg
     property bool animated: true
-    property bool showStripes: true
     property bool indeterminate: false
+    property var segmentMap  // ArrayBuffer from the model, one RangeState per slice
+    
+    readonly property bool segmented: segments.cells > 0 && !indeterminate
     
     // Background track
     Rectangle {
@@ -35,6 +42,7 @@ Item {
             width: root.indeterminate ? parent.width * 0.3 : (parent.width * root.value / 100)
             radius: parent.radius
             color: root.fillColor
+            visible: !root.segmented
             
             Behavior on width {
                 enabled: root.animated && !root.indeterminate
@@ -44,57 +52,6 @@ Item {
                 }
             }
             
-            // Animated stripes for active downloads
-            Item {
-                anchors.fill: parent
-                visible: root.showStripes && root.value > 0 && root.value < 100
-                clip: true
-                
-                Row {
-                    id: stripes
-                    spacing: 0
-                    
-                    property real stripeWidth: 20
-                    
-                    x: -stripeWidth + (stripesAnimation.running ? stripesAnimation.offset : 0)
-                    
-                    Repeater {
-                        model: Math.ceil(fill.width / stripes.stripeWidth) + 2
-                        
-                        Rectangle {
-                            width: stripes.stripeWidth
-                            height: fill.height * 2
-                            rotation: -45
-                            y: -fill.height / 2
-                            
-                            gradient: Gradient {
-                                orientation: Gradient.Horizontal
-                                GradientStop { position: 0.0; color: "transparent" }
-                                GradientStop { position: 0.5; color: Qt.rgba(255, 255, 255, 0.15) }
-                                GradientStop { position: 1.0; color: "transparent" }
-                            }
-                        }
-                    }
-                }
-                
-                NumberAnimation {
-                    id: stripesAnimation
-                    running: root.showStripes && root.value > 0 && root.value < 100
-                    loops: Animation.Infinite
-                    duration: 1000
-                    
-                    property real offset: 0
-                    from: 0
-                    to: stripes.stripeWidth
-                    
-                    onRunningChanged: offset = 0
-                    
-                    ScriptAction {
-                        script: stripesAnimation.offset = stripesAnimation.to
-                    }
-                }
-            }
-            
             // Glow effect
             Rectangle {
                 anchors.right: parent.right
@@ -111,6 +68,16 @@ Item {
             }
         }
         
+        // Segment map
+        SegmentBar {
+            id: segments
+            anchors.fill: parent
+            visible: root.segmented
+            segmentMap: root.segmentMap || new ArrayBuffer(0)
+            completedColor: root.fillColor
+            activeColor: Qt.rgba(root.fillColor.r, root.fillColor.g, root.fillColor.b, 0.35)
+        }
+        
         // Indeterminate animation
         SequentialAnimation {
             running: root.indeterminate
@@ -138,6 +138,8 @@ QtObject {
     readonly property int toolbarHeight: 48
     readonly property int downloadItemHeight: 72
     readonly property int downloadItemHeightExpanded: 140
+    readonly property int downloadItemHeightCompact: 36
+    readonly property int compactListThreshold: 200     // Rows after which the list uses the compact delegate
     
     // Breakpoints
     readonly property int breakpointSm: 640
@@ -101,6 +101,20 @@ Item {
         // Use download list model from C++
         model: downloadListModel
         
+        // Only rows on screen receive progress updates
+        function reportVisibleRange() {
+            var first = indexAt(0, contentY)
+            if (first < 0) {
+                first = indexAt(0, contentY + spacing)
+            }
+            var last = indexAt(0, contentY + height - 1)
+            downloadListModel.setVisibleRange(Math.max(first, 0), last)
+        }
+        
+        onContentYChanged: reportVisibleRange()
+        onHeightChanged: reportVisibleRange()
+        onCountChanged: reportVisibleRange()
+        
         // Smooth scrolling
         ScrollBar.vertical: ScrollBar {
             policy: ScrollBar.AsNeeded
@@ -121,34 +135,75 @@ Item {
             }
         }
         
-        // Delegate
-        delegate: DownloadItemDelegate {
-            width: listView.width - Theme.spacingSm
+        // Delegate; long lists switch to flat one-line rows
+        delegate: count > Theme.compactListThreshold ? compactDelegate : fullDelegate
+        
+        Component {
+            id: fullDelegate
             
-            // Map model roles
-            downloadId: model.id || ""
-            fileName: model.fileName || "Unknown"
-            url: model.url || ""
-            state: model.state || 0
-            progress: model.progress || 0
-            speed: model.speed || 0
-            totalSize: Theme.formatBytes(model.totalSize || 0)
-            downloadedSize: Theme.formatBytes(model.downloadedSize || 0)
-            remainingTime: model.remainingTime || ""
-            errorMessage: model.errorMessage || ""
-            activeSegments: model.activeSegments || 0
-            totalSegments: model.totalSegments || 0
+            DownloadItemDelegate {
+                width: listView.width - Theme.spacingSm
+                
+                // Map model roles
+                downloadId: model.id || ""
+                fileName: model.fileName || "Unknown"
+                url: model.url || ""
+                state: model.state || 0
+                progress: model.progress || 0
+                speed: model.speed || 0
+                totalSize: Theme.formatBytes(model.totalSize || 0)
+                downloadedSize: Theme.formatBytes(model.downloadedSize || 0)
+                remainingTime: model.remainingTime || ""
+                errorMessage: model.errorMessage || ""
+                activeSegments: model.activeSegments || 0
+                totalSegments: model.totalSegments || 0
+                segmentMap: model.segmentMap
+                
+                // Action handlers
+                onPauseClicked: downloadManager?.pauseDownload(downloadId)
+                onResumeClicked: downloadManager?.resumeDownload(downloadId)
+                onCancelClicked: downloadManager?.cancelDownload(downloadId)
+                onRetryClicked: downloadManager?.retryDownload(downloadId)
+                onOpenFolderClicked: {
+                    // Open containing folder
+                    Qt.openUrlExternally("file://" + model.filePath.substring(0, model.filePath.lastIndexOf("/")))
+                }
+                onDeleteClicked: downloadManager?.removeDownload(downloadId, false)
+            }
+        }
+        
+        Component {
+            id: compactDelegate
             
-            // Action handlers
-            onPauseClicked: downloadManager?.pauseDownload(downloadId)
-            onResumeClicked: downloadManager?.resumeDownload(downloadId)
-            onCancelClicked: downloadManager?.cancelDownload(downloadId)
-            onRetryClicked: downloadManager?.retryDownload(downloadId)
-            onOpenFolderClicked: {
-                // Open containing folder
-                Qt.openUrlExternally("file://" + model.filePath.substring(0, model.filePath.lastIndexOf("/")))
+            CompactDownloadDelegate {
+                width: listView.width - Theme.spacingSm
+                
+                // Map model roles
+                downloadId: model.id || ""
+                fileName: model.fileName || "Unknown"
+                url: model.url || ""
+                state: model.state || 0
+                progress: model.progress || 0
+                speed: model.speed || 0
+                totalSize: Theme.formatBytes(model.totalSize || 0)
+                downloadedSize: Theme.formatBytes(model.downloadedSize || 0)
+                remainingTime: model.remainingTime || ""
+                errorMessage: model.errorMessage || ""
+                activeSegments: model.activeSegments || 0
+                totalSegments: model.totalSegments || 0
+                segmentMap: model.segmentMap
+                
+                // Action handlers
+                onPauseClicked: downloadManager?.pauseDownload(downloadId)
+                onResumeClicked: downloadManager?.resumeDownload(downloadId)
+                onCancelClicked: downloadManager?.cancelDownload(downloadId)
+                onRetryClicked: downloadManager?.retryDownload(downloadId)
+                onOpenFolderClicked: {
+                    // Open containing folder
+                    Qt.openUrlExternally("file://" + model.filePath.substring(0, model.filePath.lastIndexOf("/")))
+                }
+                onDeleteClicked: downloadManager?.removeDownload(downloadId, false)
             }
-            onDeleteClicked: downloadManager?.removeDownload(downloadId, false)
         }
         
         // Add/remove animations
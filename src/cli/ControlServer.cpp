@@ -0,0 +1,414 @@
+/**
+ * @file ControlServer.cpp
+ * @brief Implementation of ControlServer - line-delimited JSON-RPC 2.0
+ */
+
+#include "cli/ControlServer.h"
+#include "openidm/engine/Checksum.h"
+#include "openidm/engine/DownloadManager.h"
+#include "openidm/engine/DownloadTask.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QUrl>
+
+#include <utility>
+
+namespace OpenIDM {
+
+namespace {
+
+// JSON-RPC 2.0 error codes
+constexpr int PARSE_ERROR = -32700;
+constexpr int INVALID_REQUEST = -32600;
+constexpr int METHOD_NOT_FOUND = -32601;
+constexpr int INVALID_PARAMS = -32602;
+constexpr int INTERNAL_ERROR = -32603;
+
+/// A client sending longer lines than this is disconnected
+constexpr qsizetype MAX_LINE = 1024 * 1024;
+
+QJsonObject makeError(int code, const QString& message) {
+    return QJsonObject{{QStringLiteral("code"), code}, {QStringLiteral("message"), message}};
+}
+
+QByteArray line(const QJsonObject& object) {
+    return QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n';
+}
+
+QString idString(const TaskId& id) {
+    return id.toString(QUuid::WithoutBraces);
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+ControlServer::ControlServer(DownloadManager& manager, QObject* parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_server(new QLocalServer(this))
+{
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    QObject::connect(m_server, &QLocalServer::newConnection, this, [this]() { accept(); });
+
+    QObject::connect(&m_manager, &DownloadManager::downloadCompleted, this, [this](const TaskId& id) {
+        broadcast(QStringLiteral("downloadCompleted"), describe(id));
+    });
+    QObject::connect(&m_manager, &DownloadManager::downloadFailed, this, [this](const TaskId& id, const QString&) {
+        broadcast(QStringLiteral("downloadFailed"), describe(id));
+    });
+}
+
+ControlServer::~ControlServer() {
+    for (QLocalSocket* socket : std::as_const(m_clients)) {
+        socket->disconnect(this);
+    }
+}
+
+bool ControlServer::listen(const QString& name) {
+    // A daemon that died leaves its socket file behind
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        qWarning() << "ControlServer: Failed to listen on" << name << ":" << m_server->errorString();
+        return false;
+    }
+    qDebug() << "ControlServer: Listening on" << m_server->fullServerName();
+    return true;
+}
+
+QString ControlServer::serverName() const {
+    return m_server->fullServerName();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Connections
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ControlServer::accept() {
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        m_clients.append(socket);
+        QObject::connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { read(socket); });
+        QObject::connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            m_clients.removeOne(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void ControlServer::read(QLocalSocket* socket) {
+    while (socket->canReadLine()) {
+        QByteArray request = socket->readLine().trimmed();
+        if (request.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(request, &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            socket->write(line(QJsonObject{
+                {QStringLiteral("jsonrpc"), QStringLiteral("2.0")},
+                {QStringLiteral("error"), makeError(PARSE_ERROR, parseError.errorString())},
+                {QStringLiteral("id"), QJsonValue::Null},
+            }));
+            continue;
+        }
+
+        // Batches are answered as one array; notifications get no answer
+        if (document.isArray()) {
+            QJsonArray responses;
+            for (const QJsonValue& entry : document.array()) {
+                QJsonObject response = handle(entry);
+                if (!response.isEmpty()) {
+                    responses.append(response);
+                }
+            }
+            if (!responses.isEmpty()) {
+                socket->write(QJsonDocument(responses).toJson(QJsonDocument::Compact) + '\n');
+            }
+        } else {
+            QJsonObject response = handle(document.object());
+            if (!response.isEmpty()) {
+                socket->write(line(response));
+            }
+        }
+    }
+    // A shutdown response must leave before the event loop stops
+    socket->flush();
+
+    if (socket->bytesAvailable() > MAX_LINE) {
+        qWarning() << "ControlServer: Dropping client with an oversized request";
+        socket->abort();
+    }
+}
+
+void ControlServer::broadcast(const QString& method, const QJsonObject& params) {
+    QByteArray notification = line(QJsonObject{
+        {QStringLiteral("jsonrpc"), QStringLiteral("2.0")},
+        {QStringLiteral("method"), method},
+        {QStringLiteral("params"), params},
+    });
+    for (QLocalSocket* socket : std::as_const(m_clients)) {
+        socket->write(notification);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Requests
+// ═══════════════════════════════════════════════════════════════════════════════
+
+QJsonObject ControlServer::handle(const QJsonValue& request) {
+    QJsonObject object = request.toObject();
+    QJsonValue id = object.value(QStringLiteral("id"));
+    bool notification = !object.contains(QStringLiteral("id"));
+
+    QJsonObject response{{QStringLiteral("jsonrpc"), QStringLiteral("2.0")}};
+    response[QStringLiteral("id")] = notification ? QJsonValue(QJsonValue::Null) : id;
+
+    QJsonValue method = object.value(QStringLiteral("method"));
+    QJsonValue params = object.value(QStringLiteral("params"));
+    if (!request.isObject() || object.value(QStringLiteral("jsonrpc")) != QStringLiteral("2.0") ||
+        !method.isString() || !(params.isUndefined() || params.isObject())) {
+        response[QStringLiteral("error")] = makeError(INVALID_REQUEST, QStringLiteral("Invalid request"));
+        return response;
+    }
+
+    QJsonObject error;
+    QJsonValue result = dispatch(method.toString(), params.toObject(), error);
+    if (notification) {
+        return {};
+    }
+    if (!error.isEmpty()) {
+        response[QStringLiteral("error")] = error;
+    } else {
+        response[QStringLiteral("result")] = result;
+    }
+    return response;
+}
+
+QJsonValue ControlServer::dispatch(const QString& method, const QJsonObject& params, QJsonObject& error) {
+    if (method == QStringLiteral("add")) {
+        return add(params, error);
+    }
+    if (method == QStringLiteral("list")) {
+        QJsonArray tasks;
+        QString state = params.value(QStringLiteral("state")).toString();
+        for (DownloadTask* task : m_manager.allTasks()) {
+            if (state.isEmpty() || downloadStateToString(task->state()).compare(state, Qt::CaseInsensitive) == 0) {
+                tasks.append(describe(task->id()));
+            }
+        }
+        return tasks;
+    }
+    if (method == QStringLiteral("stats")) {
+        return stats();
+    }
+    if (method == QStringLiteral("configure")) {
+        return configure(params);
+    }
+    if (method == QStringLiteral("shutdown")) {
+        // After this response has been written
+        QMetaObject::invokeMethod(QCoreApplication::instance(), &QCoreApplication::quit, Qt::QueuedConnection);
+        return true;
+    }
+
+    // The rest act on one task
+    static const QStringList TASK_METHODS = {
+        QStringLiteral("status"), QStringLiteral("pause"), QStringLiteral("resume"),
+        QStringLiteral("cancel"), QStringLiteral("retry"), QStringLiteral("remove"),
+        QStringLiteral("stream"),
+    };
+    if (!TASK_METHODS.contains(method)) {
+        error = makeError(METHOD_NOT_FOUND, QStringLiteral("Unknown method: %1").arg(method));
+        return {};
+    }
+
+    TaskId id = QUuid::fromString(params.value(QStringLiteral("id")).toString());
+    if (id.isNull() || (!m_manager.task(id) && !m_manager.archivedDownload(id))) {
+        error = makeError(INVALID_PARAMS, QStringLiteral("Unknown download id"));
+        return {};
+    }
+
+    if (method == QStringLiteral("pause")) {
+        m_manager.pauseDownload(id);
+    } else if (method == QStringLiteral("resume")) {
+        m_manager.resumeDownload(id);
+    } else if (method == QStringLiteral("cancel")) {
+        m_manager.cancelDownload(id);
+    } else if (method == QStringLiteral("retry")) {
+        m_manager.retryDownload(id);
+    } else if (method == QStringLiteral("remove")) {
+        m_manager.removeDownload(id, params.value(QStringLiteral("deleteFile")).toBool());
+        return true;
+    } else if (method == QStringLiteral("stream")) {
+        QString url = m_manager.streamUrl(id.toString());
+        if (url.isEmpty()) {
+            error = makeError(INTERNAL_ERROR, QStringLiteral("Stream server unavailable"));
+            return {};
+        }
+        return QJsonObject{{QStringLiteral("url"), url}};
+    }
+    return describe(id);
+}
+
+QJsonValue ControlServer::add(const QJsonObject& params, QJsonObject& error) {
+    QStringList urls;
+    if (params.value(QStringLiteral("url")).isString()) {
+        urls.append(params.value(QStringLiteral("url")).toString());
+    }
+    for (const QJsonValue& url : params.value(QStringLiteral("urls")).toArray()) {
+        urls.append(url.toString());
+    }
+    urls.removeAll(QString());
+    if (urls.isEmpty()) {
+        error = makeError(INVALID_PARAMS, QStringLiteral("Expected url or urls"));
+        return {};
+    }
+
+    QString directory = params.value(QStringLiteral("directory")).toString();
+    QString hash = params.value(QStringLiteral("hash")).toString();
+    QString extract = params.value(QStringLiteral("extract")).toString();
+    QString previous = params.value(QStringLiteral("previous")).toString();
+    QString zsync = params.value(QStringLiteral("zsync")).toString();
+    QStringList mirrors;
+    for (const QJsonValue& mirror : params.value(QStringLiteral("mirrors")).toArray()) {
+        mirrors.append(mirror.toString());
+    }
+    bool single = !hash.isEmpty() || !mirrors.isEmpty() || !extract.isEmpty() || !previous.isEmpty();
+    if (single && urls.size() != 1) {
+        error = makeError(INVALID_PARAMS, QStringLiteral("hash, mirrors, extract and previous need a single url"));
+        return {};
+    }
+
+    // Rejected before anything is added, so a failed call leaves no download behind
+    if (!hash.isEmpty() && !ExpectedHash::fromString(hash).isValid()) {
+        error = makeError(INVALID_PARAMS, QStringLiteral("Unsupported hash: %1").arg(hash));
+        return {};
+    }
+
+    std::vector<TaskId> ids;
+    if (single) {
+        // Queued until everything is in place
+        TaskId id = m_manager.addDownload(QUrl(urls.first()), directory, false);
+        if (!id.isNull()) {
+            if (!mirrors.isEmpty()) {
+                m_manager.setMirrors(idString(id), mirrors);
+            }
+            if (!extract.isEmpty()) {
+                m_manager.setExtractTo(idString(id), extract);
+            }
+            if (!previous.isEmpty()) {
+                m_manager.setDeltaSource(idString(id), previous, zsync);
+            }
+            if (!hash.isEmpty()) {
+                m_manager.setExpectedHash(idString(id), hash);
+            }
+            ids.push_back(id);
+
+            // Only this download, and only if a slot is free; the rest of
+            // the queue is left to the manager
+            DownloadTask* task = m_manager.task(id);
+            if (task && task->state() == DownloadState::Queued) {
+                m_manager.startDownload(id);
+            }
+        }
+    } else {
+        QList<QUrl> parsed;
+        for (const QString& url : std::as_const(urls)) {
+            parsed.append(QUrl(url));
+        }
+        ids = m_manager.addDownloads(parsed, directory);
+    }
+
+    QJsonArray result;
+    for (const TaskId& id : ids) {
+        result.append(idString(id));
+    }
+    return QJsonObject{{QStringLiteral("ids"), result}};
+}
+
+QJsonValue ControlServer::configure(const QJsonObject& params) {
+    EngineTunables tunables = m_manager.tunables();
+    if (params.contains(QStringLiteral("maxConcurrentDownloads"))) {
+        tunables.maxConcurrentDownloads = params.value(QStringLiteral("maxConcurrentDownloads")).toInt();
+    }
+    if (params.contains(QStringLiteral("maxSegmentsPerDownload"))) {
+        tunables.maxSegmentsPerDownload = params.value(QStringLiteral("maxSegmentsPerDownload")).toInt();
+    }
+    if (params.contains(QStringLiteral("maxTotalConnections"))) {
+        tunables.maxTotalConnections = params.value(QStringLiteral("maxTotalConnections")).toInt();
+    }
+    if (params.contains(QStringLiteral("maxConnectionsPerHost"))) {
+        tunables.maxConnectionsPerHost = params.value(QStringLiteral("maxConnectionsPerHost")).toInt();
+    }
+    if (params.contains(QStringLiteral("memoryBudgetMB"))) {
+        tunables.memoryBudgetMB = params.value(QStringLiteral("memoryBudgetMB")).toInt();
+    }
+    if (params.contains(QStringLiteral("speedLimit"))) {
+        tunables.speedLimit = params.value(QStringLiteral("speedLimit")).toDouble();
+    }
+    if (params.contains(QStringLiteral("metricsPort"))) {
+        tunables.metricsPort = params.value(QStringLiteral("metricsPort")).toInt();
+    }
+    m_manager.setTunables(tunables);
+    if (params.contains(QStringLiteral("directory"))) {
+        m_manager.setDefaultDownloadDirectory(params.value(QStringLiteral("directory")).toString());
+    }
+
+    // Effective values, after clamping
+    const EngineTunables& applied = m_manager.tunables();
+    return QJsonObject{
+        {QStringLiteral("maxConcurrentDownloads"), applied.maxConcurrentDownloads},
+        {QStringLiteral("maxSegmentsPerDownload"), applied.maxSegmentsPerDownload},
+        {QStringLiteral("maxTotalConnections"), applied.maxTotalConnections},
+        {QStringLiteral("maxConnectionsPerHost"), applied.maxConnectionsPerHost},
+        {QStringLiteral("memoryBudgetMB"), applied.memoryBudgetMB},
+        {QStringLiteral("speedLimit"), applied.speedLimit},
+        {QStringLiteral("metricsPort"), applied.metricsPort},
+        {QStringLiteral("directory"), m_manager.defaultDownloadDirectory()},
+    };
+}
+
+QJsonValue ControlServer::stats() const {
+    return QJsonObject{
+        {QStringLiteral("active"), m_manager.activeDownloadCount()},
+        {QStringLiteral("queued"), m_manager.queuedDownloadCount()},
+        {QStringLiteral("completed"), m_manager.completedDownloadCount()},
+        {QStringLiteral("total"), m_manager.totalDownloadCount()},
+        {QStringLiteral("speed"), m_manager.globalSpeed()},
+        {QStringLiteral("sessionBytes"), static_cast<qint64>(m_manager.sessionBytesDownloaded())},
+        {QStringLiteral("bufferedBytes"), static_cast<qint64>(m_manager.bufferedBytes())},
+    };
+}
+
+QJsonObject ControlServer::describe(const TaskId& id) const {
+    QJsonObject object{{QStringLiteral("id"), idString(id)}};
+
+    if (DownloadTask* task = m_manager.task(id)) {
+        object[QStringLiteral("url")] = task->url();
+        object[QStringLiteral("path")] = task->filePath();
+        object[QStringLiteral("state")] = downloadStateToString(task->state());
+        object[QStringLiteral("downloaded")] = static_cast<qint64>(task->downloadedSize());
+        object[QStringLiteral("total")] = static_cast<qint64>(task->totalSize());
+        object[QStringLiteral("speed")] = task->speed();
+        object[QStringLiteral("connections")] = task->activeSegments();
+        if (task->hasError()) {
+            object[QStringLiteral("error")] = task->errorMessage();
+        }
+    } else if (std::optional<TaskData> record = m_manager.archivedDownload(id)) {
+        object[QStringLiteral("url")] = record->url;
+        object[QStringLiteral("path")] = record->filePath;
+        object[QStringLiteral("state")] = downloadStateToString(record->state);
+        object[QStringLiteral("downloaded")] = static_cast<qint64>(record->downloadedSize);
+        object[QStringLiteral("total")] = static_cast<qint64>(record->totalSize);
+    }
+    return object;
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,81 @@
+/**
+ * @file ControlServer.h
+ * @brief JSON-RPC 2.0 control socket for the headless daemon
+ *
+ * A local socket (a Unix domain socket, or a named pipe on Windows) that
+ * accepts one JSON-RPC request per line and answers each with one line.
+ * Connected clients also receive `downloadCompleted` and `downloadFailed`
+ * notifications, so scripts can wait for results without polling.
+ *
+ * @copyright Copyright (c) 2024 OpenIDM Project
+ * @license GPL-3.0-or-later
+ */
+
+#ifndef OPENIDM_CONTROLSERVER_H
+#define OPENIDM_CONTROLSERVER_H
+
+#include "openidm/engine/Types.h"
+
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+class QLocalSocket;
+
+namespace OpenIDM {
+
+class DownloadManager;
+class DownloadTask;
+
+/**
+ * @class ControlServer
+ * @brief Drives DownloadManager on behalf of local clients
+ *
+ * Methods: add, list, status, pause, resume, cancel, retry, remove,
+ * stream, stats, configure, shutdown. See docs/design/ARCHITECTURE.md.
+ *
+ * Thread Safety:
+ * - Lives on the main thread, next to DownloadManager
+ */
+class ControlServer : public QObject {
+public:
+    explicit ControlServer(DownloadManager& manager, QObject* parent = nullptr);
+    ~ControlServer() override;
+
+    // Disable copying
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    /**
+     * @brief Listen on @p name
+     * @param name Socket path or pipe name; a stale socket is replaced
+     * @return False if the socket could not be created
+     */
+    bool listen(const QString& name);
+
+    /// @return Full path or pipe name clients connect to
+    QString serverName() const;
+
+private:
+    void accept();
+    void read(QLocalSocket* socket);
+    QJsonObject handle(const QJsonValue& request);
+    QJsonValue dispatch(const QString& method, const QJsonObject& params, QJsonObject& error);
+    void broadcast(const QString& method, const QJsonObject& params);
+
+    QJsonValue add(const QJsonObject& params, QJsonObject& error);
+    QJsonValue configure(const QJsonObject& params);
+    QJsonValue stats() const;
+    QJsonObject describe(const TaskId& id) const;
+
+    DownloadManager& m_manager;
+    QLocalServer* m_server{nullptr};
+    QList<QLocalSocket*> m_clients;
+};
+
+} // namespace OpenIDM
+
+#endif // OPENIDM_CONTROLSERVER_H
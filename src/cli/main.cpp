@@ -0,0 +1,282 @@
+/**
+ * @file main.cpp
+ * @brief Headless OpenIDM: batch downloads and a control-socket daemon
+ *
+ * Built on openidm_engine and QtCore only; no GUI, QML or Widgets.
+ *
+ *   openidm-cli -o ~/dl https://example.com/a.iso https://example.com/b.iso
+ *   openidm-cli -i urls.txt -j 8            # one URL per line, '-' = stdin
+ *   openidm-cli --daemon --socket /run/user/1000/openidm.sock
+ *
+ * Batch mode exits 0 when every download completed, 1 if any failed or
+ * timed out, 2 on bad usage.
+ */
+
+#include "cli/ControlServer.h"
+#include "openidm/engine/DownloadManager.h"
+#include "openidm/engine/DownloadTask.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <limits>
+#include <optional>
+#include <utility>
+
+using namespace OpenIDM;
+
+namespace {
+
+constexpr int EXIT_FAILED = 1;
+constexpr int EXIT_USAGE = 2;
+
+/// Set from the signal handler; polled by the event loop
+std::atomic<bool> g_interrupted{false};
+
+void onSignal(int) {
+    g_interrupted.store(true);
+}
+
+/// @return URLs from @p path, one per line; blank lines and '#' comments skipped
+QStringList readUrlList(const QString& path, bool* ok) {
+    QFile file(path);
+    *ok = path == QStringLiteral("-") ? file.open(stdin, QIODevice::ReadOnly | QIODevice::Text)
+                                      : file.open(QIODevice::ReadOnly | QIODevice::Text);
+    QStringList urls;
+    if (!*ok) {
+        return urls;
+    }
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+        line = line.trimmed();
+        if (!line.isEmpty() && !line.startsWith(QLatin1Char('#'))) {
+            urls.append(line);
+        }
+    }
+    return urls;
+}
+
+void printResult(const QString& status, const QString& url, const QString& detail) {
+    std::fprintf(stdout, "%s\t%s\t%s\n", qPrintable(status), qPrintable(url), qPrintable(detail));
+    std::fflush(stdout);
+}
+
+/**
+ * Add @p urls and wait until each has completed or failed. A URL that an
+ * earlier run already finished counts as completed; one that failed then
+ * is retried.
+ */
+int runBatch(QCoreApplication& app, const QStringList& urls, const QString& directory, Duration timeout) {
+    DownloadManager& manager = DownloadManager::instance();
+
+    QHash<TaskId, QString> pending;
+    int failures = 0;
+
+    auto settle = [&](const TaskId& id, bool failed, const QString& detail) {
+        auto it = pending.find(id);
+        if (it == pending.end()) {
+            return;
+        }
+        printResult(failed ? QStringLiteral("FAILED") : QStringLiteral("OK"), it.value(), detail);
+        failures += failed ? 1 : 0;
+        pending.erase(it);
+        if (pending.isEmpty()) {
+            app.quit();
+        }
+    };
+    QObject::connect(&manager, &DownloadManager::downloadCompleted, &app, [&](const TaskId& id) {
+        DownloadTask* task = manager.task(id);
+        settle(id, false, task ? task->filePath() : QString());
+    });
+    QObject::connect(&manager, &DownloadManager::downloadFailed, &app, [&](const TaskId& id, const QString& error) {
+        settle(id, true, error);
+    });
+
+    QList<QUrl> parsed;
+    for (const QString& url : urls) {
+        QUrl candidate = QUrl::fromUserInput(url);
+        if (!candidate.isValid() || candidate.scheme().isEmpty()) {
+            printResult(QStringLiteral("FAILED"), url, QStringLiteral("invalid URL"));
+            ++failures;
+            continue;
+        }
+        parsed.append(candidate);
+    }
+
+    std::vector<TaskId> added = manager.addDownloads(parsed, directory);
+    std::vector<TaskId> retries;
+    for (const TaskId& id : added) {
+        DownloadTask* task = manager.task(id);
+        std::optional<TaskData> archived = task ? std::nullopt : manager.archivedDownload(id);
+        QString url = task ? task->url() : archived ? archived->url : QString();
+        DownloadState state = task ? task->state() : archived ? archived->state : DownloadState::Failed;
+
+        if (state == DownloadState::Completed) {
+            printResult(QStringLiteral("OK"), url, task ? task->filePath() : archived->filePath);
+        } else {
+            pending.insert(id, url);
+            if (state == DownloadState::Failed) {
+                retries.push_back(id);
+            }
+        }
+    }
+    for (const TaskId& id : retries) {
+        manager.retryDownload(id);
+    }
+
+    if (!pending.isEmpty()) {
+        QTimer::singleShot(timeout, &app, [&app]() { app.exit(EXIT_FAILED); });
+        QTimer interrupt;
+        QObject::connect(&interrupt, &QTimer::timeout, &app, [&app]() {
+            if (g_interrupted.load()) {
+                app.exit(EXIT_FAILED);
+            }
+        });
+        interrupt.start(200);
+        app.exec();
+    }
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        printResult(QStringLiteral("FAILED"), it.value(), QStringLiteral("unfinished"));
+        ++failures;
+    }
+    return failures > 0 ? EXIT_FAILED : 0;
+}
+
+int runDaemon(QCoreApplication& app, const QString& socketName) {
+    ControlServer server(DownloadManager::instance());
+    if (!server.listen(socketName)) {
+        return EXIT_FAILED;
+    }
+    qInfo().noquote() << "Control socket:" << server.serverName();
+
+    QTimer interrupt;
+    QObject::connect(&interrupt, &QTimer::timeout, &app, [&app]() {
+        if (g_interrupted.load()) {
+            app.quit();
+        }
+    });
+    interrupt.start(200);
+    return app.exec();
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Entry Point
+// ═══════════════════════════════════════════════════════════════════════════════
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName(QStringLiteral("OpenIDM"));
+    app.setOrganizationDomain(QStringLiteral("openidm.org"));
+    app.setApplicationName(QStringLiteral("openidm-cli"));
+    app.setApplicationVersion(QStringLiteral("1.0.0"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Headless OpenIDM download engine"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument(QStringLiteral("urls"), QStringLiteral("URLs to download (batch mode)."),
+                                 QStringLiteral("[url...]"));
+
+    const QCommandLineOption inputOption({QStringLiteral("i"), QStringLiteral("input")},
+        QStringLiteral("Read URLs from a file, one per line ('-' for stdin)."), QStringLiteral("file"));
+    const QCommandLineOption outputOption({QStringLiteral("o"), QStringLiteral("output")},
+        QStringLiteral("Download directory."), QStringLiteral("dir"));
+    const QCommandLineOption concurrentOption({QStringLiteral("j"), QStringLiteral("concurrent")},
+        QStringLiteral("Concurrent downloads."), QStringLiteral("n"));
+    const QCommandLineOption segmentsOption({QStringLiteral("s"), QStringLiteral("segments")},
+        QStringLiteral("Connections per download."), QStringLiteral("n"));
+    const QCommandLineOption limitOption(QStringLiteral("limit"),
+        QStringLiteral("Global speed limit in bytes/s."), QStringLiteral("bps"));
+    const QCommandLineOption timeoutOption(QStringLiteral("timeout"),
+        QStringLiteral("Give up on a batch after this many seconds (default: none)."), QStringLiteral("s"));
+    const QCommandLineOption metricsOption(QStringLiteral("metrics-port"),
+        QStringLiteral("Serve Prometheus metrics on this localhost port."), QStringLiteral("port"));
+    const QCommandLineOption daemonOption(QStringLiteral("daemon"),
+        QStringLiteral("Run until told to stop, controlled over the JSON-RPC socket."));
+    const QCommandLineOption socketOption(QStringLiteral("socket"),
+        QStringLiteral("Control socket path or name (default: openidm)."), QStringLiteral("name"),
+        QStringLiteral("openidm"));
+    const QCommandLineOption verboseOption({QStringLiteral("v"), QStringLiteral("verbose")},
+        QStringLiteral("Log engine debug output."));
+    parser.addOptions({inputOption, outputOption, concurrentOption, segmentsOption, limitOption,
+                       timeoutOption, metricsOption, daemonOption, socketOption, verboseOption});
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+    }
+
+    QStringList urls = parser.positionalArguments();
+    if (parser.isSet(inputOption)) {
+        bool ok = false;
+        urls += readUrlList(parser.value(inputOption), &ok);
+        if (!ok) {
+            qCritical().noquote() << "Cannot read" << parser.value(inputOption);
+            return EXIT_USAGE;
+        }
+    }
+    bool daemon = parser.isSet(daemonOption);
+    if (!daemon && urls.isEmpty()) {
+        parser.showHelp(EXIT_USAGE);
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (!DownloadManager::initialize(&app)) {
+        qCritical() << "Failed to initialize DownloadManager";
+        return EXIT_FAILED;
+    }
+    DownloadManager& manager = DownloadManager::instance();
+
+    // Command-line settings apply to this run and are remembered like the GUI's
+    EngineTunables tunables = manager.tunables();
+    if (parser.isSet(concurrentOption)) tunables.maxConcurrentDownloads = parser.value(concurrentOption).toInt();
+    if (parser.isSet(segmentsOption)) tunables.maxSegmentsPerDownload = parser.value(segmentsOption).toInt();
+    if (parser.isSet(limitOption)) tunables.speedLimit = parser.value(limitOption).toDouble();
+    if (parser.isSet(metricsOption)) tunables.metricsPort = parser.value(metricsOption).toInt();
+    manager.setTunables(tunables);
+
+    QString directory;
+    if (parser.isSet(outputOption)) {
+        directory = QDir(parser.value(outputOption)).absolutePath();
+        QDir().mkpath(directory);
+    }
+
+    int result = 0;
+    if (daemon) {
+        if (!directory.isEmpty()) {
+            manager.setDefaultDownloadDirectory(directory);
+        }
+        if (!urls.isEmpty()) {
+            QList<QUrl> initial;
+            for (const QString& url : std::as_const(urls)) {
+                initial.append(QUrl::fromUserInput(url));
+            }
+            manager.addDownloads(initial, directory);
+        }
+        result = runDaemon(app, parser.value(socketOption));
+    } else {
+        Duration timeout = parser.isSet(timeoutOption)
+                               ? Duration(std::max(1LL, parser.value(timeoutOption).toLongLong()) * 1000)
+                               : Duration(std::numeric_limits<int>::max());
+        result = runBatch(app, urls, directory, timeout);
+    }
+
+    DownloadManager::shutdown();
+    return result;
+}
@@ -0,0 +1,817 @@
+/**
+ * @file ArchiveExtractor.cpp
+ * @brief Implementation of streaming tar extraction
+ */
+
+#include "openidm/engine/ArchiveExtractor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef OPENIDM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef OPENIDM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace OpenIDM {
+
+namespace {
+
+/// tar header and padding unit
+constexpr size_t TAR_BLOCK = 512;
+
+/// Largest GNU long-name or pax header accepted
+constexpr ByteCount MAX_TAR_META = 1024 * 1024;
+
+/// Takes decompressed bytes; returning false stops the decoder
+using Sink = std::function<bool(const char* data, size_t size)>;
+
+// ───────────────────────────────────────────────────────────────────────────
+// Decoders
+// ───────────────────────────────────────────────────────────────────────────
+
+class Decoder {
+public:
+    virtual ~Decoder() = default;
+
+    /// @return False on corrupt input (error is set) or when the sink stopped
+    virtual bool push(const char* data, size_t size, const Sink& sink) = 0;
+
+    /// @return True if the compressed stream ended where the input did
+    virtual bool ended() const = 0;
+
+    QString error;
+};
+
+class PlainDecoder final : public Decoder {
+public:
+    bool push(const char* data, size_t size, const Sink& sink) override { return sink(data, size); }
+    bool ended() const override { return true; }
+};
+
+#ifdef OPENIDM_HAVE_ZLIB
+class GzipDecoder final : public Decoder {
+public:
+    GzipDecoder() : m_buffer(Constants::EXTRACT_DECODE_BUFFER) {
+        // 15 + 32: 32 KB window, gzip or zlib header detected from the data
+        m_ready = inflateInit2(&m_stream, 15 + 32) == Z_OK;
+    }
+
+    ~GzipDecoder() override {
+        if (m_ready) {
+            inflateEnd(&m_stream);
+        }
+    }
+
+    bool push(const char* data, size_t size, const Sink& sink) override {
+        if (!m_ready) {
+            error = QStringLiteral("Cannot initialise zlib");
+            return false;
+        }
+
+        m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        m_stream.avail_in = static_cast<uInt>(size);
+        for (;;) {
+            if (m_ended) {
+                if (m_stream.avail_in == 0) {
+                    break;
+                }
+                // Concatenated members (pigz, split archives) are one stream
+                inflateReset(&m_stream);
+                m_ended = false;
+            }
+
+            m_stream.next_out = reinterpret_cast<Bytef*>(m_buffer.data());
+            m_stream.avail_out = static_cast<uInt>(m_buffer.size());
+            int rc = inflate(&m_stream, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+                error = QStringLiteral("Corrupt gzip data: %1")
+                            .arg(QString::fromLatin1(m_stream.msg ? m_stream.msg : "inflate failed"));
+                return false;
+            }
+
+            size_t produced = m_buffer.size() - m_stream.avail_out;
+            if (produced > 0 && !sink(m_buffer.data(), produced)) {
+                return false;
+            }
+            m_ended = rc == Z_STREAM_END;
+
+            // Input used up and nothing held back, or no progress possible
+            if ((m_stream.avail_in == 0 && m_stream.avail_out != 0) || rc == Z_BUF_ERROR) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool ended() const override { return m_ended; }
+
+private:
+    z_stream m_stream{};
+    std::vector<char> m_buffer;
+    bool m_ready{false};
+    bool m_ended{false};
+};
+#endif
+
+#ifdef OPENIDM_HAVE_ZSTD
+class ZstdDecoder final : public Decoder {
+public:
+    ZstdDecoder() : m_stream(ZSTD_createDStream()), m_buffer(Constants::EXTRACT_DECODE_BUFFER) {
+        if (m_stream) {
+            ZSTD_initDStream(m_stream);
+        }
+    }
+
+    ~ZstdDecoder() override { ZSTD_freeDStream(m_stream); }
+
+    bool push(const char* data, size_t size, const Sink& sink) override {
+        if (!m_stream) {
+            error = QStringLiteral("Cannot initialise zstd");
+            return false;
+        }
+
+        ZSTD_inBuffer input{data, size, 0};
+        for (;;) {
+            ZSTD_outBuffer output{m_buffer.data(), m_buffer.size(), 0};
+            size_t rc = ZSTD_decompressStream(m_stream, &output, &input);
+            if (ZSTD_isError(rc)) {
+                error = QStringLiteral("Corrupt zstd data: %1").arg(QString::fromLatin1(ZSTD_getErrorName(rc)));
+                return false;
+            }
+            if (output.pos > 0 && !sink(m_buffer.data(), output.pos)) {
+                return false;
+            }
+            m_ended = rc == 0;  // A frame is complete and flushed
+
+            if (input.pos == input.size && output.pos < output.size) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool ended() const override { return m_ended; }
+
+private:
+    ZSTD_DStream* m_stream;
+    std::vector<char> m_buffer;
+    bool m_ended{false};
+};
+#endif
+
+std::unique_ptr<Decoder> makeDecoder(ArchiveExtractor::Format format) {
+    switch (format) {
+    case ArchiveExtractor::Format::Tar:
+        return std::make_unique<PlainDecoder>();
+#ifdef OPENIDM_HAVE_ZLIB
+    case ArchiveExtractor::Format::TarGzip:
+        return std::make_unique<GzipDecoder>();
+#endif
+#ifdef OPENIDM_HAVE_ZSTD
+    case ArchiveExtractor::Format::TarZstd:
+        return std::make_unique<ZstdDecoder>();
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+// tar
+// ───────────────────────────────────────────────────────────────────────────
+
+QString headerString(const char* field, size_t length) {
+    return QString::fromUtf8(field, static_cast<qsizetype>(strnlen(field, length)));
+}
+
+/// @return Octal (or GNU base-256) number field, -1 if malformed
+ByteCount headerNumber(const char* field, size_t length) {
+    ByteCount value = 0;
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        for (size_t i = 1; i < length; ++i) {
+            if (value > (std::numeric_limits<ByteCount>::max() >> 8)) {
+                return -1;
+            }
+            value = (value << 8) | static_cast<unsigned char>(field[i]);
+        }
+        return value;
+    }
+
+    size_t i = 0;
+    while (i < length && field[i] == ' ') {
+        ++i;
+    }
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i) {
+        if (value > (std::numeric_limits<ByteCount>::max() >> 3)) {
+            return -1;
+        }
+        value = (value << 3) | (field[i] - '0');
+    }
+    if (i < length && field[i] != '\0' && field[i] != ' ') {
+        return -1;
+    }
+    return value;
+}
+
+/// Old writers summed signed chars; both sums are accepted
+bool checksumMatches(const char* block) {
+    ByteCount stored = headerNumber(block + 148, 8);
+    int64_t unsignedSum = 0;
+    int64_t signedSum = 0;
+    for (size_t i = 0; i < TAR_BLOCK; ++i) {
+        char c = (i >= 148 && i < 156) ? ' ' : block[i];
+        unsignedSum += static_cast<unsigned char>(c);
+        signedSum += static_cast<signed char>(c);
+    }
+    return stored == unsignedSum || stored == signedSum;
+}
+
+QFileDevice::Permissions permissionsFor(uint32_t mode) {
+    // The owner can always replace or delete what was extracted
+    QFileDevice::Permissions permissions = QFileDevice::ReadOwner | QFileDevice::WriteOwner |
+                                           QFileDevice::ReadUser | QFileDevice::WriteUser;
+    if (mode & 0100) permissions |= QFileDevice::ExeOwner | QFileDevice::ExeUser;
+    if (mode & 0040) permissions |= QFileDevice::ReadGroup;
+    if (mode & 0020) permissions |= QFileDevice::WriteGroup;
+    if (mode & 0010) permissions |= QFileDevice::ExeGroup;
+    if (mode & 0004) permissions |= QFileDevice::ReadOther;
+    if (mode & 0002) permissions |= QFileDevice::WriteOther;
+    if (mode & 0001) permissions |= QFileDevice::ExeOther;
+    return permissions;
+}
+
+/**
+ * @brief ustar / GNU / pax reader that writes entries as their bytes arrive
+ */
+class TarReader {
+public:
+    explicit TarReader(QString root) : m_root(std::move(root)) {}
+
+    /// @return False on a corrupt header or a failed write (error is set)
+    bool push(const char* data, size_t size) {
+        while (size > 0 && m_stage != Stage::Done) {
+            if (m_stage == Stage::Header) {
+                size_t take = std::min(size, TAR_BLOCK - m_filled);
+                std::memcpy(m_header + m_filled, data, take);
+                m_filled += take;
+                data += take;
+                size -= take;
+                if (m_filled == TAR_BLOCK) {
+                    m_filled = 0;
+                    if (!parseHeader()) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+
+            if (m_remaining > 0) {
+                size_t take = static_cast<size_t>(std::min<ByteCount>(static_cast<ByteCount>(size), m_remaining));
+                if (!consumeBody(data, take)) {
+                    return false;
+                }
+                m_remaining -= static_cast<ByteCount>(take);
+                data += take;
+                size -= take;
+            } else {
+                size_t take = static_cast<size_t>(std::min<ByteCount>(static_cast<ByteCount>(size), m_padding));
+                m_padding -= static_cast<ByteCount>(take);
+                data += take;
+                size -= take;
+            }
+            if (m_remaining == 0 && m_padding == 0 && !endEntry()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @return True once the end-of-archive blocks were read
+    bool done() const { return m_stage == Stage::Done; }
+
+    /// @return True if the data so far ends between two entries
+    bool atBoundary() const { return m_stage == Stage::Header && m_filled == 0; }
+
+    int entries() const { return m_entries; }
+
+    QString error;
+
+private:
+    enum class Stage { Header, Body, Done };
+    enum class Kind { File, LongName, LongLink, Pax, Skip };
+
+    bool parseHeader() {
+        if (std::all_of(m_header, m_header + TAR_BLOCK, [](char c) { return c == 0; })) {
+            if (++m_zeroBlocks == 2) {
+                m_stage = Stage::Done;
+            }
+            return true;
+        }
+        m_zeroBlocks = 0;
+
+        if (!checksumMatches(m_header)) {
+            error = m_entries == 0 ? QStringLiteral("Not a tar archive") : QStringLiteral("Corrupt tar header");
+            return false;
+        }
+
+        ByteCount size = headerNumber(m_header + 124, 12);
+        ByteCount mode = headerNumber(m_header + 100, 8);
+        if (size < 0 || mode < 0) {
+            error = QStringLiteral("Corrupt tar header");
+            return false;
+        }
+        char type = m_header[156];
+
+        m_kind = Kind::Skip;
+        switch (type) {
+        case 'L':
+            m_kind = Kind::LongName;
+            break;
+        case 'K':
+            m_kind = Kind::LongLink;
+            break;
+        case 'x':
+            m_kind = Kind::Pax;
+            break;
+        case 'g':
+            break;  // Global pax defaults: nothing here needs them
+        default:
+            if (!beginEntry(type, size, static_cast<uint32_t>(mode))) {
+                return false;
+            }
+            size = m_remaining;
+            break;
+        }
+        if (m_kind == Kind::LongName || m_kind == Kind::LongLink || m_kind == Kind::Pax) {
+            if (size > MAX_TAR_META) {
+                error = QStringLiteral("Oversized tar header");
+                return false;
+            }
+            m_meta.clear();
+        }
+
+        m_remaining = size;
+        m_padding = static_cast<ByteCount>((TAR_BLOCK - static_cast<size_t>(size % TAR_BLOCK)) % TAR_BLOCK);
+        m_stage = Stage::Body;
+        return m_remaining > 0 || m_padding > 0 || endEntry();
+    }
+
+    /// @brief Create a directory or link now, or open the file the body goes to
+    bool beginEntry(char type, ByteCount size, uint32_t mode) {
+        QString name = headerString(m_header, 100);
+        // POSIX ustar only: old GNU headers ("ustar  ") keep times there
+        if (std::memcmp(m_header + 257, "ustar", 6) == 0) {
+            QString prefix = headerString(m_header + 345, 155);
+            if (!prefix.isEmpty()) {
+                name = prefix + QLatin1Char('/') + name;
+            }
+        }
+        QString link = headerString(m_header + 157, 100);
+
+        // Earlier long-name / pax headers describe this entry
+        if (!m_nextName.isEmpty()) {
+            name = std::exchange(m_nextName, QString());
+        }
+        if (!m_nextLink.isEmpty()) {
+            link = std::exchange(m_nextLink, QString());
+        }
+        if (m_nextSize >= 0) {
+            size = std::exchange(m_nextSize, -1);
+        }
+        m_remaining = size;
+
+        QString relative = sanitize(name);
+        if (relative.isEmpty()) {
+            qWarning() << "ArchiveExtractor: Skipping unsafe entry" << name;
+            return true;
+        }
+        QString target = m_root + QLatin1Char('/') + relative;
+
+        switch (type) {
+        case '0':
+        case '7':
+        case '\0': {
+            // Replace rather than write through an existing link
+            if (QFileInfo(target).isSymLink()) {
+                QFile::remove(target);
+            }
+            QDir().mkpath(QFileInfo(target).path());
+            m_file.setFileName(target);
+            if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                error = QStringLiteral("Cannot write %1: %2").arg(relative, m_file.errorString());
+                return false;
+            }
+            m_kind = Kind::File;
+            m_mode = mode;
+            return true;
+        }
+        case '5':
+            if (!QDir().mkpath(target)) {
+                error = QStringLiteral("Cannot create %1").arg(relative);
+                return false;
+            }
+            ++m_entries;
+            return true;
+        case '1': {
+            // Hard links become copies of the entry they name
+            QString source = sanitize(link);
+            QString sourcePath = m_root + QLatin1Char('/') + source;
+            if (source.isEmpty() || !QFileInfo(sourcePath).isFile() || QFileInfo(sourcePath).isSymLink()) {
+                qWarning() << "ArchiveExtractor: Skipping hard link" << name << "->" << link;
+                return true;
+            }
+            QFile::remove(target);
+            QDir().mkpath(QFileInfo(target).path());
+            if (!QFile::copy(sourcePath, target)) {
+                error = QStringLiteral("Cannot write %1").arg(relative);
+                return false;
+            }
+            ++m_entries;
+            return true;
+        }
+        case '2': {
+#ifdef Q_OS_WIN
+            qDebug() << "ArchiveExtractor: Skipping symbolic link" << name;
+#else
+            // The link may point anywhere inside the target, never out of it
+            QString resolved = QDir::cleanPath(QFileInfo(relative).path() + QLatin1Char('/') + link);
+            if (link.isEmpty() || QDir::isAbsolutePath(link) || resolved == QStringLiteral("..") ||
+                resolved.startsWith(QStringLiteral("../"))) {
+                qWarning() << "ArchiveExtractor: Skipping symbolic link" << name << "->" << link;
+                return true;
+            }
+            QFile::remove(target);
+            QDir().mkpath(QFileInfo(target).path());
+            if (!QFile::link(link, target)) {
+                error = QStringLiteral("Cannot create link %1").arg(relative);
+                return false;
+            }
+            ++m_entries;
+#endif
+            return true;
+        }
+        default:
+            qDebug() << "ArchiveExtractor: Skipping special entry" << name << "of type" << type;
+            return true;
+        }
+    }
+
+    bool consumeBody(const char* data, size_t size) {
+        switch (m_kind) {
+        case Kind::File:
+            if (m_file.write(data, static_cast<qint64>(size)) != static_cast<qint64>(size)) {
+                error = QStringLiteral("Cannot write %1: %2").arg(m_file.fileName(), m_file.errorString());
+                return false;
+            }
+            return true;
+        case Kind::LongName:
+        case Kind::LongLink:
+        case Kind::Pax:
+            m_meta.append(data, static_cast<qsizetype>(size));
+            return true;
+        case Kind::Skip:
+            return true;
+        }
+        return true;
+    }
+
+    bool endEntry() {
+        m_stage = Stage::Header;
+        switch (m_kind) {
+        case Kind::File: {
+            QString path = m_file.fileName();
+            m_file.close();
+            if (m_mode != 0) {
+                QFile::setPermissions(path, permissionsFor(m_mode));
+            }
+            ++m_entries;
+            break;
+        }
+        case Kind::LongName:
+            m_nextName = headerString(m_meta.constData(), static_cast<size_t>(m_meta.size()));
+            break;
+        case Kind::LongLink:
+            m_nextLink = headerString(m_meta.constData(), static_cast<size_t>(m_meta.size()));
+            break;
+        case Kind::Pax:
+            parsePax();
+            break;
+        case Kind::Skip:
+            break;
+        }
+        m_kind = Kind::Skip;
+        m_meta.clear();
+        return true;
+    }
+
+    /// Records are "<length> <key>=<value>\n"
+    void parsePax() {
+        qsizetype pos = 0;
+        while (pos < m_meta.size()) {
+            qsizetype space = m_meta.indexOf(' ', pos);
+            if (space < 0) {
+                return;
+            }
+            bool ok = false;
+            qsizetype length = m_meta.mid(pos, space - pos).toLongLong(&ok);
+            if (!ok || length <= space - pos + 1 || pos + length > m_meta.size()) {
+                return;
+            }
+
+            QByteArray record = m_meta.mid(space + 1, pos + length - space - 2);
+            qsizetype equals = record.indexOf('=');
+            if (equals > 0) {
+                QByteArray key = record.left(equals);
+                QByteArray value = record.mid(equals + 1);
+                if (key == "path") {
+                    m_nextName = QString::fromUtf8(value);
+                } else if (key == "linkpath") {
+                    m_nextLink = QString::fromUtf8(value);
+                } else if (key == "size") {
+                    m_nextSize = value.toLongLong(&ok);
+                    if (!ok || m_nextSize < 0) {
+                        m_nextSize = -1;
+                    }
+                }
+            }
+            pos += length;
+        }
+    }
+
+    /**
+     * @return @p name relative to the root with "." parts removed, or empty
+     *         if it is absolute, climbs out or passes through a symbolic link
+     */
+    QString sanitize(const QString& name) const {
+        if (name.startsWith(QLatin1Char('/')) || name.startsWith(QLatin1Char('\\')) || QDir::isAbsolutePath(name)) {
+            return {};
+        }
+
+        QStringList parts;
+        for (const QString& part : name.split(QLatin1Char('/'), Qt::SkipEmptyParts)) {
+            if (part == QStringLiteral(".")) {
+                continue;
+            }
+            if (part == QStringLiteral("..") || part.contains(QLatin1Char('\\')) || part.contains(QLatin1Char(':'))) {
+                return {};
+            }
+            parts.append(part);
+        }
+        if (parts.isEmpty()) {
+            return {};
+        }
+
+        // Nothing is written through a link, whether the archive made it or not
+        QString path = m_root;
+        for (qsizetype i = 0; i + 1 < parts.size(); ++i) {
+            path += QLatin1Char('/') + parts[i];
+            if (QFileInfo(path).isSymLink()) {
+                return {};
+            }
+        }
+        return parts.join(QLatin1Char('/'));
+    }
+
+    QString m_root;
+    Stage m_stage{Stage::Header};
+    char m_header[TAR_BLOCK]{};
+    size_t m_filled{0};
+    int m_zeroBlocks{0};
+
+    // Current entry
+    Kind m_kind{Kind::Skip};
+    ByteCount m_remaining{0};           ///< Body bytes left
+    ByteCount m_padding{0};             ///< Bytes to the next block after the body
+    QFile m_file;
+    uint32_t m_mode{0};
+    QByteArray m_meta;                  ///< Long name or pax records
+
+    // From long-name and pax headers, for the next entry
+    QString m_nextName;
+    QString m_nextLink;
+    ByteCount m_nextSize{-1};
+
+    int m_entries{0};
+};
+
+} // anonymous namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+ArchiveExtractor::ArchiveExtractor(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ArchiveExtractor::~ArchiveExtractor() {
+    cancel();
+}
+
+ArchiveExtractor::Format ArchiveExtractor::formatFor(const QString& fileName) {
+    QString name = fileName.toLower();
+    if (name.endsWith(QStringLiteral(".tar"))) {
+        return Format::Tar;
+    }
+    if (name.endsWith(QStringLiteral(".tar.gz")) || name.endsWith(QStringLiteral(".tgz"))) {
+        return Format::TarGzip;
+    }
+    if (name.endsWith(QStringLiteral(".tar.zst")) || name.endsWith(QStringLiteral(".tar.zstd")) ||
+        name.endsWith(QStringLiteral(".tzst"))) {
+        return Format::TarZstd;
+    }
+    return Format::Unknown;
+}
+
+bool ArchiveExtractor::supports(Format format) {
+    switch (format) {
+    case Format::Tar:
+        return true;
+    case Format::TarGzip:
+#ifdef OPENIDM_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case Format::TarZstd:
+#ifdef OPENIDM_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    case Format::Unknown:
+        break;
+    }
+    return false;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Control
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool ArchiveExtractor::start(Format format, const QString& targetDir) {
+    if (isRunning()) {
+        return false;
+    }
+    cancel();  // Join a thread that already finished
+
+    if (!supports(format)) {
+        qWarning() << "ArchiveExtractor: Archive format not supported by this build";
+        return false;
+    }
+    if (!QDir().mkpath(targetDir)) {
+        qWarning() << "ArchiveExtractor: Cannot create" << targetDir;
+        return false;
+    }
+
+    m_format = format;
+    m_targetDir = QDir(targetDir).absolutePath();
+    {
+        std::lock_guard lock(m_mutex);
+        m_sourcePath.clear();
+        m_available = 0;
+        m_complete = false;
+        m_stopping = false;
+    }
+    m_consumed.store(0, std::memory_order_relaxed);
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&ArchiveExtractor::run, this);
+    return true;
+}
+
+void ArchiveExtractor::advance(const QString& sourcePath, ByteOffset available, bool complete) {
+    bool moved;
+    {
+        std::lock_guard lock(m_mutex);
+        moved = sourcePath != m_sourcePath;
+        m_sourcePath = sourcePath;
+        m_available = std::max(m_available, available);
+        m_complete = complete;
+    }
+    m_wake.notify_one();
+
+    // The thread re-reads the path under this lock, so once it is ours the
+    // old file is closed and will not be opened again
+    if (moved) {
+        std::lock_guard file(m_fileMutex);
+    }
+}
+
+void ArchiveExtractor::cancel() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_running.store(false, std::memory_order_release);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Extraction Thread
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ArchiveExtractor::run() {
+    std::unique_ptr<Decoder> decoder = makeDecoder(m_format);
+    TarReader tar(m_targetDir);
+    Sink sink = [&tar](const char* data, size_t size) { return tar.push(data, size) && !tar.done(); };
+
+    QByteArray chunk;
+    ByteOffset position = 0;
+    for (;;) {
+        bool complete;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] {
+                return m_stopping || (!m_sourcePath.isEmpty() && (m_available > position || m_complete));
+            });
+            if (m_stopping) {
+                return;
+            }
+            complete = m_complete && m_available <= position;
+        }
+
+        if (complete) {
+            if (!decoder->ended() || !tar.atBoundary()) {
+                fail(QStringLiteral("Archive is truncated"));
+                return;
+            }
+            break;
+        }
+
+        {
+            std::lock_guard file(m_fileMutex);
+            QString path;
+            ByteOffset end;
+            {
+                std::lock_guard lock(m_mutex);
+                path = m_sourcePath;
+                end = m_available;
+            }
+            if (path.isEmpty()) {
+                continue;  // Closed while this thread waited for the file
+            }
+
+            QFile source(path);
+            if (!source.open(QIODevice::ReadOnly) || !source.seek(position)) {
+                fail(QStringLiteral("Cannot read %1: %2").arg(path, source.errorString()));
+                return;
+            }
+            chunk.resize(static_cast<qsizetype>(std::min(end - position, Constants::EXTRACT_READ_CHUNK)));
+            qint64 read = source.read(chunk.data(), chunk.size());
+            if (read <= 0) {
+                fail(QStringLiteral("Cannot read %1: %2").arg(path, source.errorString()));
+                return;
+            }
+            chunk.resize(static_cast<qsizetype>(read));
+        }
+
+        position += chunk.size();
+        m_consumed.store(position, std::memory_order_relaxed);
+
+        if (!decoder->push(chunk.constData(), static_cast<size_t>(chunk.size()), sink) && !tar.done()) {
+            fail(!tar.error.isEmpty() ? tar.error : decoder->error);
+            return;
+        }
+        if (tar.done()) {
+            break;
+        }
+    }
+
+    int entries = tar.entries();
+    qDebug() << "ArchiveExtractor: Extracted" << entries << "entries into" << m_targetDir;
+    m_running.store(false, std::memory_order_release);
+    QMetaObject::invokeMethod(this, [this, entries]() {
+        cancel();
+        emit finished(m_targetDir, entries);
+    }, Qt::QueuedConnection);
+}
+
+void ArchiveExtractor::fail(const QString& error) {
+    qWarning() << "ArchiveExtractor:" << error;
+    m_running.store(false, std::memory_order_release);
+    QMetaObject::invokeMethod(this, [this, error]() {
+        cancel();
+        emit failed(error);
+    }, Qt::QueuedConnection);
+}
+
+} // namespace OpenIDM
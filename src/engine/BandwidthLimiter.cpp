@@ -0,0 +1,285 @@
+/**
+ * @file BandwidthLimiter.cpp
+ * @brief Implementation of hierarchical token-bucket bandwidth limiting
+ */
+
+#include "openidm/engine/BandwidthLimiter.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace OpenIDM {
+
+namespace {
+
+/// Burst allowance: a quarter second of traffic, but at least one chunk
+constexpr int64_t BURST_DIVISOR = 4;
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t burstFor(int64_t rate) {
+    return std::max<int64_t>(rate / BURST_DIVISOR, Constants::CHUNK_SIZE);
+}
+
+/**
+ * @brief Weighted water-filling of @p budget over @p claims
+ *
+ * Claims whose demand is below their weighted portion get their demand;
+ * what they leave is split again among the rest until nobody is satisfied
+ * early. @p rates is indexed like @p claims.
+ * @return Budget left over
+ */
+SpeedBps fill(const std::vector<BandwidthLimiter::ShareClaim>& claims, const std::vector<size_t>& members,
+              const std::vector<SpeedBps>& demand, SpeedBps budget, std::vector<SpeedBps>& rates) {
+    std::vector<size_t> open = members;
+    while (!open.empty() && budget > 0) {
+        double weights = 0;
+        for (size_t i : open) {
+            weights += claims[i].weight;
+        }
+        double perWeight = budget / weights;
+
+        std::vector<size_t> unsatisfied;
+        for (size_t i : open) {
+            if (demand[i] <= perWeight * claims[i].weight) {
+                rates[i] = demand[i];
+                budget -= demand[i];
+            } else {
+                unsatisfied.push_back(i);
+            }
+        }
+        if (unsatisfied.size() == open.size()) {
+            for (size_t i : open) {
+                rates[i] = perWeight * claims[i].weight;
+            }
+            return 0;
+        }
+        open = std::move(unsatisfied);
+    }
+    return std::max<SpeedBps>(budget, 0);
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// TokenBucket
+// ═══════════════════════════════════════════════════════════════════════════════
+
+TokenBucket::TokenBucket(TokenBucket* parent)
+    : m_parent(parent)
+    , m_lastRefillNs(steadyNowNs())
+{
+}
+
+void TokenBucket::setRate(SpeedBps bytesPerSecond) {
+    int64_t rate = std::max<int64_t>(static_cast<int64_t>(bytesPerSecond), 0);
+    m_rate.store(rate, std::memory_order_relaxed);
+
+    // Start full so a new limit does not stall running transfers
+    m_tokens.store(rate > 0 ? burstFor(rate) : 0, std::memory_order_relaxed);
+    m_lastRefillNs.store(steadyNowNs(), std::memory_order_relaxed);
+}
+
+void TokenBucket::adjustRate(SpeedBps bytesPerSecond) {
+    int64_t rate = std::max<int64_t>(static_cast<int64_t>(bytesPerSecond), 0);
+    int64_t previous = m_rate.load(std::memory_order_relaxed);
+    if (previous == rate) {
+        return;
+    }
+    if (previous <= 0 || rate <= 0) {
+        setRate(bytesPerSecond);
+        return;
+    }
+
+    // Settle the credit earned at the old rate before switching
+    refill();
+    m_rate.store(rate, std::memory_order_relaxed);
+
+    int64_t burst = burstFor(rate);
+    int64_t tokens = m_tokens.load(std::memory_order_relaxed);
+    while (tokens > burst && !m_tokens.compare_exchange_weak(tokens, burst, std::memory_order_relaxed)) {
+    }
+}
+
+bool TokenBucket::isLimited() const {
+    for (const TokenBucket* b = this; b; b = b->m_parent) {
+        if (b->m_rate.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TokenBucket::consume(ByteCount bytes) {
+    for (TokenBucket* b = this; b; b = b->m_parent) {
+        if (b->m_rate.load(std::memory_order_relaxed) > 0) {
+            b->refill();
+            b->m_tokens.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+    }
+}
+
+Duration TokenBucket::delay() {
+    Duration longest{0};
+    for (TokenBucket* b = this; b; b = b->m_parent) {
+        longest = std::max(longest, b->ownDelay());
+    }
+    return longest;
+}
+
+void TokenBucket::refill() {
+    int64_t rate = m_rate.load(std::memory_order_relaxed);
+    if (rate <= 0) {
+        return;
+    }
+
+    int64_t now = steadyNowNs();
+    int64_t last = m_lastRefillNs.load(std::memory_order_relaxed);
+    int64_t elapsed = now - last;
+
+    // Below ~1 byte of credit; not worth a CAS
+    if (elapsed * rate < 1'000'000'000LL) {
+        return;
+    }
+
+    // Only the thread that advances the timestamp adds the credit
+    if (!m_lastRefillNs.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        return;
+    }
+
+    int64_t credit = static_cast<int64_t>(static_cast<double>(elapsed) * rate / 1e9);
+    int64_t burst = burstFor(rate);
+
+    int64_t tokens = m_tokens.load(std::memory_order_relaxed);
+    int64_t updated;
+    do {
+        updated = std::min(tokens + credit, burst);
+    } while (!m_tokens.compare_exchange_weak(tokens, updated, std::memory_order_relaxed));
+}
+
+Duration TokenBucket::ownDelay() {
+    int64_t rate = m_rate.load(std::memory_order_relaxed);
+    if (rate <= 0) {
+        return Duration{0};
+    }
+
+    refill();
+
+    int64_t tokens = m_tokens.load(std::memory_order_relaxed);
+    if (tokens >= 0) {
+        return Duration{0};
+    }
+
+    // Round up so callers never spin on a sub-millisecond wait
+    return Duration{(-tokens * 1000 + rate - 1) / rate};
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// BandwidthLimiter
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool BandwidthLimiter::ScheduleRule::matches(const QDateTime& when) const {
+    int day = when.date().dayOfWeek() - 1;  // Monday = 0
+    QTime time = when.time();
+
+    if (start <= end) {
+        return (dayMask & (1u << day)) && time >= start && time < end;
+    }
+
+    // Window wraps past midnight: the early-morning part belongs to the
+    // previous day's rule
+    if (time >= start) {
+        return dayMask & (1u << day);
+    }
+    if (time < end) {
+        int previous = (day + 6) % 7;
+        return dayMask & (1u << previous);
+    }
+    return false;
+}
+
+BandwidthLimiter& BandwidthLimiter::instance() {
+    static BandwidthLimiter limiter;
+    return limiter;
+}
+
+void BandwidthLimiter::setGlobalLimit(SpeedBps limit) {
+    {
+        std::lock_guard lock(m_scheduleMutex);
+        m_baseLimit = limit;
+    }
+    applySchedule();
+}
+
+SpeedBps BandwidthLimiter::globalLimit() const {
+    std::lock_guard lock(m_scheduleMutex);
+    return m_baseLimit;
+}
+
+void BandwidthLimiter::setSchedule(std::vector<ScheduleRule> rules) {
+    {
+        std::lock_guard lock(m_scheduleMutex);
+        m_schedule = std::move(rules);
+    }
+    applySchedule();
+}
+
+void BandwidthLimiter::applySchedule(const QDateTime& now) {
+    SpeedBps limit;
+    {
+        std::lock_guard lock(m_scheduleMutex);
+        limit = m_baseLimit;
+        for (const auto& rule : m_schedule) {
+            if (rule.matches(now)) {
+                limit = rule.limit;
+                break;
+            }
+        }
+    }
+
+    // Avoid resetting the bucket every tick when nothing changed
+    if (limit != m_global.rate()) {
+        m_global.setRate(limit);
+    }
+}
+
+void BandwidthLimiter::share(const std::vector<ShareClaim>& claims) {
+    SpeedBps limit = effectiveLimit();
+    if (limit <= 0) {
+        for (const ShareClaim& claim : claims) {
+            claim.bucket->adjustRate(claim.cap);
+        }
+        return;
+    }
+
+    // A claim that used (nearly) all of its last rate may want more than any
+    // share; one that did not is held to a bit above what it managed
+    std::vector<SpeedBps> demand(claims.size());
+    std::vector<size_t> foreground;
+    std::vector<size_t> background;
+    for (size_t i = 0; i < claims.size(); ++i) {
+        const ShareClaim& claim = claims[i];
+        SpeedBps rate = claim.bucket->rate();
+        bool saturated = rate <= 0 || claim.speed >= rate * Constants::FAIR_SHARE_SATURATED;
+        demand[i] = saturated ? limit
+                              : std::max(claim.speed * Constants::FAIR_SHARE_HEADROOM, Constants::MIN_FAIR_SHARE);
+        if (claim.cap > 0) {
+            demand[i] = std::min(demand[i], claim.cap);
+        }
+        (claim.foreground ? foreground : background).push_back(i);
+    }
+
+    std::vector<SpeedBps> rates(claims.size(), 0.0);
+    SpeedBps left = fill(claims, foreground, demand, limit, rates);
+    fill(claims, background, demand, left, rates);
+
+    // A rate of 0 would mean unlimited; a starved task keeps a trickle
+    for (size_t i = 0; i < claims.size(); ++i) {
+        claims[i].bucket->adjustRate(std::max(rates[i], Constants::MIN_FAIR_SHARE));
+    }
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,96 @@
+/**
+ * @file ConnectionTuner.cpp
+ * @brief Implementation of ConnectionTuner - adaptive connection count
+ */
+
+#include "openidm/engine/ConnectionTuner.h"
+#include "openidm/engine/HostCache.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+ConnectionTuner::ConnectionTuner(const QString& host, size_t maxConnections)
+    : m_host(host.toLower())
+    , m_max(std::max<size_t>(maxConnections, 1))
+{
+    size_t learned = learnedOptimum(m_host);
+    m_count = std::min(learned > 0 ? learned : Constants::INITIAL_CONNECTIONS, m_max);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Control Loop
+// ═══════════════════════════════════════════════════════════════════════════════
+
+size_t ConnectionTuner::update(SpeedBps throughput) {
+    if (m_settled) {
+        return m_count;
+    }
+
+    // New connections are still in slow start
+    if (m_warmingUp) {
+        m_warmingUp = false;
+        return m_count;
+    }
+
+    if (m_baselineCount == 0) {
+        m_baselineCount = m_count;
+        m_baselineThroughput = throughput;
+        return grow();
+    }
+
+    // Gain per added connection, relative to what one connection delivered
+    // at the baseline. Below the threshold the server (or the link) is the
+    // bottleneck and more connections only cost.
+    double added = static_cast<double>(m_count - m_baselineCount);
+    double perConnection = m_baselineThroughput / static_cast<double>(m_baselineCount);
+    double marginal = (throughput - m_baselineThroughput) / added;
+
+    if (perConnection > 0.0 && marginal >= perConnection * Constants::MIN_MARGINAL_GAIN) {
+        m_baselineCount = m_count;
+        m_baselineThroughput = throughput;
+        return grow();
+    }
+
+    return settle(m_baselineCount);
+}
+
+size_t ConnectionTuner::grow() {
+    if (m_count >= m_max) {
+        return settle(m_count);
+    }
+
+    // Multiplicative steps: +50% (at least one)
+    m_count = std::min(m_max, m_count + std::max<size_t>(m_count / 2, 1));
+    m_warmingUp = true;
+    return m_count;
+}
+
+size_t ConnectionTuner::settle(size_t count) {
+    m_count = count;
+    m_settled = true;
+    rememberOptimum(m_host, count);
+
+    qDebug() << "ConnectionTuner: Settled on" << count << "connection(s) for" << m_host;
+    return m_count;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Per-host Memory
+// ═══════════════════════════════════════════════════════════════════════════════
+
+size_t ConnectionTuner::learnedOptimum(const QString& host) {
+    return HostCache::instance().learnedConnections(host);
+}
+
+void ConnectionTuner::rememberOptimum(const QString& host, size_t count) {
+    HostCache::instance().rememberConnections(host, count);
+}
+
+} // namespace OpenIDM
@@ -7,15 +7,83 @@
  */
 
 #include "CurlWrapper.h"
+#include "openidm/engine/HttpHeaderParser.h"
 
 #include <QDebug>
-#include <QRegularExpression>
 #include <QMutexLocker>
 
 #include <mutex>
 
 namespace OpenIDM {
 
+// ═══════════════════════════════════════════════════════════════════════════════
+// CurlShare Implementation
+// ═══════════════════════════════════════════════════════════════════════════════
+
+CurlShare::CurlShare()
+{
+    m_share = curl_share_init();
+    if (!m_share) {
+        qWarning() << "Failed to create CURL share object, connections will not be shared";
+        return;
+    }
+
+    curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, lockCallback);
+    curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+    curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900  // 7.57.0
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x073d00  // 7.61.0
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_PSL);
+#endif
+}
+
+CurlShare::~CurlShare()
+{
+    if (m_share) {
+        CURLSHcode result = curl_share_cleanup(m_share);
+        if (result != CURLSHE_OK) {
+            qWarning() << "CURL share still in use at cleanup:" << curl_share_strerror(result);
+        }
+        m_share = nullptr;
+    }
+}
+
+void CurlShare::attach(CURL* handle) const
+{
+    if (m_share && handle) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, m_share);
+    }
+}
+
+void CurlShare::detach(CURL* handle)
+{
+    if (handle) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, nullptr);
+    }
+}
+
+void CurlShare::lockCallback(CURL* /*handle*/, curl_lock_data data,
+                             curl_lock_access /*access*/, void* userptr)
+{
+    auto* self = static_cast<CurlShare*>(userptr);
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        self->m_locks[data].lock();
+    }
+}
+
+void CurlShare::unlockCallback(CURL* /*handle*/, curl_lock_data data, void* userptr)
+{
+    auto* self = static_cast<CurlShare*>(userptr);
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        self->m_locks[data].unlock();
+    }
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // CurlGlobalInit Implementation
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -36,10 +104,15 @@ CurlGlobalInit::CurlGlobalInit()
     } else {
         qInfo() << "libcurl initialized:" << version();
     }
+
+    // Created even when init failed so share() is always dereferenceable
+    m_share = std::make_unique<CurlShare>();
 }
 
 CurlGlobalInit::~CurlGlobalInit()
 {
+    m_share.reset();
+
     if (m_valid) {
         curl_global_cleanup();
         qDebug() << "libcurl global cleanup complete";
@@ -86,6 +159,9 @@ CurlEasyHandle::CurlEasyHandle(QObject* parent)
     // Set error buffer
     curl_easy_setopt(m_handle, CURLOPT_ERRORBUFFER, m_errorBuffer);
 
+    // Shared DNS/TLS/connection caches
+    CurlGlobalInit::instance().share().attach(m_handle);
+
     // Default settings
     curl_easy_setopt(m_handle, CURLOPT_NOSIGNAL, 1L);
     curl_easy_setopt(m_handle, CURLOPT_TCP_KEEPALIVE, 1L);
@@ -97,8 +173,9 @@ CurlEasyHandle::CurlEasyHandle(QObject* parent)
     curl_easy_setopt(m_handle, CURLOPT_SSL_VERIFYHOST, 2L);
 
     // Default timeouts
-    setConnectTimeout(Config::CONNECTION_TIMEOUT_SECONDS);
-    setLowSpeedLimit(Config::LOW_SPEED_LIMIT_BYTES, Config::LOW_SPEED_TIME_SECONDS);
+    setConnectTimeout(static_cast<int>(
+        std::chrono::duration_cast<std::chrono::seconds>(Constants::CONNECT_TIMEOUT).count()));
+    setLowSpeedLimit(Constants::LOW_SPEED_LIMIT, Constants::LOW_SPEED_TIME);
 
     // Default user agent
     setUserAgent("OpenIDM/1.0 (compatible; libcurl)");
@@ -179,7 +256,9 @@ void CurlEasyHandle::reset()
     curl_easy_setopt(m_handle, CURLOPT_NOSIGNAL, 1L);
     curl_easy_setopt(m_handle, CURLOPT_SSL_VERIFYPEER, 1L);
     curl_easy_setopt(m_handle, CURLOPT_SSL_VERIFYHOST, 2L);
-    setConnectTimeout(Config::CONNECTION_TIMEOUT_SECONDS);
+    CurlGlobalInit::instance().share().attach(m_handle);  // curl_easy_reset() drops it
+    setConnectTimeout(static_cast<int>(
+        std::chrono::duration_cast<std::chrono::seconds>(Constants::CONNECT_TIMEOUT).count()));
     setUserAgent("OpenIDM/1.0 (compatible; libcurl)");
     setFollowRedirects(true);
 }
@@ -399,57 +478,16 @@ size_t CurlEasyHandle::headerCallbackStatic(char* buffer, size_t size, size_t ni
     auto* self = static_cast<CurlEasyHandle*>(userdata);
     size_t totalSize = size * nitems;
 
-    QString line = QString::fromUtf8(buffer, static_cast<int>(totalSize)).trimmed();
-    self->parseHeaderLine(line);
+    // Parsed in place; a QString is only built for a user callback
+    HttpHeaderParser::parseLine(std::string_view(buffer, totalSize), self->m_headerInfo);
 
     if (self->m_headerCallback) {
-        self->m_headerCallback(line);
+        self->m_headerCallback(QString::fromUtf8(buffer, static_cast<qsizetype>(totalSize)).trimmed());
     }
 
     return totalSize;
 }
 
-void CurlEasyHandle::parseHeaderLine(const QString& line)
-{
-    if (line.isEmpty()) return;
-
-    // Parse Content-Length
-    if (line.startsWith("Content-Length:", Qt::CaseInsensitive)) {
-        QString value = line.mid(15).trimmed();
-        bool ok;
-        qint64 length = value.toLongLong(&ok);
-        if (ok) {
-            m_headerInfo.contentLength = length;
-        }
-    }
-    // Parse Accept-Ranges
-    else if (line.startsWith("Accept-Ranges:", Qt::CaseInsensitive)) {
-        QString value = line.mid(14).trimmed();
-        m_headerInfo.acceptRanges = (value.toLower() == "bytes");
-    }
-    // Parse Content-Type
-    else if (line.startsWith("Content-Type:", Qt::CaseInsensitive)) {
-        m_headerInfo.contentType = line.mid(13).trimmed();
-    }
-    // Parse Content-Disposition
-    else if (line.startsWith("Content-Disposition:", Qt::CaseInsensitive)) {
-        m_headerInfo.contentDisposition = line.mid(20).trimmed();
-    }
-    // Parse ETag
-    else if (line.startsWith("ETag:", Qt::CaseInsensitive)) {
-        m_headerInfo.etag = line.mid(5).trimmed();
-    }
-    // Parse Last-Modified
-    else if (line.startsWith("Last-Modified:", Qt::CaseInsensitive)) {
-        QString dateStr = line.mid(14).trimmed();
-        m_headerInfo.lastModified = QDateTime::fromString(dateStr, Qt::RFC2822Date);
-    }
-    // Parse Server
-    else if (line.startsWith("Server:", Qt::CaseInsensitive)) {
-        m_headerInfo.server = line.mid(7).trimmed();
-    }
-}
-
 // ═══════════════════════════════════════════════════════════════════════════════
 // Execution
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -4,6 +4,7 @@
  *
  * Provides a clean, exception-safe interface to libcurl that handles:
  * - Global initialization/cleanup
+ * - Process-wide DNS/TLS/connection sharing
  * - Easy handle lifecycle
  * - Progress callbacks
  * - HTTP headers
@@ -23,12 +24,15 @@
 #include <QByteArray>
 #include <QMutex>
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <optional>
 #include <span>
 
-#include "DownloadTypes.h"
+#include "openidm/engine/Types.h"
 
 namespace OpenIDM {
 
@@ -37,6 +41,7 @@ namespace OpenIDM {
 // ═══════════════════════════════════════════════════════════════════════════════
 
 class CurlGlobalInit;
+class CurlShare;
 class CurlEasyHandle;
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -95,6 +100,58 @@ using ProgressCallback = std::function<bool(qint64 downloadTotal, qint64 downloa
  */
 using HeaderCallback = std::function<void(const QString& headerLine)>;
 
+// ═══════════════════════════════════════════════════════════════════════════════
+// CurlShare - RAII for a CURLSH share object
+// ═══════════════════════════════════════════════════════════════════════════════
+
+/**
+ * @brief Thread-safe libcurl share object
+ *
+ * Shares the DNS cache, TLS session cache, connection cache and public
+ * suffix list between every easy handle attached to it, so segments of
+ * the same download (and downloads from the same host) skip repeated
+ * DNS lookups and full TLS handshakes and can pick up idle connections
+ * left by another handle.
+ *
+ * Each shared data kind has its own mutex so DNS lookups never wait for
+ * a connection-cache update.
+ */
+class CurlShare {
+public:
+    CurlShare();
+    ~CurlShare();
+
+    // Non-copyable, non-movable (libcurl keeps a pointer to the mutexes)
+    CurlShare(const CurlShare&) = delete;
+    CurlShare& operator=(const CurlShare&) = delete;
+    CurlShare(CurlShare&&) = delete;
+    CurlShare& operator=(CurlShare&&) = delete;
+
+    /**
+     * @brief Check if the share object was created
+     */
+    [[nodiscard]] bool isValid() const noexcept { return m_share != nullptr; }
+
+    /**
+     * @brief Attach an easy handle to the shared caches
+     *
+     * Handles must be cleaned up (or detached) before the share is destroyed.
+     */
+    void attach(CURL* handle) const;
+
+    /**
+     * @brief Detach an easy handle (its private caches are used again)
+     */
+    static void detach(CURL* handle);
+
+private:
+    static void lockCallback(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockCallback(CURL* handle, curl_lock_data data, void* userptr);
+
+    CURLSH* m_share = nullptr;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> m_locks;
+};
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // CurlGlobalInit - RAII for global init/cleanup
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -135,9 +192,17 @@ public:
      */
     [[nodiscard]] bool supportsProtocol(const QString& protocol) const;
 
+    /**
+     * @brief Process-wide share object for all engine handles
+     */
+    [[nodiscard]] const CurlShare& share() const noexcept { return *m_share; }
+
 private:
     CurlGlobalInit();
     bool m_valid = false;
+
+    // Destroyed before curl_global_cleanup()
+    std::unique_ptr<CurlShare> m_share;
 };
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -148,7 +213,8 @@ private:
  * @brief RAII wrapper for a libcurl easy handle
  *
  * Each SegmentWorker owns one CurlEasyHandle for its downloads.
- * Handles are reusable via reset() for connection reuse benefits.
+ * Handles are reusable via reset() for connection reuse benefits and are
+ * attached to CurlGlobalInit::share() on creation.
  */
 class CurlEasyHandle : public QObject {
     Q_OBJECT
@@ -355,8 +421,6 @@ private:
                                       curl_off_t ultotal, curl_off_t ulnow);
     static size_t headerCallbackStatic(char* buffer, size_t size, size_t nitems, void* userdata);
 
-    void parseHeaderLine(const QString& line);
-
     CURL* m_handle = nullptr;
     curl_slist* m_headerList = nullptr;
     char m_errorBuffer[CURL_ERROR_SIZE] = {0};
@@ -0,0 +1,386 @@
+/**
+ * @file DeltaSync.cpp
+ * @brief Implementation of zsync-style block matching
+ */
+
+#include "openidm/engine/DeltaSync.h"
+#include "platform/FileIo.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+namespace OpenIDM {
+
+namespace {
+
+/// Bits in the rolling-checksum prefilter (2 MB, most windows stop here)
+constexpr unsigned FILTER_BITS = 24;
+
+/// Bytes per copy when seeding the partial file
+constexpr qint64 COPY_CHUNK = 1024 * 1024;
+
+/**
+ * @brief rsync/zsync rolling checksum of one block
+ *
+ * a is the byte sum and b the sum weighted by distance from the block's
+ * end, both modulo 2^16; stored as a (high) and b (low) of 32 bits.
+ */
+struct Rsum {
+    uint16_t a = 0;
+    uint16_t b = 0;
+
+    uint32_t value() const { return (static_cast<uint32_t>(a) << 16) | b; }
+
+    static Rsum of(const unsigned char* data, size_t size) {
+        Rsum sum;
+        for (size_t i = 0; i < size; ++i) {
+            sum.a = static_cast<uint16_t>(sum.a + data[i]);
+            sum.b = static_cast<uint16_t>(sum.b + (size - i) * data[i]);
+        }
+        return sum;
+    }
+
+    /// Slide the window one byte: @p out leaves, @p in enters
+    void roll(unsigned char out, unsigned char in, size_t size) {
+        a = static_cast<uint16_t>(a - out + in);
+        b = static_cast<uint16_t>(b - size * out + a);
+    }
+};
+
+uint32_t rsumMask(int bytes) {
+    return bytes >= 4 ? 0xffffffffu : (1u << (8 * bytes)) - 1;
+}
+
+uint32_t filterSlot(uint32_t rsum) {
+    // Spread the (possibly few) stored bits over the filter
+    return (rsum * 2654435761u) >> (32 - FILTER_BITS);
+}
+
+} // anonymous namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Control Files
+// ═══════════════════════════════════════════════════════════════════════════════
+
+BlockMap BlockMap::fromZsync(const QByteArray& data) {
+    BlockMap map;
+    qsizetype pos = 0;
+    bool sawMagic = false;
+
+    // "Key: value" lines up to an empty one
+    for (;;) {
+        qsizetype end = data.indexOf('\n', pos);
+        if (end < 0) {
+            return {};
+        }
+        QByteArray line = data.mid(pos, end - pos).trimmed();
+        pos = end + 1;
+        if (line.isEmpty()) {
+            break;
+        }
+
+        qsizetype colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        QByteArray key = line.left(colon).trimmed().toLower();
+        QByteArray value = line.mid(colon + 1).trimmed();
+
+        if (key == "zsync") {
+            sawMagic = true;
+        } else if (key == "length") {
+            map.length = value.toLongLong();
+        } else if (key == "blocksize") {
+            map.blockSize = value.toLongLong();
+        } else if (key == "hash-lengths") {
+            QList<QByteArray> lengths = value.split(',');
+            if (lengths.size() != 3) {
+                return {};
+            }
+            map.sequentialMatches = lengths[0].toInt();
+            map.rsumBytes = lengths[1].toInt();
+            map.checksumBytes = lengths[2].toInt();
+        } else if (key == "sha-1") {
+            map.sha1 = QByteArray::fromHex(value);
+        }
+    }
+
+    if (!sawMagic || map.length <= 0 || map.blockSize <= 0 || map.blockSize > 1024 * 1024 ||
+        map.sequentialMatches < 1 || map.sequentialMatches > 2 || map.rsumBytes < 1 || map.rsumBytes > 4 ||
+        map.checksumBytes < 3 || map.checksumBytes > 16) {
+        qWarning() << "DeltaSync: Unsupported zsync control file";
+        return {};
+    }
+
+    ByteCount blocks = (map.length + map.blockSize - 1) / map.blockSize;
+    qsizetype recordSize = map.rsumBytes + map.checksumBytes;
+    if (data.size() - pos < blocks * recordSize) {
+        qWarning() << "DeltaSync: zsync control file is truncated";
+        return {};
+    }
+
+    map.rsums.reserve(static_cast<size_t>(blocks));
+    map.checksums.reserve(static_cast<qsizetype>(blocks * map.checksumBytes));
+    const auto* record = reinterpret_cast<const unsigned char*>(data.constData() + pos);
+    for (ByteCount i = 0; i < blocks; ++i, record += recordSize) {
+        // The last rsumBytes of the big-endian (a, b) pair
+        uint32_t rsum = 0;
+        for (int byte = 0; byte < map.rsumBytes; ++byte) {
+            rsum = (rsum << 8) | record[byte];
+        }
+        map.rsums.push_back(rsum);
+        map.checksums.append(reinterpret_cast<const char*>(record + map.rsumBytes), map.checksumBytes);
+    }
+    return map;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Matching
+// ═══════════════════════════════════════════════════════════════════════════════
+
+std::vector<BlockRun> DeltaSync::match(const BlockMap& map, const QString& seedPath,
+                                       const std::atomic<bool>& cancelled) {
+    const size_t blockSize = static_cast<size_t>(map.blockSize);
+    const size_t blocks = map.blockCount();
+    const size_t sequence = static_cast<size_t>(map.sequentialMatches);
+    const size_t span = blockSize * sequence;
+    const uint32_t mask = rsumMask(map.rsumBytes);
+    const ByteCount seedSize = QFileInfo(seedPath).size();
+
+    auto blockLength = [&](size_t block) {
+        return std::min<ByteCount>(map.blockSize, map.length - static_cast<ByteCount>(block) * map.blockSize);
+    };
+
+    // Blocks by rolling checksum, behind a bit filter
+    std::vector<std::pair<uint32_t, uint32_t>> index;
+    index.reserve(blocks);
+    std::vector<uint64_t> filter((size_t{1} << FILTER_BITS) / 64);
+    for (size_t i = 0; i < blocks; ++i) {
+        index.emplace_back(map.rsums[i], static_cast<uint32_t>(i));
+        uint32_t slot = filterSlot(map.rsums[i]);
+        filter[slot / 64] |= uint64_t{1} << (slot % 64);
+    }
+    std::sort(index.begin(), index.end());
+
+    std::vector<ByteOffset> found(blocks, -1);     // Seed offset of each target block
+    size_t missing = blocks;
+
+    auto strongMatches = [&](size_t block, const unsigned char* data) {
+        QByteArray digest = QCryptographicHash::hash(
+            QByteArrayView(reinterpret_cast<const char*>(data), static_cast<qsizetype>(blockSize)),
+            QCryptographicHash::Md4);
+        return std::memcmp(digest.constData(), map.checksums.constData() + block * map.checksumBytes,
+                           static_cast<size_t>(map.checksumBytes)) == 0;
+    };
+
+    // Seed bytes not yet slid past; window[0] is at seed offset base
+    std::vector<unsigned char> window;
+    size_t pos = 0;
+    ByteOffset base = 0;
+    Rsum first;
+    Rsum second;
+    bool primed = false;
+
+    auto claim = [&](size_t block, ByteOffset seedOffset) {
+        if (found[block] < 0 && seedOffset + blockLength(block) <= seedSize) {
+            found[block] = seedOffset;
+            --missing;
+        }
+    };
+
+    // @return True if the window at pos held at least one missing block
+    auto lookup = [&]() {
+        uint32_t key = first.value() & mask;
+        uint32_t slot = filterSlot(key);
+        if (!(filter[slot / 64] & (uint64_t{1} << (slot % 64)))) {
+            return false;
+        }
+
+        bool matched = false;
+        auto range = std::equal_range(index.begin(), index.end(), std::make_pair(key, uint32_t{0}),
+                                      [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        for (auto it = range.first; it != range.second; ++it) {
+            size_t block = it->second;
+            bool hasNext = sequence > 1 && block + 1 < blocks;
+            if (found[block] >= 0 && (!hasNext || found[block + 1] >= 0)) {
+                continue;  // Nothing left to gain here
+            }
+            if (hasNext && (second.value() & mask) != map.rsums[block + 1]) {
+                continue;
+            }
+            if (!strongMatches(block, window.data() + pos) ||
+                (hasNext && !strongMatches(block + 1, window.data() + pos + blockSize))) {
+                continue;
+            }
+
+            // Every block with this content is served by the same seed bytes
+            ByteOffset seedOffset = base + static_cast<ByteOffset>(pos);
+            claim(block, seedOffset);
+            if (hasNext) {
+                claim(block + 1, seedOffset + map.blockSize);
+            }
+            matched = true;
+        }
+        return matched;
+    };
+
+    auto scan = [&]() {
+        while (window.size() - pos >= span && missing > 0) {
+            if (!primed) {
+                first = Rsum::of(window.data() + pos, blockSize);
+                if (sequence > 1) {
+                    second = Rsum::of(window.data() + pos + blockSize, blockSize);
+                }
+                primed = true;
+            }
+
+            if (lookup()) {
+                // Matched bytes cannot start another match
+                pos += blockSize;
+                primed = false;
+                continue;
+            }
+
+            if (window.size() - pos <= span) {
+                break;  // The next byte is not read yet
+            }
+            first.roll(window[pos], window[pos + blockSize], blockSize);
+            if (sequence > 1) {
+                second.roll(window[pos + blockSize], window[pos + span], blockSize);
+            }
+            ++pos;
+        }
+
+        // Keep only what the next window still needs
+        if (pos > 0 && pos >= window.size() / 2) {
+            window.erase(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(pos));
+            base += static_cast<ByteOffset>(pos);
+            pos = 0;
+        }
+    };
+
+    FileIo::readSequential(seedPath, [&](const char* data, size_t size) {
+        window.insert(window.end(), reinterpret_cast<const unsigned char*>(data),
+                      reinterpret_cast<const unsigned char*>(data) + size);
+        scan();
+        return missing > 0 && !cancelled.load(std::memory_order_relaxed);
+    });
+
+    // The control file checksums a short last block padded with zeros
+    if (missing > 0 && !cancelled.load(std::memory_order_relaxed)) {
+        window.insert(window.end(), span, 0);
+        scan();
+    }
+
+    if (cancelled.load(std::memory_order_relaxed)) {
+        return {};
+    }
+
+    // Merge blocks that are adjacent in both files
+    std::vector<BlockRun> runs;
+    for (size_t block = 0; block < blocks; ++block) {
+        if (found[block] < 0) {
+            continue;
+        }
+        ByteOffset target = static_cast<ByteOffset>(block) * map.blockSize;
+        if (!runs.empty() && runs.back().targetOffset + runs.back().length == target &&
+            runs.back().seedOffset + runs.back().length == found[block]) {
+            runs.back().length += blockLength(block);
+        } else {
+            runs.push_back(BlockRun{target, found[block], blockLength(block)});
+        }
+    }
+    std::erase_if(runs, [](const BlockRun& run) { return run.length < Constants::DELTA_MIN_RUN; });
+
+    qDebug() << "DeltaSync: Found" << (blocks - missing) << "of" << blocks << "blocks in" << seedPath;
+    return runs;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Seeding
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool DeltaSync::copy(const std::vector<BlockRun>& runs, const QString& seedPath,
+                     const QString& partialPath, ByteCount length,
+                     const std::atomic<bool>& cancelled, QString* error) {
+    QFile seed(seedPath);
+    QFile partial(partialPath);
+    if (!seed.open(QIODevice::ReadOnly)) {
+        *error = QStringLiteral("Cannot read %1: %2").arg(seedPath, seed.errorString());
+        return false;
+    }
+    if (!partial.open(QIODevice::ReadWrite) || !partial.resize(length)) {
+        *error = QStringLiteral("Cannot write %1: %2").arg(partialPath, partial.errorString());
+        return false;
+    }
+
+    QByteArray buffer;
+    for (const BlockRun& run : runs) {
+        for (ByteCount done = 0; done < run.length; done += buffer.size()) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                *error = QStringLiteral("Cancelled");
+                return false;
+            }
+
+            qint64 chunk = std::min<qint64>(COPY_CHUNK, run.length - done);
+            if (!seed.seek(run.seedOffset + done)) {
+                *error = QStringLiteral("Cannot read %1: %2").arg(seedPath, seed.errorString());
+                return false;
+            }
+            buffer = seed.read(chunk);
+            if (buffer.size() != chunk) {
+                *error = QStringLiteral("Cannot read %1: %2").arg(seedPath, seed.errorString());
+                return false;
+            }
+            if (!partial.seek(run.targetOffset + done) || partial.write(buffer) != chunk) {
+                *error = QStringLiteral("Cannot write %1: %2").arg(partialPath, partial.errorString());
+                return false;
+            }
+        }
+    }
+
+    if (!partial.flush()) {
+        *error = QStringLiteral("Cannot write %1: %2").arg(partialPath, partial.errorString());
+        return false;
+    }
+    return true;
+}
+
+std::vector<Segment::Snapshot> DeltaSync::layout(const std::vector<BlockRun>& runs, ByteCount length) {
+    std::vector<Segment::Snapshot> snapshots;
+    SegmentId nextId = 0;
+
+    auto add = [&](ByteOffset start, ByteOffset end, bool reused) {
+        snapshots.push_back(Segment::Snapshot{
+            .id = nextId++,
+            .startByte = start,
+            .endByte = end - 1,
+            .currentByte = reused ? end : start,
+            .state = reused ? SegmentState::Completed : SegmentState::Pending,
+            .checksum = 0,
+            .tempFilePath = QString(),
+            .retryCount = 0,
+            .lastError = QString()
+        });
+    };
+
+    ByteOffset next = 0;
+    for (const BlockRun& run : runs) {
+        if (run.targetOffset > next) {
+            add(next, run.targetOffset, false);
+        }
+        add(run.targetOffset, run.targetOffset + run.length, true);
+        next = run.targetOffset + run.length;
+    }
+    if (next < length) {
+        add(next, length, false);
+    }
+    return snapshots;
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,295 @@
+/**
+ * @file DiskWriter.cpp
+ * @brief Implementation of DiskWriter - pooled write-behind buffers
+ */
+
+#include "openidm/engine/DiskWriter.h"
+#include "openidm/engine/EngineMetrics.h"
+#include "openidm/engine/OutputFile.h"
+#include "openidm/engine/ResumeJournal.h"
+#include "openidm/engine/Segment.h"
+#include "platform/FileIo.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+DiskWriter& DiskWriter::instance() {
+    static DiskWriter writer;
+    return writer;
+}
+
+DiskWriter::DiskWriter() {
+    m_thread = std::thread([this]() { run(); });
+}
+
+DiskWriter::~DiskWriter() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queueCondition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    for (auto& buffer : m_buffers) {
+        if (buffer.data) {
+            ::operator delete(buffer.data, std::align_val_t{Constants::DIRECT_IO_ALIGNMENT});
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Producer Side
+// ═══════════════════════════════════════════════════════════════════════════════
+
+WriteBuffer* DiskWriter::acquire(OutputFile* file, Segment* segment, ByteOffset offset, Charge charge) {
+    std::unique_lock lock(m_mutex);
+    if (charge == Charge::Force) {
+        MemoryBudget::instance().reserve(static_cast<ByteCount>(Constants::FILE_WRITE_BUFFER));
+        ++m_checkedOut;
+    } else if (charge == Charge::Wait) {
+        while (!grantLocked()) {
+            // Woken by any release, including receive buffers and fragments
+            lock.unlock();
+            MemoryBudget::instance().wait(static_cast<ByteCount>(Constants::FILE_WRITE_BUFFER),
+                                          Constants::PROGRESS_UPDATE_INTERVAL);
+            lock.lock();
+        }
+    }
+
+    WriteBuffer* buffer = nullptr;
+    if (!m_free.empty()) {
+        buffer = m_free.back();
+        m_free.pop_back();
+        if (buffer->data) {
+            --m_idle;
+        }
+    } else {
+        buffer = &m_buffers.emplace_back();
+    }
+    lock.unlock();
+
+    if (!buffer->data) {
+        buffer->data = static_cast<char*>(::operator new(
+            Constants::FILE_WRITE_BUFFER, std::align_val_t{Constants::DIRECT_IO_ALIGNMENT}));
+    }
+
+    size_t misalignment = static_cast<size_t>(offset) % Constants::DIRECT_IO_ALIGNMENT;
+    buffer->capacity = Constants::FILE_WRITE_BUFFER - misalignment;
+    buffer->length = 0;
+    buffer->offset = offset;
+    buffer->file = file;
+    buffer->segment = segment;
+    buffer->failed = false;
+    return buffer;
+}
+
+bool DiskWriter::admit(MemoryBudget::Waker waker) {
+    MemoryBudget& budget = MemoryBudget::instance();
+    auto bytes = static_cast<ByteCount>(Constants::FILE_WRITE_BUFFER);
+    while (true) {
+        {
+            // Reserved here, so nobody can take the room before acquire()
+            std::lock_guard lock(m_mutex);
+            if (grantLocked()) {
+                return true;
+            }
+        }
+        if (budget.park(bytes, waker)) {
+            return false;
+        }
+        // Room appeared since the attempt; try again
+    }
+}
+
+void DiskWriter::revoke() {
+    {
+        std::lock_guard lock(m_mutex);
+        --m_checkedOut;
+    }
+    MemoryBudget::instance().release(static_cast<ByteCount>(Constants::FILE_WRITE_BUFFER));
+    m_freeCondition.notify_all();
+}
+
+void DiskWriter::submit(WriteBuffer* buffer) {
+    if (!buffer) {
+        return;
+    }
+
+    std::unique_lock lock(m_mutex);
+    if (buffer->length == 0) {
+        recycle(buffer);
+        lock.unlock();
+        MemoryBudget::instance().release(static_cast<ByteCount>(Constants::FILE_WRITE_BUFFER));
+        m_freeCondition.notify_all();
+        return;
+    }
+
+    m_queue.push_back(buffer);
+    lock.unlock();
+    m_queueCondition.notify_one();
+}
+
+void DiskWriter::drain(const OutputFile* file) {
+    std::unique_lock lock(m_mutex);
+    m_freeCondition.wait(lock, [this, file]() {
+        bool queued = std::any_of(m_queue.begin(), m_queue.end(),
+                                  [file](const WriteBuffer* b) { return b->file == file; });
+        bool writing = std::find(m_inFlight.begin(), m_inFlight.end(), file) != m_inFlight.end();
+        return !queued && !writing;
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Writer Thread
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void DiskWriter::run() {
+    // Owned by this thread: FileIo instances are single-threaded
+    std::unique_ptr<FileIo> io = FileIo::create();
+
+    std::vector<WriteBuffer*> batch;
+    std::vector<FileIo::Completion> completions;
+    std::vector<std::pair<OutputFile*, ResumeJournal*>> checkpoints;
+
+    while (true) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_queueCondition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;  // Stopping and nothing left to write
+            }
+
+            // Take everything queued so far in one go
+            batch.assign(m_queue.begin(), m_queue.end());
+            m_queue.clear();
+            for (const WriteBuffer* buffer : batch) {
+                m_inFlight.push_back(buffer->file);
+            }
+        }
+
+        // One submission for the whole batch; the device sees all of it at
+        // once instead of one synchronous write after another
+        size_t next = 0;
+        while (next < batch.size() || io->pending() > 0) {
+            while (next < batch.size()) {
+                WriteBuffer* buffer = batch[next];
+                qintptr handle = buffer->file->writeHandle(buffer->offset, buffer->data, buffer->length);
+                if (!io->queueWrite(handle, buffer->offset, buffer->data, buffer->length, buffer)) {
+                    break;  // Queue full; reap some first
+                }
+                buffer->issued = std::chrono::steady_clock::now();
+                ++next;
+            }
+
+            io->submit();
+            completions.clear();
+            if (io->wait(completions, 1) == 0) {
+                // The backend could not issue its queue. Tearing it down
+                // drops whatever was never submitted; rewriting the batch
+                // is safe because positional writes are idempotent.
+                qWarning() << "DiskWriter:" << io->name() << "stalled, falling back to synchronous writes";
+                io = FileIo::createSynchronous();
+                for (WriteBuffer* buffer : batch) {
+                    buffer->failed = !buffer->file->writeAt(buffer->offset, buffer->data,
+                                                            buffer->length);
+                }
+                break;
+            }
+
+            auto completed = std::chrono::steady_clock::now();
+            for (const auto& completion : completions) {
+                auto* buffer = static_cast<WriteBuffer*>(completion.tag);
+                EngineMetrics::instance().observeDiskWrite(
+                    std::chrono::duration_cast<std::chrono::microseconds>(completed - buffer->issued),
+                    static_cast<ByteCount>(buffer->length));
+                buffer->failed = !buffer->file->completeWrite(buffer->offset, buffer->data,
+                                                              buffer->length, completion.result);
+                if (buffer->failed) {
+                    qWarning() << "DiskWriter: Write-behind failed at offset" << buffer->offset;
+                }
+            }
+        }
+
+        // Completions arrive in any order; account in FIFO order so a
+        // segment's durable byte never jumps over a still-running write.
+        // Bytes that failed stay pending: they are not in the file.
+        checkpoints.clear();
+        for (WriteBuffer* buffer : batch) {
+            if (buffer->segment && !buffer->failed) {
+                ResumeJournal* journal = buffer->file->journal();
+                if (journal && !buffer->file->hasFailed()) {
+                    journal->recordWrite(*buffer->segment, buffer->offset, buffer->data, buffer->length);
+                    if (journal->takeCheckpointRequest()) {
+                        checkpoints.emplace_back(buffer->file, journal);
+                    }
+                }
+                buffer->segment->completePendingWrite(static_cast<ByteCount>(buffer->length));
+            }
+        }
+
+        // Files are still in m_inFlight, so drain() keeps their owners waiting
+        for (auto [file, journal] : checkpoints) {
+            journal->checkpoint(*file);
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            for (WriteBuffer* buffer : batch) {
+                recycle(buffer);
+            }
+            m_inFlight.clear();
+        }
+        MemoryBudget::instance().release(static_cast<ByteCount>(batch.size() * Constants::FILE_WRITE_BUFFER));
+        m_freeCondition.notify_all();
+        batch.clear();
+    }
+}
+
+void DiskWriter::recycle(WriteBuffer* buffer) {
+    // Note: Caller must hold m_mutex; the caller releases the budget after unlocking
+    buffer->length = 0;
+    buffer->file = nullptr;
+    buffer->segment = nullptr;
+    --m_checkedOut;
+
+    // Give memory back once the burst is over instead of holding the peak
+    // (empty shells go to the back of the line, acquire() takes from the top)
+    if (m_idle >= Constants::WRITE_BUFFER_COUNT) {
+        ::operator delete(buffer->data, std::align_val_t{Constants::DIRECT_IO_ALIGNMENT});
+        buffer->data = nullptr;
+        m_free.insert(m_free.begin(), buffer);
+        return;
+    }
+    ++m_idle;
+    m_free.push_back(buffer);
+}
+
+bool DiskWriter::grantLocked() {
+    // Note: Caller must hold m_mutex
+    MemoryBudget& budget = MemoryBudget::instance();
+    auto bytes = static_cast<ByteCount>(Constants::FILE_WRITE_BUFFER);
+
+    // One buffer is always granted: whoever holds it flushes it, and that
+    // release is what wakes everyone else
+    if (m_checkedOut == 0) {
+        budget.reserve(bytes);
+    } else if (!budget.tryReserve(bytes)) {
+        return false;
+    }
+    ++m_checkedOut;
+    return true;
+}
+
+} // namespace OpenIDM
@@ -5,14 +5,45 @@
 
 #include "openidm/engine/DownloadManager.h"
 #include "openidm/persistence/PersistenceManager.h"
+#include "openidm/engine/TransferEngine.h"
+#include "openidm/engine/WorkerPool.h"
+#include "openidm/engine/HostGovernor.h"
+#include "openidm/engine/MemoryBudget.h"
+#include "openidm/engine/HostCache.h"
+#include "openidm/engine/Metalink.h"
+#include "openidm/engine/LinkList.h"
+#include "openidm/engine/BandwidthLimiter.h"
+#include "openidm/engine/SpeedCalculator.h"
+#include "openidm/engine/EngineMetrics.h"
+#include "openidm/engine/MetricsServer.h"
+#include "openidm/engine/SegmentScheduler.h"
+#include "openidm/engine/StreamServer.h"
+#include "openidm/integration/YtDlpResolver.h"
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSet>
 #include <QStandardPaths>
+#include <QtConcurrent>
 #include <algorithm>
 
 namespace OpenIDM {
 
+namespace {
+
+/// What the importLinks() worker hands back to the manager's thread
+struct LinkImport {
+    QList<QUrl> urls;           ///< First occurrence of each link, in file order
+    qint64 found = 0;           ///< Links in the file, repeats included
+    qint64 lines = 0;
+};
+
+} // namespace
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Singleton Management
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -36,6 +67,12 @@ bool DownloadManager::initialize(QObject* parent) {
     
     s_instance = std::unique_ptr<DownloadManager>(new DownloadManager(parent));
     
+    // Event-driven transfer backend; tasks fall back to one thread per
+    // segment if it cannot be started
+    if (!TransferEngine::instance().start()) {
+        qWarning() << "DownloadManager: Transfer engine unavailable, using thread pool";
+    }
+    
     // Initialize persistence
     s_instance->m_persistence = std::make_unique<PersistenceManager>();
     if (!s_instance->m_persistence->initialize()) {
@@ -44,7 +81,12 @@ bool DownloadManager::initialize(QObject* parent) {
         return false;
     }
     
-    // Load saved state
+    // Hosts and resources probed, and media extracted, in earlier sessions
+    HostCache::instance().attach(s_instance->m_persistence.get());
+    YtDlpResolver::instance().attach(s_instance->m_persistence.get());
+    
+    // Load saved settings and state
+    s_instance->loadSettings();
     s_instance->loadState();
     
     s_initialized = true;
@@ -66,8 +108,11 @@ void DownloadManager::shutdown() {
     // Save state
     s_instance->saveState();
     
-    // Clean up
+    // Clean up (tasks detach their workers from the engine first)
+    HostCache::instance().attach(nullptr);
+    YtDlpResolver::instance().attach(nullptr);
     s_instance.reset();
+    TransferEngine::instance().stop();
     s_initialized = false;
     
     qDebug() << "DownloadManager: Shutdown complete";
@@ -75,8 +120,8 @@ void DownloadManager::shutdown() {
 
 DownloadManager::DownloadManager(QObject* parent)
     : QObject(parent)
+    , m_probes(new ProbePipeline(this))
     , m_speedTimer(new QTimer(this))
-    , m_queueTimer(new QTimer(this))
 {
     // Set default download directory
     m_defaultDir = QStandardPaths::writableLocation(QStandardPaths::DownloadLocation);
@@ -85,25 +130,46 @@ DownloadManager::DownloadManager(QObject* parent)
     }
     QDir().mkpath(m_defaultDir);
     
-    // Speed update timer
+    // Speed sampling for the UI; only runs while something is active.
+    // Queue admission has no timer: processQueue() runs on state changes.
     connect(m_speedTimer, &QTimer::timeout, this, &DownloadManager::onSpeedUpdateTimer);
-    m_speedTimer->setInterval(1000);  // 1 second
-    m_speedTimer->start();
-    
-    // Queue processing timer
-    connect(m_queueTimer, &QTimer::timeout, this, &DownloadManager::processQueue);
-    m_queueTimer->setInterval(500);  // 500ms
-    m_queueTimer->start();
+    m_speedTimer->setInterval(Constants::SPEED_SAMPLE_INTERVAL);
+    
+    connect(m_probes, &ProbePipeline::probed, this, &DownloadManager::onPrefetchProbed);
+    connect(m_probes, &ProbePipeline::probeFailed, this, &DownloadManager::onPrefetchFailed);
+    
+    // Per-task series for /metrics; rendered on the metrics thread, so
+    // only the registry's shared lock and the tasks' atomics are touched
+    EngineMetrics::instance().setTaskSource([this](const std::function<void(const TaskSample&)>& visit) {
+        m_registry.forEach([&visit](DownloadTask* task) {
+            TaskSample sample;
+            sample.id = task->id().toString(QUuid::WithoutBraces);
+            sample.state = task->state();
+            sample.downloaded = task->downloadedSize();
+            sample.total = task->totalSize();
+            sample.speed = task->speed();
+            sample.connections = task->activeSegments();
+            visit(sample);
+        });
+    });
 }
 
 DownloadManager::~DownloadManager() {
     // Stop timers
     m_speedTimer->stop();
-    m_queueTimer->stop();
+    
+    // An import still reading its file only touches its own copies
+    if (m_importCancel) {
+        m_importCancel->store(true);
+    }
+    
+    // No scrape may walk the registry past this point
+    m_metricsServer.reset();
+    m_streamServer.reset();
+    EngineMetrics::instance().setTaskSource({});
     
     // Clear tasks
-    std::lock_guard lock(m_tasksMutex);
-    m_tasks.clear();
+    m_registry.takeAll();
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -126,16 +192,14 @@ TaskId DownloadManager::addDownload(const QUrl& url, const QString& destPath, bo
     // Create task
     QString dest = destPath.isEmpty() ? m_defaultDir : destPath;
     auto task = std::make_unique<DownloadTask>(url, dest, this);
+    task->setTunables(m_tunables);
     TaskId id = task->id();
     
     // Connect task signals
     connectTask(task.get());
     
     // Store task
-    {
-        std::lock_guard lock(m_tasksMutex);
-        m_tasks[id] = std::move(task);
-    }
+    DownloadTask* added = m_registry.add(std::move(task));
     
     qDebug() << "DownloadManager: Added download" << id.toString() << "URL:" << url.toString();
     
@@ -146,38 +210,199 @@ TaskId DownloadManager::addDownload(const QUrl& url, const QString& destPath, bo
     
     // Save to persistence
     if (m_persistence) {
-        m_persistence->saveTask(m_tasks[id].get());
+        m_persistence->saveTask(added);
     }
     
     // Start if requested and we have capacity
     if (startImmediately && canStartMore()) {
-        m_tasks[id]->start();
+        added->start();
     }
     
     return id;
 }
 
+std::vector<TaskId> DownloadManager::addMetalink(const QByteArray& document, const QString& destDir) {
+    std::vector<TaskId> ids;
+    QString dest = destDir.isEmpty() ? m_defaultDir : destDir;
+    
+    for (MetalinkFile& file : parseMetalink(document)) {
+        QUrl primary = file.urls.takeFirst();
+        QString path = file.name.isEmpty() ? dest : dest + QDir::separator() + file.name;
+        if (!file.name.isEmpty()) {
+            QDir().mkpath(QFileInfo(path).path());
+        }
+        
+        TaskId id = addDownload(primary, path, false);
+        DownloadTask* t = task(id);
+        if (!t) {
+            continue;
+        }
+        
+        if (t->state() == DownloadState::Queued) {
+            t->setMirrors(file.urls);
+            if (file.hash.isValid()) {
+                t->setExpectedHash(file.hash);
+            }
+            if (m_persistence) {
+                m_persistence->saveTask(t);
+            }
+        }
+        ids.push_back(id);
+    }
+    
+    qDebug() << "DownloadManager: Added" << ids.size() << "downloads from Metalink";
+    
+    processQueue();
+    return ids;
+}
+
 QString DownloadManager::addDownloadUrl(const QString& url, const QString& destPath, bool startImmediately) {
     TaskId id = addDownload(QUrl(url), destPath, startImmediately);
     return id.isNull() ? QString{} : id.toString(QUuid::WithoutBraces);
 }
 
 std::vector<TaskId> DownloadManager::addDownloads(const QList<QUrl>& urls, const QString& destDir) {
+    return addBatch(urls, destDir, nullptr);
+}
+
+bool DownloadManager::importLinks(const QString& path, const QString& destDir) {
+    if (m_importCancel) {
+        qWarning() << "DownloadManager: An import is already running";
+        return false;
+    }
+    
+    QUrl location(path);
+    QString file = location.isLocalFile() ? location.toLocalFile() : path;
+    if (!QFileInfo(file).isReadable()) {
+        qWarning() << "DownloadManager: Cannot read link list" << file;
+        return false;
+    }
+    
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_importCancel = cancelled;
+    QString dest = destDir.isEmpty() ? m_defaultDir : destDir;
+    
+    auto* watcher = new QFutureWatcher<LinkImport>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, dest, file]() {
+        LinkImport result = watcher->result();
+        watcher->deleteLater();
+        m_importCancel.reset();
+        
+        size_t created = 0;
+        addBatch(result.urls, dest, &created);
+        
+        qDebug() << "DownloadManager: Imported" << created << "of" << result.found
+                 << "links in" << result.lines << "lines of" << file;
+        auto skipped = result.found - static_cast<qint64>(created);
+        emit importFinished(static_cast<int>(created), static_cast<int>(skipped));
+    });
+    
+    // Only the parse runs here; tasks are QObjects of this thread and are
+    // created in one batch once it is done
+    watcher->setFuture(QtConcurrent::run([file, cancelled]() {
+        LinkImport result;
+        QFile device(file);
+        if (!device.open(QIODevice::ReadOnly)) {
+            qWarning() << "DownloadManager: Failed to open link list" << file << device.errorString();
+            return result;
+        }
+        
+        QSet<QString> seen;
+        result.lines = readLinkList(device, [&result, &seen](const QUrl& url) {
+            ++result.found;
+            QString key = TaskRegistry::normalizeUrl(url);
+            if (!seen.contains(key)) {
+                seen.insert(key);
+                result.urls.append(url);
+            }
+        }, cancelled.get());
+        return result;
+    }));
+    
+    return true;
+}
+
+std::vector<TaskId> DownloadManager::addBatch(const QList<QUrl>& urls, const QString& destDir, size_t* created) {
     std::vector<TaskId> ids;
     ids.reserve(urls.size());
     
     QString dest = destDir.isEmpty() ? m_defaultDir : destDir;
     
+    // Create every task before any of them is announced or saved
+    std::vector<std::unique_ptr<DownloadTask>> tasks;
+    std::vector<DownloadTask*> added;
+    std::vector<TaskId> addedIds;
+    QHash<QString, TaskId> batch;
+    
     for (const QUrl& url : urls) {
-        TaskId id = addDownload(url, dest, false);
-        if (!id.isNull()) {
-            ids.push_back(id);
+        if (!url.isValid()) {
+            qWarning() << "DownloadManager: Invalid URL:" << url.toString();
+            continue;
+        }
+        
+        // Duplicates resolve to the download already registered or queued here
+        QString key = TaskRegistry::normalizeUrl(url);
+        if (auto existing = m_registry.findByUrl(url)) {
+            ids.push_back(*existing);
+            continue;
+        }
+        if (auto it = batch.constFind(key); it != batch.cend()) {
+            ids.push_back(it.value());
+            continue;
+        }
+        
+        auto task = std::make_unique<DownloadTask>(url, dest, this);
+        task->setTunables(m_tunables);
+        connectTask(task.get());
+        
+        TaskId id = task->id();
+        batch.insert(key, id);
+        ids.push_back(id);
+        addedIds.push_back(id);
+        added.push_back(task.get());
+        tasks.push_back(std::move(task));
+    }
+    
+    if (created) {
+        *created = added.size();
+    }
+    
+    if (!tasks.empty()) {
+        m_registry.add(std::move(tasks));
+        
+        qDebug() << "DownloadManager: Added" << added.size() << "downloads";
+        
+        updateCounts();
+        emit downloadsAdded(addedIds);
+        emit totalCountChanged();
+        emit queueCountChanged();
+        
+        if (m_persistence) {
+            m_persistence->saveTasks(added);
         }
     }
     
     // Start queued downloads
     processQueue();
     
+    // Probe the rest ahead of their turn, unless already known
+    std::vector<ProbePipeline::Request> prefetch;
+    for (const TaskId& id : addedIds) {
+        DownloadTask* task = m_registry.find(id);
+        if (!task || task->state() != DownloadState::Queued || task->totalSize() > 0) {
+            continue;
+        }
+        QUrl url(task->url());
+        if (!HostCache::instance().lookup(url)) {
+            prefetch.push_back({id, url});
+        }
+    }
+    
+    if (!prefetch.empty()) {
+        qDebug() << "DownloadManager: Probing" << prefetch.size() << "queued downloads";
+        m_probes->enqueue(std::move(prefetch));
+    }
+    
     return ids;
 }
 
@@ -186,16 +411,31 @@ void DownloadManager::removeDownload(const QString& id, bool deleteFile) {
 }
 
 void DownloadManager::removeDownload(const TaskId& id, bool deleteFile) {
-    std::unique_ptr<DownloadTask> task;
+    std::unique_ptr<DownloadTask> task = m_registry.take(id);
+    std::optional<TaskData> record;
     
-    {
-        std::lock_guard lock(m_tasksMutex);
-        auto it = m_tasks.find(id);
-        if (it == m_tasks.end()) {
+    if (!task) {
+        record = m_registry.takeArchived(id);
+        if (!record) {
             return;
         }
-        task = std::move(it->second);
-        m_tasks.erase(it);
+    }
+    
+    if (record) {
+        if (deleteFile && !record->filePath.isEmpty()) {
+            QFile::remove(record->filePath);
+        }
+        if (m_persistence) {
+            m_persistence->deleteTask(id);
+        }
+        
+        qDebug() << "DownloadManager: Removed archived download" << id.toString();
+        
+        updateCounts();
+        emit downloadRemoved(id);
+        emit totalCountChanged();
+        emit completedCountChanged();
+        return;
     }
     
     // Cancel if active
@@ -218,18 +458,18 @@ void DownloadManager::removeDownload(const TaskId& id, bool deleteFile) {
     qDebug() << "DownloadManager: Removed download" << id.toString();
     
     updateCounts();
+    updateSpeedTimer();
     emit downloadRemoved(id);
     emit totalCountChanged();
+    
+    // A removed active download frees a slot
+    processQueue();
 }
 
 void DownloadManager::removeAllDownloads(bool deleteFiles) {
-    std::vector<TaskId> ids;
-    
-    {
-        std::lock_guard lock(m_tasksMutex);
-        for (const auto& [id, task] : m_tasks) {
-            ids.push_back(id);
-        }
+    std::vector<TaskId> ids = m_registry.archivedIds();
+    for (DownloadTask* task : m_registry.all()) {
+        ids.push_back(task->id());
     }
     
     for (const TaskId& id : ids) {
@@ -239,14 +479,22 @@ void DownloadManager::removeAllDownloads(bool deleteFiles) {
 
 void DownloadManager::clearCompleted() {
     std::vector<TaskId> completedIds;
+    for (DownloadTask* task : m_registry.inState(DownloadState::Completed)) {
+        completedIds.push_back(task->id());
+    }
+    std::map<TaskId, TaskData> archive = m_registry.takeArchive();
     
-    {
-        std::lock_guard lock(m_tasksMutex);
-        for (const auto& [id, task] : m_tasks) {
-            if (task->state() == DownloadState::Completed) {
-                completedIds.push_back(id);
+    // The archive can hold tens of thousands of rows: one signal, not one per row
+    if (!archive.empty()) {
+        if (m_persistence) {
+            for (const auto& [id, record] : archive) {
+                m_persistence->deleteTask(id);
             }
         }
+        updateCounts();
+        emit archiveCleared();
+        emit totalCountChanged();
+        emit completedCountChanged();
     }
     
     for (const TaskId& id : completedIds) {
@@ -259,9 +507,7 @@ void DownloadManager::clearCompleted() {
 // ═══════════════════════════════════════════════════════════════════════════════
 
 DownloadTask* DownloadManager::task(const TaskId& id) const {
-    std::lock_guard lock(m_tasksMutex);
-    auto it = m_tasks.find(id);
-    return it != m_tasks.end() ? it->second.get() : nullptr;
+    return m_registry.find(id);
 }
 
 DownloadTask* DownloadManager::taskById(const QString& id) const {
@@ -269,42 +515,23 @@ DownloadTask* DownloadManager::taskById(const QString& id) const {
 }
 
 std::vector<DownloadTask*> DownloadManager::allTasks() const {
-    std::lock_guard lock(m_tasksMutex);
-    
-    std::vector<DownloadTask*> result;
-    result.reserve(m_tasks.size());
-    
-    for (const auto& [id, task] : m_tasks) {
-        result.push_back(task.get());
-    }
-    
-    return result;
+    return m_registry.all();
+}
+
+std::optional<TaskData> DownloadManager::archivedDownload(const TaskId& id) const {
+    return m_registry.findArchived(id);
+}
+
+std::vector<TaskId> DownloadManager::archivedDownloads() const {
+    return m_registry.archivedIds();
 }
 
 std::vector<DownloadTask*> DownloadManager::tasksInState(DownloadState state) const {
-    std::lock_guard lock(m_tasksMutex);
-    
-    std::vector<DownloadTask*> result;
-    
-    for (const auto& [id, task] : m_tasks) {
-        if (task->state() == state) {
-            result.push_back(task.get());
-        }
-    }
-    
-    return result;
+    return m_registry.inState(state);
 }
 
 std::optional<TaskId> DownloadManager::findByUrl(const QUrl& url) const {
-    std::lock_guard lock(m_tasksMutex);
-    
-    for (const auto& [id, task] : m_tasks) {
-        if (task->urlObject() == url) {
-            return id;
-        }
-    }
-    
-    return std::nullopt;
+    return m_registry.findByUrl(url);
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -369,6 +596,97 @@ void DownloadManager::retryDownload(const TaskId& id) {
     }
 }
 
+bool DownloadManager::setExpectedHash(const QString& id, const QString& hash) {
+    DownloadTask* t = task(QUuid::fromString(id));
+    ExpectedHash expected = ExpectedHash::fromString(hash);
+    if (!t || !expected.isValid()) {
+        qWarning() << "DownloadManager: Cannot set expected hash for" << id;
+        return false;
+    }
+    
+    t->setExpectedHash(expected);
+    if (m_persistence) {
+        m_persistence->saveTask(t);
+    }
+    return true;
+}
+
+bool DownloadManager::setMirrors(const QString& id, const QStringList& urls) {
+    DownloadTask* t = task(QUuid::fromString(id));
+    if (!t || t->state() != DownloadState::Queued) {
+        qWarning() << "DownloadManager: Cannot set mirrors for" << id;
+        return false;
+    }
+    
+    QList<QUrl> mirrors;
+    for (const QString& url : urls) {
+        mirrors.push_back(QUrl(url));
+    }
+    
+    t->setMirrors(mirrors);
+    if (m_persistence) {
+        m_persistence->saveTask(t);
+    }
+    return true;
+}
+
+bool DownloadManager::setExtractTo(const QString& id, const QString& directory) {
+    DownloadTask* t = task(QUuid::fromString(id));
+    if (!t || t->state() != DownloadState::Queued || directory.isEmpty()) {
+        qWarning() << "DownloadManager: Cannot extract" << id << "into" << directory;
+        return false;
+    }
+    
+    t->setExtractTo(directory);
+    return true;
+}
+
+bool DownloadManager::setDeltaSource(const QString& id, const QString& previousFile, const QString& controlUrl) {
+    DownloadTask* t = task(QUuid::fromString(id));
+    if (!t || t->state() != DownloadState::Queued || previousFile.isEmpty()) {
+        qWarning() << "DownloadManager: Cannot reuse" << previousFile << "for" << id;
+        return false;
+    }
+    
+    t->setDeltaSource(previousFile, controlUrl.isEmpty() ? QUrl() : QUrl::fromUserInput(controlUrl));
+    return true;
+}
+
+bool DownloadManager::setPriority(const QString& id, int priority) {
+    DownloadTask* t = task(QUuid::fromString(id));
+    if (!t || priority < static_cast<int>(Priority::Low) || priority > static_cast<int>(Priority::Urgent)) {
+        qWarning() << "DownloadManager: Cannot set priority" << priority << "for" << id;
+        return false;
+    }
+    
+    t->setPriority(static_cast<Priority>(priority));
+    WorkerPool::instance().reprioritize();
+    processQueue();
+    return true;
+}
+
+QString DownloadManager::streamUrl(const QString& id) {
+    TaskId taskId = QUuid::fromString(id);
+    DownloadTask* t = task(taskId);
+    if (!t && !archivedDownload(taskId)) {
+        qWarning() << "DownloadManager: Cannot stream unknown download" << id;
+        return {};
+    }
+    
+    if (!m_streamServer) {
+        m_streamServer = std::make_unique<StreamServer>(*this);
+        if (!m_streamServer->start()) {
+            m_streamServer.reset();
+            return {};
+        }
+    }
+    
+    if (t && t->scheduler()) {
+        t->scheduler()->setSequential(true);
+    }
+    return m_streamServer->urlFor(taskId).toString();
+}
+
 void DownloadManager::pauseAll() {
     auto tasks = tasksInState(DownloadState::Downloading);
     for (DownloadTask* t : tasks) {
@@ -411,8 +729,7 @@ int DownloadManager::completedDownloadCount() const {
 }
 
 int DownloadManager::totalDownloadCount() const {
-    std::lock_guard lock(m_tasksMutex);
-    return static_cast<int>(m_tasks.size());
+    return m_registry.size();
 }
 
 SpeedBps DownloadManager::globalSpeed() const {
@@ -427,19 +744,81 @@ ByteCount DownloadManager::sessionBytesDownloaded() const {
     return m_sessionBytes.load(std::memory_order_relaxed);
 }
 
+ByteCount DownloadManager::bufferedBytes() const {
+    return MemoryBudget::instance().used();
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Settings
 // ═══════════════════════════════════════════════════════════════════════════════
 
-void DownloadManager::setMaxConcurrentDownloads(int count) {
-    count = std::clamp(count, 1, 16);
-    if (m_maxConcurrent != count) {
-        m_maxConcurrent = count;
-        emit settingsChanged();
+void DownloadManager::setTunables(const EngineTunables& tunables) {
+    EngineTunables next = tunables;
+    next.maxConcurrentDownloads = std::clamp(next.maxConcurrentDownloads, 1, 16);
+    next.maxSegmentsPerDownload = std::clamp(next.maxSegmentsPerDownload, 1,
+                                             static_cast<int>(Constants::MAX_SEGMENTS));
+    next.maxTotalConnections = std::clamp(next.maxTotalConnections, 1,
+                                          static_cast<int>(Constants::MAX_TOTAL_CONNECTIONS));
+    next.maxConnectionsPerHost = std::clamp(next.maxConnectionsPerHost, 1,
+                                            static_cast<int>(Constants::MAX_HOST_CONNECTIONS));
+    next.memoryBudgetMB = std::clamp(next.memoryBudgetMB, static_cast<int>(Constants::MIN_MEMORY_BUDGET_MB),
+                                     static_cast<int>(Constants::MAX_MEMORY_BUDGET_MB));
+    next.speedLimit = std::max(0.0, next.speedLimit);
+    for (QString& name : next.networkInterfaces) {
+        name = name.trimmed();
+    }
+    next.networkInterfaces.removeAll(QString());
+    next.networkInterfaces.removeDuplicates();
+    next.metricsPort = std::clamp(next.metricsPort, 0, 65535);
+    
+    if (next == m_tunables) {
+        return;
+    }
+    
+    if (next.metricsPort != m_tunables.metricsPort || next.metricsPublic != m_tunables.metricsPublic) {
+        if (next.metricsPort == 0) {
+            m_metricsServer.reset();
+        } else {
+            if (!m_metricsServer) {
+                m_metricsServer = std::make_unique<MetricsServer>();
+            }
+            if (!m_metricsServer->start(static_cast<quint16>(next.metricsPort), next.metricsPublic)) {
+                m_metricsServer.reset();
+            }
+        }
+    }
+    
+    bool capacityChanged = next.maxConcurrentDownloads != m_tunables.maxConcurrentDownloads;
+    if (next.speedLimit != m_tunables.speedLimit) {
+        BandwidthLimiter::instance().setGlobalLimit(next.speedLimit);
+    }
+    if (next.maxTotalConnections != m_tunables.maxTotalConnections) {
+        WorkerPool::instance().setCapacity(static_cast<size_t>(next.maxTotalConnections));
+    }
+    if (next.maxConnectionsPerHost != m_tunables.maxConnectionsPerHost) {
+        HostGovernor::instance().setLimit(static_cast<size_t>(next.maxConnectionsPerHost));
+    }
+    if (next.memoryBudgetMB != m_tunables.memoryBudgetMB) {
+        MemoryBudget::instance().setLimit(static_cast<ByteCount>(next.memoryBudgetMB) * 1024 * 1024);
+    }
+    
+    m_tunables = next;
+    m_registry.forEach([&next](DownloadTask* task) {
+        task->setTunables(next);
+    });
+    emit settingsChanged();
+    
+    if (capacityChanged) {
         processQueue();
     }
 }
 
+void DownloadManager::setMaxConcurrentDownloads(int count) {
+    EngineTunables next = m_tunables;
+    next.maxConcurrentDownloads = count;
+    setTunables(next);
+}
+
 void DownloadManager::setDefaultDownloadDirectory(const QString& path) {
     if (m_defaultDir != path) {
         m_defaultDir = path;
@@ -449,18 +828,21 @@ void DownloadManager::setDefaultDownloadDirectory(const QString& path) {
 }
 
 void DownloadManager::setMaxSegmentsPerDownload(int count) {
-    count = std::clamp(count, 1, static_cast<int>(Constants::MAX_SEGMENTS));
-    if (m_maxSegments != count) {
-        m_maxSegments = count;
-        emit settingsChanged();
-    }
+    EngineTunables next = m_tunables;
+    next.maxSegmentsPerDownload = count;
+    setTunables(next);
+}
+
+void DownloadManager::setVerifySidecars(bool enabled) {
+    EngineTunables next = m_tunables;
+    next.verifySidecars = enabled;
+    setTunables(next);
 }
 
 void DownloadManager::setSpeedLimit(SpeedBps limit) {
-    if (m_speedLimit != limit) {
-        m_speedLimit = limit;
-        emit settingsChanged();
-    }
+    EngineTunables next = m_tunables;
+    next.speedLimit = limit;
+    setTunables(next);
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -472,14 +854,78 @@ void DownloadManager::saveState() {
     
     qDebug() << "DownloadManager: Saving state...";
     
-    std::lock_guard lock(m_tasksMutex);
-    for (const auto& [id, task] : m_tasks) {
-        m_persistence->saveTask(task.get());
-    }
+    m_registry.forEach([this](DownloadTask* task) {
+        m_persistence->saveTask(task);
+    });
     
+    saveSettings();
     m_persistence->checkpoint();
 }
 
+void DownloadManager::saveSettings() {
+    if (!m_persistence) return;
+    
+    m_persistence->saveSetting(QStringLiteral("maxConcurrentDownloads"),
+                               QString::number(m_tunables.maxConcurrentDownloads));
+    m_persistence->saveSetting(QStringLiteral("maxSegmentsPerDownload"),
+                               QString::number(m_tunables.maxSegmentsPerDownload));
+    m_persistence->saveSetting(QStringLiteral("maxTotalConnections"),
+                               QString::number(m_tunables.maxTotalConnections));
+    m_persistence->saveSetting(QStringLiteral("maxConnectionsPerHost"),
+                               QString::number(m_tunables.maxConnectionsPerHost));
+    m_persistence->saveSetting(QStringLiteral("memoryBudgetMB"), QString::number(m_tunables.memoryBudgetMB));
+    m_persistence->saveSetting(QStringLiteral("fastStart"),
+                               m_tunables.fastStart ? QStringLiteral("1") : QStringLiteral("0"));
+    m_persistence->saveSetting(QStringLiteral("networkInterfaces"),
+                               m_tunables.networkInterfaces.join(QLatin1Char(',')));
+    m_persistence->saveSetting(QStringLiteral("speedLimit"),
+                               QString::number(m_tunables.speedLimit, 'f', 0));
+    m_persistence->saveSetting(QStringLiteral("verifySidecars"),
+                               m_tunables.verifySidecars ? QStringLiteral("1") : QStringLiteral("0"));
+    m_persistence->saveSetting(QStringLiteral("metricsPort"), QString::number(m_tunables.metricsPort));
+    m_persistence->saveSetting(QStringLiteral("metricsPublic"),
+                               m_tunables.metricsPublic ? QStringLiteral("1") : QStringLiteral("0"));
+    m_persistence->saveSetting(QStringLiteral("defaultDownloadDirectory"), m_defaultDir);
+}
+
+void DownloadManager::loadSettings() {
+    if (!m_persistence) return;
+    
+    EngineTunables next = m_tunables;
+    next.maxConcurrentDownloads = m_persistence->loadSetting(
+        QStringLiteral("maxConcurrentDownloads"), QString::number(next.maxConcurrentDownloads)).toInt();
+    next.maxSegmentsPerDownload = m_persistence->loadSetting(
+        QStringLiteral("maxSegmentsPerDownload"), QString::number(next.maxSegmentsPerDownload)).toInt();
+    next.maxTotalConnections = m_persistence->loadSetting(
+        QStringLiteral("maxTotalConnections"), QString::number(next.maxTotalConnections)).toInt();
+    next.maxConnectionsPerHost = m_persistence->loadSetting(
+        QStringLiteral("maxConnectionsPerHost"), QString::number(next.maxConnectionsPerHost)).toInt();
+    next.memoryBudgetMB = m_persistence->loadSetting(
+        QStringLiteral("memoryBudgetMB"), QString::number(next.memoryBudgetMB)).toInt();
+    next.fastStart = m_persistence->loadSetting(
+        QStringLiteral("fastStart"), next.fastStart ? QStringLiteral("1") : QStringLiteral("0"))
+        == QStringLiteral("1");
+    next.networkInterfaces = m_persistence->loadSetting(
+        QStringLiteral("networkInterfaces"), next.networkInterfaces.join(QLatin1Char(',')))
+        .split(QLatin1Char(','), Qt::SkipEmptyParts);
+    next.speedLimit = m_persistence->loadSetting(
+        QStringLiteral("speedLimit"), QString::number(next.speedLimit, 'f', 0)).toDouble();
+    next.verifySidecars = m_persistence->loadSetting(
+        QStringLiteral("verifySidecars"), next.verifySidecars ? QStringLiteral("1") : QStringLiteral("0"))
+        == QStringLiteral("1");
+    next.metricsPort = m_persistence->loadSetting(
+        QStringLiteral("metricsPort"), QString::number(next.metricsPort)).toInt();
+    next.metricsPublic = m_persistence->loadSetting(
+        QStringLiteral("metricsPublic"), next.metricsPublic ? QStringLiteral("1") : QStringLiteral("0"))
+        == QStringLiteral("1");
+    setTunables(next);
+    
+    QString dir = m_persistence->loadSetting(QStringLiteral("defaultDownloadDirectory"));
+    if (!dir.isEmpty()) {
+        setDefaultDownloadDirectory(dir);
+    }
+}
+
 void DownloadManager::loadState() {
     if (!m_persistence) return;
     
@@ -488,7 +934,16 @@ void DownloadManager::loadState() {
     // Load tasks from database
     auto savedTasks = m_persistence->loadAllTasks();
     
+    std::vector<std::unique_ptr<DownloadTask>> tasks;
+    std::vector<TaskData> archive;
+    
     for (auto& taskData : savedTasks) {
+        // Finished downloads need no scheduler, timers or signals
+        if (taskData.state == DownloadState::Completed) {
+            archive.push_back(std::move(taskData));
+            continue;
+        }
+        
         auto task = std::make_unique<DownloadTask>(
             taskData.id,
             QUrl(taskData.url),
@@ -498,16 +953,30 @@ void DownloadManager::loadState() {
         
         // Restore task state
         // (In a full implementation, this would restore all task properties)
+        task->setExpectedHash(ExpectedHash::fromString(taskData.expectedHash));
+        task->setPriority(taskData.priority);
+        if (!taskData.mirrors.isEmpty()) {
+            task->setMirrors(QUrl::fromStringList(taskData.mirrors));
+        }
+        task->setTunables(m_tunables);
         
-        connectTask(task.get());
+        // Coarse layout; the resume journal refines it on the next start
+        task->setSavedSegments(m_persistence->loadSegments(taskData.id));
         
-        std::lock_guard lock(m_tasksMutex);
-        m_tasks[taskData.id] = std::move(task);
+        connectTask(task.get());
+        tasks.push_back(std::move(task));
     }
     
+    m_registry.add(std::move(tasks));
+    m_registry.addArchived(std::move(archive));
+    
     updateCounts();
     
-    qDebug() << "DownloadManager: Loaded" << m_tasks.size() << "tasks";
+    qDebug() << "DownloadManager: Loaded" << m_registry.taskCount() << "tasks and"
+             << m_registry.archivedCount() << "archived downloads";
+    
+    // Start restored queued downloads once the event loop runs
+    QMetaObject::invokeMethod(this, &DownloadManager::processQueue, Qt::QueuedConnection);
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -515,14 +984,23 @@ void DownloadManager::loadState() {
 // ═══════════════════════════════════════════════════════════════════════════════
 
 void DownloadManager::onTaskStateChanged(DownloadState newState) {
-    updateCounts();
-    
     auto* task = qobject_cast<DownloadTask*>(sender());
     if (!task) return;
     
-    TaskId id = task->id();
+    m_registry.updateState(task);
+    updateCounts();
+    updateSpeedTimer();
+    
+    // A task that started probes for itself
+    if (newState != DownloadState::Queued) {
+        m_probes->cancel(task->id());
+    }
     
     switch (newState) {
+        case DownloadState::Queued:
+            // Retried or re-queued; may start right away
+            processQueue();
+            break;
         case DownloadState::Downloading:
             emit activeCountChanged();
             break;
@@ -546,6 +1024,7 @@ void DownloadManager::onTaskStateChanged(DownloadState newState) {
 
 void DownloadManager::onTaskCompleted() {
     auto* task = qobject_cast<DownloadTask*>(sender());
+    EngineMetrics::instance().addDownloadFinished(true);
     if (task) {
         emit downloadCompleted(task->id());
     }
@@ -553,6 +1032,7 @@ void DownloadManager::onTaskCompleted() {
 
 void DownloadManager::onTaskFailed(const DownloadError& error) {
     auto* task = qobject_cast<DownloadTask*>(sender());
+    EngineMetrics::instance().addDownloadFinished(false);
     if (task) {
         emit downloadFailed(task->id(), error.message);
     }
@@ -565,19 +1045,42 @@ void DownloadManager::onTaskNeedsPersistence() {
     }
 }
 
+void DownloadManager::onPrefetchProbed(const TaskId& id, const ServerCapabilities& caps) {
+    DownloadTask* task = m_registry.find(id);
+    if (!task || !task->applyPrefetchedCapabilities(caps)) {
+        return;
+    }
+    
+    // A known size may move the task ahead in the queue
+    processQueue();
+}
+
+void DownloadManager::onPrefetchFailed(const TaskId& id, const DownloadError& error) {
+    // The task probes again when it starts and reports the error then
+    qDebug() << "DownloadManager: Background probe failed for" << id.toString() << "-" << error.message;
+}
+
 void DownloadManager::onSpeedUpdateTimer() {
-    SpeedBps totalSpeed = 0.0;
+    // Pick up time-of-day speed schedule changes, then split the limit
+    BandwidthLimiter& limiter = BandwidthLimiter::instance();
+    limiter.applySchedule();
+    
+    std::vector<BandwidthLimiter::ShareClaim> claims;
+    m_registry.forEach([&claims](DownloadTask* task) {
+        if (task->state() == DownloadState::Downloading) {
+            claims.push_back({&task->bandwidth(), priorityWeight(task->priority()),
+                              task->priority() == Priority::Urgent, task->speedLimit(), task->speed()});
+        }
+    });
+    limiter.share(claims);
+    
+    // Running tasks publish their speed into the aggregate on every tick
+    SpeedBps totalSpeed = AggregateSpeedCalculator::instance().totalSpeed();
     ByteCount sessionBytes = 0;
     
-    {
-        std::lock_guard lock(m_tasksMutex);
-        for (const auto& [id, task] : m_tasks) {
-            if (task->isActive()) {
-                totalSpeed += task->speed();
-            }
-            sessionBytes += task->downloadedSize();
-        }
-    }
+    m_registry.forEach([&](DownloadTask* task) {
+        sessionBytes += task->downloadedSize();
+    });
     
     SpeedBps oldSpeed = m_globalSpeed.exchange(totalSpeed, std::memory_order_relaxed);
     m_sessionBytes.store(sessionBytes, std::memory_order_relaxed);
@@ -587,20 +1090,40 @@ void DownloadManager::onSpeedUpdateTimer() {
     }
 }
 
-void DownloadManager::processQueue() {
-    if (!canStartMore()) {
-        return;
+void DownloadManager::updateSpeedTimer() {
+    bool busy = m_activeCount.load(std::memory_order_relaxed) > 0;
+    if (busy && !m_speedTimer->isActive()) {
+        m_speedTimer->start();
+    } else if (!busy && m_speedTimer->isActive()) {
+        m_speedTimer->stop();
+        onSpeedUpdateTimer();  // Publish the final (zero) speed
     }
-    
+}
+
+void DownloadManager::processQueue() {
     auto queued = tasksInState(DownloadState::Queued);
     
-    // Sort by priority (higher priority first)
-    std::sort(queued.begin(), queued.end(), [](DownloadTask* a, DownloadTask* b) {
-        return a->priority() > b->priority();
+    // Sort by priority (higher priority first); within one, known sizes
+    // smallest first so short files do not wait behind large ones, then
+    // unknown sizes oldest first
+    std::stable_sort(queued.begin(), queued.end(), [](DownloadTask* a, DownloadTask* b) {
+        if (a->priority() != b->priority()) {
+            return a->priority() > b->priority();
+        }
+        bool aKnown = a->totalSize() > 0;
+        bool bKnown = b->totalSize() > 0;
+        if (aKnown != bKnown) {
+            return aKnown;
+        }
+        return aKnown && a->totalSize() < b->totalSize();
     });
     
+    // Starting a task can fail synchronously and re-enter processQueue()
+    // through onTaskStateChanged(), so skip tasks started in the meantime.
+    // Urgent tasks sort first and do not wait for a free place.
     for (DownloadTask* task : queued) {
-        if (!canStartMore()) break;
+        if (!canStartMore() && task->priority() != Priority::Urgent) break;
+        if (task->state() != DownloadState::Queued) continue;
         task->start();
     }
 }
@@ -625,29 +1148,13 @@ void DownloadManager::disconnectTask(DownloadTask* task) {
 }
 
 void DownloadManager::updateCounts() {
-    int active = 0, queued = 0, completed = 0;
-    
-    {
-        std::lock_guard lock(m_tasksMutex);
-        for (const auto& [id, task] : m_tasks) {
-            switch (task->state()) {
-                case DownloadState::Downloading:
-                case DownloadState::Probing:
-                case DownloadState::Merging:
-                case DownloadState::Verifying:
-                    ++active;
-                    break;
-                case DownloadState::Queued:
-                    ++queued;
-                    break;
-                case DownloadState::Completed:
-                    ++completed;
-                    break;
-                default:
-                    break;
-            }
-        }
-    }
+    // Per-state counts are maintained by the registry's lists
+    int active = m_registry.count(DownloadState::Downloading)
+               + m_registry.count(DownloadState::Probing)
+               + m_registry.count(DownloadState::Merging)
+               + m_registry.count(DownloadState::Verifying);
+    int queued = m_registry.count(DownloadState::Queued);
+    int completed = m_registry.count(DownloadState::Completed) + m_registry.archivedCount();
     
     m_activeCount.store(active, std::memory_order_relaxed);
     m_queuedCount.store(queued, std::memory_order_relaxed);
@@ -655,7 +1162,7 @@ void DownloadManager::updateCounts() {
 }
 
 bool DownloadManager::canStartMore() const {
-    return activeDownloadCount() < m_maxConcurrent;
+    return activeDownloadCount() < m_tunables.maxConcurrentDownloads;
 }
 
 void DownloadManager::startNextQueued() {
@@ -5,17 +5,118 @@
 
 #include "openidm/engine/DownloadTask.h"
 #include "openidm/engine/NetworkProbe.h"
+#include "openidm/engine/TransferEngine.h"
+#include "openidm/engine/WorkerPool.h"
+#include "openidm/engine/HostCache.h"
+#include "openidm/engine/DiskWriter.h"
+#include "openidm/engine/DeltaSync.h"
 #include "openidm/persistence/PersistenceManager.h"
+#include "engine/CurlWrapper.h"
 
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
-#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QSaveFile>
+#include <QtConcurrent>
 #include <algorithm>
+#include <array>
 #include <numeric>
+#include <utility>
 
 namespace OpenIDM {
 
+namespace {
+
+/// Largest sidecar accepted (they hold one line per file)
+constexpr qint64 MAX_SIDECAR_SIZE = 64 * 1024;
+
+/**
+ * @brief Outcome of matching a previous copy against the control file
+ */
+struct DeltaResult {
+    std::vector<Segment::Snapshot> layout;      ///< Empty = download everything
+    ByteCount reused{0};
+    QByteArray sha1;                            ///< From the control file
+    QString error;
+};
+
+/**
+ * @brief Outcome of the background hashing pass
+ */
+struct VerificationResult {
+    ExpectedHash expected;
+    QByteArray actual;
+    QString error;
+};
+
+/**
+ * @brief Fetch and parse `<url>.sha256` (blocking; runs on a pool thread)
+ */
+ExpectedHash fetchSidecar(const QUrl& url, const QString& fileName) {
+    QUrl sidecarUrl = url;
+    sidecarUrl.setPath(url.path() + QStringLiteral(".sha256"));
+
+    CurlEasyHandle handle;
+    handle.setUrl(sidecarUrl);
+    handle.setFollowRedirects(true);
+    handle.setConnectTimeout(15);
+
+    QByteArray content;
+    handle.setWriteCallback([&content](std::span<const char> data) {
+        content.append(data.data(), static_cast<qsizetype>(data.size()));
+        return content.size() <= MAX_SIDECAR_SIZE;
+    });
+
+    CurlResult result = handle.performGet();
+    if (!result.success() || result.httpCode != 200) {
+        qDebug() << "DownloadTask: No checksum sidecar at" << sidecarUrl.toString();
+        return ExpectedHash{};
+    }
+    return ExpectedHash::fromSidecar(content, fileName);
+}
+
+/**
+ * @brief Read a zsync control file from disk or a URL (blocking; pool thread)
+ * @return Empty if it cannot be had
+ */
+QByteArray fetchControlFile(const QUrl& url) {
+    if (url.isLocalFile()) {
+        QFile file(url.toLocalFile());
+        if (!file.open(QIODevice::ReadOnly) || file.size() > Constants::MAX_ZSYNC_CONTROL_SIZE) {
+            return {};
+        }
+        return file.readAll();
+    }
+
+    CurlEasyHandle handle;
+    handle.setUrl(url);
+    handle.setFollowRedirects(true);
+    handle.setConnectTimeout(15);
+
+    QByteArray content;
+    handle.setWriteCallback([&content](std::span<const char> data) {
+        content.append(data.data(), static_cast<qsizetype>(data.size()));
+        return content.size() <= Constants::MAX_ZSYNC_CONTROL_SIZE;
+    });
+
+    CurlResult result = handle.performGet();
+    if (!result.success() || result.httpCode != 200) {
+        return {};
+    }
+    return content;
+}
+
+QByteArray crc32cDigest(uint32_t crc) {
+    QByteArray digest(4, Qt::Uninitialized);
+    for (int i = 0; i < 4; ++i) {
+        digest[i] = static_cast<char>(crc >> (24 - 8 * i));
+    }
+    return digest;
+}
+
+} // namespace
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Construction
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -24,9 +125,10 @@ DownloadTask::DownloadTask(const QUrl& url, const QString& destPath, QObject* pa
     : QObject(parent)
     , m_id(QUuid::createUuid())
     , m_url(url)
+    , m_sources(url)
     , m_scheduler(std::make_unique<SegmentScheduler>(this, this))
-    , m_threadPool(QThreadPool::globalInstance())
     , m_progressTimer(new QTimer(this))
+    , m_tuneTimer(new QTimer(this))
 {
     // Extract filename from URL
     m_fileName = url.fileName();
@@ -63,6 +165,10 @@ DownloadTask::DownloadTask(const QUrl& url, const QString& destPath, QObject* pa
         std::chrono::duration_cast<std::chrono::milliseconds>(Constants::PROGRESS_UPDATE_INTERVAL).count()
     );
     
+    // Connection-count controller
+    connect(m_tuneTimer, &QTimer::timeout, this, &DownloadTask::onTuneTimer);
+    m_tuneTimer->setInterval(Constants::CONNECTION_TUNE_INTERVAL);
+    
     qDebug() << "DownloadTask: Created task" << m_id.toString() << "for" << m_url.toString();
 }
 
@@ -73,8 +179,17 @@ DownloadTask::DownloadTask(const TaskId& id, const QUrl& url, const QString& des
 }
 
 DownloadTask::~DownloadTask() {
+    if (m_deltaCancel) {
+        m_deltaCancel->store(true);
+    }
     stopWorkers();
-    cleanupTempFiles();
+    WorkerPool::instance().release(this);
+    AggregateSpeedCalculator::instance().releaseSlot(m_speedSlot);
+    
+    // Keep the partial file on disk so the download can be resumed
+    if (m_outputFile) {
+        m_outputFile->close();
+    }
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -95,12 +210,17 @@ double DownloadTask::progress() const {
         return 0.0;
     }
     
+    if (m_verifiedBytes && state() == DownloadState::Verifying) {
+        ByteCount verified = m_verifiedBytes->load(std::memory_order_relaxed);
+        return (static_cast<double>(std::min(verified, total)) / total) * 100.0;
+    }
+    
     ByteCount downloaded = downloadedSize();
     return (static_cast<double>(downloaded) / total) * 100.0;
 }
 
 SpeedBps DownloadTask::averageSpeed() const {
-    if (m_speedHistory.empty()) {
+    if (!m_speedMeter.hasSamples()) {
         return 0.0;
     }
     
@@ -115,16 +235,11 @@ SpeedBps DownloadTask::averageSpeed() const {
 }
 
 Duration DownloadTask::remainingTime() const {
-    SpeedBps currentSpeed = speed();
-    
-    if (currentSpeed <= 0 || totalSize() <= 0) {
+    if (totalSize() <= 0) {
         return Duration{-1};
     }
     
-    ByteCount remaining = totalSize() - downloadedSize();
-    double seconds = static_cast<double>(remaining) / currentSpeed;
-    
-    return Duration{static_cast<int64_t>(seconds * 1000)};
+    return m_speedMeter.eta(totalSize() - downloadedSize());
 }
 
 int DownloadTask::activeSegments() const {
@@ -136,7 +251,65 @@ int DownloadTask::totalSegments() const {
 }
 
 int DownloadTask::completedSegments() const {
-    return static_cast<int>(m_scheduler->segmentsInState(SegmentState::Completed).size());
+    return static_cast<int>(m_scheduler->countInState(SegmentState::Completed));
+}
+
+QByteArray DownloadTask::segmentMap(int cells) const {
+    ByteCount size = totalSize();
+    if (size <= 0 || cells <= 0) {
+        return QByteArray();
+    }
+    cells = static_cast<int>(std::min<ByteCount>(cells, size));
+    
+    // Reused across calls, so a progress tick copies the table without allocating
+    m_scheduler->copyTable(m_segmentTable);
+    
+    // Bytes of each state per cell; cell i starts at i * size / cells
+    auto cellOf = [&](ByteOffset byte) {
+        return std::min(cells - 1, static_cast<int>(static_cast<double>(byte) * cells / static_cast<double>(size)));
+    };
+    auto cellStart = [&](int cell) {
+        return static_cast<ByteOffset>(static_cast<double>(cell) * static_cast<double>(size) / cells);
+    };
+    std::vector<std::array<ByteCount, 3>> weights(static_cast<size_t>(cells));
+    auto add = [&](ByteOffset start, ByteOffset end, RangeState state) {
+        start = std::max<ByteOffset>(start, 0);
+        end = std::min<ByteOffset>(end, size - 1);
+        if (start > end) {
+            return;
+        }
+        for (int cell = cellOf(start), last = cellOf(end); cell <= last; ++cell) {
+            ByteOffset from = std::max(start, cellStart(cell));
+            ByteOffset to = cell == last ? end + 1 : cellStart(cell + 1);
+            weights[static_cast<size_t>(cell)][static_cast<size_t>(state)] += std::max<ByteCount>(0, to - from);
+        }
+    };
+    
+    // Bytes before a segment's frontier are received; the rest is in
+    // flight while a worker holds it and pending otherwise
+    const SegmentTable& table = m_segmentTable;
+    for (size_t i = 0; i < table.size(); ++i) {
+        ByteOffset start = table.starts[i];
+        ByteOffset end = table.ends[i];
+        if (end < start) {
+            continue;
+        }
+        if (table.states[i] == SegmentState::Completed) {
+            add(start, end, RangeState::Completed);
+            continue;
+        }
+        ByteOffset current = std::clamp(table.currents[i], start, end + 1);
+        add(start, current - 1, RangeState::Completed);
+        add(current, end, table.states[i] == SegmentState::Active ? RangeState::InFlight : RangeState::Pending);
+    }
+    
+    QByteArray result(cells, Qt::Uninitialized);
+    for (int i = 0; i < cells; ++i) {
+        const auto& weight = weights[static_cast<size_t>(i)];
+        auto state = std::max_element(weight.begin(), weight.end()) - weight.begin();
+        result[i] = static_cast<char>(state);
+    }
+    return result;
 }
 
 DownloadProgress DownloadTask::progressInfo() const {
@@ -160,10 +333,38 @@ DownloadProgress DownloadTask::progressInfo() const {
 void DownloadTask::setPriority(Priority priority) {
     if (m_priority != priority) {
         m_priority = priority;
+        markDirty(DirtyPriority);
         emit needsPersistence();
     }
 }
 
+void DownloadTask::setSpeedLimit(SpeedBps limit) {
+    m_speedLimit = limit;
+    m_bandwidth.setRate(limit);
+}
+
+void DownloadTask::setSegmentSpeedLimit(SpeedBps limit) {
+    m_segmentSpeedLimit = limit;
+    for (auto& worker : m_workers) {
+        worker->setSpeedLimit(limit);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Tracing
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool DownloadTask::exportTrace(const QString& path) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "DownloadTask: Cannot write trace" << path << file.errorString();
+        return false;
+    }
+    
+    file.write(m_trace.toChromeTrace(m_fileName));
+    return file.commit();
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Actions
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -182,16 +383,42 @@ void DownloadTask::start() {
     // Record start time
     m_startTime = std::chrono::system_clock::now();
     
+    // A recent probe of the same resource makes this one unnecessary
+    if (!m_capabilities.isValid()) {
+        if (auto cached = HostCache::instance().lookup(m_url)) {
+            qDebug() << "DownloadTask: Using cached capabilities for" << m_url.toString();
+            applyCapabilities(*cached);
+        }
+    }
+    
     // If we have server capabilities, skip probing
     if (m_capabilities.isValid()) {
-        initializeSegments();
-        startWorkers();
+        planSegments();
+    } else if (canFastStart()) {
+        // The first ranged GET tells us what a HEAD would have
+        fastStart();
     } else {
         // Probe server first
         probeServer();
     }
 }
 
+bool DownloadTask::applyPrefetchedCapabilities(const ServerCapabilities& caps) {
+    if (state() != DownloadState::Queued || m_capabilities.isValid() || !caps.isValid()) {
+        return false;  // Started meanwhile, or already known
+    }
+    
+    HostCache::instance().store(m_url, caps);
+    
+    // The resource may change before the task's turn comes
+    ServerCapabilities prefetched = caps;
+    prefetched.fromCache = true;
+    applyCapabilities(prefetched);
+    
+    emit needsPersistence();
+    return true;
+}
+
 void DownloadTask::pause() {
     if (state() != DownloadState::Downloading) {
         return;
@@ -209,6 +436,10 @@ void DownloadTask::pause() {
     m_scheduler->pauseAll();
     m_progressTimer->stop();
     
+    if (m_journal) {
+        m_journal->requestCheckpoint();
+    }
+    
     // Record elapsed time
     auto now = std::chrono::system_clock::now();
     m_elapsedTime += std::chrono::duration_cast<Duration>(now - m_startTime);
@@ -227,13 +458,14 @@ void DownloadTask::resume() {
     
     m_startTime = std::chrono::system_clock::now();
     
-    m_scheduler->resumeAll();
-    
-    // Resume workers
+    // Resume workers first: resumeAll() wakes the engine's idle workers,
+    // and the engine passes over any that are still paused
     for (auto& worker : m_workers) {
         worker->resume();
     }
     
+    m_scheduler->resumeAll();
+    
     m_progressTimer->start();
 }
 
@@ -248,9 +480,15 @@ void DownloadTask::cancel() {
     stopWorkers();
     m_scheduler->cancelAll();
     m_progressTimer->stop();
+    stopExtraction();
+    if (m_deltaCancel) {
+        m_deltaCancel->store(true);
+        m_deltaCancel.reset();
+    }
     
     cleanupTempFiles();
     
+    markDirty(DirtyError);
     emit errorChanged();
 }
 
@@ -263,9 +501,14 @@ void DownloadTask::retry() {
     
     // Reset error
     m_lastError = DownloadError{};
+    m_fileCrc32c.reset();
     
     // Reset scheduler
     m_scheduler->reset();
+    stopExtraction();
+    
+    // Segments restart from zero, so stale partial data must not survive
+    cleanupTempFiles();
     
     // Start fresh
     setState(DownloadState::Queued);
@@ -280,37 +523,105 @@ void DownloadTask::onProbeCompleted(const ServerCapabilities& caps) {
     qDebug() << "DownloadTask: Probe completed. Size:" << caps.contentLength
              << "Ranges:" << caps.supportsRanges;
     
-    m_capabilities = caps;
-    
-    // Update file info from server
-    if (!caps.fileName.isEmpty()) {
-        m_fileName = caps.fileName;
-        m_filePath = m_destDir + QDir::separator() + m_fileName;
-        emit fileNameChanged();
-        emit filePathChanged();
-    }
-    
-    if (caps.contentLength > 0) {
-        m_totalSize.store(caps.contentLength, std::memory_order_relaxed);
-        emit totalSizeChanged();
-    }
-    
-    initializeSegments();
-    startWorkers();
+    HostCache::instance().store(m_url, caps);
+    applyCapabilities(caps);
+    planSegments();
 }
 
 void DownloadTask::onProbeFailed(const DownloadError& error) {
     qWarning() << "DownloadTask: Probe failed:" << error.message;
     
+    // A fast-start probe is a worker of its own
+    stopWorkers();
+    
     setError(error);
     setState(DownloadState::Failed);
     emit failed(error);
 }
 
+void DownloadTask::onStreamProbed(const ServerCapabilities& caps) {
+    if (state() != DownloadState::Probing) {
+        return;  // Cancelled while the headers were in flight
+    }
+    
+    qDebug() << "DownloadTask: Stream probed. Size:" << caps.contentLength
+             << "Ranges:" << caps.supportsRanges;
+    
+    HostCache::instance().store(m_url, caps);
+    applyCapabilities(caps);
+    
+    // Segment 0 keeps streaming; the rest of the file is queued as ranges.
+    // Encoded bodies are not byte ranges of the file, so they stay whole.
+    if (caps.canSegment() && !caps.supportsCompression) {
+        size_t segmentCount = SegmentScheduler::calculateOptimalSegmentCount(caps.contentLength);
+        m_scheduler->resolveOpenSegment(caps.contentLength, segmentCount);
+    }
+    
+    if (!prepareOutputFile()) {
+        stopWorkers();
+        
+        DownloadError error;
+        error.category = ErrorCategory::FileSystem;
+        error.message = QStringLiteral("Failed to create output file");
+        error.details = m_outputFile->errorString();
+        setError(error);
+        setState(DownloadState::Failed);
+        emit failed(error);
+        return;
+    }
+    
+    setState(DownloadState::Downloading);
+    startExtraction();
+    
+    for (auto& worker : m_workers) {
+        worker->releaseProbe();
+    }
+    
+    rampUpWorkers();
+}
+
+void DownloadTask::onResourceChanged(int httpStatus) {
+    if (state() != DownloadState::Downloading) {
+        return;  // Another worker already reported it
+    }
+    
+    qWarning() << "DownloadTask: HTTP" << httpStatus << "- resource changed on the server";
+    
+    HostCache::instance().invalidate(m_url);
+    stopWorkers();
+    m_progressTimer->stop();
+    
+    if (!m_capabilities.fromCache) {
+        DownloadError error;
+        error.category = ErrorCategory::ClientError;
+        error.errorCode = httpStatus;
+        error.message = QStringLiteral("Resource changed on the server (HTTP %1)").arg(httpStatus);
+        setError(error);
+        setState(DownloadState::Failed);
+        emit failed(error);
+        return;
+    }
+    
+    // The cached answer was stale: discard what it produced and probe again
+    m_capabilities = ServerCapabilities{};
+    m_savedSegments.clear();
+    m_totalSize.store(-1, std::memory_order_relaxed);
+    markDirty(DirtyFileInfo);
+    emit totalSizeChanged();
+    
+    m_scheduler->reset();
+    stopExtraction();
+    cleanupTempFiles();
+    
+    setState(DownloadState::Queued);
+    start();
+}
+
 void DownloadTask::onSegmentCompleted(SegmentId id) {
     qDebug() << "DownloadTask: Segment" << id << "completed";
     
     updateStatistics();
+    markDirty(DirtyProgress | DirtySegments);
     emit progressChanged();
     emit needsPersistence();
 }
@@ -330,47 +641,86 @@ void DownloadTask::onSegmentFailed(SegmentId id, const QString& error) {
 }
 
 void DownloadTask::onAllSegmentsCompleted() {
-    qDebug() << "DownloadTask: All segments completed, starting merge";
+    qDebug() << "DownloadTask: All segments completed, finalizing output file";
     
     setState(DownloadState::Merging);
     m_progressTimer->stop();
     
-    // Merge segment files
-    if (!mergeSegments()) {
+    // The extractor must not hold the partial file while it is renamed
+    if (m_extractor) {
+        m_extractor->advance(QString(), m_extractFed, false);
+    }
+    
+    // Segments were written in place; the .part file is flushed and checked
+    // before finishVerification() renames it
+    if (!sealOutputFile()) {
+        stopExtraction();
         DownloadError error;
         error.category = ErrorCategory::FileSystem;
-        error.message = QStringLiteral("Failed to merge segment files");
+        error.message = QStringLiteral("Failed to write output file");
+        error.details = m_outputFile ? m_outputFile->errorString() : QString();
         setError(error);
         setState(DownloadState::Failed);
         emit failed(error);
         return;
     }
     
-    // Verify file (optional)
-    setState(DownloadState::Verifying);
-    if (!verifyFile()) {
-        qWarning() << "DownloadTask: File verification failed (non-fatal)";
+    // Nothing left to resume: the journal has served its purpose
+    if (m_journal) {
+        m_outputFile->setJournal(nullptr);
+        m_journal->discard();
+        m_journal.reset();
     }
     
-    // Cleanup temp files
-    cleanupTempFiles();
+    // The whole-file CRC falls out of the segment CRCs at no cost
+    m_fileCrc32c = combineSegmentChecksums();
     
-    // Record completion
-    m_endTime = std::chrono::system_clock::now();
-    setState(DownloadState::Completed);
-    
-    emit completed();
-    emit needsPersistence();
+    // Verify file; completes (or fails) the task when done
+    setState(DownloadState::Verifying);
+    verifyFile();
 }
 
 void DownloadTask::onProgressTimer() {
+    // Nothing is transferred while hashing; only the verify pass moves
+    if (state() == DownloadState::Verifying) {
+        markDirty(DirtyProgress);
+        emit progressChanged();
+        return;
+    }
+    
     updateStatistics();
+    feedExtractor();
+    
+    // Only flag what moved since the last tick, so views skip quiet rows
+    ByteCount downloaded = downloadedSize();
+    SpeedBps currentSpeed = speed();
+    int segments = activeSegments();
+    uint32_t dirty = 0;
+    if (downloaded != m_reportedBytes) {
+        m_reportedBytes = downloaded;
+        dirty |= DirtyProgress;
+    }
+    if (currentSpeed != m_reportedSpeed) {
+        m_reportedSpeed = currentSpeed;
+        dirty |= DirtySpeed;
+    }
+    if (segments != m_reportedSegments) {
+        m_reportedSegments = segments;
+        dirty |= DirtySegments;
+    }
+    markDirty(dirty);
+    
     emit progressChanged();
     emit speedChanged();
     
-    // Check if persistence needed
-    ByteCount downloaded = downloadedSize();
-    if (downloaded - m_lastPersistedBytes >= Constants::PERSISTENCE_CHECKPOINT_BYTES) {
+    // Byte progress of ranged downloads lives in the resume journal; SQLite
+    // then only hears about state changes and segment completions
+    if (m_journal) {
+        if (downloaded - m_lastJournalSyncBytes >= Constants::RESUME_JOURNAL_SYNC_BYTES) {
+            m_lastJournalSyncBytes = downloaded;
+            m_journal->requestCheckpoint();
+        }
+    } else if (downloaded - m_lastPersistedBytes >= Constants::PERSISTENCE_CHECKPOINT_BYTES) {
         m_lastPersistedBytes = downloaded;
         emit needsPersistence();
     }
@@ -393,9 +743,63 @@ void DownloadTask::probeServer() {
     m_probe->probe(m_url);
 }
 
+bool DownloadTask::canFastStart() const {
+    if (!m_tunables.fastStart || !m_savedSegments.empty() || !m_deltaSeed.isEmpty()) {
+        return false;  // Delta downloads need the size before the first byte
+    }
+    
+    QString scheme = m_url.scheme();
+    if (scheme != QLatin1String("http") && scheme != QLatin1String("https")) {
+        return false;
+    }
+    
+    return !QFileInfo::exists(m_filePath + QStringLiteral(".part"));
+}
+
+void DownloadTask::fastStart() {
+    setState(DownloadState::Probing);
+    
+    // One open-ended segment until the response says how large the file is
+    m_scheduler->initializeSegments(-1, 1);
+    m_connectionPlan = SegmentScheduler::ConnectionPlan{};
+    m_connectionPlan.protocol = HttpProtocol::Unknown;  // Let curl negotiate
+    if (auto host = HostCache::instance().host(m_url)) {
+        m_connectionPlan.protocol = host->protocol;
+    }
+    
+    m_workers.clear();
+    WorkerPool::instance().request(this, 1);
+    spawnWorker();
+}
+
+void DownloadTask::applyCapabilities(const ServerCapabilities& caps) {
+    m_capabilities = caps;
+    m_sources.setReference(caps, m_expectedHash.isValid());
+    
+    // Update file info from server
+    if (!caps.fileName.isEmpty()) {
+        m_fileName = caps.fileName;
+        m_filePath = m_destDir + QDir::separator() + m_fileName;
+        markDirty(DirtyFileInfo);
+        emit fileNameChanged();
+        emit filePathChanged();
+    }
+    
+    if (caps.contentLength > 0) {
+        m_totalSize.store(caps.contentLength, std::memory_order_relaxed);
+        markDirty(DirtyFileInfo);
+        emit totalSizeChanged();
+    }
+}
+
 void DownloadTask::initializeSegments() {
     ByteCount fileSize = totalSize();
     
+    // An interrupted download continues where its partial file left off
+    if (m_capabilities.supportsRanges && fileSize > 0 && restoreSegments()) {
+        return;
+    }
+    
     size_t segmentCount;
     if (!m_capabilities.supportsRanges || fileSize <= 0) {
         // Single segment for non-resumable downloads
@@ -409,34 +813,161 @@ void DownloadTask::initializeSegments() {
     m_scheduler->initializeSegments(fileSize, segmentCount);
 }
 
+void DownloadTask::planSegments() {
+    // A previous copy only helps a download that starts from scratch
+    if (!m_deltaSeed.isEmpty() && m_capabilities.canSegment() && !m_capabilities.supportsCompression &&
+        QFileInfo(m_deltaSeed).isFile() && !QFileInfo::exists(m_filePath + QStringLiteral(".part"))) {
+        seedFromPrevious();
+        return;
+    }
+    
+    initializeSegments();
+    startWorkers();
+}
+
+void DownloadTask::seedFromPrevious() {
+    setState(DownloadState::Probing);
+    
+    QUrl control = m_deltaControl;
+    if (control.isEmpty()) {
+        control = m_url;
+        control.setPath(m_url.path() + QStringLiteral(".zsync"));
+    }
+    
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_deltaCancel = cancelled;
+    
+    auto* watcher = new QFutureWatcher<DeltaResult>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, cancelled]() {
+        DeltaResult result = watcher->result();
+        watcher->deleteLater();
+        if (cancelled->load() || state() != DownloadState::Probing) {
+            return;  // Cancelled while matching
+        }
+        m_deltaCancel.reset();
+        
+        QString partial = m_filePath + QStringLiteral(".part");
+        if (result.layout.empty()) {
+            qDebug() << "DownloadTask: Downloading all of" << m_fileName
+                     << (result.error.isEmpty() ? QStringLiteral("(no reusable blocks)") : result.error);
+            QFile::remove(partial);
+            initializeSegments();
+        } else {
+            qDebug() << "DownloadTask: Reusing" << result.reused << "of" << totalSize() << "bytes from" << m_deltaSeed;
+            m_scheduler->restoreSegments(result.layout);
+            
+            // Copied blocks were only checked by truncated MD4s
+            if (!m_expectedHash.isValid() && result.sha1.size() == 20) {
+                m_expectedHash = ExpectedHash{HashAlgorithm::Sha1, result.sha1};
+            }
+        }
+        startWorkers();
+    });
+    
+    // The job captures copies only, so it may outlive the task
+    watcher->setFuture(QtConcurrent::run([control, cancelled, seed = m_deltaSeed, length = totalSize(),
+                                          partial = m_filePath + QStringLiteral(".part")]() {
+        DeltaResult result;
+        BlockMap map = BlockMap::fromZsync(fetchControlFile(control));
+        if (!map.isValid() || map.length != length) {
+            result.error = QStringLiteral("(no usable control file at %1)").arg(control.toString());
+            return result;
+        }
+        
+        std::vector<BlockRun> runs = DeltaSync::match(map, seed, *cancelled);
+        if (runs.empty() || !DeltaSync::copy(runs, seed, partial, length, *cancelled, &result.error)) {
+            return result;
+        }
+        
+        for (const BlockRun& run : runs) {
+            result.reused += run.length;
+        }
+        result.layout = DeltaSync::layout(runs, length);
+        result.sha1 = map.sha1;
+        return result;
+    }));
+}
+
+bool DownloadTask::restoreSegments() {
+    QString partial = m_filePath + QStringLiteral(".part");
+    auto snapshots = ResumeJournal::recover(ResumeJournal::pathFor(partial), partial, totalSize(),
+                                            std::exchange(m_savedSegments, {}));
+    if (snapshots.empty()) {
+        return false;
+    }
+    
+    m_scheduler->restoreSegments(snapshots);
+    qDebug() << "DownloadTask: Resuming" << snapshots.size() << "segments from" << partial;
+    return true;
+}
+
 void DownloadTask::startWorkers() {
+    if (!prepareOutputFile()) {
+        DownloadError error;
+        error.category = ErrorCategory::FileSystem;
+        error.message = QStringLiteral("Failed to create output file");
+        error.details = m_outputFile->errorString();
+        setError(error);
+        setState(DownloadState::Failed);
+        emit failed(error);
+        return;
+    }
+    
     setState(DownloadState::Downloading);
+    startExtraction();
+    
+    // Interrupted after the last write but before finalizing
+    if (m_scheduler->isAllComplete()) {
+        QMetaObject::invokeMethod(this, &DownloadTask::onAllSegmentsCompleted, Qt::QueuedConnection);
+        return;
+    }
     
-    // Calculate number of workers
+    m_workers.clear();
+    rampUpWorkers();
+}
+
+void DownloadTask::rampUpWorkers() {
+    // Calculate number of workers. The event-driven backend needs no thread
+    // per connection, so only the blocking backend is capped by the threads.
+    TransferEngine& engine = TransferEngine::instance();
+    WorkerPool& pool = WorkerPool::instance();
     size_t segmentCount = m_scheduler->segmentCount();
-    size_t workerCount = std::min(segmentCount, 
-                                  static_cast<size_t>(m_threadPool->maxThreadCount()));
     
-    // Limit to MAX_SEGMENTS
-    workerCount = std::min(workerCount, static_cast<size_t>(Constants::MAX_SEGMENTS));
+    // One worker per stream; for h2/h3 the streams share a few connections.
+    // Blocking easy handles cannot multiplex, so that backend gets plain
+    // one-stream-per-connection.
+    m_connectionPlan = SegmentScheduler::planConnections(m_capabilities, segmentCount);
+    if (!engine.isRunning()) {
+        m_connectionPlan.connections = m_connectionPlan.totalStreams();
+        m_connectionPlan.streamsPerConnection = 1;
+    }
     
-    qDebug() << "DownloadTask: Starting" << workerCount << "workers";
+    size_t workerCount = m_connectionPlan.totalStreams();
+    if (!engine.isRunning()) {
+        workerCount = std::min(workerCount, static_cast<size_t>(pool.threadCount()));
+    }
     
-    // Create and start workers
-    m_workers.clear();
+    // Limit to the configured connections per download
+    workerCount = std::min(workerCount, static_cast<size_t>(std::max(1, m_tunables.maxSegmentsPerDownload)));
+    
+    // workerCount is now only the ceiling: the tuner starts with a few
+    // connections (or what it learned for this host) and ramps from there,
+    // within what the engine-wide pool grants
+    m_connectionTuner = std::make_unique<ConnectionTuner>(HostCache::hostKey(m_url), workerCount);
+    size_t initialCount = pool.request(this, m_connectionTuner->currentCount());
+    
+    qDebug() << "DownloadTask: Starting" << initialCount << "of up to" << workerCount
+             << "workers over" << m_connectionPlan.connections
+             << httpProtocolToString(m_connectionPlan.protocol) << "connection(s)";
+    
+    // Create and start workers; a running fast-start probe is one of them
     m_workers.reserve(workerCount);
+    applyConnectionCount(initialCount);
     
-    for (size_t i = 0; i < workerCount; ++i) {
-        auto worker = std::make_unique<SegmentWorker>(this, m_scheduler.get(), this);
-        
-        // Connect worker signals
-        connect(worker.get(), &SegmentWorker::finished, this, [this, w = worker.get()]() {
-            qDebug() << "DownloadTask: Worker finished";
-        });
-        
-        // Start worker
-        m_threadPool->start(worker.get());
-        m_workers.push_back(std::move(worker));
+    if (!m_connectionTuner->isSettled() && workerCount > 1) {
+        m_tuneLastBytes = downloadedSize();
+        m_tuneLastTime = std::chrono::system_clock::now();
+        m_tuneTimer->start();
     }
     
     // Enable scheduler rebalancing
@@ -446,103 +977,421 @@ void DownloadTask::startWorkers() {
     m_progressTimer->start();
 }
 
+void DownloadTask::spawnWorker() {
+    TransferEngine& engine = TransferEngine::instance();
+    
+    auto worker = std::make_unique<SegmentWorker>(this, m_scheduler.get(), this);
+    worker->setProtocol(m_connectionPlan.protocol, m_connectionPlan.isMultiplexed());
+    worker->setSpeedLimit(m_segmentSpeedLimit);
+    
+    worker->setPrecondition(m_capabilities);
+    connect(worker.get(), &SegmentWorker::resourceChanged,
+            this, &DownloadTask::onResourceChanged);
+    
+    // Spawned while probing = the fast-start worker (see fastStart())
+    if (state() == DownloadState::Probing) {
+        worker->setCapabilityProbe(true);
+        connect(worker.get(), &SegmentWorker::capabilitiesReceived,
+                this, &DownloadTask::onStreamProbed);
+        connect(worker.get(), &SegmentWorker::probeFailed,
+                this, &DownloadTask::onProbeFailed);
+    }
+    
+    // Connect worker signals
+    connect(worker.get(), &SegmentWorker::finished, this, [this, w = worker.get()]() {
+        qDebug() << "DownloadTask: Worker finished";
+    });
+    
+    // Start worker
+    if (engine.isRunning()) {
+        engine.attachWorker(worker.get());
+    } else {
+        WorkerPool::instance().start(worker.get());
+    }
+    m_workers.push_back(std::move(worker));
+}
+
+void DownloadTask::setConnectionCount(size_t count) {
+    applyConnectionCount(WorkerPool::instance().request(this, count));
+}
+
+void DownloadTask::applyConnectionCount(size_t count) {
+    size_t running = std::count_if(m_workers.begin(), m_workers.end(),
+                                   [](const auto& w) { return w->shouldContinue(); });
+    
+    while (running < count) {
+        spawnWorker();
+        ++running;
+    }
+    
+    // Stop the most recently added workers; their segments go back to the
+    // scheduler with progress intact. Stopped workers stay in m_workers until
+    // stopWorkers() has waited for them, so the pool/engine never sees a
+    // dangling pointer.
+    for (auto it = m_workers.rbegin(); it != m_workers.rend() && running > count; ++it) {
+        if ((*it)->shouldContinue()) {
+            (*it)->stop();
+            --running;
+        }
+    }
+}
+
+void DownloadTask::onTuneTimer() {
+    if (!m_connectionTuner || state() != DownloadState::Downloading) {
+        m_tuneTimer->stop();
+        return;
+    }
+    
+    auto now = std::chrono::system_clock::now();
+    ByteCount downloaded = downloadedSize();
+    double seconds = std::chrono::duration<double>(now - m_tuneLastTime).count();
+    SpeedBps throughput = seconds > 0.0 ? (downloaded - m_tuneLastBytes) / seconds : 0.0;
+    
+    m_tuneLastBytes = downloaded;
+    m_tuneLastTime = now;
+    
+    size_t current = m_connectionTuner->currentCount();
+    size_t desired = m_connectionTuner->update(throughput);
+    if (desired != current) {
+        qDebug() << "DownloadTask: Connections" << current << "->" << desired
+                 << "at" << throughput << "B/s";
+        setConnectionCount(desired);
+    }
+    
+    if (m_connectionTuner->isSettled()) {
+        m_tuneTimer->stop();
+    }
+}
+
+void DownloadTask::onConnectionsGranted() {
+    if (state() != DownloadState::Downloading) {
+        return;
+    }
+    
+    size_t granted = WorkerPool::instance().granted(this);
+    if (granted > 0) {
+        applyConnectionCount(granted);
+    }
+}
+
 void DownloadTask::stopWorkers() {
+    m_tuneTimer->stop();
+    
     // Stop all workers
+    TransferEngine& engine = TransferEngine::instance();
     for (auto& worker : m_workers) {
         worker->stop();
+        engine.detachWorker(worker.get());
     }
     
-    // Wait for workers to finish (with timeout)
-    // Note: In a real implementation, we might want to use QThreadPool::waitForDone
+    // Pool threads use a worker until its run() returns; only then may it go.
+    // All are stopped first so they wind down in parallel.
+    WorkerPool& pool = WorkerPool::instance();
+    for (auto& worker : m_workers) {
+        pool.finish(worker.get());
+    }
     
     m_workers.clear();
+    
+    // Destroyed workers have submitted their buffers; let them reach the
+    // file before it is closed or its segments are persisted
+    if (m_outputFile) {
+        DiskWriter::instance().drain(m_outputFile.get());
+        
+        if (m_journal && m_outputFile->isOpen()) {
+            m_journal->checkpoint(*m_outputFile);
+        }
+    }
 }
 
-bool DownloadTask::mergeSegments() {
-    qDebug() << "DownloadTask: Merging segments to" << m_filePath;
+bool DownloadTask::prepareOutputFile() {
+    // The file name may have changed after probing
+    if (!m_outputFile || m_outputFile->finalPath() != m_filePath) {
+        m_outputFile = std::make_unique<OutputFile>(m_filePath);
+    }
     
-    // Ensure destination directory exists
-    QDir().mkpath(QFileInfo(m_filePath).path());
+    if (!m_outputFile->open()) {
+        return false;
+    }
     
-    QFile outputFile(m_filePath);
-    if (!outputFile.open(QIODevice::WriteOnly)) {
-        qWarning() << "DownloadTask: Failed to open output file:" << outputFile.errorString();
+    // Reserve the full size up front so positional writes never extend the
+    // file and a full disk is reported before any data is transferred
+    ByteCount size = totalSize();
+    if (size > 0 && !m_outputFile->preallocate(size)) {
+        m_outputFile->close();
         return false;
     }
     
-    // Get all segments in order
-    auto segments = m_scheduler->allSegments();
-    std::sort(segments.begin(), segments.end(), [](Segment* a, Segment* b) {
-        return a->startByte() < b->startByte();
+    // Optional page-cache bypass for the full write-behind buffers
+    if (DiskWriter::instance().directIo()) {
+        m_outputFile->enableDirectIo();
+    }
+    
+    // Only ranged downloads can resume, so only they keep a journal
+    if (m_capabilities.supportsRanges && size > 0) {
+        openJournal();
+    }
+    
+    qDebug() << "DownloadTask: Writing directly to" << m_outputFile->partialPath();
+    return true;
+}
+
+void DownloadTask::openJournal() {
+    m_outputFile->setJournal(nullptr);
+    m_journal = std::make_unique<ResumeJournal>(ResumeJournal::pathFor(m_outputFile->partialPath()));
+    
+    // The journal starts with the current progress marked synced; restored
+    // progress was verified against the file but may not be on disk yet
+    m_outputFile->sync();
+    if (!m_journal->open(totalSize(), m_scheduler->allSegments())) {
+        qWarning() << "DownloadTask: Resume journal unavailable, progress is saved to the database only";
+        m_journal.reset();
+        return;
+    }
+    
+    m_outputFile->setJournal(m_journal.get());
+    m_lastJournalSyncBytes = downloadedSize();
+}
+
+bool DownloadTask::sealOutputFile() {
+    if (!m_outputFile) {
+        return false;
+    }
+    
+    DiskWriter::instance().drain(m_outputFile.get());
+    
+    // A lost write leaves a hole; keep the .part file so the data can be recovered
+    if (m_outputFile->hasFailed()) {
+        qWarning() << "DownloadTask: Write to output file failed:" << m_outputFile->errorString();
+        m_outputFile->close();
+        return false;
+    }
+    
+    if (!m_outputFile->seal()) {
+        qWarning() << "DownloadTask: Failed to flush output file:" << m_outputFile->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool DownloadTask::finalizeOutputFile() {
+    if (!m_outputFile || !m_outputFile->finalize()) {
+        qWarning() << "DownloadTask: Failed to finalize output file:"
+                   << (m_outputFile ? m_outputFile->errorString() : QString());
+        return false;
+    }
+    
+    qDebug() << "DownloadTask: Output file finalized at" << m_filePath;
+    return true;
+}
+
+void DownloadTask::verifyFile() {
+    // Nothing is published until the .part file has passed
+    QString partialPath = m_outputFile->partialPath();
+    
+    // Basic verification: check file size
+    QFileInfo fi(partialPath);
+    ByteCount expectedSize = totalSize();
+    if (!fi.exists()) {
+        qWarning() << "DownloadTask: Completed file is missing:" << partialPath;
+    } else if (expectedSize > 0 && fi.size() != expectedSize) {
+        qWarning() << "DownloadTask: File size mismatch. Expected:" << expectedSize
+                   << "Actual:" << fi.size();
+    }
+    
+    ExpectedHash expected = m_expectedHash;
+    
+    // Answered by the segment CRCs without reading the file
+    if (expected.algorithm == HashAlgorithm::Crc32c && m_fileCrc32c) {
+        finishVerification(expected, crc32cDigest(*m_fileCrc32c), QString());
+        return;
+    }
+    
+    if (!expected.isValid() && !m_verifySidecar) {
+        finishVerification(expected, QByteArray(), QString());
+        return;
+    }
+    
+    // Hashing a large file takes seconds; keep it off the task's thread.
+    // The job captures copies only, so it may outlive the task.
+    auto verified = std::make_shared<std::atomic<ByteCount>>(0);
+    m_verifiedBytes = verified;
+    m_progressTimer->start();
+    
+    auto* watcher = new QFutureWatcher<VerificationResult>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        VerificationResult result = watcher->result();
+        watcher->deleteLater();
+        finishVerification(result.expected, result.actual, result.error);
     });
     
-    // Merge each segment
-    for (Segment* segment : segments) {
-        QString tempPath = segment->tempFilePath();
-        QFile tempFile(tempPath);
-        
-        if (!tempFile.open(QIODevice::ReadOnly)) {
-            qWarning() << "DownloadTask: Failed to open temp file:" << tempPath;
-            outputFile.close();
-            QFile::remove(m_filePath);
-            return false;
+    watcher->setFuture(QtConcurrent::run([expected, url = m_url, path = partialPath,
+                                          fileName = m_fileName, verified]() {
+        VerificationResult result;
+        result.expected = expected.isValid() ? expected : fetchSidecar(url, fileName);
+        if (!result.expected.isValid()) {
+            return result;  // No sidecar either; nothing to compare
         }
         
-        // Copy in chunks
-        constexpr qint64 BUFFER_SIZE = Constants::FILE_BUFFER_SIZE;
-        char buffer[BUFFER_SIZE];
-        
-        while (!tempFile.atEnd()) {
-            qint64 read = tempFile.read(buffer, BUFFER_SIZE);
-            if (read <= 0) break;
+        result.actual = hashFile(path, result.expected.algorithm, verified.get());
+        if (result.actual.isEmpty()) {
+            result.error = QStringLiteral("Cannot read %1 for verification").arg(path);
+        }
+        return result;
+    }));
+}
+
+void DownloadTask::finishVerification(const ExpectedHash& expected, const QByteArray& actual,
+                                      const QString& readError) {
+    m_verifiedBytes.reset();
+    if (state() != DownloadState::Verifying) {
+        return;  // Cancelled while hashing
+    }
+    m_progressTimer->stop();
+    
+    if (expected.isValid()) {
+        if (!readError.isEmpty() || actual != expected.digest) {
+            stopExtraction();
             
-            qint64 written = outputFile.write(buffer, read);
-            if (written != read) {
-                qWarning() << "DownloadTask: Write error during merge";
-                tempFile.close();
-                outputFile.close();
-                QFile::remove(m_filePath);
-                return false;
+            // Wrong data is not worth resuming; a file that could not be
+            // read is kept for another attempt
+            if (readError.isEmpty()) {
+                m_outputFile->discard();
             }
+            
+            DownloadError error;
+            error.category = ErrorCategory::Checksum;
+            error.message = readError.isEmpty() ? QStringLiteral("Checksum mismatch") : readError;
+            error.details = QStringLiteral("%1 expected %2, got %3")
+                                .arg(hashAlgorithmName(expected.algorithm),
+                                     QString::fromLatin1(expected.digest.toHex()),
+                                     QString::fromLatin1(actual.toHex()));
+            error.timestamp = std::chrono::system_clock::now();
+            setError(error);
+            setState(DownloadState::Failed);
+            emit failed(error);
+            emit needsPersistence();
+            return;
         }
-        
-        tempFile.close();
+        qDebug() << "DownloadTask:" << hashAlgorithmName(expected.algorithm)
+                 << "verified for" << m_fileName;
     }
     
-    outputFile.close();
+    if (!finalizeOutputFile()) {
+        stopExtraction();
+        DownloadError error;
+        error.category = ErrorCategory::FileSystem;
+        error.message = QStringLiteral("Failed to finalize output file");
+        error.details = m_outputFile ? m_outputFile->errorString() : QString();
+        setError(error);
+        setState(DownloadState::Failed);
+        emit failed(error);
+        emit needsPersistence();
+        return;
+    }
     
-    qDebug() << "DownloadTask: Merge completed successfully";
-    return true;
+    // Whatever the extractor has not read yet is in the final file now
+    if (m_extractor && m_extractor->isRunning()) {
+        m_extractor->advance(m_filePath, QFileInfo(m_filePath).size(), true);
+    }
+    
+    // Record completion
+    m_endTime = std::chrono::system_clock::now();
+    setState(DownloadState::Completed);
+    
+    emit completed();
+    emit needsPersistence();
 }
 
-bool DownloadTask::verifyFile() {
-    // Basic verification: check file size
-    QFileInfo fi(m_filePath);
+std::optional<uint32_t> DownloadTask::combineSegmentChecksums() const {
+    if (totalSize() <= 0) {
+        return std::nullopt;
+    }
     
-    if (!fi.exists()) {
-        return false;
+    auto segments = m_scheduler->allSegments();
+    std::sort(segments.begin(), segments.end(), [](const Segment* a, const Segment* b) {
+        return a->startByte() < b->startByte();
+    });
+    
+    uint32_t crc = 0;
+    ByteOffset expectedStart = 0;
+    for (const Segment* segment : segments) {
+        if (segment->startByte() != expectedStart || !segment->hasCompleteChecksum()) {
+            return std::nullopt;
+        }
+        crc = crc32cCombine(crc, segment->checksum(), segment->totalSize());
+        expectedStart = segment->endByte() + 1;
     }
     
-    ByteCount expectedSize = totalSize();
-    if (expectedSize > 0 && fi.size() != expectedSize) {
-        qWarning() << "DownloadTask: File size mismatch. Expected:" << expectedSize
-                   << "Actual:" << fi.size();
-        return false;
+    if (expectedStart != totalSize()) {
+        return std::nullopt;
+    }
+    return crc;
+}
+
+void DownloadTask::startExtraction() {
+    if (m_extractTo.isEmpty() || m_extractor) {
+        return;  // Not asked for, or already following this download
     }
     
-    // TODO: Full checksum verification if server provided one
+    ArchiveExtractor::Format format = ArchiveExtractor::formatFor(m_fileName);
+    if (!ArchiveExtractor::supports(format)) {
+        qWarning() << "DownloadTask: Cannot unpack" << m_fileName << "while downloading";
+        emit extractionFailed(QStringLiteral("Unsupported archive: %1").arg(m_fileName));
+        return;
+    }
     
-    return true;
+    m_extractor = std::make_unique<ArchiveExtractor>();
+    connect(m_extractor.get(), &ArchiveExtractor::finished, this, [this](const QString& directory, int entries) {
+        qDebug() << "DownloadTask: Unpacked" << entries << "entries into" << directory;
+        emit extracted(directory);
+    });
+    connect(m_extractor.get(), &ArchiveExtractor::failed, this, &DownloadTask::extractionFailed);
+    
+    if (!m_extractor->start(format, m_extractTo)) {
+        m_extractor.reset();
+        emit extractionFailed(QStringLiteral("Cannot create %1").arg(m_extractTo));
+        return;
+    }
+    
+    // Ranges in file order keep the contiguous prefix growing
+    m_scheduler->setSequential(true);
+    m_extractFed = 0;
+    feedExtractor();
 }
 
-void DownloadTask::cleanupTempFiles() {
-    auto segments = m_scheduler->allSegments();
+void DownloadTask::feedExtractor() {
+    if (!m_extractor || !m_extractor->isRunning() || !m_outputFile) {
+        return;
+    }
     
-    for (Segment* segment : segments) {
-        QString tempPath = segment->tempFilePath();
-        if (!tempPath.isEmpty() && QFile::exists(tempPath)) {
-            QFile::remove(tempPath);
+    m_extractFed = m_scheduler->contiguousEnd(m_extractFed);
+    m_extractor->advance(m_outputFile->partialPath(), m_extractFed, false);
+}
+
+void DownloadTask::stopExtraction() {
+    if (m_extractor) {
+        m_extractor->cancel();
+        m_extractor.reset();
+    }
+    m_extractFed = 0;
+}
+
+void DownloadTask::cleanupTempFiles() {
+    if (m_journal) {
+        if (m_outputFile) {
+            m_outputFile->setJournal(nullptr);
         }
+        m_journal->discard();
+        m_journal.reset();
+    } else {
+        QFile::remove(ResumeJournal::pathFor(m_filePath + QStringLiteral(".part")));
+    }
+    
+    if (m_outputFile) {
+        m_outputFile->discard();
+    } else {
+        QFile::remove(m_filePath + QStringLiteral(".part"));
     }
 }
 
@@ -553,12 +1402,33 @@ void DownloadTask::setState(DownloadState newState) {
         qDebug() << "DownloadTask:" << m_id.toString()
                  << "state changed from" << downloadStateToString(oldState)
                  << "to" << downloadStateToString(newState);
+        
+        // Only transferring tasks count towards the global speed
+        AggregateSpeedCalculator& aggregate = AggregateSpeedCalculator::instance();
+        if (newState == DownloadState::Downloading) {
+            m_speedMeter.reset();
+            if (m_speedSlot < 0) {
+                m_speedSlot = aggregate.acquireSlot();
+            }
+        } else if (oldState == DownloadState::Downloading) {
+            aggregate.releaseSlot(m_speedSlot);
+            m_speedSlot = -1;
+        }
+        
+        // Hand the connections to other active downloads right away; a
+        // fast-start probe holds its slot from Probing into Downloading
+        if (newState != DownloadState::Downloading && newState != DownloadState::Probing) {
+            WorkerPool::instance().release(this);
+        }
+        
+        markDirty(DirtyState | DirtySpeed | DirtySegments);
         emit stateChanged(newState);
     }
 }
 
 void DownloadTask::setError(const DownloadError& error) {
     m_lastError = error;
+    markDirty(DirtyError);
     emit errorChanged();
 }
 
@@ -567,26 +1437,14 @@ void DownloadTask::updateStatistics() {
     ByteCount downloaded = m_scheduler->totalDownloadedBytes();
     m_downloadedBytes.store(downloaded, std::memory_order_relaxed);
     
-    // Aggregate speed from scheduler
+    // Aggregate speed from scheduler (samples the workers' counters)
+    m_scheduler->sampleThroughput();
     SpeedBps speed = m_scheduler->totalThroughput();
     m_currentSpeed.store(speed, std::memory_order_relaxed);
     
-    // Record speed history for ETA calculation
-    auto now = std::chrono::system_clock::now();
-    m_speedHistory.emplace_back(now, downloaded);
-    
-    // Keep only recent history
-    auto cutoff = now - Constants::SPEED_SMOOTHING_WINDOW;
-    while (!m_speedHistory.empty() && m_speedHistory.front().first < cutoff) {
-        m_speedHistory.erase(m_speedHistory.begin());
-    }
-}
-
-QString DownloadTask::tempFilePath(SegmentId segmentId) const {
-    return QStringLiteral("%1/.%2.part%3")
-              .arg(m_destDir)
-              .arg(m_fileName)
-              .arg(segmentId);
+    // Smoothed speed for the ETA, and this task's share of the global meter
+    m_speedMeter.setTotal(downloaded, std::chrono::system_clock::now());
+    AggregateSpeedCalculator::instance().publish(m_speedSlot, speed);
 }
 
 } // namespace OpenIDM
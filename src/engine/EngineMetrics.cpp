@@ -0,0 +1,255 @@
+/**
+ * @file EngineMetrics.cpp
+ * @brief Implementation of EngineMetrics - counters and text exposition
+ */
+
+#include "openidm/engine/EngineMetrics.h"
+#include "openidm/engine/MemoryBudget.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace OpenIDM {
+
+namespace {
+
+/// Spreads threads over the shards; fixed per thread for its lifetime
+size_t shardIndex(size_t shards) {
+    static std::atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index % shards;
+}
+
+const char* categoryLabel(ErrorCategory category) {
+    switch (category) {
+        case ErrorCategory::None:        return "none";
+        case ErrorCategory::Network:     return "network";
+        case ErrorCategory::ServerError: return "server";
+        case ErrorCategory::ClientError: return "client";
+        case ErrorCategory::FileSystem:  return "filesystem";
+        case ErrorCategory::Checksum:    return "checksum";
+        case ErrorCategory::Cancelled:   return "cancelled";
+        case ErrorCategory::Timeout:     return "timeout";
+        case ErrorCategory::SSLError:    return "tls";
+        default:                         return "unknown";
+    }
+}
+
+const char* stateLabel(DownloadState state) {
+    switch (state) {
+        case DownloadState::Queued:      return "queued";
+        case DownloadState::Probing:     return "probing";
+        case DownloadState::Downloading: return "downloading";
+        case DownloadState::Paused:      return "paused";
+        case DownloadState::Merging:     return "merging";
+        case DownloadState::Verifying:   return "verifying";
+        case DownloadState::Completed:   return "completed";
+        case DownloadState::Failed:      return "failed";
+        default:                         return "unknown";
+    }
+}
+
+/// Appends "# HELP" and "# TYPE" for a family
+void family(QByteArray& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void sample(QByteArray& out, const char* name, const QByteArray& labels, double value) {
+    out += name;
+    if (!labels.isEmpty()) {
+        out += '{' + labels + '}';
+    }
+    out += ' ';
+    out += QByteArray::number(value, 'g', 15);
+    out += '\n';
+}
+
+void sample(QByteArray& out, const char* name, double value) {
+    sample(out, name, QByteArray(), value);
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Recording
+// ═══════════════════════════════════════════════════════════════════════════════
+
+EngineMetrics& EngineMetrics::instance() {
+    static EngineMetrics metrics;
+    return metrics;
+}
+
+void EngineMetrics::addBytesReceived(ByteCount bytes) {
+    m_bytesReceived[shardIndex(SHARDS)].value.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void EngineMetrics::addRebalance(int splits) {
+    m_rebalances.fetch_add(1, std::memory_order_relaxed);
+    m_rebalanceSplits.fetch_add(static_cast<uint64_t>(std::max(splits, 0)), std::memory_order_relaxed);
+}
+
+void EngineMetrics::addRetry(ErrorCategory category) {
+    size_t index = std::min(static_cast<size_t>(category), CATEGORIES - 1);
+    m_retries[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+void EngineMetrics::addDownloadFinished(bool success) {
+    (success ? m_downloadsCompleted : m_downloadsFailed).fetch_add(1, std::memory_order_relaxed);
+}
+
+void EngineMetrics::observeDiskWrite(std::chrono::microseconds latency, ByteCount bytes) {
+    auto bucket = std::lower_bound(WRITE_BUCKETS_US.begin(), WRITE_BUCKETS_US.end(), latency.count());
+    m_writeBuckets[static_cast<size_t>(bucket - WRITE_BUCKETS_US.begin())].fetch_add(1, std::memory_order_relaxed);
+    m_writeLatencySumUs.fetch_add(latency.count(), std::memory_order_relaxed);
+    m_bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+ByteCount EngineMetrics::bytesReceived() const {
+    ByteCount total = 0;
+    for (const Shard& shard : m_bytesReceived) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Exposition
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void EngineMetrics::setTaskSource(TaskSource source) {
+    std::lock_guard lock(m_sourceMutex);
+    m_taskSource = std::move(source);
+}
+
+QByteArray EngineMetrics::render() const {
+    QByteArray out;
+    out.reserve(4096);
+
+    family(out, "openidm_received_bytes_total", "counter", "Bytes stored by all transfers.");
+    sample(out, "openidm_received_bytes_total", static_cast<double>(bytesReceived()));
+
+    family(out, "openidm_active_transfers", "gauge", "Segment transfers in progress (connections or streams).");
+    sample(out, "openidm_active_transfers", static_cast<double>(m_activeTransfers.load(std::memory_order_relaxed)));
+
+    family(out, "openidm_segment_steals_total", "counter", "Segments split off a busy worker's segment.");
+    sample(out, "openidm_segment_steals_total", static_cast<double>(m_steals.load(std::memory_order_relaxed)));
+
+    family(out, "openidm_segment_hedges_total", "counter", "End-game duplicate requests.");
+    sample(out, "openidm_segment_hedges_total", static_cast<double>(m_hedges.load(std::memory_order_relaxed)));
+
+    family(out, "openidm_rebalances_total", "counter", "Rebalance passes that split slow segments.");
+    sample(out, "openidm_rebalances_total", static_cast<double>(m_rebalances.load(std::memory_order_relaxed)));
+    family(out, "openidm_rebalance_splits_total", "counter", "Slow segments split by rebalancing.");
+    sample(out, "openidm_rebalance_splits_total", static_cast<double>(m_rebalanceSplits.load(std::memory_order_relaxed)));
+
+    family(out, "openidm_segment_retries_total", "counter", "Failed segment transfers queued for retry, by error category.");
+    for (size_t i = 0; i < CATEGORIES; ++i) {
+        uint64_t value = m_retries[i].load(std::memory_order_relaxed);
+        QByteArray labels = QByteArray("category=\"") + categoryLabel(static_cast<ErrorCategory>(i)) + '"';
+        sample(out, "openidm_segment_retries_total", labels, static_cast<double>(value));
+    }
+
+    family(out, "openidm_downloads_finished_total", "counter", "Downloads that completed or failed.");
+    sample(out, "openidm_downloads_finished_total", "result=\"completed\"",
+           static_cast<double>(m_downloadsCompleted.load(std::memory_order_relaxed)));
+    sample(out, "openidm_downloads_finished_total", "result=\"failed\"",
+           static_cast<double>(m_downloadsFailed.load(std::memory_order_relaxed)));
+
+    family(out, "openidm_persistence_queue_depth", "gauge", "Database writes waiting for the writer thread.");
+    sample(out, "openidm_persistence_queue_depth", static_cast<double>(m_persistenceQueue.load(std::memory_order_relaxed)));
+
+    // Buckets are kept per range and summed here into Prometheus' cumulative form
+    family(out, "openidm_disk_write_seconds", "histogram", "Latency of write-behind buffers from submission to completion.");
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < m_writeBuckets.size(); ++i) {
+        cumulative += m_writeBuckets[i].load(std::memory_order_relaxed);
+        QByteArray le = i < WRITE_BUCKETS_US.size()
+                            ? QByteArray::number(static_cast<double>(WRITE_BUCKETS_US[i]) / 1e6, 'g', 6)
+                            : QByteArray("+Inf");
+        sample(out, "openidm_disk_write_seconds_bucket", "le=\"" + le + '"', static_cast<double>(cumulative));
+    }
+    sample(out, "openidm_disk_write_seconds_sum",
+           static_cast<double>(m_writeLatencySumUs.load(std::memory_order_relaxed)) / 1e6);
+    sample(out, "openidm_disk_write_seconds_count", static_cast<double>(cumulative));
+
+    family(out, "openidm_disk_written_bytes_total", "counter", "Bytes written by the write-behind thread.");
+    sample(out, "openidm_disk_written_bytes_total", static_cast<double>(m_bytesWritten.load(std::memory_order_relaxed)));
+
+    const MemoryBudget& memory = MemoryBudget::instance();
+    family(out, "openidm_buffered_bytes", "gauge", "Bytes held in memory between the network and the disk.");
+    sample(out, "openidm_buffered_bytes", static_cast<double>(memory.used()));
+    family(out, "openidm_buffered_bytes_limit", "gauge", "Memory budget for buffered bytes.");
+    sample(out, "openidm_buffered_bytes_limit", static_cast<double>(memory.limit()));
+    family(out, "openidm_memory_pauses_total", "counter", "Transfers paused because the memory budget was spent.");
+    sample(out, "openidm_memory_pauses_total", static_cast<double>(memory.pauses()));
+
+    // Per task
+    std::vector<TaskSample> tasks;
+    {
+        std::lock_guard lock(m_sourceMutex);
+        if (m_taskSource) {
+            m_taskSource([&tasks](const TaskSample& task) { tasks.push_back(task); });
+        }
+    }
+
+    SpeedBps globalSpeed = 0.0;
+    std::array<int, static_cast<size_t>(DownloadState::Failed) + 1> states{};
+    for (const TaskSample& task : tasks) {
+        globalSpeed += task.speed;
+        size_t state = std::min(static_cast<size_t>(task.state), states.size() - 1);
+        ++states[state];
+    }
+
+    family(out, "openidm_speed_bytes_per_second", "gauge", "Smoothed download speed of all tasks.");
+    sample(out, "openidm_speed_bytes_per_second", globalSpeed);
+
+    family(out, "openidm_tasks", "gauge", "Tasks by state.");
+    for (size_t i = 0; i < states.size(); ++i) {
+        sample(out, "openidm_tasks", QByteArray("state=\"") + stateLabel(static_cast<DownloadState>(i)) + '"',
+               static_cast<double>(states[i]));
+    }
+
+    // Finished tasks would only add flat series; report the ones that move
+    auto live = [](const TaskSample& task) {
+        return task.state != DownloadState::Completed && task.state != DownloadState::Failed;
+    };
+    family(out, "openidm_task_downloaded_bytes", "gauge", "Bytes downloaded per unfinished task.");
+    for (const TaskSample& task : tasks) {
+        if (live(task)) {
+            sample(out, "openidm_task_downloaded_bytes", "task=\"" + task.id.toLatin1() + '"',
+                   static_cast<double>(task.downloaded));
+        }
+    }
+    family(out, "openidm_task_size_bytes", "gauge", "Total size per unfinished task, if known.");
+    for (const TaskSample& task : tasks) {
+        if (live(task) && task.total >= 0) {
+            sample(out, "openidm_task_size_bytes", "task=\"" + task.id.toLatin1() + '"',
+                   static_cast<double>(task.total));
+        }
+    }
+    family(out, "openidm_task_speed_bytes_per_second", "gauge", "Smoothed speed per unfinished task.");
+    for (const TaskSample& task : tasks) {
+        if (live(task)) {
+            sample(out, "openidm_task_speed_bytes_per_second", "task=\"" + task.id.toLatin1() + '"', task.speed);
+        }
+    }
+    family(out, "openidm_task_connections", "gauge", "Segments being transferred per unfinished task.");
+    for (const TaskSample& task : tasks) {
+        if (live(task)) {
+            sample(out, "openidm_task_connections", "task=\"" + task.id.toLatin1() + '"',
+                   static_cast<double>(task.connections));
+        }
+    }
+
+    return out;
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,697 @@
+/**
+ * @file FragmentDownloader.cpp
+ * @brief Implementation of FragmentDownloader - parallel HLS/DASH fragments
+ */
+
+#include "openidm/engine/FragmentDownloader.h"
+#include "openidm/engine/MemoryBudget.h"
+#include "openidm/integration/StreamParser.h"
+#include "engine/CurlWrapper.h"
+
+#include <curl/curl.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QMetaObject>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef OPENIDM_HAVE_OPENSSL
+#include <openssl/evp.h>
+#endif
+
+namespace OpenIDM {
+
+namespace {
+
+/// Master → media playlist hops before giving up
+constexpr int MAX_PLAYLIST_DEPTH = 2;
+
+/// @return True for HTTP errors that a retry may fix
+bool isTransient(long httpCode) {
+    return httpCode == 0 || httpCode == 408 || httpCode == 429 || httpCode >= 500;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+FragmentDownloader::FragmentDownloader(QObject* parent)
+    : QObject(parent)
+{
+}
+
+FragmentDownloader::~FragmentDownloader() {
+    cancel();
+}
+
+bool FragmentDownloader::supportsEncryption() {
+#ifdef OPENIDM_HAVE_OPENSSL
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Control
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool FragmentDownloader::startPlaylist(const QUrl& playlist, const QString& outputPath) {
+    if (m_running || !playlist.isValid()) {
+        return false;
+    }
+
+    m_list = FragmentList{};
+    m_playlistUrl = playlist;
+    m_playlistDepth = 0;
+    return launch(outputPath);
+}
+
+bool FragmentDownloader::start(FragmentList list, const QString& outputPath) {
+    if (m_running || !list.isValid()) {
+        return false;
+    }
+    if (list.isEncrypted() && !supportsEncryption()) {
+        qWarning() << "FragmentDownloader: Encrypted stream, but built without OpenSSL";
+        return false;
+    }
+
+    m_list = std::move(list);
+    m_playlistUrl = QUrl();
+    return launch(outputPath);
+}
+
+bool FragmentDownloader::launch(const QString& outputPath) {
+    // Truncate now so a failure to open is reported before any transfer
+    QFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "FragmentDownloader: Cannot open" << outputPath << output.errorString();
+        return false;
+    }
+    output.close();
+
+    m_outputPath = outputPath;
+    dropBodies();
+    m_keys.assign(m_list.keys.size(), QByteArray());
+    m_written = 0;
+    m_bytesWritten = 0;
+    m_failed = false;
+    m_retries.clear();
+    m_attempts.clear();
+    m_nextFragment = 0;
+    m_activeFragments = 0;
+    m_keysStarted = false;
+    m_bytesReceived = 0;
+    m_speed.reset();
+    m_lastProgress = Timestamp{};
+
+    CurlGlobalInit::instance();
+    m_multi = curl_multi_init();
+
+    // Fragments of one CDN share a few connections, as HTTP/2 streams
+    // where the server allows it
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      static_cast<long>(Constants::FRAGMENT_CONCURRENCY));
+
+    curl_slist_free_all(m_headers);
+    m_headers = nullptr;
+    for (const QString& line : m_headerLines) {
+        m_headers = curl_slist_append(m_headers, line.toUtf8().constData());
+    }
+
+    m_stopping = false;
+    m_running = true;
+    m_io = std::thread([this]() { run(); });
+    m_writer = std::thread([this]() { write(); });
+    return true;
+}
+
+void FragmentDownloader::cancel() {
+    m_stopping = true;
+    {
+        std::lock_guard lock(m_mutex);
+        m_writerWake.notify_all();
+    }
+    if (m_multi) {
+        curl_multi_wakeup(m_multi);
+    }
+    if (m_io.joinable()) {
+        m_io.join();
+    }
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    if (m_multi) {
+        curl_multi_cleanup(m_multi);
+        m_multi = nullptr;
+    }
+    curl_slist_free_all(m_headers);
+    m_headers = nullptr;
+    dropBodies();
+    m_running = false;
+}
+
+void FragmentDownloader::fail(const DownloadError& error) {
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_failed) {
+            return;
+        }
+        m_failed = true;
+        m_writerWake.notify_all();
+    }
+    m_stopping = true;
+
+    QMetaObject::invokeMethod(this, [this, error]() {
+        cancel();
+        emit failed(error);
+    }, Qt::QueuedConnection);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// I/O Thread
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void FragmentDownloader::run() {
+    while (!m_stopping) {
+        startTransfers();
+        resumePaused();
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        int pending = 0;
+        while (CURLMsg* msg = curl_multi_info_read(m_multi, &pending)) {
+            if (msg->msg == CURLMSG_DONE) {
+                finishTransfer(msg->easy_handle, msg->data.result);
+            }
+        }
+
+        reportProgress();
+
+        // Woken early by the writer (window moved), cancel() and fail();
+        // otherwise no later than the next retry is due
+        int timeoutMs = static_cast<int>(Constants::PROGRESS_UPDATE_INTERVAL.count());
+        if (!m_retries.empty()) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                m_retries.front().notBefore - std::chrono::system_clock::now());
+            timeoutMs = std::clamp(static_cast<int>(wait.count()), 0, timeoutMs);
+        }
+        curl_multi_poll(m_multi, nullptr, 0, timeoutMs, nullptr);
+    }
+
+    while (!m_active.empty()) {
+        releaseTransfer(m_active.begin()->first);
+    }
+}
+
+void FragmentDownloader::startTransfers() {
+    QUrl playlist;
+    size_t fragmentCount = 0;
+    size_t written = 0;
+    std::vector<QUrl> keys;
+    {
+        std::lock_guard lock(m_mutex);
+        playlist = m_playlistUrl;
+        fragmentCount = m_list.fragments.size();
+        written = m_written;
+        if (!m_keysStarted && playlist.isEmpty()) {
+            keys = m_list.keys;
+        }
+    }
+
+    // The media playlist has to be known before anything else
+    if (!playlist.isEmpty()) {
+        if (m_active.empty() && m_retries.empty()) {
+            startTransfer(Kind::Playlist, 0, playlist);
+        }
+        if (m_retries.empty() || m_retries.front().notBefore > std::chrono::system_clock::now()) {
+            return;
+        }
+    }
+
+    // Keys are tiny; fetch them all up front, next to the first fragments
+    if (!m_keysStarted && playlist.isEmpty()) {
+        m_keysStarted = true;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            startTransfer(Kind::Key, i, keys[i]);
+        }
+    }
+
+    auto now = std::chrono::system_clock::now();
+    while (!m_retries.empty() && m_retries.front().notBefore <= now) {
+        Retry retry = m_retries.front();
+        m_retries.pop_front();
+
+        QUrl url;
+        {
+            std::lock_guard lock(m_mutex);
+            url = retry.kind == Kind::Playlist ? m_playlistUrl
+                  : retry.kind == Kind::Key    ? m_list.keys[retry.index]
+                                               : m_list.fragments[retry.index].url;
+        }
+        startTransfer(retry.kind, retry.index, url);
+    }
+
+    // Window: never hold more than FRAGMENT_WINDOW fragments ahead of the
+    // writer, however fast the network is
+    while (m_activeFragments < Constants::FRAGMENT_CONCURRENCY && m_nextFragment < fragmentCount &&
+           m_nextFragment < written + Constants::FRAGMENT_WINDOW) {
+        QUrl url;
+        {
+            std::lock_guard lock(m_mutex);
+            url = m_list.fragments[m_nextFragment].url;
+        }
+        startTransfer(Kind::Fragment, m_nextFragment++, url);
+    }
+}
+
+void FragmentDownloader::startTransfer(Kind kind, size_t index, const QUrl& url) {
+    CURL* easy = curl_easy_init();
+    if (!easy) {
+        DownloadError error;
+        error.category = ErrorCategory::Unknown;
+        error.message = QStringLiteral("Failed to initialize curl");
+        fail(error);
+        return;
+    }
+
+    auto transfer = std::make_unique<Transfer>();
+    transfer->owner = this;
+    transfer->kind = kind;
+    transfer->index = index;
+    transfer->url = url;
+    transfer->urlBytes = url.toString().toUtf8();
+
+    if (kind == Kind::Fragment) {
+        std::lock_guard lock(m_mutex);
+        const StreamFragment& fragment = m_list.fragments[index];
+        if (fragment.rangeStart >= 0 && fragment.rangeLength > 0) {
+            transfer->rangeBytes = QByteArray::number(fragment.rangeStart) + '-' +
+                                   QByteArray::number(fragment.rangeStart + fragment.rangeLength - 1);
+        }
+        ++m_activeFragments;
+    }
+
+    // DNS entries and TLS sessions are shared with the segment engine
+    CurlGlobalInit::instance().share().attach(easy);
+
+    curl_easy_setopt(easy, CURLOPT_URL, transfer->urlBytes.constData());
+    if (!transfer->rangeBytes.isEmpty()) {
+        curl_easy_setopt(easy, CURLOPT_RANGE, transfer->rangeBytes.constData());
+    }
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, m_headers);
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(easy, CURLOPT_MAXREDIRS, 10L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(Constants::CONNECT_TIMEOUT.count()));
+    curl_easy_setopt(easy, CURLOPT_LOW_SPEED_LIMIT, Constants::LOW_SPEED_LIMIT);
+    curl_easy_setopt(easy, CURLOPT_LOW_SPEED_TIME, Constants::LOW_SPEED_TIME);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, 2L);
+
+#ifdef Q_OS_WIN
+    curl_easy_setopt(easy, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NATIVE_CA);
+#endif
+
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer.get());
+    curl_easy_setopt(easy, CURLOPT_USERAGENT, "OpenIDM/1.0 (https://github.com/openidm)");
+
+    curl_multi_add_handle(m_multi, easy);
+    m_active.emplace(easy, std::move(transfer));
+}
+
+void FragmentDownloader::finishTransfer(CURL* easy, int curlCode) {
+    auto it = m_active.find(easy);
+    if (it == m_active.end()) {
+        return;
+    }
+    long httpCode = 0;
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &httpCode);
+
+    std::unique_ptr<Transfer> transfer = std::move(it->second);
+    if (transfer->kind == Kind::Fragment) {
+        --m_activeFragments;
+    }
+    releaseTransfer(easy);
+
+    if (curlCode != CURLE_OK) {
+        if (transfer->kind == Kind::Fragment) {
+            MemoryBudget::instance().release(transfer->body.size());
+        }
+        DownloadError error;
+        error.category = httpCode >= 500 ? ErrorCategory::ServerError
+                         : httpCode >= 400 ? ErrorCategory::ClientError
+                                           : ErrorCategory::Network;
+        error.errorCode = httpCode > 0 ? static_cast<int>(httpCode) : curlCode;
+        error.message = QStringLiteral("%1: %2").arg(
+            transfer->url.toString(),
+            QString::fromUtf8(curl_easy_strerror(static_cast<CURLcode>(curlCode))));
+        if (isTransient(httpCode)) {
+            scheduleRetry(transfer->kind, transfer->index, error);
+        } else {
+            fail(error);
+        }
+        return;
+    }
+
+    switch (transfer->kind) {
+        case Kind::Playlist:
+            if (!acceptPlaylist(transfer->body, transfer->url)) {
+                return;
+            }
+            break;
+
+        case Kind::Key: {
+            if (transfer->body.size() != 16) {
+                DownloadError error;
+                error.category = ErrorCategory::ServerError;
+                error.message = QStringLiteral("Invalid AES-128 key from %1").arg(transfer->url.toString());
+                fail(error);
+                return;
+            }
+            std::lock_guard lock(m_mutex);
+            m_keys[transfer->index] = std::move(transfer->body);
+            m_writerWake.notify_all();
+            break;
+        }
+
+        case Kind::Fragment: {
+            std::lock_guard lock(m_mutex);
+            m_bodies[transfer->index] = std::move(transfer->body);
+            m_writerWake.notify_all();
+            break;
+        }
+    }
+}
+
+void FragmentDownloader::releaseTransfer(CURL* easy) {
+    auto it = m_active.find(easy);
+    if (it == m_active.end()) {
+        return;
+    }
+
+    if (it->second && it->second->kind == Kind::Fragment) {
+        --m_activeFragments;
+        MemoryBudget::instance().release(it->second->body.size());
+    }
+
+    curl_multi_remove_handle(m_multi, easy);
+    curl_easy_cleanup(easy);
+    m_active.erase(it);
+}
+
+bool FragmentDownloader::reserveBody(Transfer& transfer, size_t bytes) {
+    MemoryBudget& budget = MemoryBudget::instance();
+    auto wanted = static_cast<ByteCount>(bytes);
+    bool granted = budget.tryReserve(wanted);
+    if (!granted) {
+        // The writer is waiting for the next fragment in order; it always
+        // gets memory, or a full window could never drain
+        std::lock_guard lock(m_mutex);
+        if (transfer.index == m_written) {
+            budget.reserve(wanted);
+            granted = true;
+        }
+    }
+
+    if (!granted && !transfer.paused) {
+        budget.addPause();
+    }
+    transfer.paused = !granted;
+    transfer.pausedBytes = granted ? 0 : wanted;
+    return granted;
+}
+
+void FragmentDownloader::resumePaused() {
+    size_t written = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        written = m_written;
+    }
+
+    // Polled every loop (at most PROGRESS_UPDATE_INTERVAL apart): a woken
+    // handle that still does not fit pauses itself again
+    MemoryBudget& budget = MemoryBudget::instance();
+    for (auto& [easy, transfer] : m_active) {
+        if (transfer && transfer->paused &&
+            (transfer->index == written || budget.hasRoom(transfer->pausedBytes))) {
+            curl_easy_pause(easy, CURLPAUSE_CONT);
+        }
+    }
+}
+
+void FragmentDownloader::dropBodies() {
+    ByteCount charged = 0;
+    for (const auto& [index, body] : m_bodies) {
+        charged += body.size();
+    }
+    m_bodies.clear();
+    MemoryBudget::instance().release(charged);
+}
+
+bool FragmentDownloader::acceptPlaylist(const QByteArray& body, const QUrl& url) {
+    QString content = QString::fromUtf8(body);
+    DownloadError error;
+    error.category = ErrorCategory::ServerError;
+
+    if (!StreamParser::isM3U8(content)) {
+        error.message = QStringLiteral("Not an HLS playlist: %1").arg(url.toString());
+        fail(error);
+        return false;
+    }
+
+    HlsPlaylist playlist = StreamParser::parseM3U8(content, url);
+
+    if (playlist.isMaster) {
+        const HlsVariant* best = StreamParser::bestVariant(playlist);
+        if (!best || best->url.isEmpty() || ++m_playlistDepth > MAX_PLAYLIST_DEPTH) {
+            error.message = QStringLiteral("No usable variant in %1").arg(url.toString());
+            fail(error);
+            return false;
+        }
+        std::lock_guard lock(m_mutex);
+        m_playlistUrl = QUrl(best->url);
+        return true;
+    }
+
+    FragmentList list = StreamParser::fragments(playlist);
+    if (!list.isValid() || (list.isEncrypted() && !supportsEncryption())) {
+        error.category = ErrorCategory::ClientError;
+        error.message = playlist.isEndList
+                            ? QStringLiteral("Unsupported stream encryption in %1").arg(url.toString())
+                            : QStringLiteral("Live playlists are not supported: %1").arg(url.toString());
+        fail(error);
+        return false;
+    }
+
+    qDebug() << "FragmentDownloader:" << list.fragments.size() << "fragments," << list.keys.size()
+             << "keys from" << url.toString();
+
+    std::lock_guard lock(m_mutex);
+    m_list = std::move(list);
+    m_keys.assign(m_list.keys.size(), QByteArray());
+    m_playlistUrl = QUrl();
+    m_writerWake.notify_all();
+    return true;
+}
+
+void FragmentDownloader::scheduleRetry(Kind kind, size_t index, const DownloadError& error) {
+    size_t& attempts = m_attempts[{static_cast<int>(kind), index}];
+    if (++attempts > Constants::MAX_RETRIES) {
+        DownloadError final = error;
+        final.retryCount = attempts - 1;
+        fail(final);
+        return;
+    }
+
+    // Exponential backoff, as for segments
+    double delayMs = static_cast<double>(Constants::RETRY_BACKOFF_BASE.count()) *
+                     std::pow(Constants::RETRY_BACKOFF_MULTIPLIER, static_cast<double>(attempts - 1));
+    delayMs = std::min(delayMs, static_cast<double>(Constants::MAX_RETRY_DELAY.count()));
+
+    Retry retry{kind, index, std::chrono::system_clock::now() +
+                             std::chrono::milliseconds(static_cast<int64_t>(delayMs))};
+    auto position = std::upper_bound(m_retries.begin(), m_retries.end(), retry,
+                                     [](const Retry& a, const Retry& b) { return a.notBefore < b.notBefore; });
+    m_retries.insert(position, retry);
+
+    qDebug() << "FragmentDownloader: Retry" << attempts << "in" << delayMs << "ms:" << error.message;
+}
+
+void FragmentDownloader::reportProgress() {
+    auto now = std::chrono::system_clock::now();
+    m_speed.setTotal(m_bytesReceived, now);
+    if (now - m_lastProgress < Constants::PROGRESS_UPDATE_INTERVAL) {
+        return;
+    }
+    m_lastProgress = now;
+
+    int written = 0;
+    int total = 0;
+    ByteCount bytes = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        written = static_cast<int>(m_written);
+        total = static_cast<int>(m_list.fragments.size());
+        bytes = m_bytesWritten;
+    }
+    SpeedBps speed = m_speed.smoothedSpeed();
+
+    QMetaObject::invokeMethod(this, [this, written, total, bytes, speed]() {
+        emit progress(written, total, bytes, speed);
+    }, Qt::QueuedConnection);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Writer Thread
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void FragmentDownloader::write() {
+    QFile output(m_outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        DownloadError error;
+        error.category = ErrorCategory::FileSystem;
+        error.message = QStringLiteral("Cannot open %1: %2").arg(m_outputPath, output.errorString());
+        fail(error);
+        return;
+    }
+
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        // Next in order, with its key if it needs one
+        auto ready = [this]() {
+            if (!m_playlistUrl.isEmpty() || m_written >= m_list.fragments.size()) {
+                return false;
+            }
+            auto body = m_bodies.find(m_written);
+            if (body == m_bodies.end()) {
+                return false;
+            }
+            int key = m_list.fragments[m_written].key;
+            return key < 0 || !m_keys[static_cast<size_t>(key)].isEmpty();
+        };
+        auto done = [this]() {
+            return m_playlistUrl.isEmpty() && m_list.isValid() && m_written >= m_list.fragments.size();
+        };
+
+        m_writerWake.wait(lock, [&]() { return m_stopping || m_failed || ready() || done(); });
+        if (m_stopping || m_failed) {
+            return;
+        }
+        if (done()) {
+            break;
+        }
+
+        size_t index = m_written;
+        QByteArray data = std::move(m_bodies[index]);
+        m_bodies.erase(index);
+        const StreamFragment& fragment = m_list.fragments[index];
+        QByteArray key = fragment.key >= 0 ? m_keys[static_cast<size_t>(fragment.key)] : QByteArray();
+        QByteArray iv = fragment.iv;
+
+        // Decrypt and append outside the lock; the I/O thread keeps going
+        lock.unlock();
+        ByteCount charged = data.size();
+        bool ok = key.isEmpty() || decrypt(data, key, iv);
+        if (ok) {
+            ok = output.write(data) == data.size();
+        }
+        MemoryBudget::instance().release(charged);
+        lock.lock();
+
+        if (!ok) {
+            DownloadError error;
+            error.category = key.isEmpty() ? ErrorCategory::FileSystem : ErrorCategory::ServerError;
+            error.message = key.isEmpty()
+                                ? QStringLiteral("Write failed: %1").arg(output.errorString())
+                                : QStringLiteral("Cannot decrypt fragment %1").arg(index);
+            lock.unlock();
+            fail(error);
+            return;
+        }
+
+        ++m_written;
+        m_bytesWritten += data.size();
+
+        // The window moved; let the I/O thread start the next fragment
+        curl_multi_wakeup(m_multi);
+    }
+
+    int total = static_cast<int>(m_written);
+    ByteCount bytes = m_bytesWritten;
+    lock.unlock();
+
+    output.close();
+    m_stopping = true;
+    curl_multi_wakeup(m_multi);
+
+    QMetaObject::invokeMethod(this, [this, total, bytes]() {
+        cancel();
+        emit progress(total, total, bytes, 0.0);
+        emit finished(m_outputPath);
+    }, Qt::QueuedConnection);
+}
+
+bool FragmentDownloader::decrypt(QByteArray& data, const QByteArray& key, const QByteArray& iv) const {
+#ifdef OPENIDM_HAVE_OPENSSL
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        return false;
+    }
+
+    // AES-128-CBC with PKCS#7 padding (RFC 8216 §4.3.2.4)
+    QByteArray plain(data.size() + 16, Qt::Uninitialized);
+    int length = 0;
+    int tail = 0;
+    bool ok = EVP_DecryptInit_ex(ctx, EVP_aes_128_cbc(), nullptr,
+                                 reinterpret_cast<const unsigned char*>(key.constData()),
+                                 reinterpret_cast<const unsigned char*>(iv.constData())) == 1 &&
+              EVP_DecryptUpdate(ctx, reinterpret_cast<unsigned char*>(plain.data()), &length,
+                                reinterpret_cast<const unsigned char*>(data.constData()),
+                                static_cast<int>(data.size())) == 1 &&
+              EVP_DecryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(plain.data()) + length, &tail) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+
+    if (!ok) {
+        return false;
+    }
+    plain.truncate(length + tail);
+    data = std::move(plain);
+    return true;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(key);
+    Q_UNUSED(iv);
+    return false;
+#endif
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Callbacks
+// ═══════════════════════════════════════════════════════════════════════════════
+
+size_t FragmentDownloader::writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* transfer = static_cast<Transfer*>(userdata);
+    size_t totalSize = size * nmemb;
+
+    // Fetched fragments wait in memory for their turn; over budget, the
+    // rest stays with the server until the writer catches up
+    if (transfer->kind == Kind::Fragment && !transfer->owner->reserveBody(*transfer, totalSize)) {
+        return CURL_WRITEFUNC_PAUSE;
+    }
+    transfer->body.append(ptr, static_cast<qsizetype>(totalSize));
+    transfer->owner->m_bytesReceived += static_cast<ByteCount>(totalSize);
+    return totalSize;
+}
+
+} // namespace OpenIDM
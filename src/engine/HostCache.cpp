@@ -0,0 +1,196 @@
+/**
+ * @file HostCache.cpp
+ * @brief Implementation of the persisted capability cache
+ */
+
+#include "openidm/engine/HostCache.h"
+#include "openidm/engine/TaskRegistry.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+HostCache& HostCache::instance() {
+    static HostCache cache;
+    return cache;
+}
+
+void HostCache::attach(PersistenceManager* persistence) {
+    std::vector<HostRecord> hosts;
+    std::vector<ResourceRecord> resources;
+    if (persistence) {
+        hosts = persistence->loadHostRecords();
+        resources = persistence->loadResourceRecords();
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_persistence = persistence;
+
+    for (HostRecord& record : hosts) {
+        if (isFresh(record.updatedAt, Constants::HOST_CACHE_TTL)) {
+            QString key = record.host;
+            m_hosts.insert_or_assign(key, std::move(record));
+        }
+    }
+
+    size_t expired = 0;
+    for (ResourceRecord& record : resources) {
+        if (!isFresh(record.updatedAt, Constants::RESOURCE_CACHE_TTL)) {
+            persistence->deleteResourceRecord(record.url);
+            ++expired;
+            continue;
+        }
+        QString key = record.url;
+        m_resources.insert_or_assign(key, std::move(record));
+    }
+
+    if (persistence) {
+        qDebug() << "HostCache: Loaded" << m_hosts.size() << "hosts and" << m_resources.size()
+                 << "resources," << expired << "expired";
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Resources
+// ═══════════════════════════════════════════════════════════════════════════════
+
+std::optional<ServerCapabilities> HostCache::lookup(const QUrl& url) const {
+    QString key = TaskRegistry::normalizeUrl(url);
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_resources.find(key);
+    if (it == m_resources.end() || !isFresh(it->second.updatedAt, Constants::RESOURCE_CACHE_TTL)) {
+        return std::nullopt;
+    }
+
+    ServerCapabilities caps = it->second.capabilities;
+    caps.fromCache = true;
+
+    // Host-level knowledge may be newer than the resource entry
+    auto host = m_hosts.find(hostKey(url));
+    if (host != m_hosts.end()) {
+        caps.advertisesHttp3 = host->second.advertisesHttp3;
+    }
+    return caps;
+}
+
+void HostCache::store(const QUrl& url, const ServerCapabilities& caps) {
+    if (!caps.isValid() || caps.fromCache) {
+        return;
+    }
+
+    qint64 timestamp = now();
+
+    std::lock_guard lock(m_mutex);
+
+    HostRecord& host = m_hosts[hostKey(url)];
+    host.host = hostKey(url);
+    host.supportsRanges = caps.supportsRanges;
+    host.protocol = caps.protocol;
+    host.advertisesHttp3 = caps.advertisesHttp3;
+    host.updatedAt = timestamp;
+    saveHostLocked(host);
+
+    // Without a size and a validator a cached answer could not be trusted
+    if (caps.contentLength <= 0 || (caps.etag.isEmpty() && caps.lastModified.isEmpty())) {
+        return;
+    }
+
+    ResourceRecord record;
+    record.url = TaskRegistry::normalizeUrl(url);
+    record.capabilities = caps;
+    record.updatedAt = timestamp;
+    if (m_persistence) {
+        m_persistence->saveResourceRecord(record);
+    }
+    QString key = record.url;
+    m_resources.insert_or_assign(key, std::move(record));
+}
+
+void HostCache::invalidate(const QUrl& url) {
+    QString key = TaskRegistry::normalizeUrl(url);
+
+    std::lock_guard lock(m_mutex);
+    if (m_resources.erase(key) > 0) {
+        qDebug() << "HostCache: Invalidated" << key;
+    }
+    if (m_persistence) {
+        m_persistence->deleteResourceRecord(key);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Hosts
+// ═══════════════════════════════════════════════════════════════════════════════
+
+std::optional<HostRecord> HostCache::host(const QUrl& url) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_hosts.find(hostKey(url));
+    if (it == m_hosts.end() || !isFresh(it->second.updatedAt, Constants::HOST_CACHE_TTL)) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+size_t HostCache::learnedConnections(const QString& hostKey) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_hosts.find(hostKey.toLower());
+    if (it == m_hosts.end() || !isFresh(it->second.updatedAt, Constants::HOST_CACHE_TTL)) {
+        return 0;
+    }
+    return static_cast<size_t>(std::max(it->second.connections, 0));
+}
+
+void HostCache::rememberConnections(const QString& hostKey, size_t count) {
+    if (hostKey.isEmpty() || count == 0) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    HostRecord& host = m_hosts[hostKey.toLower()];
+    host.host = hostKey.toLower();
+    host.connections = static_cast<int>(count);
+    host.updatedAt = now();
+    saveHostLocked(host);
+}
+
+QString HostCache::hostKey(const QUrl& url) {
+    QString key = url.host().toLower();
+
+    int port = url.port();
+    int defaultPort = url.scheme() == QLatin1String("https") ? 443
+                    : url.scheme() == QLatin1String("http")  ? 80
+                                                             : -1;
+    if (port != -1 && port != defaultPort) {
+        key += QLatin1Char(':') + QString::number(port);
+    }
+    return key;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+qint64 HostCache::now() {
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+bool HostCache::isFresh(qint64 updatedAt, Duration ttl) {
+    return now() - updatedAt < ttl.count();
+}
+
+void HostCache::saveHostLocked(const HostRecord& record) {
+    // Note: Caller must hold m_mutex
+    if (m_persistence) {
+        m_persistence->saveHostRecord(record);
+    }
+}
+
+} // namespace OpenIDM
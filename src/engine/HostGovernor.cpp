@@ -0,0 +1,218 @@
+/**
+ * @file HostGovernor.cpp
+ * @brief Implementation of the per-host connection budget
+ */
+
+#include "openidm/engine/HostGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QDebug>
+#include <QRandomGenerator>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+HostGovernor& HostGovernor::instance() {
+    static HostGovernor governor;
+    return governor;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Budget
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void HostGovernor::setLimit(size_t connections) {
+    std::lock_guard lock(m_mutex);
+    m_ceiling = std::clamp<size_t>(connections, 1, Constants::MAX_HOST_CONNECTIONS);
+}
+
+size_t HostGovernor::limit() const {
+    std::lock_guard lock(m_mutex);
+    return m_ceiling;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Slots
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool HostGovernor::tryAcquire(const QString& host, Duration* retryIn) {
+    // No host to be polite to (local files, unparsable URLs)
+    if (host.isEmpty()) {
+        return true;
+    }
+
+    std::lock_guard lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    Host& state = m_hosts[host];
+
+    if (state.blockedUntil > now) {
+        if (retryIn) {
+            *retryIn = std::chrono::ceil<Duration>(state.blockedUntil - now);
+        }
+        return false;
+    }
+    if (state.active >= limitLocked(state, now)) {
+        if (retryIn) {
+            *retryIn = Duration(0);
+        }
+        return false;
+    }
+
+    ++state.active;
+    return true;
+}
+
+void HostGovernor::release(const QString& host) {
+    if (host.isEmpty()) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_hosts.find(host);
+    if (it == m_hosts.end() || it->second.active == 0) {
+        return;
+    }
+    --it->second.active;
+    pruneLocked(host);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Feedback
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void HostGovernor::reportThrottled(const QString& host, Duration retryAfter) {
+    if (host.isEmpty()) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    Host& state = m_hosts[host];
+
+    // Every connection open at the time answers 429 at once; halve only once
+    bool sameBurst = state.throttledAt != Clock::time_point{} &&
+                     now - state.throttledAt < Constants::RETRY_BACKOFF_BASE;
+    if (!sameBurst) {
+        size_t current = std::min(limitLocked(state, now), std::max<size_t>(state.active, 1));
+        state.limit = std::max<size_t>(current / 2, 1);
+        state.throttledAt = now;
+        qDebug() << "HostGovernor:" << host << "throttled, limit now" << state.limit;
+    }
+    state.cleanStreak = 0;
+
+    Duration delay = retryAfter >= Duration(0) ? std::min(retryAfter, Constants::MAX_RETRY_AFTER)
+                                               : Constants::RETRY_BACKOFF_BASE;
+    state.blockedUntil = std::max(state.blockedUntil, now + delay);
+}
+
+void HostGovernor::reportSuccess(const QString& host) {
+    if (host.isEmpty()) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_hosts.find(host);
+    if (it == m_hosts.end()) {
+        return;
+    }
+    Host& state = it->second;
+    state.failures = 0;
+
+    // Additive increase back towards the ceiling
+    if (state.limit != 0 && ++state.cleanStreak >= Constants::HOST_RECOVERY_STREAK) {
+        state.cleanStreak = 0;
+        ++state.limit;
+        if (state.limit >= m_ceiling) {
+            state.limit = 0;
+        }
+    }
+    pruneLocked(host);
+}
+
+void HostGovernor::reportFailure(const QString& host) {
+    if (host.isEmpty()) {
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    Clock::time_point now = Clock::now();
+    Host& state = m_hosts[host];
+
+    // An outage fails every open connection at once; that is one failure
+    if (state.failedAt == Clock::time_point{} || now - state.failedAt >= Constants::RETRY_BACKOFF_BASE) {
+        ++state.failures;
+        state.failedAt = now;
+    }
+}
+
+Duration HostGovernor::retryDelay(const QString& host, int attempt) const {
+    size_t level = static_cast<size_t>(std::max(attempt, 1));
+    Duration blocked{0};
+    double draw = 0.0;
+    {
+        std::lock_guard lock(m_mutex);
+        draw = m_jitter ? m_jitter->generateDouble() : QRandomGenerator::global()->generateDouble();
+        auto it = m_hosts.find(host);
+        if (it != m_hosts.end()) {
+            Clock::time_point now = Clock::now();
+            level = std::max(level, it->second.failures);
+            if (it->second.blockedUntil > now) {
+                blocked = std::chrono::ceil<Duration>(it->second.blockedUntil - now);
+            }
+        }
+    }
+
+    // Full jitter: a burst of failures spreads its retries over the window
+    double cap = static_cast<double>(Constants::RETRY_BACKOFF_BASE.count()) *
+                 std::pow(Constants::RETRY_BACKOFF_MULTIPLIER, static_cast<double>(std::min<size_t>(level, 32) - 1));
+    cap = std::min(cap, static_cast<double>(Constants::MAX_RETRY_DELAY.count()));
+    Duration jitter(static_cast<int64_t>(draw * cap));
+    return std::max(jitter, blocked);
+}
+
+void HostGovernor::seedJitter(quint32 seed) {
+    std::lock_guard lock(m_mutex);
+    m_jitter.emplace(seed);
+}
+
+std::vector<HostGovernor::HostStatus> HostGovernor::hosts() const {
+    std::lock_guard lock(m_mutex);
+    Clock::time_point now = Clock::now();
+
+    std::vector<HostStatus> result;
+    result.reserve(m_hosts.size());
+    for (const auto& [host, state] : m_hosts) {
+        Duration blocked = state.blockedUntil > now ? std::chrono::ceil<Duration>(state.blockedUntil - now)
+                                                    : Duration(0);
+        result.push_back(HostStatus{host, state.active,
+                                    state.limit == 0 ? m_ceiling : std::min(state.limit, m_ceiling), blocked});
+    }
+    return result;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+size_t HostGovernor::limitLocked(Host& host, Clock::time_point now) {
+    if (host.limit != 0 && now - host.throttledAt > Constants::HOST_THROTTLE_MEMORY) {
+        host.limit = 0;
+        host.cleanStreak = 0;
+    }
+    return host.limit == 0 ? m_ceiling : std::min(host.limit, m_ceiling);
+}
+
+void HostGovernor::pruneLocked(const QString& host) {
+    auto it = m_hosts.find(host);
+    if (it != m_hosts.end() && it->second.active == 0 && it->second.limit == 0 &&
+        it->second.failures == 0 && it->second.blockedUntil <= Clock::now()) {
+        m_hosts.erase(it);
+    }
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,306 @@
+/**
+ * @file HttpHeaderParser.cpp
+ * @brief Implementation of HttpHeaderParser - header lines without regex
+ */
+
+#include "openidm/engine/HttpHeaderParser.h"
+
+#include <QByteArray>
+#include <QUrl>
+
+#include <algorithm>
+#include <charconv>
+
+namespace OpenIDM {
+
+namespace {
+
+constexpr char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+constexpr bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+constexpr bool isWordChar(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+std::string_view trimmed(std::string_view text) {
+    while (!text.empty() && isSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+/// @return True if @p text equals the lower-case @p lower, ignoring case
+bool equalsLower(std::string_view text, std::string_view lower) {
+    if (text.size() != lower.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (toLower(text[i]) != lower[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Length plus first and last letter tell every known header apart; the
+ * switch in lookup() fails to compile if two names ever collide.
+ */
+constexpr uint32_t nameKey(std::string_view name) {
+    if (name.empty()) {
+        return 0;
+    }
+    return (static_cast<uint32_t>(name.size()) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(toLower(name.front()))) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(toLower(name.back())));
+}
+
+template <typename Int>
+bool parseInteger(std::string_view text, Int& value) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+QString toQString(std::string_view text) {
+    return QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+}
+
+/// Alt-Svc offers HTTP/3 as `h3=":443"` or a draft `h3-29=":443"`
+bool offersHttp3(std::string_view value) {
+    for (size_t pos = value.find("h3"); pos != std::string_view::npos; pos = value.find("h3", pos + 2)) {
+        if (pos > 0 && isWordChar(value[pos - 1])) {
+            continue;
+        }
+        size_t next = pos + 2;
+        if (next < value.size() && value[next] == '-') {
+            ++next;
+            while (next < value.size() && value[next] >= '0' && value[next] <= '9') {
+                ++next;
+            }
+        }
+        if (value.substr(next, 2) == "=\"") {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Append an obs-fold continuation to the header it belongs to
+void continueField(std::string_view text, HttpHeaderInfo& info) {
+    using Header = HttpHeaderParser::Header;
+    QString more = QLatin1Char(' ') + toQString(text);
+
+    // Numeric and token headers are not folded by real servers
+    switch (static_cast<Header>(info.foldHeader)) {
+        case Header::ContentType:
+            info.contentType += more;
+            break;
+        case Header::ContentDisposition: {
+            info.contentDisposition += more;
+            QByteArray value = info.contentDisposition.toUtf8();
+            info.fileName = HttpHeaderParser::fileNameFrom(
+                std::string_view(value.constData(), static_cast<size_t>(value.size())));
+            break;
+        }
+        case Header::AltSvc:
+            info.advertisesHttp3 = info.advertisesHttp3 || offersHttp3(text);
+            break;
+        case Header::Server:
+            info.server += more;
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Lines
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void HttpHeaderParser::parseLine(std::string_view line, HttpHeaderInfo& info) {
+    bool folded = !line.empty() && (line.front() == ' ' || line.front() == '\t');
+    line = trimmed(line);
+    if (line.empty()) {
+        return;
+    }
+    if (folded) {
+        continueField(line, info);
+        return;
+    }
+
+    // Each response of a redirect chain starts over
+    if (line.substr(0, 5) == "HTTP/") {
+        info = HttpHeaderInfo{};
+        size_t space = line.find(' ');
+        if (space != std::string_view::npos) {
+            std::string_view code = line.substr(space + 1, 3);
+            parseInteger(code, info.statusCode);
+        }
+        return;
+    }
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+        return;
+    }
+    std::string_view value = trimmed(line.substr(colon + 1));
+    Header header = lookup(trimmed(line.substr(0, colon)));
+    info.foldHeader = static_cast<uint8_t>(header);
+
+    switch (header) {
+        case Header::ContentLength: {
+            qint64 length = -1;
+            if (parseInteger(value, length)) {
+                info.contentLength = length;
+            }
+            break;
+        }
+        case Header::ContentType:
+            info.contentType = toQString(value);
+            break;
+        case Header::ContentRange: {
+            // "bytes 0-99/1000" or a 416's "bytes */1000"; the total is "*"
+            // when unknown. Range units are case-insensitive.
+            size_t slash = value.rfind('/');
+            qint64 total = -1;
+            if (equalsLower(value.substr(0, 6), "bytes ") && slash != std::string_view::npos &&
+                parseInteger(value.substr(slash + 1), total) && total >= 0) {
+                info.rangeTotal = total;
+            }
+            break;
+        }
+        case Header::ContentEncoding:
+            info.contentEncoded = !value.empty();
+            break;
+        case Header::ContentDisposition:
+            info.contentDisposition = toQString(value);
+            info.fileName = fileNameFrom(value);
+            break;
+        case Header::AcceptRanges:
+            info.acceptRanges = equalsLower(value, "bytes");
+            break;
+        case Header::ETag:
+            // Strong tags without their quotes; weak ones (W/"...") verbatim
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+            info.etag = toQString(value);
+            break;
+        case Header::LastModified:
+            info.lastModifiedValue = toQString(value);
+            info.lastModified = QDateTime::fromString(info.lastModifiedValue, Qt::RFC2822Date);
+            break;
+        case Header::Location:
+            info.hasLocation = true;
+            break;
+        case Header::AltSvc:
+            info.advertisesHttp3 = info.advertisesHttp3 || offersHttp3(value);
+            break;
+        case Header::Server:
+            info.server = toQString(value);
+            break;
+        case Header::RetryAfter: {
+            // Delay in seconds or an HTTP-date
+            qint64 seconds = -1;
+            if (parseInteger(value, seconds) && seconds >= 0) {
+                info.retryAfter = Duration(seconds * 1000);
+            } else {
+                QDateTime when = QDateTime::fromString(toQString(value), Qt::RFC2822Date);
+                if (when.isValid()) {
+                    info.retryAfter = Duration(std::max<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(when)));
+                }
+            }
+            break;
+        }
+        case Header::Unknown:
+            break;
+    }
+}
+
+HttpHeaderParser::Header HttpHeaderParser::lookup(std::string_view name) {
+    auto match = [name](std::string_view lower, Header header) {
+        return equalsLower(name, lower) ? header : Header::Unknown;
+    };
+
+    switch (nameKey(name)) {
+        case nameKey("content-length"):         return match("content-length", Header::ContentLength);
+        case nameKey("content-type"):           return match("content-type", Header::ContentType);
+        case nameKey("content-range"):          return match("content-range", Header::ContentRange);
+        case nameKey("content-encoding"):       return match("content-encoding", Header::ContentEncoding);
+        case nameKey("content-disposition"):    return match("content-disposition", Header::ContentDisposition);
+        case nameKey("accept-ranges"):          return match("accept-ranges", Header::AcceptRanges);
+        case nameKey("etag"):                   return match("etag", Header::ETag);
+        case nameKey("last-modified"):          return match("last-modified", Header::LastModified);
+        case nameKey("location"):               return match("location", Header::Location);
+        case nameKey("alt-svc"):                return match("alt-svc", Header::AltSvc);
+        case nameKey("server"):                 return match("server", Header::Server);
+        case nameKey("retry-after"):            return match("retry-after", Header::RetryAfter);
+        default:                                return Header::Unknown;
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Content-Disposition
+// ═══════════════════════════════════════════════════════════════════════════════
+
+QString HttpHeaderParser::fileNameFrom(std::string_view disposition) {
+    QByteArray plain;
+    QByteArray extended;
+
+    // attachment; filename="a; b.txt"; filename*=UTF-8''a%3B%20b.txt
+    size_t pos = 0;
+    while (pos < disposition.size()) {
+        size_t end = disposition.find_first_of("=;", pos);
+        std::string_view name = trimmed(disposition.substr(pos, end - pos));
+        if (end == std::string_view::npos || disposition[end] == ';') {
+            pos = (end == std::string_view::npos) ? disposition.size() : end + 1;
+            continue;
+        }
+
+        // The value is a token or a quoted string that may contain ';'
+        QByteArray value;
+        size_t cursor = end + 1;
+        while (cursor < disposition.size() && isSpace(disposition[cursor])) {
+            ++cursor;
+        }
+        if (cursor < disposition.size() && disposition[cursor] == '"') {
+            for (++cursor; cursor < disposition.size() && disposition[cursor] != '"'; ++cursor) {
+                if (disposition[cursor] == '\\' && cursor + 1 < disposition.size()) {
+                    ++cursor;
+                }
+                value.append(disposition[cursor]);
+            }
+            cursor = disposition.find(';', cursor);
+        } else {
+            size_t stop = disposition.find(';', cursor);
+            std::string_view token = trimmed(disposition.substr(cursor, stop - cursor));
+            value = QByteArray(token.data(), static_cast<qsizetype>(token.size()));
+            cursor = stop;
+        }
+        pos = (cursor == std::string_view::npos) ? disposition.size() : cursor + 1;
+
+        if (equalsLower(name, "filename*")) {
+            // charset'language'percent-encoded
+            qsizetype quote = value.indexOf('\'');
+            qsizetype second = quote >= 0 ? value.indexOf('\'', quote + 1) : -1;
+            extended = second >= 0 ? value.mid(second + 1) : value;
+        } else if (equalsLower(name, "filename")) {
+            plain = value;
+        }
+    }
+
+    const QByteArray& chosen = extended.isEmpty() ? plain : extended;
+    return chosen.isEmpty() ? QString() : QUrl::fromPercentEncoding(chosen).trimmed();
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,147 @@
+/**
+ * @file LinkList.cpp
+ * @brief Implementation of the link list reader
+ */
+
+#include "openidm/engine/LinkList.h"
+
+#include <QString>
+
+namespace OpenIDM {
+
+namespace {
+
+/// Longest line read at once; longer ones are split, a URL is never that long
+constexpr qint64 MAX_LINE = 64 * 1024;
+
+/// @return @p text as a URL if it is one the engine can download
+bool toDownloadUrl(QStringView text, QUrl& url) {
+    text = text.trimmed();
+    if (text.isEmpty()) {
+        return false;
+    }
+    url = QUrl(text.toString(), QUrl::StrictMode);
+    if (!url.isValid() || url.host().isEmpty()) {
+        return false;
+    }
+    QString scheme = url.scheme().toLower();
+    return scheme == QLatin1String("http") || scheme == QLatin1String("https") ||
+           scheme == QLatin1String("ftp") || scheme == QLatin1String("ftps");
+}
+
+/// @return True if @p line had at least one href attribute
+bool extractHrefs(QStringView line, QList<QUrl>& out) {
+    bool found = false;
+    qsizetype pos = 0;
+    while ((pos = line.indexOf(QLatin1String("href"), pos, Qt::CaseInsensitive)) >= 0) {
+        pos += 4;
+        while (pos < line.size() && line[pos].isSpace()) ++pos;
+        if (pos >= line.size() || line[pos] != QLatin1Char('=')) {
+            continue;
+        }
+        ++pos;
+        while (pos < line.size() && line[pos].isSpace()) ++pos;
+        if (pos >= line.size()) {
+            break;
+        }
+
+        qsizetype end;
+        QChar quote = line[pos];
+        if (quote == QLatin1Char('"') || quote == QLatin1Char('\'')) {
+            end = line.indexOf(quote, ++pos);
+            if (end < 0) {
+                break;
+            }
+        } else {
+            end = pos;
+            while (end < line.size() && !line[end].isSpace() && line[end] != QLatin1Char('>')) ++end;
+        }
+
+        found = true;
+        QString value = line.mid(pos, end - pos).toString();
+        value.replace(QLatin1String("&amp;"), QLatin1String("&"));
+        QUrl url;
+        if (toDownloadUrl(value, url)) {
+            out.append(url);
+        }
+        pos = end;
+    }
+    return found;
+}
+
+/// @return First comma or tab separated field of @p line that is a URL
+bool extractField(QStringView line, QUrl& url) {
+    QChar separator = line.contains(QLatin1Char('\t')) ? QLatin1Char('\t') : QLatin1Char(',');
+    QString field;
+    bool quoted = false;
+
+    for (qsizetype i = 0; i <= line.size(); ++i) {
+        if (i == line.size() || (!quoted && line[i] == separator)) {
+            if (toDownloadUrl(field, url)) {
+                return true;
+            }
+            field.clear();
+        } else if (line[i] == QLatin1Char('"')) {
+            // "" inside a quoted field is a literal quote
+            if (quoted && i + 1 < line.size() && line[i + 1] == QLatin1Char('"')) {
+                field += QLatin1Char('"');
+                ++i;
+            } else {
+                quoted = !quoted;
+            }
+        } else {
+            field += line[i];
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Parsing
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void extractLinks(QStringView line, QList<QUrl>& out) {
+    line = line.trimmed();
+    if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+        return;
+    }
+
+    if (extractHrefs(line, out)) {
+        return;
+    }
+
+    QUrl url;
+    bool separated = line.contains(QLatin1Char(',')) || line.contains(QLatin1Char('\t'));
+    if (separated ? extractField(line, url) : toDownloadUrl(line, url)) {
+        out.append(url);
+    }
+}
+
+qint64 readLinkList(QIODevice& device, const std::function<void(const QUrl&)>& sink,
+                    const std::atomic<bool>* cancelled) {
+    qint64 lines = 0;
+    QList<QUrl> found;
+
+    while (!device.atEnd()) {
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        QString line = QString::fromUtf8(device.readLine(MAX_LINE));
+        if (lines++ == 0 && line.startsWith(QChar(0xFEFF))) {
+            line.remove(0, 1);
+        }
+
+        found.clear();
+        extractLinks(line, found);
+        for (const QUrl& url : found) {
+            sink(url);
+        }
+    }
+
+    return lines;
+}
+
+} // namespace OpenIDM
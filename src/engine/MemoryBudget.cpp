@@ -0,0 +1,108 @@
+/**
+ * @file MemoryBudget.cpp
+ * @brief Implementation of the engine-wide buffer budget
+ */
+
+#include "openidm/engine/MemoryBudget.h"
+
+#include <utility>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+MemoryBudget& MemoryBudget::instance() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Limit
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void MemoryBudget::setLimit(ByteCount bytes) {
+    m_limit.store(bytes, std::memory_order_relaxed);
+    wake();  // A raised cap may fit a parked transfer
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Reservations
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool MemoryBudget::tryReserve(ByteCount bytes) {
+    ByteCount used = m_used.load(std::memory_order_relaxed);
+    do {
+        if (used + bytes > m_limit.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    } while (!m_used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+    notePeak(used + bytes);
+    return true;
+}
+
+void MemoryBudget::reserve(ByteCount bytes) {
+    notePeak(m_used.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryBudget::release(ByteCount bytes) {
+    if (bytes <= 0) {
+        return;
+    }
+    m_used.fetch_sub(bytes, std::memory_order_relaxed);
+    wake();
+}
+
+bool MemoryBudget::hasRoom(ByteCount bytes) const {
+    return m_used.load(std::memory_order_relaxed) + bytes <= m_limit.load(std::memory_order_relaxed);
+}
+
+bool MemoryBudget::park(ByteCount bytes, Waker waker) {
+    {
+        // Checked under the lock that wake() takes, so a release between the
+        // caller's failed reservation and this call is not missed
+        std::lock_guard lock(m_mutex);
+        if (!hasRoom(bytes)) {
+            m_wakers.push_back(std::move(waker));
+            m_pauses.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MemoryBudget::wait(ByteCount bytes, Duration timeout) {
+    std::unique_lock lock(m_mutex);
+    if (!hasRoom(bytes)) {
+        m_pauses.fetch_add(1, std::memory_order_relaxed);
+        m_released.wait_for(lock, timeout);
+    }
+    return hasRoom(bytes);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void MemoryBudget::notePeak(ByteCount used) {
+    ByteCount peak = m_peak.load(std::memory_order_relaxed);
+    while (used > peak && !m_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+}
+
+void MemoryBudget::wake() {
+    std::vector<Waker> wakers;
+    {
+        std::lock_guard lock(m_mutex);
+        wakers.swap(m_wakers);
+    }
+    m_released.notify_all();
+
+    // Each retries its reservation and parks again if it still does not fit
+    for (Waker& waker : wakers) {
+        waker();
+    }
+}
+
+} // namespace OpenIDM
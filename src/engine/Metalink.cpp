@@ -0,0 +1,127 @@
+/**
+ * @file Metalink.cpp
+ * @brief Implementation of the Metalink parser
+ */
+
+#include "openidm/engine/Metalink.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+namespace {
+
+struct RankedUrl {
+    QUrl url;
+    int rank;                   ///< Lower is preferred
+};
+
+/// @return True if @p name stays inside the destination directory (RFC 5854 §4.1.2.1)
+bool isSafeName(const QString& name) {
+    QString cleaned = QDir::cleanPath(name);
+    return !cleaned.isEmpty() && !QDir::isAbsolutePath(cleaned) &&
+           cleaned != QLatin1String("..") && !cleaned.startsWith(QLatin1String("../")) &&
+           !cleaned.contains(QLatin1Char('\\'));
+}
+
+/// @return Rank of a digest algorithm; the strongest one listed is kept
+int hashStrength(HashAlgorithm algorithm) {
+    switch (algorithm) {
+        case HashAlgorithm::Sha512: return 4;
+        case HashAlgorithm::Sha256: return 3;
+        case HashAlgorithm::Sha1:   return 2;
+        case HashAlgorithm::Md5:    return 1;
+        default:                    return 0;
+    }
+}
+
+} // namespace
+
+std::vector<MetalinkFile> parseMetalink(const QByteArray& document) {
+    std::vector<MetalinkFile> files;
+
+    QXmlStreamReader xml(document);
+    MetalinkFile current;
+    std::vector<RankedUrl> urls;
+    bool inFile = false;
+    int piecesDepth = 0;        ///< Inside <pieces>: per-piece hashes, not the file's
+
+    while (!xml.atEnd()) {
+        xml.readNext();
+
+        if (xml.isStartElement()) {
+            QStringView element = xml.name();
+
+            if (element == QLatin1String("file")) {
+                current = MetalinkFile{};
+                current.name = xml.attributes().value(QLatin1String("name")).toString().trimmed();
+                urls.clear();
+                inFile = true;
+            } else if (!inFile) {
+                continue;
+            } else if (element == QLatin1String("pieces")) {
+                ++piecesDepth;
+            } else if (element == QLatin1String("size")) {
+                bool ok = false;
+                ByteCount size = xml.readElementText().trimmed().toLongLong(&ok);
+                current.size = ok ? size : -1;
+            } else if (element == QLatin1String("hash") && piecesDepth == 0) {
+                QString type = xml.attributes().value(QLatin1String("type")).toString();
+                ExpectedHash hash = ExpectedHash::fromString(type + QLatin1Char(':') +
+                                                             xml.readElementText().trimmed());
+                if (hash.isValid() && hashStrength(hash.algorithm) > hashStrength(current.hash.algorithm)) {
+                    current.hash = hash;
+                }
+            } else if (element == QLatin1String("url")) {
+                QXmlStreamAttributes attributes = xml.attributes();
+
+                // v4 "priority" 1..999999, lower first; v3 "preference" 0..100, higher first
+                int rank = 999999;
+                if (attributes.hasAttribute(QLatin1String("priority"))) {
+                    rank = attributes.value(QLatin1String("priority")).toInt();
+                } else if (attributes.hasAttribute(QLatin1String("preference"))) {
+                    rank = 100 - attributes.value(QLatin1String("preference")).toInt();
+                }
+
+                QUrl url(xml.readElementText().trimmed());
+                QString scheme = url.scheme().toLower();
+                if (url.isValid() && (scheme == QLatin1String("http") || scheme == QLatin1String("https"))) {
+                    urls.push_back({url, rank});
+                }
+            }
+        } else if (xml.isEndElement()) {
+            QStringView element = xml.name();
+
+            if (element == QLatin1String("pieces")) {
+                piecesDepth = std::max(piecesDepth - 1, 0);
+            } else if (element == QLatin1String("file") && inFile) {
+                inFile = false;
+
+                std::stable_sort(urls.begin(), urls.end(),
+                                 [](const RankedUrl& a, const RankedUrl& b) { return a.rank < b.rank; });
+                for (const RankedUrl& ranked : urls) {
+                    current.urls.push_back(ranked.url);
+                }
+
+                if (!current.name.isEmpty() && !isSafeName(current.name)) {
+                    qWarning() << "Metalink: Skipping unsafe file name" << current.name;
+                } else if (current.isValid()) {
+                    files.push_back(std::move(current));
+                }
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        qWarning() << "Metalink: Invalid document:" << xml.errorString();
+        return {};
+    }
+
+    return files;
+}
+
+} // namespace OpenIDM
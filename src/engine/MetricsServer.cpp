@@ -0,0 +1,178 @@
+/**
+ * @file MetricsServer.cpp
+ * @brief Implementation of MetricsServer - /metrics over HTTP/1.1
+ */
+
+#include "openidm/engine/MetricsServer.h"
+#include "openidm/engine/EngineMetrics.h"
+
+#include <QDebug>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVariant>
+
+#include <memory>
+
+namespace OpenIDM {
+
+namespace {
+
+/// Larger request heads are not a scraper's; the connection is dropped
+constexpr qsizetype MAX_REQUEST = 8 * 1024;
+
+/// Idle connections are closed after this long
+constexpr int REQUEST_TIMEOUT_MS = 10000;
+
+QByteArray response(int status, const QByteArray& reason, const QByteArray& contentType,
+                    const QByteArray& body) {
+    QByteArray out = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n";
+    out += "Content-Type: " + contentType + "\r\n";
+    out += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    out += "Connection: close\r\n\r\n";
+    out += body;
+    return out;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Listener (server thread)
+// ═══════════════════════════════════════════════════════════════════════════════
+
+class MetricsListener : public QObject {
+public:
+    bool listen(quint16 port, bool anyInterface, quint16& bound);
+    void close();
+
+private:
+    void accept();
+    void handle(QTcpSocket* socket);
+
+    std::unique_ptr<QTcpServer> m_server;
+};
+
+bool MetricsListener::listen(quint16 port, bool anyInterface, quint16& bound) {
+    close();
+
+    m_server = std::make_unique<QTcpServer>();
+    QHostAddress address = anyInterface ? QHostAddress(QHostAddress::Any) : QHostAddress(QHostAddress::LocalHost);
+    if (!m_server->listen(address, port)) {
+        qWarning() << "MetricsServer: Failed to listen on port" << port << ":" << m_server->errorString();
+        m_server.reset();
+        return false;
+    }
+    bound = m_server->serverPort();
+    QObject::connect(m_server.get(), &QTcpServer::newConnection, this, [this]() { accept(); });
+    return true;
+}
+
+void MetricsListener::close() {
+    if (m_server) {
+        m_server->close();
+        m_server.reset();
+    }
+    // Pending sockets are children of the server and went with it; accepted
+    // ones are children of this object
+    for (QTcpSocket* socket : findChildren<QTcpSocket*>(Qt::FindDirectChildrenOnly)) {
+        socket->abort();
+        delete socket;
+    }
+}
+
+void MetricsListener::accept() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        socket->setParent(this);
+
+        auto* timeout = new QTimer(socket);
+        timeout->setSingleShot(true);
+        QObject::connect(timeout, &QTimer::timeout, socket, &QTcpSocket::abort);
+        timeout->start(REQUEST_TIMEOUT_MS);
+
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handle(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void MetricsListener::handle(QTcpSocket* socket) {
+    // Only the request line matters; wait for the whole head, then answer once
+    if (socket->property("answered").toBool()) {
+        socket->readAll();
+        return;
+    }
+    QByteArray input = socket->property("input").toByteArray() + socket->readAll();
+    qsizetype headerEnd = input.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (input.size() > MAX_REQUEST) {
+            socket->abort();
+        } else {
+            socket->setProperty("input", input);
+        }
+        return;
+    }
+    socket->setProperty("answered", true);
+    socket->setProperty("input", QVariant());
+
+    const QList<QByteArray> requestLine = input.left(input.indexOf("\r\n")).split(' ');
+    QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+    path = path.left(path.indexOf('?') >= 0 ? path.indexOf('?') : path.size());
+
+    QByteArray reply;
+    if (method != "GET" && method != "HEAD") {
+        reply = response(405, "Method Not Allowed", "text/plain", "GET only\n");
+    } else if (path != "/metrics") {
+        reply = response(404, "Not Found", "text/plain", "Try /metrics\n");
+    } else {
+        reply = response(200, "OK", "text/plain; version=0.0.4; charset=utf-8", EngineMetrics::instance().render());
+        if (method == "HEAD") {
+            reply.truncate(reply.indexOf("\r\n\r\n") + 4);
+        }
+    }
+    socket->write(reply);
+    socket->disconnectFromHost();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// MetricsServer
+// ═══════════════════════════════════════════════════════════════════════════════
+
+MetricsServer::MetricsServer(QObject* parent)
+    : QObject(parent)
+{
+    m_thread.setObjectName(QStringLiteral("MetricsServer"));
+    m_thread.start();
+    m_listener = new MetricsListener;
+    m_listener->moveToThread(&m_thread);
+}
+
+MetricsServer::~MetricsServer() {
+    MetricsListener* listener = m_listener;
+    QMetaObject::invokeMethod(listener, [listener]() {
+        listener->close();
+        delete listener;
+    }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+bool MetricsServer::start(quint16 port, bool anyInterface) {
+    bool ok = false;
+    quint16 bound = 0;
+    QMetaObject::invokeMethod(m_listener, [this, port, anyInterface, &ok, &bound]() {
+        ok = m_listener->listen(port, anyInterface, bound);
+    }, Qt::BlockingQueuedConnection);
+    m_port = ok ? bound : 0;
+    if (ok) {
+        qDebug() << "MetricsServer: Serving /metrics on port" << m_port;
+    }
+    return ok;
+}
+
+void MetricsServer::stop() {
+    QMetaObject::invokeMethod(m_listener, [this]() { m_listener->close(); }, Qt::BlockingQueuedConnection);
+    m_port = 0;
+}
+
+} // namespace OpenIDM
@@ -4,9 +4,10 @@
  */
 
 #include "openidm/engine/NetworkProbe.h"
+#include "openidm/engine/HttpHeaderParser.h"
+#include "engine/CurlWrapper.h"
 #include <curl/curl.h>
 #include <QDebug>
-#include <QRegularExpression>
 #include <QtConcurrent>
 
 namespace OpenIDM {
@@ -32,7 +33,7 @@ void NetworkProbe::probe(const QUrl& url) {
     m_probing = true;
     m_cancelled = false;
     m_capabilities = ServerCapabilities{};
-    m_rawHeaders.clear();
+    m_headers = HttpHeaderInfo{};
     
     // Run probe in background thread
     QtConcurrent::run([this, url]() {
@@ -48,6 +49,8 @@ void NetworkProbe::performProbe(const QUrl& url) {
     qDebug() << "NetworkProbe: Probing" << url.toString();
     
     // Initialize curl
+    CurlGlobalInit& curlGlobal = CurlGlobalInit::instance();
+    
     m_curl = curl_easy_init();
     if (!m_curl) {
         DownloadError error;
@@ -61,6 +64,10 @@ void NetworkProbe::performProbe(const QUrl& url) {
         return;
     }
     
+    // The probe's DNS entry, TLS session and connection are reused by the
+    // segment workers that follow it
+    curlGlobal.share().attach(m_curl);
+    
     QByteArray urlBytes = url.toString().toUtf8();
     
     // Configure curl for HEAD request
@@ -70,6 +77,9 @@ void NetworkProbe::performProbe(const QUrl& url) {
     curl_easy_setopt(m_curl, CURLOPT_MAXREDIRS, 10L);
     curl_easy_setopt(m_curl, CURLOPT_NOSIGNAL, 1L);
     
+    // Offer HTTP/2 over TLS so the planner can multiplex segments
+    curl_easy_setopt(m_curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    
     // Timeouts
     curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT, 30L);
     curl_easy_setopt(m_curl, CURLOPT_TIMEOUT, 60L);
@@ -115,25 +125,8 @@ void NetworkProbe::performProbe(const QUrl& url) {
         return;
     }
     
-    // Get HTTP response code
-    long httpCode = 0;
-    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpCode);
-    m_capabilities.httpStatusCode = static_cast<int>(httpCode);
-    
-    // Get content length
-    curl_off_t contentLength = -1;
-    curl_easy_getinfo(m_curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
-    m_capabilities.contentLength = contentLength;
-    
-    // Get content type
-    char* contentType = nullptr;
-    curl_easy_getinfo(m_curl, CURLINFO_CONTENT_TYPE, &contentType);
-    if (contentType) {
-        m_capabilities.contentType = QString::fromUtf8(contentType);
-    }
-    
-    // Parse headers for additional info
-    parseHeaders();
+    m_capabilities = readCapabilities(m_curl, m_headers);
+    long httpCode = m_capabilities.httpStatusCode;
     
     curl_easy_cleanup(m_curl);
     m_curl = nullptr;
@@ -154,7 +147,8 @@ void NetworkProbe::performProbe(const QUrl& url) {
     
     qDebug() << "NetworkProbe: Completed. Size:" << m_capabilities.contentLength
              << "Ranges:" << m_capabilities.supportsRanges
-             << "Type:" << m_capabilities.contentType;
+             << "Type:" << m_capabilities.contentType
+             << "Protocol:" << httpProtocolToString(m_capabilities.protocol);
     
     ServerCapabilities caps = m_capabilities;
     QMetaObject::invokeMethod(this, [this, caps]() {
@@ -163,75 +157,69 @@ void NetworkProbe::performProbe(const QUrl& url) {
     }, Qt::QueuedConnection);
 }
 
-void NetworkProbe::parseHeaders() {
-    // Parse Accept-Ranges
-    static QRegularExpression acceptRangesRegex(
-        QStringLiteral("Accept-Ranges:\\s*(bytes|none)", QStringLiteral("i").at(0)),
-        QRegularExpression::CaseInsensitiveOption
-    );
-    
-    auto match = acceptRangesRegex.match(m_rawHeaders);
-    if (match.hasMatch()) {
-        m_capabilities.supportsRanges = (match.captured(1).toLower() == QStringLiteral("bytes"));
-    }
+ServerCapabilities NetworkProbe::readCapabilities(CURL* curl, const HttpHeaderInfo& headers) {
+    ServerCapabilities caps;
     
-    // Parse Content-Disposition for filename
-    static QRegularExpression contentDispositionRegex(
-        QStringLiteral("Content-Disposition:.*filename\\*?=['\"]?([^'\"\\r\\n;]+)"),
-        QRegularExpression::CaseInsensitiveOption
-    );
-    
-    match = contentDispositionRegex.match(m_rawHeaders);
-    if (match.hasMatch()) {
-        QString filename = match.captured(1).trimmed();
-        // Handle URL encoding
-        filename = QUrl::fromPercentEncoding(filename.toUtf8());
-        // Remove quotes if present
-        if (filename.startsWith('"') && filename.endsWith('"')) {
-            filename = filename.mid(1, filename.length() - 2);
-        }
-        m_capabilities.fileName = filename;
-    }
+    // Get HTTP response code
+    long httpCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    caps.httpStatusCode = static_cast<int>(httpCode);
     
-    // Parse ETag
-    static QRegularExpression etagRegex(
-        QStringLiteral("ETag:\\s*\"?([^\"\\r\\n]+)\"?"),
-        QRegularExpression::CaseInsensitiveOption
-    );
+    // Get content length
+    curl_off_t contentLength = -1;
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+    caps.contentLength = contentLength;
     
-    match = etagRegex.match(m_rawHeaders);
-    if (match.hasMatch()) {
-        m_capabilities.etag = match.captured(1).trimmed();
+    // Get content type
+    char* contentType = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentType);
+    if (contentType) {
+        caps.contentType = QString::fromUtf8(contentType);
     }
     
-    // Parse Last-Modified
-    static QRegularExpression lastModifiedRegex(
-        QStringLiteral("Last-Modified:\\s*([^\\r\\n]+)"),
-        QRegularExpression::CaseInsensitiveOption
-    );
-    
-    match = lastModifiedRegex.match(m_rawHeaders);
-    if (match.hasMatch()) {
-        m_capabilities.lastModified = match.captured(1).trimmed();
+    // Record the negotiated protocol
+    long httpVersion = CURL_HTTP_VERSION_NONE;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &httpVersion);
+    switch (httpVersion) {
+        case CURL_HTTP_VERSION_1_0:
+        case CURL_HTTP_VERSION_1_1:
+            caps.protocol = HttpProtocol::Http1;
+            break;
+        case CURL_HTTP_VERSION_2_0:
+            caps.protocol = HttpProtocol::Http2;
+            break;
+#if LIBCURL_VERSION_NUM >= 0x074200  // 7.66.0
+        case CURL_HTTP_VERSION_3:
+            caps.protocol = HttpProtocol::Http3;
+            break;
+#endif
+        default:
+            caps.protocol = HttpProtocol::Unknown;
+            break;
     }
     
-    // Parse Content-Encoding
-    static QRegularExpression contentEncodingRegex(
-        QStringLiteral("Content-Encoding:\\s*([^\\r\\n]+)"),
-        QRegularExpression::CaseInsensitiveOption
-    );
-    
-    match = contentEncodingRegex.match(m_rawHeaders);
-    if (match.hasMatch()) {
-        m_capabilities.supportsCompression = true;
+    // Fields curl does not report, already parsed per line
+    caps.supportsRanges = headers.acceptRanges;
+    caps.supportsCompression = headers.contentEncoded;
+    caps.fileName = headers.fileName;
+    caps.etag = headers.etag;
+    caps.lastModified = headers.lastModifiedValue;
+    caps.advertisesHttp3 = headers.advertisesHttp3;
+    
+    // A 206 carries the total size (bytes 0-99/1000) and proves range support
+    if (headers.rangeTotal >= 0) {
+        caps.supportsRanges = true;
+        caps.contentLength = headers.rangeTotal;
     }
+    
+    return caps;
 }
 
 size_t NetworkProbe::headerCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
     auto* probe = static_cast<NetworkProbe*>(userdata);
     size_t totalSize = size * nitems;
     
-    probe->m_rawHeaders += QString::fromUtf8(buffer, totalSize);
+    HttpHeaderParser::parseLine(std::string_view(buffer, totalSize), probe->m_headers);
     
     return totalSize;
 }
@@ -0,0 +1,338 @@
+/**
+ * @file OutputFile.cpp
+ * @brief Implementation of OutputFile - preallocated positional-write file
+ */
+
+#include "openidm/engine/OutputFile.h"
+#include "platform/FileIo.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+OutputFile::OutputFile(QString finalPath)
+    : m_finalPath(std::move(finalPath))
+{
+}
+
+OutputFile::~OutputFile() {
+    close();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Lifecycle
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool OutputFile::open() {
+    if (isOpen()) {
+        return true;
+    }
+
+    m_failed.store(false, std::memory_order_release);
+
+    QDir().mkpath(QFileInfo(m_finalPath).path());
+    QString path = QDir::toNativeSeparators(partialPath());
+
+#ifdef Q_OS_WIN
+    HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(path.utf16()),
+                                GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ,
+                                nullptr,
+                                OPEN_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,  // IOCP-capable
+                                nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        setSystemError("open");
+        return false;
+    }
+    m_handle = handle;
+#else
+    m_fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        setSystemError("open");
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+bool OutputFile::preallocate(ByteCount size) {
+    if (!isOpen() || size <= 0) {
+        return false;
+    }
+
+#if defined(Q_OS_WIN)
+    LARGE_INTEGER current;
+    if (GetFileSizeEx(m_handle, &current) && current.QuadPart >= size) {
+        return true;  // Resuming into an already reserved file
+    }
+
+    LARGE_INTEGER target;
+    target.QuadPart = size;
+    if (!SetFilePointerEx(m_handle, target, nullptr, FILE_BEGIN) || !SetEndOfFile(m_handle)) {
+        setSystemError("preallocate");
+        return false;
+    }
+
+    // Skips lazy zero-filling on NTFS. Only succeeds when the process holds
+    // SE_MANAGE_VOLUME_NAME; failure is harmless.
+    SetFileValidData(m_handle, size);
+    return true;
+#else
+    struct stat st {};
+    if (::fstat(m_fd, &st) == 0 && st.st_size >= size) {
+        return true;  // Resuming into an already reserved file
+    }
+
+#if defined(Q_OS_MACOS)
+    fstore_t store{};
+    store.fst_flags = F_ALLOCATECONTIG;
+    store.fst_posmode = F_PEOFPOSMODE;
+    store.fst_offset = 0;
+    store.fst_length = size - st.st_size;
+    if (::fcntl(m_fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        ::fcntl(m_fd, F_PREALLOCATE, &store);  // Best effort
+    }
+#elif defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+    int rc = ::posix_fallocate(m_fd, 0, size);
+    if (rc == 0) {
+        return true;
+    }
+    if (rc == ENOSPC) {
+        errno = rc;
+        setSystemError("preallocate");
+        return false;
+    }
+    // EOPNOTSUPP / EINVAL: filesystem cannot preallocate, extend instead
+#endif
+
+    if (::ftruncate(m_fd, size) != 0) {
+        setSystemError("preallocate");
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool OutputFile::enableDirectIo() {
+#if defined(Q_OS_LINUX) && defined(O_DIRECT)
+    if (!isOpen()) {
+        return false;
+    }
+    if (m_directFd >= 0) {
+        return true;
+    }
+
+    QString path = QDir::toNativeSeparators(partialPath());
+    m_directFd = ::open(QFile::encodeName(path).constData(), O_WRONLY | O_DIRECT | O_CLOEXEC);
+    if (m_directFd < 0) {
+        qDebug() << "OutputFile: O_DIRECT not available for" << path << std::strerror(errno);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool OutputFile::writeAt(ByteOffset offset, const char* data, size_t length) {
+    if (!isOpen()) {
+        return false;
+    }
+
+#ifdef Q_OS_WIN
+    // The handle is overlapped, so wait on a per-thread event. Setting the
+    // low bit keeps this write's completion out of the DiskWriter's port.
+    thread_local HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    while (length > 0) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        overlapped.hEvent = reinterpret_cast<HANDLE>(reinterpret_cast<uintptr_t>(event) | 1);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(length, 0x7FFFFFFF));
+        DWORD written = 0;
+        BOOL ok = WriteFile(m_handle, data, chunk, nullptr, &overlapped);
+        if (ok || GetLastError() == ERROR_IO_PENDING) {
+            ok = GetOverlappedResult(m_handle, &overlapped, &written, TRUE);
+        }
+        if (!ok || written == 0) {
+            setSystemError("write");
+            m_failed.store(true, std::memory_order_release);
+            return false;
+        }
+
+        data += written;
+        offset += written;
+        length -= written;
+    }
+#else
+    int fd = static_cast<int>(writeHandle(offset, data, length));
+
+    while (length > 0) {
+        ssize_t written = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            setSystemError("write");
+            m_failed.store(true, std::memory_order_release);
+            return false;
+        }
+
+        data += written;
+        offset += written;
+        length -= static_cast<size_t>(written);
+    }
+#endif
+
+    return true;
+}
+
+bool OutputFile::completeWrite(ByteOffset offset, const char* data, size_t length, int64_t result) {
+    if (result == static_cast<int64_t>(length)) {
+        return true;
+    }
+
+    if (result < 0) {
+#ifdef Q_OS_WIN
+        SetLastError(static_cast<DWORD>(-result));
+#else
+        errno = static_cast<int>(-result);
+#endif
+        setSystemError("write");
+        m_failed.store(true, std::memory_order_release);
+        return false;
+    }
+
+    // Short write: finish the remainder synchronously
+    auto done = static_cast<size_t>(result);
+    return writeAt(offset + static_cast<ByteOffset>(done), data + done, length - done);
+}
+
+bool OutputFile::sync() {
+    if (!isOpen()) {
+        return false;
+    }
+
+#ifdef Q_OS_WIN
+    if (!FlushFileBuffers(m_handle)) {
+        setSystemError("FlushFileBuffers");
+        return false;
+    }
+#else
+    if (::fsync(m_fd) != 0) {
+        setSystemError("fsync");
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool OutputFile::seal() {
+    if (!isOpen()) {
+        return false;
+    }
+
+    bool synced = sync();
+    close();
+    return synced;
+}
+
+bool OutputFile::finalize() {
+    if (isOpen() && !seal()) {
+        return false;
+    }
+
+    // A rename that replaces the target in one step; the bytes are only
+    // copied (reflinked where possible) if the two are on different volumes
+    return FileIo::moveFile(partialPath(), m_finalPath, &m_errorString);
+}
+
+void OutputFile::close() {
+#ifdef Q_OS_WIN
+    if (m_handle) {
+        CloseHandle(m_handle);
+        m_handle = nullptr;
+    }
+#else
+    if (m_directFd >= 0) {
+        ::close(m_directFd);
+        m_directFd = -1;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+}
+
+void OutputFile::discard() {
+    close();
+    QFile::remove(partialPath());
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Accessors
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool OutputFile::isOpen() const {
+#ifdef Q_OS_WIN
+    return m_handle != nullptr;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+qintptr OutputFile::writeHandle(ByteOffset offset, const char* data, size_t length) const {
+#ifdef Q_OS_WIN
+    Q_UNUSED(offset);
+    Q_UNUSED(data);
+    Q_UNUSED(length);
+    return reinterpret_cast<qintptr>(m_handle);
+#else
+    // O_DIRECT requires block-aligned offset, length and memory
+    constexpr auto ALIGN = Constants::DIRECT_IO_ALIGNMENT;
+    bool aligned = m_directFd >= 0 &&
+                   static_cast<size_t>(offset) % ALIGN == 0 &&
+                   length % ALIGN == 0 &&
+                   reinterpret_cast<uintptr_t>(data) % ALIGN == 0;
+    return aligned ? m_directFd : m_fd;
+#endif
+}
+
+void OutputFile::setSystemError(const char* operation) {
+#ifdef Q_OS_WIN
+    m_errorString = QStringLiteral("%1 failed: Windows error %2")
+                        .arg(QLatin1String(operation))
+                        .arg(GetLastError());
+#else
+    m_errorString = QStringLiteral("%1 failed: %2")
+                        .arg(QLatin1String(operation), QString::fromLocal8Bit(std::strerror(errno)));
+#endif
+    qWarning() << "OutputFile:" << partialPath() << m_errorString;
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,315 @@
+/**
+ * @file ProbePipeline.cpp
+ * @brief Implementation of ProbePipeline - bulk probes over one multi handle
+ */
+
+#include "openidm/engine/ProbePipeline.h"
+#include "openidm/engine/HostCache.h"
+#include "openidm/engine/NetworkProbe.h"
+#include "openidm/engine/HttpHeaderParser.h"
+#include "engine/CurlWrapper.h"
+
+#include <curl/curl.h>
+
+#include <QDebug>
+#include <QMetaObject>
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+ProbePipeline::ProbePipeline(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ProbePipeline::~ProbePipeline() {
+    m_running = false;
+    if (m_multi) {
+        curl_multi_wakeup(m_multi);
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_multi) {
+        curl_multi_cleanup(m_multi);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Requests
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ProbePipeline::enqueue(std::vector<Request> requests) {
+    if (requests.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        for (Request& request : requests) {
+            QString host = HostCache::hostKey(request.url);
+            m_pendingByHost[host].push_back(std::move(request));
+        }
+        m_pendingCount += requests.size();
+
+        if (!m_running.exchange(true)) {
+            CurlGlobalInit::instance();
+            m_multi = curl_multi_init();
+
+            // HEADs to one HTTP/2 host share a connection
+            curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+            m_thread = std::thread([this]() { run(); });
+        }
+    }
+
+    curl_multi_wakeup(m_multi);
+}
+
+void ProbePipeline::cancel(const TaskId& id) {
+    std::lock_guard lock(m_mutex);
+    for (auto it = m_pendingByHost.begin(); it != m_pendingByHost.end(); ++it) {
+        auto& queue = it->second;
+        auto found = std::find_if(queue.begin(), queue.end(),
+                                  [&id](const Request& request) { return request.id == id; });
+        if (found == queue.end()) {
+            continue;
+        }
+
+        queue.erase(found);
+        --m_pendingCount;
+        if (queue.empty()) {
+            m_pendingByHost.erase(it);
+        }
+        return;
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Probe Thread
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ProbePipeline::run() {
+    while (m_running) {
+        std::vector<Result> results;
+        startTransfers(results);
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        int pending = 0;
+        while (CURLMsg* msg = curl_multi_info_read(m_multi, &pending)) {
+            if (msg->msg == CURLMSG_DONE) {
+                finishTransfer(msg->easy_handle, msg->data.result, results);
+            }
+        }
+
+        // One queued call per pass keeps a burst of results from flooding
+        // the GUI thread's event queue
+        if (!results.empty()) {
+            QMetaObject::invokeMethod(this, [this, results = std::move(results)]() {
+                deliver(results);
+            }, Qt::QueuedConnection);
+        }
+
+        // Woken early by enqueue() and the destructor
+        curl_multi_poll(m_multi, nullptr, 0, 1000, nullptr);
+    }
+
+    while (!m_active.empty()) {
+        releaseTransfer(m_active.begin()->first);
+    }
+}
+
+void ProbePipeline::startTransfers(std::vector<Result>& results) {
+    std::vector<std::unique_ptr<Transfer>> starting;
+    {
+        std::lock_guard lock(m_mutex);
+
+        // Round-robin over hosts so one large host cannot starve the rest
+        bool progress = true;
+        while (progress && m_active.size() + starting.size() < Constants::PROBE_CONCURRENCY) {
+            progress = false;
+
+            auto it = m_pendingByHost.upper_bound(m_lastHost);
+            for (size_t visited = 0; visited < m_pendingByHost.size(); ++visited, ++it) {
+                if (it == m_pendingByHost.end()) {
+                    it = m_pendingByHost.begin();
+                }
+                if (m_activePerHost[it->first] >= Constants::PROBE_PER_HOST) {
+                    continue;
+                }
+
+                auto transfer = std::make_unique<Transfer>();
+                transfer->request = std::move(it->second.front());
+                transfer->host = it->first;
+                it->second.pop_front();
+
+                ++m_activePerHost[it->first];
+                m_lastHost = it->first;
+                starting.push_back(std::move(transfer));
+
+                if (it->second.empty()) {
+                    m_pendingByHost.erase(it);
+                }
+                progress = true;
+                break;
+            }
+        }
+    }
+
+    for (auto& transfer : starting) {
+        startTransfer(std::move(transfer), results);
+    }
+}
+
+void ProbePipeline::startTransfer(std::unique_ptr<Transfer> transfer, std::vector<Result>& results) {
+    CURL* easy = curl_easy_init();
+    if (!easy) {
+        Result result;
+        result.id = transfer->request.id;
+        result.error.category = ErrorCategory::Unknown;
+        result.error.message = QStringLiteral("Failed to initialize curl");
+        results.push_back(std::move(result));
+
+        --m_activePerHost[transfer->host];
+        --m_pendingCount;
+        return;
+    }
+
+    // Probed DNS entries and TLS sessions are reused by the downloads
+    CurlGlobalInit::instance().share().attach(easy);
+
+    transfer->urlBytes = transfer->request.url.toString().toUtf8();
+
+    // Same request as NetworkProbe, with a shorter deadline
+    curl_easy_setopt(easy, CURLOPT_URL, transfer->urlBytes.constData());
+    curl_easy_setopt(easy, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(easy, CURLOPT_MAXREDIRS, 10L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(Constants::PROBE_TIMEOUT.count()));
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, 2L);
+
+#ifdef Q_OS_WIN
+    curl_easy_setopt(easy, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NATIVE_CA);
+#endif
+
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, transfer.get());
+    curl_easy_setopt(easy, CURLOPT_USERAGENT, "OpenIDM/1.0");
+
+    curl_multi_add_handle(m_multi, easy);
+    m_active.emplace(easy, std::move(transfer));
+}
+
+void ProbePipeline::finishTransfer(CURL* easy, int curlCode, std::vector<Result>& results) {
+    auto it = m_active.find(easy);
+    if (it == m_active.end()) {
+        return;
+    }
+    Transfer& transfer = *it->second;
+
+    ServerCapabilities caps = NetworkProbe::readCapabilities(easy, transfer.headers);
+    int httpCode = caps.httpStatusCode;
+
+    // Some servers refuse HEAD; one byte of a GET carries the same headers
+    bool headRefused = httpCode == 405 || httpCode == 501;
+    if (curlCode == CURLE_OK && headRefused && !transfer.rangedGet) {
+        curl_multi_remove_handle(m_multi, easy);
+
+        transfer.rangedGet = true;
+        transfer.headers = HttpHeaderInfo{};
+        curl_easy_setopt(easy, CURLOPT_NOBODY, 0L);
+        curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(easy, CURLOPT_RANGE, "0-0");
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, discardCallback);
+
+        curl_multi_add_handle(m_multi, easy);
+        return;
+    }
+
+    // discardCallback aborts a GET at its first body chunk
+    bool completed = curlCode == CURLE_OK || (transfer.rangedGet && curlCode == CURLE_WRITE_ERROR);
+
+    Result result;
+    result.id = transfer.request.id;
+    if (!completed) {
+        result.error.category = ErrorCategory::Network;
+        result.error.errorCode = curlCode;
+        result.error.message = QString::fromUtf8(curl_easy_strerror(static_cast<CURLcode>(curlCode)));
+    } else if (httpCode >= 400 || !caps.isValid()) {
+        result.error.category = (httpCode >= 500) ? ErrorCategory::ServerError : ErrorCategory::ClientError;
+        result.error.errorCode = httpCode;
+        result.error.message = QStringLiteral("HTTP error %1").arg(httpCode);
+    } else {
+        // A 206 to "0-0" reports the one byte it sent; Content-Range
+        // already replaced that with the total
+        result.ok = true;
+        result.capabilities = caps;
+    }
+    results.push_back(std::move(result));
+
+    releaseTransfer(easy);
+}
+
+void ProbePipeline::releaseTransfer(CURL* easy) {
+    auto it = m_active.find(easy);
+    if (it == m_active.end()) {
+        return;
+    }
+
+    curl_multi_remove_handle(m_multi, easy);
+    curl_easy_cleanup(easy);
+
+    auto host = m_activePerHost.find(it->second->host);
+    if (host != m_activePerHost.end() && --host->second == 0) {
+        m_activePerHost.erase(host);
+    }
+
+    m_active.erase(it);
+    --m_pendingCount;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Delivery
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void ProbePipeline::deliver(const std::vector<Result>& results) {
+    for (const Result& result : results) {
+        if (result.ok) {
+            emit probed(result.id, result.capabilities);
+        } else {
+            emit probeFailed(result.id, result.error);
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Callbacks
+// ═══════════════════════════════════════════════════════════════════════════════
+
+size_t ProbePipeline::headerCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* transfer = static_cast<Transfer*>(userdata);
+    size_t totalSize = size * nitems;
+
+    // A status line resets the info: only the final response of a redirect
+    // chain is kept
+    HttpHeaderParser::parseLine(std::string_view(buffer, totalSize), transfer->headers);
+
+    return totalSize;
+}
+
+size_t ProbePipeline::discardCallback(char* /*ptr*/, size_t /*size*/, size_t /*nmemb*/, void* /*userdata*/) {
+    // Headers are all we need; a server ignoring the range would otherwise
+    // send the whole file
+    return 0;
+}
+
+} // namespace OpenIDM
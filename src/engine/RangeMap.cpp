@@ -0,0 +1,146 @@
+/**
+ * @file RangeMap.cpp
+ * @brief Implementation of RangeMap
+ */
+
+#include "openidm/engine/RangeMap.h"
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Updates
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void RangeMap::reset(ByteCount size) {
+    m_runs.clear();
+    for (auto& index : m_bySize) {
+        index.clear();
+    }
+    m_bytes.fill(0);
+    m_size = std::max<ByteCount>(size, 0);
+
+    if (m_size > 0) {
+        insertRun(0, Run{m_size - 1, RangeState::Pending, 0});
+    }
+}
+
+void RangeMap::assign(ByteOffset start, ByteOffset end, RangeState state, SegmentId owner) {
+    start = std::max<ByteOffset>(start, 0);
+    end = std::min<ByteOffset>(end, m_size - 1);
+    if (start > end) {
+        return;
+    }
+
+    // Cut the runs straddling either edge, then replace everything between
+    splitAt(start);
+    splitAt(end + 1);
+
+    auto it = m_runs.lower_bound(start);
+    while (it != m_runs.end() && it->first <= end) {
+        auto next = std::next(it);
+        eraseRun(it);
+        it = next;
+    }
+
+    SegmentId tag = state == RangeState::InFlight ? owner : 0;
+    coalesce(insertRun(start, Run{end, state, tag}));
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Queries
+// ═══════════════════════════════════════════════════════════════════════════════
+
+std::optional<RangeMap::Range> RangeMap::largest(RangeState state) const {
+    const auto& bySize = m_bySize[index(state)];
+    if (bySize.empty()) {
+        return std::nullopt;
+    }
+    auto run = m_runs.find(bySize.rbegin()->second);
+    return Range{run->first, run->second.end, run->second.state, run->second.owner};
+}
+
+std::vector<RangeMap::Range> RangeMap::ranges() const {
+    std::vector<Range> result;
+    result.reserve(m_runs.size());
+    for (const auto& [start, run] : m_runs) {
+        result.push_back(Range{start, run.end, run.state, run.owner});
+    }
+    return result;
+}
+
+std::vector<RangeMap::Range> RangeMap::ranges(RangeState state) const {
+    std::vector<Range> result;
+    result.reserve(m_bySize[index(state)].size());
+    for (const auto& [start, run] : m_runs) {
+        if (run.state == state) {
+            result.push_back(Range{start, run.end, run.state, run.owner});
+        }
+    }
+    return result;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool RangeMap::mergeable(const Run& a, const Run& b) {
+    return a.state == b.state && (a.state != RangeState::InFlight || a.owner == b.owner);
+}
+
+RangeMap::Runs::iterator RangeMap::insertRun(ByteOffset start, const Run& run) {
+    ByteCount length = run.end - start + 1;
+    m_bySize[index(run.state)].emplace(length, start);
+    m_bytes[index(run.state)] += length;
+    return m_runs.emplace(start, run).first;
+}
+
+void RangeMap::eraseRun(Runs::iterator it) {
+    ByteCount length = it->second.end - it->first + 1;
+    m_bySize[index(it->second.state)].erase({length, it->first});
+    m_bytes[index(it->second.state)] -= length;
+    m_runs.erase(it);
+}
+
+void RangeMap::splitAt(ByteOffset position) {
+    if (position <= 0 || position >= m_size) {
+        return;
+    }
+    auto it = std::prev(m_runs.upper_bound(position));
+    if (it->first == position) {
+        return;
+    }
+
+    // Same state on both sides; the caller is about to overwrite one of them
+    ByteOffset start = it->first;
+    Run run = it->second;
+    eraseRun(it);
+    insertRun(start, Run{position - 1, run.state, run.owner});
+    insertRun(position, run);
+}
+
+void RangeMap::coalesce(Runs::iterator it) {
+    // Runs tile the file, so neighbours in the map are neighbours on disk
+    if (it != m_runs.begin()) {
+        auto prev = std::prev(it);
+        if (mergeable(prev->second, it->second)) {
+            ByteOffset start = prev->first;
+            Run merged{it->second.end, prev->second.state, prev->second.owner};
+            eraseRun(prev);
+            eraseRun(it);
+            it = insertRun(start, merged);
+        }
+    }
+
+    auto next = std::next(it);
+    if (next != m_runs.end() && mergeable(it->second, next->second)) {
+        ByteOffset start = it->first;
+        Run merged{next->second.end, it->second.state, it->second.owner};
+        eraseRun(next);
+        eraseRun(it);
+        insertRun(start, merged);
+    }
+}
+
+} // namespace OpenIDM
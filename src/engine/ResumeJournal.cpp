@@ -0,0 +1,558 @@
+/**
+ * @file ResumeJournal.cpp
+ * @brief Implementation of ResumeJournal - mapped append-only resume log
+ */
+
+#include "openidm/engine/ResumeJournal.h"
+#include "openidm/engine/Checksum.h"
+#include "openidm/engine/OutputFile.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace OpenIDM {
+
+namespace {
+
+constexpr char JOURNAL_MAGIC[8] = {'O', 'I', 'D', 'M', 'J', 'R', 'N', 'L'};
+constexpr uint32_t JOURNAL_VERSION = 1;
+
+/**
+ * @brief File header (one per journal)
+ */
+struct JournalHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    int64_t totalSize;          ///< Size of the complete file the journal describes
+    uint8_t reserved[40];
+};
+static_assert(sizeof(JournalHeader) == 64, "journal header layout is part of the file format");
+
+enum RecordFlag : uint32_t {
+    RecordSynced   = 1u << 0,   ///< Written right after the data file was flushed
+    RecordCrcValid = 1u << 1    ///< crc covers [startByte, durableByte)
+};
+
+/**
+ * @brief One progress record (native endianness; the journal never leaves the machine)
+ */
+struct JournalRecord {
+    uint32_t segmentId;
+    uint32_t flags;
+    int64_t startByte;
+    int64_t endByte;
+    int64_t durableByte;
+    uint32_t crc;
+    uint32_t recordCrc;         ///< CRC32C of the fields above; zeroed or torn slots fail it
+};
+static_assert(sizeof(JournalRecord) == 40, "journal record layout is part of the file format");
+
+constexpr size_t RECORD_CHECKED_BYTES = offsetof(JournalRecord, recordCrc);
+
+uint32_t recordChecksum(const JournalRecord& record) {
+    return crc32c(reinterpret_cast<const char*>(&record), RECORD_CHECKED_BYTES);
+}
+
+bool isValidRecord(const JournalRecord& record) {
+    return record.recordCrc == recordChecksum(record)
+        && record.startByte >= 0
+        && record.durableByte >= record.startByte
+        && record.durableByte <= record.endByte + 1;
+}
+
+qint64 mappedSize(uint32_t capacity) {
+    return static_cast<qint64>(sizeof(JournalHeader))
+         + static_cast<qint64>(capacity) * static_cast<qint64>(sizeof(JournalRecord));
+}
+
+/**
+ * @brief Continue a CRC32C over a range of the partial file
+ * @return Updated CRC, or nullopt if the range could not be read
+ */
+std::optional<uint32_t> crcOfRange(QFile& file, ByteOffset offset, ByteCount length, uint32_t crc) {
+    if (!file.seek(offset)) {
+        return std::nullopt;
+    }
+
+    QByteArray chunk(static_cast<qsizetype>(Constants::FILE_WRITE_BUFFER), Qt::Uninitialized);
+    while (length > 0) {
+        qint64 wanted = std::min<qint64>(length, chunk.size());
+        qint64 read = file.read(chunk.data(), wanted);
+        if (read != wanted) {
+            return std::nullopt;
+        }
+        crc = crc32c(chunk.constData(), static_cast<size_t>(read), crc);
+        length -= read;
+    }
+    return crc;
+}
+
+SegmentState stateForProgress(const Segment::Snapshot& snap) {
+    return snap.currentByte > snap.endByte ? SegmentState::Completed : SegmentState::Pending;
+}
+
+/**
+ * @brief Make a set of snapshots tile [0, totalSize) exactly
+ *
+ * Splits done after the last SQLite save are only visible through later
+ * journal records, so a stale parent may still claim its old end. The
+ * earlier segment is cut back at the next segment's start; bytes it had
+ * written past that point are correct file data and remain the next
+ * segment's business.
+ */
+std::vector<Segment::Snapshot> normalizeLayout(std::vector<Segment::Snapshot> snapshots, ByteCount totalSize) {
+    std::sort(snapshots.begin(), snapshots.end(), [](const auto& a, const auto& b) {
+        return a.startByte < b.startByte;
+    });
+
+    SegmentId nextId = 0;
+    for (const auto& snap : snapshots) {
+        nextId = std::max(nextId, snap.id + 1);
+    }
+
+    auto gap = [&nextId](ByteOffset start, ByteOffset end) {
+        Segment::Snapshot snap{};
+        snap.id = nextId++;
+        snap.startByte = start;
+        snap.endByte = end;
+        snap.currentByte = start;
+        snap.state = SegmentState::Pending;
+        snap.checksumValid = true;
+        return snap;
+    };
+
+    std::vector<Segment::Snapshot> result;
+    result.reserve(snapshots.size() + 1);
+    ByteOffset expected = 0;
+    ByteOffset lastByte = totalSize - 1;
+
+    for (auto& snap : snapshots) {
+        if (snap.startByte > lastByte) {
+            continue;
+        }
+        snap.endByte = std::min(snap.endByte, lastByte);
+
+        // Overlap: trim the previous segment instead of this one
+        while (!result.empty() && snap.startByte < expected) {
+            Segment::Snapshot& prev = result.back();
+            if (snap.startByte <= prev.startByte) {
+                result.pop_back();
+                expected = result.empty() ? 0 : result.back().endByte + 1;
+                continue;
+            }
+            prev.endByte = snap.startByte - 1;
+            if (prev.currentByte > prev.endByte + 1) {
+                prev.currentByte = prev.endByte + 1;
+                prev.checksumValid = false;
+            }
+            prev.state = stateForProgress(prev);
+            expected = prev.endByte + 1;
+        }
+
+        if (snap.startByte > expected) {
+            result.push_back(gap(expected, snap.startByte - 1));
+        }
+        result.push_back(std::move(snap));
+        expected = result.back().endByte + 1;
+    }
+
+    if (totalSize > 0 && expected <= lastByte) {
+        result.push_back(gap(expected, lastByte));
+    }
+    return result;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+ResumeJournal::ResumeJournal(QString path)
+    : m_path(std::move(path))
+{
+}
+
+ResumeJournal::~ResumeJournal() {
+    // Mapped pages reach the file through the page cache; nothing to flush
+    unmap();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Lifecycle
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool ResumeJournal::open(ByteCount totalSize, const std::vector<Segment*>& segments) {
+    std::lock_guard lock(m_mutex);
+
+    m_entries.clear();
+    m_synced.clear();
+
+    for (const Segment* segment : segments) {
+        Entry entry;
+        entry.startByte = segment->startByte();
+        entry.endByte = segment->endByte();
+        entry.durableByte = segment->resumeByte();
+        Segment::ChecksumRange checksum = segment->checksumRange();
+        entry.crc = checksum.crc;
+        entry.crcValid = checksum.reaches(entry.durableByte);
+
+        m_entries[segment->id()] = entry;
+        m_synced[segment->id()] = entry;
+    }
+
+    if (!rewrite(totalSize)) {
+        unmap();
+        return false;
+    }
+
+    qDebug() << "ResumeJournal: Tracking" << segments.size() << "segments in" << m_path;
+    return true;
+}
+
+void ResumeJournal::discard() {
+    std::lock_guard lock(m_mutex);
+    unmap();
+    QFile::remove(m_path);
+    m_entries.clear();
+    m_synced.clear();
+}
+
+bool ResumeJournal::rewrite(ByteCount totalSize) {
+    // Note: Caller must hold m_mutex
+    unmap();
+    m_totalSize = totalSize;
+
+    // The last synced and the latest record of each segment survive
+    std::vector<JournalRecord> records;
+    records.reserve(m_entries.size() * 2);
+
+    auto makeRecord = [](SegmentId id, const Entry& entry, bool synced) {
+        JournalRecord record{};
+        record.segmentId = id;
+        record.flags = (synced ? RecordSynced : 0u) | (entry.crcValid ? RecordCrcValid : 0u);
+        record.startByte = entry.startByte;
+        record.endByte = entry.endByte;
+        record.durableByte = entry.durableByte;
+        record.crc = entry.crc;
+        record.recordCrc = recordChecksum(record);
+        return record;
+    };
+
+    for (const auto& [id, entry] : m_entries) {
+        auto synced = m_synced.find(id);
+        if (synced != m_synced.end()) {
+            records.push_back(makeRecord(id, synced->second, true));
+            if (synced->second.durableByte == entry.durableByte
+                && synced->second.endByte == entry.endByte) {
+                continue;
+            }
+        }
+        records.push_back(makeRecord(id, entry, false));
+    }
+
+    m_capacity = std::max<uint32_t>(Constants::RESUME_JOURNAL_RECORDS,
+                                    static_cast<uint32_t>(records.size() * 2));
+    qint64 size = mappedSize(m_capacity);
+
+    // Built beside the live journal and swapped in, so a crash mid-way
+    // leaves either the old journal or the new one
+    QString temp = m_path + QStringLiteral(".tmp");
+    QFile out(temp);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || !out.resize(size)) {
+        qWarning() << "ResumeJournal: Cannot create" << temp << ":" << out.errorString();
+        return false;
+    }
+
+    JournalHeader header{};
+    std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.recordSize = sizeof(JournalRecord);
+    header.totalSize = totalSize;
+
+    bool written = out.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header)
+        && out.write(reinterpret_cast<const char*>(records.data()),
+                     static_cast<qint64>(records.size() * sizeof(JournalRecord)))
+               == static_cast<qint64>(records.size() * sizeof(JournalRecord));
+    out.close();
+    if (!written) {
+        qWarning() << "ResumeJournal: Cannot write" << temp;
+        QFile::remove(temp);
+        return false;
+    }
+
+    if (QFile::exists(m_path) && !QFile::remove(m_path)) {
+        qWarning() << "ResumeJournal: Cannot replace" << m_path;
+        QFile::remove(temp);
+        return false;
+    }
+    if (!QFile::rename(temp, m_path)) {
+        qWarning() << "ResumeJournal: Cannot rename" << temp << "to" << m_path;
+        return false;
+    }
+
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "ResumeJournal: Cannot open" << m_path << ":" << m_file.errorString();
+        return false;
+    }
+
+    m_map = m_file.map(0, size);
+    if (!m_map) {
+        qWarning() << "ResumeJournal: Cannot map" << m_path << ":" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_count = static_cast<uint32_t>(records.size());
+    return true;
+}
+
+void ResumeJournal::unmap() {
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_capacity = 0;
+    m_count = 0;
+}
+
+bool ResumeJournal::flushMap() {
+    // Note: Caller must hold m_mutex
+    if (!m_map) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return FlushViewOfFile(m_map, 0) != 0;
+#else
+    return ::msync(m_map, static_cast<size_t>(mappedSize(m_capacity)), MS_SYNC) == 0;
+#endif
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Recording
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool ResumeJournal::append(SegmentId id, const Entry& entry, bool synced) {
+    // Note: Caller must hold m_mutex; entry must already be in m_entries/m_synced
+    if (m_count >= m_capacity) {
+        // Full: compaction writes the current state of every segment
+        return rewrite(m_totalSize);
+    }
+
+    JournalRecord record{};
+    record.segmentId = id;
+    record.flags = (synced ? RecordSynced : 0u) | (entry.crcValid ? RecordCrcValid : 0u);
+    record.startByte = entry.startByte;
+    record.endByte = entry.endByte;
+    record.durableByte = entry.durableByte;
+    record.crc = entry.crc;
+    record.recordCrc = recordChecksum(record);
+
+    std::memcpy(m_map + mappedSize(m_count), &record, sizeof(record));
+    ++m_count;
+    return true;
+}
+
+void ResumeJournal::recordWrite(const Segment& segment, ByteOffset offset, const char* data, size_t length) {
+    // The expensive part happens outside the lock; combining is O(log n)
+    uint32_t blockCrc = crc32c(data, length);
+
+    std::lock_guard lock(m_mutex);
+    if (!m_map) {
+        return;
+    }
+
+    auto [it, inserted] = m_entries.try_emplace(segment.id());
+    Entry& entry = it->second;
+    if (inserted) {
+        // Created by a split after open()
+        entry.startByte = segment.startByte();
+        entry.durableByte = segment.startByte();
+    }
+    entry.endByte = segment.endByte();
+
+    if (offset == entry.durableByte) {
+        entry.crc = crc32cCombine(entry.crc, blockCrc, static_cast<ByteCount>(length));
+        entry.durableByte = offset + static_cast<ByteOffset>(length);
+    } else {
+        // A hedged twin wrote out of order; only the segment's own
+        // conservative resume point is known to be complete
+        entry.crcValid = false;
+        entry.durableByte = std::max(entry.durableByte,
+                                     std::min(segment.resumeByte(), entry.endByte + 1));
+    }
+
+    if (!append(segment.id(), entry, false)) {
+        unmap();    // Journal lost; SQLite still has the coarse state
+    }
+}
+
+bool ResumeJournal::checkpoint(OutputFile& file) {
+    std::map<SegmentId, Entry> sampled;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_map) {
+            return false;
+        }
+        sampled = m_entries;
+    }
+
+    // Everything sampled has been written; after the flush it is durable
+    if (!file.sync()) {
+        return false;
+    }
+
+    std::lock_guard lock(m_mutex);
+    for (const auto& [id, entry] : sampled) {
+        auto synced = m_synced.find(id);
+        if (synced != m_synced.end()
+            && synced->second.durableByte == entry.durableByte
+            && synced->second.endByte == entry.endByte) {
+            continue;
+        }
+        m_synced[id] = entry;
+        if (!append(id, entry, true)) {
+            unmap();
+            return false;
+        }
+    }
+    return flushMap();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Recovery
+// ═══════════════════════════════════════════════════════════════════════════════
+
+std::vector<Segment::Snapshot> ResumeJournal::recover(const QString& journalPath, const QString& dataPath,
+                                                      ByteCount totalSize,
+                                                      std::vector<Segment::Snapshot> snapshots) {
+    if (totalSize <= 0 || !QFile::exists(dataPath)) {
+        return {};
+    }
+
+    // Without a usable journal the SQLite layout is all there is
+    auto fallback = [&snapshots, totalSize]() {
+        return snapshots.empty() ? std::vector<Segment::Snapshot>{}
+                                 : normalizeLayout(std::move(snapshots), totalSize);
+    };
+
+    QFile journal(journalPath);
+    if (!journal.open(QIODevice::ReadOnly)) {
+        return fallback();
+    }
+    QByteArray content = journal.readAll();
+    journal.close();
+
+    JournalHeader header{};
+    if (content.size() < static_cast<qsizetype>(sizeof(header))) {
+        return fallback();
+    }
+    std::memcpy(&header, content.constData(), sizeof(header));
+
+    if (std::memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0
+        || header.version != JOURNAL_VERSION
+        || header.recordSize != sizeof(JournalRecord)) {
+        qWarning() << "ResumeJournal: Ignoring unrecognised journal" << journalPath;
+        return fallback();
+    }
+    if (header.totalSize != totalSize) {
+        // The remote file changed; nothing on disk can be trusted
+        qWarning() << "ResumeJournal: File size changed from" << header.totalSize
+                   << "to" << totalSize << ", restarting download";
+        return {};
+    }
+
+    struct Found {
+        JournalRecord latest{};
+        JournalRecord synced{};
+        bool hasSynced{false};
+    };
+    std::map<SegmentId, Found> found;
+
+    // Appended in order; the first invalid slot is the end of the log
+    for (qsizetype pos = sizeof(header);
+         pos + static_cast<qsizetype>(sizeof(JournalRecord)) <= content.size();
+         pos += sizeof(JournalRecord)) {
+        JournalRecord record;
+        std::memcpy(&record, content.constData() + pos, sizeof(record));
+        if (!isValidRecord(record)) {
+            break;
+        }
+        Found& entry = found[record.segmentId];
+        entry.latest = record;
+        if (record.flags & RecordSynced) {
+            entry.synced = record;
+            entry.hasSynced = true;
+        }
+    }
+
+    QFile data(dataPath);
+    if (found.empty() || !data.open(QIODevice::ReadOnly)) {
+        return fallback();
+    }
+
+    std::map<SegmentId, Segment::Snapshot> merged;
+    for (auto& snap : snapshots) {
+        snap.checksumValid = false;
+        merged[snap.id] = std::move(snap);
+    }
+
+    ByteCount verifiedBytes = 0;
+    for (const auto& [id, entry] : found) {
+        const JournalRecord& latest = entry.latest;
+
+        // Last point known to be on stable storage (the start if never synced)
+        ByteOffset durable = entry.hasSynced ? entry.synced.durableByte : latest.startByte;
+        uint32_t crc = entry.hasSynced ? entry.synced.crc : 0;
+        bool crcValid = entry.hasSynced ? (entry.synced.flags & RecordCrcValid) != 0 : true;
+
+        // Re-verify only the tail written since then
+        if (latest.durableByte > durable && crcValid && (latest.flags & RecordCrcValid)) {
+            auto tail = crcOfRange(data, durable, latest.durableByte - durable, crc);
+            if (tail && *tail == latest.crc) {
+                verifiedBytes += latest.durableByte - durable;
+                durable = latest.durableByte;
+                crc = latest.crc;
+            } else {
+                qDebug() << "ResumeJournal: Segment" << id << "tail did not verify, resuming from"
+                         << durable;
+            }
+        }
+
+        Segment::Snapshot& snap = merged[id];
+        snap.id = id;
+        snap.startByte = latest.startByte;
+        snap.endByte = latest.endByte;
+        snap.currentByte = durable;
+        snap.checksum = crc;
+        snap.checksumValid = crcValid;
+        snap.state = stateForProgress(snap);
+    }
+
+    std::vector<Segment::Snapshot> result;
+    result.reserve(merged.size());
+    for (auto& [id, snap] : merged) {
+        result.push_back(std::move(snap));
+    }
+
+    qDebug() << "ResumeJournal: Recovered" << found.size() << "segments from" << journalPath
+             << "(" << verifiedBytes << "tail bytes re-verified)";
+    return normalizeLayout(std::move(result), totalSize);
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,84 @@
+/**
+ * @file RetryWheel.cpp
+ * @brief Implementation of RetryWheel
+ */
+
+#include "openidm/engine/RetryWheel.h"
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+RetryWheel::RetryWheel(Clock::time_point origin)
+    : m_slots(Constants::RETRY_WHEEL_SLOTS)
+    , m_origin(origin)
+{
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Updates
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void RetryWheel::schedule(Segment* segment, Clock::time_point notBefore) {
+    // Never into the slot being read, or it would wait a whole revolution
+    uint64_t tick = std::max(tickOf(notBefore), m_current + 1);
+    m_slots[tick % m_slots.size()].push_back(Entry{segment, tick});
+    ++m_size;
+}
+
+std::vector<Segment*> RetryWheel::advance(Clock::time_point now) {
+    std::vector<Segment*> segments;
+    uint64_t target = now > m_origin ? static_cast<uint64_t>((now - m_origin) / Constants::RETRY_WHEEL_TICK) : 0;
+    if (target <= m_current || m_size == 0) {
+        m_current = std::max(m_current, target);
+        return segments;
+    }
+
+    // After a long stall, one pass over every slot covers all ticks
+    std::vector<Entry> due;
+    uint64_t from = std::max(m_current + 1, target >= m_slots.size() ? target - m_slots.size() + 1 : 0);
+    for (uint64_t tick = from; tick <= target; ++tick) {
+        std::vector<Entry>& slot = m_slots[tick % m_slots.size()];
+        auto ready = std::stable_partition(slot.begin(), slot.end(),
+                                           [target](const Entry& entry) { return entry.tick > target; });
+        due.insert(due.end(), ready, slot.end());
+        m_size -= static_cast<size_t>(slot.end() - ready);
+        slot.erase(ready, slot.end());
+    }
+    m_current = target;
+
+    // The pass starts mid-revolution, so overdue entries can come out of order
+    std::stable_sort(due.begin(), due.end(),
+                     [](const Entry& a, const Entry& b) { return a.tick < b.tick; });
+    segments.reserve(due.size());
+    for (const Entry& entry : due) {
+        segments.push_back(entry.segment);
+    }
+    return segments;
+}
+
+void RetryWheel::clear() {
+    for (auto& slot : m_slots) {
+        slot.clear();
+    }
+    m_size = 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+uint64_t RetryWheel::tickOf(Clock::time_point time) const {
+    if (time <= m_origin) {
+        return 0;
+    }
+    // Rounded up: a retry may run late by a tick, never early
+    auto elapsed = std::chrono::duration_cast<Duration>(time - m_origin);
+    return static_cast<uint64_t>((elapsed + Constants::RETRY_WHEEL_TICK - Duration(1)) / Constants::RETRY_WHEEL_TICK);
+}
+
+} // namespace OpenIDM
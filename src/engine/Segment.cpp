@@ -4,75 +4,12 @@
  */
 
 #include "openidm/engine/Segment.h"
+#include "openidm/engine/Checksum.h"
+
 #include <algorithm>
 
 namespace OpenIDM {
 
-// ═══════════════════════════════════════════════════════════════════════════════
-// CRC32 Implementation (IEEE polynomial)
-// ═══════════════════════════════════════════════════════════════════════════════
-
-namespace {
-
-// Pre-computed CRC32 lookup table
-constexpr uint32_t CRC32_TABLE[] = {
-    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
-    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
-    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
-    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd706b3,
-    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-};
-
-} // anonymous namespace
-
-uint32_t calculateCRC32(const char* data, size_t size, uint32_t previousCrc) {
-    uint32_t crc = previousCrc ^ 0xFFFFFFFF;
-    
-    for (size_t i = 0; i < size; ++i) {
-        crc = CRC32_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
-    }
-    
-    return crc ^ 0xFFFFFFFF;
-}
-
 // ═══════════════════════════════════════════════════════════════════════════════
 // Segment Implementation
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -84,6 +21,7 @@ Segment::Segment(SegmentId id, ByteOffset startByte, ByteOffset endByte)
     , m_currentByte(startByte)
     , m_state(SegmentState::Pending)
     , m_checksum(0)
+    , m_checksumEnd(startByte)
     , m_retryCount(0)
 {
 }
@@ -95,6 +33,7 @@ Segment::Segment()
     , m_currentByte(0)
     , m_state(SegmentState::Pending)
     , m_checksum(0)
+    , m_checksumEnd(0)
     , m_retryCount(0)
 {
 }
@@ -105,16 +44,16 @@ Segment::Segment(Segment&& other) noexcept
     , m_endByte(other.m_endByte)
     , m_currentByte(other.m_currentByte.load())
     , m_state(other.m_state.load())
-    , m_checksum(other.m_checksum)
-    , m_tempFilePath(std::move(other.m_tempFilePath))
+    , m_writers(other.m_writers.load())
+    , m_pendingWrite(other.m_pendingWrite.load())
+    , m_hedgeDurable(other.m_hedgeDurable.load())
+    , m_checksum(other.m_checksum.load())
+    , m_checksumEnd(other.m_checksumEnd.load())
+    , m_checksumBroken(other.m_checksumBroken.load())
     , m_retryCount(other.m_retryCount)
-    , m_lastError(std::move(other.m_lastError))
+    , m_notes(std::move(other.m_notes))
 {
-    other.m_id = 0;
-    other.m_startByte = 0;
-    other.m_endByte = 0;
-    other.m_currentByte.store(0);
-    other.m_state.store(SegmentState::Pending);
+    other.resetMovedFrom();
 }
 
 Segment& Segment::operator=(Segment&& other) noexcept {
@@ -124,20 +63,34 @@ Segment& Segment::operator=(Segment&& other) noexcept {
         m_endByte = other.m_endByte;
         m_currentByte.store(other.m_currentByte.load());
         m_state.store(other.m_state.load());
-        m_checksum = other.m_checksum;
-        m_tempFilePath = std::move(other.m_tempFilePath);
+        m_writers.store(other.m_writers.load());
+        m_pendingWrite.store(other.m_pendingWrite.load());
+        m_hedgeDurable.store(other.m_hedgeDurable.load());
+        publishChecksum(other.m_checksum.load(), other.m_checksumEnd.load());
+        m_checksumBroken.store(other.m_checksumBroken.load());
         m_retryCount = other.m_retryCount;
-        m_lastError = std::move(other.m_lastError);
+        m_notes = std::move(other.m_notes);
         
-        other.m_id = 0;
-        other.m_startByte = 0;
-        other.m_endByte = 0;
-        other.m_currentByte.store(0);
-        other.m_state.store(SegmentState::Pending);
+        other.resetMovedFrom();
     }
     return *this;
 }
 
+void Segment::resetMovedFrom() {
+    // Leave the source as a default-constructed segment
+    m_id = 0;
+    m_startByte = 0;
+    m_endByte = 0;
+    m_currentByte.store(0);
+    m_state.store(SegmentState::Pending);
+    m_writers.store(0);
+    m_pendingWrite.store(0);
+    m_hedgeDurable.store(-1);
+    publishChecksum(0, 0);
+    m_checksumBroken.store(false);
+    m_retryCount = 0;
+}
+
 void Segment::setEndByte(ByteOffset newEnd) {
     // Ensure new end is valid
     if (newEnd >= currentByte() && newEnd <= m_endByte) {
@@ -145,30 +98,103 @@ void Segment::setEndByte(ByteOffset newEnd) {
     }
 }
 
-void Segment::updateChecksum(const char* data, size_t size) {
-    m_checksum = calculateCRC32(data, size, m_checksum);
+bool Segment::resolveEnd(ByteOffset end) {
+    if (totalSize() > 0 || end < currentByte()) {
+        return false;
+    }
+    m_endByte = end;
+    return true;
+}
+
+ByteCount Segment::claim(ByteOffset streamPos, ByteCount length, ByteOffset* claimStart) {
+    ByteOffset end = streamPos + length;
+    if (totalSize() > 0) {
+        end = std::min(end, m_endByte + 1);
+    }
+    
+    ByteOffset frontier = m_currentByte.load(std::memory_order_acquire);
+    do {
+        // Already delivered by another writer (or past a stolen end)
+        if (end <= frontier) {
+            return 0;
+        }
+        // Claims must stay contiguous; a gap would leave a hole in the file
+        if (streamPos > frontier) {
+            return 0;
+        }
+    } while (!m_currentByte.compare_exchange_weak(frontier, end,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_acquire));
+    
+    *claimStart = frontier;
+    return end - frontier;
+}
+
+void Segment::updateChecksum(ByteOffset offset, const char* data, size_t size) {
+    // Only this writer stores them, so its own relaxed loads are current
+    ByteOffset end = m_checksumEnd.load(std::memory_order_relaxed);
+    if (offset != end) {
+        m_checksumBroken.store(true, std::memory_order_release);
+        return;
+    }
+    
+    uint32_t crc = crc32c(data, size, m_checksum.load(std::memory_order_relaxed));
+    publishChecksum(crc, end + static_cast<ByteOffset>(size));
 }
 
-std::unique_ptr<Segment> Segment::split(SegmentId newId) {
+void Segment::publishChecksum(uint32_t crc, ByteOffset end) {
+    uint32_t seq = m_checksumSeq.load(std::memory_order_relaxed);
+    m_checksumSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_checksum.store(crc, std::memory_order_relaxed);
+    m_checksumEnd.store(end, std::memory_order_relaxed);
+    m_checksumSeq.store(seq + 2, std::memory_order_release);
+}
+
+Segment::ChecksumRange Segment::checksumRange() const {
+    ChecksumRange range;
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = m_checksumSeq.load(std::memory_order_acquire);
+        range.crc = m_checksum.load(std::memory_order_relaxed);
+        range.end = m_checksumEnd.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_checksumSeq.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    range.broken = m_checksumBroken.load(std::memory_order_acquire);
+    return range;
+}
+
+std::optional<Segment> Segment::split(SegmentId newId) {
     // Check if splittable
     ByteCount remaining = remainingBytes();
     if (remaining < Constants::MIN_STEAL_SIZE * 2) {
-        return nullptr;
+        return std::nullopt;
     }
     
     // Calculate split point (middle of remaining bytes)
+    return splitAt(newId, currentByte() + (remaining / 2));
+}
+
+std::optional<Segment> Segment::splitAt(SegmentId newId, ByteOffset position) {
     ByteOffset current = currentByte();
-    ByteOffset splitPoint = current + (remaining / 2);
+    if (m_endByte - current + 1 < Constants::MIN_STEAL_SIZE * 2) {
+        return std::nullopt;
+    }
     
     // Align to chunk boundary for efficiency
-    splitPoint = (splitPoint / Constants::CHUNK_SIZE) * Constants::CHUNK_SIZE;
-    if (splitPoint <= current) {
+    ByteOffset splitPoint = (position / Constants::CHUNK_SIZE) * Constants::CHUNK_SIZE;
+    if (splitPoint < current + Constants::MIN_STEAL_SIZE) {
         splitPoint = current + Constants::MIN_STEAL_SIZE;
     }
+    if (splitPoint > m_endByte + 1 - Constants::MIN_STEAL_SIZE) {
+        return std::nullopt;
+    }
     
     // Create new segment for second half
     ByteOffset originalEnd = m_endByte;
-    auto newSegment = std::make_unique<Segment>(newId, splitPoint, originalEnd);
+    std::optional<Segment> newSegment(std::in_place, newId, splitPoint, originalEnd);
     
     // Update this segment's end
     m_endByte = splitPoint - 1;
@@ -177,16 +203,27 @@ std::unique_ptr<Segment> Segment::split(SegmentId newId) {
 }
 
 Segment::Snapshot Segment::snapshot() const {
+    // A completed segment whose tail is not known to be on disk resumes
+    ByteOffset durable = resumeByte();
+    SegmentState state = m_state.load(std::memory_order_acquire);
+    if (state == SegmentState::Completed && durable <= m_endByte) {
+        state = SegmentState::Active;
+    }
+    
+    // The I/O thread may extend the checksum meanwhile; take CRC and end together
+    ChecksumRange checksum = checksumRange();
+    
     return Snapshot{
         .id = m_id,
         .startByte = m_startByte,
         .endByte = m_endByte,
-        .currentByte = m_currentByte.load(std::memory_order_relaxed),
-        .state = m_state.load(std::memory_order_acquire),
-        .checksum = m_checksum,
-        .tempFilePath = m_tempFilePath,
+        .currentByte = durable,
+        .state = state,
+        .checksum = checksum.crc,
+        .tempFilePath = tempFilePath(),
         .retryCount = m_retryCount,
-        .lastError = m_lastError
+        .lastError = lastError(),
+        .checksumValid = checksum.reaches(durable)
     };
 }
 
@@ -196,10 +233,20 @@ void Segment::restore(const Snapshot& snap) {
     m_endByte = snap.endByte;
     m_currentByte.store(snap.currentByte, std::memory_order_relaxed);
     m_state.store(snap.state, std::memory_order_release);
-    m_checksum = snap.checksum;
-    m_tempFilePath = snap.tempFilePath;
+    setTempFilePath(snap.tempFilePath);
+    
+    // A CRC that followed the in-memory frontier rather than the durable
+    // offset resumed from only counts if nothing was downloaded yet; one
+    // re-verified by the resume journal continues where it left off
+    if (snap.checksumValid) {
+        publishChecksum(snap.checksum, snap.currentByte);
+        m_checksumBroken.store(false, std::memory_order_release);
+    } else {
+        publishChecksum(snap.checksum, m_startByte);
+        m_checksumBroken.store(snap.currentByte != m_startByte, std::memory_order_release);
+    }
     m_retryCount = snap.retryCount;
-    m_lastError = snap.lastError;
+    setLastError(snap.lastError);
 }
 
 } // namespace OpenIDM
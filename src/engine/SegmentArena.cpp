@@ -0,0 +1,54 @@
+/**
+ * @file SegmentArena.cpp
+ * @brief Implementation of SegmentArena and SegmentTable
+ */
+
+#include "openidm/engine/SegmentArena.h"
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// SegmentArena
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SegmentArena::clear() {
+    for (size_t i = 0; i < m_used; ++i) {
+        std::destroy_at(slot(i));
+    }
+    m_used = 0;
+}
+
+void* SegmentArena::nextSlot() {
+    if (m_used == capacity()) {
+        m_slabs.push_back(std::make_unique<Slab>());
+    }
+    size_t index = m_used++;
+    return m_slabs[index / Constants::SEGMENT_SLAB_SIZE]->storage +
+           (index % Constants::SEGMENT_SLAB_SIZE) * sizeof(Segment);
+}
+
+Segment* SegmentArena::slot(size_t index) const {
+    std::byte* storage = m_slabs[index / Constants::SEGMENT_SLAB_SIZE]->storage +
+                         (index % Constants::SEGMENT_SLAB_SIZE) * sizeof(Segment);
+    return std::launder(reinterpret_cast<Segment*>(storage));
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// SegmentTable
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SegmentTable::resize(size_t rows) {
+    ids.resize(rows);
+    starts.resize(rows);
+    currents.resize(rows);
+    ends.resize(rows);
+    states.resize(rows);
+}
+
+size_t SegmentTable::count(SegmentState state) const {
+    return static_cast<size_t>(std::count(states.begin(), states.end(), state));
+}
+
+} // namespace OpenIDM
@@ -4,15 +4,64 @@
  */
 
 #include "openidm/engine/SegmentScheduler.h"
+#include "openidm/engine/Checksum.h"
 #include "openidm/engine/SegmentWorker.h"
 #include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/EngineMetrics.h"
+#include "openidm/engine/HostCache.h"
+#include "openidm/engine/HostGovernor.h"
+#include "openidm/engine/TransferEngine.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <chrono>
 #include <QDebug>
+#include <QMetaObject>
 
 namespace OpenIDM {
 
+namespace {
+
+/**
+ * @brief Fold runs of adjacent completed snapshots into their first one
+ *
+ * The merged CRC is the combination of the parts' when all of them had
+ * one. Ordering by start also puts pending segments back in file order.
+ */
+std::vector<Segment::Snapshot> mergeCompleted(std::vector<Segment::Snapshot> snapshots) {
+    std::sort(snapshots.begin(), snapshots.end(), [](const auto& a, const auto& b) {
+        return a.startByte < b.startByte;
+    });
+    
+    // Merged in place: kept snapshots move down over the absorbed ones
+    size_t kept = 0;
+    for (auto& snap : snapshots) {
+        if (kept > 0) {
+            Segment::Snapshot& prev = snapshots[kept - 1];
+            if (prev.state == SegmentState::Completed && snap.state == SegmentState::Completed
+                && prev.endByte + 1 == snap.startByte) {
+                prev.checksumValid = prev.checksumValid && snap.checksumValid;
+                prev.checksum = prev.checksumValid
+                                    ? crc32cCombine(prev.checksum, snap.checksum, snap.endByte - snap.startByte + 1)
+                                    : 0;
+                prev.endByte = snap.endByte;
+                prev.currentByte = snap.currentByte;
+                continue;
+            }
+        }
+        if (&snapshots[kept] != &snap) {
+            snapshots[kept] = std::move(snap);
+        }
+        ++kept;
+    }
+    snapshots.erase(snapshots.begin() + static_cast<std::ptrdiff_t>(kept), snapshots.end());
+    
+    return snapshots;
+}
+
+} // namespace
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Construction
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -21,12 +70,24 @@ SegmentScheduler::SegmentScheduler(DownloadTask* task, QObject* parent)
     : QObject(parent)
     , m_task(task)
     , m_rebalanceTimer(new QTimer(this))
+    , m_hostTimer(new QTimer(this))
+    , m_retryTimer(new QTimer(this))
 {
     connect(m_rebalanceTimer, &QTimer::timeout, this, &SegmentScheduler::onRebalanceTimer);
+    m_hostTimer->setSingleShot(true);
+    connect(m_hostTimer, &QTimer::timeout, this, &SegmentScheduler::onHostTimer);
+    m_retryTimer->setInterval(static_cast<int>(Constants::RETRY_WHEEL_TICK.count()));
+    connect(m_retryTimer, &QTimer::timeout, this, &SegmentScheduler::onRetryTimer);
 }
 
 SegmentScheduler::~SegmentScheduler() {
     cancelAll();
+    
+    std::unique_lock lock(m_mutex);
+    for (const auto& [worker, host] : m_workerHosts) {
+        HostGovernor::instance().release(host);
+    }
+    m_workerHosts.clear();
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -38,10 +99,14 @@ std::vector<Segment*> SegmentScheduler::initializeSegments(ByteCount totalSize,
     
     // Clear any existing segments
     m_segments.clear();
+    m_arena.clear();
     m_pendingQueue.clear();
+    m_retryWheel.clear();
     m_activeSegments.clear();
     m_completedSegments.clear();
     m_failedSegments.clear();
+    m_segmentIndex.clear();
+    m_ranges.reset(totalSize);
     m_nextSegmentId.store(0);
     
     // Clamp segment count
@@ -68,40 +133,92 @@ std::vector<Segment*> SegmentScheduler::initializeSegments(ByteCount totalSize,
         ByteOffset startByte = currentStart;
         ByteOffset endByte = currentStart + thisSize - 1;
         
-        auto segment = std::make_unique<Segment>(nextSegmentId(), startByte, endByte);
-        Segment* ptr = segment.get();
-        
-        m_segments.push_back(std::move(segment));
+        Segment* ptr = createNewSegment(startByte, endByte);
         m_pendingQueue.push_back(ptr);
         result.push_back(ptr);
         
         currentStart = endByte + 1;
     }
     
+    refreshTableLocked();
+    
     qDebug() << "SegmentScheduler: Initialized" << segmentCount << "segments for" 
              << totalSize << "bytes";
     
     return result;
 }
 
+bool SegmentScheduler::resolveOpenSegment(ByteCount totalSize, size_t segmentCount) {
+    std::unique_lock lock(m_mutex);
+    
+    if (m_segments.size() != 1 || totalSize <= 0) {
+        return false;
+    }
+    
+    segmentCount = std::clamp(segmentCount, 
+                              static_cast<size_t>(Constants::MIN_SEGMENTS),
+                              static_cast<size_t>(Constants::MAX_SEGMENTS));
+    
+    ByteCount segmentSize = totalSize / segmentCount;
+    ByteCount remainder = totalSize % segmentCount;
+    
+    // The first range stays with the worker that is streaming it
+    Segment* first = m_segments.front();
+    ByteCount firstSize = segmentCount == 1 ? totalSize : segmentSize;
+    if (!first->resolveEnd(firstSize - 1)) {
+        return false;
+    }
+    m_ranges.reset(totalSize);
+    trackLocked(first, m_activeSegments.count(first) ? RangeState::InFlight : RangeState::Pending);
+    
+    ByteOffset currentStart = firstSize;
+    for (size_t i = 1; i < segmentCount; ++i) {
+        ByteCount thisSize = segmentSize;
+        if (i == segmentCount - 1) {
+            thisSize += remainder;
+        }
+        
+        Segment* segment = createNewSegment(currentStart, currentStart + thisSize - 1);
+        m_pendingQueue.push_back(segment);
+        currentStart += thisSize;
+    }
+    refreshTableLocked();
+    
+    qDebug() << "SegmentScheduler: Resolved open segment into" << segmentCount
+             << "segments for" << totalSize << "bytes";
+    
+    signalWork();
+    return true;
+}
+
 void SegmentScheduler::restoreSegments(const std::vector<Segment::Snapshot>& snapshots) {
     std::unique_lock lock(m_mutex);
     
     m_segments.clear();
+    m_arena.clear();
     m_pendingQueue.clear();
+    m_retryWheel.clear();
+    m_retryTimer->stop();
     m_activeSegments.clear();
     m_completedSegments.clear();
     m_failedSegments.clear();
+    m_segmentIndex.clear();
+    
+    // Only the gaps need segments of their own; finished neighbours collapse
+    std::vector<Segment::Snapshot> layout = mergeCompleted(snapshots);
+    m_ranges.reset(layout.empty() ? 0 : layout.back().endByte + 1);
     
     SegmentId maxId = 0;
     
     for (const auto& snap : snapshots) {
-        auto segment = std::make_unique<Segment>();
-        segment->restore(snap);
-        
         maxId = std::max(maxId, snap.id);
+    }
+    
+    for (const auto& snap : layout) {
+        Segment restored;
+        restored.restore(snap);
         
-        Segment* ptr = segment.get();
+        Segment* ptr = adoptSegment(std::move(restored));
         
         // Place in appropriate collection based on state
         switch (snap.state) {
@@ -117,17 +234,18 @@ void SegmentScheduler::restoreSegments(const std::vector<Segment::Snapshot>& sna
                 break;
             default:
                 // Active/Stolen segments should be treated as pending on restore
-                segment->setState(SegmentState::Pending);
+                ptr->setState(SegmentState::Pending);
                 m_pendingQueue.push_back(ptr);
                 break;
         }
         
-        m_segments.push_back(std::move(segment));
+        trackLocked(ptr, snap.state == SegmentState::Completed ? RangeState::Completed : RangeState::Pending);
     }
     
     m_nextSegmentId.store(maxId + 1);
+    refreshTableLocked();
     
-    qDebug() << "SegmentScheduler: Restored" << snapshots.size() << "segments,"
+    qDebug() << "SegmentScheduler: Restored" << layout.size() << "of" << snapshots.size() << "segments,"
              << "pending:" << m_pendingQueue.size()
              << "completed:" << m_completedSegments.size()
              << "failed:" << m_failedSegments.size();
@@ -147,6 +265,33 @@ size_t SegmentScheduler::calculateOptimalSegmentCount(ByteCount totalSize) {
                       static_cast<size_t>(Constants::MAX_SEGMENTS));
 }
 
+SegmentScheduler::ConnectionPlan SegmentScheduler::planConnections(const ServerCapabilities& caps,
+                                                                   size_t segmentCount) {
+    ConnectionPlan plan;
+    segmentCount = std::max<size_t>(segmentCount, 1);
+    
+    if (!caps.canMultiplex() || segmentCount == 1) {
+        // One request in flight per connection
+        plan.connections = segmentCount;
+        plan.streamsPerConnection = 1;
+        plan.protocol = caps.protocol == HttpProtocol::Unknown ? HttpProtocol::Http1 : caps.protocol;
+        return plan;
+    }
+    
+    // Prefer HTTP/3 when the server advertised it, else stay on what the
+    // probe negotiated
+    plan.protocol = caps.advertisesHttp3 ? HttpProtocol::Http3 : caps.protocol;
+    
+    // Fill streams on as few connections as possible
+    plan.connections = std::min(Constants::MAX_MULTIPLEXED_CONNECTIONS,
+                                (segmentCount + Constants::MAX_STREAMS_PER_CONNECTION - 1)
+                                    / Constants::MAX_STREAMS_PER_CONNECTION);
+    plan.connections = std::max<size_t>(plan.connections, 1);
+    plan.streamsPerConnection = std::min(Constants::MAX_STREAMS_PER_CONNECTION,
+                                         (segmentCount + plan.connections - 1) / plan.connections);
+    return plan;
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Segment Access
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -154,26 +299,14 @@ size_t SegmentScheduler::calculateOptimalSegmentCount(ByteCount totalSize) {
 std::vector<Segment*> SegmentScheduler::allSegments() const {
     std::shared_lock lock(m_mutex);
     
-    std::vector<Segment*> result;
-    result.reserve(m_segments.size());
-    
-    for (const auto& seg : m_segments) {
-        result.push_back(seg.get());
-    }
-    
-    return result;
+    return m_segments;
 }
 
 Segment* SegmentScheduler::segment(SegmentId id) const {
     std::shared_lock lock(m_mutex);
     
-    for (const auto& seg : m_segments) {
-        if (seg->id() == id) {
-            return seg.get();
-        }
-    }
-    
-    return nullptr;
+    auto it = m_segmentIndex.find(id);
+    return it != m_segmentIndex.end() ? it->second : nullptr;
 }
 
 size_t SegmentScheduler::segmentCount() const {
@@ -186,15 +319,45 @@ std::vector<Segment*> SegmentScheduler::segmentsInState(SegmentState state) cons
     
     std::vector<Segment*> result;
     
-    for (const auto& seg : m_segments) {
+    for (Segment* seg : m_segments) {
         if (seg->state() == state) {
-            result.push_back(seg.get());
+            result.push_back(seg);
         }
     }
     
     return result;
 }
 
+size_t SegmentScheduler::countInState(SegmentState state) const {
+    std::shared_lock lock(m_mutex);
+    
+    return static_cast<size_t>(std::count_if(m_segments.begin(), m_segments.end(),
+                                             [state](const Segment* seg) { return seg->state() == state; }));
+}
+
+void SegmentScheduler::copyTable(SegmentTable& out) const {
+    std::shared_lock lock(m_mutex);
+    out = m_table;
+}
+
+RangeMap SegmentScheduler::ranges() const {
+    std::shared_lock lock(m_mutex);
+    return m_ranges;
+}
+
+std::vector<Segment::Snapshot> SegmentScheduler::compactSnapshots() const {
+    std::shared_lock lock(m_mutex);
+    
+    std::vector<Segment::Snapshot> snapshots;
+    snapshots.reserve(m_segments.size());
+    
+    for (const Segment* seg : m_segments) {
+        snapshots.push_back(seg->snapshot());
+    }
+    
+    return mergeCompleted(std::move(snapshots));
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Work Distribution - Core Work-Stealing Algorithm
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -208,16 +371,37 @@ Segment* SegmentScheduler::acquireSegment(SegmentWorker* worker) {
     
     // First, try to get from pending queue
     if (!m_pendingQueue.empty()) {
-        Segment* segment = m_pendingQueue.front();
-        m_pendingQueue.pop_front();
+        auto next = nextPendingLocked();
+        Segment* segment = *next;
+        
+        // Other downloads may already hold the host's connections
+        Duration retryIn{0};
+        if (!admitLocked(worker, segment, &retryIn)) {
+            lock.unlock();
+            scheduleHostRetry(retryIn);
+            return nullptr;
+        }
+        m_pendingQueue.erase(next);
+        
+        // Streaming: one window at a time, the rest stays queued
+        std::vector<SegmentId> added;
+        if (m_sequential) {
+            segment = carveWindowLocked(segment, added);
+        }
         
         segment->setState(SegmentState::Active);
+        segment->addWriter();
         m_activeSegments.insert(segment);
-        m_workerAssignments[worker] = segment;
+        trackLocked(segment, RangeState::InFlight);
+        placeLocked(worker, segment);
         
         qDebug() << "SegmentScheduler: Worker acquired segment" << segment->id()
                  << "from pending queue. Range:" << segment->startByte() << "-" << segment->endByte();
         
+        lock.unlock();
+        for (SegmentId id : added) {
+            emit segmentAdded(id);
+        }
         return segment;
     }
     
@@ -231,13 +415,26 @@ void SegmentScheduler::releaseSegment(SegmentWorker* worker, Segment* segment) {
     
     if (!segment) return;
     
-    m_activeSegments.erase(segment);
     m_workerAssignments.erase(worker);
+    auto held = m_workerHosts.find(worker);
+    QString host = held != m_workerHosts.end() ? held->second : QString();
+    releaseHostLocked(worker);
+    
+    // The last writer of a hedged segment settles it; an earlier one may
+    // still be writing its final claimed bytes.
+    if (segment->removeWriter() > 0) {
+        return;
+    }
+    
+    m_activeSegments.erase(segment);
+    trackLocked(segment, segment->state() == SegmentState::Completed ? RangeState::Completed
+                                                                    : RangeState::Pending);
     
     // Place back in appropriate collection based on state
     switch (segment->state()) {
         case SegmentState::Completed:
             m_completedSegments.insert(segment);
+            signalWork();  // Idle workers may now be done
             lock.unlock();
             emit segmentCompleted(segment->id());
             checkAllComplete();
@@ -245,9 +442,9 @@ void SegmentScheduler::releaseSegment(SegmentWorker* worker, Segment* segment) {
             
         case SegmentState::Failed:
             if (segment->canRetry()) {
-                segment->setState(SegmentState::Pending);
-                m_pendingQueue.push_back(segment);
-                m_workCondition.notify_one();
+                // Back off without holding the worker; it moves on to other work
+                segment->incrementRetry();
+                scheduleRetryLocked(segment, HostGovernor::instance().retryDelay(host, segment->retryCount()));
             } else {
                 m_failedSegments.insert(segment);
                 lock.unlock();
@@ -257,12 +454,14 @@ void SegmentScheduler::releaseSegment(SegmentWorker* worker, Segment* segment) {
             
         case SegmentState::Paused:
             m_pendingQueue.push_front(segment);  // High priority for resume
+            signalWork();
             break;
             
         default:
             // Unexpected state - treat as pending
             segment->setState(SegmentState::Pending);
             m_pendingQueue.push_back(segment);
+            signalWork();
             break;
     }
 }
@@ -274,18 +473,50 @@ Segment* SegmentScheduler::stealWork(SegmentWorker* worker) {
         return nullptr;
     }
     
-    // Find the segment with the most remaining bytes
-    Segment* largest = findLargestActiveSegment();
+    // Find the segment with the most remaining bytes; when streaming, the
+    // earliest one with more than a window left instead
+    Segment* sequentialVictim = m_sequential ? findSequentialVictim() : nullptr;
+    Segment* largest = sequentialVictim ? sequentialVictim : findLargestActiveSegment();
     
     if (!largest || !largest->isSplittable()) {
+        // Too little left to split; race the slowest tail instead
+        Segment* hedged = findHedgeCandidate();
+        Duration retryIn{0};
+        if (hedged && !admitLocked(worker, hedged, &retryIn)) {
+            lock.unlock();
+            scheduleHostRetry(retryIn);
+            return nullptr;
+        }
+        if (hedged) {
+            hedged->addHedgeWriter();
+            EngineMetrics::instance().addHedge();
+            if (auto stats = m_workerStats.find(worker); stats != m_workerStats.end()) {
+                ++stats->second.hedges;
+            }
+            placeLocked(worker, hedged);
+            
+            qDebug() << "SegmentScheduler: End-game hedge on segment" << hedged->id()
+                     << "Range:" << hedged->currentByte() << "-" << hedged->endByte();
+        }
+        return hedged;
+    }
+    
+    // The thief downloads from the same hosts as everyone else
+    Duration retryIn{0};
+    if (!admitLocked(worker, largest, &retryIn)) {
+        lock.unlock();
+        scheduleHostRetry(retryIn);
         return nullptr;
     }
     
     // Split the segment
     SegmentId newId = nextSegmentId();
-    auto newSegment = largest->split(newId);
+    auto newSegment = sequentialVictim
+                          ? largest->splitAt(newId, largest->currentByte() + Constants::STREAM_WINDOW)
+                          : largest->split(newId);
     
     if (!newSegment) {
+        releaseHostLocked(worker);
         return nullptr;
     }
     
@@ -293,14 +524,24 @@ Segment* SegmentScheduler::stealWork(SegmentWorker* worker) {
              << "created segment" << newId
              << "Range:" << newSegment->startByte() << "-" << newSegment->endByte();
     
-    Segment* ptr = newSegment.get();
+    Segment* ptr = adoptSegment(std::move(*newSegment));
     ptr->setState(SegmentState::Active);
+    ptr->addWriter();
+    
+    StealEvent steal{now(), 0, largest->id(), newId, ptr->startByte()};
+    if (auto stats = m_workerStats.find(worker); stats != m_workerStats.end()) {
+        ++stats->second.steals;
+        steal.worker = stats->second.slot;
+    }
     
-    m_segments.push_back(std::move(newSegment));
     m_activeSegments.insert(ptr);
-    m_workerAssignments[worker] = ptr;
+    trackLocked(largest, RangeState::InFlight);
+    trackLocked(ptr, RangeState::InFlight);
+    placeLocked(worker, ptr);
     
     lock.unlock();
+    EngineMetrics::instance().addSteal();
+    m_task->trace().recordSteal(steal);
     emit segmentAdded(newId);
     
     return ptr;
@@ -313,7 +554,9 @@ void SegmentScheduler::markCompleted(Segment* segment) {
     
     std::unique_lock lock(m_mutex);
     m_activeSegments.erase(segment);
+    trackLocked(segment, RangeState::Completed);
     m_completedSegments.insert(segment);
+    signalWork();
     lock.unlock();
     
     emit segmentCompleted(segment->id());
@@ -328,11 +571,10 @@ void SegmentScheduler::markFailed(Segment* segment, const QString& error) {
     
     std::unique_lock lock(m_mutex);
     m_activeSegments.erase(segment);
+    trackLocked(segment, RangeState::Pending);
     
     if (segment->canRetry()) {
-        segment->setState(SegmentState::Pending);
-        m_pendingQueue.push_back(segment);
-        m_workCondition.notify_one();
+        scheduleRetryLocked(segment, HostGovernor::instance().retryDelay(QString(), segment->retryCount()));
     } else {
         segment->setState(SegmentState::Failed);
         m_failedSegments.insert(segment);
@@ -348,14 +590,41 @@ void SegmentScheduler::markFailed(Segment* segment, const QString& error) {
 void SegmentScheduler::registerWorker(SegmentWorker* worker) {
     std::unique_lock lock(m_mutex);
     m_workers.insert(worker);
+    // Lowest free slot, so a restarted worker takes over its predecessor's track
+    m_workerStats.erase(worker);
+    int slot = 0;
+    while (std::any_of(m_workerStats.begin(), m_workerStats.end(),
+                       [slot](const auto& entry) { return entry.second.slot == slot; })) {
+        ++slot;
+    }
     m_workerStats[worker] = WorkerStats{worker, nullptr, 0.0, 0, Timestamp{}};
+    m_workerStats[worker].slot = slot;
 }
 
 void SegmentScheduler::unregisterWorker(SegmentWorker* worker) {
     std::unique_lock lock(m_mutex);
     m_workers.erase(worker);
     m_workerAssignments.erase(worker);
+    releaseHostLocked(worker);
     m_workerStats.erase(worker);
+    m_workerSources.erase(worker);
+    m_workerInterfaces.erase(worker);
+}
+
+void SegmentScheduler::recordAttempt(SegmentWorker* worker, TransferAttempt attempt) {
+    {
+        std::unique_lock lock(m_mutex);
+        auto it = m_workerStats.find(worker);
+        if (it != m_workerStats.end()) {
+            WorkerStats& stats = it->second;
+            attempt.worker = stats.slot;
+            ++stats.attempts;
+            stats.retries += attempt.retry > 0 ? 1 : 0;
+            stats.writeStall += attempt.writeStall;
+            stats.lastAttempt = attempt;
+        }
+    }
+    m_task->trace().record(attempt);
 }
 
 size_t SegmentScheduler::activeWorkerCount() const {
@@ -368,34 +637,206 @@ void SegmentScheduler::notifyWorkerIdle(SegmentWorker* /*worker*/) {
 }
 
 void SegmentScheduler::wakeAllWorkers() {
-    m_workCondition.notify_all();
+    std::unique_lock lock(m_mutex);
+    signalWork();
+}
+
+void SegmentScheduler::scheduleHostRetry(Duration delay) {
+    // Worker threads get here; the timer belongs to the scheduler's thread.
+    // One pending wake-up is enough for all of a task's waiting workers.
+    if (m_hostRetryQueued.exchange(true)) {
+        return;
+    }
+    Duration wait = delay > Duration(0) ? std::min(delay, Constants::MAX_RETRY_AFTER)
+                                        : Constants::HOST_SLOT_POLL;
+    QMetaObject::invokeMethod(this, [this, wait]() {
+        m_hostTimer->start(static_cast<int>(wait.count()));
+    }, Qt::QueuedConnection);
+}
+
+void SegmentScheduler::scheduleRetryLocked(Segment* segment, Duration delay) {
+    // Note: Caller must hold m_mutex exclusively
+    segment->setState(SegmentState::Pending);
+    bool idle = m_retryWheel.empty();
+    m_retryWheel.schedule(segment, now() + delay);
+    
+    qDebug() << "SegmentScheduler: Segment" << segment->id() << "retry" << segment->retryCount()
+             << "in" << delay.count() << "ms";
+    
+    // Worker threads get here; the tick belongs to the scheduler's thread
+    if (idle) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_retryTimer->isActive()) {
+                m_retryTimer->start();
+            }
+        }, Qt::QueuedConnection);
+    }
 }
 
-bool SegmentScheduler::waitForWork(Duration timeout) {
+void SegmentScheduler::onRetryTimer() {
     std::unique_lock lock(m_mutex);
     
-    // Check if there's work available
-    if (!m_pendingQueue.empty() || !m_activeSegments.empty()) {
-        return true;
+    std::vector<Segment*> due = m_retryWheel.advance(now());
+    for (Segment* segment : due) {
+        m_pendingQueue.push_back(segment);
+    }
+    if (!due.empty()) {
+        signalWork();
     }
+    if (m_retryWheel.empty()) {
+        m_retryTimer->stop();
+    }
+}
+
+void SegmentScheduler::onHostTimer() {
+    // Slots freed by other downloads are not signalled here; look again
+    m_hostRetryQueued.store(false);
+    wakeAllWorkers();
+}
+
+uint64_t SegmentScheduler::workGeneration() const {
+    std::shared_lock lock(m_mutex);
+    return m_workGeneration;
+}
+
+bool SegmentScheduler::waitForWork(uint64_t generation) {
+    std::unique_lock lock(m_mutex);
     
-    // Wait for work or timeout
-    return m_workCondition.wait_for(lock, timeout, [this]() {
-        return !m_pendingQueue.empty() || m_cancelled || m_paused;
+    // No timeout: everything that can make work appear signals the condition
+    m_workCondition.wait(lock, [this, generation]() {
+        return m_workGeneration != generation || m_cancelled || isAllCompleteLocked();
     });
+    
+    return !m_cancelled && !isAllCompleteLocked();
+}
+
+SourceId SegmentScheduler::sourceOf(SegmentWorker* worker) const {
+    std::shared_lock lock(m_mutex);
+    auto it = m_workerSources.find(worker);
+    return it != m_workerSources.end() ? it->second : 0;
+}
+
+void SegmentScheduler::setInterfaces(const QStringList& interfaces) {
+    std::unique_lock lock(m_mutex);
+    
+    QStringList current;
+    for (const auto& lane : m_interfaces) {
+        current.append(lane.name);
+    }
+    if (current == interfaces) {
+        return;
+    }
+    
+    // Running transfers keep their socket; workers move with their next segment
+    m_interfaces.clear();
+    for (const QString& name : interfaces) {
+        if (!name.trimmed().isEmpty()) {
+            m_interfaces.push_back(InterfaceStats{name.trimmed()});
+        }
+    }
+    m_workerInterfaces.clear();
+}
+
+QString SegmentScheduler::interfaceOf(SegmentWorker* worker) const {
+    std::shared_lock lock(m_mutex);
+    auto it = m_workerInterfaces.find(worker);
+    return it != m_workerInterfaces.end() && it->second < m_interfaces.size()
+               ? m_interfaces[it->second].name
+               : QString();
+}
+
+void SegmentScheduler::signalWork() {
+    // Note: Caller must hold m_mutex
+    ++m_workGeneration;
+    m_workCondition.notify_all();
+    
+    TransferEngine& engine = TransferEngine::instance();
+    if (engine.isRunning()) {
+        engine.wakeIdleWorkers();
+    }
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
 // Throughput Monitoring
 // ═══════════════════════════════════════════════════════════════════════════════
 
-void SegmentScheduler::reportThroughput(SegmentWorker* worker, SpeedBps bytesPerSecond) {
+void SegmentScheduler::sampleThroughput() {
     std::unique_lock lock(m_mutex);
     
-    auto it = m_workerStats.find(worker);
-    if (it != m_workerStats.end()) {
-        it->second.throughput = bytesPerSecond;
-        it->second.lastUpdate = std::chrono::system_clock::now();
+    // Fold progress since the last tick into the map, so the largest
+    // in-flight run stays a good guess for work stealing
+    for (auto* segment : m_activeSegments) {
+        trackLocked(segment, RangeState::InFlight);
+    }
+    refreshTableLocked();
+    
+    Timestamp sampled = m_clock ? Timestamp(std::chrono::duration_cast<Timestamp::duration>(
+                                      m_clock().time_since_epoch()))
+                                : std::chrono::system_clock::now();
+    const double timeConstant = std::chrono::duration<double>(Constants::THROUGHPUT_TIME_CONSTANT).count();
+    
+    for (auto& [worker, stats] : m_workerStats) {
+        ByteCount bytes = worker->totalBytesDownloaded();
+        
+        // First sample only establishes the baseline
+        if (stats.lastUpdate == Timestamp{}) {
+            stats.bytesDownloaded = bytes;
+            stats.lastUpdate = sampled;
+            continue;
+        }
+        
+        double seconds = std::chrono::duration<double>(sampled - stats.lastUpdate).count();
+        if (seconds <= 0.0) {
+            continue;
+        }
+        
+        // Exponential smoothing that stays correct for uneven timer ticks
+        SpeedBps instant = static_cast<double>(bytes - stats.bytesDownloaded) / seconds;
+        double alpha = 1.0 - std::exp(-seconds / timeConstant);
+        stats.throughput += alpha * (instant - stats.throughput);
+        stats.bytesDownloaded = bytes;
+        stats.lastUpdate = sampled;
+        
+        worker->setMeasuredSpeed(stats.throughput);
+    }
+    
+    // Per-source sums drive mirror weighting and demotion
+    SourceSet& sources = m_task->sources();
+    if (sources.size() > 1) {
+        std::vector<SpeedBps> throughput(sources.size(), 0.0);
+        for (const auto& [worker, source] : m_workerSources) {
+            auto stats = m_workerStats.find(worker);
+            if (stats != m_workerStats.end() && m_workerAssignments.count(worker) && source < throughput.size()) {
+                throughput[source] += stats->second.throughput;
+            }
+        }
+        sources.sample(throughput, workersPerSourceLocked());
+    }
+    
+    // Per-interface sums drive multipath placement; an idle interface
+    // keeps its last rate so it is not mistaken for an unmeasured one
+    if (!m_interfaces.empty()) {
+        std::vector<SpeedBps> throughput(m_interfaces.size(), 0.0);
+        for (const auto& [worker, lane] : m_workerInterfaces) {
+            auto stats = m_workerStats.find(worker);
+            if (stats != m_workerStats.end() && m_workerAssignments.count(worker) && lane < throughput.size()) {
+                throughput[lane] += stats->second.throughput;
+            }
+        }
+        std::vector<size_t> workers = workersPerInterfaceLocked();
+        for (size_t i = 0; i < m_interfaces.size(); ++i) {
+            m_interfaces[i].workers = workers[i];
+            if (workers[i] > 0 && throughput[i] > 0.0) {
+                m_interfaces[i].throughput = throughput[i];
+                m_interfaces[i].measured = true;
+            }
+        }
+    }
+    
+    // Entering the end game is the one change that makes work appear
+    // without an event of its own; tell idle workers about the hedge
+    if (m_workerAssignments.size() < m_workers.size() && findHedgeCandidate()) {
+        signalWork();
     }
 }
 
@@ -418,11 +859,20 @@ std::vector<SegmentScheduler::WorkerStats> SegmentScheduler::workerStats() const
     
     for (const auto& [worker, stats] : m_workerStats) {
         result.push_back(stats);
+        auto lane = m_workerInterfaces.find(worker);
+        if (lane != m_workerInterfaces.end() && lane->second < m_interfaces.size()) {
+            result.back().networkInterface = m_interfaces[lane->second].name;
+        }
     }
     
     return result;
 }
 
+std::vector<SegmentScheduler::InterfaceStats> SegmentScheduler::interfaceStats() const {
+    std::shared_lock lock(m_mutex);
+    return m_interfaces;
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Rebalancing
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -477,9 +927,10 @@ void SegmentScheduler::rebalanceSegments() {
             auto newSegment = segment->split(newId);
             
             if (newSegment) {
-                Segment* ptr = newSegment.get();
-                m_segments.push_back(std::move(newSegment));
+                Segment* ptr = adoptSegment(std::move(*newSegment));
                 m_pendingQueue.push_back(ptr);
+                trackLocked(segment, RangeState::InFlight);
+                trackLocked(ptr, RangeState::Pending);
                 ++splitCount;
                 
                 qDebug() << "SegmentScheduler: Rebalance split segment" << segment->id()
@@ -489,8 +940,9 @@ void SegmentScheduler::rebalanceSegments() {
     }
     
     if (splitCount > 0) {
-        m_workCondition.notify_all();
+        signalWork();
         lock.unlock();
+        EngineMetrics::instance().addRebalance(splitCount);
         emit rebalanced(splitCount);
     }
 }
@@ -527,7 +979,13 @@ ByteCount SegmentScheduler::totalDownloadedBytes() const {
 
 bool SegmentScheduler::isAllComplete() const {
     std::shared_lock lock(m_mutex);
-    return m_pendingQueue.empty() && m_activeSegments.empty() && m_failedSegments.empty();
+    return isAllCompleteLocked();
+}
+
+bool SegmentScheduler::isAllCompleteLocked() const {
+    // Note: Caller must hold m_mutex
+    return m_pendingQueue.empty() && m_activeSegments.empty() && m_failedSegments.empty() &&
+           m_retryWheel.empty();
 }
 
 bool SegmentScheduler::hasFailed() const {
@@ -541,6 +999,131 @@ void SegmentScheduler::checkAllComplete() {
     }
 }
 
+// ═══════════════════════════════════════════════════════════════════════════════
+// Sequential Mode
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SegmentScheduler::setSequential(bool enabled) {
+    std::unique_lock lock(m_mutex);
+    m_sequential = enabled;
+}
+
+bool SegmentScheduler::isSequential() const {
+    std::shared_lock lock(m_mutex);
+    return m_sequential;
+}
+
+void SegmentScheduler::setReadPosition(ByteOffset position) {
+    std::unique_lock lock(m_mutex);
+    m_readPosition = std::max<ByteOffset>(position, 0);
+}
+
+ByteOffset SegmentScheduler::contiguousEnd(ByteOffset from) const {
+    std::shared_lock lock(m_mutex);
+    
+    std::vector<const Segment*> order;
+    order.reserve(m_segments.size());
+    for (const Segment* segment : m_segments) {
+        if (segment->totalSize() > 0) {
+            order.push_back(segment);
+        }
+    }
+    std::sort(order.begin(), order.end(), [](const Segment* a, const Segment* b) {
+        return a->startByte() < b->startByte();
+    });
+    
+    // Segments tile the file; walk them while each one is on disk to its end
+    ByteOffset position = from;
+    for (const Segment* segment : order) {
+        if (segment->endByte() < position) {
+            continue;
+        }
+        if (segment->startByte() > position) {
+            break;
+        }
+        
+        // Claimed bytes count as pending until they are in the file
+        ByteOffset durable = std::min(segment->durableByte(), segment->endByte() + 1);
+        if (durable <= position) {
+            break;
+        }
+        position = durable;
+        if (position <= segment->endByte()) {
+            break;
+        }
+    }
+    return position;
+}
+
+std::deque<Segment*>::iterator SegmentScheduler::nextPendingLocked() {
+    // Note: Caller must hold m_mutex exclusively
+    if (!m_sequential) {
+        return m_pendingQueue.begin();
+    }
+    
+    // The piece holding or following the read position, else the earliest
+    auto ahead = m_pendingQueue.end();
+    auto earliest = m_pendingQueue.end();
+    for (auto it = m_pendingQueue.begin(); it != m_pendingQueue.end(); ++it) {
+        ByteOffset from = (*it)->currentByte();
+        if (earliest == m_pendingQueue.end() || from < (*earliest)->currentByte()) {
+            earliest = it;
+        }
+        if ((*it)->endByte() >= m_readPosition &&
+            (ahead == m_pendingQueue.end() || from < (*ahead)->currentByte())) {
+            ahead = it;
+        }
+    }
+    return ahead != m_pendingQueue.end() ? ahead : earliest;
+}
+
+Segment* SegmentScheduler::carveWindowLocked(Segment* segment, std::vector<SegmentId>& added) {
+    // Note: Caller must hold m_mutex exclusively; the segment is off the queue
+    if (segment->totalSize() <= 0) {
+        return segment;
+    }
+    
+    // A seek into the middle: the reader's bytes first, the head later
+    if (segment->currentByte() < m_readPosition && m_readPosition <= segment->endByte()) {
+        if (auto tail = segment->splitAt(nextSegmentId(), m_readPosition)) {
+            Segment* ahead = adoptSegment(std::move(*tail));
+            added.push_back(ahead->id());
+            m_pendingQueue.push_back(segment);
+            segment = ahead;
+        }
+    }
+    
+    // The rest goes back to the front of the queue for the next worker
+    if (auto rest = segment->splitAt(nextSegmentId(), segment->currentByte() + Constants::STREAM_WINDOW)) {
+        Segment* later = adoptSegment(std::move(*rest));
+        added.push_back(later->id());
+        m_pendingQueue.push_front(later);
+    }
+    return segment;
+}
+
+Segment* SegmentScheduler::findSequentialVictim() const {
+    // Note: Caller must hold lock
+    
+    // Splitting one window past the earliest current byte keeps the
+    // workers on consecutive windows from the read position on
+    Segment* victim = nullptr;
+    bool victimAhead = false;
+    for (auto* segment : m_activeSegments) {
+        if (segment->totalSize() <= 0 ||
+            segment->remainingBytes() < Constants::STREAM_WINDOW + Constants::MIN_STEAL_SIZE) {
+            continue;
+        }
+        bool ahead = segment->endByte() >= m_readPosition;
+        if (!victim || (ahead && !victimAhead) ||
+            (ahead == victimAhead && segment->currentByte() < victim->currentByte())) {
+            victim = segment;
+            victimAhead = ahead;
+        }
+    }
+    return victim;
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Control
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -553,11 +1136,12 @@ void SegmentScheduler::pauseAll() {
     for (auto* segment : m_activeSegments) {
         segment->setState(SegmentState::Paused);
         m_pendingQueue.push_front(segment);
+        trackLocked(segment, RangeState::Pending);
     }
     m_activeSegments.clear();
     m_workerAssignments.clear();
     
-    m_workCondition.notify_all();
+    signalWork();
     
     if (m_rebalanceTimer->isActive()) {
         m_rebalanceTimer->stop();
@@ -575,7 +1159,7 @@ void SegmentScheduler::resumeAll() {
         }
     }
     
-    m_workCondition.notify_all();
+    signalWork();
     
     if (m_autoRebalance) {
         m_rebalanceTimer->start();
@@ -588,23 +1172,41 @@ void SegmentScheduler::cancelAll() {
     m_paused = false;
     
     m_pendingQueue.clear();
+    m_retryWheel.clear();
     m_activeSegments.clear();
     m_workerAssignments.clear();
     
-    m_workCondition.notify_all();
+    signalWork();
     m_rebalanceTimer->stop();
+    m_retryTimer->stop();
 }
 
 void SegmentScheduler::reset() {
     std::unique_lock lock(m_mutex);
     
     m_segments.clear();
+    m_arena.clear();
+    m_table.resize(0);
     m_pendingQueue.clear();
+    m_retryWheel.clear();
+    m_retryTimer->stop();
     m_activeSegments.clear();
     m_completedSegments.clear();
     m_failedSegments.clear();
+    m_segmentIndex.clear();
+    m_ranges.clear();
     m_workerAssignments.clear();
     m_workerStats.clear();
+    m_workerSources.clear();
+    for (const auto& [worker, host] : m_workerHosts) {
+        HostGovernor::instance().release(host);
+    }
+    m_workerHosts.clear();
+    m_workerInterfaces.clear();
+    for (auto& lane : m_interfaces) {
+        lane.throughput = 0.0;
+        lane.workers = 0;
+    }
     m_nextSegmentId.store(0);
     m_paused = false;
     m_cancelled = false;
@@ -617,6 +1219,16 @@ void SegmentScheduler::reset() {
 Segment* SegmentScheduler::findLargestActiveSegment() const {
     // Note: Caller must hold lock
     
+    // The map's largest in-flight run is the largest remainder as of the
+    // last sample; it only needs checking against the live counters
+    if (auto run = m_ranges.largest(RangeState::InFlight)) {
+        auto it = m_segmentIndex.find(run->owner);
+        if (it != m_segmentIndex.end() && m_activeSegments.count(it->second) && it->second->isSplittable()) {
+            return it->second;
+        }
+    }
+    
+    // Unknown size, or it finished or shrank since: scan
     Segment* largest = nullptr;
     ByteCount maxRemaining = 0;
     
@@ -631,22 +1243,216 @@ Segment* SegmentScheduler::findLargestActiveSegment() const {
     return largest;
 }
 
+Segment* SegmentScheduler::findHedgeCandidate() const {
+    // Note: Caller must hold lock
+    
+    if (!m_pendingQueue.empty()) {
+        return nullptr;
+    }
+    
+    // Only in the end game: duplicate requests are wasted bandwidth otherwise
+    ByteCount remainingTotal = 0;
+    for (auto* segment : m_activeSegments) {
+        remainingTotal += std::max<ByteCount>(segment->remainingBytes(), 0);
+    }
+    if (remainingTotal <= 0 || remainingTotal > Constants::HEDGE_THRESHOLD) {
+        return nullptr;
+    }
+    
+    // Pick the segment that will finish last at its current speed
+    Segment* slowest = nullptr;
+    double worstEta = std::chrono::duration<double>(Constants::HEDGE_MIN_ETA).count();
+    
+    for (const auto& [worker, segment] : m_workerAssignments) {
+        if (segment->state() != SegmentState::Active || segment->writerCount() != 1 ||
+            segment->totalSize() <= 0 || segment->remainingBytes() <= 0) {
+            continue;
+        }
+        
+        auto statsIt = m_workerStats.find(worker);
+        SpeedBps throughput = statsIt != m_workerStats.end() ? statsIt->second.throughput : 0.0;
+        double eta = throughput > 0.0
+                         ? static_cast<double>(segment->remainingBytes()) / throughput
+                         : std::numeric_limits<double>::infinity();
+        
+        if (eta > worstEta) {
+            worstEta = eta;
+            slowest = segment;
+        }
+    }
+    
+    return slowest;
+}
+
 Segment* SegmentScheduler::createNewSegment(ByteOffset start, ByteOffset end) {
-    auto segment = std::make_unique<Segment>(nextSegmentId(), start, end);
-    Segment* ptr = segment.get();
-    m_segments.push_back(std::move(segment));
+    return adoptSegment(Segment(nextSegmentId(), start, end));
+}
+
+Segment* SegmentScheduler::adoptSegment(Segment&& segment) {
+    // Note: Caller must hold m_mutex exclusively
+    Segment* ptr = m_arena.create(std::move(segment));
+    m_segmentIndex[ptr->id()] = ptr;
+    m_segments.push_back(ptr);
     return ptr;
 }
 
+void SegmentScheduler::refreshTableLocked() {
+    // Note: Caller must hold m_mutex exclusively
+    m_table.resize(m_segments.size());
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        const Segment* segment = m_segments[i];
+        m_table.ids[i] = segment->id();
+        m_table.starts[i] = segment->startByte();
+        m_table.currents[i] = segment->currentByte();
+        m_table.ends[i] = segment->endByte();
+        m_table.states[i] = segment->state();
+    }
+}
+
+void SegmentScheduler::trackLocked(const Segment* segment, RangeState state) {
+    // Note: Caller must hold m_mutex exclusively
+    ByteOffset start = segment->startByte();
+    ByteOffset end = segment->endByte();
+    
+    if (state == RangeState::Completed) {
+        m_ranges.assign(start, end, state);
+        return;
+    }
+    
+    // Bytes before the frontier were claimed by a writer and count as received
+    ByteOffset current = std::clamp(segment->currentByte(), start, end + 1);
+    m_ranges.assign(start, current - 1, RangeState::Completed);
+    m_ranges.assign(current, end, state, segment->id());
+}
+
 void SegmentScheduler::scheduleSegment(Segment* segment) {
     std::unique_lock lock(m_mutex);
     segment->setState(SegmentState::Pending);
     m_pendingQueue.push_back(segment);
-    m_workCondition.notify_one();
+    signalWork();
+}
+
+SourceId SegmentScheduler::chooseSourceLocked(SegmentWorker* worker, const Segment* segment) const {
+    // Note: Caller must hold m_mutex
+    SourceSet& sources = m_task->sources();
+    
+    // A body without ranges can only come from the URL that was probed
+    if (sources.size() < 2 || segment->totalSize() <= 0) {
+        return 0;
+    }
+    
+    // A new worker counts as being on the primary until it is placed
+    auto current = m_workerSources.find(worker);
+    return sources.choose(current != m_workerSources.end() ? current->second : 0,
+                          workersPerSourceLocked());
+}
+
+bool SegmentScheduler::admitLocked(SegmentWorker* worker, const Segment* segment, Duration* retryIn) {
+    // Note: Caller must hold m_mutex exclusively
+    releaseHostLocked(worker);
+    
+    SourceId source = chooseSourceLocked(worker, segment);
+    QString host = HostCache::hostKey(m_task->sources().url(source));
+    if (!HostGovernor::instance().tryAcquire(host, retryIn)) {
+        return false;
+    }
+    m_workerHosts[worker] = host;
+    m_workerSources[worker] = source;
+    return true;
+}
+
+void SegmentScheduler::placeLocked(SegmentWorker* worker, Segment* segment) {
+    // Note: Caller must hold m_mutex exclusively; admitLocked() chose the source
+    m_workerAssignments[worker] = segment;
+    assignInterfaceLocked(worker);
+}
+
+void SegmentScheduler::releaseHostLocked(SegmentWorker* worker) {
+    // Note: Caller must hold m_mutex exclusively
+    auto it = m_workerHosts.find(worker);
+    if (it != m_workerHosts.end()) {
+        HostGovernor::instance().release(it->second);
+        m_workerHosts.erase(it);
+    }
+}
+
+std::vector<size_t> SegmentScheduler::workersPerSourceLocked() const {
+    // Note: Caller must hold m_mutex
+    std::vector<size_t> counts(m_task->sources().size(), 0);
+    for (const auto& [worker, source] : m_workerSources) {
+        if (source < counts.size() && m_workerAssignments.count(worker)) {
+            ++counts[source];
+        }
+    }
+    return counts;
+}
+
+void SegmentScheduler::assignInterfaceLocked(SegmentWorker* worker) {
+    // Note: Caller must hold m_mutex exclusively
+    if (m_interfaces.size() < 2) {
+        if (m_interfaces.empty()) {
+            m_workerInterfaces.erase(worker);
+        } else {
+            m_workerInterfaces[worker] = 0;
+        }
+        return;
+    }
+    
+    // A new worker counts as being on the first interface until it is placed
+    size_t& current = m_workerInterfaces.try_emplace(worker, 0).first->second;
+    std::vector<size_t> workers = workersPerInterfaceLocked();
+    
+    // An interface that never carried traffic is assumed as good as the best
+    SpeedBps bestMeasured = 0.0;
+    for (const auto& lane : m_interfaces) {
+        if (lane.measured) {
+            bestMeasured = std::max(bestMeasured, lane.throughput);
+        }
+    }
+    
+    // Share this worker would get: the link's rate over its workers plus one
+    auto expectedRate = [&](size_t index) {
+        const InterfaceStats& lane = m_interfaces[index];
+        SpeedBps rate = lane.measured ? lane.throughput : std::max(bestMeasured, 1.0);
+        size_t others = workers[index] - (index == current && workers[index] > 0 ? 1 : 0);
+        return rate / static_cast<double>(others + 1);
+    };
+    
+    size_t best = 0;
+    SpeedBps bestRate = -1.0;
+    for (size_t i = 0; i < m_interfaces.size(); ++i) {
+        SpeedBps rate = expectedRate(i);
+        if (rate > bestRate) {
+            best = i;
+            bestRate = rate;
+        }
+    }
+    
+    // Stay unless the move is clearly worth a new connection
+    if (current < m_interfaces.size() && current != best &&
+        expectedRate(current) >= bestRate * Constants::MIRROR_SWITCH_RATIO) {
+        return;
+    }
+    current = best;
+}
+
+std::vector<size_t> SegmentScheduler::workersPerInterfaceLocked() const {
+    // Note: Caller must hold m_mutex
+    std::vector<size_t> counts(m_interfaces.size(), 0);
+    for (const auto& [worker, lane] : m_workerInterfaces) {
+        if (lane < counts.size() && m_workerAssignments.count(worker)) {
+            ++counts[lane];
+        }
+    }
+    return counts;
 }
 
 SegmentId SegmentScheduler::nextSegmentId() {
     return m_nextSegmentId.fetch_add(1);
 }
 
+RetryWheel::Clock::time_point SegmentScheduler::now() const {
+    return m_clock ? m_clock() : RetryWheel::Clock::now();
+}
+
 } // namespace OpenIDM
@@ -6,14 +6,36 @@
 #include "openidm/engine/SegmentWorker.h"
 #include "openidm/engine/SegmentScheduler.h"
 #include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/OutputFile.h"
+#include "openidm/engine/DiskWriter.h"
+#include "openidm/engine/EngineMetrics.h"
+#include "openidm/engine/ResumeJournal.h"
+#include "openidm/engine/TransferEngine.h"
+#include "openidm/engine/NetworkProbe.h"
+#include "openidm/engine/HttpHeaderParser.h"
+#include "openidm/engine/HostCache.h"
+#include "openidm/engine/HostGovernor.h"
+#include "openidm/engine/MemoryBudget.h"
+#include "engine/CurlWrapper.h"
 
 #include <curl/curl.h>
 #include <QDebug>
-#include <QDir>
-#include <QFileInfo>
+#include <QHostAddress>
+#include <algorithm>
+#include <cstring>
+#include <utility>
 
 namespace OpenIDM {
 
+namespace {
+
+/// Responses that mean "too many connections, come back later"
+constexpr bool isThrottleStatus(long httpCode) {
+    return httpCode == 429 || httpCode == 503;
+}
+
+} // namespace
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Construction
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -22,15 +44,15 @@ SegmentWorker::SegmentWorker(DownloadTask* task, SegmentScheduler* scheduler, QO
     : QObject(parent)
     , m_task(task)
     , m_scheduler(scheduler)
+    , m_bandwidth(&task->bandwidth())
 {
     setAutoDelete(false);  // We manage lifecycle manually
-    
-    // Reserve space for speed samples
-    m_speedSamples.reserve(Constants::SPEED_HISTORY_SIZE);
 }
 
 SegmentWorker::~SegmentWorker() {
     stop();
+    flushWriteBuffer();
+    returnWriteGrant();
     cleanupCurl();
 }
 
@@ -45,6 +67,7 @@ void SegmentWorker::run() {
     if (!initCurl()) {
         m_state.store(State::Error, std::memory_order_release);
         emit finished();
+        markExited();
         return;
     }
     
@@ -59,53 +82,30 @@ void SegmentWorker::run() {
         if (!shouldContinue()) break;
         
         // Try to acquire a segment
-        Segment* segment = m_scheduler->acquireSegment(this);
+        uint64_t generation = m_scheduler->workGeneration();
+        Segment* segment = acquireNext();
         
         if (!segment) {
-            // No work available - wait for more or termination
-            if (!m_scheduler->waitForWork(std::chrono::seconds(1))) {
-                // Timeout - check if all work is done
-                if (m_scheduler->isAllComplete()) {
-                    break;
-                }
-                continue;
+            // Sleep until the scheduler has news; false = nothing left to do
+            if (!m_scheduler->waitForWork(generation)) {
+                break;
             }
             continue;
         }
         
-        // Download the segment
-        m_state.store(State::Downloading, std::memory_order_release);
-        emit stateChanged(State::Downloading);
-        
-        {
-            QMutexLocker locker(&m_segmentMutex);
-            m_currentSegment = segment;
-        }
-        
-        m_segmentBytesDownloaded.store(0);
-        m_segmentStartTime = std::chrono::system_clock::now();
-        
-        bool success = downloadSegment(segment);
-        
-        {
-            QMutexLocker locker(&m_segmentMutex);
-            m_currentSegment = nullptr;
-        }
-        
-        // Report result to scheduler
-        if (success) {
-            segment->setState(SegmentState::Completed);
-            emit segmentCompleted(segment);
+        // Download the segment (blocking)
+        bool success = false;
+        if (prepareTransfer(segment)) {
+            qDebug() << "SegmentWorker: Downloading segment" << segment->id()
+                     << "Range:" << segment->currentByte() << "-" << segment->endByte();
+            success = completeTransfer(segment, curl_easy_perform(m_curl));
         }
         
-        m_scheduler->releaseSegment(this, segment);
+        finishSegment(segment, success);
         
         if (!success && !shouldContinue()) {
             break;
         }
-        
-        m_state.store(State::Idle, std::memory_order_release);
-        emit stateChanged(State::Idle);
     }
     
     // Cleanup
@@ -114,6 +114,7 @@ void SegmentWorker::run() {
     
     qDebug() << "SegmentWorker: Worker thread finished";
     emit finished();
+    markExited();
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -129,6 +130,23 @@ void SegmentWorker::stop() {
         m_isPaused.store(false, std::memory_order_release);
     }
     m_pauseCondition.wakeAll();
+    
+    // Wake up if waiting for work
+    m_scheduler->wakeAllWorkers();
+}
+
+void SegmentWorker::waitForExit() {
+    QMutexLocker locker(&m_runMutex);
+    while (m_queued) {
+        m_runCondition.wait(&m_runMutex);
+    }
+}
+
+void SegmentWorker::markExited() {
+    // The owner may destroy the worker as soon as the lock is released
+    QMutexLocker locker(&m_runMutex);
+    m_queued = false;
+    m_runCondition.wakeAll();
 }
 
 void SegmentWorker::pause() {
@@ -148,6 +166,40 @@ void SegmentWorker::resume() {
     emit stateChanged(State::Downloading);
 }
 
+void SegmentWorker::releaseProbe() {
+    bool parked = false;
+    {
+        QMutexLocker locker(&m_pauseMutex);
+        m_probeReleased.store(true, std::memory_order_release);
+        parked = std::exchange(m_probeParked, false);
+    }
+    m_pauseCondition.wakeAll();
+    
+    // The engine paused the handle at the gate; curl redelivers the held data
+    if (parked) {
+        TransferEngine::instance().resume(m_curl);
+    }
+}
+
+void SegmentWorker::setPrecondition(const ServerCapabilities& caps) {
+    m_precondition.clear();
+    if (!caps.fromCache) {
+        return;
+    }
+    
+    // Weak ETags (W/"...") never match If-Match
+    if (!caps.etag.isEmpty() && !caps.etag.startsWith(QLatin1String("W/"))) {
+        m_precondition = "If-Match: \"" + caps.etag.toUtf8() + '"';
+    } else if (!caps.lastModified.isEmpty()) {
+        m_precondition = "If-Unmodified-Since: " + caps.lastModified.toUtf8();
+    }
+}
+
+void SegmentWorker::setProtocol(HttpProtocol protocol, bool multiplex) {
+    m_protocol = protocol;
+    m_multiplex = multiplex;
+}
+
 Segment* SegmentWorker::currentSegment() const {
     QMutexLocker locker(&m_segmentMutex);
     return m_currentSegment;
@@ -161,34 +213,102 @@ SpeedBps SegmentWorker::currentSpeed() const {
 // Download Implementation
 // ═══════════════════════════════════════════════════════════════════════════════
 
-bool SegmentWorker::downloadSegment(Segment* segment) {
+Segment* SegmentWorker::acquireNext() {
+    Segment* segment = m_scheduler->acquireSegment(this);
+    if (!segment) {
+        return nullptr;
+    }
+    
+    m_state.store(State::Downloading, std::memory_order_release);
+    emit stateChanged(State::Downloading);
+    
+    {
+        QMutexLocker locker(&m_segmentMutex);
+        m_currentSegment = segment;
+    }
+    
+    m_segmentBytesDownloaded.store(0, std::memory_order_relaxed);
+    m_segmentStartTime = std::chrono::system_clock::now();
+    
+    return segment;
+}
+
+bool SegmentWorker::prepareTransfer(Segment* segment) {
     if (!segment || !m_curl) {
         return false;
     }
     
-    // Open temp file for this segment
-    if (!openTempFile(segment)) {
+    // All segments share the task's preallocated output file. The
+    // fast-start probe connects before the task knows which file to open;
+    // it picks the file up once released.
+    bool holding = m_capabilityProbe && !m_probeReleased.load(std::memory_order_acquire);
+    m_output = holding ? nullptr : m_task->outputFile();
+    if (!holding && (!m_output || !m_output->isOpen())) {
         DownloadError error;
         error.category = ErrorCategory::FileSystem;
-        error.message = QStringLiteral("Failed to open temp file: %1").arg(segment->tempFilePath());
+        error.message = QStringLiteral("Output file is not open: %1").arg(m_task->filePath());
         emit errorOccurred(segment, error);
+        m_output = nullptr;
         return false;
     }
     
+    // The scheduler picked a source with the segment
+    m_source = m_scheduler->sourceOf(this);
+    m_verifySource = m_task->sources().needsVerification(m_source);
+    m_probeHeaders = HttpHeaderInfo{};
+    m_interface = m_scheduler->interfaceOf(this).toUtf8();
+    
     // Configure curl for this segment
+    m_streamOffset = segment->currentByte();
     if (!configureCurl(segment)) {
-        closeTempFile();
+        m_output = nullptr;
         return false;
     }
     
-    qDebug() << "SegmentWorker: Downloading segment" << segment->id()
-             << "Range:" << segment->currentByte() << "-" << segment->endByte();
+    // A large receive buffer while memory allows, curl's default otherwise
+    MemoryBudget& budget = MemoryBudget::instance();
+    if (budget.tryReserve(Constants::CURL_BUFFER_SIZE)) {
+        m_receiveBuffer = Constants::CURL_BUFFER_SIZE;
+    } else {
+        m_receiveBuffer = Constants::CURL_MIN_BUFFER_SIZE;
+        budget.reserve(m_receiveBuffer);
+    }
+    curl_easy_setopt(m_curl, CURLOPT_BUFFERSIZE, static_cast<long>(m_receiveBuffer));
+    
+    if constexpr (TransferTrace::ENABLED) {
+        m_attempt = TransferAttempt{};
+        m_attempt.segment = segment->id();
+        m_attempt.source = m_source;
+        m_attempt.startByte = m_streamOffset;
+        m_attempt.retry = segment->retryCount();
+        m_attempt.hedged = segment->isHedged();
+        m_attempt.started = std::chrono::steady_clock::now();
+        m_attemptBaseline = m_totalBytesDownloaded.load(std::memory_order_relaxed);
+    }
     
-    // Perform the download
-    CURLcode result = curl_easy_perform(m_curl);
+    m_inTransfer = true;
+    EngineMetrics::instance().addActiveTransfers(1);
+    return true;
+}
+
+bool SegmentWorker::completeTransfer(Segment* segment, int curlCode) {
+    auto result = static_cast<CURLcode>(curlCode);
+    
+    flushWriteBuffer(segment->isHedged());
+    returnWriteGrant();
+    m_output = nullptr;
+    recordAttempt(curlCode);
+    
+    // The callbacks stop the transfer once the segment has been filled,
+    // either after a work-stealing split or by a hedged twin; that is a
+    // successful completion.
+    if ((result == CURLE_WRITE_ERROR || result == CURLE_ABORTED_BY_CALLBACK) &&
+        segment->totalSize() > 0 && segment->remainingBytes() <= 0) {
+        result = CURLE_OK;
+    }
     
-    // Close file
-    closeTempFile();
+    // While a hedged twin is still streaming it owns the segment's state
+    bool shared = segment->writerCount() > 1;
     
     // Handle result
     if (result != CURLE_OK) {
@@ -198,15 +318,27 @@ bool SegmentWorker::downloadSegment(Segment* segment) {
                 return false;
             }
             if (m_isPaused.load()) {
-                segment->setState(SegmentState::Paused);
+                if (!shared) {
+                    segment->setState(SegmentState::Paused);
+                }
                 return false;
             }
         }
         
-        // Real error
+        // Real error; a mirror that keeps failing is dropped, one that
+        // is merely busy is left to the HostGovernor
         DownloadError error = handleCurlError(result, segment);
-        segment->setLastError(error.message);
-        segment->setState(SegmentState::Failed);
+        if (!isThrottleStatus(error.errorCode)) {
+            m_task->sources().reportFailure(m_source);
+            HostGovernor::instance().reportFailure(sourceHost());
+        }
+        if (!shared) {
+            segment->setLastError(error.message);
+            segment->setState(SegmentState::Failed);
+            if (segment->canRetry()) {
+                EngineMetrics::instance().addRetry(error.category);
+            }
+        }
         emit errorOccurred(segment, error);
         return false;
     }
@@ -218,16 +350,80 @@ bool SegmentWorker::downloadSegment(Segment* segment) {
     if (actual < expected) {
         qWarning() << "SegmentWorker: Segment" << segment->id()
                    << "incomplete. Expected:" << expected << "Got:" << actual;
-        segment->setLastError(QStringLiteral("Incomplete download"));
-        segment->setState(SegmentState::Failed);
+        HostGovernor::instance().reportFailure(sourceHost());
+        if (!shared) {
+            segment->setLastError(QStringLiteral("Incomplete download"));
+            segment->setState(SegmentState::Failed);
+            if (segment->canRetry()) {
+                EngineMetrics::instance().addRetry(ErrorCategory::Network);
+            }
+        }
         return false;
     }
     
     qDebug() << "SegmentWorker: Segment" << segment->id() << "completed successfully";
+    m_task->sources().reportSuccess(m_source);
+    HostGovernor::instance().reportSuccess(sourceHost());
     return true;
 }
 
+void SegmentWorker::recordAttempt(int curlCode) {
+    if constexpr (!TransferTrace::ENABLED) {
+        return;
+    }
+    
+    // Cumulative microseconds since the transfer started
+    auto phase = [this](CURLINFO info) {
+        curl_off_t value = 0;
+        curl_easy_getinfo(m_curl, info, &value);
+        return std::chrono::microseconds(value);
+    };
+    m_attempt.nameLookup = phase(CURLINFO_NAMELOOKUP_TIME_T);
+    m_attempt.connect = phase(CURLINFO_CONNECT_TIME_T);
+    m_attempt.appConnect = phase(CURLINFO_APPCONNECT_TIME_T);
+    m_attempt.startTransfer = phase(CURLINFO_STARTTRANSFER_TIME_T);
+    m_attempt.total = phase(CURLINFO_TOTAL_TIME_T);
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &m_attempt.httpStatus);
+    m_attempt.result = curlCode;
+    m_attempt.bytes = m_totalBytesDownloaded.load(std::memory_order_relaxed) - m_attemptBaseline;
+    
+    m_scheduler->recordAttempt(this, m_attempt);
+}
+
+void SegmentWorker::finishSegment(Segment* segment, bool success) {
+    // Aborted transfers skip completeTransfer()
+    flushWriteBuffer(segment->isHedged());
+    returnWriteGrant();
+    if (std::exchange(m_inTransfer, false)) {
+        EngineMetrics::instance().addActiveTransfers(-1);
+    }
+    MemoryBudget::instance().release(std::exchange(m_receiveBuffer, 0));
+    
+    {
+        QMutexLocker locker(&m_segmentMutex);
+        m_currentSegment = nullptr;
+    }
+    
+    // Report result to scheduler
+    if (success) {
+        segment->setState(SegmentState::Completed);
+        emit segmentCompleted(segment);
+    }
+    
+    m_scheduler->releaseSegment(this, segment);
+    
+    m_state.store(State::Idle, std::memory_order_release);
+    emit stateChanged(State::Idle);
+}
+
 bool SegmentWorker::initCurl() {
+    if (m_curl) {
+        return true;  // Keep the warm handle (and its connection) across segments
+    }
+    
+    // Thread-safe one-time curl_global_init() plus the shared caches
+    CurlGlobalInit& curlGlobal = CurlGlobalInit::instance();
+    
     m_curl = curl_easy_init();
     
     if (!m_curl) {
@@ -235,6 +431,10 @@ bool SegmentWorker::initCurl() {
         return false;
     }
     
+    // Share DNS, TLS sessions and idle connections with every other worker
+    // and with NetworkProbe, so new segments skip the handshake
+    curlGlobal.share().attach(m_curl);
+    
     // Set common options
     curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, 1L);
     curl_easy_setopt(m_curl, CURLOPT_MAXREDIRS, 10L);
@@ -244,8 +444,11 @@ bool SegmentWorker::initCurl() {
     // Timeouts
     curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT_MS, 
                      std::chrono::duration_cast<std::chrono::milliseconds>(Constants::CONNECT_TIMEOUT).count());
-    curl_easy_setopt(m_curl, CURLOPT_LOW_SPEED_LIMIT, 1L);  // 1 byte/sec
-    curl_easy_setopt(m_curl, CURLOPT_LOW_SPEED_TIME, 60L);  // For 60 seconds
+    curl_easy_setopt(m_curl, CURLOPT_LOW_SPEED_LIMIT, Constants::LOW_SPEED_LIMIT);
+    curl_easy_setopt(m_curl, CURLOPT_LOW_SPEED_TIME, Constants::LOW_SPEED_TIME);
+    
+    // Keep idle connections alive for the next (possibly stolen) segment
+    curl_easy_setopt(m_curl, CURLOPT_TCP_KEEPALIVE, 1L);
     
     // SSL verification (enable by default for security)
     curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 1L);
@@ -265,14 +468,42 @@ bool SegmentWorker::configureCurl(Segment* segment) {
         return false;
     }
     
-    // URL
-    QByteArray urlBytes = m_task->url().toUtf8();
+    // URL of the source the scheduler assigned
+    QByteArray urlBytes = m_task->sources().url(m_source).toString().toUtf8();
     curl_easy_setopt(m_curl, CURLOPT_URL, urlBytes.constData());
     
-    // Range header
-    QString range = segment->rangeHeader();
-    QByteArray rangeBytes = range.toUtf8();
-    curl_easy_setopt(m_curl, CURLOPT_RANGE, rangeBytes.constData());
+    // Multipath: bind to the interface the scheduler picked, and resolve
+    // over it when it is named by device. CURLOPT_DNS_INTERFACE needs a
+    // c-ares build; elsewhere the option fails and the system resolver is used.
+    curl_easy_setopt(m_curl, CURLOPT_INTERFACE, m_interface.isEmpty() ? nullptr : m_interface.constData());
+    QByteArray device = m_interface.startsWith("if!") ? m_interface.mid(3) : m_interface;
+    bool byDevice = !device.isEmpty() && !device.contains('!') &&
+                    QHostAddress(QString::fromUtf8(device)).isNull();
+    curl_easy_setopt(m_curl, CURLOPT_DNS_INTERFACE, byDevice ? device.constData() : nullptr);
+    
+    // Range (CURLOPT_RANGE takes "start-end"; curl adds the "bytes=" unit).
+    // Start at the frontier captured in prepareTransfer(): a hedged twin
+    // may move currentByte() at any time.
+    if (segment->totalSize() > 0) {
+        QByteArray rangeBytes = QByteArray::number(m_streamOffset) + '-' + QByteArray::number(segment->endByte());
+        curl_easy_setopt(m_curl, CURLOPT_RANGE, rangeBytes.constData());
+    } else if (m_capabilityProbe) {
+        // Fast start: an open range makes the server state the total size
+        // in Content-Range while the body streams as segment 0
+        QByteArray rangeBytes = QByteArray::number(m_streamOffset) + '-';
+        curl_easy_setopt(m_curl, CURLOPT_RANGE, rangeBytes.constData());
+    } else {
+        curl_easy_setopt(m_curl, CURLOPT_RANGE, nullptr);
+    }
+    
+    // Validators of cached capabilities; a changed resource answers 412.
+    // They belong to the primary URL; mirrors are checked by verifySource().
+    curl_slist_free_all(m_headers);
+    m_headers = nullptr;
+    if (!m_precondition.isEmpty() && segment->totalSize() > 0 && m_source == 0) {
+        m_headers = curl_slist_append(nullptr, m_precondition.constData());
+    }
+    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, m_headers);
     
     // Callbacks
     curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, writeCallback);
@@ -288,56 +519,34 @@ bool SegmentWorker::configureCurl(Segment* segment) {
     // User agent
     curl_easy_setopt(m_curl, CURLOPT_USERAGENT, "OpenIDM/1.0 (https://github.com/openidm)");
     
-    return true;
-}
-
-void SegmentWorker::cleanupCurl() {
-    if (m_curl) {
-        curl_easy_cleanup(m_curl);
-        m_curl = nullptr;
-    }
-}
-
-bool SegmentWorker::openTempFile(Segment* segment) {
-    QString tempPath = segment->tempFilePath();
-    
-    if (tempPath.isEmpty()) {
-        // Generate temp file path
-        QString dir = QFileInfo(m_task->filePath()).path();
-        tempPath = QStringLiteral("%1/.%2.part%3")
-                      .arg(dir)
-                      .arg(QFileInfo(m_task->filePath()).fileName())
-                      .arg(segment->id());
-        segment->setTempFilePath(tempPath);
+    // Protocol: HTTP/3 only if this libcurl was built with it. The plan was
+    // made for the primary's host; mirrors negotiate their own.
+    HttpProtocol protocol = m_source == 0 ? m_protocol : HttpProtocol::Unknown;
+    long httpVersion = CURL_HTTP_VERSION_2TLS;
+#if LIBCURL_VERSION_NUM >= 0x074200  // 7.66.0
+    if (protocol == HttpProtocol::Http3 &&
+        (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP3)) {
+        httpVersion = CURL_HTTP_VERSION_3;
     }
-    
-    // Ensure directory exists
-    QDir().mkpath(QFileInfo(tempPath).path());
-    
-    m_tempFile = std::make_unique<QFile>(tempPath);
-    
-    // Open for append if resuming, otherwise write
-    QIODevice::OpenMode mode = QIODevice::WriteOnly;
-    if (segment->downloadedBytes() > 0) {
-        mode |= QIODevice::Append;
+#endif
+    if (protocol == HttpProtocol::Http1) {
+        httpVersion = CURL_HTTP_VERSION_1_1;
     }
+    curl_easy_setopt(m_curl, CURLOPT_HTTP_VERSION, httpVersion);
     
-    if (!m_tempFile->open(mode)) {
-        qWarning() << "SegmentWorker: Failed to open temp file:" << tempPath
-                   << m_tempFile->errorString();
-        m_tempFile.reset();
-        return false;
-    }
+    // Join an existing multiplexed connection instead of opening a new one
+    curl_easy_setopt(m_curl, CURLOPT_PIPEWAIT, m_multiplex ? 1L : 0L);
     
     return true;
 }
 
-void SegmentWorker::closeTempFile() {
-    if (m_tempFile) {
-        m_tempFile->flush();
-        m_tempFile->close();
-        m_tempFile.reset();
+void SegmentWorker::cleanupCurl() {
+    if (m_curl) {
+        curl_easy_cleanup(m_curl);
+        m_curl = nullptr;
     }
+    curl_slist_free_all(m_headers);
+    m_headers = nullptr;
 }
 
 DownloadError SegmentWorker::handleCurlError(int code, Segment* segment) {
@@ -349,6 +558,16 @@ DownloadError SegmentWorker::handleCurlError(int code, Segment* segment) {
     const char* errorStr = curl_easy_strerror(static_cast<CURLcode>(code));
     error.details = QString::fromUtf8(errorStr);
     
+    // A throttled response is cut off at its headers (checkThrottle())
+    long httpCode = 0;
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    if (code == CURLE_WRITE_ERROR && isThrottleStatus(httpCode)) {
+        error.category = ErrorCategory::ServerError;
+        error.errorCode = httpCode;
+        error.message = QStringLiteral("HTTP error %1: server is throttling connections").arg(httpCode);
+        return error;
+    }
+    
     switch (code) {
         case CURLE_COULDNT_RESOLVE_HOST:
         case CURLE_COULDNT_CONNECT:
@@ -369,8 +588,6 @@ DownloadError SegmentWorker::handleCurlError(int code, Segment* segment) {
             
         case CURLE_HTTP_RETURNED_ERROR:
             error.category = ErrorCategory::ServerError;
-            long httpCode = 0;
-            curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpCode);
             error.errorCode = httpCode;
             error.message = QStringLiteral("HTTP error %1").arg(httpCode);
             break;
@@ -384,41 +601,205 @@ DownloadError SegmentWorker::handleCurlError(int code, Segment* segment) {
     return error;
 }
 
-void SegmentWorker::updateSpeed(ByteCount bytes) {
-    auto now = std::chrono::system_clock::now();
-    
-    QMutexLocker locker(&m_speedMutex);
-    
-    m_speedSamples.push_back({bytes, now});
-    
-    // Remove old samples (older than smoothing window)
-    auto cutoff = now - Constants::SPEED_SMOOTHING_WINDOW;
-    while (!m_speedSamples.empty() && m_speedSamples.front().time < cutoff) {
-        m_speedSamples.erase(m_speedSamples.begin());
+bool SegmentWorker::storeData(Segment* segment, ByteOffset offset, const char* data, size_t length) {
+    // Hedged twins write through: their interleaved claims would break the
+    // in-order flushing that Segment::durableByte() relies on
+    if (segment->isHedged()) {
+        flushWriteBuffer(true);
+        if (!m_output->writeAt(offset, data, length)) {
+            return false;
+        }
+        if (ResumeJournal* journal = m_output->journal()) {
+            journal->recordWrite(*segment, offset, data, length);
+        }
+        segment->completePendingWrite(static_cast<ByteCount>(length));
+        return true;
     }
     
-    // Calculate average speed
-    if (m_speedSamples.size() >= 2) {
-        ByteCount totalBytes = 0;
-        for (const auto& sample : m_speedSamples) {
-            totalBytes += sample.bytes;
+    DiskWriter& writer = DiskWriter::instance();
+    
+    while (length > 0) {
+        // A buffer covers one contiguous range
+        if (m_writeBuffer && m_writeBuffer->end() != offset) {
+            flushWriteBuffer();
+        }
+        if (!m_writeBuffer) {
+            // The engine thread never waits: the write callback took a grant
+            // for this buffer, and one more in the same callback (the range
+            // moved under a steal) is charged past the budget
+            auto charge = std::exchange(m_writeGranted, false) ? DiskWriter::Charge::Granted
+                        : m_engineDriven                       ? DiskWriter::Charge::Force
+                                                               : DiskWriter::Charge::Wait;
+            if constexpr (TransferTrace::ENABLED) {
+                auto waited = std::chrono::steady_clock::now();
+                m_writeBuffer = writer.acquire(m_output, segment, offset, charge);  // Blocks when the disk lags
+                m_attempt.writeStall += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - waited);
+            } else {
+                m_writeBuffer = writer.acquire(m_output, segment, offset, charge);
+            }
         }
         
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            m_speedSamples.back().time - m_speedSamples.front().time
-        );
+        size_t chunk = std::min(length, m_writeBuffer->capacity - m_writeBuffer->length);
+        std::memcpy(m_writeBuffer->data + m_writeBuffer->length, data, chunk);
+        m_writeBuffer->length += chunk;
         
-        if (duration.count() > 0) {
-            SpeedBps speed = static_cast<double>(totalBytes) / (duration.count() / 1000.0);
-            m_currentSpeed.store(speed, std::memory_order_relaxed);
+        if (m_writeBuffer->isFull()) {
+            flushWriteBuffer();
         }
+        
+        data += chunk;
+        offset += static_cast<ByteOffset>(chunk);
+        length -= chunk;
+    }
+    
+    return true;
+}
+
+void SegmentWorker::flushWriteBuffer(bool synchronous) {
+    WriteBuffer* buffer = std::exchange(m_writeBuffer, nullptr);
+    if (!buffer) {
+        return;
+    }
+    
+    if (synchronous && buffer->length > 0) {
+        // Bytes that failed stay pending: they are not in the file
+        if (buffer->file->writeAt(buffer->offset, buffer->data, buffer->length)) {
+            if (ResumeJournal* journal = buffer->file->journal()) {
+                journal->recordWrite(*buffer->segment, buffer->offset, buffer->data, buffer->length);
+            }
+            buffer->segment->completePendingWrite(static_cast<ByteCount>(buffer->length));
+        }
+        buffer->length = 0;  // submit() recycles empty buffers
+    }
+    
+    DiskWriter::instance().submit(buffer);
+}
+
+void SegmentWorker::returnWriteGrant() {
+    if (std::exchange(m_writeGranted, false)) {
+        DiskWriter::instance().revoke();
     }
 }
 
 void SegmentWorker::waitWhilePaused() {
     QMutexLocker locker(&m_pauseMutex);
+    // resume() and stop() clear the flag under the mutex and wake us
     while (m_isPaused.load(std::memory_order_acquire) && shouldContinue()) {
-        m_pauseCondition.wait(&m_pauseMutex, 100);  // Check every 100ms
+        m_pauseCondition.wait(&m_pauseMutex);
+    }
+}
+
+bool SegmentWorker::waitForProbeRelease() {
+    QMutexLocker locker(&m_pauseMutex);
+    
+    // On the event loop the handle is paused and releaseProbe() unpauses it
+    if (m_engineDriven) {
+        m_probeParked = !m_probeReleased.load(std::memory_order_acquire);
+        return !m_probeParked;
+    }
+    
+    while (!m_probeReleased.load(std::memory_order_acquire) && shouldContinue()) {
+        m_pauseCondition.wait(&m_pauseMutex);
+    }
+    return m_probeReleased.load(std::memory_order_acquire);
+}
+
+bool SegmentWorker::reportCapabilities() {
+    long httpCode = 0;
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    
+    // Interim and followed redirect responses precede the one for the file
+    bool redirect = httpCode >= 300 && httpCode < 400 &&
+                    m_probeHeaders.hasLocation;
+    if (httpCode < 200 || redirect) {
+        return true;
+    }
+    
+    checkThrottle();  // The probe itself fails below
+    ServerCapabilities caps = NetworkProbe::readCapabilities(m_curl, m_probeHeaders);
+    m_probeReported = true;
+    m_probeHeaders = HttpHeaderInfo{};
+    
+    if (!caps.isValid()) {
+        DownloadError error;
+        error.category = (httpCode >= 500) ? ErrorCategory::ServerError : ErrorCategory::ClientError;
+        error.errorCode = httpCode;
+        error.message = QStringLiteral("HTTP error %1").arg(httpCode);
+        
+        m_shouldStop.store(true, std::memory_order_release);
+        emit probeFailed(error);
+        return false;
+    }
+    
+    qDebug() << "SegmentWorker: Fast start. Status:" << httpCode
+             << "Size:" << caps.contentLength << "Ranges:" << caps.supportsRanges
+             << "Protocol:" << httpProtocolToString(caps.protocol);
+    
+    emit capabilitiesReceived(caps);
+    return true;
+}
+
+bool SegmentWorker::checkPreconditions() {
+    long httpCode = 0;
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    
+    // 412: a validator no longer matches; 416: the file shrank below our range
+    if (httpCode != 412 && httpCode != 416) {
+        return true;
+    }
+    
+    qWarning() << "SegmentWorker: HTTP" << httpCode << "- resource changed on the server";
+    m_shouldStop.store(true, std::memory_order_release);
+    emit resourceChanged(static_cast<int>(httpCode));
+    return false;
+}
+
+QString SegmentWorker::sourceHost() const {
+    return HostCache::hostKey(m_task->sources().url(m_source));
+}
+
+bool SegmentWorker::checkThrottle() {
+    long httpCode = 0;
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    if (!isThrottleStatus(httpCode)) {
+        return true;
+    }
+    
+    // The body is an error page, not file data; the segment is retried
+    // once the governor lets the host have a connection again
+    qWarning() << "SegmentWorker: HTTP" << httpCode << "- host is throttling, Retry-After:"
+               << m_probeHeaders.retryAfter.count() << "ms";
+    HostGovernor::instance().reportThrottled(sourceHost(),
+                                             m_probeHeaders.retryAfter);
+    return false;
+}
+
+bool SegmentWorker::verifySource() {
+    long httpCode = 0;
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    
+    bool redirect = httpCode >= 300 && httpCode < 400 &&
+                    m_probeHeaders.hasLocation;
+    if (httpCode < 200 || redirect) {
+        return true;
+    }
+    
+    ServerCapabilities caps = NetworkProbe::readCapabilities(m_curl, m_probeHeaders);
+    m_verifySource = false;
+    m_probeHeaders = HttpHeaderInfo{};
+    
+    // A dropped mirror fails this segment; the retry goes to another source
+    return m_task->sources().verify(m_source, caps);
+}
+
+void SegmentWorker::waitForBandwidth(Duration wait) {
+    // Sleep in short slices so stop/pause stay responsive
+    QMutexLocker locker(&m_pauseMutex);
+    while (wait.count() > 0 && shouldContinue() && !isPaused()) {
+        auto slice = std::min(wait, Constants::PROGRESS_UPDATE_INTERVAL);
+        m_pauseCondition.wait(&m_pauseMutex, static_cast<unsigned long>(slice.count()));
+        wait = m_bandwidth.delay();
     }
 }
 
@@ -430,34 +811,96 @@ size_t SegmentWorker::writeCallback(char* ptr, size_t size, size_t nmemb, void*
     auto* worker = static_cast<SegmentWorker*>(userdata);
     size_t totalSize = size * nmemb;
     
-    if (!worker->m_tempFile || !worker->m_tempFile->isOpen()) {
+    // The fast-start probe holds its data until the task has opened the file
+    if (worker->m_capabilityProbe && !worker->m_probeReleased.load(std::memory_order_acquire)) {
+        if (!worker->waitForProbeRelease()) {
+            return worker->m_engineDriven && worker->shouldContinue() ? CURL_WRITEFUNC_PAUSE : 0;
+        }
+    }
+    if (!worker->m_output && worker->m_capabilityProbe) {
+        worker->m_output = worker->m_task->outputFile();
+    }
+    
+    Segment* segment = worker->currentSegment();
+    if (!worker->m_output || !segment || worker->m_output->hasFailed()) {
         return 0;  // Abort transfer
     }
     
-    // Write to temp file
-    qint64 written = worker->m_tempFile->write(ptr, totalSize);
+    // Once a bucket in the chain is in debt, hold this data back. On the
+    // event loop the handle is paused (curl redelivers the same data when
+    // unpaused); a pooled thread simply sleeps.
+    if (worker->m_bandwidth.isLimited()) {
+        Duration wait = worker->m_bandwidth.delay();
+        if (wait.count() > 0) {
+            if (worker->m_engineDriven) {
+                TransferEngine::instance().resumeLater(worker->m_curl, wait);
+                return CURL_WRITEFUNC_PAUSE;
+            }
+            worker->waitForBandwidth(wait);
+        }
+    }
     
-    if (written != static_cast<qint64>(totalSize)) {
-        qWarning() << "SegmentWorker: Write failed, expected:" << totalSize
-                   << "written:" << written;
-        return 0;  // Abort transfer
+    // Out of memory budget: leave the data with curl, and the rest with the
+    // server, until a write-behind buffer is released. Pooled threads block
+    // in DiskWriter::acquire() instead.
+    if (worker->m_engineDriven && !segment->isHedged()) {
+        const WriteBuffer* buffer = worker->m_writeBuffer;
+        bool needsBuffer = !buffer || buffer->end() != worker->m_streamOffset ||
+                           buffer->capacity - buffer->length < totalSize;
+        CURL* easy = worker->m_curl;
+        if (needsBuffer && !worker->m_writeGranted) {
+            if (!DiskWriter::instance().admit([easy]() { TransferEngine::instance().resume(easy); })) {
+                return CURL_WRITEFUNC_PAUSE;
+            }
+            worker->m_writeGranted = true;  // Reserved for storeData()'s acquire()
+        }
     }
     
-    // Update segment progress
-    Segment* segment = worker->currentSegment();
-    if (segment) {
-        segment->advanceBy(totalSize);
-        segment->updateChecksum(ptr, totalSize);
+    // Only bytes beyond the segment's frontier are ours to write: a hedged
+    // twin may already have delivered them, and a steal may have moved the
+    // end below the range we requested (the thief owns those bytes now).
+    ByteOffset streamPos = worker->m_streamOffset;
+    worker->m_streamOffset += static_cast<ByteOffset>(totalSize);
+    
+    // The bytes count as pending before the frontier moves over them, so
+    // durableByte() never covers a claim that storeData() has not queued
+    // (acquire() may block in between); the unclaimed rest is given back
+    ByteOffset writeFrom = streamPos;
+    segment->addPendingWrite(static_cast<ByteCount>(totalSize));
+    ByteCount claimed = segment->claim(streamPos, static_cast<ByteCount>(totalSize), &writeFrom);
+    segment->completePendingWrite(static_cast<ByteCount>(totalSize) - claimed);
+    const char* data = ptr + (writeFrom - streamPos);
+    
+    // Store at the claimed absolute position in the final file
+    if (claimed > 0 && !worker->storeData(segment, writeFrom, data, static_cast<size_t>(claimed))) {
+        qWarning() << "SegmentWorker: Write failed at offset" << writeFrom
+                   << worker->m_output->errorString();
+        return 0;  // Abort transfer
     }
     
-    // Update worker statistics
-    worker->m_segmentBytesDownloaded.fetch_add(totalSize);
-    worker->m_totalBytesDownloaded.fetch_add(totalSize);
-    worker->updateSpeed(totalSize);
+    // The rolling checksum needs in-order data from a single writer
+    if (claimed > 0 && !segment->isHedged()) {
+        segment->updateChecksum(writeFrom, data, static_cast<size_t>(claimed));
+    }
     
-    // Report throughput to scheduler
-    worker->m_scheduler->reportThroughput(worker, worker->currentSpeed());
+    // Update worker statistics; this thread is the only writer, so plain
+    // relaxed stores suffice and the progress timer samples them lock-free
+    worker->m_segmentBytesDownloaded.store(
+        worker->m_segmentBytesDownloaded.load(std::memory_order_relaxed) + claimed,
+        std::memory_order_relaxed);
+    worker->m_totalBytesDownloaded.store(
+        worker->m_totalBytesDownloaded.load(std::memory_order_relaxed) + claimed,
+        std::memory_order_relaxed);
+    worker->m_bandwidth.consume(static_cast<ByteCount>(totalSize));
+    if (claimed > 0) {
+        EngineMetrics::instance().addBytesReceived(claimed);
+    }
     
+    // Returning a short count ends the transfer once the segment is full
+    if (segment->totalSize() > 0 && segment->remainingBytes() <= 0 &&
+        static_cast<size_t>(claimed) < totalSize) {
+        return 0;
+    }
     return totalSize;
 }
 
@@ -476,28 +919,54 @@ int SegmentWorker::progressCallback(void* clientp,
         return 1;  // Abort to pause
     }
     
-    // Emit progress periodically
-    auto now = std::chrono::system_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - worker->m_lastProgressReport
-    );
-    
-    if (elapsed >= Constants::PROGRESS_UPDATE_INTERVAL) {
-        worker->m_lastProgressReport = now;
-        emit worker->progressUpdated(
-            worker->m_segmentBytesDownloaded.load(),
-            worker->currentSpeed()
-        );
+    // Lost a hedged race: the twin filled the segment while we stalled
+    Segment* segment = worker->currentSegment();
+    if (segment && segment->totalSize() > 0 && segment->remainingBytes() <= 0) {
+        return 1;
     }
     
+    // Progress is sampled from the counters by the task's progress timer
     return 0;  // Continue transfer
 }
 
-size_t SegmentWorker::headerCallback(char* buffer, size_t size, size_t nitems, void* /*userdata*/) {
+size_t SegmentWorker::headerCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* worker = static_cast<SegmentWorker*>(userdata);
     size_t totalSize = size * nitems;
     
-    // Parse headers if needed (e.g., for Content-Range validation)
-    // QString header = QString::fromUtf8(buffer, totalSize).trimmed();
+    // A blank line ends the header block
+    bool endOfHeaders = (totalSize == 2 && buffer[0] == '\r' && buffer[1] == '\n') ||
+                        (totalSize == 1 && buffer[0] == '\n');
+    
+    if (worker->m_capabilityProbe && !worker->m_probeReported) {
+        // Every response in a redirect chain starts with its own status
+        // line, which resets the parsed headers
+        HttpHeaderParser::parseLine(std::string_view(buffer, totalSize), worker->m_probeHeaders);
+        
+        if (endOfHeaders && !worker->reportCapabilities()) {
+            return 0;  // Abort transfer
+        }
+        return totalSize;
+    }
+    
+    // Status lines always; other headers to check a mirror, or for the
+    // Retry-After of a throttled response
+    std::string_view line(buffer, totalSize);
+    if (worker->m_verifySource || line.substr(0, 5) == "HTTP/" ||
+        isThrottleStatus(worker->m_probeHeaders.statusCode)) {
+        HttpHeaderParser::parseLine(line, worker->m_probeHeaders);
+    }
+    
+    if (endOfHeaders && !worker->checkThrottle()) {
+        return 0;  // Abort transfer
+    }
+    
+    if (worker->m_verifySource && endOfHeaders && !worker->verifySource()) {
+        return 0;  // Abort transfer
+    }
+    
+    if (endOfHeaders && !worker->checkPreconditions()) {
+        return 0;  // Abort transfer
+    }
     
     return totalSize;
 }
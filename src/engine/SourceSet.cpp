@@ -0,0 +1,295 @@
+/**
+ * @file SourceSet.cpp
+ * @brief Implementation of the per-download mirror set
+ */
+
+#include "openidm/engine/SourceSet.h"
+#include "openidm/engine/TaskRegistry.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <chrono>
+
+namespace OpenIDM {
+
+namespace {
+
+size_t countAt(const std::vector<size_t>& workers, SourceId id) {
+    return id < workers.size() ? workers[id] : 0;
+}
+
+bool isStrongEtag(const QString& etag) {
+    return !etag.isEmpty() && !etag.startsWith(QLatin1String("W/"));
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+SourceSet::SourceSet(const QUrl& primary) {
+    Source source;
+    source.url = primary;
+    source.verified = true;  // The reference itself
+    m_sources.push_back(std::move(source));
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Sources
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SourceSet::setMirrors(const QList<QUrl>& mirrors) {
+    std::lock_guard lock(m_mutex);
+    m_sources.resize(1);
+
+    QStringList seen{TaskRegistry::normalizeUrl(m_sources.front().url)};
+    for (const QUrl& url : mirrors) {
+        QString scheme = url.scheme().toLower();
+        if (!url.isValid() || (scheme != QLatin1String("http") && scheme != QLatin1String("https"))) {
+            continue;
+        }
+        QString key = TaskRegistry::normalizeUrl(url);
+        if (seen.contains(key)) {
+            continue;
+        }
+        seen.push_back(key);
+
+        Source source;
+        source.url = url;
+        m_sources.push_back(std::move(source));
+    }
+}
+
+QList<QUrl> SourceSet::mirrors() const {
+    std::lock_guard lock(m_mutex);
+    QList<QUrl> result;
+    for (size_t i = 1; i < m_sources.size(); ++i) {
+        result.push_back(m_sources[i].url);
+    }
+    return result;
+}
+
+size_t SourceSet::size() const {
+    std::lock_guard lock(m_mutex);
+    return m_sources.size();
+}
+
+QUrl SourceSet::url(SourceId id) const {
+    std::lock_guard lock(m_mutex);
+    return id < m_sources.size() ? m_sources[id].url : m_sources.front().url;
+}
+
+std::vector<SourceSet::Source> SourceSet::sources() const {
+    std::lock_guard lock(m_mutex);
+    return m_sources;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Verification
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SourceSet::setReference(const ServerCapabilities& caps, bool haveHash) {
+    std::lock_guard lock(m_mutex);
+    m_reference = caps;
+    m_haveHash = haveHash;
+
+    // A new reference (e.g. after a 412) must be matched again
+    for (size_t i = 1; i < m_sources.size(); ++i) {
+        m_sources[i].verified = false;
+    }
+}
+
+bool SourceSet::needsVerification(SourceId id) const {
+    std::lock_guard lock(m_mutex);
+    return id > 0 && id < m_sources.size() && !m_sources[id].verified &&
+           m_sources[id].state != State::Dropped;
+}
+
+bool SourceSet::verify(SourceId id, const ServerCapabilities& response) {
+    std::lock_guard lock(m_mutex);
+    if (id == 0 || id >= m_sources.size()) {
+        return true;
+    }
+    Source& source = m_sources[id];
+    if (source.verified || source.state == State::Dropped) {
+        return source.state != State::Dropped;
+    }
+
+    QString reason;
+    if (response.httpStatusCode != 206) {
+        reason = QStringLiteral("answered HTTP %1 to a range request").arg(response.httpStatusCode);
+    } else if (m_reference.contentLength > 0 && response.contentLength != m_reference.contentLength) {
+        reason = QStringLiteral("reports %1 bytes, expected %2")
+                     .arg(response.contentLength).arg(m_reference.contentLength);
+    } else if (!m_haveHash && isStrongEtag(m_reference.etag) && isStrongEtag(response.etag) &&
+               response.etag != m_reference.etag) {
+        // Without a digest to check the result, only the validator can
+        // tell that two servers hold the same bytes
+        reason = QStringLiteral("has ETag %1, expected %2").arg(response.etag, m_reference.etag);
+    }
+
+    if (!reason.isEmpty()) {
+        dropLocked(id, reason);
+        return false;
+    }
+
+    source.verified = true;
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Health
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SourceSet::reportSuccess(SourceId id) {
+    std::lock_guard lock(m_mutex);
+    if (id < m_sources.size()) {
+        m_sources[id].failures = 0;
+    }
+}
+
+void SourceSet::reportFailure(SourceId id) {
+    std::lock_guard lock(m_mutex);
+    if (id >= m_sources.size() || m_sources[id].state == State::Dropped) {
+        return;
+    }
+    if (++m_sources[id].failures >= Constants::MIRROR_MAX_FAILURES) {
+        dropLocked(id, QStringLiteral("failed %1 segments in a row").arg(m_sources[id].failures));
+    }
+}
+
+void SourceSet::sample(const std::vector<SpeedBps>& throughput, const std::vector<size_t>& workers) {
+    std::lock_guard lock(m_mutex);
+    if (m_sources.size() < 2) {
+        return;
+    }
+
+    auto now = std::chrono::system_clock::now();
+
+    // Best per-connection speed among sources that are in use
+    SpeedBps best = 0.0;
+    for (SourceId id = 0; id < m_sources.size(); ++id) {
+        Source& source = m_sources[id];
+        size_t count = countAt(workers, id);
+        if (count == 0) {
+            continue;
+        }
+        source.throughput = id < throughput.size() ? throughput[id] : 0.0;
+        source.measured = true;
+        if (source.state == State::Active) {
+            best = std::max(best, source.throughput / static_cast<double>(count));
+        }
+    }
+
+    for (SourceId id = 0; id < m_sources.size(); ++id) {
+        Source& source = m_sources[id];
+
+        // Probation over: measure it again from scratch
+        if (source.state == State::Demoted && now - source.demotedAt >= Constants::MIRROR_PROBATION) {
+            source.state = State::Active;
+            source.measured = false;
+            source.slowSince = Timestamp{};
+            qDebug() << "SourceSet: Retrying demoted source" << source.url.toString();
+            continue;
+        }
+
+        size_t count = countAt(workers, id);
+        if (source.state != State::Active || count == 0 || best <= 0.0) {
+            continue;
+        }
+
+        bool slow = source.throughput / static_cast<double>(count) < best * Constants::MIRROR_DEMOTE_RATIO;
+        if (!slow) {
+            source.slowSince = Timestamp{};
+        } else if (source.slowSince == Timestamp{}) {
+            source.slowSince = now;
+        } else if (now - source.slowSince >= Constants::MIRROR_DEMOTE_AFTER && usableCountLocked() > 1) {
+            source.state = State::Demoted;
+            source.demotedAt = now;
+            qDebug() << "SourceSet: Demoted" << source.url.toString() << "at"
+                     << source.throughput << "B/s over" << count << "connections";
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Assignment
+// ═══════════════════════════════════════════════════════════════════════════════
+
+SourceId SourceSet::choose(SourceId current, const std::vector<size_t>& workers) const {
+    std::lock_guard lock(m_mutex);
+    if (m_sources.size() < 2) {
+        return 0;
+    }
+
+    // Demoted sources only when no active one is left; dropped ones never
+    State wanted = State::Active;
+    if (std::none_of(m_sources.begin(), m_sources.end(),
+                     [](const Source& source) { return source.state == State::Active; })) {
+        wanted = State::Demoted;
+    }
+
+    SpeedBps bestMeasured = 0.0;
+    for (const Source& source : m_sources) {
+        if (source.state == wanted && source.measured) {
+            bestMeasured = std::max(bestMeasured, source.throughput);
+        }
+    }
+
+    auto expectedRate = [&](SourceId id) {
+        const Source& source = m_sources[id];
+        SpeedBps rate = source.measured ? source.throughput : std::max(bestMeasured, 1.0);
+        size_t others = countAt(workers, id) - (id == current && countAt(workers, id) > 0 ? 1 : 0);
+        return rate / static_cast<double>(others + 1);
+    };
+
+    SourceId best = 0;
+    SpeedBps bestRate = -1.0;
+    for (SourceId id = 0; id < m_sources.size(); ++id) {
+        if (m_sources[id].state != wanted) {
+            continue;
+        }
+        SpeedBps rate = expectedRate(id);
+        if (rate > bestRate) {
+            best = id;
+            bestRate = rate;
+        }
+    }
+
+    if (bestRate < 0.0) {
+        return 0;  // Everything dropped; let the primary report the errors
+    }
+
+    if (current < m_sources.size() && current != best && m_sources[current].state == wanted &&
+        expectedRate(current) >= bestRate * Constants::MIRROR_SWITCH_RATIO) {
+        return current;
+    }
+    return best;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SourceSet::dropLocked(SourceId id, const QString& reason) {
+    // Note: Caller must hold m_mutex
+    Source& source = m_sources[id];
+
+    // The last usable source stays; its errors reach the task as usual
+    if (source.state == State::Dropped || usableCountLocked() <= 1) {
+        return;
+    }
+
+    source.state = State::Dropped;
+    qWarning() << "SourceSet: Dropped" << source.url.toString() << "-" << reason;
+}
+
+size_t SourceSet::usableCountLocked() const {
+    // Note: Caller must hold m_mutex
+    return static_cast<size_t>(std::count_if(m_sources.begin(), m_sources.end(),
+                                             [](const Source& source) { return source.state != State::Dropped; }));
+}
+
+} // namespace OpenIDM
@@ -3,109 +3,142 @@
  * @brief Speed calculation and ETA estimation utilities
  */
 
-#include "openidm/engine/Types.h"
-#include <deque>
-#include <numeric>
-#include <cmath>
+#include "openidm/engine/SpeedCalculator.h"
+
+#include <algorithm>
 
 namespace OpenIDM {
 
-/**
- * @class SpeedCalculator
- * @brief Calculates smoothed download speed and ETA
- */
-class SpeedCalculator {
-public:
-    SpeedCalculator(size_t sampleCount = Constants::SPEED_HISTORY_SIZE)
-        : m_maxSamples(sampleCount)
-    {
+// ═══════════════════════════════════════════════════════════════════════════════
+// SpeedCalculator
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void SpeedCalculator::reset() {
+    m_buckets.fill(0);
+    m_windowBytes = 0;
+    m_origin = Timestamp{};
+    m_firstBucket = 0;
+    m_headBucket = -1;
+    m_lastTotal = -1;
+    m_ema = 0.0;
+    m_speed.store(0.0, std::memory_order_relaxed);
+    m_smoothed.store(0.0, std::memory_order_relaxed);
+}
+
+void SpeedCalculator::addBytes(ByteCount bytes, Timestamp now) {
+    if (m_headBucket < 0) {
+        m_origin = now;
+        m_headBucket = 0;
+        m_firstBucket = 0;
     }
-    
-    /**
-     * @brief Add a speed sample
-     * @param bytesPerSecond Current speed measurement
-     */
-    void addSample(SpeedBps bytesPerSecond) {
-        m_samples.push_back(bytesPerSecond);
-        
-        if (m_samples.size() > m_maxSamples) {
-            m_samples.pop_front();
-        }
+
+    int64_t bucket = std::chrono::duration_cast<Duration>(now - m_origin).count() / BUCKET_WIDTH.count();
+    advanceTo(bucket);
+
+    m_buckets[static_cast<size_t>(m_headBucket % BUCKET_COUNT)] += bytes;
+    m_windowBytes += bytes;
+
+    // Full buckets in the window plus the elapsed part of the newest one
+    int64_t fullBuckets = std::min<int64_t>(m_headBucket - m_firstBucket, BUCKET_COUNT - 1);
+    auto headStart = m_origin + BUCKET_WIDTH * m_headBucket;
+    double seconds = std::chrono::duration<double>(BUCKET_WIDTH * fullBuckets + (now - headStart)).count();
+    if (seconds > 0.0) {
+        m_speed.store(static_cast<double>(m_windowBytes) / seconds, std::memory_order_relaxed);
     }
-    
-    /**
-     * @brief Get smoothed average speed
-     * @return Average speed in bytes/second
-     */
-    SpeedBps averageSpeed() const {
-        if (m_samples.empty()) {
-            return 0.0;
-        }
-        
-        double sum = std::accumulate(m_samples.begin(), m_samples.end(), 0.0);
-        return sum / m_samples.size();
+}
+
+void SpeedCalculator::setTotal(ByteCount total, Timestamp now) {
+    if (m_lastTotal < 0 || total < m_lastTotal) {
+        m_lastTotal = total;
+        sample(now);
+        return;
     }
-    
-    /**
-     * @brief Get exponentially smoothed speed
-     * @param alpha Smoothing factor (0-1, higher = more weight to recent)
-     * @return Smoothed speed in bytes/second
-     */
-    SpeedBps exponentialSmoothedSpeed(double alpha = Constants::ETA_SMOOTHING_FACTOR) const {
-        if (m_samples.empty()) {
-            return 0.0;
-        }
-        
-        double smoothed = m_samples.front();
-        
-        for (size_t i = 1; i < m_samples.size(); ++i) {
-            smoothed = alpha * m_samples[i] + (1.0 - alpha) * smoothed;
-        }
-        
-        return smoothed;
+
+    ByteCount delta = total - m_lastTotal;
+    m_lastTotal = total;
+    addBytes(delta, now);
+}
+
+Duration SpeedCalculator::eta(ByteCount remainingBytes) const {
+    SpeedBps speed = smoothedSpeed();
+    if (speed <= 0.0) {
+        speed = currentSpeed();
     }
-    
-    /**
-     * @brief Calculate ETA based on remaining bytes
-     * @param remainingBytes Bytes left to download
-     * @return Estimated time remaining in milliseconds
-     */
-    Duration calculateETA(ByteCount remainingBytes) const {
-        SpeedBps speed = exponentialSmoothedSpeed();
-        
-        if (speed <= 0 || remainingBytes <= 0) {
-            return Duration{-1};  // Unknown
-        }
-        
-        double seconds = static_cast<double>(remainingBytes) / speed;
-        return Duration{static_cast<int64_t>(seconds * 1000)};
+    if (speed <= 0.0 || remainingBytes <= 0) {
+        return Duration{-1};  // Unknown
+    }
+
+    double seconds = static_cast<double>(remainingBytes) / speed;
+    return Duration{static_cast<int64_t>(seconds * 1000)};
+}
+
+void SpeedCalculator::advanceTo(int64_t bucket) {
+    if (bucket <= m_headBucket) {
+        return;
     }
-    
-    /**
-     * @brief Get current (instantaneous) speed
-     * @return Last recorded speed
-     */
-    SpeedBps currentSpeed() const {
-        return m_samples.empty() ? 0.0 : m_samples.back();
+
+    // A long silence empties the window; no need to walk it
+    if (bucket - m_headBucket >= static_cast<int64_t>(BUCKET_COUNT)) {
+        m_buckets.fill(0);
+        m_windowBytes = 0;
+        m_ema = 0.0;
+        m_smoothed.store(0.0, std::memory_order_relaxed);
+        m_headBucket = bucket;
+        m_firstBucket = bucket;
+        return;
     }
-    
-    /**
-     * @brief Clear all samples
-     */
-    void reset() {
-        m_samples.clear();
+
+    const double bucketSeconds = std::chrono::duration<double>(BUCKET_WIDTH).count();
+    while (m_headBucket < bucket) {
+        // Close the head bucket into the moving average
+        double rate = static_cast<double>(m_buckets[static_cast<size_t>(m_headBucket % BUCKET_COUNT)]) / bucketSeconds;
+        m_ema = m_ema > 0.0 ? Constants::ETA_SMOOTHING_FACTOR * rate + (1.0 - Constants::ETA_SMOOTHING_FACTOR) * m_ema
+                            : rate;
+
+        ++m_headBucket;
+        ByteCount& slot = m_buckets[static_cast<size_t>(m_headBucket % BUCKET_COUNT)];
+        m_windowBytes -= slot;
+        slot = 0;
     }
-    
-    /**
-     * @brief Get number of samples
-     */
-    size_t sampleCount() const {
-        return m_samples.size();
+    m_smoothed.store(m_ema, std::memory_order_relaxed);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// AggregateSpeedCalculator
+// ═══════════════════════════════════════════════════════════════════════════════
+
+AggregateSpeedCalculator& AggregateSpeedCalculator::instance() {
+    static AggregateSpeedCalculator aggregate;
+    return aggregate;
+}
+
+int AggregateSpeedCalculator::acquireSlot() {
+    for (size_t i = 0; i < SLOT_COUNT; ++i) {
+        bool expected = false;
+        if (m_used[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            m_active.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void AggregateSpeedCalculator::releaseSlot(int slot) {
+    if (slot < 0 || slot >= static_cast<int>(SLOT_COUNT)) {
+        return;
+    }
+    publish(slot, 0.0);
+    m_used[static_cast<size_t>(slot)].store(false, std::memory_order_release);
+    m_active.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void AggregateSpeedCalculator::publish(int slot, SpeedBps speed) {
+    if (slot < 0 || slot >= static_cast<int>(SLOT_COUNT)) {
+        return;
     }
-    
-private:
-    std::deque<SpeedBps> m_samples;
-    size_t m_maxSamples;
-};
+    int64_t value = static_cast<int64_t>(speed);
+    int64_t previous = m_speeds[static_cast<size_t>(slot)].exchange(value, std::memory_order_relaxed);
+    m_total.fetch_add(value - previous, std::memory_order_relaxed);
+}
 
 } // namespace OpenIDM
@@ -0,0 +1,428 @@
+/**
+ * @file StreamServer.cpp
+ * @brief Implementation of StreamServer - partial files over HTTP/1.1
+ */
+
+#include "openidm/engine/StreamServer.h"
+#include "openidm/engine/DownloadManager.h"
+#include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/SegmentScheduler.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QMimeDatabase>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <vector>
+
+namespace OpenIDM {
+
+namespace {
+
+/// Larger request heads are not a player's; the connection is dropped
+constexpr qsizetype MAX_REQUEST = 8 * 1024;
+
+/// Connections that send no complete request head are closed after this long
+constexpr int REQUEST_TIMEOUT_MS = 10000;
+
+const QByteArray STREAM_PATH = "/stream/";
+
+QByteArray response(int status, const QByteArray& reason, const QByteArray& body) {
+    QByteArray out = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n";
+    out += "Content-Type: text/plain\r\n";
+    out += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    out += "Connection: close\r\n\r\n";
+    out += body;
+    return out;
+}
+
+enum class RangeKind { Full, Partial, Unsatisfiable };
+
+/**
+ * @brief Resolve a Range header against @p size
+ *
+ * Only a single byte range is honoured; anything else (several ranges,
+ * other units, garbage) is ignored and the whole file served, as RFC 9110
+ * allows.
+ */
+RangeKind parseRange(const QByteArray& header, ByteCount size, ByteOffset& first, ByteOffset& last) {
+    first = 0;
+    last = size - 1;
+
+    QByteArray spec = header.trimmed();
+    if (!spec.startsWith("bytes=") || spec.contains(',')) {
+        return RangeKind::Full;
+    }
+    spec = spec.mid(6);
+    qsizetype dash = spec.indexOf('-');
+    if (dash < 0) {
+        return RangeKind::Full;
+    }
+    QByteArray from = spec.left(dash).trimmed();
+    QByteArray to = spec.mid(dash + 1).trimmed();
+    bool ok = false;
+
+    // bytes=-n: the last n bytes
+    if (from.isEmpty()) {
+        ByteCount suffix = to.toLongLong(&ok);
+        if (!ok) {
+            return RangeKind::Full;
+        }
+        if (suffix <= 0) {
+            return RangeKind::Unsatisfiable;
+        }
+        first = std::max<ByteOffset>(size - suffix, 0);
+        return RangeKind::Partial;
+    }
+
+    first = from.toLongLong(&ok);
+    if (!ok || first < 0) {
+        return RangeKind::Full;
+    }
+    if (!to.isEmpty()) {
+        ByteOffset end = to.toLongLong(&ok);
+        if (!ok || end < first) {
+            return RangeKind::Full;
+        }
+        last = std::min<ByteOffset>(end, size - 1);
+    }
+    return first < size ? RangeKind::Partial : RangeKind::Unsatisfiable;
+}
+
+QByteArray headerValue(const QByteArray& head, const QByteArray& name) {
+    const QList<QByteArray> lines = head.split('\n');
+    for (const QByteArray& line : lines) {
+        qsizetype colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == name) {
+            return line.mid(colon + 1).trimmed();
+        }
+    }
+    return {};
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+StreamServer::StreamServer(DownloadManager& manager, QObject* parent)
+    : QObject(parent)
+    , m_manager(manager)
+{
+    // Readers waiting on the download are retried on the progress cadence
+    m_poll = new QTimer(this);
+    m_poll->setInterval(Constants::PROGRESS_UPDATE_INTERVAL);
+    connect(m_poll, &QTimer::timeout, this, [this]() { poll(); });
+}
+
+StreamServer::~StreamServer() {
+    stop();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Listener
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool StreamServer::start(quint16 port) {
+    stop();
+
+    m_server = new QTcpServer(this);
+    if (!m_server->listen(QHostAddress(QHostAddress::LocalHost), port)) {
+        qWarning() << "StreamServer: Failed to listen on port" << port << ":" << m_server->errorString();
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+    m_port = m_server->serverPort();
+    connect(m_server, &QTcpServer::newConnection, this, [this]() { accept(); });
+    qDebug() << "StreamServer: Serving downloads on port" << m_port;
+    return true;
+}
+
+void StreamServer::stop() {
+    m_poll->stop();
+
+    std::vector<QTcpSocket*> sockets;
+    sockets.reserve(m_streams.size());
+    for (const auto& [socket, stream] : m_streams) {
+        sockets.push_back(socket);
+    }
+    m_streams.clear();
+    for (QTcpSocket* socket : sockets) {
+        socket->abort();
+        delete socket;
+    }
+
+    if (m_server) {
+        m_server->close();
+        delete m_server;
+        m_server = nullptr;
+    }
+    m_port = 0;
+}
+
+QUrl StreamServer::urlFor(const TaskId& id) const {
+    return QUrl(QStringLiteral("http://127.0.0.1:%1/stream/%2")
+                    .arg(m_port)
+                    .arg(id.toString(QUuid::WithoutBraces)));
+}
+
+void StreamServer::accept() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        socket->setParent(this);
+        m_streams.emplace(socket, Stream{});
+
+        auto* timeout = new QTimer(socket);
+        timeout->setSingleShot(true);
+        connect(timeout, &QTimer::timeout, socket, &QTcpSocket::abort);
+        timeout->start(REQUEST_TIMEOUT_MS);
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { read(socket); });
+        connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]() { pump(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            drop(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Requests
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void StreamServer::read(QTcpSocket* socket) {
+    auto it = m_streams.find(socket);
+    if (it == m_streams.end()) {
+        return;
+    }
+    Stream& stream = it->second;
+
+    // One request per connection; anything after the head is ignored
+    if (stream.answered || !stream.task.isNull()) {
+        socket->readAll();
+        return;
+    }
+    stream.input += socket->readAll();
+    qsizetype headerEnd = stream.input.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (stream.input.size() > MAX_REQUEST) {
+            socket->abort();
+        }
+        return;
+    }
+    if (auto* timeout = socket->findChild<QTimer*>(QString(), Qt::FindDirectChildrenOnly)) {
+        timeout->stop();
+    }
+
+    QByteArray head = stream.input.left(headerEnd);
+    stream.input.clear();
+    const QList<QByteArray> requestLine = head.left(head.indexOf("\r\n")).split(' ');
+    QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+    path = path.left(path.indexOf('?') >= 0 ? path.indexOf('?') : path.size());
+
+    if (method != "GET" && method != "HEAD") {
+        stream.answered = true;
+        socket->write(response(405, "Method Not Allowed", "GET only\n"));
+        socket->disconnectFromHost();
+        return;
+    }
+    TaskId id = path.startsWith(STREAM_PATH) ? QUuid::fromString(QString::fromLatin1(path.mid(STREAM_PATH.size())))
+                                             : TaskId();
+    if (id.isNull()) {
+        stream.answered = true;
+        socket->write(response(404, "Not Found", "Try /stream/<download id>\n"));
+        socket->disconnectFromHost();
+        return;
+    }
+
+    stream.task = id;
+    stream.head = method == "HEAD";
+    stream.range = headerValue(head, "range");
+    respond(socket, stream);
+}
+
+void StreamServer::respond(QTcpSocket* socket, Stream& stream) {
+    Source source;
+    if (!locate(stream, source)) {
+        socket->write(response(404, "Not Found", "No such download\n"));
+        socket->disconnectFromHost();
+        return;
+    }
+
+    // Content-Length must be right from the start; wait for the probe
+    if (source.size <= 0) {
+        stream.waiting = true;
+        m_poll->start();
+        return;
+    }
+
+    ByteOffset first = 0;
+    ByteOffset last = 0;
+    RangeKind kind = parseRange(stream.range, source.size, first, last);
+    if (kind == RangeKind::Unsatisfiable) {
+        QByteArray reply = "HTTP/1.1 416 Range Not Satisfiable\r\n";
+        reply += "Content-Range: bytes */" + QByteArray::number(source.size) + "\r\n";
+        reply += "Content-Length: 0\r\nConnection: close\r\n\r\n";
+        socket->write(reply);
+        socket->disconnectFromHost();
+        return;
+    }
+
+    stream.position = first;
+    stream.end = last;
+    stream.answered = true;
+
+    QMimeDatabase mimes;
+    QByteArray type = mimes.mimeTypeForFile(source.fileName, QMimeDatabase::MatchExtension).name().toUtf8();
+    QByteArray reply = kind == RangeKind::Partial ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+    reply += "Content-Type: " + type + "\r\n";
+    reply += "Accept-Ranges: bytes\r\n";
+    if (kind == RangeKind::Partial) {
+        reply += "Content-Range: bytes " + QByteArray::number(first) + '-' + QByteArray::number(last) + '/' +
+                 QByteArray::number(source.size) + "\r\n";
+    }
+    reply += "Content-Length: " + QByteArray::number(last - first + 1) + "\r\n";
+    reply += "Connection: close\r\n\r\n";
+    socket->write(reply);
+
+    if (stream.head) {
+        socket->disconnectFromHost();
+        return;
+    }
+
+    // A player is reading: fetch from where it reads
+    if (DownloadTask* task = m_manager.task(stream.task)) {
+        if (SegmentScheduler* scheduler = task->scheduler()) {
+            scheduler->setSequential(true);
+            scheduler->setReadPosition(first);
+        }
+    }
+    pump(socket);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Body
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void StreamServer::pump(QTcpSocket* socket) {
+    auto it = m_streams.find(socket);
+    if (it == m_streams.end() || socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+    Stream& stream = it->second;
+    stream.waiting = false;
+
+    if (!stream.answered) {
+        if (!stream.task.isNull()) {
+            respond(socket, stream);
+        }
+        return;
+    }
+    if (stream.head || stream.position > stream.end) {
+        return;
+    }
+
+    // Keep the socket fed, but never buffer more than the player is behind
+    qint64 budget = static_cast<qint64>(Constants::STREAM_SEND_BUFFER) - socket->bytesToWrite();
+    if (budget <= 0) {
+        return;
+    }
+
+    Source source;
+    if (!locate(stream, source)) {
+        // Failed or removed: a short body tells the player it is over
+        socket->abort();
+        return;
+    }
+    if (DownloadTask* task = m_manager.task(stream.task)) {
+        if (SegmentScheduler* scheduler = task->scheduler()) {
+            scheduler->setReadPosition(stream.position);
+        }
+    }
+
+    ByteOffset available = std::min<ByteOffset>(source.available, stream.end + 1);
+    QFile file(source.path);
+    QByteArray data;
+    if (available > stream.position && file.open(QIODevice::ReadOnly) && file.seek(stream.position)) {
+        data = file.read(std::min<qint64>(budget, available - stream.position));
+    }
+    if (data.isEmpty()) {
+        // Not downloaded yet (or mid-rename); block this reader, not the others
+        stream.waiting = true;
+        m_poll->start();
+        return;
+    }
+
+    socket->write(data);
+    stream.position += data.size();
+    if (stream.position > stream.end) {
+        socket->disconnectFromHost();
+    }
+}
+
+void StreamServer::poll() {
+    std::vector<QTcpSocket*> waiting;
+    for (const auto& [socket, stream] : m_streams) {
+        if (stream.waiting) {
+            waiting.push_back(socket);
+        }
+    }
+    if (waiting.empty()) {
+        m_poll->stop();
+        return;
+    }
+    for (QTcpSocket* socket : waiting) {
+        pump(socket);
+    }
+}
+
+void StreamServer::drop(QTcpSocket* socket) {
+    m_streams.erase(socket);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool StreamServer::locate(const Stream& stream, Source& source) const {
+    if (DownloadTask* task = m_manager.task(stream.task)) {
+        DownloadState state = task->state();
+        if (state == DownloadState::Failed) {
+            return false;
+        }
+        source.fileName = task->fileName();
+        if (state == DownloadState::Completed) {
+            source.path = task->filePath();
+            source.size = QFileInfo(source.path).size();
+            source.available = source.size;
+            return source.size > 0;
+        }
+
+        // Segments write into the .part file until finalize renames it
+        QString partial = task->filePath() + QStringLiteral(".part");
+        source.path = QFileInfo::exists(partial) ? partial : task->filePath();
+        source.size = task->totalSize();
+        SegmentScheduler* scheduler = task->scheduler();
+        source.available = scheduler ? scheduler->contiguousEnd(stream.position) : stream.position;
+        return true;
+    }
+
+    std::optional<TaskData> archived = m_manager.archivedDownload(stream.task);
+    if (!archived || archived->state != DownloadState::Completed) {
+        return false;
+    }
+    source.path = archived->filePath;
+    source.fileName = archived->fileName;
+    source.size = QFileInfo(source.path).size();
+    source.available = source.size;
+    return source.size > 0;
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,298 @@
+/**
+ * @file TaskRegistry.cpp
+ * @brief Implementation of the indexed task registry
+ */
+
+#include "openidm/engine/TaskRegistry.h"
+#include "openidm/engine/DownloadTask.h"
+
+#include <mutex>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+TaskRegistry::~TaskRegistry() {
+    std::unique_lock lock(m_mutex);
+    m_lists = {};
+    m_byUrl.clear();
+    m_tasks.clear();
+}
+
+QString TaskRegistry::normalizeUrl(const QUrl& url) {
+    QUrl normalized = url.adjusted(QUrl::RemoveFragment | QUrl::NormalizePathSegments);
+
+    int defaultPort = -1;
+    QString scheme = normalized.scheme();
+    if (scheme == QLatin1String("http")) {
+        defaultPort = 80;
+    } else if (scheme == QLatin1String("https")) {
+        defaultPort = 443;
+    } else if (scheme == QLatin1String("ftp")) {
+        defaultPort = 21;
+    }
+    if (defaultPort != -1 && normalized.port() == defaultPort) {
+        normalized.setPort(-1);
+    }
+
+    // QUrl already lower-cases scheme and host
+    return normalized.toString(QUrl::FullyEncoded);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Tasks
+// ═══════════════════════════════════════════════════════════════════════════════
+
+DownloadTask* TaskRegistry::add(std::unique_ptr<DownloadTask> task) {
+    std::unique_lock lock(m_mutex);
+    if (m_tasks.count(task->id()) || m_archive.count(task->id())) {
+        return nullptr;
+    }
+
+    DownloadTask* raw = task.get();
+    insertLocked(std::move(task));
+    return raw;
+}
+
+void TaskRegistry::add(std::vector<std::unique_ptr<DownloadTask>> tasks) {
+    std::unique_lock lock(m_mutex);
+    for (auto& task : tasks) {
+        if (!m_tasks.count(task->id()) && !m_archive.count(task->id())) {
+            insertLocked(std::move(task));
+        }
+    }
+}
+
+std::unique_ptr<DownloadTask> TaskRegistry::take(const TaskId& id) {
+    std::unique_lock lock(m_mutex);
+    auto it = m_tasks.find(id);
+    if (it == m_tasks.end()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<DownloadTask> task = std::move(it->second);
+    m_tasks.erase(it);
+    unlink(task.get());
+    unindexUrl(normalizeUrl(task->urlObject()), id);
+    m_taskCount.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+std::vector<std::unique_ptr<DownloadTask>> TaskRegistry::takeAll() {
+    std::unique_lock lock(m_mutex);
+
+    std::vector<std::unique_ptr<DownloadTask>> result;
+    result.reserve(m_tasks.size());
+    for (auto& [id, task] : m_tasks) {
+        unlink(task.get());
+        unindexUrl(normalizeUrl(task->urlObject()), id);
+        result.push_back(std::move(task));
+    }
+    m_tasks.clear();
+    m_taskCount.store(0, std::memory_order_relaxed);
+    return result;
+}
+
+void TaskRegistry::updateState(DownloadTask* task) {
+    std::unique_lock lock(m_mutex);
+    TaskListHook& hook = task->m_registryHook;
+    DownloadState state = task->state();
+    if (!hook.linked || hook.list == state) {
+        return;
+    }
+    unlink(task);
+    link(task, state);
+}
+
+DownloadTask* TaskRegistry::find(const TaskId& id) const {
+    std::shared_lock lock(m_mutex);
+    auto it = m_tasks.find(id);
+    return it != m_tasks.end() ? it->second.get() : nullptr;
+}
+
+std::vector<DownloadTask*> TaskRegistry::all() const {
+    std::shared_lock lock(m_mutex);
+
+    std::vector<DownloadTask*> result;
+    result.reserve(m_tasks.size());
+    for (const auto& [id, task] : m_tasks) {
+        result.push_back(task.get());
+    }
+    return result;
+}
+
+std::vector<DownloadTask*> TaskRegistry::inState(DownloadState state) const {
+    std::shared_lock lock(m_mutex);
+
+    std::vector<DownloadTask*> result;
+    result.reserve(static_cast<size_t>(count(state)));
+    for (DownloadTask* task = m_lists[static_cast<size_t>(state)].head; task;
+         task = task->m_registryHook.next) {
+        result.push_back(task);
+    }
+    return result;
+}
+
+void TaskRegistry::forEach(const std::function<void(DownloadTask*)>& fn) const {
+    std::shared_lock lock(m_mutex);
+    for (const auto& [id, task] : m_tasks) {
+        fn(task.get());
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Archive
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void TaskRegistry::addArchived(std::vector<TaskData> records) {
+    std::unique_lock lock(m_mutex);
+    for (TaskData& record : records) {
+        TaskId id = record.id;
+        if (m_tasks.count(id)) {
+            continue;
+        }
+        QString key = normalizeUrl(QUrl(record.url));
+        if (m_archive.emplace(id, std::move(record)).second) {
+            indexUrl(key, id);
+        }
+    }
+    m_archivedCount.store(static_cast<int>(m_archive.size()), std::memory_order_relaxed);
+}
+
+std::optional<TaskData> TaskRegistry::takeArchived(const TaskId& id) {
+    std::unique_lock lock(m_mutex);
+    auto it = m_archive.find(id);
+    if (it == m_archive.end()) {
+        return std::nullopt;
+    }
+
+    TaskData record = std::move(it->second);
+    m_archive.erase(it);
+    unindexUrl(normalizeUrl(QUrl(record.url)), id);
+    m_archivedCount.fetch_sub(1, std::memory_order_relaxed);
+    return record;
+}
+
+std::map<TaskId, TaskData> TaskRegistry::takeArchive() {
+    std::unique_lock lock(m_mutex);
+
+    std::map<TaskId, TaskData> archive;
+    archive.swap(m_archive);
+    for (const auto& [id, record] : archive) {
+        unindexUrl(normalizeUrl(QUrl(record.url)), id);
+    }
+    m_archivedCount.store(0, std::memory_order_relaxed);
+    return archive;
+}
+
+std::optional<TaskData> TaskRegistry::findArchived(const TaskId& id) const {
+    std::shared_lock lock(m_mutex);
+    auto it = m_archive.find(id);
+    if (it == m_archive.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::vector<TaskId> TaskRegistry::archivedIds() const {
+    std::shared_lock lock(m_mutex);
+
+    std::vector<TaskId> result;
+    result.reserve(m_archive.size());
+    for (const auto& [id, record] : m_archive) {
+        result.push_back(id);
+    }
+    return result;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Lookup
+// ═══════════════════════════════════════════════════════════════════════════════
+
+std::optional<TaskId> TaskRegistry::findByUrl(const QUrl& url) const {
+    QString key = normalizeUrl(url);
+
+    std::shared_lock lock(m_mutex);
+    auto it = m_byUrl.find(key);
+    if (it == m_byUrl.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void TaskRegistry::insertLocked(std::unique_ptr<DownloadTask> task) {
+    // Note: Caller must hold m_mutex exclusively
+    DownloadTask* raw = task.get();
+    TaskId id = raw->id();
+    m_tasks.emplace(id, std::move(task));
+    link(raw, raw->state());
+    indexUrl(normalizeUrl(raw->urlObject()), id);
+    m_taskCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TaskRegistry::link(DownloadTask* task, DownloadState state) {
+    // Note: Caller must hold m_mutex exclusively
+    TaskListHook& hook = task->m_registryHook;
+    List& list = m_lists[static_cast<size_t>(state)];
+
+    hook.prev = list.tail;
+    hook.next = nullptr;
+    hook.list = state;
+    hook.linked = true;
+
+    if (list.tail) {
+        list.tail->m_registryHook.next = task;
+    } else {
+        list.head = task;
+    }
+    list.tail = task;
+
+    m_counts[static_cast<size_t>(state)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void TaskRegistry::unlink(DownloadTask* task) {
+    // Note: Caller must hold m_mutex exclusively
+    TaskListHook& hook = task->m_registryHook;
+    if (!hook.linked) {
+        return;
+    }
+    List& list = m_lists[static_cast<size_t>(hook.list)];
+
+    if (hook.prev) {
+        hook.prev->m_registryHook.next = hook.next;
+    } else {
+        list.head = hook.next;
+    }
+    if (hook.next) {
+        hook.next->m_registryHook.prev = hook.prev;
+    } else {
+        list.tail = hook.prev;
+    }
+
+    m_counts[static_cast<size_t>(hook.list)].fetch_sub(1, std::memory_order_relaxed);
+    hook = TaskListHook{};
+}
+
+void TaskRegistry::indexUrl(const QString& key, const TaskId& id) {
+    // Note: Caller must hold m_mutex exclusively
+    m_byUrl.emplace(key, id);
+}
+
+void TaskRegistry::unindexUrl(const QString& key, const TaskId& id) {
+    // Note: Caller must hold m_mutex exclusively
+    auto [begin, end] = m_byUrl.equal_range(key);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second == id) {
+            m_byUrl.erase(it);
+            return;
+        }
+    }
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,378 @@
+/**
+ * @file TransferEngine.cpp
+ * @brief Implementation of TransferEngine - curl_multi_socket_action event loop
+ */
+
+#include "openidm/engine/TransferEngine.h"
+#include "openidm/engine/SegmentWorker.h"
+#include "openidm/engine/SegmentScheduler.h"
+
+#include <curl/curl.h>
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <vector>
+
+namespace OpenIDM {
+
+namespace {
+
+/// Read/write notifiers for one libcurl socket (stored via curl_multi_assign)
+struct SocketState {
+    QSocketNotifier* read{nullptr};
+    QSocketNotifier* write{nullptr};
+};
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Singleton / Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+TransferEngine& TransferEngine::instance() {
+    static TransferEngine engine;
+    return engine;
+}
+
+TransferEngine::TransferEngine()
+    : QObject(nullptr)
+{
+    m_thread.setObjectName(QStringLiteral("OpenIDM-TransferEngine"));
+}
+
+TransferEngine::~TransferEngine() {
+    stop();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Lifecycle
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool TransferEngine::start() {
+    if (isRunning()) {
+        return true;
+    }
+
+    // After a stop() the object still belongs to the (finished) thread
+    if (thread() != &m_thread) {
+        moveToThread(&m_thread);
+    }
+    m_thread.start();
+
+    QMetaObject::invokeMethod(this, &TransferEngine::initializeMulti, Qt::BlockingQueuedConnection);
+
+    if (!m_multi) {
+        m_thread.quit();
+        m_thread.wait();
+        return false;
+    }
+
+    m_running.store(true, std::memory_order_release);
+    qDebug() << "TransferEngine: Started";
+    return true;
+}
+
+void TransferEngine::stop() {
+    if (!m_running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(this, &TransferEngine::cleanupMulti, Qt::BlockingQueuedConnection);
+
+    m_thread.quit();
+    m_thread.wait();
+    qDebug() << "TransferEngine: Stopped";
+}
+
+void TransferEngine::initializeMulti() {
+    m_multi = curl_multi_init();
+    if (!m_multi) {
+        qCritical() << "TransferEngine: Failed to initialize curl multi handle";
+        return;
+    }
+
+    // Captureless lambdas adapt curl_socket_t to qintptr while keeping
+    // access to the private static callbacks
+    auto onSocket = [](CURL* easy, curl_socket_t s, int what, void* userp, void* socketp) -> int {
+        return socketCallback(easy, static_cast<qintptr>(s), what, userp, socketp);
+    };
+    auto onTimer = [](CURLM* multi, long timeoutMs, void* userp) -> int {
+        return timerCallback(multi, timeoutMs, userp);
+    };
+
+    curl_multi_setopt(m_multi, CURLMOPT_SOCKETFUNCTION, static_cast<curl_socket_callback>(onSocket));
+    curl_multi_setopt(m_multi, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(m_multi, CURLMOPT_TIMERFUNCTION, static_cast<curl_multi_timer_callback>(onTimer));
+    curl_multi_setopt(m_multi, CURLMOPT_TIMERDATA, this);
+
+    // HTTP/2 and HTTP/3 segments of a host share connections as streams
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#if LIBCURL_VERSION_NUM >= 0x074300  // 7.67.0
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                      static_cast<long>(Constants::MAX_STREAMS_PER_CONNECTION));
+#endif
+
+    m_socketTimer = new QTimer(this);
+    m_socketTimer->setSingleShot(true);
+    connect(m_socketTimer, &QTimer::timeout, this, &TransferEngine::onSocketTimeout);
+}
+
+void TransferEngine::cleanupMulti() {
+    // Abort running transfers; segments go back to the scheduler
+    while (!m_transfers.empty()) {
+        doDetach(m_transfers.begin()->second.worker);
+    }
+    while (!m_idleWorkers.empty()) {
+        doDetach(*m_idleWorkers.begin());
+    }
+
+    delete m_socketTimer;
+    m_socketTimer = nullptr;
+
+    if (m_multi) {
+        curl_multi_cleanup(m_multi);
+        m_multi = nullptr;
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Workers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void TransferEngine::attachWorker(SegmentWorker* worker) {
+    QMetaObject::invokeMethod(this, [this, worker]() { doAttach(worker); }, Qt::QueuedConnection);
+}
+
+void TransferEngine::detachWorker(SegmentWorker* worker) {
+    if (!isRunning()) {
+        return;
+    }
+
+    Qt::ConnectionType type = QThread::currentThread() == &m_thread
+                                  ? Qt::DirectConnection
+                                  : Qt::BlockingQueuedConnection;
+    QMetaObject::invokeMethod(this, [this, worker]() { doDetach(worker); }, type);
+}
+
+void TransferEngine::wakeIdleWorkers() {
+    if (!m_wakePending.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &TransferEngine::onWorkAvailable, Qt::QueuedConnection);
+    }
+}
+
+void TransferEngine::resumeLater(CURL* easy, Duration delay) {
+    QTimer::singleShot(delay, this, [this, easy]() {
+        if (m_transfers.count(easy) > 0) {
+            curl_easy_pause(easy, CURLPAUSE_CONT);
+        }
+    });
+}
+
+void TransferEngine::resume(CURL* easy) {
+    QMetaObject::invokeMethod(this, [this, easy]() {
+        if (m_transfers.count(easy) > 0) {
+            curl_easy_pause(easy, CURLPAUSE_CONT);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void TransferEngine::doAttach(SegmentWorker* worker) {
+    worker->m_engineDriven = true;
+
+    if (!worker->initCurl()) {
+        worker->m_state.store(SegmentWorker::State::Error, std::memory_order_release);
+        emit worker->finished();
+        return;
+    }
+
+    worker->m_scheduler->registerWorker(worker);
+
+    if (!startTransfer(worker)) {
+        parkWorker(worker);
+    }
+}
+
+void TransferEngine::doDetach(SegmentWorker* worker) {
+    for (auto it = m_transfers.begin(); it != m_transfers.end(); ++it) {
+        if (it->second.worker != worker) {
+            continue;
+        }
+
+        Segment* segment = it->second.segment;
+        curl_multi_remove_handle(m_multi, it->first);
+        m_transfers.erase(it);
+        m_activeCount.fetch_sub(1, std::memory_order_relaxed);
+
+        worker->finishSegment(segment, false);
+        break;
+    }
+
+    if (m_idleWorkers.erase(worker) > 0 || worker->m_curl) {
+        worker->m_scheduler->unregisterWorker(worker);
+        worker->cleanupCurl();
+    }
+}
+
+bool TransferEngine::startTransfer(SegmentWorker* worker) {
+    if (worker->shouldContinue() && !worker->isPaused()) {
+        Segment* segment = worker->acquireNext();
+        if (!segment) {
+            return false;
+        }
+
+        if (!worker->prepareTransfer(segment)) {
+            worker->finishSegment(segment, false);
+            return false;
+        }
+
+        m_transfers[worker->m_curl] = Transfer{worker, segment};
+        m_activeCount.fetch_add(1, std::memory_order_relaxed);
+        curl_multi_add_handle(m_multi, worker->m_curl);
+        return true;
+    }
+
+    return false;
+}
+
+void TransferEngine::retireWorker(SegmentWorker* worker) {
+    m_idleWorkers.erase(worker);
+    worker->m_scheduler->unregisterWorker(worker);
+    worker->cleanupCurl();
+
+    qDebug() << "TransferEngine: Worker retired";
+    emit worker->finished();
+}
+
+void TransferEngine::parkWorker(SegmentWorker* worker) {
+    // A signal that raced with the failed acquire is already queued as
+    // onWorkAvailable() and runs after this returns
+    m_idleWorkers.insert(worker);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Event Loop
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void TransferEngine::socketAction(qintptr socket, int eventMask) {
+    int running = 0;
+    curl_multi_socket_action(m_multi, static_cast<curl_socket_t>(socket), eventMask, &running);
+    checkMultiInfo();
+}
+
+void TransferEngine::onSocketTimeout() {
+    socketAction(static_cast<qintptr>(CURL_SOCKET_TIMEOUT), 0);
+}
+
+void TransferEngine::onWorkAvailable() {
+    m_wakePending.store(false, std::memory_order_release);
+
+    // Copy: startTransfer()/retireWorker() modify the idle set
+    std::vector<SegmentWorker*> idle(m_idleWorkers.begin(), m_idleWorkers.end());
+
+    for (SegmentWorker* worker : idle) {
+        if (!worker->shouldContinue() || worker->m_scheduler->isAllComplete()) {
+            retireWorker(worker);
+            continue;
+        }
+        if (startTransfer(worker)) {
+            m_idleWorkers.erase(worker);
+        }
+    }
+}
+
+void TransferEngine::checkMultiInfo() {
+    int pending = 0;
+    while (CURLMsg* msg = curl_multi_info_read(m_multi, &pending)) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        CURL* easy = msg->easy_handle;
+        CURLcode result = msg->data.result;
+
+        auto it = m_transfers.find(easy);
+        if (it == m_transfers.end()) {
+            curl_multi_remove_handle(m_multi, easy);
+            continue;
+        }
+
+        Transfer transfer = it->second;
+        m_transfers.erase(it);
+        m_activeCount.fetch_sub(1, std::memory_order_relaxed);
+        curl_multi_remove_handle(m_multi, easy);
+
+        SegmentWorker* worker = transfer.worker;
+        bool success = worker->completeTransfer(transfer.segment, result);
+        worker->finishSegment(transfer.segment, success);
+
+        // Keep the handle busy while the scheduler has work for it
+        if (!worker->shouldContinue()) {
+            retireWorker(worker);
+        } else if (!startTransfer(worker)) {
+            if (worker->m_scheduler->isAllComplete()) {
+                retireWorker(worker);
+            } else {
+                parkWorker(worker);
+            }
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Curl Callbacks
+// ═══════════════════════════════════════════════════════════════════════════════
+
+int TransferEngine::socketCallback(CURL* /*easy*/, qintptr socket, int what, void* userp, void* socketp) {
+    auto* engine = static_cast<TransferEngine*>(userp);
+    auto* state = static_cast<SocketState*>(socketp);
+
+    if (what == CURL_POLL_REMOVE) {
+        if (state) {
+            // curl may close the socket now and the descriptor be reused before
+            // the notifiers are gone: disable them at once. deleteLater: we may
+            // be inside one of their slots.
+            for (QSocketNotifier* notifier : {state->read, state->write}) {
+                if (notifier) {
+                    notifier->setEnabled(false);
+                    notifier->deleteLater();
+                }
+            }
+            delete state;
+        }
+        return 0;
+    }
+
+    if (!state) {
+        state = new SocketState;
+
+        state->read = new QSocketNotifier(socket, QSocketNotifier::Read, engine);
+        connect(state->read, &QSocketNotifier::activated, engine, [engine, socket]() {
+            engine->socketAction(socket, CURL_CSELECT_IN);
+        });
+
+        state->write = new QSocketNotifier(socket, QSocketNotifier::Write, engine);
+        connect(state->write, &QSocketNotifier::activated, engine, [engine, socket]() {
+            engine->socketAction(socket, CURL_CSELECT_OUT);
+        });
+
+        curl_multi_assign(engine->m_multi, static_cast<curl_socket_t>(socket), state);
+    }
+
+    state->read->setEnabled(what == CURL_POLL_IN || what == CURL_POLL_INOUT);
+    state->write->setEnabled(what == CURL_POLL_OUT || what == CURL_POLL_INOUT);
+    return 0;
+}
+
+int TransferEngine::timerCallback(CURLM* /*multi*/, long timeoutMs, void* userp) {
+    auto* engine = static_cast<TransferEngine*>(userp);
+
+    if (timeoutMs < 0) {
+        engine->m_socketTimer->stop();
+    } else {
+        // A zero timeout must not be handled re-entrantly from inside libcurl
+        engine->m_socketTimer->start(static_cast<int>(timeoutMs));
+    }
+    return 0;
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,192 @@
+/**
+ * @file TransferTrace.cpp
+ * @brief Implementation of TransferTrace - attempt ring and trace export
+ */
+
+#include "openidm/engine/TransferTrace.h"
+
+#include <algorithm>
+#include <set>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace OpenIDM {
+
+namespace {
+
+constexpr int PROCESS_ID = 1;
+
+qint64 microsSince(std::chrono::steady_clock::time_point origin, std::chrono::steady_clock::time_point at) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(at - origin).count();
+}
+
+QJsonObject slice(const QString& name, int track, qint64 start, qint64 duration) {
+    QJsonObject event;
+    event[QStringLiteral("name")] = name;
+    event[QStringLiteral("ph")] = QStringLiteral("X");
+    event[QStringLiteral("pid")] = PROCESS_ID;
+    event[QStringLiteral("tid")] = track;
+    event[QStringLiteral("ts")] = start;
+    event[QStringLiteral("dur")] = std::max<qint64>(duration, 0);
+    return event;
+}
+
+QJsonObject metadata(const QString& kind, int track, const QString& name) {
+    QJsonObject event;
+    event[QStringLiteral("name")] = kind;
+    event[QStringLiteral("ph")] = QStringLiteral("M");
+    event[QStringLiteral("pid")] = PROCESS_ID;
+    event[QStringLiteral("tid")] = track;
+    event[QStringLiteral("args")] = QJsonObject{{QStringLiteral("name"), name}};
+    return event;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Ring
+// ═══════════════════════════════════════════════════════════════════════════════
+
+template <typename T>
+void TransferTrace::Ring<T>::push(const T& item) {
+    if (items.size() < CAPACITY) {
+        items.reserve(CAPACITY);
+        items.push_back(item);
+        return;
+    }
+    items[next] = item;
+    next = (next + 1) % CAPACITY;
+}
+
+template <typename T>
+std::vector<T> TransferTrace::Ring<T>::ordered() const {
+    // Before the ring wraps, next stays 0 and items are already in order
+    std::vector<T> result(items.begin() + static_cast<std::ptrdiff_t>(next), items.end());
+    result.insert(result.end(), items.begin(), items.begin() + static_cast<std::ptrdiff_t>(next));
+    return result;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Recording
+// ═══════════════════════════════════════════════════════════════════════════════
+
+TransferTrace::TransferTrace()
+    : m_origin(std::chrono::steady_clock::now())
+{
+}
+
+void TransferTrace::record(const TransferAttempt& attempt) {
+    if constexpr (ENABLED) {
+        std::lock_guard lock(m_mutex);
+        m_attempts.push(attempt);
+    }
+}
+
+void TransferTrace::recordSteal(const StealEvent& steal) {
+    if constexpr (ENABLED) {
+        std::lock_guard lock(m_mutex);
+        m_steals.push(steal);
+    }
+}
+
+std::vector<TransferAttempt> TransferTrace::attempts() const {
+    std::lock_guard lock(m_mutex);
+    return m_attempts.ordered();
+}
+
+std::vector<StealEvent> TransferTrace::steals() const {
+    std::lock_guard lock(m_mutex);
+    return m_steals.ordered();
+}
+
+void TransferTrace::clear() {
+    std::lock_guard lock(m_mutex);
+    m_attempts = {};
+    m_steals = {};
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Export
+// ═══════════════════════════════════════════════════════════════════════════════
+
+QByteArray TransferTrace::toChromeTrace(const QString& name) const {
+    std::vector<TransferAttempt> attempts;
+    std::vector<StealEvent> steals;
+    {
+        std::lock_guard lock(m_mutex);
+        attempts = m_attempts.ordered();
+        steals = m_steals.ordered();
+    }
+
+    QJsonArray events;
+    events.append(metadata(QStringLiteral("process_name"), 0, name));
+
+    std::set<int> tracks;
+    for (const TransferAttempt& attempt : attempts) {
+        tracks.insert(attempt.worker);
+        qint64 start = microsSince(m_origin, attempt.started);
+
+        QJsonObject whole = slice(QStringLiteral("segment %1").arg(attempt.segment), attempt.worker,
+                                  start, attempt.total.count());
+        whole[QStringLiteral("args")] = QJsonObject{
+            {QStringLiteral("startByte"), attempt.startByte},
+            {QStringLiteral("bytes"), attempt.bytes},
+            {QStringLiteral("source"), static_cast<qint64>(attempt.source)},
+            {QStringLiteral("retry"), attempt.retry},
+            {QStringLiteral("hedged"), attempt.hedged},
+            {QStringLiteral("curlCode"), attempt.result},
+            {QStringLiteral("httpStatus"), static_cast<qint64>(attempt.httpStatus)},
+            {QStringLiteral("writeStallUs"), attempt.writeStall.count()},
+        };
+        events.append(whole);
+
+        // Cumulative curl times become back-to-back phases; skipped
+        // phases (a reused connection, plain HTTP) have no width
+        qint64 dns = attempt.nameLookup.count();
+        qint64 connected = std::max(dns, attempt.connect.count());
+        qint64 secured = std::max(connected, attempt.appConnect.count());
+        qint64 firstByte = std::max(secured, attempt.startTransfer.count());
+        const std::pair<QString, std::pair<qint64, qint64>> phases[] = {
+            {QStringLiteral("dns"), {0, dns}},
+            {QStringLiteral("connect"), {dns, connected}},
+            {QStringLiteral("tls"), {connected, secured}},
+            {QStringLiteral("ttfb"), {secured, firstByte}},
+            {QStringLiteral("body"), {firstByte, std::max(firstByte, attempt.total.count())}},
+        };
+        for (const auto& [phase, span] : phases) {
+            if (span.second > span.first) {
+                events.append(slice(phase, attempt.worker, start + span.first, span.second - span.first));
+            }
+        }
+    }
+
+    for (const StealEvent& steal : steals) {
+        tracks.insert(steal.worker);
+        QJsonObject event;
+        event[QStringLiteral("name")] = QStringLiteral("steal");
+        event[QStringLiteral("ph")] = QStringLiteral("i");
+        event[QStringLiteral("s")] = QStringLiteral("t");
+        event[QStringLiteral("pid")] = PROCESS_ID;
+        event[QStringLiteral("tid")] = steal.worker;
+        event[QStringLiteral("ts")] = microsSince(m_origin, steal.at);
+        event[QStringLiteral("args")] = QJsonObject{
+            {QStringLiteral("from"), static_cast<qint64>(steal.from)},
+            {QStringLiteral("created"), static_cast<qint64>(steal.created)},
+            {QStringLiteral("splitAt"), steal.splitAt},
+        };
+        events.append(event);
+    }
+
+    for (int track : tracks) {
+        events.append(metadata(QStringLiteral("thread_name"), track, QStringLiteral("worker %1").arg(track)));
+    }
+
+    QJsonObject document;
+    document[QStringLiteral("traceEvents")] = events;
+    document[QStringLiteral("displayTimeUnit")] = QStringLiteral("ms");
+    return QJsonDocument(document).toJson(QJsonDocument::Compact);
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,225 @@
+/**
+ * @file WorkerPool.cpp
+ * @brief Implementation of the engine-wide connection budget
+ */
+
+#include "openidm/engine/WorkerPool.h"
+#include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/SegmentWorker.h"
+
+#include <algorithm>
+
+#include <QMetaObject>
+
+namespace OpenIDM {
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+WorkerPool& WorkerPool::instance() {
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::WorkerPool() {
+    m_threads.setObjectName(QStringLiteral("OpenIDM-Workers"));
+    m_threads.setMaxThreadCount(static_cast<int>(m_capacity));
+    m_threads.setExpiryTimeout(-1);  // Keep threads between downloads
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Budget
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void WorkerPool::setCapacity(size_t connections) {
+    connections = std::clamp<size_t>(connections, 1, Constants::MAX_TOTAL_CONNECTIONS);
+
+    std::vector<DownloadTask*> notify;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_capacity == connections) {
+            return;
+        }
+        m_capacity = connections;
+        m_threads.setMaxThreadCount(static_cast<int>(connections));
+        redistribute(notify);
+    }
+    notifyGranted(notify);
+}
+
+size_t WorkerPool::capacity() const {
+    std::lock_guard lock(m_mutex);
+    return m_capacity;
+}
+
+size_t WorkerPool::inUse() const {
+    std::lock_guard lock(m_mutex);
+    return m_inUse;
+}
+
+size_t WorkerPool::request(DownloadTask* task, size_t wanted) {
+    if (wanted == 0) {
+        release(task);
+        return 0;
+    }
+
+    std::vector<DownloadTask*> notify;
+    size_t result = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        Claim& claim = m_claims[task];
+        claim.wanted = wanted;
+
+        if (claim.granted > wanted) {
+            m_inUse -= claim.granted - wanted;
+            claim.granted = wanted;
+        } else if (claim.granted == 0) {
+            // Guaranteed minimum, even over budget
+            claim.granted = 1;
+            ++m_inUse;
+        }
+
+        redistribute(notify);
+        result = claim.granted;
+    }
+
+    // The caller applies its own grant; only tell the others
+    notify.erase(std::remove(notify.begin(), notify.end(), task), notify.end());
+    notifyGranted(notify);
+    return result;
+}
+
+void WorkerPool::release(DownloadTask* task) {
+    std::vector<DownloadTask*> notify;
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_claims.find(task);
+        if (it == m_claims.end()) {
+            return;
+        }
+        m_inUse -= it->second.granted;
+        m_claims.erase(it);
+        redistribute(notify);
+    }
+    notifyGranted(notify);
+}
+
+size_t WorkerPool::granted(DownloadTask* task) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_claims.find(task);
+    return it != m_claims.end() ? it->second.granted : 0;
+}
+
+void WorkerPool::reprioritize() {
+    std::vector<DownloadTask*> notify;
+    {
+        std::lock_guard lock(m_mutex);
+        redistribute(notify);
+    }
+    notifyGranted(notify);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Threads
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void WorkerPool::start(SegmentWorker* worker) {
+    {
+        QMutexLocker locker(&worker->m_runMutex);
+        worker->m_queued = true;
+    }
+    m_threads.start(worker);
+}
+
+void WorkerPool::finish(SegmentWorker* worker) {
+    if (m_threads.tryTake(worker)) {
+        worker->markExited();
+        return;
+    }
+    worker->waitForExit();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Internal Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void WorkerPool::redistribute(std::vector<DownloadTask*>& notify) {
+    // Note: Caller must hold m_mutex
+    while (m_inUse < m_capacity) {
+        DownloadTask* best = nullptr;
+        double bestShare = 0.0;
+
+        for (const auto& [task, claim] : m_claims) {
+            if (claim.granted >= claim.wanted) {
+                continue;
+            }
+            double share = static_cast<double>(priorityWeight(task->priority())) / (claim.granted + 1);
+            if (share > bestShare) {
+                best = task;
+                bestShare = share;
+            }
+        }
+
+        if (!best) {
+            break;
+        }
+
+        ++m_claims[best].granted;
+        ++m_inUse;
+        if (std::find(notify.begin(), notify.end(), best) == notify.end()) {
+            notify.push_back(best);
+        }
+    }
+
+    preempt(notify);
+}
+
+void WorkerPool::preempt(std::vector<DownloadTask*>& notify) {
+    // Note: Caller must hold m_mutex
+    auto mark = [&notify](DownloadTask* task) {
+        if (std::find(notify.begin(), notify.end(), task) == notify.end()) {
+            notify.push_back(task);
+        }
+    };
+
+    for (auto& [task, claim] : m_claims) {
+        if (task->priority() != Priority::Urgent) {
+            continue;
+        }
+        while (claim.granted < claim.wanted) {
+            // The background claim with the most slots per unit of weight
+            Claim* donor = nullptr;
+            DownloadTask* donorTask = nullptr;
+            double most = 0.0;
+            for (auto& [other, candidate] : m_claims) {
+                if (other->priority() == Priority::Urgent || candidate.granted <= 1) {
+                    continue;
+                }
+                double perWeight = static_cast<double>(candidate.granted) / priorityWeight(other->priority());
+                if (perWeight > most) {
+                    donor = &candidate;
+                    donorTask = other;
+                    most = perWeight;
+                }
+            }
+            if (!donor) {
+                break;
+            }
+            --donor->granted;
+            ++claim.granted;
+            mark(donorTask);
+            mark(task);
+        }
+    }
+}
+
+void WorkerPool::notifyGranted(const std::vector<DownloadTask*>& tasks) {
+    // Queued so a task never spawns workers from inside another task's
+    // stopWorkers(); dropped by Qt if the task is deleted in between
+    for (DownloadTask* task : tasks) {
+        QMetaObject::invokeMethod(task, &DownloadTask::onConnectionsGranted, Qt::QueuedConnection);
+    }
+}
+
+} // namespace OpenIDM
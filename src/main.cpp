@@ -17,6 +17,7 @@
 #include "openidm/engine/DownloadManager.h"
 #include "openidm/viewmodel/DownloadListModel.h"
 #include "openidm/viewmodel/DownloadViewModel.h"
+#include "openidm/viewmodel/SegmentBar.h"
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -72,6 +73,7 @@ int main(int argc, char *argv[])
     qmlRegisterUncreatableType<OpenIDM::DownloadTask>(
         "OpenIDM", 1, 0, "DownloadTask",
         QStringLiteral("DownloadTask cannot be created from QML"));
+    qmlRegisterType<OpenIDM::SegmentBar>("OpenIDM", 1, 0, "SegmentBar");
     
     // Expose C++ objects to QML
     engine.rootContext()->setContextProperty(
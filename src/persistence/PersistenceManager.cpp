@@ -5,6 +5,7 @@
 
 #include "openidm/persistence/PersistenceManager.h"
 #include "openidm/engine/DownloadTask.h"
+#include "openidm/engine/EngineMetrics.h"
 #include "openidm/engine/Segment.h"
 
 #include <QDebug>
@@ -14,8 +15,82 @@
 #include <QStandardPaths>
 #include <QCoreApplication>
 
+#include <algorithm>
+#include <map>
+
 namespace OpenIDM {
 
+namespace {
+
+const QString WRITER_CONNECTION = QStringLiteral("openidm_writer");
+
+void applyPragmas(const QSqlDatabase& db) {
+    QSqlQuery query(db);
+    query.exec(QStringLiteral("PRAGMA journal_mode = WAL"));
+    query.exec(QStringLiteral("PRAGMA synchronous = NORMAL"));
+    query.exec(QStringLiteral("PRAGMA foreign_keys = ON"));
+    query.exec(QStringLiteral("PRAGMA cache_size = -64000"));  // 64MB cache
+}
+
+} // namespace
+
+/**
+ * @brief Statements prepared once on the writer connection and reused per batch
+ */
+struct PersistenceManager::Statements {
+    explicit Statements(const QSqlDatabase& db)
+        : saveTask(db), saveSegment(db), deleteSegments(db), deleteTask(db), saveSetting(db)
+        , saveHost(db), saveResource(db), deleteResource(db), saveMirrors(db), saveMedia(db)
+    {
+    }
+
+    bool prepare() {
+        return saveTask.prepare(QStringLiteral(R"(
+                   INSERT OR REPLACE INTO downloads
+                   (id, url, file_path, file_name, total_size, downloaded_size, state,
+                    supports_ranges, created_at, updated_at, content_type, error_message, checksum,
+                    priority)
+                   VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+               )"))
+            && saveSegment.prepare(QStringLiteral(R"(
+                   INSERT OR REPLACE INTO segments
+                   (id, download_id, segment_index, start_byte, end_byte, current_byte,
+                    state, checksum, temp_file, retry_count, last_error)
+                   VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+               )"))
+            && deleteSegments.prepare(QStringLiteral("DELETE FROM segments WHERE download_id = ?"))
+            && deleteTask.prepare(QStringLiteral("DELETE FROM downloads WHERE id = ?"))
+            && saveSetting.prepare(QStringLiteral("INSERT OR REPLACE INTO settings (key, value) VALUES (?, ?)"))
+            && saveHost.prepare(QStringLiteral(R"(
+                   INSERT OR REPLACE INTO host_cache
+                   (host, supports_ranges, protocol, advertises_h3, connections, updated_at)
+                   VALUES (?, ?, ?, ?, ?, ?)
+               )"))
+            && saveResource.prepare(QStringLiteral(R"(
+                   INSERT OR REPLACE INTO resource_cache
+                   (url, content_length, supports_ranges, supports_compression, content_type,
+                    file_name, etag, last_modified, status_code, protocol, updated_at)
+                   VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+               )"))
+            && deleteResource.prepare(QStringLiteral("DELETE FROM resource_cache WHERE url = ?"))
+            && saveMirrors.prepare(QStringLiteral(
+                   "INSERT OR REPLACE INTO download_mirrors (download_id, urls) VALUES (?, ?)"))
+            && saveMedia.prepare(QStringLiteral(
+                   "INSERT OR REPLACE INTO media_cache (key, info, expires_at) VALUES (?, ?, ?)"));
+    }
+
+    QSqlQuery saveTask;
+    QSqlQuery saveSegment;
+    QSqlQuery deleteSegments;
+    QSqlQuery deleteTask;
+    QSqlQuery saveSetting;
+    QSqlQuery saveHost;
+    QSqlQuery saveResource;
+    QSqlQuery deleteResource;
+    QSqlQuery saveMirrors;
+    QSqlQuery saveMedia;
+};
+
 PersistenceManager::PersistenceManager(QObject* parent)
     : QObject(parent)
 {
@@ -51,35 +126,44 @@ bool PersistenceManager::initialize(const QString& dbPath) {
     }
     
     // Enable WAL mode and other pragmas
-    QSqlQuery query(m_database);
-    query.exec(QStringLiteral("PRAGMA journal_mode = WAL"));
-    query.exec(QStringLiteral("PRAGMA synchronous = NORMAL"));
-    query.exec(QStringLiteral("PRAGMA foreign_keys = ON"));
-    query.exec(QStringLiteral("PRAGMA cache_size = -64000"));  // 64MB cache
+    applyPragmas(m_database);
     
-    // Create schema
-    if (!createSchema()) {
+    // Create schema, then bring tables of older databases up to date
+    if (!createSchema() || !migrateSchema()) {
         qCritical() << "PersistenceManager: Failed to create schema";
         m_database.close();
         return false;
     }
     
-    // Start write thread
+    // Start write thread; it opens its own connection (connections are thread-bound)
+    std::promise<bool> ready;
+    std::future<bool> writerReady = ready.get_future();
     m_running = true;
-    m_writeThread = std::thread(&PersistenceManager::writeThreadLoop, this);
+    m_writeThread = std::thread(&PersistenceManager::writeThreadLoop, this, std::move(ready));
+    
+    if (!writerReady.get()) {
+        qCritical() << "PersistenceManager: Failed to open writer connection";
+        m_writeThread.join();
+        m_running = false;
+        m_database.close();
+        return false;
+    }
     
     qDebug() << "PersistenceManager: Initialized successfully";
     return true;
 }
 
 void PersistenceManager::close() {
-    // Stop write thread
+    // Stop write thread; it commits whatever is still queued first
     if (m_running) {
-        m_running = false;
-        m_queueCondition.notify_all();
-        if (m_writeThread.joinable()) {
-            m_writeThread.join();
+        {
+            std::lock_guard lock(m_queueMutex);
+            m_running = false;
         }
+        m_queueCondition.notify_all();
+    }
+    if (m_writeThread.joinable()) {
+        m_writeThread.join();
     }
     
     // Close database
@@ -109,7 +193,8 @@ bool PersistenceManager::createSchema() {
             completed_at    INTEGER,
             content_type    TEXT,
             checksum        TEXT,
-            error_message   TEXT
+            error_message   TEXT,
+            priority        INTEGER NOT NULL DEFAULT 1
         )
     )"));
     
@@ -158,6 +243,75 @@ bool PersistenceManager::createSchema() {
         return false;
     }
     
+    // Capability cache: per host, and per resource with its validators
+    success = query.exec(QStringLiteral(R"(
+        CREATE TABLE IF NOT EXISTS host_cache (
+            host            TEXT PRIMARY KEY,
+            supports_ranges INTEGER DEFAULT 0,
+            protocol        INTEGER DEFAULT 0,
+            advertises_h3   INTEGER DEFAULT 0,
+            connections     INTEGER DEFAULT 0,
+            updated_at      INTEGER NOT NULL
+        )
+    )"));
+    
+    success = success && query.exec(QStringLiteral(R"(
+        CREATE TABLE IF NOT EXISTS resource_cache (
+            url             TEXT PRIMARY KEY,
+            content_length  INTEGER DEFAULT -1,
+            supports_ranges INTEGER DEFAULT 0,
+            supports_compression INTEGER DEFAULT 0,
+            content_type    TEXT,
+            file_name       TEXT,
+            etag            TEXT,
+            last_modified   TEXT,
+            status_code     INTEGER DEFAULT 0,
+            protocol        INTEGER DEFAULT 0,
+            updated_at      INTEGER NOT NULL
+        )
+    )"));
+    
+    if (!success) {
+        qCritical() << "PersistenceManager: Failed to create capability cache tables:"
+                    << query.lastError().text();
+        return false;
+    }
+    
+    // Mirrors of multi-source downloads, one newline-separated list per task
+    success = query.exec(QStringLiteral(R"(
+        CREATE TABLE IF NOT EXISTS download_mirrors (
+            download_id     TEXT PRIMARY KEY,
+            urls            TEXT NOT NULL,
+            FOREIGN KEY (download_id) REFERENCES downloads(id) ON DELETE CASCADE
+        )
+    )"));
+    
+    if (!success) {
+        qCritical() << "PersistenceManager: Failed to create mirrors table:"
+                    << query.lastError().text();
+        return false;
+    }
+    
+    // Extractor results (yt-dlp info JSON), dropped once expired
+    success = query.exec(QStringLiteral(R"(
+        CREATE TABLE IF NOT EXISTS media_cache (
+            key             TEXT PRIMARY KEY,
+            info            BLOB NOT NULL,
+            expires_at      INTEGER NOT NULL
+        )
+    )"));
+    
+    if (!success) {
+        qCritical() << "PersistenceManager: Failed to create media cache table:"
+                    << query.lastError().text();
+        return false;
+    }
+    
+    QSqlQuery prune(m_database);
+    prune.prepare(QStringLiteral("DELETE FROM media_cache WHERE expires_at < ?"));
+    prune.addBindValue(QDateTime::currentMSecsSinceEpoch());
+    prune.exec();
+    
     // Indexes
     query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS idx_downloads_state ON downloads(state)"));
     query.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS idx_segments_download ON segments(download_id)"));
@@ -165,6 +319,37 @@ bool PersistenceManager::createSchema() {
     return true;
 }
 
+bool PersistenceManager::migrateSchema() {
+    // Columns added after the first release; CREATE TABLE IF NOT EXISTS
+    // leaves existing tables as they were
+    QSqlQuery columns(m_database);
+    if (!columns.exec(QStringLiteral("PRAGMA table_info(downloads)"))) {
+        qCritical() << "PersistenceManager: Failed to read downloads columns:"
+                    << columns.lastError().text();
+        return false;
+    }
+    
+    bool hasPriority = false;
+    while (columns.next()) {
+        if (columns.value(1).toString() == QLatin1String("priority")) {
+            hasPriority = true;
+        }
+    }
+    
+    if (!hasPriority) {
+        QSqlQuery query(m_database);
+        if (!query.exec(QStringLiteral(
+                "ALTER TABLE downloads ADD COLUMN priority INTEGER NOT NULL DEFAULT 1"))) {
+            qCritical() << "PersistenceManager: Failed to add priority column:"
+                        << query.lastError().text();
+            return false;
+        }
+        qDebug() << "PersistenceManager: Added priority column to downloads";
+    }
+    
+    return true;
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Task Operations
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -172,6 +357,25 @@ bool PersistenceManager::createSchema() {
 void PersistenceManager::saveTask(DownloadTask* task) {
     if (!task) return;
     
+    std::vector<WriteRequest> requests;
+    appendSave(task, requests);
+    enqueueWrites(std::move(requests));
+}
+
+void PersistenceManager::saveTasks(const std::vector<DownloadTask*>& tasks) {
+    std::vector<WriteRequest> requests;
+    requests.reserve(tasks.size() * 2);
+    for (DownloadTask* task : tasks) {
+        if (task) {
+            appendSave(task, requests);
+        }
+    }
+    
+    // Queued together, so the writer takes them as one batch and one transaction
+    enqueueWrites(std::move(requests));
+}
+
+void PersistenceManager::appendSave(DownloadTask* task, std::vector<WriteRequest>& requests) {
     TaskData data;
     data.id = task->id();
     data.url = task->url();
@@ -185,27 +389,38 @@ void PersistenceManager::saveTask(DownloadTask* task) {
     data.updatedAt = QDateTime::currentMSecsSinceEpoch();
     data.contentType = task->contentType();
     data.errorMessage = task->errorMessage();
+    data.expectedHash = task->expectedHash().toString();
+    data.priority = task->priority();
+    for (const QUrl& mirror : task->mirrors()) {
+        data.mirrors.push_back(mirror.toString());
+    }
     
     WriteRequest request;
     request.op = WriteOp::SaveTask;
     request.taskId = task->id();
-    request.taskData = data;
-    
-    enqueueWrite(std::move(request));
+    request.taskData = std::move(data);
+    requests.push_back(std::move(request));
     
-    // Also save segments
-    auto segments = task->scheduler()->allSegments();
-    saveSegments(task->id(), segments);
+    // Also save segments, finished neighbours merged
+    WriteRequest segments;
+    segments.op = WriteOp::ReplaceSegments;
+    segments.taskId = task->id();
+    segments.segmentSnapshots = task->scheduler()->compactSnapshots();
+    requests.push_back(std::move(segments));
 }
 
 std::vector<TaskData> PersistenceManager::loadAllTasks() {
     std::vector<TaskData> result;
     
+    // Histories run to tens of thousands of rows; don't buffer them twice
     QSqlQuery query(m_database);
+    query.setForwardOnly(true);
     query.prepare(QStringLiteral(R"(
         SELECT id, url, file_path, file_name, total_size, downloaded_size,
-               state, supports_ranges, created_at, updated_at, content_type, error_message
+               state, supports_ranges, created_at, updated_at, content_type, error_message,
+               checksum, m.urls, priority
         FROM downloads
+        LEFT JOIN download_mirrors m ON m.download_id = downloads.id
         ORDER BY created_at DESC
     )"));
     
@@ -228,6 +443,9 @@ std::vector<TaskData> PersistenceManager::loadAllTasks() {
         data.updatedAt = query.value(9).toLongLong();
         data.contentType = query.value(10).toString();
         data.errorMessage = query.value(11).toString();
+        data.expectedHash = query.value(12).toString();
+        data.mirrors = query.value(13).toString().split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+        data.priority = static_cast<Priority>(std::clamp(query.value(14).toInt(), 0, 3));
         
         result.push_back(std::move(data));
     }
@@ -239,8 +457,10 @@ std::optional<TaskData> PersistenceManager::loadTask(const TaskId& id) {
     QSqlQuery query(m_database);
     query.prepare(QStringLiteral(R"(
         SELECT id, url, file_path, file_name, total_size, downloaded_size,
-               state, supports_ranges, created_at, updated_at, content_type, error_message
+               state, supports_ranges, created_at, updated_at, content_type, error_message,
+               checksum, m.urls, priority
         FROM downloads
+        LEFT JOIN download_mirrors m ON m.download_id = downloads.id
         WHERE id = ?
     )"));
     query.addBindValue(id.toString(QUuid::WithoutBraces));
@@ -262,6 +482,9 @@ std::optional<TaskData> PersistenceManager::loadTask(const TaskId& id) {
     data.updatedAt = query.value(9).toLongLong();
     data.contentType = query.value(10).toString();
     data.errorMessage = query.value(11).toString();
+    data.expectedHash = query.value(12).toString();
+    data.mirrors = query.value(13).toString().split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    data.priority = static_cast<Priority>(std::clamp(query.value(14).toInt(), 0, 3));
     
     return data;
 }
@@ -290,9 +513,29 @@ void PersistenceManager::saveSegment(const TaskId& taskId, Segment* segment) {
 }
 
 void PersistenceManager::saveSegments(const TaskId& taskId, const std::vector<Segment*>& segments) {
+    std::vector<WriteRequest> requests;
+    requests.reserve(segments.size());
+    
     for (Segment* seg : segments) {
-        saveSegment(taskId, seg);
+        if (!seg) continue;
+        
+        WriteRequest request;
+        request.op = WriteOp::SaveSegment;
+        request.taskId = taskId;
+        request.segmentSnapshot = seg->snapshot();
+        requests.push_back(std::move(request));
     }
+    
+    enqueueWrites(std::move(requests));
+}
+
+void PersistenceManager::replaceSegments(const TaskId& taskId, std::vector<Segment::Snapshot> snapshots) {
+    WriteRequest request;
+    request.op = WriteOp::ReplaceSegments;
+    request.taskId = taskId;
+    request.segmentSnapshots = std::move(snapshots);
+    
+    enqueueWrite(std::move(request));
 }
 
 std::vector<Segment::Snapshot> PersistenceManager::loadSegments(const TaskId& taskId) {
@@ -355,6 +598,126 @@ QString PersistenceManager::loadSetting(const QString& key, const QString& defau
     return defaultValue;
 }
 
+// ═══════════════════════════════════════════════════════════════════════════════
+// Capability Cache
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void PersistenceManager::saveHostRecord(const HostRecord& record) {
+    WriteRequest request;
+    request.op = WriteOp::SaveHost;
+    request.key = record.host;
+    request.hostRecord = record;
+    
+    enqueueWrite(std::move(request));
+}
+
+void PersistenceManager::saveResourceRecord(const ResourceRecord& record) {
+    WriteRequest request;
+    request.op = WriteOp::SaveResource;
+    request.key = record.url;
+    request.resourceRecord = record;
+    
+    enqueueWrite(std::move(request));
+}
+
+void PersistenceManager::deleteResourceRecord(const QString& url) {
+    WriteRequest request;
+    request.op = WriteOp::DeleteResource;
+    request.key = url;
+    
+    enqueueWrite(std::move(request));
+}
+
+std::vector<HostRecord> PersistenceManager::loadHostRecords() {
+    std::vector<HostRecord> result;
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral(R"(
+            SELECT host, supports_ranges, protocol, advertises_h3, connections, updated_at
+            FROM host_cache
+        )"))) {
+        qWarning() << "PersistenceManager: Failed to load host cache:" << query.lastError().text();
+        return result;
+    }
+    
+    while (query.next()) {
+        HostRecord record;
+        record.host = query.value(0).toString();
+        record.supportsRanges = query.value(1).toBool();
+        record.protocol = static_cast<HttpProtocol>(query.value(2).toInt());
+        record.advertisesHttp3 = query.value(3).toBool();
+        record.connections = query.value(4).toInt();
+        record.updatedAt = query.value(5).toLongLong();
+        
+        result.push_back(std::move(record));
+    }
+    
+    return result;
+}
+
+std::vector<ResourceRecord> PersistenceManager::loadResourceRecords() {
+    std::vector<ResourceRecord> result;
+    
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral(R"(
+            SELECT url, content_length, supports_ranges, supports_compression, content_type,
+                   file_name, etag, last_modified, status_code, protocol, updated_at
+            FROM resource_cache
+        )"))) {
+        qWarning() << "PersistenceManager: Failed to load resource cache:" << query.lastError().text();
+        return result;
+    }
+    
+    while (query.next()) {
+        ResourceRecord record;
+        record.url = query.value(0).toString();
+        ServerCapabilities& caps = record.capabilities;
+        caps.contentLength = query.value(1).toLongLong();
+        caps.supportsRanges = query.value(2).toBool();
+        caps.supportsCompression = query.value(3).toBool();
+        caps.contentType = query.value(4).toString();
+        caps.fileName = query.value(5).toString();
+        caps.etag = query.value(6).toString();
+        caps.lastModified = query.value(7).toString();
+        caps.httpStatusCode = query.value(8).toInt();
+        caps.protocol = static_cast<HttpProtocol>(query.value(9).toInt());
+        record.updatedAt = query.value(10).toLongLong();
+        
+        result.push_back(std::move(record));
+    }
+    
+    return result;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Media Info Cache
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void PersistenceManager::saveMediaInfo(const QString& key, const QByteArray& info, qint64 expiresAt) {
+    WriteRequest request;
+    request.op = WriteOp::SaveMedia;
+    request.key = key;
+    request.blob = info;
+    request.expiresAt = expiresAt;
+    
+    enqueueWrite(std::move(request));
+}
+
+std::optional<QByteArray> PersistenceManager::loadMediaInfo(const QString& key) {
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral("SELECT info FROM media_cache WHERE key = ? AND expires_at > ?"));
+    query.addBindValue(key);
+    query.addBindValue(QDateTime::currentMSecsSinceEpoch());
+    
+    if (query.exec() && query.next()) {
+        return query.value(0).toByteArray();
+    }
+    
+    return std::nullopt;
+}
+
 // ═══════════════════════════════════════════════════════════════════════════════
 // Maintenance
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -377,17 +740,66 @@ void PersistenceManager::vacuum() {
 void PersistenceManager::enqueueWrite(WriteRequest request) {
     {
         std::lock_guard lock(m_queueMutex);
-        m_writeQueue.push(std::move(request));
+        m_writeQueue.push_back(std::move(request));
+        EngineMetrics::instance().setPersistenceQueueDepth(m_writeQueue.size());
+    }
+    m_queueCondition.notify_one();
+}
+
+void PersistenceManager::enqueueWrites(std::vector<WriteRequest> requests) {
+    if (requests.empty()) return;
+    
+    {
+        std::lock_guard lock(m_queueMutex);
+        m_writeQueue.insert(m_writeQueue.end(),
+                            std::make_move_iterator(requests.begin()),
+                            std::make_move_iterator(requests.end()));
+        EngineMetrics::instance().setPersistenceQueueDepth(m_writeQueue.size());
     }
     m_queueCondition.notify_one();
 }
 
-void PersistenceManager::writeThreadLoop() {
+bool PersistenceManager::openWriterConnection() {
+    // Clone from this thread so the writer connection belongs to it
+    m_writer = QSqlDatabase::cloneDatabase(QStringLiteral("openidm"), WRITER_CONNECTION);
+    if (!m_writer.open()) {
+        qCritical() << "PersistenceManager: Failed to open writer connection:"
+                    << m_writer.lastError().text();
+        return false;
+    }
+    applyPragmas(m_writer);
+    
+    m_statements = std::make_unique<Statements>(m_writer);
+    if (!m_statements->prepare()) {
+        qCritical() << "PersistenceManager: Failed to prepare statements:"
+                    << m_writer.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void PersistenceManager::closeWriterConnection() {
+    m_statements.reset();
+    if (m_writer.isOpen()) {
+        m_writer.close();
+    }
+    m_writer = QSqlDatabase();
+    QSqlDatabase::removeDatabase(WRITER_CONNECTION);
+}
+
+void PersistenceManager::writeThreadLoop(std::promise<bool> ready) {
+    bool opened = openWriterConnection();
+    ready.set_value(opened);
+    if (!opened) {
+        closeWriterConnection();
+        return;
+    }
+    
     qDebug() << "PersistenceManager: Write thread started";
     
-    while (m_running || !m_writeQueue.empty()) {
-        WriteRequest request;
-        
+    std::vector<WriteRequest> batch;
+    
+    while (true) {
         {
             std::unique_lock lock(m_queueMutex);
             m_queueCondition.wait(lock, [this]() {
@@ -395,19 +807,149 @@ void PersistenceManager::writeThreadLoop() {
             });
             
             if (m_writeQueue.empty()) {
-                continue;
+                break;  // Stopping and fully drained
             }
             
-            request = std::move(m_writeQueue.front());
-            m_writeQueue.pop();
+            // Let the rest of a burst (saveTask() + its segments, a progress
+            // tick across all tasks) arrive so it shares one transaction
+            if (m_running) {
+                m_queueCondition.wait_for(lock, Constants::PERSISTENCE_BATCH_WINDOW,
+                                          [this]() { return !m_running.load(); });
+            }
+            
+            batch.swap(m_writeQueue);
+            EngineMetrics::instance().setPersistenceQueueDepth(0);
         }
         
-        processWrite(request);
+        processBatch(batch);
+        batch.clear();
     }
     
+    closeWriterConnection();
     qDebug() << "PersistenceManager: Write thread stopped";
 }
 
+std::vector<PersistenceManager::WriteRequest>
+PersistenceManager::coalesce(std::vector<WriteRequest>& batch) {
+    std::vector<WriteRequest> ordered;
+    std::vector<bool> dropped;
+    ordered.reserve(batch.size());
+    dropped.reserve(batch.size());
+    
+    // Latest pending entry per key; it keeps the slot of the first occurrence
+    // so a task row still precedes its segment rows (foreign key)
+    std::map<TaskId, size_t> tasks;
+    std::map<std::pair<TaskId, SegmentId>, size_t> segments;
+    std::map<TaskId, size_t> layouts;           ///< Replaces everything before it
+    std::map<QString, size_t> settings;
+    std::map<QString, size_t> hosts;
+    std::map<QString, size_t> resources;        ///< Saves and deletes; the last one wins
+    std::map<QString, size_t> media;
+    
+    auto append = [&](WriteRequest& request) {
+        ordered.push_back(std::move(request));
+        dropped.push_back(false);
+        return ordered.size() - 1;
+    };
+    
+    auto upsert = [&](auto& index, const auto& key, WriteRequest& request) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            ordered[it->second] = std::move(request);
+        } else {
+            index.emplace(key, append(request));
+        }
+    };
+    
+    for (WriteRequest& request : batch) {
+        switch (request.op) {
+            case WriteOp::SaveTask:
+                upsert(tasks, request.taskId, request);
+                break;
+            case WriteOp::SaveSegment:
+                upsert(segments, std::make_pair(request.taskId, request.segmentSnapshot.id), request);
+                break;
+            case WriteOp::ReplaceSegments: {
+                // Earlier rows of the task are superseded, not just updated
+                const TaskId id = request.taskId;
+                if (auto it = layouts.find(id); it != layouts.end()) {
+                    dropped[it->second] = true;
+                    layouts.erase(it);
+                }
+                auto seg = segments.lower_bound(std::make_pair(id, SegmentId{0}));
+                while (seg != segments.end() && seg->first.first == id) {
+                    dropped[seg->second] = true;
+                    seg = segments.erase(seg);
+                }
+                layouts.emplace(id, append(request));
+                break;
+            }
+            case WriteOp::SaveSetting:
+                upsert(settings, request.key, request);
+                break;
+            case WriteOp::SaveHost:
+                upsert(hosts, request.key, request);
+                break;
+            case WriteOp::SaveResource:
+            case WriteOp::DeleteResource:
+                upsert(resources, request.key, request);
+                break;
+            case WriteOp::SaveMedia:
+                upsert(media, request.key, request);
+                break;
+            case WriteOp::DeleteTask: {
+                // Earlier saves are moot; later ones start fresh after the delete
+                const TaskId id = request.taskId;
+                if (auto it = tasks.find(id); it != tasks.end()) {
+                    dropped[it->second] = true;
+                    tasks.erase(it);
+                }
+                auto seg = segments.lower_bound(std::make_pair(id, SegmentId{0}));
+                while (seg != segments.end() && seg->first.first == id) {
+                    dropped[seg->second] = true;
+                    seg = segments.erase(seg);
+                }
+                if (auto it = layouts.find(id); it != layouts.end()) {
+                    dropped[it->second] = true;
+                    layouts.erase(it);
+                }
+                append(request);
+                break;
+            }
+        }
+    }
+    
+    std::vector<WriteRequest> result;
+    result.reserve(ordered.size());
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        if (!dropped[i]) {
+            result.push_back(std::move(ordered[i]));
+        }
+    }
+    return result;
+}
+
+void PersistenceManager::processBatch(std::vector<WriteRequest>& batch) {
+    std::vector<WriteRequest> requests = coalesce(batch);
+    
+    // One transaction per batch: a single WAL commit instead of one per row
+    bool transaction = m_writer.transaction();
+    if (!transaction) {
+        qWarning() << "PersistenceManager: Failed to begin transaction:"
+                   << m_writer.lastError().text();
+    }
+    
+    for (const WriteRequest& request : requests) {
+        processWrite(request);
+    }
+    
+    if (transaction && !m_writer.commit()) {
+        qWarning() << "PersistenceManager: Failed to commit" << requests.size()
+                   << "writes:" << m_writer.lastError().text();
+        m_writer.rollback();
+    }
+}
+
 void PersistenceManager::processWrite(const WriteRequest& request) {
     switch (request.op) {
         case WriteOp::SaveTask:
@@ -416,79 +958,109 @@ void PersistenceManager::processWrite(const WriteRequest& request) {
         case WriteOp::SaveSegment:
             doSaveSegment(request.taskId, request.segmentSnapshot);
             break;
+        case WriteOp::ReplaceSegments:
+            doReplaceSegments(request.taskId, request.segmentSnapshots);
+            break;
         case WriteOp::DeleteTask:
             doDeleteTask(request.taskId);
             break;
         case WriteOp::SaveSetting:
             doSaveSetting(request.key, request.value);
             break;
+        case WriteOp::SaveHost:
+            doSaveHost(request.hostRecord);
+            break;
+        case WriteOp::SaveResource:
+            doSaveResource(request.resourceRecord);
+            break;
+        case WriteOp::DeleteResource:
+            doDeleteResource(request.key);
+            break;
+        case WriteOp::SaveMedia:
+            doSaveMedia(request.key, request.blob, request.expiresAt);
+            break;
     }
 }
 
 void PersistenceManager::doSaveTask(const TaskData& data) {
-    QSqlQuery query(m_database);
-    query.prepare(QStringLiteral(R"(
-        INSERT OR REPLACE INTO downloads
-        (id, url, file_path, file_name, total_size, downloaded_size, state,
-         supports_ranges, created_at, updated_at, content_type, error_message)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-    )"));
+    QSqlQuery& query = m_statements->saveTask;
     
-    query.addBindValue(data.id.toString(QUuid::WithoutBraces));
-    query.addBindValue(data.url);
-    query.addBindValue(data.filePath);
-    query.addBindValue(data.fileName);
-    query.addBindValue(data.totalSize);
-    query.addBindValue(data.downloadedSize);
-    query.addBindValue(static_cast<int>(data.state));
-    query.addBindValue(data.supportsRanges ? 1 : 0);
-    query.addBindValue(data.createdAt);
-    query.addBindValue(data.updatedAt);
-    query.addBindValue(data.contentType);
-    query.addBindValue(data.errorMessage);
+    query.bindValue(0, data.id.toString(QUuid::WithoutBraces));
+    query.bindValue(1, data.url);
+    query.bindValue(2, data.filePath);
+    query.bindValue(3, data.fileName);
+    query.bindValue(4, data.totalSize);
+    query.bindValue(5, data.downloadedSize);
+    query.bindValue(6, static_cast<int>(data.state));
+    query.bindValue(7, data.supportsRanges ? 1 : 0);
+    query.bindValue(8, data.createdAt);
+    query.bindValue(9, data.updatedAt);
+    query.bindValue(10, data.contentType);
+    query.bindValue(11, data.errorMessage);
+    query.bindValue(12, data.expectedHash);
+    query.bindValue(13, static_cast<int>(data.priority));
     
     if (!query.exec()) {
         qWarning() << "PersistenceManager: Failed to save task:" << query.lastError().text();
+        return;
+    }
+    
+    // Replacing the downloads row may cascade to its mirrors; write them back
+    if (!data.mirrors.isEmpty()) {
+        QSqlQuery& mirrors = m_statements->saveMirrors;
+        mirrors.bindValue(0, data.id.toString(QUuid::WithoutBraces));
+        mirrors.bindValue(1, data.mirrors.join(QLatin1Char('\n')));
+        if (!mirrors.exec()) {
+            qWarning() << "PersistenceManager: Failed to save mirrors:" << mirrors.lastError().text();
+        }
     }
 }
 
 void PersistenceManager::doSaveSegment(const TaskId& taskId, const Segment::Snapshot& snap) {
-    QSqlQuery query(m_database);
-    query.prepare(QStringLiteral(R"(
-        INSERT OR REPLACE INTO segments
-        (id, download_id, segment_index, start_byte, end_byte, current_byte,
-         state, checksum, temp_file, retry_count, last_error)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-    )"));
+    QSqlQuery& query = m_statements->saveSegment;
     
-    query.addBindValue(snap.id);
-    query.addBindValue(taskId.toString(QUuid::WithoutBraces));
-    query.addBindValue(snap.id);  // segment_index same as id for now
-    query.addBindValue(snap.startByte);
-    query.addBindValue(snap.endByte);
-    query.addBindValue(snap.currentByte);
-    query.addBindValue(static_cast<int>(snap.state));
-    query.addBindValue(snap.checksum);
-    query.addBindValue(snap.tempFilePath);
-    query.addBindValue(snap.retryCount);
-    query.addBindValue(snap.lastError);
+    query.bindValue(0, snap.id);
+    query.bindValue(1, taskId.toString(QUuid::WithoutBraces));
+    query.bindValue(2, snap.id);  // segment_index same as id for now
+    query.bindValue(3, snap.startByte);
+    query.bindValue(4, snap.endByte);
+    query.bindValue(5, snap.currentByte);
+    query.bindValue(6, static_cast<int>(snap.state));
+    query.bindValue(7, snap.checksum);
+    query.bindValue(8, snap.tempFilePath);
+    query.bindValue(9, snap.retryCount);
+    query.bindValue(10, snap.lastError);
     
     if (!query.exec()) {
         qWarning() << "PersistenceManager: Failed to save segment:" << query.lastError().text();
     }
 }
 
+void PersistenceManager::doReplaceSegments(const TaskId& taskId, const std::vector<Segment::Snapshot>& snapshots) {
+    QSqlQuery& segments = m_statements->deleteSegments;
+    segments.bindValue(0, taskId.toString(QUuid::WithoutBraces));
+    
+    if (!segments.exec()) {
+        qWarning() << "PersistenceManager: Failed to clear segments:" << segments.lastError().text();
+        return;
+    }
+    
+    for (const Segment::Snapshot& snap : snapshots) {
+        doSaveSegment(taskId, snap);
+    }
+}
+
 void PersistenceManager::doDeleteTask(const TaskId& id) {
-    QSqlQuery query(m_database);
+    const QString key = id.toString(QUuid::WithoutBraces);
     
     // Delete segments first (foreign key)
-    query.prepare(QStringLiteral("DELETE FROM segments WHERE download_id = ?"));
-    query.addBindValue(id.toString(QUuid::WithoutBraces));
-    query.exec();
+    QSqlQuery& segments = m_statements->deleteSegments;
+    segments.bindValue(0, key);
+    segments.exec();
     
     // Delete task
-    query.prepare(QStringLiteral("DELETE FROM downloads WHERE id = ?"));
-    query.addBindValue(id.toString(QUuid::WithoutBraces));
+    QSqlQuery& query = m_statements->deleteTask;
+    query.bindValue(0, key);
     
     if (!query.exec()) {
         qWarning() << "PersistenceManager: Failed to delete task:" << query.lastError().text();
@@ -496,14 +1068,69 @@ void PersistenceManager::doDeleteTask(const TaskId& id) {
 }
 
 void PersistenceManager::doSaveSetting(const QString& key, const QString& value) {
-    QSqlQuery query(m_database);
-    query.prepare(QStringLiteral("INSERT OR REPLACE INTO settings (key, value) VALUES (?, ?)"));
-    query.addBindValue(key);
-    query.addBindValue(value);
+    QSqlQuery& query = m_statements->saveSetting;
+    query.bindValue(0, key);
+    query.bindValue(1, value);
     
     if (!query.exec()) {
         qWarning() << "PersistenceManager: Failed to save setting:" << query.lastError().text();
     }
 }
 
+void PersistenceManager::doSaveHost(const HostRecord& record) {
+    QSqlQuery& query = m_statements->saveHost;
+    
+    query.bindValue(0, record.host);
+    query.bindValue(1, record.supportsRanges ? 1 : 0);
+    query.bindValue(2, static_cast<int>(record.protocol));
+    query.bindValue(3, record.advertisesHttp3 ? 1 : 0);
+    query.bindValue(4, record.connections);
+    query.bindValue(5, record.updatedAt);
+    
+    if (!query.exec()) {
+        qWarning() << "PersistenceManager: Failed to save host entry:" << query.lastError().text();
+    }
+}
+
+void PersistenceManager::doSaveResource(const ResourceRecord& record) {
+    QSqlQuery& query = m_statements->saveResource;
+    const ServerCapabilities& caps = record.capabilities;
+    
+    query.bindValue(0, record.url);
+    query.bindValue(1, caps.contentLength);
+    query.bindValue(2, caps.supportsRanges ? 1 : 0);
+    query.bindValue(3, caps.supportsCompression ? 1 : 0);
+    query.bindValue(4, caps.contentType);
+    query.bindValue(5, caps.fileName);
+    query.bindValue(6, caps.etag);
+    query.bindValue(7, caps.lastModified);
+    query.bindValue(8, caps.httpStatusCode);
+    query.bindValue(9, static_cast<int>(caps.protocol));
+    query.bindValue(10, record.updatedAt);
+    
+    if (!query.exec()) {
+        qWarning() << "PersistenceManager: Failed to save resource entry:" << query.lastError().text();
+    }
+}
+
+void PersistenceManager::doDeleteResource(const QString& url) {
+    QSqlQuery& query = m_statements->deleteResource;
+    query.bindValue(0, url);
+    
+    if (!query.exec()) {
+        qWarning() << "PersistenceManager: Failed to delete resource entry:" << query.lastError().text();
+    }
+}
+
+void PersistenceManager::doSaveMedia(const QString& key, const QByteArray& info, qint64 expiresAt) {
+    QSqlQuery& query = m_statements->saveMedia;
+    query.bindValue(0, key);
+    query.bindValue(1, info);
+    query.bindValue(2, expiresAt);
+    
+    if (!query.exec()) {
+        qWarning() << "PersistenceManager: Failed to save media info:" << query.lastError().text();
+    }
+}
+
 } // namespace OpenIDM
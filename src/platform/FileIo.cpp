@@ -0,0 +1,425 @@
+/**
+ * @file FileIo.cpp
+ * @brief Backend selection and the synchronous fallback
+ *
+ * @copyright Copyright (c) 2024 OpenIDM Project
+ * @license GPL-3.0-or-later
+ */
+
+#include "FileIo.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <new>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef Q_OS_MACOS
+#include <copyfile.h>
+#include <sys/clonefile.h>
+#endif
+
+namespace OpenIDM {
+
+namespace {
+
+/**
+ * @brief Executes queued operations one by one on submit()
+ */
+class SyncFileIo : public FileIo {
+public:
+    explicit SyncFileIo(unsigned queueDepth)
+        : m_depth(queueDepth)
+    {
+    }
+
+    const char* name() const override { return "sync"; }
+
+    bool queueWrite(qintptr handle, ByteOffset offset,
+                    const char* data, size_t length, void* tag) override {
+        return enqueue({handle, offset, const_cast<char*>(data), length, tag, true});
+    }
+
+    bool queueRead(qintptr handle, ByteOffset offset,
+                   char* data, size_t length, void* tag) override {
+        return enqueue({handle, offset, data, length, tag, false});
+    }
+
+    void submit() override {
+        for (const Operation& op : m_queued) {
+            m_done.push_back({op.tag, execute(op)});
+        }
+        m_queued.clear();
+    }
+
+    size_t wait(std::vector<Completion>& completions, size_t /*minimum*/) override {
+        size_t count = m_done.size();
+        completions.insert(completions.end(), m_done.begin(), m_done.end());
+        m_done.clear();
+        return count;
+    }
+
+    size_t pending() const override { return m_queued.size() + m_done.size(); }
+
+private:
+    struct Operation {
+        qintptr handle;
+        ByteOffset offset;
+        char* data;
+        size_t length;
+        void* tag;
+        bool write;
+    };
+
+    bool enqueue(const Operation& op) {
+        if (pending() >= m_depth) {
+            return false;
+        }
+        m_queued.push_back(op);
+        return true;
+    }
+
+    static int64_t execute(const Operation& op) {
+        size_t done = 0;
+        while (done < op.length) {
+#ifdef Q_OS_WIN
+            ByteOffset position = op.offset + static_cast<ByteOffset>(done);
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFF);
+            overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+            HANDLE handle = reinterpret_cast<HANDLE>(op.handle);
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(op.length - done, 0x7FFFFFFF));
+            DWORD transferred = 0;
+            BOOL ok = op.write
+                ? WriteFile(handle, op.data + done, chunk, &transferred, &overlapped)
+                : ReadFile(handle, op.data + done, chunk, &transferred, &overlapped);
+            if (!ok && GetLastError() == ERROR_IO_PENDING) {
+                ok = GetOverlappedResult(handle, &overlapped, &transferred, TRUE);
+            }
+            if (!ok) {
+                if (!op.write && GetLastError() == ERROR_HANDLE_EOF) {
+                    break;
+                }
+                return -static_cast<int64_t>(GetLastError());
+            }
+#else
+            int fd = static_cast<int>(op.handle);
+            off_t position = static_cast<off_t>(op.offset + static_cast<ByteOffset>(done));
+            ssize_t transferred = op.write
+                ? ::pwrite(fd, op.data + done, op.length - done, position)
+                : ::pread(fd, op.data + done, op.length - done, position);
+            if (transferred < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -static_cast<int64_t>(errno);
+            }
+#endif
+            if (transferred == 0) {
+                break;  // End of file (reads) or no progress (writes)
+            }
+            done += static_cast<size_t>(transferred);
+        }
+        return static_cast<int64_t>(done);
+    }
+
+    unsigned m_depth;
+    std::vector<Operation> m_queued;
+    std::vector<Completion> m_done;
+};
+
+/// Reads kept in flight by readSequential()
+constexpr size_t READ_AHEAD = 4;
+
+#ifndef Q_OS_WIN
+/**
+ * @brief Copy @p size bytes from @p in to @p out, cheapest method first
+ */
+bool copyData(int in, int out, off_t size) {
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    // Reflink (btrfs, XFS): the copy shares extents, so nothing is read.
+    // Works across btrfs subvolumes, where rename() reports EXDEV.
+    if (::ioctl(out, FICLONE, in) == 0) {
+        return true;
+    }
+#endif
+#ifdef Q_OS_MACOS
+    if (::fcopyfile(in, out, nullptr, COPYFILE_DATA) == 0) {
+        return true;
+    }
+#endif
+
+    off_t done = 0;
+#ifdef Q_OS_LINUX
+    // In-kernel copy; some filesystem pairs refuse it, then reads take over
+    while (done < size) {
+        ssize_t copied = ::copy_file_range(in, nullptr, out, nullptr, static_cast<size_t>(size - done), 0);
+        if (copied <= 0) {
+            break;
+        }
+        done += copied;
+    }
+#endif
+
+    std::vector<char> buffer(done < size ? Constants::FILE_WRITE_BUFFER : 0);
+    while (done < size) {
+        ssize_t got = ::read(in, buffer.data(), buffer.size());
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        for (ssize_t written = 0; written < got;) {
+            ssize_t put = ::write(out, buffer.data() + written, static_cast<size_t>(got - written));
+            if (put < 0 && errno == EINTR) {
+                continue;
+            }
+            if (put <= 0) {
+                return false;
+            }
+            written += put;
+        }
+        done += got;
+    }
+    return true;
+}
+
+/**
+ * @brief Create @p to as a durable copy of @p from
+ */
+bool copyFile(const QByteArray& from, const QByteArray& to, QString* error) {
+#ifdef Q_OS_MACOS
+    // APFS clone: shares blocks until either file changes
+    ::unlink(to.constData());
+    if (::clonefile(from.constData(), to.constData(), 0) == 0) {
+        return true;
+    }
+#endif
+
+    int in = ::open(from.constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        *error = QStringLiteral("Cannot open %1: %2").arg(QFile::decodeName(from), QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+    struct stat info{};
+    ::fstat(in, &info);
+
+    int out = ::open(to.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 0777);
+    if (out < 0) {
+        *error = QStringLiteral("Cannot create %1: %2").arg(QFile::decodeName(to), QString::fromLocal8Bit(std::strerror(errno)));
+        ::close(in);
+        return false;
+    }
+
+    bool ok = copyData(in, out, info.st_size) && ::fsync(out) == 0;
+    if (!ok) {
+        *error = QStringLiteral("Cannot copy %1 to %2: %3")
+                     .arg(QFile::decodeName(from), QFile::decodeName(to), QString::fromLocal8Bit(std::strerror(errno)));
+    }
+    ::close(in);
+    ::close(out);
+    return ok;
+}
+#endif
+
+} // namespace
+
+std::unique_ptr<FileIo> FileIo::create(unsigned queueDepth) {
+    queueDepth = std::max(queueDepth, 1u);
+
+    std::unique_ptr<FileIo> io;
+#if defined(OPENIDM_HAVE_IO_URING)
+    io = createUringFileIo(queueDepth);
+#elif defined(Q_OS_WIN)
+    io = createIocpFileIo(queueDepth);
+#endif
+
+    if (!io) {
+        io = createSynchronous(queueDepth);
+    }
+
+    qDebug() << "FileIo: Using" << io->name() << "backend, queue depth" << queueDepth;
+    return io;
+}
+
+std::unique_ptr<FileIo> FileIo::createSynchronous(unsigned queueDepth) {
+    return std::make_unique<SyncFileIo>(std::max(queueDepth, 1u));
+}
+
+bool FileIo::readSequential(const QString& path,
+                            const std::function<bool(const char*, size_t)>& consumer) {
+    QString native = QDir::toNativeSeparators(path);
+#ifdef Q_OS_WIN
+    HANDLE file = CreateFileW(reinterpret_cast<LPCWSTR>(native.utf16()),
+                              GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        qWarning() << "FileIo: Cannot open" << path << "for reading:" << GetLastError();
+        return false;
+    }
+    auto handle = reinterpret_cast<qintptr>(file);
+#else
+    int fd = ::open(QFile::encodeName(native).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        qWarning() << "FileIo: Cannot open" << path << "for reading:" << errno;
+        return false;
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    qintptr handle = fd;
+#endif
+
+    struct Slot {
+        char* data{nullptr};
+        ByteOffset offset{0};
+        int64_t result{0};
+        bool done{false};
+    };
+
+    constexpr size_t CHUNK = Constants::FILE_WRITE_BUFFER;
+    constexpr std::align_val_t ALIGN{Constants::DIRECT_IO_ALIGNMENT};
+
+    std::unique_ptr<FileIo> io = create(static_cast<unsigned>(READ_AHEAD));
+    Slot slots[READ_AHEAD];
+    ByteOffset nextOffset = 0;
+
+    for (auto& slot : slots) {
+        slot.data = static_cast<char*>(::operator new(CHUNK, ALIGN));
+        slot.offset = nextOffset;
+        io->queueRead(handle, slot.offset, slot.data, CHUNK, &slot);
+        nextOffset += CHUNK;
+    }
+    io->submit();
+
+    bool complete = false;
+    bool ok = true;
+    size_t head = 0;
+    std::vector<Completion> completions;
+
+    while (ok && !complete) {
+        // Deliver finished chunks in order, refilling each slot behind us
+        while (slots[head].done) {
+            Slot& slot = slots[head];
+            if (slot.result < 0) {
+                qWarning() << "FileIo: Read failed at offset" << slot.offset << "of" << path;
+                ok = false;
+                break;
+            }
+            if (slot.result > 0 && !consumer(slot.data, static_cast<size_t>(slot.result))) {
+                ok = false;
+                break;
+            }
+            if (slot.result < static_cast<int64_t>(CHUNK)) {
+                complete = true;  // Short read: end of file
+                break;
+            }
+
+            slot.done = false;
+            slot.offset = nextOffset;
+            io->queueRead(handle, slot.offset, slot.data, CHUNK, &slot);
+            nextOffset += CHUNK;
+            head = (head + 1) % READ_AHEAD;
+        }
+        if (!ok || complete) {
+            break;
+        }
+
+        io->submit();
+        completions.clear();
+        if (io->wait(completions, 1) == 0) {
+            ok = false;
+            break;
+        }
+        for (const auto& completion : completions) {
+            auto* slot = static_cast<Slot*>(completion.tag);
+            slot->result = completion.result;
+            slot->done = true;
+        }
+    }
+
+    // Reads past the end may still be in flight; buffers must outlive them
+    io.reset();
+    for (auto& slot : slots) {
+        ::operator delete(slot.data, ALIGN);
+    }
+
+#ifdef Q_OS_WIN
+    CloseHandle(file);
+#else
+    ::close(fd);
+#endif
+    return ok && complete;
+}
+
+bool FileIo::moveFile(const QString& from, const QString& to, QString* error) {
+#ifdef Q_OS_WIN
+    auto source = reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16());
+    auto target = reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16());
+    if (MoveFileExW(source, target, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        return true;
+    }
+    DWORD code = GetLastError();
+    if (code != ERROR_NOT_SAME_DEVICE) {
+        *error = QStringLiteral("Cannot rename %1 to %2 (error %3)").arg(from, to).arg(code);
+        return false;
+    }
+
+    // Another volume: the system copy engine, unbuffered for large files
+    if (!CopyFileExW(source, target, nullptr, nullptr, nullptr, COPY_FILE_NO_BUFFERING)) {
+        *error = QStringLiteral("Cannot copy %1 to %2 (error %3)").arg(from, to).arg(GetLastError());
+        return false;
+    }
+    DeleteFileW(source);
+    return true;
+#else
+    QByteArray source = QFile::encodeName(QDir::toNativeSeparators(from));
+    QByteArray target = QFile::encodeName(QDir::toNativeSeparators(to));
+
+    // Replaces an existing target atomically
+    if (::rename(source.constData(), target.constData()) == 0) {
+        return true;
+    }
+    if (errno != EXDEV) {
+        *error = QStringLiteral("Cannot rename %1 to %2: %3").arg(from, to, QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+
+    // Another filesystem: copy next to the target so the swap stays atomic
+    QByteArray temp = target + ".moving";
+    if (!copyFile(source, temp, error)) {
+        ::unlink(temp.constData());
+        return false;
+    }
+    if (::rename(temp.constData(), target.constData()) != 0) {
+        *error = QStringLiteral("Cannot rename %1 to %2: %3")
+                     .arg(QFile::decodeName(temp), to, QString::fromLocal8Bit(std::strerror(errno)));
+        ::unlink(temp.constData());
+        return false;
+    }
+    ::unlink(source.constData());
+    qDebug() << "FileIo: Copied" << from << "across filesystems to" << to;
+    return true;
+#endif
+}
+
+} // namespace OpenIDM
@@ -0,0 +1,134 @@
+/**
+ * @file FileIo.h
+ * @brief Batched asynchronous positional file I/O
+ *
+ * Backends: io_uring on Linux (when built with liburing), I/O completion
+ * ports on Windows, and a synchronous pread/pwrite fallback everywhere else.
+ * Callers queue a batch of operations, submit it once and then reap
+ * completions, so a single thread can keep the device queue full.
+ *
+ * @copyright Copyright (c) 2024 OpenIDM Project
+ * @license GPL-3.0-or-later
+ */
+
+#ifndef OPENIDM_FILEIO_H
+#define OPENIDM_FILEIO_H
+
+#include "openidm/engine/Types.h"
+
+#include <QString>
+#include <QtGlobal>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace OpenIDM {
+
+/**
+ * @brief Asynchronous file I/O queue
+ *
+ * Handles are native: a file descriptor on POSIX, a HANDLE on Windows
+ * (IOCP needs it opened with FILE_FLAG_OVERLAPPED; other handles are
+ * served synchronously). Buffers must stay valid until their completion
+ * has been reaped.
+ *
+ * Thread Safety:
+ * - Not thread-safe; one instance per submitting thread
+ */
+class FileIo {
+public:
+    /**
+     * @brief Result of one operation
+     */
+    struct Completion {
+        void* tag{nullptr};         ///< Value passed when queueing
+        int64_t result{0};          ///< Bytes transferred, or negative error code
+    };
+
+    /**
+     * @brief Create the best backend available on this platform
+     * @param queueDepth Maximum operations in flight
+     */
+    static std::unique_ptr<FileIo> create(unsigned queueDepth = Constants::FILE_IO_QUEUE_DEPTH);
+
+    /**
+     * @brief Create the portable backend that runs operations on submit()
+     */
+    static std::unique_ptr<FileIo> createSynchronous(unsigned queueDepth = Constants::FILE_IO_QUEUE_DEPTH);
+
+    /**
+     * @brief Read a whole file front to back with several reads in flight
+     *
+     * Used by verification passes: the next chunks are already being read
+     * while the consumer hashes the current one. Chunks are delivered in
+     * file order.
+     *
+     * @param path File to read
+     * @param consumer Called per chunk; return false to stop early
+     * @return True if the file was read to the end (and not stopped)
+     */
+    static bool readSequential(const QString& path,
+                               const std::function<bool(const char*, size_t)>& consumer);
+
+    /**
+     * @brief Move a file into place, replacing any file at the target
+     *
+     * Renames when both paths are on one filesystem. Otherwise the data is
+     * cloned (FICLONE, clonefile) or copied inside the kernel
+     * (copy_file_range, CopyFileEx) next to the target, renamed over it,
+     * and the source removed; user-space reads are the last resort.
+     *
+     * @param error Set when false is returned
+     */
+    static bool moveFile(const QString& from, const QString& to, QString* error);
+
+    virtual ~FileIo() = default;
+
+    /// @return Backend name for logging ("io_uring", "iocp", "sync")
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Queue a write; nothing is issued before submit()
+     * @return False if the queue is full (submit and reap first)
+     */
+    virtual bool queueWrite(qintptr handle, ByteOffset offset,
+                            const char* data, size_t length, void* tag) = 0;
+
+    /**
+     * @brief Queue a read; nothing is issued before submit()
+     * @return False if the queue is full (submit and reap first)
+     */
+    virtual bool queueRead(qintptr handle, ByteOffset offset,
+                           char* data, size_t length, void* tag) = 0;
+
+    /**
+     * @brief Issue every queued operation with as few system calls as possible
+     */
+    virtual void submit() = 0;
+
+    /**
+     * @brief Reap completions, blocking until at least @p minimum are available
+     *
+     * Returns early with fewer if nothing else is in flight.
+     * @return Number of completions appended to @p completions
+     */
+    virtual size_t wait(std::vector<Completion>& completions, size_t minimum) = 0;
+
+    /// @return Operations submitted or queued but not yet reaped
+    virtual size_t pending() const = 0;
+};
+
+#if defined(OPENIDM_HAVE_IO_URING)
+/// @return io_uring backend, or nullptr if the kernel refuses a ring
+std::unique_ptr<FileIo> createUringFileIo(unsigned queueDepth);
+#endif
+
+#if defined(Q_OS_WIN)
+/// @return IOCP backend, or nullptr if no port could be created
+std::unique_ptr<FileIo> createIocpFileIo(unsigned queueDepth);
+#endif
+
+} // namespace OpenIDM
+
+#endif // OPENIDM_FILEIO_H
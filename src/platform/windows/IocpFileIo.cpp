@@ -0,0 +1,179 @@
+/**
+ * @file IocpFileIo.cpp
+ * @brief I/O completion port file I/O backend (Windows)
+ *
+ * Overlapped WriteFile()/ReadFile() start immediately; submit() is a no-op
+ * and wait() drains the port with GetQueuedCompletionStatusEx(). Handles
+ * that cannot join the port (not opened FILE_FLAG_OVERLAPPED) are served
+ * synchronously and reported as immediate completions.
+ *
+ * @copyright Copyright (c) 2024 OpenIDM Project
+ * @license GPL-3.0-or-later
+ */
+
+#include "platform/FileIo.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+#include <windows.h>
+
+namespace OpenIDM {
+
+namespace {
+
+class IocpFileIo : public FileIo {
+public:
+    ~IocpFileIo() override {
+        // Buffers belong to the caller; never leave the kernel writing into them
+        std::vector<Completion> discarded;
+        while (m_inFlight > 0 && wait(discarded, m_inFlight) > 0) {
+            discarded.clear();
+        }
+        if (m_port) {
+            CloseHandle(m_port);
+        }
+    }
+
+    bool init(unsigned queueDepth) {
+        m_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        if (!m_port) {
+            qDebug() << "FileIo: CreateIoCompletionPort failed:" << GetLastError();
+            return false;
+        }
+        m_depth = queueDepth;
+        return true;
+    }
+
+    const char* name() const override { return "iocp"; }
+
+    bool queueWrite(qintptr handle, ByteOffset offset,
+                    const char* data, size_t length, void* tag) override {
+        return start(handle, offset, const_cast<char*>(data), length, tag, true);
+    }
+
+    bool queueRead(qintptr handle, ByteOffset offset,
+                   char* data, size_t length, void* tag) override {
+        return start(handle, offset, data, length, tag, false);
+    }
+
+    void submit() override {}
+
+    size_t wait(std::vector<Completion>& completions, size_t minimum) override {
+        size_t reaped = m_immediate.size();
+        completions.insert(completions.end(), m_immediate.begin(), m_immediate.end());
+        m_immediate.clear();
+
+        OVERLAPPED_ENTRY entries[16];
+        while (m_inFlight > 0) {
+            DWORD timeout = reaped < minimum ? INFINITE : 0;
+            ULONG count = 0;
+            if (!GetQueuedCompletionStatusEx(m_port, entries, 16, &count, timeout, FALSE)) {
+                break;  // WAIT_TIMEOUT: nothing more ready
+            }
+
+            for (ULONG i = 0; i < count; ++i) {
+                auto* op = CONTAINING_RECORD(entries[i].lpOverlapped, Operation, overlapped);
+                // Already complete; this only translates the status to a Win32 error
+                DWORD transferred = 0;
+                int64_t result;
+                if (GetOverlappedResult(op->handle, &op->overlapped, &transferred, FALSE)) {
+                    result = transferred;
+                } else {
+                    DWORD error = GetLastError();
+                    result = error == ERROR_HANDLE_EOF ? 0 : -static_cast<int64_t>(error);
+                }
+                completions.push_back({op->tag, result});
+                delete op;
+                --m_inFlight;
+                ++reaped;
+            }
+        }
+        return reaped;
+    }
+
+    size_t pending() const override { return m_inFlight + m_immediate.size(); }
+
+private:
+    struct Operation {
+        OVERLAPPED overlapped{};
+        HANDLE handle{nullptr};
+        void* tag{nullptr};
+    };
+
+    bool start(qintptr rawHandle, ByteOffset offset, char* data, size_t length, void* tag, bool write) {
+        if (pending() >= m_depth) {
+            return false;
+        }
+
+        HANDLE handle = reinterpret_cast<HANDLE>(rawHandle);
+        if (!associate(handle)) {
+            m_immediate.push_back({tag, runSynchronously(handle, offset, data, length, write)});
+            return true;
+        }
+
+        auto* op = new Operation;
+        op->overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        op->overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        op->handle = handle;
+        op->tag = tag;
+
+        // Buffers are at most a few MB; DWORD length is sufficient
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(length, 0x7FFFFFFF));
+        BOOL ok = write ? WriteFile(handle, data, chunk, nullptr, &op->overlapped)
+                        : ReadFile(handle, data, chunk, nullptr, &op->overlapped);
+        DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+        if (!ok && error != ERROR_IO_PENDING) {
+            // Nothing was queued to the port
+            delete op;
+            m_immediate.push_back({tag, (!write && error == ERROR_HANDLE_EOF) ? 0 : -static_cast<int64_t>(error)});
+            return true;
+        }
+
+        // Synchronous success still posts a completion packet
+        ++m_inFlight;
+        return true;
+    }
+
+    bool associate(HANDLE handle) {
+        if (CreateIoCompletionPort(handle, m_port, 0, 0)) {
+            return true;
+        }
+        // Already bound: a handle is only ever used by one FileIo instance
+        return GetLastError() == ERROR_INVALID_PARAMETER;
+    }
+
+    static int64_t runSynchronously(HANDLE handle, ByteOffset offset, char* data, size_t length, bool write) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(length, 0x7FFFFFFF));
+        DWORD transferred = 0;
+        BOOL ok = write ? WriteFile(handle, data, chunk, &transferred, &overlapped)
+                        : ReadFile(handle, data, chunk, &transferred, &overlapped);
+        if (!ok) {
+            DWORD error = GetLastError();
+            return (!write && error == ERROR_HANDLE_EOF) ? 0 : -static_cast<int64_t>(error);
+        }
+        return transferred;
+    }
+
+    HANDLE m_port{nullptr};
+    unsigned m_depth{0};
+    size_t m_inFlight{0};                   ///< Started, packet not yet reaped
+    std::vector<Completion> m_immediate;    ///< Finished without the port
+};
+
+} // namespace
+
+std::unique_ptr<FileIo> createIocpFileIo(unsigned queueDepth) {
+    auto io = std::make_unique<IocpFileIo>();
+    if (!io->init(queueDepth)) {
+        return nullptr;
+    }
+    return io;
+}
+
+} // namespace OpenIDM
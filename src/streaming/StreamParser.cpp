@@ -3,231 +3,302 @@
  * @brief Parser for HLS/M3U8 and other streaming formats
  */
 
-#include <QString>
+#include "openidm/integration/StreamParser.h"
+
 #include <QStringList>
-#include <QUrl>
 #include <QRegularExpression>
-#include <vector>
+
+#include <algorithm>
 
 namespace OpenIDM {
 
-/**
- * @brief Represents a segment in an HLS stream
- */
-struct HlsSegment {
-    QString url;
-    double duration;
-    QString title;
-    int sequenceNumber;
-    bool isDiscontinuity;
-};
+namespace {
 
-/**
- * @brief Represents an HLS variant stream
- */
-struct HlsVariant {
-    QString url;
-    int bandwidth;
-    QString resolution;
-    QString codecs;
-    QString audio;
-    QString subtitles;
-};
+/// @return Value of a playlist tag attribute, without quotes; empty if absent
+QString attributeValue(const QString& line, const QString& name) {
+    QRegularExpression regex(QStringLiteral("(?:^|[:,])%1=(\"([^\"]*)\"|[^,]*)")
+                                 .arg(QRegularExpression::escape(name)));
+    auto match = regex.match(line);
+    if (!match.hasMatch()) {
+        return QString();
+    }
+    return match.capturedStart(2) >= 0 ? match.captured(2) : match.captured(1).trimmed();
+}
 
-/**
- * @brief Parsed HLS playlist
- */
-struct HlsPlaylist {
-    bool isMaster;
-    int targetDuration;
-    int mediaSequence;
-    bool isEndList;
-    std::vector<HlsVariant> variants;
-    std::vector<HlsSegment> segments;
-};
+/// Parse "<length>[@<offset>]"; without an offset the range follows @p next
+void parseByteRange(const QString& value, qint64& next, qint64& start, qint64& length) {
+    int at = value.indexOf('@');
+    length = value.left(at).toLongLong();
+    start = at >= 0 ? value.mid(at + 1).toLongLong() : next;
+    next = start + length;
+}
 
-/**
- * @class StreamParser
- * @brief Parses HLS/M3U8 playlists
- */
-class StreamParser {
-public:
-    /**
-     * @brief Check if content is an M3U8 playlist
-     * @param content Content to check
-     * @return True if content is M3U8
-     */
-    static bool isM3U8(const QString& content) {
-        return content.trimmed().startsWith(QStringLiteral("#EXTM3U"));
+/// IV attribute "0x..." as 16 bytes; empty if malformed
+QByteArray parseIv(const QString& value) {
+    QString hex = value.mid(2);
+    if (!value.startsWith(QStringLiteral("0x"), Qt::CaseInsensitive) || hex.size() > 32) {
+        return QByteArray();
+    }
+    QByteArray iv = QByteArray::fromHex(hex.rightJustified(32, '0').toLatin1());
+    return iv.size() == 16 ? iv : QByteArray();
+}
+
+/// Default IV: the media sequence number as a 128-bit big-endian integer
+QByteArray sequenceIv(qint64 sequence) {
+    QByteArray iv(16, '\0');
+    for (int i = 0; i < 8; ++i) {
+        iv[15 - i] = static_cast<char>((sequence >> (8 * i)) & 0xff);
     }
+    return iv;
+}
+
+} // namespace
+
+bool StreamParser::isM3U8(const QString& content) {
+    return content.trimmed().startsWith(QStringLiteral("#EXTM3U"));
+}
+
+HlsPlaylist StreamParser::parseM3U8(const QString& content, const QUrl& baseUrl) {
+    HlsPlaylist playlist;
+    playlist.isMaster = false;
+    playlist.targetDuration = 0;
+    playlist.mediaSequence = 0;
+    playlist.isEndList = false;
     
-    /**
-     * @brief Parse an M3U8 playlist
-     * @param content Playlist content
-     * @param baseUrl Base URL for resolving relative URLs
-     * @return Parsed playlist structure
-     */
-    static HlsPlaylist parseM3U8(const QString& content, const QUrl& baseUrl) {
-        HlsPlaylist playlist;
-        playlist.isMaster = false;
-        playlist.targetDuration = 0;
-        playlist.mediaSequence = 0;
-        playlist.isEndList = false;
-        
-        QStringList lines = content.split(QRegularExpression(QStringLiteral("[\r\n]+")));
+    QStringList lines = content.split(QRegularExpression(QStringLiteral("[\r\n]+")));
+    
+    double currentDuration = 0;
+    QString currentTitle;
+    bool expectSegment = false;
+    bool discontinuity = false;
+    int sequenceNumber = 0;
+    
+    // Encryption and sub-ranges carry over to the following segments
+    QString keyUrl;
+    QByteArray keyIv;
+    qint64 rangeStart = -1;
+    qint64 rangeLength = 0;
+    qint64 nextRangeStart = 0;
+    
+    for (const QString& line : lines) {
+        QString trimmed = line.trimmed();
         
-        double currentDuration = 0;
-        QString currentTitle;
-        bool expectSegment = false;
-        int sequenceNumber = 0;
+        if (trimmed.isEmpty() || trimmed == QStringLiteral("#EXTM3U")) {
+            continue;
+        }
         
-        for (const QString& line : lines) {
-            QString trimmed = line.trimmed();
+        // Master playlist variant
+        if (trimmed.startsWith(QStringLiteral("#EXT-X-STREAM-INF:"))) {
+            playlist.isMaster = true;
             
-            if (trimmed.isEmpty() || trimmed == QStringLiteral("#EXTM3U")) {
-                continue;
-            }
+            HlsVariant variant{};
             
-            // Master playlist variant
-            if (trimmed.startsWith(QStringLiteral("#EXT-X-STREAM-INF:"))) {
-                playlist.isMaster = true;
-                
-                HlsVariant variant;
-                
-                // Parse attributes
-                static QRegularExpression bandwidthRegex(QStringLiteral("BANDWIDTH=(\\d+)"));
-                static QRegularExpression resolutionRegex(QStringLiteral("RESOLUTION=([\\dx]+)"));
-                static QRegularExpression codecsRegex(QStringLiteral("CODECS=\"([^\"]+)\""));
-                
-                auto match = bandwidthRegex.match(trimmed);
-                if (match.hasMatch()) {
-                    variant.bandwidth = match.captured(1).toInt();
-                }
-                
-                match = resolutionRegex.match(trimmed);
-                if (match.hasMatch()) {
-                    variant.resolution = match.captured(1);
-                }
-                
-                match = codecsRegex.match(trimmed);
-                if (match.hasMatch()) {
-                    variant.codecs = match.captured(1);
-                }
-                
-                playlist.variants.push_back(variant);
-                continue;
-            }
+            // Parse attributes
+            static QRegularExpression bandwidthRegex(QStringLiteral("BANDWIDTH=(\\d+)"));
+            static QRegularExpression resolutionRegex(QStringLiteral("RESOLUTION=([\\dx]+)"));
+            static QRegularExpression codecsRegex(QStringLiteral("CODECS=\"([^\"]+)\""));
             
-            // Target duration
-            if (trimmed.startsWith(QStringLiteral("#EXT-X-TARGETDURATION:"))) {
-                playlist.targetDuration = trimmed.mid(22).toInt();
-                continue;
+            auto match = bandwidthRegex.match(trimmed);
+            if (match.hasMatch()) {
+                variant.bandwidth = match.captured(1).toInt();
             }
             
-            // Media sequence
-            if (trimmed.startsWith(QStringLiteral("#EXT-X-MEDIA-SEQUENCE:"))) {
-                playlist.mediaSequence = trimmed.mid(22).toInt();
-                sequenceNumber = playlist.mediaSequence;
-                continue;
+            match = resolutionRegex.match(trimmed);
+            if (match.hasMatch()) {
+                variant.resolution = match.captured(1);
             }
             
-            // End list marker
-            if (trimmed == QStringLiteral("#EXT-X-ENDLIST")) {
-                playlist.isEndList = true;
-                continue;
+            match = codecsRegex.match(trimmed);
+            if (match.hasMatch()) {
+                variant.codecs = match.captured(1);
             }
             
-            // Segment info
-            if (trimmed.startsWith(QStringLiteral("#EXTINF:"))) {
-                QString info = trimmed.mid(8);
-                int commaPos = info.indexOf(',');
-                if (commaPos > 0) {
-                    currentDuration = info.left(commaPos).toDouble();
-                    currentTitle = info.mid(commaPos + 1).trimmed();
-                } else {
-                    currentDuration = info.toDouble();
-                }
-                expectSegment = true;
-                continue;
+            playlist.variants.push_back(variant);
+            continue;
+        }
+        
+        // Target duration
+        if (trimmed.startsWith(QStringLiteral("#EXT-X-TARGETDURATION:"))) {
+            playlist.targetDuration = trimmed.mid(22).toInt();
+            continue;
+        }
+        
+        // Media sequence
+        if (trimmed.startsWith(QStringLiteral("#EXT-X-MEDIA-SEQUENCE:"))) {
+            playlist.mediaSequence = trimmed.mid(22).toInt();
+            sequenceNumber = playlist.mediaSequence;
+            continue;
+        }
+        
+        // End list marker
+        if (trimmed == QStringLiteral("#EXT-X-ENDLIST")) {
+            playlist.isEndList = true;
+            continue;
+        }
+        
+        // Encryption of the following segments
+        if (trimmed.startsWith(QStringLiteral("#EXT-X-KEY:"))) {
+            QString method = attributeValue(trimmed, QStringLiteral("METHOD"));
+            if (method == QStringLiteral("NONE")) {
+                keyUrl.clear();
+                keyIv.clear();
+            } else if (method == QStringLiteral("AES-128")) {
+                keyUrl = resolveUrl(attributeValue(trimmed, QStringLiteral("URI")), baseUrl);
+                keyIv = parseIv(attributeValue(trimmed, QStringLiteral("IV")));
+            } else {
+                playlist.unsupportedKey = true;
             }
-            
-            // Discontinuity marker
-            if (trimmed == QStringLiteral("#EXT-X-DISCONTINUITY")) {
-                continue;
+            continue;
+        }
+        
+        // Media initialization section (fMP4)
+        if (trimmed.startsWith(QStringLiteral("#EXT-X-MAP:"))) {
+            playlist.initSection = HlsSegment{};
+            playlist.initSection.url = resolveUrl(attributeValue(trimmed, QStringLiteral("URI")), baseUrl);
+            playlist.initSection.sequenceNumber = sequenceNumber;
+            playlist.initSection.isDiscontinuity = false;
+            playlist.initSection.duration = 0;
+            playlist.initSection.keyUrl = keyUrl;
+            playlist.initSection.keyIv = keyIv;
+            QString range = attributeValue(trimmed, QStringLiteral("BYTERANGE"));
+            if (!range.isEmpty()) {
+                qint64 next = 0;
+                parseByteRange(range, next, playlist.initSection.byteRangeStart,
+                               playlist.initSection.byteRangeLength);
             }
+            continue;
+        }
+        
+        // Sub-range of the next segment's resource
+        if (trimmed.startsWith(QStringLiteral("#EXT-X-BYTERANGE:"))) {
+            parseByteRange(trimmed.mid(17), nextRangeStart, rangeStart, rangeLength);
+            continue;
+        }
+        
+        // Segment info
+        if (trimmed.startsWith(QStringLiteral("#EXTINF:"))) {
+            QString info = trimmed.mid(8);
+            int commaPos = info.indexOf(',');
+            if (commaPos > 0) {
+                currentDuration = info.left(commaPos).toDouble();
+                currentTitle = info.mid(commaPos + 1).trimmed();
+            } else {
+                currentDuration = info.toDouble();
+            }
+            expectSegment = true;
+            continue;
+        }
+        
+        // Discontinuity marker
+        if (trimmed == QStringLiteral("#EXT-X-DISCONTINUITY")) {
+            discontinuity = true;
+            continue;
+        }
+        
+        // URL line (segment or variant)
+        if (!trimmed.startsWith('#')) {
+            QString resolvedUrl = resolveUrl(trimmed, baseUrl);
             
-            // URL line (segment or variant)
-            if (!trimmed.startsWith('#')) {
-                QString resolvedUrl = resolveUrl(trimmed, baseUrl);
+            if (playlist.isMaster && !playlist.variants.empty()) {
+                // This is a variant URL
+                playlist.variants.back().url = resolvedUrl;
+            } else if (expectSegment) {
+                // This is a segment URL
+                HlsSegment segment;
+                segment.url = resolvedUrl;
+                segment.duration = currentDuration;
+                segment.title = currentTitle;
+                segment.sequenceNumber = sequenceNumber++;
+                segment.isDiscontinuity = discontinuity;
+                segment.byteRangeStart = rangeStart;
+                segment.byteRangeLength = rangeLength;
+                segment.keyUrl = keyUrl;
+                segment.keyIv = keyIv;
                 
-                if (playlist.isMaster && !playlist.variants.empty()) {
-                    // This is a variant URL
-                    playlist.variants.back().url = resolvedUrl;
-                } else if (expectSegment) {
-                    // This is a segment URL
-                    HlsSegment segment;
-                    segment.url = resolvedUrl;
-                    segment.duration = currentDuration;
-                    segment.title = currentTitle;
-                    segment.sequenceNumber = sequenceNumber++;
-                    segment.isDiscontinuity = false;
-                    
-                    playlist.segments.push_back(segment);
-                    expectSegment = false;
-                }
+                playlist.segments.push_back(segment);
+                expectSegment = false;
+                discontinuity = false;
+                rangeStart = -1;
+                rangeLength = 0;
             }
         }
-        
-        return playlist;
     }
     
-    /**
-     * @brief Get total duration of all segments
-     * @param playlist Parsed playlist
-     * @return Total duration in seconds
-     */
-    static double totalDuration(const HlsPlaylist& playlist) {
-        double total = 0;
-        for (const auto& segment : playlist.segments) {
-            total += segment.duration;
-        }
-        return total;
+    return playlist;
+}
+
+FragmentList StreamParser::fragments(const HlsPlaylist& playlist) {
+    FragmentList list;
+    
+    // A live playlist keeps growing; yt-dlp follows those
+    if (playlist.isMaster || !playlist.isEndList || playlist.unsupportedKey) {
+        return list;
     }
     
-    /**
-     * @brief Get best quality variant
-     * @param playlist Master playlist
-     * @return Variant with highest bandwidth
-     */
-    static const HlsVariant* bestVariant(const HlsPlaylist& playlist) {
-        if (playlist.variants.empty()) {
-            return nullptr;
+    auto keyIndex = [&list](const QString& url) {
+        if (url.isEmpty()) {
+            return -1;
         }
-        
-        const HlsVariant* best = &playlist.variants[0];
-        for (const auto& variant : playlist.variants) {
-            if (variant.bandwidth > best->bandwidth) {
-                best = &variant;
-            }
+        QUrl key(url);
+        auto it = std::find(list.keys.begin(), list.keys.end(), key);
+        if (it == list.keys.end()) {
+            list.keys.push_back(key);
+            return static_cast<int>(list.keys.size() - 1);
         }
-        return best;
+        return static_cast<int>(it - list.keys.begin());
+    };
+    
+    auto append = [&](const HlsSegment& segment) {
+        StreamFragment fragment;
+        fragment.url = QUrl(segment.url);
+        fragment.rangeStart = segment.byteRangeStart;
+        fragment.rangeLength = segment.byteRangeLength;
+        fragment.key = keyIndex(segment.keyUrl);
+        if (fragment.key >= 0) {
+            fragment.iv = segment.keyIv.isEmpty() ? sequenceIv(segment.sequenceNumber) : segment.keyIv;
+        }
+        list.fragments.push_back(std::move(fragment));
+    };
+    
+    if (!playlist.initSection.url.isEmpty()) {
+        append(playlist.initSection);
+    }
+    for (const auto& segment : playlist.segments) {
+        append(segment);
     }
     
-private:
-    /**
-     * @brief Resolve a potentially relative URL
-     * @param url URL to resolve
-     * @param baseUrl Base URL for resolution
-     * @return Absolute URL
-     */
-    static QString resolveUrl(const QString& url, const QUrl& baseUrl) {
-        if (url.startsWith(QStringLiteral("http://")) || 
-            url.startsWith(QStringLiteral("https://"))) {
-            return url;
+    return list;
+}
+
+double StreamParser::totalDuration(const HlsPlaylist& playlist) {
+    double total = 0;
+    for (const auto& segment : playlist.segments) {
+        total += segment.duration;
+    }
+    return total;
+}
+
+const HlsVariant* StreamParser::bestVariant(const HlsPlaylist& playlist) {
+    if (playlist.variants.empty()) {
+        return nullptr;
+    }
+    
+    const HlsVariant* best = &playlist.variants[0];
+    for (const auto& variant : playlist.variants) {
+        if (variant.bandwidth > best->bandwidth) {
+            best = &variant;
         }
-        
-        return baseUrl.resolved(QUrl(url)).toString();
     }
-};
+    return best;
+}
+
+QString StreamParser::resolveUrl(const QString& url, const QUrl& baseUrl) {
+    if (url.startsWith(QStringLiteral("http://")) || 
+        url.startsWith(QStringLiteral("https://"))) {
+        return url;
+    }
+    
+    return baseUrl.resolved(QUrl(url)).toString();
+}
 
 } // namespace OpenIDM
@@ -7,13 +7,10 @@
  */
 
 #include "StreamingResolver.h"
+#include "openidm/integration/YtDlpResolver.h"
 
 #include <QDebug>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QStandardPaths>
-#include <QFileInfo>
-#include <QRegularExpression>
+#include <QJsonArray>
 
 namespace OpenIDM {
 
@@ -24,14 +21,24 @@ namespace OpenIDM {
 StreamingResolver::StreamingResolver(QObject* parent)
     : QObject(parent)
 {
-    // Try to find yt-dlp
-    m_ytdlpPath = findYtDlp();
+    YtDlpResolver& resolver = YtDlpResolver::instance();
 
-    if (!m_ytdlpPath.isEmpty()) {
-        qDebug() << "StreamingResolver: Found yt-dlp at" << m_ytdlpPath;
-    } else {
-        qDebug() << "StreamingResolver: yt-dlp not found";
-    }
+    connect(&resolver, &YtDlpResolver::resolved, this, [this](quint64 id, const QJsonObject& obj) {
+        if (id == m_requestId) {
+            m_requestId = 0;
+            parseOutput(obj);
+        }
+    });
+    connect(&resolver, &YtDlpResolver::failed, this, [this](quint64 id, const QString& message) {
+        if (id == m_requestId) {
+            m_requestId = 0;
+            qWarning() << "StreamingResolver: yt-dlp failed:" << message;
+            emit error(message.isEmpty() ? "Failed to resolve URL" : message);
+        }
+    });
+
+    // Searched in the background instead of blocking on `which` here
+    resolver.locate();
 }
 
 StreamingResolver::~StreamingResolver()
@@ -45,7 +52,12 @@ StreamingResolver::~StreamingResolver()
 
 void StreamingResolver::setYtDlpPath(const QString& path)
 {
-    m_ytdlpPath = path;
+    YtDlpResolver::instance().setYtDlpPath(path);
+}
+
+QString StreamingResolver::ytDlpPath() const
+{
+    return YtDlpResolver::instance().ytDlpPath();
 }
 
 void StreamingResolver::setPreferredFormat(const QString& format)
@@ -64,28 +76,12 @@ void StreamingResolver::setPreferredQuality(const QString& quality)
 
 bool StreamingResolver::isAvailable() const
 {
-    if (m_ytdlpPath.isEmpty()) {
-        return false;
-    }
-
-    QFileInfo info(m_ytdlpPath);
-    return info.exists() && info.isExecutable();
+    return YtDlpResolver::instance().isAvailable();
 }
 
 QString StreamingResolver::version() const
 {
-    if (!isAvailable()) {
-        return QString();
-    }
-
-    QProcess process;
-    process.start(m_ytdlpPath, {"--version"});
-
-    if (process.waitForFinished(5000)) {
-        return QString::fromUtf8(process.readAllStandardOutput()).trimmed();
-    }
-
-    return QString();
+    return YtDlpResolver::instance().version();
 }
 
 bool StreamingResolver::isSupportedUrl(const QUrl& url) const
@@ -122,193 +118,38 @@ bool StreamingResolver::isSupportedUrl(const QUrl& url) const
 
 void StreamingResolver::resolve(const QUrl& url)
 {
-    if (!isAvailable()) {
-        emit error("yt-dlp is not available");
-        return;
-    }
-
     // Cancel any existing resolution
     cancel();
 
     m_currentUrl = url;
-    m_outputBuffer.clear();
-
-    // Create process
-    m_process = new QProcess(this);
-
-    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, &StreamingResolver::onProcessFinished);
-    connect(m_process, &QProcess::errorOccurred,
-            this, &StreamingResolver::onProcessError);
-    connect(m_process, &QProcess::readyReadStandardOutput,
-            this, &StreamingResolver::onProcessReadyRead);
-
-    // Build arguments
-    QStringList args;
-    args << "--no-playlist";      // Single video only
-    args << "--no-warnings";      // Suppress warnings
-    args << "-j";                 // JSON output
-
-    // Format selection
-    if (!m_preferredFormat.isEmpty()) {
-        args << "-f" << m_preferredFormat;
-    }
-
-    args << url.toString();
 
-    qDebug() << "StreamingResolver: Starting yt-dlp with args:" << args;
+    qDebug() << "StreamingResolver: Resolving" << url.toString() << "format" << m_preferredFormat;
 
     emit progress("Resolving URL...");
 
-    m_process->start(m_ytdlpPath, args);
+    // Fails through error() if yt-dlp turns out not to be installed
+    m_requestId = YtDlpResolver::instance().resolve(url, m_preferredFormat);
 }
 
 void StreamingResolver::cancel()
 {
-    if (m_process) {
-        m_process->disconnect();
-
-        if (m_process->state() != QProcess::NotRunning) {
-            m_process->kill();
-            m_process->waitForFinished(3000);
-        }
-
-        m_process->deleteLater();
-        m_process = nullptr;
-    }
-
-    m_outputBuffer.clear();
-}
-
-// ═══════════════════════════════════════════════════════════════════════════════
-// Private Slots
-// ═══════════════════════════════════════════════════════════════════════════════
-
-void StreamingResolver::onProcessFinished(int exitCode, QProcess::ExitStatus status)
-{
-    if (status != QProcess::NormalExit || exitCode != 0) {
-        QString errorOutput = QString::fromUtf8(m_process->readAllStandardError());
-        qWarning() << "StreamingResolver: yt-dlp failed:" << errorOutput;
-        emit error(errorOutput.isEmpty() ? "Failed to resolve URL" : errorOutput);
-    } else {
-        parseOutput(m_outputBuffer);
+    if (m_requestId != 0) {
+        YtDlpResolver::instance().cancel(m_requestId);
+        m_requestId = 0;
     }
-
-    m_process->deleteLater();
-    m_process = nullptr;
-}
-
-void StreamingResolver::onProcessError(QProcess::ProcessError processError)
-{
-    QString errorMsg;
-
-    switch (processError) {
-        case QProcess::FailedToStart:
-            errorMsg = "Failed to start yt-dlp";
-            break;
-        case QProcess::Crashed:
-            errorMsg = "yt-dlp crashed";
-            break;
-        case QProcess::Timedout:
-            errorMsg = "yt-dlp timed out";
-            break;
-        default:
-            errorMsg = "yt-dlp error";
-            break;
-    }
-
-    qWarning() << "StreamingResolver:" << errorMsg;
-    emit error(errorMsg);
-
-    m_process->deleteLater();
-    m_process = nullptr;
-}
-
-void StreamingResolver::onProcessReadyRead()
-{
-    m_outputBuffer.append(m_process->readAllStandardOutput());
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
 // Private Helpers
 // ═══════════════════════════════════════════════════════════════════════════════
 
-QString StreamingResolver::findYtDlp() const
-{
-    // Check common locations
-    QStringList searchPaths;
-
-#ifdef Q_OS_WIN
-    searchPaths << "yt-dlp.exe";
-    searchPaths << "yt-dlp";
-
-    // Check in PATH
-    QString pathEnv = qEnvironmentVariable("PATH");
-    for (const auto& dir : pathEnv.split(';')) {
-        searchPaths << dir + "/yt-dlp.exe";
-        searchPaths << dir + "/yt-dlp";
-    }
-
-    // Common Windows locations
-    searchPaths << QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/yt-dlp.exe";
-#else
-    searchPaths << "yt-dlp";
-
-    // Check in PATH
-    QString pathEnv = qEnvironmentVariable("PATH");
-    for (const auto& dir : pathEnv.split(':')) {
-        searchPaths << dir + "/yt-dlp";
-    }
-
-    // Common Unix locations
-    searchPaths << "/usr/local/bin/yt-dlp";
-    searchPaths << "/usr/bin/yt-dlp";
-    searchPaths << QDir::homePath() + "/.local/bin/yt-dlp";
-#endif
-
-    for (const auto& path : searchPaths) {
-        QFileInfo info(path);
-        if (info.exists() && info.isExecutable()) {
-            return info.absoluteFilePath();
-        }
-    }
-
-    // Try to find via which/where
-    QProcess which;
-#ifdef Q_OS_WIN
-    which.start("where", {"yt-dlp"});
-#else
-    which.start("which", {"yt-dlp"});
-#endif
-
-    if (which.waitForFinished(3000) && which.exitCode() == 0) {
-        QString result = QString::fromUtf8(which.readAllStandardOutput()).trimmed();
-        if (!result.isEmpty()) {
-            return result.split('\n').first();
-        }
-    }
-
-    return QString();
-}
-
-void StreamingResolver::parseOutput(const QByteArray& output)
+void StreamingResolver::parseOutput(const QJsonObject& obj)
 {
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(output, &parseError);
-
-    if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "StreamingResolver: JSON parse error:" << parseError.errorString();
-        emit error("Failed to parse yt-dlp output");
-        return;
-    }
-
-    if (!doc.isObject()) {
+    if (obj.isEmpty()) {
         emit error("Invalid yt-dlp output format");
         return;
     }
 
-    QJsonObject obj = doc.object();
-
     // Extract information
     StreamInfo info;
     info.url = QUrl(obj["url"].toString());
@@ -3,7 +3,8 @@
  * @brief URL resolver for streaming services
  *
  * Wraps yt-dlp to resolve streaming URLs from YouTube, Vimeo, etc.
- * into direct download URLs.
+ * into direct download URLs. Extraction runs on the shared YtDlpResolver,
+ * so resolutions reuse its warm helper process and result cache.
  *
  * @copyright Copyright (c) 2024 OpenIDM Project
  * @license GPL-3.0-or-later
@@ -12,11 +13,9 @@
 #ifndef OPENIDM_STREAMINGRESOLVER_H
 #define OPENIDM_STREAMINGRESOLVER_H
 
+#include <QJsonObject>
 #include <QObject>
 #include <QUrl>
-#include <QProcess>
-
-#include <memory>
 
 namespace OpenIDM {
 
@@ -60,7 +59,7 @@ public:
     /**
      * @brief Get current yt-dlp path
      */
-    [[nodiscard]] QString ytDlpPath() const { return m_ytdlpPath; }
+    [[nodiscard]] QString ytDlpPath() const;
 
     /**
      * @brief Set preferred format (e.g., "best", "bestvideo+bestaudio")
@@ -94,7 +93,7 @@ public:
     /**
      * @brief Check if resolution is in progress
      */
-    [[nodiscard]] bool isResolving() const { return m_process != nullptr; }
+    [[nodiscard]] bool isResolving() const { return m_requestId != 0; }
 
     // ═══════════════════════════════════════════════════════════════════════════
     // Resolution
@@ -133,22 +132,14 @@ signals:
      */
     void progress(const QString& status);
 
-private slots:
-    void onProcessFinished(int exitCode, QProcess::ExitStatus status);
-    void onProcessError(QProcess::ProcessError error);
-    void onProcessReadyRead();
-
 private:
-    QString findYtDlp() const;
-    void parseOutput(const QByteArray& output);
+    void parseOutput(const QJsonObject& obj);
 
-    QString m_ytdlpPath;
     QString m_preferredFormat = "best";
     QString m_preferredQuality = "best";
 
-    QProcess* m_process = nullptr;
+    quint64 m_requestId = 0;     ///< Pending YtDlpResolver request, 0 = none
     QUrl m_currentUrl;
-    QByteArray m_outputBuffer;
 };
 
 } // namespace OpenIDM
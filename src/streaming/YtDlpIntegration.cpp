@@ -10,14 +10,13 @@
  */
 
 #include "openidm/integration/YtDlpIntegration.h"
+#include "openidm/integration/YtDlpResolver.h"
 
 #include <QProcess>
 #include <QDebug>
-#include <QJsonDocument>
 #include <QJsonObject>
-#include <QJsonArray>
-#include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
 
 namespace OpenIDM {
 
@@ -28,6 +27,10 @@ namespace OpenIDM {
 YtDlpIntegration::YtDlpIntegration(QObject* parent)
     : QObject(parent)
     , m_process(new QProcess(this))
+    , m_fragments(new FragmentDownloader(this))
+    , m_parser(new YtDlpOutputParser(this))
+    , m_playlist(false)
+    , m_resolveId(0)
 {
     // Connect process signals
     connect(m_process, &QProcess::readyReadStandardOutput,
@@ -37,8 +40,40 @@ YtDlpIntegration::YtDlpIntegration(QObject* parent)
     connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &YtDlpIntegration::onProcessFinished);
     
-    // Find yt-dlp executable
-    m_ytdlpPath = findYtDlp();
+    // Native fragment downloads report through the same signals
+    connect(m_fragments, &FragmentDownloader::progress, this,
+            [this](int written, int total, ByteCount /*bytes*/, SpeedBps speed) {
+        emit progress(total > 0 ? 100.0 * written / total : 0.0, speed);
+    });
+    connect(m_fragments, &FragmentDownloader::finished, this, &YtDlpIntegration::finished);
+    connect(m_fragments, &FragmentDownloader::failed, this, [this](const DownloadError& failure) {
+        emit error(failure.message);
+    });
+    
+    connect(m_parser, &YtDlpOutputParser::entries, this, &YtDlpIntegration::playlistEntries);
+    connect(m_parser, &YtDlpOutputParser::finished, this, &YtDlpIntegration::playlistExtracted);
+    
+    // Info extraction goes through the shared warm resolver
+    YtDlpResolver& resolver = YtDlpResolver::instance();
+    connect(&resolver, &YtDlpResolver::availabilityChanged, this, &YtDlpIntegration::availabilityChanged);
+    connect(&resolver, &YtDlpResolver::resolved, this, [this](quint64 id, const QJsonObject& obj) {
+        if (id != m_resolveId) {
+            return;
+        }
+        m_resolveId = 0;
+        m_lastInfo = YtDlpOutputParser::videoInfo(obj, m_currentUrl.toString());
+        emit infoExtracted(m_lastInfo);
+    });
+    connect(&resolver, &YtDlpResolver::failed, this, [this](quint64 id, const QString& message) {
+        if (id != m_resolveId) {
+            return;
+        }
+        m_resolveId = 0;
+        emit error(message);
+    });
+    
+    // Look for yt-dlp off the GUI thread; no blocking `which` here
+    resolver.locate();
 }
 
 YtDlpIntegration::~YtDlpIntegration() {
@@ -49,19 +84,11 @@ YtDlpIntegration::~YtDlpIntegration() {
 }
 
 bool YtDlpIntegration::isAvailable() const {
-    return !m_ytdlpPath.isEmpty() && QFile::exists(m_ytdlpPath);
+    return YtDlpResolver::instance().isAvailable();
 }
 
 QString YtDlpIntegration::version() const {
-    if (!isAvailable()) {
-        return QString();
-    }
-    
-    QProcess process;
-    process.start(m_ytdlpPath, {QStringLiteral("--version")});
-    process.waitForFinished(5000);
-    
-    return QString::fromUtf8(process.readAllStandardOutput()).trimmed();
+    return YtDlpResolver::instance().version();
 }
 
 bool YtDlpIntegration::isSupportedUrl(const QUrl& url) const {
@@ -103,6 +130,19 @@ bool YtDlpIntegration::isSupportedUrl(const QUrl& url) const {
 }
 
 void YtDlpIntegration::extractInfo(const QUrl& url) {
+    if (m_resolveId != 0) {
+        emit error(QStringLiteral("Another extraction is in progress"));
+        return;
+    }
+    
+    // An unlocated resolver finds yt-dlp first and fails the request if absent
+    m_currentUrl = url;
+    
+    qDebug() << "YtDlpIntegration: Extracting info for" << url.toString();
+    m_resolveId = YtDlpResolver::instance().resolve(url);
+}
+
+void YtDlpIntegration::extractPlaylist(const QUrl& url, bool flat) {
     if (!isAvailable()) {
         emit error(QStringLiteral("yt-dlp is not installed or not found in PATH"));
         return;
@@ -114,22 +154,40 @@ void YtDlpIntegration::extractInfo(const QUrl& url) {
     }
     
     m_currentUrl = url;
+    m_playlist = true;
     m_outputBuffer.clear();
     m_errorBuffer.clear();
+    m_parser->start();
     
     QStringList args = {
-        QStringLiteral("--dump-json"),
-        QStringLiteral("--no-playlist"),
-        QStringLiteral("--no-download"),
-        url.toString()
+        QStringLiteral("-j"),
+        QStringLiteral("--yes-playlist"),
+        QStringLiteral("--no-warnings"),
     };
+    if (flat) {
+        args << QStringLiteral("--flat-playlist");
+    }
+    args << url.toString();
     
-    qDebug() << "YtDlpIntegration: Extracting info for" << url.toString();
-    m_process->start(m_ytdlpPath, args);
+    qDebug() << "YtDlpIntegration: Extracting playlist" << url.toString();
+    m_process->start(YtDlpResolver::instance().ytDlpPath(), args);
 }
 
 void YtDlpIntegration::download(const QUrl& url, const QString& outputPath, 
                                  const QString& format) {
+    if (m_fragments->isRunning()) {
+        emit error(QStringLiteral("Another download is in progress"));
+        return;
+    }
+    
+    // Segmented formats already resolved by extractInfo() need no yt-dlp run
+    if (const FormatInfo* native = nativeFormat(url, format)) {
+        if (startNative(*native, expandTemplate(outputPath, *native))) {
+            return;
+        }
+        qDebug() << "YtDlpIntegration: Native fragment download unavailable, using yt-dlp";
+    }
+    
     if (!isAvailable()) {
         emit error(QStringLiteral("yt-dlp is not installed or not found in PATH"));
         return;
@@ -141,6 +199,7 @@ void YtDlpIntegration::download(const QUrl& url, const QString& outputPath,
     }
     
     m_currentUrl = url;
+    m_playlist = false;
     m_outputBuffer.clear();
     m_errorBuffer.clear();
     
@@ -157,10 +216,17 @@ void YtDlpIntegration::download(const QUrl& url, const QString& outputPath,
     args << url.toString();
     
     qDebug() << "YtDlpIntegration: Starting download" << url.toString();
-    m_process->start(m_ytdlpPath, args);
+    m_process->start(YtDlpResolver::instance().ytDlpPath(), args);
 }
 
 void YtDlpIntegration::cancel() {
+    if (m_resolveId != 0) {
+        YtDlpResolver::instance().cancel(m_resolveId);
+        m_resolveId = 0;
+    }
+    m_fragments->cancel();
+    m_parser->cancel();
+    
     if (m_process->state() != QProcess::NotRunning) {
         m_process->terminate();
         if (!m_process->waitForFinished(3000)) {
@@ -171,27 +237,29 @@ void YtDlpIntegration::cancel() {
 
 void YtDlpIntegration::onProcessOutput() {
     QByteArray data = m_process->readAllStandardOutput();
-    m_outputBuffer.append(data);
     
-    // Parse progress updates
-    QString output = QString::fromUtf8(data);
+    // Playlist JSON is parsed on the parser's thread, never accumulated here
+    if (m_playlist) {
+        m_parser->feed(std::move(data));
+        return;
+    }
     
-    // Look for progress pattern: [download] XX.X% of ~XXX MiB at XXX MiB/s
-    static QRegularExpression progressRegex(
-        QStringLiteral("\\[download\\]\\s+(\\d+\\.?\\d*)%.*?at\\s+([\\d.]+)\\s*(\\w+)/s")
-    );
+    // Progress lines: [download] XX.X% of ~XXX MiB at XXX MiB/s
+    bool matched = false;
+    double percent = 0.0;
+    double speed = 0.0;
+    YtDlpOutputParser::forEachLine(m_outputBuffer, data, [&](QByteArrayView line) {
+        double linePercent = 0.0;
+        double lineSpeed = 0.0;
+        if (YtDlpOutputParser::parseProgress(line, linePercent, lineSpeed)) {
+            matched = true;
+            percent = linePercent;
+            speed = lineSpeed;
+        }
+    });
     
-    auto match = progressRegex.match(output);
-    if (match.hasMatch()) {
-        double percent = match.captured(1).toDouble();
-        double speed = match.captured(2).toDouble();
-        QString unit = match.captured(3);
-        
-        // Convert speed to bytes/sec
-        if (unit == QStringLiteral("KiB")) speed *= 1024;
-        else if (unit == QStringLiteral("MiB")) speed *= 1024 * 1024;
-        else if (unit == QStringLiteral("GiB")) speed *= 1024 * 1024 * 1024;
-        
+    // Only the latest of the lines read together is worth reporting
+    if (matched) {
         emit progress(percent, speed);
     }
 }
@@ -201,6 +269,19 @@ void YtDlpIntegration::onProcessError() {
 }
 
 void YtDlpIntegration::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus) {
+    if (m_playlist) {
+        m_playlist = false;
+        m_parser->feed(m_process->readAllStandardOutput());
+        
+        // Entries parsed so far are still delivered, then playlistExtracted()
+        if (exitStatus == QProcess::CrashExit || (exitCode != 0 && !m_errorBuffer.isEmpty())) {
+            emit error(exitStatus == QProcess::CrashExit ? QStringLiteral("yt-dlp process crashed")
+                                                         : QString::fromUtf8(m_errorBuffer));
+        }
+        m_parser->finish();
+        return;
+    }
+    
     if (exitStatus == QProcess::CrashExit) {
         emit error(QStringLiteral("yt-dlp process crashed"));
         return;
@@ -215,97 +296,68 @@ void YtDlpIntegration::onProcessFinished(int exitCode, QProcess::ExitStatus exit
         return;
     }
     
-    // Parse JSON output for info extraction
-    QString output = QString::fromUtf8(m_outputBuffer);
-    
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(m_outputBuffer, &parseError);
-    
-    if (parseError.error != QJsonParseError::NoError) {
-        // Not JSON, might be download output
-        emit finished(m_currentUrl.toString());
-        return;
+    emit finished(m_currentUrl.toString());
+}
+
+const FormatInfo* YtDlpIntegration::nativeFormat(const QUrl& url, const QString& format) const {
+    if (m_lastInfo.url != url.toString()) {
+        return nullptr;
     }
     
-    if (!doc.isObject()) {
-        emit error(QStringLiteral("Invalid JSON response from yt-dlp"));
-        return;
+    // "video+audio" needs a remux, which is yt-dlp's (ffmpeg's) job
+    QString formatId = format.isEmpty() ? m_lastInfo.bestFormat : format;
+    if (formatId.isEmpty() || formatId.contains(QLatin1Char('+'))) {
+        return nullptr;
     }
     
-    // Parse video info
-    QJsonObject obj = doc.object();
-    VideoInfo info;
-    info.url = m_currentUrl.toString();
-    info.title = obj.value(QStringLiteral("title")).toString();
-    info.description = obj.value(QStringLiteral("description")).toString();
-    info.duration = obj.value(QStringLiteral("duration")).toInt();
-    info.thumbnail = obj.value(QStringLiteral("thumbnail")).toString();
-    info.uploader = obj.value(QStringLiteral("uploader")).toString();
-    info.uploadDate = obj.value(QStringLiteral("upload_date")).toString();
-    
-    // Parse formats
-    QJsonArray formats = obj.value(QStringLiteral("formats")).toArray();
-    for (const QJsonValue& formatVal : formats) {
-        QJsonObject formatObj = formatVal.toObject();
-        
-        FormatInfo format;
-        format.formatId = formatObj.value(QStringLiteral("format_id")).toString();
-        format.ext = formatObj.value(QStringLiteral("ext")).toString();
-        format.resolution = formatObj.value(QStringLiteral("resolution")).toString();
-        format.filesize = formatObj.value(QStringLiteral("filesize")).toVariant().toLongLong();
-        format.vcodec = formatObj.value(QStringLiteral("vcodec")).toString();
-        format.acodec = formatObj.value(QStringLiteral("acodec")).toString();
-        format.tbr = formatObj.value(QStringLiteral("tbr")).toDouble();
-        format.note = formatObj.value(QStringLiteral("format_note")).toString();
-        
-        info.formats.append(format);
+    for (const FormatInfo& candidate : m_lastInfo.formats) {
+        if (candidate.formatId != formatId) {
+            continue;
+        }
+        bool hls = candidate.protocol.startsWith(QStringLiteral("m3u8")) && !candidate.url.isEmpty();
+        bool dash = candidate.protocol == QStringLiteral("http_dash_segments") &&
+                    candidate.fragments.isValid();
+        return hls || dash ? &candidate : nullptr;
     }
-    
-    // Best format
-    info.bestFormat = obj.value(QStringLiteral("format_id")).toString();
-    info.directUrl = obj.value(QStringLiteral("url")).toString();
-    
-    emit infoExtracted(info);
+    return nullptr;
 }
 
-QString YtDlpIntegration::findYtDlp() const {
-    // Check common locations
-    QStringList candidates = {
-        QStringLiteral("yt-dlp"),
-        QStringLiteral("yt-dlp.exe"),
-    };
+bool YtDlpIntegration::startNative(const FormatInfo& format, const QString& outputPath) {
+    QDir().mkpath(QFileInfo(outputPath).absolutePath());
+    m_fragments->setHeaders(format.httpHeaders);
     
-    // Check PATH first
-    QString found = QStandardPaths::findExecutable(QStringLiteral("yt-dlp"));
-    if (!found.isEmpty()) {
-        return found;
+    qDebug() << "YtDlpIntegration: Fetching" << format.protocol << "fragments natively to" << outputPath;
+    if (format.fragments.isValid()) {
+        return m_fragments->start(format.fragments, outputPath);
     }
-    
-    // Check common install locations
-#ifdef Q_OS_WIN
-    QStringList paths = {
-        QDir::homePath() + QStringLiteral("/AppData/Local/Programs/yt-dlp"),
-        QStringLiteral("C:/Program Files/yt-dlp"),
-        QStringLiteral("C:/yt-dlp"),
-    };
-#else
-    QStringList paths = {
-        QStringLiteral("/usr/local/bin"),
-        QStringLiteral("/usr/bin"),
-        QDir::homePath() + QStringLiteral("/.local/bin"),
-    };
-#endif
-    
-    for (const QString& path : paths) {
-        for (const QString& candidate : candidates) {
-            QString fullPath = path + QDir::separator() + candidate;
-            if (QFile::exists(fullPath)) {
-                return fullPath;
-            }
+    return m_fragments->startPlaylist(QUrl(format.url), outputPath);
+}
+
+QString YtDlpIntegration::expandTemplate(const QString& outputPath, const FormatInfo& format) const {
+    // The yt-dlp output template fields we know without running it
+    static QRegularExpression fieldRegex(QStringLiteral("%\\((\\w+)\\)s"));
+    
+    QString expanded;
+    qsizetype last = 0;
+    auto it = fieldRegex.globalMatch(outputPath);
+    while (it.hasNext()) {
+        auto match = it.next();
+        QString field = match.captured(1);
+        QString value;
+        if (field == QStringLiteral("title")) {
+            value = m_lastInfo.title;
+        } else if (field == QStringLiteral("ext")) {
+            value = format.ext.isEmpty() ? QStringLiteral("mp4") : format.ext;
+        } else if (field == QStringLiteral("format_id")) {
+            value = format.formatId;
+        } else if (field == QStringLiteral("uploader")) {
+            value = m_lastInfo.uploader;
         }
+        value.replace(QLatin1Char('/'), QLatin1Char('_'));
+        expanded += outputPath.mid(last, match.capturedStart() - last) + value;
+        last = match.capturedEnd();
     }
-    
-    return QString();
+    return expanded + outputPath.mid(last);
 }
 
 } // namespace OpenIDM
@@ -0,0 +1,275 @@
+/**
+ * @file YtDlpOutputParser.cpp
+ * @brief Implementation of YtDlpOutputParser - incremental yt-dlp output parsing
+ */
+
+#include "openidm/integration/YtDlpOutputParser.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMetaObject>
+#include <QUrl>
+
+namespace OpenIDM {
+
+namespace {
+
+/// @return @p view without leading spaces and '~' (approximate sizes)
+QByteArrayView skipSpaces(QByteArrayView view) {
+    while (!view.isEmpty() && (view.front() == ' ' || view.front() == '~')) {
+        view.slice(1);
+    }
+    return view;
+}
+
+/// @return Length of the leading "123.45" in @p view
+qsizetype numberLength(QByteArrayView view) {
+    qsizetype length = 0;
+    while (length < view.size() && ((view[length] >= '0' && view[length] <= '9') || view[length] == '.')) {
+        ++length;
+    }
+    return length;
+}
+
+/// @return Bytes per unit for yt-dlp's size suffixes, 0 if unknown
+double unitScale(QByteArrayView unit) {
+    if (unit == "B") return 1.0;
+    if (unit == "KiB") return 1024.0;
+    if (unit == "MiB") return 1024.0 * 1024;
+    if (unit == "GiB") return 1024.0 * 1024 * 1024;
+    if (unit == "KB") return 1000.0;
+    if (unit == "MB") return 1000.0 * 1000;
+    if (unit == "GB") return 1000.0 * 1000 * 1000;
+    return 0.0;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+YtDlpOutputParser::YtDlpOutputParser(QObject* parent)
+    : QObject(parent)
+{
+}
+
+YtDlpOutputParser::~YtDlpOutputParser() {
+    cancel();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Control
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void YtDlpOutputParser::start(const QString& sourceUrl) {
+    cancel();
+    
+    ++m_generation;
+    m_chunks.clear();
+    m_endOfInput = false;
+    m_stopping = false;
+    m_sourceUrl = sourceUrl;
+    m_pending.clear();
+    m_count = 0;
+    
+    m_running = true;
+    m_worker = std::thread([this]() { run(); });
+}
+
+void YtDlpOutputParser::feed(QByteArray chunk) {
+    if (chunk.isEmpty() || !m_running) {
+        return;
+    }
+    std::lock_guard lock(m_mutex);
+    m_chunks.push_back(std::move(chunk));
+    m_wake.notify_one();
+}
+
+void YtDlpOutputParser::finish() {
+    std::lock_guard lock(m_mutex);
+    m_endOfInput = true;
+    m_wake.notify_one();
+}
+
+void YtDlpOutputParser::cancel() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+        m_wake.notify_one();
+    }
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    ++m_generation;
+    m_running = false;
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Worker Thread
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void YtDlpOutputParser::run() {
+    const quint64 generation = m_generation;
+    
+    for (;;) {
+        std::deque<QByteArray> chunks;
+        bool endOfInput = false;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || m_endOfInput || !m_chunks.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            chunks.swap(m_chunks);
+            endOfInput = m_endOfInput;
+        }
+        
+        QList<VideoInfo> batch;
+        auto parseLine = [this, &batch](QByteArrayView line) {
+            // Warnings and progress share stdout with the JSON lines
+            if (!line.startsWith('{')) {
+                return;
+            }
+            QJsonParseError error;
+            QJsonDocument doc = QJsonDocument::fromJson(
+                QByteArray::fromRawData(line.data(), line.size()), &error);
+            if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+                qWarning() << "YtDlpOutputParser: Skipping malformed line:" << error.errorString();
+                return;
+            }
+            batch.append(videoInfo(doc.object(), m_sourceUrl));
+        };
+        
+        for (const QByteArray& chunk : chunks) {
+            forEachLine(m_pending, chunk, parseLine);
+        }
+        if (endOfInput && !m_pending.isEmpty()) {
+            // Output need not end with a newline
+            forEachLine(m_pending, QByteArrayView("\n"), parseLine);
+        }
+        
+        m_count += static_cast<int>(batch.size());
+        
+        // One queued call per wake-up keeps thousands of entries from
+        // flooding the GUI thread's event queue
+        if (!batch.isEmpty() || endOfInput) {
+            int count = m_count;
+            QMetaObject::invokeMethod(this, [this, generation, endOfInput, count, batch = std::move(batch)]() {
+                if (generation != m_generation) {
+                    return;
+                }
+                if (!batch.isEmpty()) {
+                    emit entries(batch);
+                }
+                if (endOfInput) {
+                    m_running = false;
+                    emit finished(count);
+                }
+            }, Qt::QueuedConnection);
+        }
+        
+        if (endOfInput) {
+            return;
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Parsing
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool YtDlpOutputParser::parseProgress(QByteArrayView line, double& percent, double& speed) {
+    static constexpr QByteArrayView tag("[download]");
+    if (!line.startsWith(tag)) {
+        return false;
+    }
+    
+    // "  42.0% of ..."
+    QByteArrayView rest = skipSpaces(line.sliced(tag.size()));
+    qsizetype length = numberLength(rest);
+    if (length == 0 || length >= rest.size() || rest[length] != '%') {
+        return false;
+    }
+    bool ok = false;
+    percent = rest.first(length).toDouble(&ok);
+    if (!ok) {
+        return false;
+    }
+    
+    // "... at  2.50MiB/s ..."; "Unknown B/s" before the first estimate
+    speed = 0.0;
+    qsizetype at = rest.indexOf(" at ");
+    if (at >= 0) {
+        QByteArrayView rate = skipSpaces(rest.sliced(at + 4));
+        length = numberLength(rate);
+        qsizetype slash = rate.indexOf("/s");
+        if (length > 0 && slash > length) {
+            speed = rate.first(length).toDouble() * unitScale(rate.sliced(length, slash - length));
+        }
+    }
+    return true;
+}
+
+VideoInfo YtDlpOutputParser::videoInfo(const QJsonObject& obj, const QString& sourceUrl) {
+    VideoInfo info;
+    info.url = sourceUrl;
+    if (info.url.isEmpty()) {
+        // Playlist entries: the page of the entry itself
+        info.url = obj.value(QStringLiteral("webpage_url")).toString();
+        if (info.url.isEmpty()) {
+            info.url = obj.value(QStringLiteral("url")).toString();
+        }
+    }
+    info.title = obj.value(QStringLiteral("title")).toString();
+    info.description = obj.value(QStringLiteral("description")).toString();
+    info.duration = static_cast<int>(obj.value(QStringLiteral("duration")).toDouble());
+    info.thumbnail = obj.value(QStringLiteral("thumbnail")).toString();
+    info.uploader = obj.value(QStringLiteral("uploader")).toString();
+    info.uploadDate = obj.value(QStringLiteral("upload_date")).toString();
+    
+    // Parse formats
+    QJsonArray formats = obj.value(QStringLiteral("formats")).toArray();
+    for (const QJsonValue& formatVal : formats) {
+        QJsonObject formatObj = formatVal.toObject();
+        
+        FormatInfo format;
+        format.formatId = formatObj.value(QStringLiteral("format_id")).toString();
+        format.ext = formatObj.value(QStringLiteral("ext")).toString();
+        format.resolution = formatObj.value(QStringLiteral("resolution")).toString();
+        format.filesize = formatObj.value(QStringLiteral("filesize")).toVariant().toLongLong();
+        format.vcodec = formatObj.value(QStringLiteral("vcodec")).toString();
+        format.acodec = formatObj.value(QStringLiteral("acodec")).toString();
+        format.tbr = formatObj.value(QStringLiteral("tbr")).toDouble();
+        format.note = formatObj.value(QStringLiteral("format_note")).toString();
+        format.url = formatObj.value(QStringLiteral("url")).toString();
+        format.protocol = formatObj.value(QStringLiteral("protocol")).toString();
+        
+        QJsonObject headers = formatObj.value(QStringLiteral("http_headers")).toObject();
+        for (auto it = headers.begin(); it != headers.end(); ++it) {
+            format.httpHeaders.append(it.key() + QStringLiteral(": ") + it.value().toString());
+        }
+        
+        // DASH: fragments are absolute or relative to fragment_base_url
+        QUrl fragmentBase(formatObj.value(QStringLiteral("fragment_base_url")).toString());
+        for (const QJsonValue& fragmentVal : formatObj.value(QStringLiteral("fragments")).toArray()) {
+            QJsonObject fragmentObj = fragmentVal.toObject();
+            StreamFragment fragment;
+            fragment.url = fragmentObj.contains(QStringLiteral("url"))
+                               ? QUrl(fragmentObj.value(QStringLiteral("url")).toString())
+                               : fragmentBase.resolved(QUrl(fragmentObj.value(QStringLiteral("path")).toString()));
+            format.fragments.fragments.push_back(std::move(fragment));
+        }
+        
+        info.formats.append(format);
+    }
+    
+    // Best format
+    info.bestFormat = obj.value(QStringLiteral("format_id")).toString();
+    info.directUrl = obj.value(QStringLiteral("url")).toString();
+    
+    return info;
+}
+
+} // namespace OpenIDM
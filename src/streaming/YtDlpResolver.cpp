@@ -0,0 +1,470 @@
+/**
+ * @file YtDlpResolver.cpp
+ * @brief Implementation of YtDlpResolver - warm yt-dlp helper and cache
+ */
+
+#include "openidm/integration/YtDlpResolver.h"
+#include "openidm/integration/YtDlpOutputParser.h"
+#include "openidm/persistence/PersistenceManager.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+#include <QUrlQuery>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+namespace OpenIDM {
+
+namespace {
+
+/**
+ * JSON-lines front end to yt_dlp: one request per stdin line
+ * ({"id", "url", "format"}), one answer per stdout line ({"id", "info"} or
+ * {"id", "error"}). The first line says whether yt_dlp could be imported.
+ */
+constexpr const char* HELPER_SCRIPT = R"PY(
+import json, sys, threading
+from concurrent.futures import ThreadPoolExecutor
+try:
+    import yt_dlp
+except Exception as e:
+    print(json.dumps({"ready": False, "error": str(e)}), flush=True)
+    sys.exit(3)
+lock = threading.Lock()
+def emit(obj):
+    line = json.dumps(obj, ensure_ascii=False, default=str)
+    with lock:
+        sys.stdout.write(line + "\n")
+        sys.stdout.flush()
+def resolve(req):
+    opts = {"quiet": True, "no_warnings": True, "noplaylist": True, "skip_download": True}
+    if req.get("format"):
+        opts["format"] = req["format"]
+    try:
+        with yt_dlp.YoutubeDL(opts) as ydl:
+            info = ydl.sanitize_info(ydl.extract_info(req["url"], download=False))
+        emit({"id": req["id"], "info": info})
+    except BaseException as e:
+        emit({"id": req["id"], "error": str(e)})
+pool = ThreadPoolExecutor(max_workers=int(sys.argv[1]) if len(sys.argv) > 1 else 4)
+emit({"ready": True, "version": yt_dlp.version.__version__})
+for line in sys.stdin:
+    line = line.strip()
+    if line:
+        pool.submit(resolve, json.loads(line))
+pool.shutdown(wait=True)
+)PY";
+
+/// Helper crashes tolerated before every request gets its own process
+constexpr int MAX_HELPER_RESTARTS = 3;
+
+struct Location {
+    QString ytdlp;
+    QString python;
+    QString version;
+};
+
+/// @return The yt-dlp executable, searched like a shell would, then in usual places
+QString findYtDlp() {
+    QString found = QStandardPaths::findExecutable(QStringLiteral("yt-dlp"));
+    if (!found.isEmpty()) {
+        return found;
+    }
+
+#ifdef Q_OS_WIN
+    const QStringList paths = {
+        QDir::homePath() + QStringLiteral("/AppData/Local/Programs/yt-dlp"),
+        QStringLiteral("C:/Program Files/yt-dlp"),
+        QStringLiteral("C:/yt-dlp"),
+    };
+    const QString name = QStringLiteral("yt-dlp.exe");
+#else
+    const QStringList paths = {
+        QStringLiteral("/usr/local/bin"),
+        QStringLiteral("/usr/bin"),
+        QDir::homePath() + QStringLiteral("/.local/bin"),
+    };
+    const QString name = QStringLiteral("yt-dlp");
+#endif
+
+    for (const QString& path : paths) {
+        QFileInfo info(path + QLatin1Char('/') + name);
+        if (info.exists() && info.isExecutable()) {
+            return info.absoluteFilePath();
+        }
+    }
+    return QString();
+}
+
+/// @return Interpreter that runs @p ytdlp if it is a Python script, else python3 from PATH
+QString findPython(const QString& ytdlp) {
+    QFile script(ytdlp);
+    if (script.open(QIODevice::ReadOnly)) {
+        QByteArray shebang = script.readLine(512).trimmed();
+        if (shebang.startsWith("#!") && shebang.contains("python")) {
+            QStringList parts = QString::fromUtf8(shebang.mid(2)).split(QLatin1Char(' '), Qt::SkipEmptyParts);
+            if (parts.size() > 1 && parts.first().endsWith(QStringLiteral("env"))) {
+                return QStandardPaths::findExecutable(parts.at(1));
+            }
+            if (!parts.isEmpty() && QFileInfo(parts.first()).isExecutable()) {
+                return parts.first();
+            }
+        }
+    }
+    
+    QString python = QStandardPaths::findExecutable(QStringLiteral("python3"));
+    return python.isEmpty() ? QStandardPaths::findExecutable(QStringLiteral("python")) : python;
+}
+
+/// Runs on a pool thread: file lookups and `--version` stay off the GUI thread
+Location locateInBackground(const QString& configured) {
+    Location location;
+    location.ytdlp = configured.isEmpty() ? findYtDlp() : configured;
+    if (location.ytdlp.isEmpty()) {
+        return location;
+    }
+    
+    location.python = findPython(location.ytdlp);
+    
+    QProcess process;
+    process.start(location.ytdlp, {QStringLiteral("--version")});
+    if (process.waitForFinished(10000)) {
+        location.version = QString::fromUtf8(process.readAllStandardOutput()).trimmed();
+    }
+    return location;
+}
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Construction
+// ═══════════════════════════════════════════════════════════════════════════════
+
+YtDlpResolver& YtDlpResolver::instance() {
+    static YtDlpResolver resolver;
+    return resolver;
+}
+
+YtDlpResolver::YtDlpResolver()
+    : QObject(nullptr)
+{
+}
+
+void YtDlpResolver::attach(PersistenceManager* persistence) {
+    m_persistence = persistence;
+}
+
+void YtDlpResolver::setYtDlpPath(const QString& path) {
+    m_ytdlpPath = path;
+    m_located = false;
+    m_mode = Mode::Unknown;
+    locate();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Location
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void YtDlpResolver::locate() {
+    if (m_locating || m_located) {
+        return;
+    }
+    m_locating = true;
+    
+    auto* watcher = new QFutureWatcher<Location>(this);
+    connect(watcher, &QFutureWatcher<Location>::finished, this, [this, watcher]() {
+        Location location = watcher->result();
+        watcher->deleteLater();
+    
+        m_ytdlpPath = location.ytdlp;
+        m_python = location.python;
+        m_version = location.version;
+        m_locating = false;
+        m_located = true;
+    
+        qDebug() << "YtDlpResolver: yt-dlp" << (m_ytdlpPath.isEmpty() ? QStringLiteral("not found") : m_ytdlpPath)
+                 << m_version << "python" << m_python;
+    
+        emit availabilityChanged(isAvailable());
+        dispatch();
+    });
+    watcher->setFuture(QtConcurrent::run(locateInBackground, m_ytdlpPath));
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Requests
+// ═══════════════════════════════════════════════════════════════════════════════
+
+quint64 YtDlpResolver::resolve(const QUrl& url, const QString& format) {
+    Request request{m_nextId++, url, format};
+    
+    // Cached answers are delivered queued, after the caller has the id
+    if (m_persistence) {
+        if (auto cached = m_persistence->loadMediaInfo(cacheKey(url, format))) {
+            QJsonObject info = QJsonDocument::fromJson(*cached).object();
+            if (!info.isEmpty()) {
+                quint64 id = request.id;
+                QMetaObject::invokeMethod(this, [this, id, info]() {
+                    emit resolved(id, info);
+                }, Qt::QueuedConnection);
+                return id;
+            }
+        }
+    }
+    
+    m_queue.push_back(std::move(request));
+    dispatch();
+    return m_nextId - 1;
+}
+
+void YtDlpResolver::cancel(quint64 id) {
+    auto queued = std::find_if(m_queue.begin(), m_queue.end(),
+                               [id](const Request& request) { return request.id == id; });
+    if (queued != m_queue.end()) {
+        m_queue.erase(queued);
+    }
+    m_running.erase(id);
+}
+
+void YtDlpResolver::dispatch() {
+    if (!m_located) {
+        locate();
+        return;
+    }
+    
+    if (m_ytdlpPath.isEmpty()) {
+        while (!m_queue.empty()) {
+            Request request = std::move(m_queue.front());
+            m_queue.pop_front();
+            fail(request, QStringLiteral("yt-dlp is not installed or not found in PATH"));
+        }
+        return;
+    }
+    
+    if (m_mode == Mode::Unknown) {
+        if (m_python.isEmpty()) {
+            m_mode = Mode::Processes;
+        } else {
+            startHelper();
+            return;
+        }
+    }
+    
+    if (m_mode == Mode::Helper) {
+        // The helper runs RESOLVER_CONCURRENCY extractions and queues the rest
+        if (!m_helperReady) {
+            return;
+        }
+        while (!m_queue.empty()) {
+            Request request = std::move(m_queue.front());
+            m_queue.pop_front();
+    
+            QJsonObject line{
+                {QStringLiteral("id"), static_cast<qint64>(request.id)},
+                {QStringLiteral("url"), request.url.toString()},
+                {QStringLiteral("format"), request.format},
+            };
+            m_helper->write(QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n');
+            m_running.emplace(request.id, std::move(request));
+        }
+        return;
+    }
+    
+    while (!m_queue.empty() && m_processes.size() < Constants::RESOLVER_CONCURRENCY) {
+        Request request = std::move(m_queue.front());
+        m_queue.pop_front();
+        startProcess(request);
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Helper Process
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void YtDlpResolver::startHelper() {
+    m_mode = Mode::Helper;
+    m_helperReady = false;
+    m_helperBuffer.clear();
+    
+    m_helper = new QProcess(this);
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("PYTHONIOENCODING"), QStringLiteral("utf-8"));
+    m_helper->setProcessEnvironment(environment);
+    
+    connect(m_helper, &QProcess::readyReadStandardOutput, this, &YtDlpResolver::onHelperOutput);
+    connect(m_helper, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &YtDlpResolver::onHelperFinished);
+    connect(m_helper, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            onHelperFinished();
+        }
+    });
+    
+    qDebug() << "YtDlpResolver: Starting helper with" << m_python;
+    m_helper->start(m_python, {QStringLiteral("-u"), QStringLiteral("-c"), QString::fromUtf8(HELPER_SCRIPT),
+                               QString::number(Constants::RESOLVER_CONCURRENCY)});
+}
+
+void YtDlpResolver::onHelperOutput() {
+    // A large answer may span many reads; only its partial line is kept
+    YtDlpOutputParser::forEachLine(m_helperBuffer, m_helper->readAllStandardOutput(),
+                                   [this](QByteArrayView line) { handleLine(line); });
+}
+
+void YtDlpResolver::handleLine(QByteArrayView line) {
+    QJsonObject message = QJsonDocument::fromJson(QByteArray::fromRawData(line.data(), line.size())).object();
+    if (message.isEmpty()) {
+        return;
+    }
+    
+    if (message.contains(QStringLiteral("ready"))) {
+        m_helperReady = message.value(QStringLiteral("ready")).toBool();
+        if (m_helperReady) {
+            QString version = message.value(QStringLiteral("version")).toString();
+            if (!version.isEmpty()) {
+                m_version = version;
+            }
+            dispatch();
+        } else {
+            qDebug() << "YtDlpResolver: yt_dlp not importable, one process per request:"
+                     << message.value(QStringLiteral("error")).toString();
+        }
+        return;
+    }
+    
+    auto it = m_running.find(static_cast<quint64>(message.value(QStringLiteral("id")).toInteger()));
+    if (it == m_running.end()) {
+        return;  // Cancelled
+    }
+    Request request = std::move(it->second);
+    m_running.erase(it);
+    
+    if (message.contains(QStringLiteral("info"))) {
+        finish(request, message.value(QStringLiteral("info")).toObject());
+    } else {
+        fail(request, message.value(QStringLiteral("error")).toString());
+    }
+}
+
+void YtDlpResolver::onHelperFinished() {
+    if (!m_helper) {
+        return;
+    }
+    bool wasReady = m_helperReady;
+    m_helper->disconnect(this);
+    m_helper->deleteLater();
+    m_helper = nullptr;
+    m_helperReady = false;
+    
+    // Whatever the helper had not answered goes back to the queue front
+    for (auto it = m_running.rbegin(); it != m_running.rend(); ++it) {
+        m_queue.push_front(std::move(it->second));
+    }
+    m_running.clear();
+    
+    if (!wasReady || ++m_helperRestarts > MAX_HELPER_RESTARTS) {
+        m_mode = Mode::Processes;
+    } else {
+        qWarning() << "YtDlpResolver: Helper exited, restarting";
+        m_mode = Mode::Unknown;
+    }
+    dispatch();
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// One Process per Request
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void YtDlpResolver::startProcess(const Request& request) {
+    auto* process = new QProcess(this);
+    m_processes.emplace(process, request.id);
+    m_running.emplace(request.id, request);
+    
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process](int exitCode, QProcess::ExitStatus status) {
+        quint64 id = m_processes[process];
+        m_processes.erase(process);
+        process->deleteLater();
+    
+        auto it = m_running.find(id);
+        if (it != m_running.end()) {
+            Request done = std::move(it->second);
+            m_running.erase(it);
+    
+            QJsonObject info = QJsonDocument::fromJson(process->readAllStandardOutput()).object();
+            if (status == QProcess::NormalExit && exitCode == 0 && !info.isEmpty()) {
+                finish(done, info);
+            } else {
+                QString message = QString::fromUtf8(process->readAllStandardError()).trimmed();
+                fail(done, message.isEmpty() ? QStringLiteral("yt-dlp exited with code %1").arg(exitCode)
+                                             : message);
+            }
+        }
+        dispatch();
+    });
+    connect(process, &QProcess::errorOccurred, this, [process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            emit process->finished(-1, QProcess::CrashExit);
+        }
+    });
+    
+    QStringList args = {QStringLiteral("-j"), QStringLiteral("--no-playlist"), QStringLiteral("--no-warnings")};
+    if (!request.format.isEmpty()) {
+        args << QStringLiteral("-f") << request.format;
+    }
+    args << request.url.toString();
+    
+    process->start(m_ytdlpPath, args);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Results
+// ═══════════════════════════════════════════════════════════════════════════════
+
+void YtDlpResolver::finish(const Request& request, const QJsonObject& info) {
+    if (m_persistence) {
+        m_persistence->saveMediaInfo(cacheKey(request.url, request.format),
+                                     QJsonDocument(info).toJson(QJsonDocument::Compact), expiryOf(info));
+    }
+    emit resolved(request.id, info);
+}
+
+void YtDlpResolver::fail(const Request& request, const QString& message) {
+    qWarning() << "YtDlpResolver: Failed to resolve" << request.url.toString() << message;
+    emit failed(request.id, message);
+}
+
+QString YtDlpResolver::cacheKey(const QUrl& url, const QString& format) {
+    return url.toString(QUrl::RemoveFragment) + QLatin1Char('\n') + format;
+}
+
+qint64 YtDlpResolver::expiryOf(const QJsonObject& info) {
+    qint64 expiresAt = QDateTime::currentMSecsSinceEpoch() + Constants::MEDIA_CACHE_TTL.count();
+    
+    // Signed media URLs (e.g. "...&expire=1700000000&...") die before the TTL
+    auto clamp = [&expiresAt](const QString& mediaUrl) {
+        QUrlQuery query{QUrl(mediaUrl)};
+        bool ok = false;
+        qint64 expire = query.queryItemValue(QStringLiteral("expire")).toLongLong(&ok);
+        if (ok && expire > 0) {
+            expiresAt = std::min(expiresAt, expire * 1000 - Constants::MEDIA_EXPIRY_MARGIN.count());
+        }
+    };
+    
+    clamp(info.value(QStringLiteral("url")).toString());
+    for (const QJsonValue& format : info.value(QStringLiteral("requested_formats")).toArray()) {
+        clamp(format.toObject().value(QStringLiteral("url")).toString());
+    }
+    return expiresAt;
+}
+
+} // namespace OpenIDM
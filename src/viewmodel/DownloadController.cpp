@@ -7,15 +7,17 @@
  */
 
 #include "DownloadController.h"
-#include "DownloadListModel.h"
-#include "engine/DownloadManager.h"
+#include "openidm/engine/DownloadManager.h"
+#include "openidm/engine/DownloadTask.h"
+#include "openidm/viewmodel/DownloadListModel.h"
 
 #include <QDebug>
 #include <QDesktopServices>
+#include <QDir>
 #include <QFileInfo>
 #include <QClipboard>
 #include <QGuiApplication>
-#include <QRegularExpression>
+#include <QProcess>
 
 namespace OpenIDM {
 
@@ -24,26 +26,29 @@ DownloadController* DownloadController::s_instance = nullptr;
 DownloadController::DownloadController(QObject* parent)
     : QObject(parent)
 {
-    m_manager = DownloadManager::instance();
-    m_model = new DownloadListModel(this);
+    m_manager = &DownloadManager::instance();
+    m_model = new DownloadListModel(m_manager, this);
 
     // Connect signals
     connect(m_manager, &DownloadManager::activeCountChanged,
             this, &DownloadController::activeCountChanged);
-    connect(m_manager, &DownloadManager::queuedCountChanged,
+    connect(m_manager, &DownloadManager::queueCountChanged,
             this, &DownloadController::queuedCountChanged);
     connect(m_manager, &DownloadManager::totalCountChanged,
             this, &DownloadController::totalCountChanged);
-    connect(m_manager, &DownloadManager::totalSpeedUpdated,
+    connect(m_manager, &DownloadManager::globalSpeedChanged,
             this, &DownloadController::totalSpeedChanged);
-    connect(m_manager, &DownloadManager::maxConcurrentChanged,
+    connect(m_manager, &DownloadManager::settingsChanged,
             this, &DownloadController::maxConcurrentChanged);
+    connect(m_manager, &DownloadManager::settingsChanged,
+            this, &DownloadController::defaultSavePathChanged);
     connect(m_manager, &DownloadManager::downloadCompleted,
             this, &DownloadController::onDownloadCompleted);
-    connect(m_manager, &DownloadManager::downloadError,
-            this, &DownloadController::onDownloadError);
-    connect(m_manager, &DownloadManager::downloadAdded,
-            this, &DownloadController::downloadAdded);
+    connect(m_manager, &DownloadManager::downloadFailed,
+            this, &DownloadController::onDownloadFailed);
+    connect(m_manager, &DownloadManager::downloadAdded, this, [this](const TaskId& id) {
+        emit downloadAdded(id.toString(QUuid::WithoutBraces));
+    });
 
     s_instance = this;
 }
@@ -74,59 +79,47 @@ DownloadController* DownloadController::create(QQmlEngine* qmlEngine, QJSEngine*
 
 int DownloadController::activeCount() const
 {
-    return m_manager->activeCount();
+    return m_manager->activeDownloadCount();
 }
 
 int DownloadController::queuedCount() const
 {
-    return m_manager->queuedCount();
+    return m_manager->queuedDownloadCount();
 }
 
 int DownloadController::totalCount() const
 {
-    return m_manager->totalCount();
+    return m_manager->totalDownloadCount();
 }
 
 double DownloadController::totalSpeed() const
 {
-    return m_manager->totalSpeed();
+    return m_manager->globalSpeed();
 }
 
 QString DownloadController::formattedTotalSpeed() const
 {
-    double speed = totalSpeed();
-
-    if (speed < 1024) {
-        return QString::number(speed, 'f', 0) + " B/s";
-    }
-    if (speed < 1024 * 1024) {
-        return QString::number(speed / 1024.0, 'f', 1) + " KB/s";
-    }
-    if (speed < 1024 * 1024 * 1024) {
-        return QString::number(speed / (1024.0 * 1024.0), 'f', 2) + " MB/s";
-    }
-    return QString::number(speed / (1024.0 * 1024.0 * 1024.0), 'f', 2) + " GB/s";
+    return m_manager->globalSpeedFormatted();
 }
 
 int DownloadController::maxConcurrent() const
 {
-    return m_manager->maxConcurrent();
+    return m_manager->maxConcurrentDownloads();
 }
 
 void DownloadController::setMaxConcurrent(int max)
 {
-    m_manager->setMaxConcurrent(max);
+    m_manager->setMaxConcurrentDownloads(max);
 }
 
 QString DownloadController::defaultSavePath() const
 {
-    return m_manager->defaultSavePath();
+    return m_manager->defaultDownloadDirectory();
 }
 
 void DownloadController::setDefaultSavePath(const QString& path)
 {
-    m_manager->setDefaultSavePath(path);
-    emit defaultSavePathChanged();
+    m_manager->setDefaultDownloadDirectory(path);
 }
 
 // ═══════════════════════════════════════════════════════════════════════════════
@@ -142,7 +135,13 @@ QString DownloadController::addDownload(const QString& url,
         return QString();
     }
 
-    return m_manager->addDownload(QUrl(url), savePath, fileName);
+    QString destPath = savePath;
+    if (!fileName.isEmpty()) {
+        QDir dir(savePath.isEmpty() ? m_manager->defaultDownloadDirectory() : savePath);
+        destPath = dir.filePath(fileName);
+    }
+
+    return m_manager->addDownloadUrl(url, destPath);
 }
 
 void DownloadController::startDownload(const QString& id)
@@ -160,9 +159,9 @@ void DownloadController::resumeDownload(const QString& id)
     m_manager->resumeDownload(id);
 }
 
-void DownloadController::cancelDownload(const QString& id, bool deleteFiles)
+void DownloadController::cancelDownload(const QString& id)
 {
-    m_manager->cancelDownload(id, deleteFiles);
+    m_manager->cancelDownload(id);
 }
 
 void DownloadController::retryDownload(const QString& id)
@@ -197,23 +196,21 @@ void DownloadController::clearCompleted()
 
 void DownloadController::openFile(const QString& id)
 {
-    DownloadInfo info = m_manager->downloadInfo(id);
-    if (info.id.isEmpty()) {
+    QString filePath;
+    if (!locate(id, &filePath, nullptr)) {
         return;
     }
 
-    QString filePath = info.fullFilePath();
     QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
 }
 
 void DownloadController::openFolder(const QString& id)
 {
-    DownloadInfo info = m_manager->downloadInfo(id);
-    if (info.id.isEmpty()) {
+    QString filePath;
+    if (!locate(id, &filePath, nullptr)) {
         return;
     }
 
-    QString filePath = info.fullFilePath();
     QFileInfo fileInfo(filePath);
 
 #ifdef Q_OS_WIN
@@ -230,13 +227,13 @@ void DownloadController::openFolder(const QString& id)
 
 void DownloadController::copyUrl(const QString& id)
 {
-    DownloadInfo info = m_manager->downloadInfo(id);
-    if (info.id.isEmpty()) {
+    QUrl url;
+    if (!locate(id, nullptr, &url)) {
         return;
     }
 
     QClipboard* clipboard = QGuiApplication::clipboard();
-    clipboard->setText(info.originalUrl.toString());
+    clipboard->setText(url.toString());
 }
 
 bool DownloadController::isValidUrl(const QString& url) const
@@ -275,15 +272,40 @@ QString DownloadController::getClipboardUrl() const
 // Private Slots
 // ═══════════════════════════════════════════════════════════════════════════════
 
-void DownloadController::onDownloadCompleted(const QString& id)
+void DownloadController::onDownloadCompleted(const TaskId& id)
 {
-    DownloadInfo info = m_manager->downloadInfo(id);
-    emit downloadCompleted(id, info.fileName);
+    QString key = id.toString(QUuid::WithoutBraces);
+    QString filePath;
+    locate(key, &filePath, nullptr);
+    emit downloadCompleted(key, QFileInfo(filePath).fileName());
 }
 
-void DownloadController::onDownloadError(const QString& id, const QString& message)
+void DownloadController::onDownloadFailed(const TaskId& id, const QString& message)
 {
-    emit downloadError(id, message);
+    emit downloadError(id.toString(QUuid::WithoutBraces), message);
+}
+
+// ═══════════════════════════════════════════════════════════════════════════════
+// Private Helpers
+// ═══════════════════════════════════════════════════════════════════════════════
+
+bool DownloadController::locate(const QString& id, QString* filePath, QUrl* url) const
+{
+    TaskId taskId = QUuid::fromString(id);
+
+    if (DownloadTask* task = m_manager->task(taskId)) {
+        if (filePath) *filePath = task->filePath();
+        if (url) *url = task->urlObject();
+        return true;
+    }
+
+    if (auto record = m_manager->archivedDownload(taskId)) {
+        if (filePath) *filePath = record->filePath;
+        if (url) *url = QUrl(record->url);
+        return true;
+    }
+
+    return false;
 }
 
 } // namespace OpenIDM
@@ -13,7 +13,7 @@
 #include <QUrl>
 #include <QQmlEngine>
 
-#include "engine/DownloadTypes.h"
+#include "openidm/engine/Types.h"
 
 namespace OpenIDM {
 
@@ -87,7 +87,7 @@ public:
     /**
      * @brief Cancel a download
      */
-    Q_INVOKABLE void cancelDownload(const QString& id, bool deleteFiles = true);
+    Q_INVOKABLE void cancelDownload(const QString& id);
 
     /**
      * @brief Retry a failed download
@@ -157,10 +157,13 @@ signals:
     void downloadError(const QString& id, const QString& message);
 
 private slots:
-    void onDownloadCompleted(const QString& id);
-    void onDownloadError(const QString& id, const QString& message);
+    void onDownloadCompleted(const TaskId& id);
+    void onDownloadFailed(const TaskId& id, const QString& message);
 
 private:
+    /// @return Local path and source URL of a task or archived download
+    bool locate(const QString& id, QString* filePath, QUrl* url) const;
+
     DownloadManager* m_manager = nullptr;
     DownloadListModel* m_model = nullptr;
 
@@ -7,6 +7,8 @@
 #include "openidm/engine/DownloadManager.h"
 #include "openidm/engine/DownloadTask.h"
 
+#include <algorithm>
+
 namespace OpenIDM {
 
 DownloadListModel::DownloadListModel(DownloadManager* manager, QObject* parent)
@@ -32,17 +34,22 @@ DownloadListModel::DownloadListModel(DownloadManager* manager, QObject* parent)
     m_roleNames[TotalSegmentsRole] = "totalSegments";
     m_roleNames[ContentTypeRole] = "contentType";
     m_roleNames[PriorityRole] = "priority";
+    m_roleNames[SegmentMapRole] = "segmentMap";
     
     // Connect to manager signals
     connect(m_manager, &DownloadManager::downloadAdded,
             this, &DownloadListModel::onDownloadAdded);
+    connect(m_manager, &DownloadManager::downloadsAdded,
+            this, &DownloadListModel::onDownloadsAdded);
     connect(m_manager, &DownloadManager::downloadRemoved,
             this, &DownloadListModel::onDownloadRemoved);
+    connect(m_manager, &DownloadManager::archiveCleared,
+            this, &DownloadListModel::onArchiveCleared);
     
     // Setup update timer for progress updates
     connect(m_updateTimer, &QTimer::timeout,
             this, &DownloadListModel::onProgressTimer);
-    m_updateTimer->setInterval(100);  // 100ms updates
+    m_updateTimer->setInterval(static_cast<int>(Constants::PROGRESS_UPDATE_INTERVAL.count()));
     m_updateTimer->start();
     
     // Initial load
@@ -57,17 +64,18 @@ int DownloadListModel::rowCount(const QModelIndex& parent) const {
     if (parent.isValid()) {
         return 0;
     }
-    return m_tasks.size();
+    return m_rows.size();
 }
 
 QVariant DownloadListModel::data(const QModelIndex& index, int role) const {
-    if (!index.isValid() || index.row() >= m_tasks.size()) {
+    if (!index.isValid() || index.row() >= m_rows.size()) {
         return QVariant();
     }
     
-    DownloadTask* task = m_tasks.at(index.row());
+    const Row& row = m_rows.at(index.row());
+    DownloadTask* task = row.task;
     if (!task) {
-        return QVariant();
+        return archivedData(row.id, role);
     }
     
     switch (role) {
@@ -105,6 +113,55 @@ QVariant DownloadListModel::data(const QModelIndex& index, int role) const {
             return task->contentType();
         case PriorityRole:
             return static_cast<int>(task->priority());
+        case SegmentMapRole:
+            return task->segmentMap();
+        default:
+            return QVariant();
+    }
+}
+
+QVariant DownloadListModel::archivedData(const QUuid& id, int role) const {
+    auto record = m_manager->archivedDownload(id);
+    if (!record) {
+        return QVariant();
+    }
+    
+    switch (role) {
+        case IdRole:
+            return id.toString(QUuid::WithoutBraces);
+        case UrlRole:
+            return record->url;
+        case FileNameRole:
+            return record->fileName;
+        case FilePathRole:
+            return record->filePath;
+        case TotalSizeRole:
+            return record->totalSize;
+        case DownloadedSizeRole:
+            return record->downloadedSize;
+        case ProgressRole:
+            return 100.0;
+        case SpeedRole:
+            return 0.0;
+        case SpeedFormattedRole:
+            return formatSpeed(0.0);
+        case StateRole:
+            return static_cast<int>(record->state);
+        case StateStringRole:
+            return downloadStateToString(record->state);
+        case RemainingTimeRole:
+            return formatDuration(Duration{-1});
+        case ErrorMessageRole:
+            return record->errorMessage;
+        case ActiveSegmentsRole:
+        case TotalSegmentsRole:
+            return 0;
+        case ContentTypeRole:
+            return record->contentType;
+        case PriorityRole:
+            return static_cast<int>(Priority::Normal);
+        case SegmentMapRole:
+            return QByteArray();
         default:
             return QVariant();
     }
@@ -120,18 +177,60 @@ int DownloadListModel::indexOf(const QString& taskId) const {
 }
 
 QString DownloadListModel::taskIdAt(int index) const {
-    if (index >= 0 && index < m_tasks.size()) {
-        return m_tasks.at(index)->idString();
+    if (index >= 0 && index < m_rows.size()) {
+        return m_rows.at(index).id.toString(QUuid::WithoutBraces);
     }
     return QString();
 }
 
+void DownloadListModel::setVisibleRange(int first, int last) {
+    m_visibleFirst = std::max(0, first);
+    m_visibleLast = last;
+}
+
+void DownloadListModel::setViewVisible(bool visible) {
+    if (m_viewVisible == visible) {
+        return;
+    }
+    
+    m_viewVisible = visible;
+    if (visible) {
+        // Dirty bits piled up while hidden; show them right away
+        onProgressTimer();
+        m_updateTimer->start();
+    } else {
+        m_updateTimer->stop();
+    }
+    emit viewVisibleChanged();
+}
+
 void DownloadListModel::onDownloadAdded(const QUuid& id) {
     DownloadTask* task = m_manager->task(id);
     if (!task) return;
     
-    beginInsertRows(QModelIndex(), m_tasks.size(), m_tasks.size());
-    m_tasks.append(task);
+    beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size());
+    m_rowIndex.insert(id, m_rows.size());
+    m_rows.append(Row{id, task});
+    endInsertRows();
+    
+    emit countChanged();
+}
+
+void DownloadListModel::onDownloadsAdded(const std::vector<QUuid>& ids) {
+    QList<Row> rows;
+    rows.reserve(static_cast<qsizetype>(ids.size()));
+    for (const QUuid& id : ids) {
+        if (DownloadTask* task = m_manager->task(id)) {
+            rows.append(Row{id, task});
+        }
+    }
+    if (rows.isEmpty()) return;
+    
+    // One insertion for the whole batch; views lay out once
+    int first = m_rows.size();
+    beginInsertRows(QModelIndex(), first, first + rows.size() - 1);
+    m_rows.append(std::move(rows));
+    rebuildIndex(first);
     endInsertRows();
     
     emit countChanged();
@@ -142,52 +241,117 @@ void DownloadListModel::onDownloadRemoved(const QUuid& id) {
     if (index < 0) return;
     
     beginRemoveRows(QModelIndex(), index, index);
-    m_tasks.removeAt(index);
+    m_rows.removeAt(index);
+    m_rowIndex.remove(id);
+    rebuildIndex(index);
     endRemoveRows();
     
     emit countChanged();
 }
 
+void DownloadListModel::onArchiveCleared() {
+    beginResetModel();
+    m_rows.removeIf([](const Row& row) { return row.task == nullptr; });
+    m_rowIndex.clear();
+    rebuildIndex();
+    endResetModel();
+    
+    emit countChanged();
+}
+
 void DownloadListModel::onProgressTimer() {
-    // Emit dataChanged for all active downloads
-    for (int i = 0; i < m_tasks.size(); ++i) {
-        DownloadTask* task = m_tasks.at(i);
-        if (task->isActive()) {
-            QModelIndex idx = index(i);
-            emit dataChanged(idx, idx, {
-                ProgressRole,
-                SpeedRole,
-                SpeedFormattedRole,
-                DownloadedSizeRole,
-                RemainingTimeRole,
-                ActiveSegmentsRole,
-                StateRole,
-                StateStringRole
-            });
+    if (!m_viewVisible || m_rows.isEmpty()) {
+        return;
+    }
+    
+    int last = m_rows.size() - 1;
+    if (m_visibleLast >= 0) {
+        last = std::min(last, m_visibleLast + Constants::VIEW_ROW_MARGIN);
+    }
+    int first = std::max(0, m_visibleFirst - Constants::VIEW_ROW_MARGIN);
+    
+    // One signal per run of adjacent rows with the same changes
+    int runStart = first;
+    uint32_t runFields = 0;
+    for (int i = first; i <= last; ++i) {
+        DownloadTask* task = m_rows.at(i).task;
+        uint32_t fields = task ? task->takeDirtyFields() : 0;
+        if (fields != runFields) {
+            if (runFields) {
+                emitRowsChanged(runStart, i - 1, runFields);
+            }
+            runStart = i;
+            runFields = fields;
         }
     }
+    if (runFields) {
+        emitRowsChanged(runStart, last, runFields);
+    }
+}
+
+void DownloadListModel::emitRowsChanged(int first, int last, uint32_t fields) {
+    QList<int> roles;
+    if (fields & DownloadTask::DirtyProgress) {
+        roles << DownloadedSizeRole << ProgressRole;
+    }
+    if (fields & (DownloadTask::DirtyProgress | DownloadTask::DirtySegments)) {
+        roles << SegmentMapRole;
+    }
+    if (fields & (DownloadTask::DirtyProgress | DownloadTask::DirtySpeed)) {
+        roles << RemainingTimeRole;
+    }
+    if (fields & DownloadTask::DirtySpeed) {
+        roles << SpeedRole << SpeedFormattedRole;
+    }
+    if (fields & DownloadTask::DirtyState) {
+        roles << StateRole << StateStringRole;
+    }
+    if (fields & DownloadTask::DirtySegments) {
+        roles << ActiveSegmentsRole << TotalSegmentsRole;
+    }
+    if (fields & DownloadTask::DirtyError) {
+        roles << ErrorMessageRole;
+    }
+    if (fields & DownloadTask::DirtyFileInfo) {
+        roles << FileNameRole << FilePathRole << TotalSizeRole << ContentTypeRole;
+    }
+    if (fields & DownloadTask::DirtyPriority) {
+        roles << PriorityRole;
+    }
+    
+    emit dataChanged(index(first), index(last), roles);
 }
 
 void DownloadListModel::refreshTaskList() {
     beginResetModel();
-    m_tasks.clear();
+    m_rows.clear();
     
     auto allTasks = m_manager->allTasks();
+    auto archived = m_manager->archivedDownloads();
+    m_rows.reserve(static_cast<qsizetype>(allTasks.size() + archived.size()));
+    
     for (DownloadTask* task : allTasks) {
-        m_tasks.append(task);
+        m_rows.append(Row{task->id(), task});
     }
+    for (const QUuid& id : archived) {
+        m_rows.append(Row{id, nullptr});
+    }
+    m_rowIndex.clear();
+    rebuildIndex();
     
     endResetModel();
     emit countChanged();
 }
 
-int DownloadListModel::findTaskIndex(const QUuid& id) const {
-    for (int i = 0; i < m_tasks.size(); ++i) {
-        if (m_tasks.at(i)->id() == id) {
-            return i;
-        }
+void DownloadListModel::rebuildIndex(int from) {
+    m_rowIndex.reserve(m_rows.size());
+    for (int i = from; i < m_rows.size(); ++i) {
+        m_rowIndex.insert(m_rows.at(i).id, i);
     }
-    return -1;
+}
+
+int DownloadListModel::findTaskIndex(const QUuid& id) const {
+    return m_rowIndex.value(id, -1);
 }
 
 } // namespace OpenIDM
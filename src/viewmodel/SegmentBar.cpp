@@ -0,0 +1,107 @@
+/**
+ * @file SegmentBar.cpp
+ * @brief Implementation of SegmentBar
+ */
+
+#include "openidm/viewmodel/SegmentBar.h"
+
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+
+namespace OpenIDM {
+
+SegmentBar::SegmentBar(QQuickItem* parent)
+    : QQuickItem(parent)
+    , m_colors{Qt::transparent, QColor(0x22, 0xD3, 0xEE, 0x60), QColor(0x22, 0xD3, 0xEE)}
+{
+    setFlag(ItemHasContents, true);
+}
+
+void SegmentBar::setSegmentMap(const QByteArray& map) {
+    if (map == m_segmentMap) {
+        return;
+    }
+    m_segmentMap = map;
+    update();
+    emit segmentMapChanged();
+}
+
+void SegmentBar::setColor(int state, const QColor& color) {
+    if (m_colors[state] == color) {
+        return;
+    }
+    m_colors[state] = color;
+    update();
+    emit colorsChanged();
+}
+
+void SegmentBar::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        update();
+    }
+}
+
+QSGNode* SegmentBar::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*) {
+    auto* node = static_cast<QSGGeometryNode*>(oldNode);
+    if (!node) {
+        node = new QSGGeometryNode;
+        auto* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        node->setGeometry(geometry);
+        node->setMaterial(new QSGVertexColorMaterial);
+        node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    }
+
+    const int cells = this->cells();
+    const char* map = m_segmentMap.constData();
+    auto visible = [this](char state) {
+        auto index = static_cast<unsigned char>(state);
+        return index < 3 && m_colors[index].alpha() > 0;
+    };
+
+    // One quad per run of equal, visible cells
+    int runs = 0;
+    for (int i = 0; i < cells; ++i) {
+        if (visible(map[i]) && (i == 0 || map[i] != map[i - 1])) {
+            ++runs;
+        }
+    }
+
+    QSGGeometry* geometry = node->geometry();
+    geometry->allocate(runs * 6);
+    QSGGeometry::ColoredPoint2D* vertex = geometry->vertexDataAsColoredPoint2D();
+
+    const float h = static_cast<float>(height());
+    const double cellWidth = cells > 0 ? width() / cells : 0.0;
+    for (int i = 0; i < cells;) {
+        int end = i + 1;
+        while (end < cells && map[end] == map[i]) {
+            ++end;
+        }
+        if (visible(map[i])) {
+            // Vertex colors are premultiplied
+            QColor color = m_colors[static_cast<unsigned char>(map[i])];
+            auto a = static_cast<uchar>(color.alpha());
+            auto r = static_cast<uchar>(color.red() * a / 255);
+            auto g = static_cast<uchar>(color.green() * a / 255);
+            auto b = static_cast<uchar>(color.blue() * a / 255);
+
+            auto x0 = static_cast<float>(i * cellWidth);
+            auto x1 = static_cast<float>(end * cellWidth);
+            vertex[0].set(x0, 0, r, g, b, a);
+            vertex[1].set(x1, 0, r, g, b, a);
+            vertex[2].set(x0, h, r, g, b, a);
+            vertex[3].set(x1, 0, r, g, b, a);
+            vertex[4].set(x1, h, r, g, b, a);
+            vertex[5].set(x0, h, r, g, b, a);
+            vertex += 6;
+        }
+        i = end;
+    }
+
+    node->markDirty(QSGNode::DirtyGeometry);
+    return node;
+}
+
+} // namespace OpenIDM
@@ -7,33 +7,33 @@
  */
 
 #include "SettingsController.h"
-#include "persistence/PersistenceManager.h"
+#include "openidm/engine/DownloadManager.h"
 
 namespace OpenIDM {
 
 SettingsController::SettingsController(QObject* parent)
     : QObject(parent)
+    , m_manager(&DownloadManager::instance())
 {
+    m_tunables = m_manager->tunables();
 }
 
-void SettingsController::setPersistenceManager(PersistenceManager* persistence)
+void SettingsController::apply()
 {
-    m_persistence = persistence;
-    load();
+    m_manager->setTunables(m_tunables);
+    m_tunables = m_manager->tunables();
 }
 
 void SettingsController::save()
 {
-    if (m_persistence) {
-        m_persistence->saveSettings(m_settings);
-    }
+    apply();
+    m_manager->saveSettings();
 }
 
 void SettingsController::load()
 {
-    if (m_persistence) {
-        m_settings = m_persistence->loadSettings();
-    }
+    m_manager->loadSettings();
+    m_tunables = m_manager->tunables();
 }
 
 } // namespace OpenIDM
@@ -10,14 +10,17 @@
 #define OPENIDM_SETTINGSCONTROLLER_H
 
 #include <QObject>
-#include "engine/DownloadTypes.h"
+#include "openidm/engine/Types.h"
 
 namespace OpenIDM {
 
-class PersistenceManager;
+class DownloadManager;
 
 /**
  * @brief Settings controller for QML
+ *
+ * Edits a copy of the engine tunables; apply() hands it to DownloadManager,
+ * which stays the only owner of the active values.
  */
 class SettingsController : public QObject {
     Q_OBJECT
@@ -25,14 +28,20 @@ class SettingsController : public QObject {
 public:
     explicit SettingsController(QObject* parent = nullptr);
 
-    void setPersistenceManager(PersistenceManager* persistence);
+    [[nodiscard]] const EngineTunables& tunables() const { return m_tunables; }
+    void setTunables(const EngineTunables& tunables) { m_tunables = tunables; }
+
+    /**
+     * @brief Apply the edited tunables to the engine
+     */
+    Q_INVOKABLE void apply();
 
     Q_INVOKABLE void save();
     Q_INVOKABLE void load();
 
 private:
-    PersistenceManager* m_persistence = nullptr;
-    Settings m_settings;
+    DownloadManager* m_manager = nullptr;
+    EngineTunables m_tunables;
 };
 
 } // namespace OpenIDM
@@ -0,0 +1,166 @@
+/**
+ * @file test_checksum.cpp
+ * @brief Unit tests for CRC32C combination and expected-hash parsing
+ */
+
+#include <QtTest>
+
+#include "openidm/engine/Checksum.h"
+
+using namespace OpenIDM;
+
+namespace {
+
+const QString ABC_SHA256 = QStringLiteral(
+    "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+/// @return @p size bytes that are the same on every run
+QByteArray testData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    uint32_t state = 0x12345678;
+    for (char& byte : data) {
+        state = state * 1664525u + 1013904223u;
+        byte = static_cast<char>(state >> 24);
+    }
+    return data;
+}
+
+uint32_t crcOf(const QByteArray& data)
+{
+    return crc32c(data.constData(), static_cast<size_t>(data.size()));
+}
+
+} // namespace
+
+class TestChecksum : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testCrc32cKnownAnswer();
+    void testCrc32cIncremental();
+    void testCrc32cCombine_data();
+    void testCrc32cCombine();
+    void testCrc32cCombineEmpty();
+    void testExpectedHashFromString_data();
+    void testExpectedHashFromString();
+    void testExpectedHashRoundTrip();
+};
+
+void TestChecksum::testCrc32cKnownAnswer()
+{
+    // RFC 3720 check value
+    QCOMPARE(crcOf(QByteArray("123456789")), uint32_t(0xE3069283));
+    QCOMPARE(crcOf(QByteArray()), uint32_t(0));
+    QCOMPARE(crcOf(QByteArray(32, '\0')), uint32_t(0x8A9136AA));
+}
+
+void TestChecksum::testCrc32cIncremental()
+{
+    QByteArray data = testData(4099);
+    uint32_t crc = 0;
+    for (int pos = 0; pos < data.size(); pos += 13) {
+        int length = std::min(13, static_cast<int>(data.size()) - pos);
+        crc = crc32c(data.constData() + pos, static_cast<size_t>(length), crc);
+    }
+    QCOMPARE(crc, crcOf(data));
+}
+
+void TestChecksum::testCrc32cCombine_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("split");
+
+    QTest::newRow("first byte") << 1000 << 1;
+    QTest::newRow("word boundary") << 1000 << 8;
+    QTest::newRow("unaligned") << 1000 << 9;
+    QTest::newRow("middle") << 1000 << 500;
+    QTest::newRow("last byte") << 1000 << 999;
+    QTest::newRow("long tail") << (1 << 20) << 12345;
+    QTest::newRow("long head") << (1 << 20) << (1 << 20) - 7;
+}
+
+void TestChecksum::testCrc32cCombine()
+{
+    QFETCH(int, size);
+    QFETCH(int, split);
+
+    QByteArray data = testData(size);
+    QByteArray a = data.left(split);
+    QByteArray b = data.mid(split);
+    QCOMPARE(crc32cCombine(crcOf(a), crcOf(b), b.size()), crcOf(data));
+}
+
+void TestChecksum::testCrc32cCombineEmpty()
+{
+    QByteArray data = testData(777);
+
+    // An empty second range leaves the first CRC as it is
+    QCOMPARE(crc32cCombine(crcOf(data), 0, 0), crcOf(data));
+
+    // An empty first range contributes nothing
+    QCOMPARE(crc32cCombine(0, crcOf(data), data.size()), crcOf(data));
+
+    // Known answer: "1234" + "56789"
+    QCOMPARE(crc32cCombine(crcOf(QByteArray("1234")), crcOf(QByteArray("56789")), 5),
+             uint32_t(0xE3069283));
+}
+
+void TestChecksum::testExpectedHashFromString_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("algorithm");     // hashAlgorithmName(), "none" if invalid
+    QTest::addColumn<QString>("digest");        // Lower-case hex
+
+    QString upper = ABC_SHA256.toUpper();
+
+    QTest::newRow("prefixed") << "sha256:" + ABC_SHA256 << "sha256" << ABC_SHA256;
+    QTest::newRow("upper-case hex") << "sha256:" + upper << "sha256" << ABC_SHA256;
+    QTest::newRow("upper-case name") << "SHA-256=" + ABC_SHA256 << "sha256" << ABC_SHA256;
+    QTest::newRow("padded") << "  sha256 : " + upper + "  " << "sha256" << ABC_SHA256;
+    QTest::newRow("bare sha256") << upper << "sha256" << ABC_SHA256;
+    QTest::newRow("bare crc32c") << "E3069283" << "crc32c" << "e3069283";
+    QTest::newRow("md5") << "md5:900150983CD24FB0D6963F7D28E17F72" << "md5"
+                         << "900150983cd24fb0d6963f7d28e17f72";
+    QTest::newRow("digest header base64") << "sha-256=ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0="
+                                          << "sha256" << ABC_SHA256;
+
+    QTest::newRow("empty") << "" << "none" << "";
+    QTest::newRow("no digest") << "sha256:" << "none" << "";
+    QTest::newRow("short") << "sha256:" + ABC_SHA256.left(63) << "none" << "";
+    QTest::newRow("long") << "sha256:" + ABC_SHA256 + "0" << "none" << "";
+    QTest::newRow("bad character") << "sha256:" + ABC_SHA256.left(63) + "g" << "none" << "";
+    QTest::newRow("bare odd length") << ABC_SHA256.left(63) << "none" << "";
+    QTest::newRow("bare not hex") << QString(64, QLatin1Char('z')) << "none" << "";
+    QTest::newRow("unknown algorithm") << "whirlpool:" + ABC_SHA256 << "none" << "";
+    QTest::newRow("wrong length for name") << "md5:" + ABC_SHA256 << "none" << "";
+    QTest::newRow("bad base64") << "sha-256=ungWv48Bz+pBQUDeXa4iI7ADYaOW!" << "none" << "";
+}
+
+void TestChecksum::testExpectedHashFromString()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, algorithm);
+    QFETCH(QString, digest);
+
+    ExpectedHash hash = ExpectedHash::fromString(text);
+    QCOMPARE(hashAlgorithmName(hash.algorithm), algorithm);
+    QCOMPARE(hash.isValid(), algorithm != QLatin1String("none"));
+    QCOMPARE(QString::fromLatin1(hash.digest.toHex()), digest);
+}
+
+void TestChecksum::testExpectedHashRoundTrip()
+{
+    ExpectedHash hash = ExpectedHash::fromString(ABC_SHA256.toUpper());
+    QCOMPARE(hash.toString(), "sha256:" + ABC_SHA256);
+
+    ExpectedHash parsed = ExpectedHash::fromString(hash.toString());
+    QCOMPARE(parsed.algorithm, hash.algorithm);
+    QCOMPARE(parsed.digest, hash.digest);
+
+    QCOMPARE(ExpectedHash{}.toString(), QString());
+}
+
+QTEST_MAIN(TestChecksum)
+#include "test_checksum.moc"
@@ -5,7 +5,9 @@
 
 #include <QtTest>
 
-#include "engine/DownloadTypes.h"
+#include "openidm/engine/Segment.h"
+#include "openidm/engine/SpeedCalculator.h"
+#include "openidm/engine/Types.h"
 
 using namespace OpenIDM;
 
@@ -14,99 +16,87 @@ class TestEngine : public QObject
     Q_OBJECT
 
 private slots:
-    void testSegmentInfoProgress();
-    void testSegmentInfoRemaining();
-    void testSegmentInfoCanSplit();
-    void testDownloadInfoProgress();
-    void testDownloadInfoEta();
-    void testDownloadStatsFormatSpeed();
-    void testDownloadStatsFormatEta();
+    void testSegmentProgress();
+    void testSegmentRemaining();
+    void testSegmentIsSplittable();
+    void testSegmentClaim();
+    void testSpeedCalculatorEta();
+    void testFormatSpeed();
+    void testFormatDuration();
 };
 
-void TestEngine::testSegmentInfoProgress()
+void TestEngine::testSegmentProgress()
 {
-    SegmentInfo seg;
-    seg.startByte = 0;
-    seg.endByte = 999;
-    seg.downloadedBytes = 500;
+    Segment seg(0, 0, 999);
+    seg.setCurrentByte(500);
 
-    QCOMPARE(seg.progress(), 50.0);
+    QCOMPARE(seg.progress(), 0.5);
 }
 
-void TestEngine::testSegmentInfoRemaining()
+void TestEngine::testSegmentRemaining()
 {
-    SegmentInfo seg;
-    seg.startByte = 0;
-    seg.endByte = 999;
-    seg.downloadedBytes = 300;
+    Segment seg(0, 0, 999);
+    seg.setCurrentByte(300);
 
-    QCOMPARE(seg.remainingBytes(), 700);
+    QCOMPARE(seg.remainingBytes(), ByteCount(700));
 }
 
-void TestEngine::testSegmentInfoCanSplit()
+void TestEngine::testSegmentIsSplittable()
 {
-    SegmentInfo seg;
-    seg.startByte = 0;
-    seg.endByte = Config::MIN_SPLIT_SIZE * 4 - 1;
-    seg.downloadedBytes = 0;
+    Segment seg(0, 0, Constants::MIN_STEAL_SIZE * 4 - 1);
 
-    QVERIFY(seg.canSplit());
+    QVERIFY(seg.isSplittable());
 
-    seg.downloadedBytes = Config::MIN_SPLIT_SIZE * 3;
-    QVERIFY(!seg.canSplit());
+    seg.setCurrentByte(Constants::MIN_STEAL_SIZE * 3);
+    QVERIFY(!seg.isSplittable());
 }
 
-void TestEngine::testDownloadInfoProgress()
+void TestEngine::testSegmentClaim()
 {
-    DownloadInfo info;
-    info.totalSize = 1000;
-    info.downloadedBytes = 250;
+    Segment seg(0, 0, 999);
+    ByteOffset start = -1;
 
-    QCOMPARE(info.progress(), 25.0);
-}
+    QCOMPARE(seg.claim(0, 400, &start), ByteCount(400));
+    QCOMPARE(start, ByteOffset(0));
 
-void TestEngine::testDownloadInfoEta()
-{
-    DownloadInfo info;
-    info.totalSize = 1000000;
-    info.downloadedBytes = 500000;
-    info.averageSpeed = 100000; // 100 KB/s
+    // A second stream overlapping the frontier only gets the new part
+    QCOMPARE(seg.claim(200, 400, &start), ByteCount(200));
+    QCOMPARE(start, ByteOffset(400));
 
-    QCOMPARE(info.estimatedTimeRemaining(), 5); // 5 seconds
+    // Data already covered, or past a gap, is not claimed
+    QCOMPARE(seg.claim(0, 100, &start), ByteCount(0));
+    QCOMPARE(seg.claim(700, 100, &start), ByteCount(0));
 }
 
-void TestEngine::testDownloadStatsFormatSpeed()
+void TestEngine::testSpeedCalculatorEta()
 {
-    DownloadStats stats;
-
-    stats.speed = 512;
-    QCOMPARE(stats.formattedSpeed(), QString("512 B/s"));
-
-    stats.speed = 1024;
-    QCOMPARE(stats.formattedSpeed(), QString("1.0 KB/s"));
+    SpeedCalculator meter;
+    QCOMPARE(meter.eta(1000).count(), Duration::rep(-1));
 
-    stats.speed = 1024 * 1024;
-    QCOMPARE(stats.formattedSpeed(), QString("1.00 MB/s"));
+    Timestamp start = std::chrono::system_clock::now();
+    meter.setTotal(0, start);
+    meter.setTotal(100000, start + std::chrono::seconds(1));
 
-    stats.speed = 1024 * 1024 * 1024;
-    QCOMPARE(stats.formattedSpeed(), QString("1.00 GB/s"));
+    QVERIFY(meter.hasSamples());
+    QVERIFY(meter.eta(500000).count() > 0);
 }
 
-void TestEngine::testDownloadStatsFormatEta()
+void TestEngine::testFormatSpeed()
 {
-    DownloadStats stats;
-
-    stats.eta = 30;
-    QCOMPARE(stats.formattedEta(), QString("30s"));
-
-    stats.eta = 90;
-    QCOMPARE(stats.formattedEta(), QString("1m 30s"));
+    QCOMPARE(formatSpeed(512), QString("512 B/s"));
+    QCOMPARE(formatSpeed(1024), QString("1.0 KB/s"));
+    QCOMPARE(formatSpeed(1024 * 1024), QString("1.00 MB/s"));
+    QCOMPARE(formatSpeed(1024.0 * 1024 * 1024), QString("1.00 GB/s"));
+}
 
-    stats.eta = 3661;
-    QCOMPARE(stats.formattedEta(), QString("1h 1m"));
+void TestEngine::testFormatDuration()
+{
+    using std::chrono::seconds;
 
-    stats.eta = -1;
-    QCOMPARE(stats.formattedEta(), QString("Unknown"));
+    QCOMPARE(formatDuration(seconds(30)), QString("30s"));
+    QCOMPARE(formatDuration(seconds(90)), QString("1m 30s"));
+    QCOMPARE(formatDuration(seconds(3661)), QString("1h 1m 1s"));
+    QCOMPARE(formatDuration(Duration(-1000)), QString("Unknown"));
 }
 
 QTEST_MAIN(TestEngine)
@@ -0,0 +1,208 @@
+/**
+ * @file test_http_header_parser.cpp
+ * @brief Table-driven tests for HttpHeaderParser
+ */
+
+#include <QtTest>
+
+#include "openidm/engine/HttpHeaderParser.h"
+
+using namespace OpenIDM;
+
+namespace {
+
+/// Feed @p lines the way curl's header callback does, CRLF included
+HttpHeaderInfo parse(const QList<QByteArray>& lines)
+{
+    HttpHeaderInfo info;
+    for (const QByteArray& line : lines) {
+        QByteArray raw = line + "\r\n";
+        HttpHeaderParser::parseLine(std::string_view(raw.constData(), static_cast<size_t>(raw.size())),
+                                    info);
+    }
+    return info;
+}
+
+} // namespace
+
+class TestHttpHeaderParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testLookup_data();
+    void testLookup();
+    void testContentRange_data();
+    void testContentRange();
+    void testContentDisposition_data();
+    void testContentDisposition();
+    void testFoldedHeaders();
+    void testDuplicatedHeaders();
+    void testStatusLineResets();
+};
+
+void TestHttpHeaderParser::testLookup_data()
+{
+    QTest::addColumn<QByteArray>("name");
+    QTest::addColumn<int>("header");
+
+    using Header = HttpHeaderParser::Header;
+    QTest::newRow("lower") << QByteArray("content-length") << int(Header::ContentLength);
+    QTest::newRow("mixed") << QByteArray("Content-Range") << int(Header::ContentRange);
+    QTest::newRow("upper") << QByteArray("ETAG") << int(Header::ETag);
+    QTest::newRow("same key, other name") << QByteArray("content-lengtx") << int(Header::Unknown);
+    QTest::newRow("longer") << QByteArray("content-lengths") << int(Header::Unknown);
+    QTest::newRow("unknown") << QByteArray("x-powered-by") << int(Header::Unknown);
+    QTest::newRow("empty") << QByteArray() << int(Header::Unknown);
+}
+
+void TestHttpHeaderParser::testLookup()
+{
+    QFETCH(QByteArray, name);
+    QFETCH(int, header);
+
+    auto found = HttpHeaderParser::lookup(std::string_view(name.constData(),
+                                                           static_cast<size_t>(name.size())));
+    QCOMPARE(int(found), header);
+}
+
+void TestHttpHeaderParser::testContentRange_data()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<qint64>("total");
+
+    QTest::newRow("range") << QByteArray("bytes 0-99/1000") << qint64(1000);
+    QTest::newRow("unsatisfied") << QByteArray("bytes */1000") << qint64(1000);
+    QTest::newRow("upper-case unit") << QByteArray("BYTES 0-99/1000") << qint64(1000);
+    QTest::newRow("trailing space") << QByteArray("bytes 0-99/1000  ") << qint64(1000);
+    QTest::newRow("unknown total") << QByteArray("bytes 0-99/*") << qint64(-1);
+    QTest::newRow("no total") << QByteArray("bytes 0-99") << qint64(-1);
+    QTest::newRow("empty total") << QByteArray("bytes 0-99/") << qint64(-1);
+    QTest::newRow("other unit") << QByteArray("items 0-99/1000") << qint64(-1);
+    QTest::newRow("equals sign") << QByteArray("bytes=0-99/1000") << qint64(-1);
+    QTest::newRow("not a number") << QByteArray("bytes 0-99/10x0") << qint64(-1);
+    QTest::newRow("negative") << QByteArray("bytes 0-99/-5") << qint64(-1);
+    QTest::newRow("empty") << QByteArray() << qint64(-1);
+}
+
+void TestHttpHeaderParser::testContentRange()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(qint64, total);
+
+    HttpHeaderInfo info = parse({"HTTP/1.1 206 Partial Content", "Content-Range: " + value});
+    QCOMPARE(info.rangeTotal, total);
+}
+
+void TestHttpHeaderParser::testContentDisposition_data()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<QString>("fileName");
+
+    QTest::newRow("token") << QByteArray("attachment; filename=plain.txt") << "plain.txt";
+    QTest::newRow("quoted") << QByteArray("attachment; filename=\"a b.txt\"") << "a b.txt";
+    QTest::newRow("quoted semicolon") << QByteArray("attachment; filename=\"a; b.txt\"; size=3")
+                                      << "a; b.txt";
+    QTest::newRow("escaped quote") << QByteArray("attachment; filename=\"say \\\"hi\\\".txt\"")
+                                   << "say \"hi\".txt";
+    QTest::newRow("upper-case name") << QByteArray("ATTACHMENT; FILENAME=\"upper.txt\"") << "upper.txt";
+    QTest::newRow("spaces around =") << QByteArray("attachment; filename = \"spaced.txt\"")
+                                     << "spaced.txt";
+    QTest::newRow("extended") << QByteArray("attachment; filename*=UTF-8''na%C3%AFve.txt")
+                              << QString::fromUtf8("na\xC3\xAFve.txt");
+    QTest::newRow("extended with language") << QByteArray("attachment; filename*=UTF-8'en'a%20b.txt")
+                                            << "a b.txt";
+    QTest::newRow("extended after plain")
+        << QByteArray("attachment; filename=\"fallback.txt\"; filename*=UTF-8''real.txt") << "real.txt";
+    QTest::newRow("extended before plain")
+        << QByteArray("attachment; filename*=UTF-8''real.txt; filename=\"fallback.txt\"") << "real.txt";
+    QTest::newRow("percent in plain") << QByteArray("attachment; filename=\"100%25.txt\"") << "100%.txt";
+    QTest::newRow("inline") << QByteArray("inline") << "";
+    QTest::newRow("empty quoted") << QByteArray("attachment; filename=\"\"") << "";
+    QTest::newRow("unterminated quote") << QByteArray("attachment; filename=\"open.txt") << "open.txt";
+}
+
+void TestHttpHeaderParser::testContentDisposition()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(QString, fileName);
+
+    QCOMPARE(HttpHeaderParser::fileNameFrom(std::string_view(value.constData(),
+                                                             static_cast<size_t>(value.size()))),
+             fileName);
+
+    HttpHeaderInfo info = parse({"HTTP/1.1 200 OK", "Content-Disposition: " + value});
+    QCOMPARE(info.fileName, fileName);
+}
+
+void TestHttpHeaderParser::testFoldedHeaders()
+{
+    // A folded parameter still names the file
+    HttpHeaderInfo info = parse({"HTTP/1.1 200 OK",
+                                 "Content-Disposition: attachment;",
+                                 "\tfilename=\"folded.txt\""});
+    QCOMPARE(info.fileName, QString("folded.txt"));
+
+    // Text is joined with a single space
+    info = parse({"HTTP/1.1 200 OK", "Server: Apache/2.4", "   (Unix)"});
+    QCOMPARE(info.server, QString("Apache/2.4 (Unix)"));
+
+    // A continuation line is never read as a header of its own
+    info = parse({"HTTP/1.1 200 OK",
+                  "Content-Length: 100",
+                  "Server: nginx",
+                  " Content-Length: 5",
+                  "X-Custom: a",
+                  " Accept-Ranges: bytes"});
+    QCOMPARE(info.contentLength, qint64(100));
+    QVERIFY(!info.acceptRanges);
+
+    // Nothing to continue right after the status line
+    info = parse({"HTTP/1.1 200 OK", " Content-Length: 5"});
+    QCOMPARE(info.contentLength, qint64(-1));
+
+    // Folded Alt-Svc offers count too
+    info = parse({"HTTP/1.1 200 OK", "Alt-Svc: h2=\":443\";", " h3=\":443\"; ma=86400"});
+    QVERIFY(info.advertisesHttp3);
+}
+
+void TestHttpHeaderParser::testDuplicatedHeaders()
+{
+    HttpHeaderInfo info = parse({"HTTP/1.1 200 OK",
+                                 "Content-Length: 1000",
+                                 "content-length: 1000",
+                                 "Content-Type: text/plain",
+                                 "Content-Type: application/octet-stream",
+                                 "Alt-Svc: h3=\":443\"",
+                                 "Alt-Svc: clear",
+                                 "ETag: \"one\"",
+                                 "ETag: W/\"two\""});
+    QCOMPARE(info.contentLength, qint64(1000));
+    QCOMPARE(info.contentType, QString("application/octet-stream"));
+    QVERIFY(info.advertisesHttp3);
+    QCOMPARE(info.etag, QString("W/\"two\""));
+
+    // An unparsable repeat leaves the earlier value
+    info = parse({"HTTP/1.1 200 OK", "Content-Length: 1000", "Content-Length: many"});
+    QCOMPARE(info.contentLength, qint64(1000));
+}
+
+void TestHttpHeaderParser::testStatusLineResets()
+{
+    HttpHeaderInfo info = parse({"HTTP/1.1 302 Found",
+                                 "Location: https://mirror.example.com/file.iso",
+                                 "Content-Length: 0",
+                                 "Server: edge",
+                                 "HTTP/2 200",
+                                 " (folded into nothing)",
+                                 "Content-Length: 5000",
+                                 "Accept-Ranges: bytes"});
+    QCOMPARE(info.statusCode, 200);
+    QVERIFY(!info.hasLocation);
+    QCOMPARE(info.contentLength, qint64(5000));
+    QVERIFY(info.acceptRanges);
+    QVERIFY(info.server.isEmpty());
+}
+
+QTEST_MAIN(TestHttpHeaderParser)
+#include "test_http_header_parser.moc"
@@ -0,0 +1,144 @@
+/**
+ * @file test_persistence.cpp
+ * @brief Unit tests for the download database
+ */
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
+#include "openidm/persistence/PersistenceManager.h"
+
+using namespace OpenIDM;
+
+namespace {
+
+/// @return True if the downloads table of @p path has a priority column
+bool hasPriorityColumn(const QString& path)
+{
+    bool found = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"),
+                                                    QStringLiteral("test_inspect"));
+        db.setDatabaseName(path);
+        if (db.open()) {
+            QSqlQuery query(db);
+            query.exec(QStringLiteral("PRAGMA table_info(downloads)"));
+            while (query.next()) {
+                found = found || query.value(1).toString() == QLatin1String("priority");
+            }
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("test_inspect"));
+    return found;
+}
+
+/// Write a database as releases before the priority column left it
+bool createLegacyDatabase(const QString& path)
+{
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"),
+                                                    QStringLiteral("test_legacy"));
+        db.setDatabaseName(path);
+        if (db.open()) {
+            QSqlQuery query(db);
+            ok = query.exec(QStringLiteral(R"(
+                CREATE TABLE downloads (
+                    id              TEXT PRIMARY KEY,
+                    url             TEXT NOT NULL,
+                    file_path       TEXT NOT NULL,
+                    file_name       TEXT NOT NULL,
+                    total_size      INTEGER NOT NULL DEFAULT -1,
+                    downloaded_size INTEGER DEFAULT 0,
+                    state           INTEGER NOT NULL DEFAULT 0,
+                    supports_ranges INTEGER DEFAULT 1,
+                    created_at      INTEGER NOT NULL,
+                    updated_at      INTEGER NOT NULL,
+                    completed_at    INTEGER,
+                    content_type    TEXT,
+                    checksum        TEXT,
+                    error_message   TEXT
+                )
+            )"))
+                && query.exec(QStringLiteral(R"(
+                INSERT INTO downloads (id, url, file_path, file_name, created_at, updated_at)
+                VALUES ('{4f6d1c2a-8e3b-4a57-9c1d-2b7e5f0a9d13}', 'https://example.com/a.iso',
+                        '/tmp/a.iso', 'a.iso', 1, 1)
+            )"));
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("test_legacy"));
+    return ok;
+}
+
+} // namespace
+
+class TestPersistence : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFreshDatabase();
+    void testMigratesLegacyDatabase();
+    void testMigrationIsIdempotent();
+};
+
+void TestPersistence::testFreshDatabase()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath(QStringLiteral("openidm.db"));
+
+    {
+        PersistenceManager manager;
+        QVERIFY(manager.initialize(path));
+        QVERIFY(manager.loadAllTasks().empty());
+        manager.close();
+    }
+
+    QVERIFY(hasPriorityColumn(path));
+}
+
+void TestPersistence::testMigratesLegacyDatabase()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath(QStringLiteral("openidm.db"));
+    QVERIFY(createLegacyDatabase(path));
+    QVERIFY(!hasPriorityColumn(path));
+
+    {
+        PersistenceManager manager;
+        QVERIFY(manager.initialize(path));
+
+        std::vector<TaskData> tasks = manager.loadAllTasks();
+        QCOMPARE(tasks.size(), size_t(1));
+        QCOMPARE(tasks[0].fileName, QString("a.iso"));
+        QCOMPARE(tasks[0].priority, Priority::Normal);
+        manager.close();
+    }
+
+    QVERIFY(hasPriorityColumn(path));
+}
+
+void TestPersistence::testMigrationIsIdempotent()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath(QStringLiteral("openidm.db"));
+    QVERIFY(createLegacyDatabase(path));
+
+    for (int run = 0; run < 2; ++run) {
+        PersistenceManager manager;
+        QVERIFY(manager.initialize(path));
+        QCOMPARE(manager.loadAllTasks().size(), size_t(1));
+        manager.close();
+    }
+}
+
+QTEST_MAIN(TestPersistence)
+#include "test_persistence.moc"
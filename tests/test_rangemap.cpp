@@ -0,0 +1,204 @@
+/**
+ * @file test_rangemap.cpp
+ * @brief Unit tests for RangeMap
+ */
+
+#include <QtTest>
+
+#include "openidm/engine/RangeMap.h"
+
+using namespace OpenIDM;
+
+class TestRangeMap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testReset();
+    void testMergeAdjacent();
+    void testMergeOverlapping();
+    void testSplitRun();
+    void testSplitAndRestore();
+    void testInFlightOwners();
+    void testClipping();
+    void testBoundaries();
+    void testLargest();
+};
+
+void TestRangeMap::testReset()
+{
+    RangeMap map;
+    map.reset(1000);
+    QCOMPARE(map.size(), ByteCount(1000));
+    QCOMPARE(map.runCount(), size_t(1));
+    QCOMPARE(map.bytes(RangeState::Pending), ByteCount(1000));
+
+    // Unknown size: nothing to track
+    map.reset(-1);
+    QCOMPARE(map.runCount(), size_t(0));
+    QCOMPARE(map.bytes(RangeState::Pending), ByteCount(0));
+    QVERIFY(!map.largest(RangeState::Pending).has_value());
+}
+
+void TestRangeMap::testMergeAdjacent()
+{
+    RangeMap map;
+    map.reset(1000);
+    map.assign(0, 99, RangeState::Completed);
+    map.assign(100, 199, RangeState::Completed);
+
+    auto runs = map.ranges();
+    QCOMPARE(runs.size(), size_t(2));
+    QCOMPARE(runs[0].start, ByteOffset(0));
+    QCOMPARE(runs[0].end, ByteOffset(199));
+    QCOMPARE(runs[0].state, RangeState::Completed);
+    QCOMPARE(runs[1].start, ByteOffset(200));
+    QCOMPARE(runs[1].state, RangeState::Pending);
+
+    // Filling the gap collapses the file into one run
+    map.assign(200, 999, RangeState::Completed);
+    QCOMPARE(map.runCount(), size_t(1));
+    QCOMPARE(map.bytes(RangeState::Completed), ByteCount(1000));
+}
+
+void TestRangeMap::testMergeOverlapping()
+{
+    RangeMap map;
+    map.reset(1000);
+    map.assign(0, 299, RangeState::Completed);
+    map.assign(200, 499, RangeState::Completed);
+
+    auto completed = map.ranges(RangeState::Completed);
+    QCOMPARE(completed.size(), size_t(1));
+    QCOMPARE(completed[0].start, ByteOffset(0));
+    QCOMPARE(completed[0].end, ByteOffset(499));
+    QCOMPARE(map.bytes(RangeState::Completed), ByteCount(500));
+    QCOMPARE(map.bytes(RangeState::Pending), ByteCount(500));
+
+    // A range covering several runs replaces all of them
+    map.assign(600, 699, RangeState::Completed);
+    map.assign(400, 799, RangeState::Completed);
+    QCOMPARE(map.runCount(), size_t(2));
+    QCOMPARE(map.bytes(RangeState::Completed), ByteCount(800));
+}
+
+void TestRangeMap::testSplitRun()
+{
+    RangeMap map;
+    map.reset(1000);
+    map.assign(400, 599, RangeState::InFlight, 7);
+
+    auto runs = map.ranges();
+    QCOMPARE(runs.size(), size_t(3));
+    QCOMPARE(runs[0].end, ByteOffset(399));
+    QCOMPARE(runs[1].start, ByteOffset(400));
+    QCOMPARE(runs[1].end, ByteOffset(599));
+    QCOMPARE(runs[1].owner, SegmentId(7));
+    QCOMPARE(runs[2].start, ByteOffset(600));
+    QCOMPARE(map.bytes(RangeState::Pending), ByteCount(800));
+    QCOMPARE(map.bytes(RangeState::InFlight), ByteCount(200));
+}
+
+void TestRangeMap::testSplitAndRestore()
+{
+    RangeMap map;
+    map.reset(1000);
+    map.assign(0, 999, RangeState::Completed);
+
+    // A failed write puts a range in the middle back to pending
+    map.assign(300, 399, RangeState::Pending);
+    QCOMPARE(map.runCount(), size_t(3));
+    QCOMPARE(map.bytes(RangeState::Completed), ByteCount(900));
+    QCOMPARE(map.largest(RangeState::Pending)->start, ByteOffset(300));
+
+    map.assign(300, 399, RangeState::Completed);
+    QCOMPARE(map.runCount(), size_t(1));
+    QCOMPARE(map.bytes(RangeState::Pending), ByteCount(0));
+}
+
+void TestRangeMap::testInFlightOwners()
+{
+    RangeMap map;
+    map.reset(1000);
+    map.assign(0, 99, RangeState::InFlight, 1);
+    map.assign(100, 199, RangeState::InFlight, 2);
+    QCOMPARE(map.ranges(RangeState::InFlight).size(), size_t(2));
+
+    // Same owner merges; owners of other states are dropped
+    map.assign(200, 299, RangeState::InFlight, 2);
+    auto inFlight = map.ranges(RangeState::InFlight);
+    QCOMPARE(inFlight.size(), size_t(2));
+    QCOMPARE(inFlight[1].start, ByteOffset(100));
+    QCOMPARE(inFlight[1].end, ByteOffset(299));
+
+    map.assign(0, 99, RangeState::Completed, 1);
+    QCOMPARE(map.ranges(RangeState::Completed)[0].owner, SegmentId(0));
+}
+
+void TestRangeMap::testClipping()
+{
+    RangeMap map;
+    map.reset(1000);
+    map.assign(-50, 9, RangeState::Completed);
+    map.assign(990, 5000, RangeState::Completed);
+
+    auto completed = map.ranges(RangeState::Completed);
+    QCOMPARE(completed.size(), size_t(2));
+    QCOMPARE(completed[0].start, ByteOffset(0));
+    QCOMPARE(completed[0].end, ByteOffset(9));
+    QCOMPARE(completed[1].start, ByteOffset(990));
+    QCOMPARE(completed[1].end, ByteOffset(999));
+
+    // Empty and out-of-range assignments change nothing
+    map.assign(500, 499, RangeState::Completed);
+    map.assign(1000, 1100, RangeState::Completed);
+    QCOMPARE(map.bytes(RangeState::Completed), ByteCount(20));
+    QCOMPARE(map.runCount(), size_t(3));
+}
+
+void TestRangeMap::testBoundaries()
+{
+    RangeMap map;
+    map.reset(1000);
+    map.assign(0, 0, RangeState::Completed);
+    map.assign(999, 999, RangeState::Completed);
+
+    auto runs = map.ranges();
+    QCOMPARE(runs.size(), size_t(3));
+    QCOMPARE(runs[0].length(), ByteCount(1));
+    QCOMPARE(runs[1].start, ByteOffset(1));
+    QCOMPARE(runs[1].end, ByteOffset(998));
+    QCOMPARE(runs[2].start, ByteOffset(999));
+    QCOMPARE(runs[2].length(), ByteCount(1));
+
+    // Assigning right up to a run's edge must not split its neighbour
+    map.assign(1, 499, RangeState::Completed);
+    runs = map.ranges();
+    QCOMPARE(runs.size(), size_t(3));
+    QCOMPARE(runs[0].end, ByteOffset(499));
+    QCOMPARE(runs[1].start, ByteOffset(500));
+    QCOMPARE(runs[1].end, ByteOffset(998));
+}
+
+void TestRangeMap::testLargest()
+{
+    RangeMap map;
+    map.reset(300);
+    map.assign(100, 199, RangeState::Completed);
+
+    // Equally long runs: the last one wins
+    auto largest = map.largest(RangeState::Pending);
+    QVERIFY(largest.has_value());
+    QCOMPARE(largest->start, ByteOffset(200));
+    QCOMPARE(largest->length(), ByteCount(100));
+
+    map.assign(250, 299, RangeState::Completed);
+    QCOMPARE(map.largest(RangeState::Pending)->start, ByteOffset(0));
+
+    map.assign(0, 299, RangeState::Completed);
+    QVERIFY(!map.largest(RangeState::Pending).has_value());
+    QCOMPARE(map.largest(RangeState::Completed)->length(), ByteCount(300));
+}
+
+QTEST_MAIN(TestRangeMap)
+#include "test_rangemap.moc"
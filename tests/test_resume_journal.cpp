@@ -0,0 +1,300 @@
+/**
+ * @file test_resume_journal.cpp
+ * @brief Unit tests for ResumeJournal recovery
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include <memory>
+
+#include "openidm/engine/Checksum.h"
+#include "openidm/engine/OutputFile.h"
+#include "openidm/engine/ResumeJournal.h"
+#include "openidm/engine/Segment.h"
+
+using namespace OpenIDM;
+
+namespace {
+
+constexpr ByteCount FILE_SIZE = 4096;
+
+// On-disk layout of the journal (part of its file format)
+constexpr qint64 HEADER_SIZE = 64;
+constexpr qint64 RECORD_SIZE = 40;
+
+QByteArray testData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    uint32_t state = 0x9E3779B9;
+    for (char& byte : data) {
+        state = state * 1664525u + 1013904223u;
+        byte = static_cast<char>(state >> 24);
+    }
+    return data;
+}
+
+/// Write part of @p data where it belongs and journal it, like DiskWriter does
+void store(OutputFile& output, ResumeJournal& journal, const Segment& segment,
+           const QByteArray& data, ByteOffset offset, int length)
+{
+    const char* bytes = data.constData() + offset;
+    QVERIFY(output.writeAt(offset, bytes, static_cast<size_t>(length)));
+    journal.recordWrite(segment, offset, bytes, static_cast<size_t>(length));
+}
+
+/// Replace @p length bytes of @p path at @p offset with their complement
+void corrupt(const QString& path, qint64 offset, qint64 length)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(offset));
+    QByteArray bytes = file.read(length);
+    for (char& byte : bytes) {
+        byte = static_cast<char>(~byte);
+    }
+    QVERIFY(file.seek(offset));
+    QCOMPARE(file.write(bytes), length);
+}
+
+uint32_t crcOf(const QByteArray& data, int length)
+{
+    return crc32c(data.constData(), static_cast<size_t>(length));
+}
+
+} // namespace
+
+class TestResumeJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testRecoverSynced();
+    void testRecoverVerifiedTail();
+    void testTailChecksumMismatch();
+    void testTornRecord();
+    void testTruncatedHeader();
+    void testSizeChanged();
+    void testStaleSegmentTable();
+    void testLayoutGapsAndOverlaps();
+
+private:
+    /**
+     * Journal two segments: [0, 2047] gets 1024 synced bytes, [2048, 4095]
+     * is completed and synced; then 512 more bytes of the first segment
+     * are journaled without a checkpoint.
+     * Records: 2 from open(), 2 writes, 2 synced, 1 tail = 7.
+     */
+    void writeTwoSegments();
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_dataPath;
+    QString m_journalPath;
+    QByteArray m_data;
+};
+
+void TestResumeJournal::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    m_data = testData(static_cast<int>(FILE_SIZE));
+    OutputFile output(m_dir->filePath(QStringLiteral("file.bin")));
+    m_dataPath = output.partialPath();
+    m_journalPath = ResumeJournal::pathFor(m_dataPath);
+}
+
+void TestResumeJournal::cleanup()
+{
+    m_dir.reset();
+}
+
+void TestResumeJournal::writeTwoSegments()
+{
+    OutputFile output(m_dir->filePath(QStringLiteral("file.bin")));
+    QVERIFY(output.open());
+
+    Segment first(0, 0, 2047);
+    Segment second(1, 2048, 4095);
+    ResumeJournal journal(m_journalPath);
+    QVERIFY(journal.open(FILE_SIZE, {&first, &second}));
+
+    store(output, journal, first, m_data, 0, 1024);
+    store(output, journal, second, m_data, 2048, 2048);
+    QVERIFY(journal.checkpoint(output));
+
+    store(output, journal, first, m_data, 1024, 512);
+    output.close();
+}
+
+void TestResumeJournal::testRecoverSynced()
+{
+    OutputFile output(m_dir->filePath(QStringLiteral("file.bin")));
+    QVERIFY(output.open());
+    {
+        Segment first(0, 0, 2047);
+        Segment second(1, 2048, 4095);
+        ResumeJournal journal(m_journalPath);
+        QVERIFY(journal.open(FILE_SIZE, {&first, &second}));
+        store(output, journal, first, m_data, 0, 1024);
+        store(output, journal, second, m_data, 2048, 2048);
+        QVERIFY(journal.checkpoint(output));
+    }
+    output.close();
+
+    auto layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].currentByte, ByteOffset(1024));
+    QCOMPARE(layout[0].state, SegmentState::Pending);
+    QVERIFY(layout[0].checksumValid);
+    QCOMPARE(layout[0].checksum, crcOf(m_data, 1024));
+    QCOMPARE(layout[1].startByte, ByteOffset(2048));
+    QCOMPARE(layout[1].currentByte, ByteOffset(4096));
+    QCOMPARE(layout[1].state, SegmentState::Completed);
+}
+
+void TestResumeJournal::testRecoverVerifiedTail()
+{
+    writeTwoSegments();
+
+    // The unsynced tail is read back and matches its record
+    auto layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].currentByte, ByteOffset(1536));
+    QCOMPARE(layout[0].checksum, crcOf(m_data, 1536));
+}
+
+void TestResumeJournal::testTailChecksumMismatch()
+{
+    writeTwoSegments();
+
+    // The tail never reached the disk intact: fall back to the synced point
+    corrupt(m_dataPath, 1100, 10);
+
+    auto layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].currentByte, ByteOffset(1024));
+    QCOMPARE(layout[0].checksum, crcOf(m_data, 1024));
+    QCOMPARE(layout[1].state, SegmentState::Completed);
+}
+
+void TestResumeJournal::testTornRecord()
+{
+    writeTwoSegments();
+
+    // A crash mid-append leaves half a record; the log ends before it
+    QFile journal(m_journalPath);
+    QVERIFY(journal.resize(HEADER_SIZE + 6 * RECORD_SIZE + RECORD_SIZE / 2));
+
+    auto layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].currentByte, ByteOffset(1024));
+    QCOMPARE(layout[1].state, SegmentState::Completed);
+
+    // A damaged record ends it the same way, even with valid ones after it
+    writeTwoSegments();
+    corrupt(m_journalPath, HEADER_SIZE + 4 * RECORD_SIZE + 8, 1);
+
+    layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].currentByte, ByteOffset(1024));
+    QCOMPARE(layout[1].currentByte, ByteOffset(4096));
+}
+
+void TestResumeJournal::testTruncatedHeader()
+{
+    writeTwoSegments();
+    QFile journal(m_journalPath);
+    QVERIFY(journal.resize(HEADER_SIZE / 2));
+
+    // Nothing to recover without SQLite's layout
+    QVERIFY(ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {}).empty());
+
+    // Otherwise that layout is used as it is
+    Segment first(0, 0, 2047);
+    Segment second(1, 2048, 4095);
+    auto layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE,
+                                         {first.snapshot(), second.snapshot()});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].currentByte, ByteOffset(0));
+    QCOMPARE(layout[1].currentByte, ByteOffset(2048));
+}
+
+void TestResumeJournal::testSizeChanged()
+{
+    writeTwoSegments();
+
+    // A different remote size means the partial file is of another version
+    QVERIFY(ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE * 2, {}).empty());
+}
+
+void TestResumeJournal::testStaleSegmentTable()
+{
+    OutputFile output(m_dir->filePath(QStringLiteral("file.bin")));
+    QVERIFY(output.open());
+
+    Segment parent(0, 0, 4095);
+    Segment::Snapshot saved = parent.snapshot();  // What SQLite still has
+    {
+        ResumeJournal journal(m_journalPath);
+        QVERIFY(journal.open(FILE_SIZE, {&parent}));
+        store(output, journal, parent, m_data, 0, 1024);
+        QVERIFY(journal.checkpoint(output));
+
+        // Split after the last database save; only the journal saw the child
+        parent.setEndByte(2047);
+        Segment child(1, 2048, 4095);
+        store(output, journal, child, m_data, 2048, 512);
+        QVERIFY(journal.checkpoint(output));
+    }
+    output.close();
+
+    auto layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {saved});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].id, SegmentId(0));
+    QCOMPARE(layout[0].endByte, ByteOffset(2047));
+    QCOMPARE(layout[0].currentByte, ByteOffset(1024));
+    QCOMPARE(layout[1].id, SegmentId(1));
+    QCOMPARE(layout[1].startByte, ByteOffset(2048));
+    QCOMPARE(layout[1].endByte, ByteOffset(4095));
+    QCOMPARE(layout[1].currentByte, ByteOffset(2560));
+}
+
+void TestResumeJournal::testLayoutGapsAndOverlaps()
+{
+    // Only the database layout: no journal beside the partial file
+    QFile data(m_dataPath);
+    QVERIFY(data.open(QIODevice::WriteOnly));
+    QCOMPARE(data.write(m_data), qint64(FILE_SIZE));
+    data.close();
+
+    Segment::Snapshot head = Segment(3, 0, 1023).snapshot();
+    head.currentByte = 512;
+    Segment::Snapshot tail = Segment(4, 2048, 4095).snapshot();
+
+    auto layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {tail, head});
+    QCOMPARE(layout.size(), size_t(3));
+    QCOMPARE(layout[0].id, SegmentId(3));
+    QCOMPARE(layout[0].currentByte, ByteOffset(512));
+    QCOMPARE(layout[1].id, SegmentId(5));          // New id for the gap
+    QCOMPARE(layout[1].startByte, ByteOffset(1024));
+    QCOMPARE(layout[1].endByte, ByteOffset(2047));
+    QCOMPARE(layout[1].currentByte, ByteOffset(1024));
+    QCOMPARE(layout[2].id, SegmentId(4));
+
+    // An earlier segment reaching into the next one is cut back
+    head = Segment(3, 0, 3000).snapshot();
+    head.currentByte = 2500;
+    layout = ResumeJournal::recover(m_journalPath, m_dataPath, FILE_SIZE, {head, tail});
+    QCOMPARE(layout.size(), size_t(2));
+    QCOMPARE(layout[0].endByte, ByteOffset(2047));
+    QCOMPARE(layout[0].currentByte, ByteOffset(2048));
+    QCOMPARE(layout[0].state, SegmentState::Completed);
+    QVERIFY(!layout[0].checksumValid);
+    QCOMPARE(layout[1].startByte, ByteOffset(2048));
+}
+
+QTEST_MAIN(TestResumeJournal)
+#include "test_resume_journal.moc"
@@ -0,0 +1,162 @@
+/**
+ * @file test_retry_wheel.cpp
+ * @brief Unit tests for RetryWheel
+ */
+
+#include <QtTest>
+
+#include "openidm/engine/RetryWheel.h"
+#include "openidm/engine/Segment.h"
+
+using namespace OpenIDM;
+
+namespace {
+
+constexpr uint64_t SLOTS = Constants::RETRY_WHEEL_SLOTS;
+
+/// Fixed origin, so tick k starts exactly at at(k)
+const RetryWheel::Clock::time_point ORIGIN = RetryWheel::Clock::now();
+
+RetryWheel::Clock::time_point at(uint64_t tick) {
+    return ORIGIN + static_cast<Duration::rep>(tick) * Constants::RETRY_WHEEL_TICK;
+}
+
+} // namespace
+
+class TestRetryWheel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFiringOrder();
+    void testNeverEarly();
+    void testPastDeadline();
+    void testWrapAround();
+    void testLongerThanOneTurn();
+    void testLongStall();
+    void testClear();
+};
+
+void TestRetryWheel::testFiringOrder()
+{
+    RetryWheel wheel(ORIGIN);
+    Segment a(0, 0, 99), b(1, 100, 199), c(2, 200, 299), d(3, 300, 399);
+
+    wheel.schedule(&c, at(3));
+    wheel.schedule(&a, at(1));
+    wheel.schedule(&b, at(2));
+    wheel.schedule(&d, at(2));
+    QCOMPARE(wheel.size(), size_t(4));
+
+    // Earliest first; same tick keeps scheduling order
+    std::vector<Segment*> due = wheel.advance(at(3));
+    QCOMPARE(due, (std::vector<Segment*>{&a, &b, &d, &c}));
+    QVERIFY(wheel.empty());
+}
+
+void TestRetryWheel::testNeverEarly()
+{
+    RetryWheel wheel(ORIGIN);
+    Segment a(0, 0, 99);
+
+    // Just past tick 2 rounds up to tick 3
+    wheel.schedule(&a, at(2) + Duration(1));
+    QVERIFY(wheel.advance(at(2)).empty());
+    QVERIFY(wheel.advance(at(3) - Duration(1)).empty());
+    QCOMPARE(wheel.advance(at(3)), std::vector<Segment*>{&a});
+
+    // Nothing twice
+    QVERIFY(wheel.advance(at(4)).empty());
+}
+
+void TestRetryWheel::testPastDeadline()
+{
+    RetryWheel wheel(ORIGIN);
+    Segment a(0, 0, 99);
+    wheel.advance(at(5));
+
+    // Already due: goes into the next tick, not the one just read
+    wheel.schedule(&a, at(1));
+    QVERIFY(wheel.advance(at(5)).empty());
+    QCOMPARE(wheel.size(), size_t(1));
+    QCOMPARE(wheel.advance(at(6)), std::vector<Segment*>{&a});
+}
+
+void TestRetryWheel::testWrapAround()
+{
+    RetryWheel wheel(ORIGIN);
+    Segment a(0, 0, 99), b(1, 100, 199), c(2, 200, 299);
+
+    wheel.schedule(&c, at(1));
+    QCOMPARE(wheel.advance(at(1)), std::vector<Segment*>{&c});
+
+    // Slot 1 again, one revolution later
+    wheel.advance(at(SLOTS - 2));
+    wheel.schedule(&a, at(SLOTS + 1));
+    wheel.schedule(&b, at(SLOTS - 1));
+    QCOMPARE(wheel.advance(at(SLOTS - 1)), std::vector<Segment*>{&b});
+    QVERIFY(wheel.advance(at(SLOTS)).empty());
+    QCOMPARE(wheel.advance(at(SLOTS + 1)), std::vector<Segment*>{&a});
+    QVERIFY(wheel.empty());
+}
+
+void TestRetryWheel::testLongerThanOneTurn()
+{
+    RetryWheel wheel(ORIGIN);
+    Segment near(0, 0, 99), far(1, 100, 199), farther(2, 200, 299);
+
+    // All three hash to slot 5
+    wheel.schedule(&far, at(SLOTS + 5));
+    wheel.schedule(&farther, at(2 * SLOTS + 5));
+    wheel.schedule(&near, at(5));
+
+    QCOMPARE(wheel.advance(at(5)), std::vector<Segment*>{&near});
+    QCOMPARE(wheel.size(), size_t(2));
+
+    QVERIFY(wheel.advance(at(SLOTS + 4)).empty());
+    QCOMPARE(wheel.advance(at(SLOTS + 5)), std::vector<Segment*>{&far});
+    QVERIFY(wheel.advance(at(2 * SLOTS + 4)).empty());
+    QCOMPARE(wheel.advance(at(2 * SLOTS + 5)), std::vector<Segment*>{&farther});
+    QVERIFY(wheel.empty());
+}
+
+void TestRetryWheel::testLongStall()
+{
+    RetryWheel wheel(ORIGIN);
+    Segment a(0, 0, 99), b(1, 100, 199), c(2, 200, 299), later(3, 300, 399);
+
+    wheel.schedule(&c, at(SLOTS + 3));
+    wheel.schedule(&b, at(11));
+    wheel.schedule(&a, at(10));
+    wheel.schedule(&later, at(3 * SLOTS));
+
+    // The pass over the wheel starts at slot 11, still earliest first
+    std::vector<Segment*> due = wheel.advance(at(SLOTS + 10));
+    QCOMPARE(due, (std::vector<Segment*>{&a, &b, &c}));
+    QCOMPARE(wheel.size(), size_t(1));
+
+    QVERIFY(wheel.advance(at(3 * SLOTS) - Duration(1)).empty());
+    QCOMPARE(wheel.advance(at(3 * SLOTS)), std::vector<Segment*>{&later});
+}
+
+void TestRetryWheel::testClear()
+{
+    RetryWheel wheel(ORIGIN);
+    Segment a(0, 0, 99), b(1, 100, 199);
+
+    // A layout rebuild drops pending retries; the segments behind them are gone
+    wheel.schedule(&a, at(2));
+    wheel.schedule(&b, at(SLOTS + 2));
+    wheel.clear();
+    QVERIFY(wheel.empty());
+    QCOMPARE(wheel.size(), size_t(0));
+    QVERIFY(wheel.advance(at(2 * SLOTS)).empty());
+
+    // Still usable afterwards
+    wheel.schedule(&b, at(2 * SLOTS + 1));
+    QCOMPARE(wheel.size(), size_t(1));
+    QCOMPARE(wheel.advance(at(2 * SLOTS + 1)), std::vector<Segment*>{&b});
+}
+
+QTEST_MAIN(TestRetryWheel)
+#include "test_retry_wheel.moc"
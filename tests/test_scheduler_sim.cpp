@@ -0,0 +1,125 @@
+/**
+ * @file test_scheduler_sim.cpp
+ * @brief Scheduler regression tests on the simulated network
+ *
+ * Each case runs the real SegmentScheduler through SchedulerSimulator
+ * with fixed seeds, so a policy change that makes completion slower
+ * shows up here instead of on a user's connection.
+ */
+
+#include <QtTest>
+#include <QLoggingCategory>
+
+#include "SchedulerSim.h"
+
+using namespace OpenIDM;
+using namespace OpenIDM::Bench;
+
+namespace {
+
+constexpr ByteCount FILE_SIZE = 64LL * 1024 * 1024;
+constexpr size_t RUNS = 100;
+
+/// Milliseconds the file takes at @p rate with every byte useful
+double idealMs(SpeedBps rate)
+{
+    return static_cast<double>(FILE_SIZE) / rate * 1000.0;
+}
+
+} // namespace
+
+class TestSchedulerSim : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void testNeverBeatsTheServerCap();
+    void testStealingAbsorbsStragglers();
+    void testFailuresRecover();
+    void testHedgingStaysCheap();
+    void testResetDropsPendingRetries();
+};
+
+void TestSchedulerSim::initTestCase()
+{
+    QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+}
+
+void TestSchedulerSim::testNeverBeatsTheServerCap()
+{
+    NetworkModel network;
+    network.serverBandwidth = 8.0 * 1024 * 1024;
+    SchedulerSimulator simulator(FILE_SIZE, network, SchedulerPolicy{});
+
+    SimulationSummary summary = SimulationSummary::of(simulator.runMany(RUNS), FILE_SIZE);
+
+    QCOMPARE(summary.completed, RUNS);
+    QVERIFY(summary.p50 >= idealMs(network.serverBandwidth));
+    QVERIFY(summary.p90 < idealMs(network.serverBandwidth) * 1.25);
+}
+
+void TestSchedulerSim::testStealingAbsorbsStragglers()
+{
+    // Eight connections at 4 MiB/s, some of them on a path ten times slower
+    NetworkModel even;
+    NetworkModel uneven;
+    uneven.slowShare = 0.25;
+
+    SchedulerSimulator evenSimulator(FILE_SIZE, even, SchedulerPolicy{});
+    SchedulerSimulator unevenSimulator(FILE_SIZE, uneven, SchedulerPolicy{});
+    SimulationSummary evenSummary = SimulationSummary::of(evenSimulator.runMany(RUNS), FILE_SIZE);
+    SimulationSummary unevenSummary = SimulationSummary::of(unevenSimulator.runMany(RUNS), FILE_SIZE);
+
+    QCOMPARE(unevenSummary.completed, RUNS);
+    QVERIFY(unevenSummary.steals > 0.0);
+
+    // Without stealing the slowest segment alone would take ten times as long
+    QVERIFY2(unevenSummary.p90 < evenSummary.p90 * 2.0,
+             qPrintable(QStringLiteral("p90 %1 ms vs %2 ms").arg(unevenSummary.p90).arg(evenSummary.p90)));
+}
+
+void TestSchedulerSim::testFailuresRecover()
+{
+    NetworkModel network;
+    network.failureRate = 0.05;
+    network.latency = Duration(200);
+    SchedulerSimulator simulator(FILE_SIZE, network, SchedulerPolicy{});
+
+    SimulationSummary summary = SimulationSummary::of(simulator.runMany(RUNS), FILE_SIZE);
+
+    QCOMPARE(summary.completed, RUNS);
+    QVERIFY(summary.p90 < idealMs(8 * network.bandwidth) * 3.0);
+}
+
+void TestSchedulerSim::testHedgingStaysCheap()
+{
+    NetworkModel network;
+    network.spread = 1.0;
+    SchedulerSimulator simulator(FILE_SIZE, network, SchedulerPolicy{});
+
+    SimulationSummary summary = SimulationSummary::of(simulator.runMany(RUNS), FILE_SIZE);
+
+    QCOMPARE(summary.completed, RUNS);
+
+    // Racing only starts once less than HEDGE_THRESHOLD is left
+    QVERIFY(summary.overhead < static_cast<double>(Constants::HEDGE_THRESHOLD) / FILE_SIZE);
+}
+
+void TestSchedulerSim::testResetDropsPendingRetries()
+{
+    // Every held segment fails into the retry wheel just before the reset
+    SchedulerPolicy policy;
+    policy.resetAt = Duration(500);
+    SchedulerSimulator simulator(FILE_SIZE, NetworkModel{}, policy);
+
+    std::vector<SimulationResult> results = simulator.runMany(20);
+
+    for (const SimulationResult& result : results) {
+        QVERIFY(result.resetClean);
+        QVERIFY(result.completed);
+    }
+}
+
+QTEST_MAIN(TestSchedulerSim)
+#include "test_scheduler_sim.moc"